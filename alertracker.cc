@@ -21,6 +21,7 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <iomanip>
 
 #include "alertracker.h"
 #include "devicetracker.h"
@@ -36,6 +37,7 @@ Alertracker::Alertracker(GlobalRegistry *in_globalreg) :
     Kis_Net_Httpd_CPPStream_Handler(in_globalreg) {
 	globalreg = in_globalreg;
 	next_alert_id = 0;
+	num_backlog = 50;
 
 	if (globalreg->kismet_config == NULL) {
 		fprintf(stderr, "FATAL OOPS:  Alertracker called with null config\n");
@@ -70,6 +72,11 @@ Alertracker::Alertracker(GlobalRegistry *in_globalreg) :
 		num_backlog = scantmp;
 	}
 
+    // Size the pre-serialized fragment ring to match the backlog
+    alert_json_ring.resize(num_backlog);
+    alert_json_pos = 0;
+    alert_cursor = 0;
+
 	// Parse config file vector of all alerts
 	if (ParseAlertConfig(globalreg->kismet_config) < 0) {
 		_MSG("Failed to parse alert values from Kismet config file", MSGFLAG_FATAL);
@@ -181,6 +188,8 @@ int Alertracker::RegisterAlert(std::string in_header, std::string in_description
     arec->set_phy(in_phy);
     arec->set_time_last(0);
 
+    arec->configure_bucket();
+
 	alert_name_map[arec->get_header()] = arec->get_alert_ref();
 	alert_ref_map[arec->get_alert_ref()] = arec;
 
@@ -199,36 +208,53 @@ int Alertracker::FetchAlertRef(std::string in_header) {
 }
 
 int Alertracker::CheckTimes(shared_alert_def arec) {
-    // Alerts limited to 0 are squelched
-	if (arec->get_limit_rate() == 0) {
-		return 0;
-	}
+    // Token bucket check; alerts limited to 0 never have tokens.  The
+    // common path during an alert flood is a single compare against the
+    // cached token count.
+    if (arec->check_bucket(time(0)))
+        return 1;
+
+    return 0;
+}
 
-	struct timeval now;
-	gettimeofday(&now, NULL);
+std::shared_ptr<tracked_alert> Alertracker::FetchPooledAlert() {
+    local_locker lock(&alert_mutex);
 
-	// If the last time we sent anything was longer than the main rate limit,
-	// then we reset back to empty
-	if (arec->get_time_last() < (now.tv_sec - 
-                alert_time_unit_conv[arec->get_limit_unit()])) {
-		arec->set_total_sent(0);
-		arec->set_burst_sent(0);
-		return 1;
-	}
+    if (alert_pool.size() > 0) {
+        std::shared_ptr<tracked_alert> ta = alert_pool.back();
+        alert_pool.pop_back();
+        return ta;
+    }
 
-	// If the last time we sent anything was longer than the burst rate, we can
-	// reset the burst to 0
-	if (arec->get_time_last() < (now.tv_sec - 
-                alert_time_unit_conv[arec->get_burst_unit()])) {
-		arec->set_burst_sent(0);
-	}
+    return std::shared_ptr<tracked_alert>(new tracked_alert(globalreg, alert_entry_id));
+}
+
+void Alertracker::ReturnPooledAlert(std::shared_ptr<tracked_alert> in_alert) {
+    local_locker lock(&alert_mutex);
+
+    // Bound the pool by the same knob as the alert backlog
+    if ((int) alert_pool.size() < num_backlog)
+        alert_pool.push_back(in_alert);
+}
+
+void Alertracker::record_alert_json(kis_alert_info *in_info) {
+    // Caller holds alert_mutex
+    if (alert_json_ring.size() == 0)
+        return;
+
+    std::shared_ptr<tracked_alert> ta = FetchPooledAlert();
+    ta->from_alert_info(in_info);
+
+    std::stringstream ss;
+    JsonAdapter::Pack(globalreg, ss, ta, NULL);
 
-	// If we're under the limit on both, we're good to go
-	if (arec->get_burst_sent() < arec->get_limit_burst() && 
-            arec->get_total_sent() < arec->get_limit_rate())
-		return 1;
+    ReturnPooledAlert(ta);
 
-	return 0;
+    alert_json_frag& frag = alert_json_ring[alert_json_pos % alert_json_ring.size()];
+    frag.cursor = ++alert_cursor;
+    frag.json = ss.str();
+
+    alert_json_pos++;
 }
 
 int Alertracker::PotentialAlert(int in_ref) {
@@ -262,6 +288,9 @@ int Alertracker::RaiseAlert(int in_ref, kis_packet *in_pack,
 	if (CheckTimes(arec) != 1)
 		return 0;
 
+    // Spend a token before we do any allocation or formatting
+    arec->consume_bucket_token();
+
     lock.unlock();
 
 	kis_alert_info *info = new kis_alert_info;
@@ -279,7 +308,7 @@ int Alertracker::RaiseAlert(int in_ref, kis_packet *in_pack,
 
 	info->text = in_text;
 
-	// Increment and set the timers
+	// Update the sent counters and timers
     arec->inc_burst_sent(1);
     arec->inc_total_sent(1);
     arec->set_time_last(ts_to_double(info->tm));
@@ -292,6 +321,8 @@ int Alertracker::RaiseAlert(int in_ref, kis_packet *in_pack,
 		alert_backlog.erase(alert_backlog.begin());
 	}
 
+    record_alert_json(info);
+
     lock.unlock();
 
 	// Try to get the existing alert info
@@ -322,9 +353,10 @@ int Alertracker::RaiseAlert(int in_ref, kis_packet *in_pack,
         std::shared_ptr<KisDatabaseLogfile> dbf =
             Globalreg::FetchGlobalAs<KisDatabaseLogfile>(globalreg, "DATABASELOG");
         if (dbf != NULL) {
-            std::shared_ptr<tracked_alert> ta(new tracked_alert(globalreg, alert_entry_id));
+            std::shared_ptr<tracked_alert> ta = FetchPooledAlert();
             ta->from_alert_info(info);
             dbf->log_alert(ta);
+            ReturnPooledAlert(ta);
         }
     }
 
@@ -355,6 +387,7 @@ int Alertracker::RaiseOneShot(std::string in_header, std::string in_text, int in
 		delete alert_backlog[0];
 		alert_backlog.erase(alert_backlog.begin());
 	}
+    record_alert_json(info);
     lock.unlock();
 
 #ifdef PRELUDE
@@ -369,9 +402,10 @@ int Alertracker::RaiseOneShot(std::string in_header, std::string in_text, int in
         std::shared_ptr<KisDatabaseLogfile> dbf =
             Globalreg::FetchGlobalAs<KisDatabaseLogfile>(globalreg, "DATABASELOG");
         if (dbf != NULL) {
-            std::shared_ptr<tracked_alert> ta(new tracked_alert(globalreg, alert_entry_id));
+            std::shared_ptr<tracked_alert> ta = FetchPooledAlert();
             ta->from_alert_info(info);
             dbf->log_alert(ta);
+            ReturnPooledAlert(ta);
         }
     }
 
@@ -614,6 +648,16 @@ bool Alertracker::Httpd_VerifyPath(const char *path, const char *method) {
                 if (Httpd_CanSerialize(tokenurl[4]))
                     return true;
 
+                return false;
+            } else if (tokenurl[2] == "since") {
+                if (tokenurl.size() < 5)
+                    return false;
+
+                // Cursor fetches are assembled from stored json fragments,
+                // so only the json endpoint exists
+                if (tokenurl[4] == "alerts.json")
+                    return true;
+
                 return false;
             }
         }
@@ -669,6 +713,47 @@ void Alertracker::Httpd_CreateStreamResponse(
             ss >> since_time;
 
             wrap = true;
+        } else if (tokenurl[2] == "since") {
+            if (tokenurl.size() < 5)
+                return;
+
+            uint64_t since_cursor = 0;
+
+            std::stringstream cs(tokenurl[3]);
+            cs >> since_cursor;
+
+            // Concatenate the pre-serialized fragments newer than the
+            // cursor; an incident-time poll never re-serializes the
+            // tracked records
+            local_locker lock(&alert_mutex);
+
+            stream << "{\"kismet.alert.cursor\": " << alert_cursor << ", ";
+            stream << "\"kismet.alert.timestamp\": " << std::fixed <<
+                std::setprecision(6) << ts_now_to_double() << ", ";
+            stream << "\"kismet.alert.list\": [";
+
+            size_t rsz = alert_json_ring.size();
+            bool first = true;
+
+            // Walk the ring oldest-first; the next slot to be overwritten
+            // holds the oldest fragment
+            for (size_t i = 0; rsz != 0 && i < rsz; i++) {
+                const alert_json_frag& frag =
+                    alert_json_ring[(alert_json_pos + i) % rsz];
+
+                if (frag.cursor == 0 || frag.cursor <= since_cursor)
+                    continue;
+
+                if (!first)
+                    stream << ",";
+                first = false;
+
+                stream << frag.json;
+            }
+
+            stream << "]}";
+
+            return;
         }
     }
 
@@ -687,20 +772,28 @@ void Alertracker::Httpd_CreateStreamResponse(
         wrapper = msgvec;
     }
 
+    std::vector<std::shared_ptr<tracked_alert> > pooled_alerts;
+
     {
         local_locker lock(&alert_mutex);
 
         for (std::vector<kis_alert_info *>::iterator i = alert_backlog.begin();
                 i != alert_backlog.end(); ++i) {
             if (since_time < ts_to_double((*i)->tm)) {
-                std::shared_ptr<tracked_alert> ta(new tracked_alert(globalreg, alert_entry_id));
+                std::shared_ptr<tracked_alert> ta = FetchPooledAlert();
                 ta->from_alert_info(*i);
                 msgvec->add_vector(ta);
+                pooled_alerts.push_back(ta);
             }
         }
     }
 
     Httpd_Serialize(path, stream, wrapper);
+
+    // The serialized output is complete; hand the alert records back to
+    // the pool
+    for (auto ta : pooled_alerts)
+        ReturnPooledAlert(ta);
 }
 
 int Alertracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
@@ -145,6 +145,8 @@ public:
 
         if (info->gps != NULL)
             location->set(info->gps);
+        else
+            location->set_valid(false);
     }
 
 protected:
@@ -232,13 +234,25 @@ public:
         tracker_component(in_globalreg, in_id) {
         register_fields();
         reserve_fields(NULL);
+
+        bucket_rate = 0;
+        bucket_burst = 0;
+        bucket_fill = 0;
+        bucket_tokens = 0;
+        bucket_stamp = 0;
     }
 
-    tracked_alert_definition(GlobalRegistry *in_globalreg, int in_id, 
+    tracked_alert_definition(GlobalRegistry *in_globalreg, int in_id,
             SharedTrackerElement e) :
         tracker_component(in_globalreg, in_id) {
         register_fields();
         reserve_fields(e);
+
+        bucket_rate = 0;
+        bucket_burst = 0;
+        bucket_fill = 0;
+        bucket_tokens = 0;
+        bucket_stamp = 0;
     }
 
     virtual SharedTrackerElement clone_type() {
@@ -266,6 +280,55 @@ public:
     int get_alert_ref() { return alert_ref; }
     void set_alert_ref(int in_ref) { alert_ref = in_ref; }
 
+    // Cache the limits as plain values and fill the token bucket; called
+    // once at registration after the limit fields are set
+    void configure_bucket() {
+        bucket_rate = get_limit_rate();
+        bucket_burst = get_limit_burst();
+
+        // A burst larger than the rate would let a single burst blow the
+        // rate limit
+        if (bucket_burst > bucket_rate)
+            bucket_burst = bucket_rate;
+
+        bucket_fill = (double) bucket_rate /
+            (double) alert_time_unit_conv[get_limit_unit()];
+
+        bucket_tokens = (double) bucket_burst;
+        bucket_stamp = time(0);
+    }
+
+    // Peek at the token bucket without spending a token; the common path
+    // during a flood is a single compare against the cached token count.
+    // Tokens refill at the configured rate and cap at the burst limit, so
+    // short bursts pass and sustained floods settle at the rate limit.
+    bool check_bucket(time_t now) {
+        if (bucket_rate == 0)
+            return false;
+
+        if (bucket_tokens >= 1.0)
+            return true;
+
+        // Refill from the elapsed time and re-check
+        if (now > bucket_stamp) {
+            bucket_tokens += (double) (now - bucket_stamp) * bucket_fill;
+            bucket_stamp = now;
+
+            if (bucket_tokens > (double) bucket_burst)
+                bucket_tokens = (double) bucket_burst;
+        }
+
+        return bucket_tokens >= 1.0;
+    }
+
+    // Spend a token for a raised alert
+    void consume_bucket_token() {
+        if (bucket_tokens >= 1.0)
+            bucket_tokens -= 1.0;
+        else
+            bucket_tokens = 0;
+    }
+
 protected:
     virtual void register_fields() {
         tracker_component::register_fields();
@@ -305,6 +368,14 @@ protected:
     // Non-exposed internal reference
     int alert_ref;
 
+    // Token bucket limiter state, kept as plain values so per-packet
+    // checks don't walk the tracked element tree
+    uint64_t bucket_rate;
+    uint64_t bucket_burst;
+    double bucket_fill;
+    double bucket_tokens;
+    time_t bucket_stamp;
+
     // Alert type and description
     SharedTrackerElement header, description;
     // Phynum this is linked to
@@ -410,9 +481,16 @@ protected:
 
     int alert_vec_id, alert_entry_id, alert_timestamp_id, alert_def_id;
 
-    // Check and age times
+    // Check the rate limit bucket
     int CheckTimes(shared_alert_def arec);
 
+    // Fetch a tracked_alert from the reuse pool, or make one if the pool
+    // is empty
+    std::shared_ptr<tracked_alert> FetchPooledAlert();
+
+    // Return a tracked_alert to the reuse pool once nothing references it
+    void ReturnPooledAlert(std::shared_ptr<tracked_alert> in_alert);
+
 	// Parse a foo/bar rate/unit option
 	int ParseRateUnit(std::string in_ru, alert_time_unit *ret_unit, int *ret_rate);
 
@@ -433,6 +511,25 @@ protected:
     // Backlog of alerts to be sent
     std::vector<kis_alert_info *> alert_backlog;
 
+    // Pre-serialized JSON copies of the backlog, keyed by a monotonic
+    // cursor, so REST polls concatenate stored fragments instead of
+    // re-serializing the tracked records on every fetch; the caller must
+    // hold alert_mutex
+    void record_alert_json(kis_alert_info *in_info);
+
+    struct alert_json_frag {
+        uint64_t cursor;
+        std::string json;
+    };
+
+    std::vector<alert_json_frag> alert_json_ring;
+    size_t alert_json_pos;
+    uint64_t alert_cursor;
+
+    // Reusable pool of tracked_alert objects; alert storms re-fill an
+    // existing tracked tree instead of rebuilding one per record
+    std::vector<std::shared_ptr<tracked_alert> > alert_pool;
+
     // Alert configs we read before we know the alerts themselves
 	std::map<std::string, alert_conf_rec *> alert_conf_map;
 
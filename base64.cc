@@ -19,12 +19,57 @@
 #include "config.h"
 
 #include <string.h>
+#include <stdint.h>
+
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 #include "base64.h"
 
-const char Base64::b64_values[] = 
+const char Base64::b64_values[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
+// Reverse lookup, 0xFF for characters outside the alphabet
+const unsigned char Base64::b64_reverse[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF,   62, 0xFF, 0xFF, 0xFF,   63,
+      52,   53,   54,   55,   56,   57,   58,   59,
+      60,   61, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF,    0,    1,    2,    3,    4,    5,    6,
+       7,    8,    9,   10,   11,   12,   13,   14,
+      15,   16,   17,   18,   19,   20,   21,   22,
+      23,   24,   25, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF,   26,   27,   28,   29,   30,   31,   32,
+      33,   34,   35,   36,   37,   38,   39,   40,
+      41,   42,   43,   44,   45,   46,   47,   48,
+      49,   50,   51, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
 void Base64::decodeblock(unsigned char *in, unsigned char *out) {
     out[0] = in[0] << 2 | in[1] >> 4;
     out[1] = in[1] << 4 | in[2] >> 2;
@@ -32,12 +77,102 @@ void Base64::decodeblock(unsigned char *in, unsigned char *out) {
     out[3] = 0;
 }
 
+#ifdef __SSSE3__
+// Pack 16 translated sextets down to 12 output bytes
+static inline __m128i b64_dec_reshuffle(__m128i in) {
+    __m128i merge_ab_and_bc = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+    __m128i out = _mm_madd_epi16(merge_ab_and_bc, _mm_set1_epi32(0x00011000));
+
+    return _mm_shuffle_epi8(out, _mm_setr_epi8(
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+// Decode 16 clean input characters to 12 bytes; returns false (consuming
+// nothing) if the block contains padding or anything outside the alphabet
+static inline bool b64_decode_block16(const unsigned char *src, unsigned char *dst) {
+    const __m128i lut_lo = _mm_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi = _mm_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_2f = _mm_set1_epi8(0x2f);
+
+    __m128i str = _mm_loadu_si128((const __m128i *) src);
+
+    __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), _mm_set1_epi8(0x0f));
+    __m128i lo_nibbles = _mm_and_si128(str, _mm_set1_epi8(0x0f));
+
+    __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+    __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+    __m128i eq_2f = _mm_cmpeq_epi8(str, mask_2f);
+    __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi),
+                    _mm_setzero_si128())) != 0)
+        return false;
+
+    __m128i packed = b64_dec_reshuffle(_mm_add_epi8(str, roll));
+
+    unsigned char obuf[16];
+    _mm_storeu_si128((__m128i *) obuf, packed);
+    memcpy(dst, obuf, 12);
+
+    return true;
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+// Decode 16 clean input characters to 12 bytes; classification and
+// translation run vectorized, the final sextet pack is a scalar unroll
+static inline bool b64_decode_block16(const unsigned char *src, unsigned char *dst) {
+    static const uint8_t lut_lo_tab[16] = {
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A };
+    static const uint8_t lut_hi_tab[16] = {
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 };
+    static const uint8_t lut_roll_tab[16] = {
+        0, 16, 19, 4, (uint8_t) -65, (uint8_t) -65, (uint8_t) -71, (uint8_t) -71,
+        0, 0, 0, 0, 0, 0, 0, 0 };
+
+    uint8x16_t str = vld1q_u8(src);
+
+    uint8x16_t hi_nibbles = vshrq_n_u8(str, 4);
+    uint8x16_t lo_nibbles = vandq_u8(str, vdupq_n_u8(0x0f));
+
+    uint8x16_t lo = vqtbl1q_u8(vld1q_u8(lut_lo_tab), lo_nibbles);
+    uint8x16_t hi = vqtbl1q_u8(vld1q_u8(lut_hi_tab), hi_nibbles);
+    uint8x16_t eq_2f = vceqq_u8(str, vdupq_n_u8(0x2f));
+    uint8x16_t roll = vqtbl1q_u8(vld1q_u8(lut_roll_tab),
+            vandq_u8(vaddq_u8(eq_2f, hi_nibbles), vdupq_n_u8(0x0f)));
+
+    if (vmaxvq_u8(vandq_u8(lo, hi)) != 0)
+        return false;
+
+    unsigned char sext[16];
+    vst1q_u8(sext, vaddq_u8(str, roll));
+
+    for (unsigned int g = 0; g < 4; g++) {
+        const unsigned char *s = sext + g * 4;
+        unsigned char *d = dst + g * 3;
+
+        d[0] = s[0] << 2 | s[1] >> 4;
+        d[1] = s[1] << 4 | s[2] >> 2;
+        d[2] = s[2] << 6 | s[3];
+    }
+
+    return true;
+}
+#endif
+
 std::string Base64::decode(std::string in_str) {
     std::string out;
     unsigned char obuf[4], ibuf[4];
     int phase, c;
     unsigned int i;
-    char *pos;
 
     memset(obuf, 0, 4);
     memset(ibuf, 0, 4);
@@ -45,10 +180,31 @@ std::string Base64::decode(std::string in_str) {
     // Make a rough guess at the decoded length to optimise sizing
     out.reserve(in_str.length() * 0.75);
 
+    i = 0;
+
+#if defined(__SSSE3__) || (defined(__ARM_NEON) && defined(__aarch64__))
+    // Bulk path; 16 characters in, 12 bytes out, as long as blocks stay
+    // inside the alphabet.  Padding or a stray character drops to the
+    // scalar loop, which also picks up the sub-block tail.
+    {
+        const unsigned char *src = (const unsigned char *) in_str.data();
+
+        while (i + 16 <= in_str.length()) {
+            unsigned char dblock[12];
+
+            if (!b64_decode_block16(src + i, dblock))
+                break;
+
+            out.append((char *) dblock, 12);
+            i += 16;
+        }
+    }
+#endif
+
     phase = 0;
 
-    for (i = 0; i < in_str.length(); i++) {
-        c = in_str[i];
+    for (; i < in_str.length(); i++) {
+        c = (unsigned char) in_str[i];
 
         if (c == '=') {
             decodeblock(ibuf, obuf);
@@ -56,16 +212,15 @@ std::string Base64::decode(std::string in_str) {
             return out;
         }
 
-        // Find the binary # this digit corresponds to
-        pos = strchr((char *) b64_values, c);
+        // Find the binary # this digit corresponds to; fail on invalid
+        // characters
+        unsigned char v = b64_reverse[c];
 
-        // Fail on invalid characters
-        if (pos == NULL) {
+        if (v == 0xFF) {
             return out;
         }
 
-        // Get the integer position in the table
-        ibuf[phase] = pos - b64_values;
+        ibuf[phase] = v;
 
         phase = (phase + 1) % 4;
 
@@ -80,3 +235,31 @@ std::string Base64::decode(std::string in_str) {
     return out;
 }
 
+std::string Base64::encode(std::string in_data) {
+    std::string out;
+    size_t i;
+
+    out.reserve(((in_data.length() + 2) / 3) * 4);
+
+    const unsigned char *d = (const unsigned char *) in_data.data();
+
+    for (i = 0; i + 3 <= in_data.length(); i += 3) {
+        out += b64_values[d[i] >> 2];
+        out += b64_values[((d[i] & 0x03) << 4) | (d[i + 1] >> 4)];
+        out += b64_values[((d[i + 1] & 0x0F) << 2) | (d[i + 2] >> 6)];
+        out += b64_values[d[i + 2] & 0x3F];
+    }
+
+    if (in_data.length() - i == 1) {
+        out += b64_values[d[i] >> 2];
+        out += b64_values[(d[i] & 0x03) << 4];
+        out += "==";
+    } else if (in_data.length() - i == 2) {
+        out += b64_values[d[i] >> 2];
+        out += b64_values[((d[i] & 0x03) << 4) | (d[i + 1] >> 4)];
+        out += b64_values[(d[i + 1] & 0x0F) << 2];
+        out += "=";
+    }
+
+    return out;
+}
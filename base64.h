@@ -19,13 +19,20 @@
 #include "config.h"
 
 #include <stdlib.h>
+#include <string>
 #include <sstream>
 
 #ifndef __BASE64_H__
 #define __BASE64_H__
 
-/* Unexciting base64 implementation 
- * Needed to handle b64 encoded post data for the webserver
+/* Base64 codec for encoded post data in the webserver and binary blobs
+ * shuttled through text protocols.
+ *
+ * The decoder runs a bulk vectorized path (SSSE3 or NEON, when the build
+ * targets them) over full blocks of clean input and falls back to a
+ * scalar reverse-table loop for the tail, padding, and anything the bulk
+ * path rejects.  The scalar path keeps the historical behavior of
+ * returning the bytes decoded so far when it hits an invalid character.
  */
 
 class Base64 {
@@ -33,12 +40,16 @@ public:
     /* Decode a string; return raw data if it was valid */
     static std::string decode(std::string in_str);
 
+    /* Encode raw data with standard padding */
+    static std::string encode(std::string in_data);
+
     // Convert 4 6-bit b64 characters into 3 8-bit standard bytes.
     // In and out must be able to hold the appropriate amount of data.
     static void decodeblock(unsigned char *in, unsigned char *out);
 
 protected:
     const static char b64_values[];
+    const static unsigned char b64_reverse[256];
 };
 
 #endif
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+
+# This file is part of Kismet
+#
+# Kismet is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# Kismet is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# Compare two benchmark result files written by 'kismet_bench -j' or
+# 'kismet_microbench -j' and fail if anything regressed past the
+# threshold; intended for release-candidate acceptance runs:
+#
+#   ./kismet_bench -j baseline.json capture.pcap     (on the old build)
+#   ./kismet_bench -j candidate.json capture.pcap    (on the new build)
+#   ./bench_compare.py baseline.json candidate.json --threshold 5
+#
+# Exits 0 if no metric regressed by more than the threshold, 1 otherwise.
+
+import argparse
+import json
+import sys
+
+# Direction of goodness per metric; anything not listed is informational
+# (counts, timestamps) and only reported when it changes
+LOWER_BETTER = ("ns_op", "rss_mb", "elapsed_sec")
+HIGHER_BETTER = ("pps", "mbit_s", "ops_sec", "mb_s")
+
+
+def load_results(path):
+    try:
+        with open(path) as f:
+            data = json.load(f)
+    except (IOError, ValueError) as e:
+        sys.stderr.write("Could not read results from {}: {}\n".format(path, e))
+        sys.exit(1)
+
+    if "results" not in data:
+        sys.stderr.write("{} does not look like a benchmark result file\n".format(path))
+        sys.exit(1)
+
+    return data
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Compare two Kismet benchmark result files")
+    parser.add_argument("baseline", help="baseline results JSON")
+    parser.add_argument("candidate", help="candidate results JSON")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="regression threshold in percent (default 5)")
+    args = parser.parse_args()
+
+    base = load_results(args.baseline)
+    cand = load_results(args.candidate)
+
+    if base.get("bench") != cand.get("bench"):
+        sys.stderr.write("Warning: comparing different benchmarks ({} vs {})\n".format(
+            base.get("bench"), cand.get("bench")))
+
+    base_by_name = {r["name"]: r for r in base["results"]}
+    cand_by_name = {r["name"]: r for r in cand["results"]}
+
+    regressions = 0
+
+    print("{:<32} {:>12} {:>14} {:>14} {:>9}  {}".format(
+        "benchmark", "metric", "baseline", "candidate", "change", "verdict"))
+
+    for name in base_by_name:
+        if name not in cand_by_name:
+            print("{:<32} missing from candidate results".format(name))
+            regressions += 1
+            continue
+
+        b = base_by_name[name]
+        c = cand_by_name[name]
+
+        for metric in LOWER_BETTER + HIGHER_BETTER:
+            if metric not in b or metric not in c:
+                continue
+
+            bv = float(b[metric])
+            cv = float(c[metric])
+
+            if bv == 0:
+                continue
+
+            delta = (cv - bv) / bv * 100.0
+
+            if metric in LOWER_BETTER:
+                worse = delta > args.threshold
+                better = delta < -args.threshold
+            else:
+                worse = delta < -args.threshold
+                better = delta > args.threshold
+
+            if worse:
+                verdict = "REGRESSED"
+                regressions += 1
+            elif better:
+                verdict = "improved"
+            else:
+                verdict = "ok"
+
+            print("{:<32} {:>12} {:>14.2f} {:>14.2f} {:>+8.1f}%  {}".format(
+                name, metric, bv, cv, delta, verdict))
+
+    for name in cand_by_name:
+        if name not in base_by_name:
+            print("{:<32} new in candidate results, not compared".format(name))
+
+    if regressions:
+        print("\n{} metric(s) regressed more than {}%".format(
+            regressions, args.threshold))
+        return 1
+
+    print("\nNo regressions past {}%".format(args.threshold))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
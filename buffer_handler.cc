@@ -87,6 +87,13 @@ ssize_t BufferHandlerGeneric::GetWriteBufferAvailable() {
     return 0;
 }
 
+bool BufferHandlerGeneric::EnsureWriteBufferSpace(size_t in_sz) {
+    if (write_buffer)
+        return write_buffer->ensure(in_sz);
+
+    return false;
+}
+
 ssize_t BufferHandlerGeneric::PeekReadBufferData(void **in_ptr, size_t in_sz) {
     if (in_ptr == NULL)
         return 0;
@@ -121,6 +128,30 @@ ssize_t BufferHandlerGeneric::ZeroCopyPeekWriteBufferData(void **in_ptr, size_t
     return 0;
 }
 
+ssize_t BufferHandlerGeneric::ZeroCopyPeekWriteBufferVector(void **seg_a, size_t *len_a,
+        void **seg_b, size_t *len_b, size_t in_sz) {
+    if (write_buffer)
+        return write_buffer->zero_copy_peek_vector((unsigned char **) seg_a, len_a,
+                (unsigned char **) seg_b, len_b, in_sz);
+
+    *len_a = 0;
+    *len_b = 0;
+
+    return 0;
+}
+
+ssize_t BufferHandlerGeneric::ZeroCopyReserveReadBufferVector(void **seg_a, size_t *len_a,
+        void **seg_b, size_t *len_b, size_t in_sz) {
+    if (read_buffer)
+        return read_buffer->zero_copy_reserve_vector((unsigned char **) seg_a, len_a,
+                (unsigned char **) seg_b, len_b, in_sz);
+
+    *len_a = 0;
+    *len_b = 0;
+
+    return 0;
+}
+
 void BufferHandlerGeneric::PeekFreeReadBufferData(void *in_ptr) {
     if (read_buffer)
         return read_buffer->peek_free((unsigned char *) in_ptr);
@@ -144,6 +175,8 @@ size_t BufferHandlerGeneric::ConsumeReadBufferData(size_t in_sz) {
         if (readbuf_drain_cb != NULL) {
             readbuf_drain_cb(sz);
         }
+
+        read_drain_cl.unlock(sz);
     }
 
     return 0;
@@ -158,6 +191,8 @@ size_t BufferHandlerGeneric::ConsumeWriteBufferData(size_t in_sz) {
         if (writebuf_drain_cb != NULL) {
             writebuf_drain_cb(sz);
         }
+
+        write_drain_cl.unlock(sz);
     }
 
     return 0;
@@ -196,6 +231,9 @@ size_t BufferHandlerGeneric::PutReadBufferData(void *in_ptr, size_t in_sz,
             rbuf_notify->BufferAvailable(ret);
     }
 
+    if (ret != 0)
+        read_avail_cl.unlock(ret);
+
     return ret;
 }
 
@@ -211,6 +249,109 @@ bool BufferHandlerGeneric::PutWriteBufferData(std::string in_data) {
     return (r == in_data.length());
 }
 
+size_t BufferHandlerGeneric::PutReadBufferData_Blocking(void *in_ptr, size_t in_sz,
+        unsigned int timeout_ms) {
+    size_t wpos = 0;
+
+    while (1) {
+        // Arm the conditional before writing so a consume on the IO thread
+        // between our failed write and our sleep can't be lost
+        read_drain_cl.lock();
+
+        // Write whatever fits right now
+        ssize_t avail = GetReadBufferAvailable();
+        size_t chunk = in_sz - wpos;
+
+        if (avail >= 0 && (size_t) avail < chunk)
+            chunk = avail;
+
+        if (chunk > 0)
+            wpos += PutReadBufferData((char *) in_ptr + wpos, chunk, true);
+
+        if (wpos == in_sz) {
+            read_drain_cl.unlock();
+            return wpos;
+        }
+
+        // Sleep until the buffer drains
+        if (timeout_ms == 0) {
+            read_drain_cl.block_until();
+        } else if (!read_drain_cl.block_for_ms(timeout_ms)) {
+            return wpos;
+        }
+    }
+}
+
+size_t BufferHandlerGeneric::PutWriteBufferData_Blocking(void *in_ptr, size_t in_sz,
+        unsigned int timeout_ms) {
+    size_t wpos = 0;
+
+    while (1) {
+        // Arm the conditional before writing so a consume on the IO thread
+        // between our failed write and our sleep can't be lost
+        write_drain_cl.lock();
+
+        // Write whatever fits right now
+        ssize_t avail = GetWriteBufferAvailable();
+        size_t chunk = in_sz - wpos;
+
+        if (avail >= 0 && (size_t) avail < chunk)
+            chunk = avail;
+
+        if (chunk > 0)
+            wpos += PutWriteBufferData((char *) in_ptr + wpos, chunk, true);
+
+        if (wpos == in_sz) {
+            write_drain_cl.unlock();
+            return wpos;
+        }
+
+        // Sleep until the buffer drains
+        if (timeout_ms == 0) {
+            write_drain_cl.block_until();
+        } else if (!write_drain_cl.block_for_ms(timeout_ms)) {
+            return wpos;
+        }
+    }
+}
+
+bool BufferHandlerGeneric::WaitWriteBufferAvailable(size_t in_sz, unsigned int timeout_ms) {
+    while (1) {
+        write_drain_cl.lock();
+
+        ssize_t avail = GetWriteBufferAvailable();
+
+        // Unbounded buffers always have room
+        if (avail < 0 || (size_t) avail >= in_sz) {
+            write_drain_cl.unlock();
+            return true;
+        }
+
+        if (timeout_ms == 0) {
+            write_drain_cl.block_until();
+        } else if (!write_drain_cl.block_for_ms(timeout_ms)) {
+            return false;
+        }
+    }
+}
+
+bool BufferHandlerGeneric::WaitReadBufferData(size_t in_sz, unsigned int timeout_ms) {
+    while (1) {
+        read_avail_cl.lock();
+
+        if (GetReadBufferUsed() >= in_sz) {
+            read_avail_cl.unlock();
+            return true;
+        }
+
+        if (timeout_ms == 0) {
+            read_avail_cl.block_until();
+        } else if (!read_avail_cl.block_for_ms(timeout_ms)) {
+            return false;
+        }
+    }
+}
+
     
 size_t BufferHandlerGeneric::PutWriteBufferData(void *in_ptr, size_t in_sz,
         bool in_atomic) {
@@ -312,6 +453,9 @@ bool BufferHandlerGeneric::CommitReadBufferData(void *in_ptr, size_t in_sz) {
         }
     }
 
+    if (s)
+        read_avail_cl.unlock(in_sz);
+
     return s;
 }
 
@@ -446,17 +590,17 @@ BufferInterface::~BufferInterface() {
 
 BufferHandlerOStreambuf::~BufferHandlerOStreambuf() {
     if (rb_handler != NULL) {
+        // Flush whatever is left in the put area
+        sync();
+
         rb_handler->RemoveWriteBufferDrainCb();
         rb_handler = NULL;
     }
-}
 
-std::streamsize BufferHandlerOStreambuf::xsputn(const char_type *s, std::streamsize n) {
-    if (rb_handler == NULL) {
-        // fprintf(stderr, "debug - no rb handler\n");
-        return -1;
-    }
+    delete[] chunk;
+}
 
+std::streamsize BufferHandlerOStreambuf::put_data(const char *s, std::streamsize n) {
     // fprintf(stderr, "debug - ostreambuf putting %lu\n", n);
     ssize_t written = rb_handler->PutWriteBufferData((void *) s, (size_t) n, true);
 
@@ -471,34 +615,35 @@ std::streamsize BufferHandlerOStreambuf::xsputn(const char_type *s, std::streams
         return -1;
     }
 
-    // Otherwise go into a loop, blocking, until we've written the entire buffer...
-    
-    // Initialize the locking variable
-    blocking_cl.reset(new conditional_locker<size_t>());
+    // Otherwise write the rest blocking, sleeping on the handler's drain
+    // conditional until the buffer flushes
+    rb_handler->PutWriteBufferData_Blocking((void *) (s + written), n - written, 0);
 
-    // Set a write completion callback
-    rb_handler->SetWriteBufferDrainCb([this](size_t amt __attribute__((unused))) {
-        blocking_cl->unlock(amt);
-    });
+    return n;
+}
 
-    // Jump as far as we managed to write
-    ssize_t wpos = written;
-    while (1) {
-        written = rb_handler->PutWriteBufferData((void *) (s + wpos), n - wpos, true);
+std::streamsize BufferHandlerOStreambuf::xsputn(const char_type *s, std::streamsize n) {
+    if (rb_handler == NULL) {
+        // fprintf(stderr, "debug - no rb handler\n");
+        return -1;
+    }
 
-        if (wpos + written == n) {
-            rb_handler->RemoveWriteBufferDrainCb();
-            return n;
-        }
+    // Writes at least a chunk long skip the put area entirely; flush whatever
+    // is pending to keep the stream ordered, then hand the block over whole
+    if (n >= (std::streamsize) chunk_sz) {
+        if (sync() < 0)
+            return -1;
 
-        // Keep track of where we are
-        wpos += written;
+        return put_data(s, n);
+    }
 
-        // Block until the buffer flushes
-        blocking_cl->block_until();
+    if (pptr() + n > epptr()) {
+        if (sync() < 0)
+            return -1;
     }
 
-    rb_handler->RemoveWriteBufferDrainCb();
+    memcpy(pptr(), s, n);
+    pbump(n);
 
     return n;
 }
@@ -507,35 +652,32 @@ BufferHandlerOStreambuf::int_type BufferHandlerOStreambuf::overflow(int_type ch)
     if (rb_handler == NULL)
         return -1;
 
-    if (rb_handler->PutWriteBufferData((void *) &ch, 1, true) == 1) 
-        return 1;
-
-    // Not blocking, nothing we can do
-    if (!blocking) {
-        rb_handler->BufferError("write buffer full, streambuf unable to write data");
+    // Put area is full; flush it as a single block
+    if (sync() < 0)
         return -1;
+
+    if (ch != traits_type::eof()) {
+        *pptr() = (char_type) ch;
+        pbump(1);
     }
 
-    // Initialize the locking variable
-    blocking_cl.reset(new conditional_locker<size_t>());
+    return 1;
+}
 
-    // Set a write completion callback
-    rb_handler->SetWriteBufferDrainCb([this](size_t amt __attribute__((unused))) {
-        blocking_cl->unlock(amt);
-    });
+int BufferHandlerOStreambuf::sync() {
+    if (rb_handler == NULL)
+        return -1;
 
-    while (1) {
-        if (rb_handler->PutWriteBufferData((void *) &ch, 1, true) == 1) {
-            rb_handler->RemoveWriteBufferDrainCb();
-            return 1;
-        }
+    size_t sz = pptr() - pbase();
 
-        blocking_cl->block_until();
+    if (sz > 0) {
+        if (put_data(pbase(), sz) < 0)
+            return -1;
     }
 
-    rb_handler->RemoveWriteBufferDrainCb();
+    setp(chunk, chunk + chunk_sz);
 
-    return 1;
+    return 0;
 }
 
 BufferHandlerOStringStreambuf::~BufferHandlerOStringStreambuf() {
@@ -49,6 +49,13 @@ public:
     // Fetch total size of buffer; -1 indicates unbounded dynamic buffer
     virtual ssize_t size() = 0;
 
+    // Make room for an upcoming write of in_sz bytes if the buffer can;
+    // growable implementations expand here, fixed ones just report
+    // whether the space already exists
+    virtual bool ensure(size_t in_sz) {
+        return available() >= (ssize_t) in_sz;
+    }
+
     // Fetch available space in buffer, -1 indicates unbounded dynamic buffer
     virtual ssize_t available() = 0;
 
@@ -135,6 +142,43 @@ public:
     // implementations should protect peek data cross-thread using the peek_mutex 
     virtual ssize_t zero_copy_peek(unsigned char **data, size_t in_sz) = 0;
 
+    // Peek the readable contents as up to two zero-copy segments; buffers
+    // which wrap (like a ring) override this to expose both sides of the
+    // wrap so IO drivers can hand the whole buffer to writev() in a single
+    // syscall.  The default maps onto zero_copy_peek and returns a single
+    // segment.
+    //
+    // The peek must be concluded with peek_free(seg_a), and is subject to
+    // the same single-outstanding-peek rules as the other peek operations.
+    virtual ssize_t zero_copy_peek_vector(unsigned char **seg_a, size_t *len_a,
+            unsigned char **seg_b, size_t *len_b, size_t in_sz) {
+        *seg_b = NULL;
+        *len_b = 0;
+
+        ssize_t r = zero_copy_peek(seg_a, in_sz);
+
+        *len_a = r > 0 ? r : 0;
+
+        return r;
+    }
+
+    // Reserve writable space as up to two zero-copy segments, following the
+    // same override logic as zero_copy_peek_vector; lets IO drivers fill
+    // both sides of a ring wrap with one readv().  The reservation must be
+    // concluded with commit(seg_a, total_sz), where total_sz may span both
+    // segments.
+    virtual ssize_t zero_copy_reserve_vector(unsigned char **seg_a, size_t *len_a,
+            unsigned char **seg_b, size_t *len_b, size_t in_sz) {
+        *seg_b = NULL;
+        *len_b = 0;
+
+        ssize_t r = zero_copy_reserve(seg_a, in_sz);
+
+        *len_a = r > 0 ? r : 0;
+
+        return r;
+    }
+
     // Deallocate peeked data; implementations should also use this time to release
     // the peek_mutex lock on peek data
     virtual void peek_free(unsigned char *data) = 0;
@@ -182,6 +226,10 @@ public:
     virtual ssize_t GetReadBufferAvailable();
     virtual ssize_t GetWriteBufferAvailable();
 
+    // Make room for an upcoming write, growing the buffer when the
+    // implementation supports it; false if the space can't be had
+    virtual bool EnsureWriteBufferSpace(size_t in_sz);
+
     // Fetch read and write buffer data, up to in_amt.  Does not consume data.
     // When possible, minimizes copies; actual copy and memory use depends on the
     // lower-level buffer, and consumers should not rely on specific behaviors.
@@ -200,6 +248,12 @@ public:
     virtual ssize_t ZeroCopyPeekReadBufferData(void **in_ptr, size_t in_sz);
     virtual ssize_t ZeroCopyPeekWriteBufferData(void **in_ptr, size_t in_sz);
 
+    // Zero-copy peek of the write buffer as up to two segments, exposing
+    // both sides of a ring wrap for scatter-gather IO; conclude with
+    // PeekFreeWriteBufferData(seg_a)
+    virtual ssize_t ZeroCopyPeekWriteBufferVector(void **seg_a, size_t *len_a,
+            void **seg_b, size_t *len_b, size_t in_sz);
+
     virtual void PeekFreeReadBufferData(void *in_ptr);
     virtual void PeekFreeWriteBufferData(void *in_ptr);
 
@@ -219,11 +273,32 @@ public:
     virtual size_t PutReadBufferData(void *in_ptr, size_t in_sz, bool in_atomic);
     virtual size_t PutWriteBufferData(void *in_ptr, size_t in_sz, bool in_atomic);
 
-    // Place data, as a string, into the buffer as an atomic op; returns success 
+    // Place data, as a string, into the buffer as an atomic op; returns success
     // or failure on placing the entire record.
     virtual bool PutReadBufferData(std::string in_data);
     virtual bool PutWriteBufferData(std::string in_data);
 
+    // Blocking variants of the Put operations; write as much as currently
+    // fits, then sleep on a conditional notified by the consume path until
+    // the remainder fits or timeout_ms expires.  A timeout of 0 waits
+    // forever.  Returns the amount actually written.
+    //
+    // These sleep instead of spinning on the drain callbacks, and MUST NOT
+    // be called from the thread which drains the buffer (typically the
+    // pollable IO loop) or they will deadlock waiting on themselves.
+    virtual size_t PutReadBufferData_Blocking(void *in_ptr, size_t in_sz,
+            unsigned int timeout_ms);
+    virtual size_t PutWriteBufferData_Blocking(void *in_ptr, size_t in_sz,
+            unsigned int timeout_ms);
+
+    // Sleep until at least in_sz bytes of space exist in the write buffer,
+    // or until at least in_sz bytes of data exist in the read buffer, or
+    // until timeout_ms expires (0 waits forever).  Returns false on
+    // timeout.  Subject to the same IO-thread restriction as the blocking
+    // put operations.
+    virtual bool WaitWriteBufferAvailable(size_t in_sz, unsigned int timeout_ms);
+    virtual bool WaitReadBufferData(size_t in_sz, unsigned int timeout_ms);
+
     // Reserve space in the buffers; the returned pointer is suitable for direct
     // writing.  Whenever possible, this will be a zero-copy operation, however on
     // some buffer structures this may require copying of the data content to the
@@ -253,7 +328,14 @@ public:
     // Returns the amount of data available in the reserved block
     virtual ssize_t ZeroCopyReserveReadBufferData(void **in_ptr, size_t len);
     virtual ssize_t ZeroCopyReserveWriteBufferData(void **in_ptr, size_t len);
-    
+
+    // Zero-copy reservation of read buffer space as up to two segments,
+    // exposing both sides of a ring wrap for scatter-gather IO; conclude
+    // with CommitReadBufferData(seg_a, total_sz), which may span both
+    // segments
+    virtual ssize_t ZeroCopyReserveReadBufferVector(void **seg_a, size_t *len_a,
+            void **seg_b, size_t *len_b, size_t len);
+
 
     // Commit a pending reserved data block to the buffer
     //
@@ -305,6 +387,15 @@ protected:
 
     std::function<void (size_t)> readbuf_drain_cb;
     std::function<void (size_t)> writebuf_drain_cb;
+
+    // Conditionals notified by buffer state changes, used by the blocking
+    // operations to sleep precisely until space or data exists instead of
+    // polling via the drain callbacks.  The drain conditionals fire when a
+    // buffer is consumed; the avail conditional fires when data lands in
+    // the read buffer.
+    conditional_locker<size_t> read_drain_cl;
+    conditional_locker<size_t> write_drain_cl;
+    conditional_locker<size_t> read_avail_cl;
 };
 
 template<class B> 
@@ -329,12 +420,21 @@ public:
     }
 };
 
-// A C++ streambuf-compatible wrapper around a buf handler
+// A C++ streambuf-compatible wrapper around a buf handler.  Maintains a
+// chunk-sized put area so serializers which emit floods of tiny writes hand
+// data to the buffer handler in whole chunks, instead of one locked buffer
+// operation per streamed item
 struct BufferHandlerOStreambuf : public std::streambuf {
     BufferHandlerOStreambuf(std::shared_ptr<BufferHandlerGeneric > in_rbhandler) :
-        rb_handler(in_rbhandler), blocking(false) { }
+        rb_handler(in_rbhandler), blocking(false) {
+        chunk = new char[chunk_sz];
+        setp(chunk, chunk + chunk_sz);
+    }
     BufferHandlerOStreambuf(std::shared_ptr<BufferHandlerGeneric > in_rbhandler, bool in_blocking) :
-        rb_handler(in_rbhandler), blocking(in_blocking) { }
+        rb_handler(in_rbhandler), blocking(in_blocking) {
+        chunk = new char[chunk_sz];
+        setp(chunk, chunk + chunk_sz);
+    }
 
     virtual ~BufferHandlerOStreambuf();
 
@@ -342,15 +442,26 @@ protected:
     std::streamsize xsputn(const char_type *s, std::streamsize n) override;
     int_type overflow(int_type ch) override;
 
+    // Flush the pending put area into the buffer handler
+    int sync() override;
+
 private:
+    // Hand a block to the buffer handler, blocking on a full buffer if we're
+    // in blocking mode
+    std::streamsize put_data(const char *s, std::streamsize n);
+
+    // Put area size; fixed, the buffer handler takes over past this point so
+    // we never grow-and-recopy like a string buffer
+    static const size_t chunk_sz = 4096;
+
     // buf handler we bind to
     std::shared_ptr<BufferHandlerGeneric > rb_handler;
 
     // Do we block when buffer is full?
     bool blocking;
 
-    // Locker variable if we block
-    std::shared_ptr<conditional_locker<size_t> > blocking_cl;
+    // Local put area
+    char *chunk;
 };
 
 // A C++ streambuf-compatible wrapper around a buf handler with an interstitial string
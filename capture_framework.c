@@ -35,6 +35,8 @@
 #include <stdio.h>
 #include <stdbool.h>
 
+#include <zlib.h>
+
 #ifdef HAVE_CAPABILITY
 #include <sys/capability.h>
 #include <sys/prctl.h>
@@ -53,6 +55,10 @@
 #include "protobuf_c/kismet.pb-c.h"
 #include "protobuf_c/datasource.pb-c.h"
 
+static int cf_batch_flush(kis_capture_handler_t *caph);
+static void cf_batch_flush_aged(kis_capture_handler_t *caph);
+static int cf_send_comp_offer(kis_capture_handler_t *caph);
+
 uint32_t adler32_partial_csum(uint8_t *in_buf, size_t in_len,
         uint32_t *s1, uint32_t *s2) {
 	size_t i;
@@ -351,6 +357,18 @@ kis_capture_handler_t *cf_handler_init(const char *in_type) {
         return NULL;
     }
 
+    ch->shm_ring = NULL;
+    ch->shm_ring_accepted = 0;
+
+    ch->batch_enabled = 0;
+    ch->batch_max_sz = 0;
+    ch->batch_max_us = 0;
+    ch->batch_buf = NULL;
+    ch->batch_len = 0;
+
+    ch->comp_enabled = 0;
+    ch->comp_level = Z_DEFAULT_COMPRESSION;
+
     pthread_mutexattr_init(&mutexattr);
     pthread_mutexattr_settype(&mutexattr, PTHREAD_MUTEX_RECURSIVE);
     pthread_mutex_init(&(ch->out_ringbuf_lock), &mutexattr);
@@ -430,6 +448,12 @@ void cf_handler_free(kis_capture_handler_t *caph) {
     if (caph->out_ringbuf != NULL)
         kis_simple_ringbuf_free(caph->out_ringbuf);
 
+    if (caph->shm_ring != NULL)
+        kis_shm_ring_free(caph->shm_ring);
+
+    if (caph->batch_buf != NULL)
+        free(caph->batch_buf);
+
     for (szi = 0; szi < caph->channel_hop_list_sz; szi++) {
         if (caph->channel_hop_list[szi] != NULL)
             free(caph->channel_hop_list[szi]);
@@ -609,6 +633,17 @@ void cf_handler_set_hop_shuffle_spacing(kis_capture_handler_t *caph, int spacing
     pthread_mutex_unlock(&(caph->handler_lock));
 }
 
+void cf_handler_set_data_batching(kis_capture_handler_t *caph, size_t max_sz,
+        unsigned int max_us) {
+    pthread_mutex_lock(&(caph->handler_lock));
+
+    caph->batch_enabled = 1;
+    caph->batch_max_sz = max_sz;
+    caph->batch_max_us = max_us;
+
+    pthread_mutex_unlock(&(caph->handler_lock));
+}
+
 void cf_handler_list_devices(kis_capture_handler_t *caph) {
     cf_params_list_interface_t **interfaces = NULL;
 
@@ -1144,6 +1179,9 @@ int cf_handle_rx_data(kis_capture_handler_t *caph) {
     /* Buffer of entire frame, dynamic */
     uint8_t *frame_buf;
 
+    /* Is the frame claimed in-place in the ring? */
+    int zero_copy = 0;
+
     /* Incoming size */
     uint32_t packet_sz;
     uint32_t total_sz;
@@ -1198,23 +1236,30 @@ int cf_handle_rx_data(kis_capture_handler_t *caph) {
         return 0;
     }
 
-    /* We've got enough to read it all; allocate the buffer and read it in */
-    frame_buf = (uint8_t *) malloc(total_sz);
+    /* We've got enough to read it all; try to claim the frame in place in
+     * the ring first, and fall back to copying it out if it wraps the ring */
+    if (kis_simple_ringbuf_peek_zc(caph->in_ringbuf, (void **) &frame_buf,
+                total_sz) == (size_t) total_sz) {
+        zero_copy = 1;
+    } else {
+        frame_buf = (uint8_t *) malloc(total_sz);
 
-    if (frame_buf == NULL) {
-        fprintf(stderr, "FATAL:  Could not allocate read buffer\n");
-        return -1;
-    }
+        if (frame_buf == NULL) {
+            fprintf(stderr, "FATAL:  Could not allocate read buffer\n");
+            return -1;
+        }
 
-    /* Peek our ring buffer */
-    if (kis_simple_ringbuf_peek(caph->in_ringbuf, frame_buf, total_sz) != total_sz) {
-        fprintf(stderr, "FATAL: Failed to read packet from ringbuf\n");
-        free(frame_buf);
-        return -1;
-    }
+        /* Peek our ring buffer */
+        if (kis_simple_ringbuf_peek(caph->in_ringbuf, frame_buf, total_sz) != total_sz) {
+            fprintf(stderr, "FATAL: Failed to read packet from ringbuf\n");
+            free(frame_buf);
+            return -1;
+        }
 
-    /* Clear it out from the buffer */
-    kis_simple_ringbuf_read(caph->in_ringbuf, NULL, total_sz);
+        /* Clear it out from the buffer; a zero-copy frame is consumed only
+         * once we're done with the ring memory */
+        kis_simple_ringbuf_read(caph->in_ringbuf, NULL, total_sz);
+    }
 
     external_frame = (kismet_external_frame_t *) frame_buf;
 
@@ -1226,16 +1271,26 @@ int cf_handle_rx_data(kis_capture_handler_t *caph) {
     if (calc_checksum != data_checksum) {
         fprintf(stderr, "DEBUG - C - Checksum %x calced %x len %u\n", calc_checksum, data_checksum, packet_sz);
         fprintf(stderr, "FATAL:  Invalid frame received, checksum does not match\n");
-        free(frame_buf);
+        if (zero_copy)
+            kis_simple_ringbuf_read(caph->in_ringbuf, NULL, total_sz);
+        else
+            free(frame_buf);
         return -1;
     }
 
     /* Unpack the protbuf */
     kds_cmd = kismet_external__command__unpack(NULL, packet_sz, external_frame->data);
 
+    /* The unpacked command holds its own copy of everything, so we're done
+     * with the frame either way; for a zero-copy frame that means finally
+     * consuming it out of the ring */
+    if (zero_copy)
+        kis_simple_ringbuf_read(caph->in_ringbuf, NULL, total_sz);
+    else
+        free(frame_buf);
+
     if (kds_cmd == NULL) {
         fprintf(stderr, "FATAL:  Invalid frame received, unable to unpack command\n");
-        free(frame_buf);
         return -1;
     }
 
@@ -1249,6 +1304,63 @@ int cf_handle_rx_data(kis_capture_handler_t *caph) {
         cbret = 1;
         goto finish;
     } else if (strcasecmp(kds_cmd->command, "PONG") == 0) {
+        cbret = 1;
+        goto finish;
+    } else if (strcasecmp(kds_cmd->command, "SHMRINGRESULT") == 0) {
+        KismetExternal__ShmRingResult *rres;
+
+        rres = kismet_external__shm_ring_result__unpack(NULL, kds_cmd->content.len,
+                kds_cmd->content.data);
+
+        if (rres == NULL) {
+            fprintf(stderr, "FATAL:  Invalid frame received, unable to unpack "
+                    "SHMRINGRESULT command\n");
+            cbret = -1;
+            goto finish;
+        }
+
+        if (caph->shm_ring != NULL) {
+            if (rres->accepted) {
+                /* Flip the flag inside the output lock so the send path can
+                 * never see it before the ring is ready; the server unlinks
+                 * the backing file once it has it mapped */
+                pthread_mutex_lock(&(caph->out_ringbuf_lock));
+                caph->shm_ring_accepted = 1;
+                pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+            } else {
+                /* Server declined or couldn't map it; stay on the pipe */
+                kis_shm_ring_free(caph->shm_ring);
+                caph->shm_ring = NULL;
+            }
+        }
+
+        kismet_external__shm_ring_result__free_unpacked(rres, NULL);
+
+        cbret = 1;
+        goto finish;
+    } else if (strcasecmp(kds_cmd->command, "COMPRESULT") == 0) {
+        KismetExternal__CompressionResult *cres;
+
+        cres = kismet_external__compression_result__unpack(NULL, kds_cmd->content.len,
+                kds_cmd->content.data);
+
+        if (cres == NULL) {
+            fprintf(stderr, "FATAL:  Invalid frame received, unable to unpack "
+                    "COMPRESULT command\n");
+            cbret = -1;
+            goto finish;
+        }
+
+        if (cres->accepted) {
+            /* Flip the flag inside the output lock so the send path picks it
+             * up cleanly; from here on data frames go out as COMPBLOCKs */
+            pthread_mutex_lock(&(caph->out_ringbuf_lock));
+            caph->comp_enabled = 1;
+            pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+        }
+
+        kismet_external__compression_result__free_unpacked(cres, NULL);
+
         cbret = 1;
         goto finish;
     } else if (strcasecmp(kds_cmd->command, "KDSLISTINTERFACES") == 0) {
@@ -1564,7 +1676,6 @@ int cf_handle_rx_data(kis_capture_handler_t *caph) {
 finish:
     pthread_mutex_unlock(&(caph->handler_lock));
     kismet_external__command__free_unpacked(kds_cmd, NULL);
-    free(frame_buf);
 
     return cbret;
 }
@@ -1698,94 +1809,326 @@ int cf_handler_remote_connect(kis_capture_handler_t *caph) {
 
     fprintf(stderr, "INFO - Connected to '%s:%u'...\n", caph->remote_host, caph->remote_port);
 
+    /* Reset any compression state from a previous connection */
+    caph->comp_enabled = 0;
+
     /* Send the NEWSOURCE command to the Kismet server */
     cf_send_newsource(caph, uuid);
 
+    /* Offer compressed data frames; raw radiotap over a WAN link wastes a
+     * lot of uplink.  An older server simply never answers the offer and
+     * we keep sending uncompressed. */
+    cf_send_comp_offer(caph);
+
     if (uuid)
         free(uuid);
 
     return 1;
 }
 
-int cf_handler_loop(kis_capture_handler_t *caph) {
-    fd_set rset, wset;
-    int max_fd;
+/* Pick the IO descriptors for a handler - the tcp socket for remote
+ * capture, the IPC pipe pair otherwise */
+static void cf_handler_io_fds(kis_capture_handler_t *caph,
+        int *read_fd, int *write_fd) {
+    if (caph->tcp_fd >= 0) {
+        *read_fd = caph->tcp_fd;
+        *write_fd = caph->tcp_fd;
+    } else {
+        *read_fd = caph->in_fd;
+        *write_fd = caph->out_fd;
+    }
+}
+
+/* Cancel the capture thread of a handler which has left the select loop */
+static void cf_handler_kill_capture(kis_capture_handler_t *caph) {
+    pthread_mutex_lock(&(caph->out_ringbuf_lock));
+    if (caph->capture_running) {
+        pthread_cancel(caph->capturethread);
+        caph->capture_running = 0;
+    }
+    pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+}
+
+/* Stage a handler's descriptors into the select sets, raising max_fd and
+ * shrinking the select timeout if a partial batch needs an early flush.
+ *
+ * Returns:
+ * -1   Fatal condition (shutdown flagged, or ping timeout); handler is done
+ *  0   Staged, keep servicing
+ *  1   Spindown complete, handler is done cleanly
+ */
+static int cf_handler_stage_fds(kis_capture_handler_t *caph, fd_set *rset,
+        fd_set *wset, int *max_fd, struct timeval *tm) {
     int read_fd, write_fd;
-    struct timeval tm;
     int spindown;
-    int ret;
-    int rv = 0;
 
-    if (caph->tcp_fd >= 0) {
-        read_fd = caph->tcp_fd;
-        write_fd = caph->tcp_fd;
-    } else {
-        /* Set our descriptors as nonblocking */
-        fcntl(caph->in_fd, F_SETFL, fcntl(caph->in_fd, F_GETFL, 0) | O_NONBLOCK);
-        fcntl(caph->out_fd, F_SETFL, fcntl(caph->out_fd, F_GETFL, 0) | O_NONBLOCK);
+    cf_handler_io_fds(caph, &read_fd, &write_fd);
 
-        read_fd = caph->in_fd;
-        write_fd = caph->out_fd;
+    /* Check shutdown state or if we're spinning down */
+    pthread_mutex_lock(&(caph->handler_lock));
+
+    /* Hard shutdown */
+    if (caph->shutdown) {
+        fprintf(stderr, "FATAL: Shutting down main select loop\n");
+        pthread_mutex_unlock(&(caph->handler_lock));
+        return -1;
     }
 
-    /* Basic select loop using ring buffers; we fill in from the read descriptor
-     * and try to make frames; similarly we populate the outbound descriptor from
-     * anything that comes in from our IO thread */
-    while (1) {
-        FD_ZERO(&rset);
-        FD_ZERO(&wset);
+    if (caph->last_ping != 0 && time(NULL) - caph->last_ping > 15) {
+        fprintf(stderr, "FATAL - Capture source did not get PING from Kismet for "
+                "over 15 seconds; shutting down\n");
+        pthread_mutex_unlock(&(caph->handler_lock));
+        return -1;
+    }
 
-        /* Check shutdown state or if we're spinning down */
-        pthread_mutex_lock(&(caph->handler_lock));
+    /* Copy spindown state outside of lock */
+    spindown = caph->spindown;
 
-        /* Hard shutdown */
-        if (caph->shutdown) {
-            fprintf(stderr, "FATAL: Shutting down main select loop\n");
-            pthread_mutex_unlock(&(caph->handler_lock));
-            rv = -1;
-            break;
-        }
+    pthread_mutex_unlock(&(caph->handler_lock));
 
-        if (caph->last_ping != 0 && time(NULL) - caph->last_ping > 15) {
-            fprintf(stderr, "FATAL - Capture source did not get PING from Kismet for "
-                    "over 15 seconds; shutting down\n");
-            pthread_mutex_unlock(&(caph->handler_lock));
-            rv = -1;
-            break;
-        }
+    /* Flush any batch that has been held past its batching time */
+    if (caph->batch_enabled)
+        cf_batch_flush_aged(caph);
 
-        /* Copy spindown state outside of lock */
-        spindown = caph->spindown;
+    /* Only set read sets if we're not spinning down */
+    if (spindown == 0) {
+        FD_SET(read_fd, rset);
+        if (*max_fd < read_fd)
+            *max_fd = read_fd;
+    }
+
+    /* Inspect the write buffer - do we have data? */
+    pthread_mutex_lock(&(caph->out_ringbuf_lock));
+
+    if (kis_simple_ringbuf_used(caph->out_ringbuf) != 0) {
+        FD_SET(write_fd, wset);
+        if (*max_fd < write_fd)
+            *max_fd = write_fd;
+    } else if (spindown != 0) {
+        pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+        return 1;
+    }
+
+    pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+
+    /* Wake up sooner if a partial batch is waiting to be flushed */
+    if (caph->batch_enabled) {
+        pthread_mutex_lock(&(caph->handler_lock));
+
+        if (caph->batch_len > 0 && tm->tv_sec == 0 &&
+                caph->batch_max_us < (unsigned int) tm->tv_usec)
+            tm->tv_usec = caph->batch_max_us;
 
         pthread_mutex_unlock(&(caph->handler_lock));
+    }
 
-        max_fd = 0;
+    return 0;
+}
+
+/* Service a handler's descriptors after select; reads whatever the remote
+ * side sent and flushes the outbound ringbuffer.
+ *
+ * Returns:
+ * -1   Fatal error; handler is done
+ *  0   Serviced
+ */
+static int cf_handler_service_fds(kis_capture_handler_t *caph, fd_set *rset,
+        fd_set *wset) {
+    int read_fd, write_fd;
+
+    cf_handler_io_fds(caph, &read_fd, &write_fd);
+
+    if (FD_ISSET(read_fd, rset)) {
+        while (kis_simple_ringbuf_available(caph->in_ringbuf)) {
+            /* We use a fixed-length read buffer for simplicity, and we shouldn't
+             * ever have too many incoming packets queued because the datasource
+             * protocol is very tx-heavy */
+            ssize_t amt_read;
+            size_t amt_buffered;
+            uint8_t rbuf[1024];
+
+            /* We deliberately read as much as we need and try to put it in the 
+             * buffer, if the buffer fills up something has gone wrong anyhow */
+
+            /* If it looks like we're doing remote cap over tcp, use recv because
+             * OSX seems to ignore O_NONBLOCK; on the other hand, if it's IPC over
+             * pipes, we HAVE to use read because recv will fail! */
+            if (caph->remote_host != NULL)
+                amt_read = recv(read_fd, rbuf, 1024, MSG_DONTWAIT);
+            else
+                amt_read = read(read_fd, rbuf, 1024);
+
+            if (amt_read <= 0) {
+                if (errno != EINTR && errno != EAGAIN) {
+                    /* Bail entirely */
+                    if (amt_read == 0) {
+                        fprintf(stderr, "FATAL: Remote side closed read pipe\n");
+                    } else {
+                        fprintf(stderr, "FATAL:  Error during read(): %s\n", 
+                                strerror(errno));
+                    }
+                    return -1;
+                } else {
+                    /* Drop out of read/process loop */
+                    break;
+                }
+            }
+
+            amt_buffered = kis_simple_ringbuf_write(caph->in_ringbuf, rbuf, amt_read);
 
-        /* Only set read sets if we're not spinning down */
-        if (spindown == 0) {
-            /* Only set rset if we're not spinning down */
-            FD_SET(read_fd, &rset);
-            max_fd = read_fd;
+            if ((ssize_t) amt_buffered != amt_read) {
+                /* Bail entirely - to do, report error if we can over connection */
+                fprintf(stderr, "FATAL:  Error during read(): insufficient buffer space\n");
+                return -1;
+            }
+
+            /* fprintf(stderr, "debug - capframework - read %lu\n", amt_buffered); */
+
+            /* See if we have a complete packet to do something with */
+            if (cf_handle_rx_data(caph) < 0) {
+                /* Enter spindown if processing an incoming packet failed */
+                cf_handler_spindown(caph);
+            }
         }
+    }
+
+    if (FD_ISSET(write_fd, wset)) {
+        /* We can write data - lock the ring buffer mutex and write out
+         * whatever we can; we peek the ringbuffer and then flag off what
+         * we've successfully written out */
+        ssize_t written_sz;
+        size_t peek_sz;
+        size_t peeked_sz;
+        uint8_t *peek_buf;
 
-        /* Inspect the write buffer - do we have data? */
         pthread_mutex_lock(&(caph->out_ringbuf_lock));
 
-        if (kis_simple_ringbuf_used(caph->out_ringbuf) != 0) {
-            FD_SET(write_fd, &wset);
-            if (max_fd < write_fd)
-                max_fd = write_fd;
-        } else if (spindown != 0) {
+        peek_sz = kis_simple_ringbuf_used(caph->out_ringbuf);
+
+        /* Don't know how we'd get here... */
+        if (peek_sz == 0) {
             pthread_mutex_unlock(&(caph->out_ringbuf_lock));
-            rv = 0;
-            break;
+            return 0;
         }
 
+        peek_buf = (uint8_t *) malloc(peek_sz);
+
+        if (peek_buf == NULL) {
+            pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+            fprintf(stderr,
+                    "FATAL:  Error during write(): could not allocate write "
+                    "buffer space\n");
+            return -1;
+        }
+
+        peeked_sz = kis_simple_ringbuf_peek(caph->out_ringbuf, peek_buf, peek_sz);
+
+        /* fprintf(stderr, "debug - peeked %lu\n", peeked_sz); */
+
+        /* Same nonsense as before - send on tcp, write on pipes */
+        if (caph->remote_host != NULL)
+            written_sz = send(write_fd, peek_buf, peeked_sz, MSG_DONTWAIT);
+        else
+            written_sz = write(write_fd, peek_buf, peeked_sz);
+
+        if (written_sz < 0) {
+            if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+                pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+                fprintf(stderr,
+                        "FATAL:  Error during write(): %s\n", strerror(errno));
+                free(peek_buf);
+                return -1;
+            }
+        }
+
+        free(peek_buf);
+
+        /* Flag it as consumed */
+        kis_simple_ringbuf_read(caph->out_ringbuf, NULL, (size_t) written_sz);
+
+        /* Unlock */
         pthread_mutex_unlock(&(caph->out_ringbuf_lock));
 
+        /* Signal to any waiting IO that the buffer has some
+         * headroom */
+        pthread_cond_signal(&(caph->out_ringbuf_flush_cond));
+    }
+
+    return 0;
+}
+
+int cf_handler_loop(kis_capture_handler_t *caph) {
+    return cf_handler_multi_loop(&caph, 1);
+}
+
+int cf_handler_multi_loop(kis_capture_handler_t **caph_list,
+        unsigned int num_handlers) {
+    fd_set rset, wset;
+    int max_fd;
+    struct timeval tm;
+    int ret;
+    int hr;
+    unsigned int x;
+    unsigned int remaining;
+    int rv = 0;
+    int *handler_done;
+
+    if (num_handlers == 0)
+        return 0;
+
+    /* Nonzero once a handler has left the loop */
+    handler_done = (int *) calloc(num_handlers, sizeof(int));
+    if (handler_done == NULL)
+        return -1;
+
+    /* Set the pipe descriptors nonblocking; tcp sockets already are */
+    for (x = 0; x < num_handlers; x++) {
+        if (caph_list[x]->tcp_fd < 0) {
+            fcntl(caph_list[x]->in_fd, F_SETFL,
+                    fcntl(caph_list[x]->in_fd, F_GETFL, 0) | O_NONBLOCK);
+            fcntl(caph_list[x]->out_fd, F_SETFL,
+                    fcntl(caph_list[x]->out_fd, F_GETFL, 0) | O_NONBLOCK);
+        }
+    }
+
+    remaining = num_handlers;
+
+    /* Basic select loop using ring buffers; we fill in from the read
+     * descriptors and try to make frames; similarly we populate the
+     * outbound descriptors from anything that comes in from the IO
+     * threads.  All staged handlers share the one select, so a process
+     * owning several capture interfaces burns one loop, not one per
+     * interface. */
+    while (remaining > 0) {
+        FD_ZERO(&rset);
+        FD_ZERO(&wset);
+
+        max_fd = 0;
+
         tm.tv_sec = 0;
         tm.tv_usec = 500000;
 
+        for (x = 0; x < num_handlers; x++) {
+            if (handler_done[x])
+                continue;
+
+            hr = cf_handler_stage_fds(caph_list[x], &rset, &wset, &max_fd, &tm);
+
+            if (hr != 0) {
+                /* Handler finished, fatally or cleanly; kill its capture
+                 * thread and stop servicing it */
+                cf_handler_kill_capture(caph_list[x]);
+                handler_done[x] = 1;
+                remaining--;
+
+                if (hr < 0)
+                    rv = -1;
+            }
+        }
+
+        if (remaining == 0)
+            break;
+
         if ((ret = select(max_fd + 1, &rset, &wset, NULL, &tm)) < 0) {
             if (errno != EINTR && errno != EAGAIN) {
                 fprintf(stderr, "FATAL:  Error during select(): %s\n", strerror(errno));
@@ -1794,141 +2137,162 @@ int cf_handler_loop(kis_capture_handler_t *caph) {
             }
         }
 
-        if (ret == 0)
+        if (ret <= 0)
             continue;
 
-        if (FD_ISSET(read_fd, &rset)) {
-            while (kis_simple_ringbuf_available(caph->in_ringbuf)) {
-                /* We use a fixed-length read buffer for simplicity, and we shouldn't
-                 * ever have too many incoming packets queued because the datasource
-                 * protocol is very tx-heavy */
-                ssize_t amt_read;
-                size_t amt_buffered;
-                uint8_t rbuf[1024];
-
-                /* We deliberately read as much as we need and try to put it in the 
-                 * buffer, if the buffer fills up something has gone wrong anyhow */
-
-                /* If it looks like we're doing remote cap over tcp, use recv because
-                 * OSX seems to ignore O_NONBLOCK; on the other hand, if it's IPC over
-                 * pipes, we HAVE to use read because recv will fail! */
-                if (caph->remote_host != NULL)
-                    amt_read = recv(read_fd, rbuf, 1024, MSG_DONTWAIT);
-                else
-                    amt_read = read(read_fd, rbuf, 1024);
-
-                if (amt_read <= 0) {
-                    if (errno != EINTR && errno != EAGAIN) {
-                        /* Bail entirely */
-                        if (amt_read == 0) {
-                            fprintf(stderr, "FATAL: Remote side closed read pipe\n");
-                        } else {
-                            fprintf(stderr, "FATAL:  Error during read(): %s\n", 
-                                    strerror(errno));
-                        }
-                        rv = -1;
-                        goto cap_loop_fail;
-                    } else {
-                        /* Drop out of read/process loop */
-                        break;
-                    }
-                }
+        for (x = 0; x < num_handlers; x++) {
+            if (handler_done[x])
+                continue;
 
-                amt_buffered = kis_simple_ringbuf_write(caph->in_ringbuf, rbuf, amt_read);
+            if (cf_handler_service_fds(caph_list[x], &rset, &wset) < 0) {
+                cf_handler_kill_capture(caph_list[x]);
+                handler_done[x] = 1;
+                remaining--;
+                rv = -1;
+            }
+        }
+    }
 
-                if ((ssize_t) amt_buffered != amt_read) {
-                    /* Bail entirely - to do, report error if we can over connection */
-                    fprintf(stderr, "FATAL:  Error during read(): insufficient buffer space\n");
-                    rv = -1;
-                    goto cap_loop_fail;
-                }
+    /* Kill anything still running if we bailed out of the select */
+    for (x = 0; x < num_handlers; x++) {
+        if (!handler_done[x])
+            cf_handler_kill_capture(caph_list[x]);
+    }
 
-                /* fprintf(stderr, "debug - capframework - read %lu\n", amt_buffered); */
+    free(handler_done);
 
-                /* See if we have a complete packet to do something with */
-                if (cf_handle_rx_data(caph) < 0) {
-                    /* Enter spindown if processing an incoming packet failed */
-                    cf_handler_spindown(caph);
-                }
-            }
-        }
+    return rv;
+}
 
-        if (FD_ISSET(write_fd, &wset)) {
-            /* We can write data - lock the ring buffer mutex and write out
-             * whatever we can; we peek the ringbuffer and then flag off what
-             * we've successfully written out */
-            ssize_t written_sz;
-            size_t peek_sz;
-            size_t peeked_sz;
-            uint8_t *peek_buf;
+int cf_handler_shm_ring(kis_capture_handler_t *caph, size_t ring_sz) {
+    char path[128];
 
-            pthread_mutex_lock(&(caph->out_ringbuf_lock));
+    KismetExternal__ShmRingOffer offer;
+    uint8_t *buf;
+    size_t len;
 
-            peek_sz = kis_simple_ringbuf_used(caph->out_ringbuf);
+    /* Shared memory only makes sense when we're a local IPC child */
+    if (caph->remote_host != NULL || caph->tcp_fd >= 0)
+        return 0;
 
-            /* Don't know how we'd get here... */
-            if (peek_sz == 0) {
-                pthread_mutex_unlock(&(caph->out_ringbuf_lock));
-                continue;
-            }
+    if (caph->shm_ring != NULL)
+        return 0;
 
-            peek_buf = (uint8_t *) malloc(peek_sz);
+    snprintf(path, 128, "/dev/shm/kismet_datasource_%u",
+            (unsigned int) getpid());
 
-            if (peek_buf == NULL) {
-                pthread_mutex_unlock(&(caph->out_ringbuf_lock));
-                fprintf(stderr,
-                        "FATAL:  Error during write(): could not allocate write "
-                        "buffer space\n");
-                rv = -1;
-                break;
-            }
+    caph->shm_ring = kis_shm_ring_create(path, ring_sz);
 
-            peeked_sz = kis_simple_ringbuf_peek(caph->out_ringbuf, peek_buf, peek_sz);
+    if (caph->shm_ring == NULL)
+        return -1;
 
-            /* fprintf(stderr, "debug - peeked %lu\n", peeked_sz); */
+    kismet_external__shm_ring_offer__init(&offer);
 
-            /* Same nonsense as before - send on tcp, write on pipes */
-            if (caph->remote_host != NULL)
-                written_sz = send(write_fd, peek_buf, peeked_sz, MSG_DONTWAIT);
-            else
-                written_sz = write(write_fd, peek_buf, peeked_sz);
-
-            if (written_sz < 0) {
-                if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
-                    pthread_mutex_unlock(&(caph->out_ringbuf_lock));
-                    fprintf(stderr,
-                            "FATAL:  Error during write(): %s\n", strerror(errno));
-                    free(peek_buf);
-                    rv = -1;
-                    break;
-                }
-            }
+    offer.path = path;
+    offer.ring_sz = (uint32_t) caph->shm_ring->header->ring_sz;
 
-            free(peek_buf);
+    len = kismet_external__shm_ring_offer__get_packed_size(&offer);
+    buf = (uint8_t *) malloc(len);
 
-            /* Flag it as consumed */
-            kis_simple_ringbuf_read(caph->out_ringbuf, NULL, (size_t) written_sz);
+    if (buf == NULL) {
+        kis_shm_ring_free(caph->shm_ring);
+        caph->shm_ring = NULL;
+        return -1;
+    }
 
-            /* Unlock */
-            pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+    kismet_external__shm_ring_offer__pack(&offer, buf);
 
-            /* Signal to any waiting IO that the buffer has some
-             * headroom */
-            pthread_cond_signal(&(caph->out_ringbuf_flush_cond));
-        }
+    if (cf_send_packet(caph, "SHMRINGOFFER", buf, len) < 1) {
+        kis_shm_ring_free(caph->shm_ring);
+        caph->shm_ring = NULL;
+        return -1;
     }
 
-    /* Fall out of select loop */
-cap_loop_fail:
-    /* Kill the capture thread */
+    return 1;
+}
+
+/* Deposit a fully-formatted frame into the shared-memory ring and queue a
+ * doorbell command on the pipe; all-or-nothing, so if either the ring or
+ * the pipe is full the caller falls back to the normal pipe path.
+ *
+ * Returns:
+ * -1   An error occurred
+ *  0   Insufficient space in ring or doorbell buffer
+ *  1   Success
+ */
+static int cf_send_shm_frame(kis_capture_handler_t *caph, uint8_t *data, size_t len) {
+    uint32_t seqno;
+    KismetExternal__Command bell;
+
+    kismet_external_frame_t *frame;
+    size_t bell_data_sz;
+    size_t bell_total_sz;
+    uint8_t *bell_buffer;
+    uint32_t calc_checksum;
+
+    kismet_external__command__init(&bell);
+
+    pthread_mutex_lock(&(caph->handler_lock));
+    if (++caph->seqno == 0)
+        caph->seqno = 1;
+    seqno = caph->seqno;
+    pthread_mutex_unlock(&(caph->handler_lock));
+
+    bell.seqno = seqno;
+    bell.command = strdup("SHMRINGDATA");
+    bell.content.data = NULL;
+    bell.content.len = 0;
+
+    bell_data_sz = kismet_external__command__get_packed_size(&bell);
+    bell_total_sz = bell_data_sz + sizeof(kismet_external_frame_t);
+
+    bell_buffer = (uint8_t *) malloc(bell_total_sz);
+
+    if (bell_buffer == NULL) {
+        fprintf(stderr, "FATAL:  Unable to allocate the buffer for writing a packet");
+        free(bell.command);
+        return -1;
+    }
+
+    frame = (kismet_external_frame_t *) bell_buffer;
+
+    frame->signature = htonl(KIS_EXTERNAL_PROTO_SIG);
+    frame->data_sz = htonl(bell_data_sz);
+
+    kismet_external__command__pack(&bell, frame->data);
+
+    calc_checksum = adler32_csum(frame->data, bell_data_sz);
+    frame->data_checksum = htonl(calc_checksum);
+
+    /* The data frame and its doorbell go together or not at all, so check
+     * both buffers under the lock before committing to either */
     pthread_mutex_lock(&(caph->out_ringbuf_lock));
-    if (caph->capture_running) {
-        pthread_cancel(caph->capturethread);
-        caph->capture_running = 0;
+
+    if (kis_shm_ring_available(caph->shm_ring) < len ||
+            kis_simple_ringbuf_available(caph->out_ringbuf) < bell_total_sz) {
+        pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+        free(bell_buffer);
+        free(bell.command);
+        return 0;
     }
+
+    kis_shm_ring_write(caph->shm_ring, data, len);
+
+    if (kis_simple_ringbuf_write(caph->out_ringbuf, bell_buffer, bell_total_sz) !=
+            bell_total_sz) {
+        fprintf(stderr, "FATAL: Failed to write data to buffer\n");
+        pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+        free(bell_buffer);
+        free(bell.command);
+        return -1;
+    }
+
     pthread_mutex_unlock(&(caph->out_ringbuf_lock));
 
-    return rv;
+    free(bell_buffer);
+    free(bell.command);
+
+    return 1;
 }
 
 int cf_send_raw_bytes(kis_capture_handler_t *caph, uint8_t *data, size_t len) {
@@ -1950,6 +2314,33 @@ int cf_send_raw_bytes(kis_capture_handler_t *caph, uint8_t *data, size_t len) {
     return 1;
 }
 
+/* Offer zlib-compressed data frames to the server; remote links call this
+ * after connecting.  A server which doesn't understand the offer simply
+ * never answers and we keep sending uncompressed. */
+static int cf_send_comp_offer(kis_capture_handler_t *caph) {
+    KismetExternal__CompressionOffer offer;
+    uint8_t *buf;
+    size_t len;
+
+    kismet_external__compression_offer__init(&offer);
+
+    offer.method = strdup("zlib");
+
+    len = kismet_external__compression_offer__get_packed_size(&offer);
+    buf = (uint8_t *) malloc(len);
+
+    if (buf == NULL) {
+        free(offer.method);
+        return -1;
+    }
+
+    kismet_external__compression_offer__pack(&offer, buf);
+
+    free(offer.method);
+
+    return cf_send_packet(caph, "COMPOFFER", buf, len);
+}
+
 int cf_send_packet(kis_capture_handler_t *caph, const char *packtype,
         uint8_t *data, size_t len) {
     uint32_t seqno;
@@ -1979,8 +2370,44 @@ int cf_send_packet(kis_capture_handler_t *caph, const char *packtype,
     cmd.command = strdup(packtype);
     cmd.content.data = data;
     cmd.content.len = len;
-   
+
     data_sz = kismet_external__command__get_packed_size(&cmd);
+
+    /* Data frames bound for the compressor or the shm ring need a linear
+     * staging buffer anyway, but everything else can serialize directly
+     * into reserved space in the output ring and skip a copy */
+    if (!((caph->comp_enabled || caph->shm_ring_accepted) &&
+                (strcmp(packtype, "KDSDATAREPORT") == 0 ||
+                 strcmp(packtype, "KDSDATABATCH") == 0))) {
+        pthread_mutex_lock(&(caph->out_ringbuf_lock));
+
+        if (kis_simple_ringbuf_reserve(caph->out_ringbuf, (void **) &frame,
+                    data_sz + sizeof(kismet_external_frame_t))) {
+            frame->signature = htonl(KIS_EXTERNAL_PROTO_SIG);
+            frame->data_sz = htonl(data_sz);
+
+            kismet_external__command__pack(&cmd, frame->data);
+
+            calc_checksum = adler32_csum(frame->data, data_sz);
+            frame->data_checksum = htonl(calc_checksum);
+
+            kis_simple_ringbuf_commit(caph->out_ringbuf,
+                    data_sz + sizeof(kismet_external_frame_t));
+
+            pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+
+            free(data);
+            free(cmd.command);
+
+            return 1;
+        }
+
+        /* Ring full, or the frame would wrap; fall back to staging the
+         * frame and copying it in, which also handles the full-buffer
+         * backpressure path */
+        pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+    }
+
     send_buffer = (uint8_t *) malloc(data_sz + sizeof(kismet_external_frame_t));
 
     if (send_buffer == NULL) {
@@ -2005,6 +2432,49 @@ int cf_send_packet(kis_capture_handler_t *caph, const char *packtype,
 
     frame->data_checksum = htonl(calc_checksum);
 
+    /* If the server negotiated compression, wrap bulk data frames in a
+     * compressed block; control frames and the blocks themselves go out
+     * unchanged.  If compression fails or doesn't shrink the frame, fall
+     * through and send it as-is. */
+    if (caph->comp_enabled && (strcmp(packtype, "KDSDATAREPORT") == 0 ||
+                strcmp(packtype, "KDSDATABATCH") == 0)) {
+        uLongf comp_len = compressBound(data_sz + sizeof(kismet_external_frame_t));
+        uint8_t *comp_buf = (uint8_t *) malloc(comp_len);
+
+        if (comp_buf != NULL) {
+            if (compress2(comp_buf, &comp_len, send_buffer,
+                        data_sz + sizeof(kismet_external_frame_t),
+                        caph->comp_level) == Z_OK &&
+                    comp_len < data_sz + sizeof(kismet_external_frame_t)) {
+                free(send_buffer);
+                free(data);
+                free(cmd.command);
+
+                /* The recursive send takes ownership of comp_buf */
+                return cf_send_packet(caph, "COMPBLOCK", comp_buf, comp_len);
+            }
+
+            free(comp_buf);
+        }
+    }
+
+    /* Once a shared-memory ring has been negotiated, bulk data reports go
+     * into the ring with only a doorbell on the pipe; if the ring or the
+     * doorbell buffer is full, fall through to the pipe like normal */
+    if (caph->shm_ring_accepted && (strcmp(packtype, "KDSDATAREPORT") == 0 ||
+                strcmp(packtype, "KDSDATABATCH") == 0)) {
+        r = cf_send_shm_frame(caph, send_buffer,
+                data_sz + sizeof(kismet_external_frame_t));
+
+        if (r != 0) {
+            free(send_buffer);
+            free(data);
+            free(cmd.command);
+
+            return r;
+        }
+    }
+
     /* Send the whole frame */
     r = cf_send_raw_bytes(caph, send_buffer, data_sz + sizeof(kismet_external_frame_t));
 
@@ -2411,6 +2881,185 @@ int cf_send_openresp(kis_capture_handler_t *caph, uint32_t seq, unsigned int suc
     return cf_send_packet(caph, "KDSOPENSOURCEREPORT", buf, buf_len);
 }
 
+/* Encode a protobuf varint; returns the number of bytes used */
+static size_t cf_varint_encode(uint64_t v, uint8_t *out) {
+    size_t len = 0;
+
+    do {
+        out[len] = v & 0x7F;
+        v = v >> 7;
+
+        if (v)
+            out[len] |= 0x80;
+
+        len++;
+    } while (v);
+
+    return len;
+}
+
+/* Flush any pending batch as a single KDSDATABATCH command.
+ *
+ * Returns:
+ * -1   An error occurred
+ *  0   Insufficient space in buffer; the batch stays buffered and is
+ *      retried on the next flush
+ *  1   Success (or nothing pending)
+ */
+static int cf_batch_flush(kis_capture_handler_t *caph) {
+    uint8_t *buf;
+    size_t len;
+
+    /* Conservative bound on the framing around the batch payload: the
+     * external frame header plus the packed command overhead (command
+     * string, seqno, and content field tags) */
+    const size_t frame_overhead = sizeof(kismet_external_frame_t) + 64;
+
+    pthread_mutex_lock(&(caph->handler_lock));
+
+    if (caph->batch_buf == NULL || caph->batch_len == 0) {
+        pthread_mutex_unlock(&(caph->handler_lock));
+        return 1;
+    }
+
+    buf = caph->batch_buf;
+    len = caph->batch_len;
+
+    /* cf_send_packet frees the payload no matter what, so a full out ring
+     * mid-send would silently drop the whole batch; check for room before
+     * detaching (like cf_send_shm_frame does) and leave the batch
+     * buffered for the retry path instead.  With compression or a shm
+     * ring negotiated the frame may need less pipe space than this, so
+     * the worst case is holding the batch one cycle longer. */
+    pthread_mutex_lock(&(caph->out_ringbuf_lock));
+
+    if (kis_simple_ringbuf_available(caph->out_ringbuf) < len + frame_overhead) {
+        pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+        pthread_mutex_unlock(&(caph->handler_lock));
+        return 0;
+    }
+
+    pthread_mutex_unlock(&(caph->out_ringbuf_lock));
+
+    caph->batch_buf = NULL;
+    caph->batch_len = 0;
+
+    pthread_mutex_unlock(&(caph->handler_lock));
+
+    /* cf_send_packet takes ownership of the buffer */
+    return cf_send_packet(caph, "KDSDATABATCH", buf, len);
+}
+
+/* Flush a pending batch if the oldest report in it has been held longer
+ * than the configured batch time; called from the select loop so a lull
+ * in traffic can't strand a partial batch
+ */
+static void cf_batch_flush_aged(kis_capture_handler_t *caph) {
+    struct timeval now;
+    long age;
+    int flush = 0;
+
+    pthread_mutex_lock(&(caph->handler_lock));
+
+    if (caph->batch_len > 0) {
+        gettimeofday(&now, NULL);
+
+        age = (now.tv_sec - caph->batch_start.tv_sec) * 1000000L +
+            (now.tv_usec - caph->batch_start.tv_usec);
+
+        if (age >= (long) caph->batch_max_us)
+            flush = 1;
+    }
+
+    pthread_mutex_unlock(&(caph->handler_lock));
+
+    if (flush)
+        cf_batch_flush(caph);
+}
+
+/* Append a packed DataReport to the pending batch, flushing as needed;
+ * takes ownership of (and frees) the supplied buffer, like cf_send_packet.
+ *
+ * Returns:
+ * -1   An error occurred
+ *  0   Insufficient space in buffer
+ *  1   Success
+ */
+static int cf_batch_append(kis_capture_handler_t *caph, uint8_t *data, size_t len) {
+    /* Field 1, wire type 2 - a repeated embedded message - followed by its
+     * length; a sequence of reports framed this way is exactly the wire
+     * format of a packed DataReportBatch, so the batch never has to be
+     * re-serialized at flush time */
+    uint8_t hdr[11];
+    size_t hdr_len;
+    struct timeval now;
+    long age;
+    int flush = 0;
+    int r;
+
+    hdr[0] = 0x0A;
+    hdr_len = 1 + cf_varint_encode(len, hdr + 1);
+
+    /* A report too large to ever fit in a batch goes out the normal way */
+    if (hdr_len + len > caph->batch_max_sz)
+        return cf_send_packet(caph, "KDSDATAREPORT", data, len);
+
+    pthread_mutex_lock(&(caph->handler_lock));
+
+    /* Flush first if this report would overflow the pending batch */
+    if (caph->batch_buf != NULL &&
+            caph->batch_len + hdr_len + len > caph->batch_max_sz) {
+        pthread_mutex_unlock(&(caph->handler_lock));
+
+        if ((r = cf_batch_flush(caph)) < 1) {
+            free(data);
+            return r;
+        }
+
+        pthread_mutex_lock(&(caph->handler_lock));
+    }
+
+    if (caph->batch_buf == NULL) {
+        caph->batch_buf = (uint8_t *) malloc(caph->batch_max_sz);
+
+        if (caph->batch_buf == NULL) {
+            pthread_mutex_unlock(&(caph->handler_lock));
+            fprintf(stderr, "FATAL:  Unable to allocate the buffer for batching packets");
+            free(data);
+            return -1;
+        }
+
+        caph->batch_len = 0;
+    }
+
+    if (caph->batch_len == 0)
+        gettimeofday(&(caph->batch_start), NULL);
+
+    memcpy(caph->batch_buf + caph->batch_len, hdr, hdr_len);
+    caph->batch_len += hdr_len;
+
+    memcpy(caph->batch_buf + caph->batch_len, data, len);
+    caph->batch_len += len;
+
+    free(data);
+
+    /* Flush right away if we've filled the batch or held it too long */
+    gettimeofday(&now, NULL);
+
+    age = (now.tv_sec - caph->batch_start.tv_sec) * 1000000L +
+        (now.tv_usec - caph->batch_start.tv_usec);
+
+    if (caph->batch_len >= caph->batch_max_sz || age >= (long) caph->batch_max_us)
+        flush = 1;
+
+    pthread_mutex_unlock(&(caph->handler_lock));
+
+    if (flush)
+        return cf_batch_flush(caph);
+
+    return 1;
+}
+
 int cf_send_data(kis_capture_handler_t *caph,
         KismetExternal__MsgbusMessage *kv_message,
         KismetDatasource__SubSignal *kv_signal,
@@ -2450,6 +3099,11 @@ int cf_send_data(kis_capture_handler_t *caph,
 
     kismet_datasource__data_report__pack(&kedata, buf);
 
+    /* When batching, the report joins the pending batch instead of being
+     * framed on its own */
+    if (caph->batch_enabled)
+        return cf_batch_append(caph, buf, buf_len);
+
     return cf_send_packet(caph, "KDSDATAREPORT", buf, buf_len);
 }
 
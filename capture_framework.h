@@ -52,6 +52,7 @@
 #include <arpa/inet.h>
 
 #include "simple_ringbuf_c.h"
+#include "simple_shm_ring.h"
 
 #include "protobuf_c/kismet.pb-c.h"
 #include "protobuf_c/datasource.pb-c.h"
@@ -271,6 +272,28 @@ struct kis_capture_handler {
     kis_simple_ringbuf_t *in_ringbuf;
     kis_simple_ringbuf_t *out_ringbuf;
 
+    /* Optional shared-memory data ring; once the server accepts the offer,
+     * data reports are deposited directly into the ring and only a small
+     * doorbell command goes down the pipe */
+    kis_shm_ring_t *shm_ring;
+    int shm_ring_accepted;
+
+    /* Data report batching; packed DataReport blobs accumulate here and go
+     * out as one KDSDATABATCH command when the batch fills or ages out.
+     * Guarded by the handler lock. */
+    int batch_enabled;
+    size_t batch_max_sz;
+    unsigned int batch_max_us;
+    uint8_t *batch_buf;
+    size_t batch_len;
+    struct timeval batch_start;
+
+    /* Compressed data frames; remote connections offer zlib compression to
+     * the server, and once accepted, data frames are wrapped in COMPBLOCK
+     * commands to keep constrained uplinks from saturating */
+    int comp_enabled;
+    int comp_level;
+
     /* Lock for output buffer */
     pthread_mutex_t out_ringbuf_lock;
 
@@ -515,6 +538,14 @@ void cf_handler_assign_hop_channels(kis_capture_handler_t *caph, char **stringch
 /* Set a channel hop shuffle spacing */
 void cf_handler_set_hop_shuffle_spacing(kis_capture_handler_t *capf, int spacing);
 
+/* Batch data reports into KDSDATABATCH commands of up to max_sz bytes,
+ * holding a partial batch for at most max_us microseconds, so fast sources
+ * don't pay the framing and wakeup overhead per packet.  Requires a server
+ * which understands batched reports.
+ */
+void cf_handler_set_data_batching(kis_capture_handler_t *caph, size_t max_sz,
+        unsigned int max_us);
+
 
 
 /* Parse command line options
@@ -613,6 +644,37 @@ void cf_handler_remote_capture(kis_capture_handler_t *caph);
  */
 int cf_handler_loop(kis_capture_handler_t *caph);
 
+/* Service several capture handlers from one select() loop in one process;
+ * blocks until every handler has errored or been shut down.
+ *
+ * A capture binary which owns multiple interfaces can create a handler per
+ * interface (each with its own capture thread and its own connection to the
+ * server, so the per-source protocol is unchanged) and drive all of their
+ * IO from a single loop, instead of running one process per interface.
+ *
+ * Returns:
+ * -1   One or more handlers exited with an error
+ *  0   All handlers shut down cleanly
+ */
+int cf_handler_multi_loop(kis_capture_handler_t **caph_list,
+        unsigned int num_handlers);
+
+/* Create a shared-memory data ring of (at least) the given size and offer
+ * it to the Kismet server; once the server accepts, data reports bypass the
+ * pipe entirely.  Only meaningful for local IPC capture - does nothing on
+ * remote connections, where the ring is silently skipped.
+ *
+ * Capture drivers should call this after parsing options and launching any
+ * remote capture loop, but before jailing the filesystem or running
+ * cf_handler_loop, since the ring backing file is made on a tmpfs.
+ *
+ * Returns:
+ * -1   Error, the ring could not be created; the pipe is still usable
+ *  0   Ring not applicable (remote capture, or already made)
+ *  1   Ring created and offered
+ */
+int cf_handler_shm_ring(kis_capture_handler_t *caph, size_t ring_sz);
+
 /* Send a blob of data.  This must be a formatted packet created by one of the
  * other functions.
  *
@@ -61,6 +61,18 @@
 
 #include "../protobuf_c/linuxbluetooth.pb-c.h"
 
+/* Maximum devices coalesced into one report; scan results arrive in
+ * bursts, so we batch everything seen in one pass through the select
+ * loop instead of sending a report per device */
+#define BT_BATCH_MAX        16
+
+typedef struct {
+    struct timeval tv;
+    char address[18];
+    char *name;
+    int type;
+} pending_bt_device_t;
+
 /* Unique instance data passed around by capframework */
 typedef struct {
     /* Target interface */
@@ -80,6 +92,10 @@ typedef struct {
     /* Scanning type */
     uint8_t scan_type;
 
+    /* Devices pending in the current report batch */
+    pending_bt_device_t pending_devs[BT_BATCH_MAX];
+    unsigned int pending_len;
+
     kis_capture_handler_t *caph;
 } local_bluetooth_t;
 
@@ -102,43 +118,45 @@ static char *eir_get_name(const uint8_t *eir, uint16_t eir_len);
 static unsigned int eir_get_flags(const uint8_t *eir, uint16_t eir_len);
 void bdaddr_to_string(const uint8_t *bdaddr, char *str);
 
-int cf_send_btdevice(local_bluetooth_t *localbt, struct mgmt_ev_device_found *dev) {
+/* Send all pending devices as one batched report */
+int cf_flush_btdevices(local_bluetooth_t *localbt) {
     KismetLinuxBluetooth__LinuxBluetoothDataReport kereport;
-    KismetLinuxBluetooth__SubLinuxBluetoothDevice kebtdev;
+    KismetLinuxBluetooth__SubLinuxBluetoothDevice kebtdevs[BT_BATCH_MAX];
+    KismetLinuxBluetooth__SubLinuxBluetoothDevice *kebtdev_ptrs[BT_BATCH_MAX];
 
-    struct timeval tv;
-    char address[BDADDR_STR_LEN];
-    char *name;
-    uint16_t eirlen;
+    unsigned int i;
 
     uint8_t *buf;
     size_t len;
 
+    int r;
+
+    if (localbt->pending_len == 0)
+        return 0;
+
     kismet_linux_bluetooth__linux_bluetooth_data_report__init(&kereport);
-    kismet_linux_bluetooth__sub_linux_bluetooth_device__init(&kebtdev);
 
-    gettimeofday(&tv, NULL);
+    for (i = 0; i < localbt->pending_len; i++) {
+        pending_bt_device_t *pend = &(localbt->pending_devs[i]);
 
-    /* Convert the address */
-    bdaddr_to_string(dev->addr.bdaddr.b, address);
+        kismet_linux_bluetooth__sub_linux_bluetooth_device__init(&kebtdevs[i]);
 
-    /* Extract the name from EIR */
-    eirlen = le16toh(dev->eir_len);
-    name = eir_get_name(dev->eir, eirlen);
+        kebtdevs[i].time_sec = pend->tv.tv_sec;
+        kebtdevs[i].time_usec = pend->tv.tv_usec;
+        kebtdevs[i].address = pend->address;
+        kebtdevs[i].name = pend->name;
+        kebtdevs[i].type = pend->type;
 
-    kebtdev.time_sec = tv.tv_sec;
-    kebtdev.time_usec = tv.tv_usec;
-    kebtdev.address = address;
-    kebtdev.name = name;
-    kebtdev.type = dev->addr.type;
+        /* We don't get txpower or uuids currently */
 
-    /* We don't get txpower or uuids currently */
+        kebtdev_ptrs[i] = &kebtdevs[i];
+    }
 
-    kereport.btdevice = &kebtdev;
+    kereport.n_btdevice_list = localbt->pending_len;
+    kereport.btdevice_list = kebtdev_ptrs;
 
     /* TODO get a GPS function from capframework and fill it in here */
 
-
     len = kismet_linux_bluetooth__linux_bluetooth_data_report__get_packed_size(&kereport);
     buf = (uint8_t *) malloc(len);
 
@@ -148,7 +166,44 @@ int cf_send_btdevice(local_bluetooth_t *localbt, struct mgmt_ev_device_found *de
 
     kismet_linux_bluetooth__linux_bluetooth_data_report__pack(&kereport, buf);
 
-    return cf_send_packet(localbt->caph, "LBTDATAREPORT", buf, len);
+    r = cf_send_packet(localbt->caph, "LBTDATAREPORT", buf, len);
+
+    for (i = 0; i < localbt->pending_len; i++) {
+        if (localbt->pending_devs[i].name != NULL)
+            free(localbt->pending_devs[i].name);
+    }
+
+    localbt->pending_len = 0;
+
+    return r;
+}
+
+/* Queue a found device into the current batch, flushing if full */
+int cf_send_btdevice(local_bluetooth_t *localbt, struct mgmt_ev_device_found *dev) {
+    pending_bt_device_t *pend;
+    uint16_t eirlen;
+
+    if (localbt->pending_len >= BT_BATCH_MAX) {
+        if (cf_flush_btdevices(localbt) < 0)
+            return -1;
+    }
+
+    pend = &(localbt->pending_devs[localbt->pending_len]);
+
+    gettimeofday(&(pend->tv), NULL);
+
+    /* Convert the address */
+    bdaddr_to_string(dev->addr.bdaddr.b, pend->address);
+
+    /* Extract the name from EIR */
+    eirlen = le16toh(dev->eir_len);
+    pend->name = eir_get_name(dev->eir, eirlen);
+
+    pend->type = dev->addr.type;
+
+    localbt->pending_len++;
+
+    return 0;
 }
 
 void bdaddr_to_string(const uint8_t *bdaddr, char *str) {
@@ -862,6 +917,10 @@ void capture_thread(kis_capture_handler_t *caph) {
                 handle_mgmt_response(localbt);
             }
         }
+
+        /* Flush anything found this pass as one coalesced report */
+        if (localbt->pending_len > 0)
+            cf_flush_btdevices(localbt);
     }
 }
 
@@ -873,6 +932,7 @@ int main(int argc, char *argv[]) {
         .mgmt_fd = 0,
         .read_rbuf = NULL,
         .scan_type = SCAN_TYPE_DUAL,
+        .pending_len = 0,
         .caph = NULL,
     };
 
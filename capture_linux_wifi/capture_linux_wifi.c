@@ -64,6 +64,13 @@
 
 #include <stdbool.h>
 
+#include <sys/mman.h>
+#include <poll.h>
+
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/net_tstamp.h>
+
 #include "../config.h"
 
 #ifdef HAVE_LIBNM
@@ -93,6 +100,17 @@ typedef struct {
     int datalink_type;
     int override_dlt;
 
+    /* AF_PACKET TPACKET_V3 mmaped rx ring; when we can set one up we use it
+     * instead of the blocking pcap loop so the kernel block-delivers frames
+     * into shared memory and we don't pay a syscall per packet.  pcap is
+     * still used during open to derive the DLT. */
+    int use_mmap_ring;
+    int ring_fd;
+    uint8_t *ring_buf;
+    size_t ring_buf_sz;
+    unsigned int ring_block_sz;
+    unsigned int ring_block_cnt;
+
     /* Do we use mac80211 controls or basic ioctls?  We have to split this for
      * broken interfaces */
     int use_mac80211_vif;
@@ -169,38 +187,8 @@ typedef struct {
     unsigned int center_freq2;
 } local_channel_t;
 
-unsigned int wifi_chan_to_freq(unsigned int in_chan) {
-    /* 802.11 channels to frequency; if it looks like a frequency, return as
-     * pure frequency; derived from iwconfig */
-
-    if (in_chan > 250)
-        return in_chan;
-
-    if (in_chan == 14)
-        return 2484;
-    else if (in_chan < 14)
-        return 2407 + in_chan * 5;
-    else if (in_chan >= 182 && in_chan <= 196)
-        return 4000 + in_chan * 5;
-    else
-        return 5000 + in_chan * 5;
-
-    return in_chan;
-}
-
-unsigned int wifi_freq_to_chan(unsigned int in_freq) {
-    if (in_freq < 250)
-        return in_freq;
-
-    /* revamped from iw */
-    if (in_freq == 2484)
-        return 14;
-
-    if (in_freq < 2484)
-        return (in_freq - 2407) / 5;
-
-    return in_freq / 5 - 1000;
-}
+/* wifi_chan_to_freq / wifi_freq_to_chan / channel record lookups come from
+ * wifi_ht_channels.h */
 
 /* Find an interface based on a mac address (or mac address prefix in the case
  * of monitor mode interfaces); if we have to make a disassociated monitor interface
@@ -321,7 +309,7 @@ void *chantranslate_callback(kis_capture_handler_t *caph, char *chanstr) {
     char parsetype[16];
     char mod;
     int r;
-    unsigned int ci;
+    const wifi_channel *htchan;
     char errstr[STATUS_MAX];
 
     /* Match HT40+ and HT40- */
@@ -338,39 +326,28 @@ void *chantranslate_callback(kis_capture_handler_t *caph, char *chanstr) {
             (ret_localchan)->chan_width = NL80211_CHAN_WIDTH_40;
             (ret_localchan)->center_freq1 = (ret_localchan)->control_freq - 10;
 
-            /* Search for the ht channel record */
-            for (ci = 0; ci < MAX_WIFI_HT_CHANNEL; ci++) {
-                if (wifi_ht_channels[ci].chan == parsechan || 
-                        wifi_ht_channels[ci].freq == parsechan) {
+            /* Check the ht channel record */
+            htchan = wifi_get_ht_channel_any(parsechan);
 
-                    if ((wifi_ht_channels[ci].flags & WIFI_HT_HT40MINUS) == 0) {
-                        snprintf(errstr, STATUS_MAX, "requested channel %u as a HT40- "
-                                "channel; this does not appear to be a valid channel "
-                                "for 40MHz operation.", parsechan);
-                        cf_send_message(caph, errstr, MSGFLAG_INFO);
-                    }
-
-                }
+            if (htchan != NULL && (htchan->flags & WIFI_HT_HT40MINUS) == 0) {
+                snprintf(errstr, STATUS_MAX, "requested channel %u as a HT40- "
+                        "channel; this does not appear to be a valid channel "
+                        "for 40MHz operation.", parsechan);
+                cf_send_message(caph, errstr, MSGFLAG_INFO);
             }
         } else if (mod == '+') {
             (ret_localchan)->chan_type = NL80211_CHAN_HT40PLUS;
             (ret_localchan)->chan_width = NL80211_CHAN_WIDTH_40;
             (ret_localchan)->center_freq1 = (ret_localchan)->control_freq + 10;
 
-            /* Search for the ht channel record */
-            for (ci = 0; ci < sizeof(wifi_ht_channels) / 
-                    sizeof (wifi_channel); ci++) {
-                if (wifi_ht_channels[ci].chan == parsechan || 
-                        wifi_ht_channels[ci].freq == parsechan) {
+            /* Check the ht channel record */
+            htchan = wifi_get_ht_channel_any(parsechan);
 
-                    if ((wifi_ht_channels[ci].flags & WIFI_HT_HT40PLUS) == 0) {
-                        snprintf(errstr, STATUS_MAX, "requested channel %u as a HT40+ "
-                                "channel; this does not appear to be a valid channel "
-                                "for 40MHz operation.", parsechan);
-                        cf_send_message(caph, errstr, MSGFLAG_INFO);
-                    }
-
-                }
+            if (htchan != NULL && (htchan->flags & WIFI_HT_HT40PLUS) == 0) {
+                snprintf(errstr, STATUS_MAX, "requested channel %u as a HT40+ "
+                        "channel; this does not appear to be a valid channel "
+                        "for 40MHz operation.", parsechan);
+                cf_send_message(caph, errstr, MSGFLAG_INFO);
             }
         } else {
             /* otherwise return it as a basic channel; we don't know what to do */
@@ -416,36 +393,22 @@ void *chantranslate_callback(kis_capture_handler_t *caph, char *chanstr) {
                 (ret_localchan)->center_freq1 = parse_center1;
                 (ret_localchan)->unusual_center1 = 1;
             } else {
-                /* Search for the vht channel record to find the 80mhz center freq */
-                for (ci = 0; ci < sizeof(wifi_ht_channels) / 
-                        sizeof (wifi_channel); ci++) {
-                    if (wifi_ht_channels[ci].chan == parsechan || 
-                            wifi_ht_channels[ci].freq == parsechan) {
-
-                        if ((wifi_ht_channels[ci].flags & WIFI_HT_HT80) == 0) {
-                            snprintf(errstr, STATUS_MAX, "requested channel %u as a "
-                                    "VHT80 channel; this does not appear to be a valid "
-                                    "channel for 80MHz operation, skipping channel", 
-                                    parsechan);
-                            cf_send_message(caph, errstr, MSGFLAG_ERROR);
-                            free(ret_localchan);
-                            return NULL;
-                        }
-
-                        (ret_localchan)->control_freq = wifi_ht_channels[ci].freq;
-                        (ret_localchan)->center_freq1 = wifi_ht_channels[ci].freq80;
-                        return ret_localchan;
-                    }
+                /* Look up the vht channel record to find the 80mhz center freq */
+                htchan = wifi_get_ht_channel_any(parsechan);
+
+                if (htchan == NULL || (htchan->flags & WIFI_HT_HT80) == 0) {
+                    snprintf(errstr, STATUS_MAX, "requested channel %u as a "
+                            "VHT80 channel; this does not appear to be a valid "
+                            "channel for 80MHz operation, skipping channel",
+                            parsechan);
+                    cf_send_message(caph, errstr, MSGFLAG_ERROR);
+                    free(ret_localchan);
+                    return NULL;
                 }
 
-                /* Fall through to error state if we found no valid vht80 channel */
-                snprintf(errstr, STATUS_MAX, "requested channel %u as a "
-                        "VHT80 channel; this does not appear to be a valid "
-                        "channel for 80MHz operation, skipping channel", 
-                        parsechan);
-                cf_send_message(caph, errstr, MSGFLAG_ERROR);
-                free(ret_localchan);
-                return NULL;
+                (ret_localchan)->control_freq = htchan->freq;
+                (ret_localchan)->center_freq1 = htchan->freq80;
+                return ret_localchan;
             }
         } else if (strcasecmp(parsetype, "vht160") == 0) {
             (ret_localchan)->chan_width = NL80211_CHAN_WIDTH_160;
@@ -455,36 +418,22 @@ void *chantranslate_callback(kis_capture_handler_t *caph, char *chanstr) {
                 (ret_localchan)->center_freq1 = parse_center1;
                 (ret_localchan)->unusual_center1 = 1;
             } else {
-                /* Search for the vht channel record to find the 160mhz center freq */
-                for (ci = 0; ci < sizeof(wifi_ht_channels) / 
-                        sizeof (wifi_channel); ci++) {
-                    if (wifi_ht_channels[ci].chan == parsechan || 
-                            wifi_ht_channels[ci].freq == parsechan) {
-
-                        if ((wifi_ht_channels[ci].flags & WIFI_HT_HT160) == 0) {
-                            snprintf(errstr, STATUS_MAX, "requested channel %u as a "
-                                    "VHT160 channel; this does not appear to be a "
-                                    "valid channel for 160MHz operation, skipping "
-                                    "channel", parsechan);
-                            cf_send_message(caph, errstr, MSGFLAG_ERROR);
-                            free(ret_localchan);
-                            return NULL;
-                        }
-
-                        (ret_localchan)->control_freq = wifi_ht_channels[ci].freq;
-                        (ret_localchan)->center_freq1 = wifi_ht_channels[ci].freq160;
-                        return ret_localchan;
-                    }
+                /* Look up the vht channel record to find the 160mhz center freq */
+                htchan = wifi_get_ht_channel_any(parsechan);
+
+                if (htchan == NULL || (htchan->flags & WIFI_HT_HT160) == 0) {
+                    snprintf(errstr, STATUS_MAX, "requested channel %u as a "
+                            "VHT160 channel; this does not appear to be a "
+                            "valid channel for 160MHz operation, skipping "
+                            "channel", parsechan);
+                    cf_send_message(caph, errstr, MSGFLAG_ERROR);
+                    free(ret_localchan);
+                    return NULL;
                 }
 
-                /* Fall through to an error if we never found a vht160 for this */
-                snprintf(errstr, STATUS_MAX, "requested channel %u as a "
-                        "VHT160 channel; this does not appear to be a "
-                        "valid channel for 160MHz operation, skipping "
-                        "channel", parsechan);
-                cf_send_message(caph, errstr, MSGFLAG_ERROR);
-                free(ret_localchan);
-                return NULL;
+                (ret_localchan)->control_freq = htchan->freq;
+                (ret_localchan)->center_freq1 = htchan->freq160;
+                return ret_localchan;
             }
         } else {
             /* otherwise return it as a basic channel; we don't know what to do */
@@ -799,6 +748,193 @@ int probe_callback(kis_capture_handler_t *caph, uint32_t seqno, char *definition
     return 1;
 }
 
+#ifdef TPACKET3_HDRLEN
+/* Tear down the PACKET_MMAP ring, if any; safe to call with a partially
+ * constructed ring */
+static void close_mmap_ring(local_wifi_t *local_wifi) {
+    if (local_wifi->ring_buf != NULL) {
+        munmap(local_wifi->ring_buf, local_wifi->ring_buf_sz);
+        local_wifi->ring_buf = NULL;
+    }
+
+    if (local_wifi->ring_fd >= 0) {
+        close(local_wifi->ring_fd);
+        local_wifi->ring_fd = -1;
+    }
+
+    local_wifi->use_mmap_ring = 0;
+}
+
+/* Set up an AF_PACKET TPACKET_V3 mmaped rx ring on the capture interface.
+ * The kernel batches frames into blocks which the capture thread scans, so
+ * we don't pay a recv syscall per packet like we do through the traditional
+ * pcap loop.
+ *
+ * Returns -1 and populates errstr if the ring can't be created (old kernel,
+ * etc); the caller should fall back to the pcap path. */
+static int open_mmap_ring(kis_capture_handler_t *caph, char *errstr) {
+    local_wifi_t *local_wifi = (local_wifi_t *) caph->userdata;
+
+    struct tpacket_req3 ring_req;
+    struct sockaddr_ll bind_ll;
+    int pversion = TPACKET_V3;
+    unsigned int ifindex;
+
+    if ((ifindex = if_nametoindex(local_wifi->cap_interface)) == 0) {
+        snprintf(errstr, STATUS_MAX, "could not find interface index: %s",
+                strerror(errno));
+        return -1;
+    }
+
+    if ((local_wifi->ring_fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL))) < 0) {
+        snprintf(errstr, STATUS_MAX, "could not open AF_PACKET socket: %s",
+                strerror(errno));
+        return -1;
+    }
+
+    if (setsockopt(local_wifi->ring_fd, SOL_PACKET, PACKET_VERSION,
+                &pversion, sizeof(pversion)) < 0) {
+        snprintf(errstr, STATUS_MAX, "kernel does not support TPACKET_V3: %s",
+                strerror(errno));
+        return -1;
+    }
+
+#if defined(PACKET_TIMESTAMP) && defined(SOF_TIMESTAMPING_RAW_HARDWARE)
+    {
+        /* Ask for NIC hardware timestamps in the ring; the kernel falls
+         * back to a software stamp per packet when the driver can't
+         * provide one, so this is best effort and failure is harmless */
+        int tstamp_req = SOF_TIMESTAMPING_RAW_HARDWARE;
+
+        setsockopt(local_wifi->ring_fd, SOL_PACKET, PACKET_TIMESTAMP,
+                &tstamp_req, sizeof(tstamp_req));
+    }
+#endif
+
+    /* 64 128KB blocks gives us an 8MB ring, which rides out channel-hop
+     * bursts; a 10ms block retire timeout keeps latency sane on quiet
+     * channels where blocks would otherwise take a long time to fill */
+    local_wifi->ring_block_sz = 1024 * 128;
+    local_wifi->ring_block_cnt = 64;
+
+    memset(&ring_req, 0, sizeof(ring_req));
+    ring_req.tp_block_size = local_wifi->ring_block_sz;
+    ring_req.tp_block_nr = local_wifi->ring_block_cnt;
+    ring_req.tp_frame_size = MAX_PACKET_LEN;
+    ring_req.tp_frame_nr = (ring_req.tp_block_size * ring_req.tp_block_nr) /
+        ring_req.tp_frame_size;
+    ring_req.tp_retire_blk_tov = 10;
+
+    if (setsockopt(local_wifi->ring_fd, SOL_PACKET, PACKET_RX_RING,
+                &ring_req, sizeof(ring_req)) < 0) {
+        snprintf(errstr, STATUS_MAX, "could not create rx ring: %s",
+                strerror(errno));
+        return -1;
+    }
+
+    local_wifi->ring_buf_sz =
+        (size_t) ring_req.tp_block_size * ring_req.tp_block_nr;
+    local_wifi->ring_buf = (uint8_t *) mmap(NULL, local_wifi->ring_buf_sz,
+            PROT_READ | PROT_WRITE, MAP_SHARED, local_wifi->ring_fd, 0);
+
+    if (local_wifi->ring_buf == MAP_FAILED) {
+        local_wifi->ring_buf = NULL;
+        snprintf(errstr, STATUS_MAX, "could not mmap rx ring: %s",
+                strerror(errno));
+        return -1;
+    }
+
+    memset(&bind_ll, 0, sizeof(bind_ll));
+    bind_ll.sll_family = AF_PACKET;
+    bind_ll.sll_protocol = htons(ETH_P_ALL);
+    bind_ll.sll_ifindex = ifindex;
+
+    if (bind(local_wifi->ring_fd, (struct sockaddr *) &bind_ll,
+                sizeof(bind_ll)) < 0) {
+        snprintf(errstr, STATUS_MAX, "could not bind rx ring to interface: %s",
+                strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Scan completed ring blocks and forward the frames in them; mirrors the
+ * send/backpressure logic in pcap_dispatch_cb.  Returns when the socket
+ * fails or the handler is spun down, with errstr set on socket failure. */
+static void mmap_ring_loop(kis_capture_handler_t *caph, char *errstr) {
+    local_wifi_t *local_wifi = (local_wifi_t *) caph->userdata;
+
+    struct pollfd pfd;
+    struct tpacket_block_desc *desc;
+    struct tpacket3_hdr *pkt;
+    struct timeval tv;
+    unsigned int block = 0;
+    unsigned int p;
+    int ret;
+
+    while (!caph->spindown) {
+        desc = (struct tpacket_block_desc *)
+            (local_wifi->ring_buf + (size_t) block * local_wifi->ring_block_sz);
+
+        /* Wait for the kernel to hand us the next block */
+        if (!(desc->hdr.bh1.block_status & TP_STATUS_USER)) {
+            memset(&pfd, 0, sizeof(pfd));
+            pfd.fd = local_wifi->ring_fd;
+            pfd.events = POLLIN | POLLERR;
+
+            if (poll(&pfd, 1, 500) < 0) {
+                if (errno == EINTR)
+                    continue;
+
+                snprintf(errstr, STATUS_MAX, "%s", strerror(errno));
+                return;
+            }
+
+            continue;
+        }
+
+        __sync_synchronize();
+
+        pkt = (struct tpacket3_hdr *)
+            ((uint8_t *) desc + desc->hdr.bh1.offset_to_first_pkt);
+
+        for (p = 0; p < desc->hdr.bh1.num_pkts; p++) {
+            tv.tv_sec = pkt->tp_sec;
+            tv.tv_usec = pkt->tp_nsec / 1000;
+
+            /* Same retry pattern as pcap_dispatch_cb; if the write buffer is
+             * full, sleep until the main select() loop flushes it */
+            while (1) {
+                if ((ret = cf_send_data(caph,
+                                NULL, NULL, NULL,
+                                tv,
+                                local_wifi->datalink_type,
+                                pkt->tp_snaplen,
+                                (uint8_t *) pkt + pkt->tp_mac)) < 0) {
+                    cf_send_error(caph, 0, "unable to send DATA frame");
+                    cf_handler_spindown(caph);
+                    return;
+                } else if (ret == 0) {
+                    cf_handler_wait_ringbuffer(caph);
+                    continue;
+                } else {
+                    break;
+                }
+            }
+
+            pkt = (struct tpacket3_hdr *) ((uint8_t *) pkt + pkt->tp_next_offset);
+        }
+
+        /* Hand the block back to the kernel */
+        __sync_synchronize();
+        desc->hdr.bh1.block_status = TP_STATUS_KERNEL;
+
+        block = (block + 1) % local_wifi->ring_block_cnt;
+    }
+}
+#endif
+
 int open_callback(kis_capture_handler_t *caph, uint32_t seqno, char *definition,
         char *msg, uint32_t *dlt, char **uuid, KismetExternal__Command *frame,
         cf_params_interface_t **ret_interface,
@@ -880,6 +1016,10 @@ int open_callback(kis_capture_handler_t *caph, uint32_t seqno, char *definition,
         local_wifi->pd = NULL;
     }
 
+#ifdef TPACKET3_HDRLEN
+    close_mmap_ring(local_wifi);
+#endif
+
     /* Start processing the open */
 
     if ((placeholder_len = cf_parse_interface(&placeholder, definition)) <= 0) {
@@ -1446,6 +1586,37 @@ int open_callback(kis_capture_handler_t *caph, uint32_t seqno, char *definition,
 
     (*ret_interface)->capif = strdup(local_wifi->cap_interface);
 
+#ifdef TPACKET3_HDRLEN
+    /* Unless disabled in the source definition, try to switch to a
+     * PACKET_MMAP / TPACKET_V3 ring for the actual capture; we've already
+     * pulled the DLT off the pcap handle.  If the kernel doesn't support it
+     * we just stay on the pcap loop. */
+    local_wifi->use_mmap_ring = 1;
+
+    if ((placeholder_len =
+                cf_find_flag(&placeholder, "mmap_ring", definition)) > 0) {
+        if (strncasecmp(placeholder, "false", placeholder_len) == 0) {
+            local_wifi->use_mmap_ring = 0;
+        }
+    }
+
+    if (local_wifi->use_mmap_ring) {
+        if (open_mmap_ring(caph, errstr) < 0) {
+            close_mmap_ring(local_wifi);
+
+            snprintf(errstr2, STATUS_MAX, "Could not enable PACKET_MMAP ring "
+                    "capture on interface '%s' (%s), falling back to standard "
+                    "pcap capture.", local_wifi->cap_interface, errstr);
+            cf_send_message(caph, errstr2, MSGFLAG_INFO);
+        } else {
+            /* The ring delivers our frames now; close the pcap handle so the
+             * kernel doesn't duplicate every packet into its socket, too */
+            pcap_close(local_wifi->pd);
+            local_wifi->pd = NULL;
+        }
+    }
+#endif
+
     if (local_wifi->use_mac80211_channels) {
         if (mac80211_connect(local_wifi->cap_interface, &(local_wifi->mac80211_socket),
                     &(local_wifi->mac80211_id), &(local_wifi->mac80211_ifidx),
@@ -1606,18 +1777,36 @@ void capture_thread(kis_capture_handler_t *caph) {
     char iferrstr[STATUS_MAX];
     int ifflags = 0, ifret;
 
-    /* Simple capture thread: since we don't care about blocking and 
+    /* Simple capture thread: since we don't care about blocking and
      * channel control is managed by the channel hopping thread, all we have
-     * to do is enter a blocking pcap loop */
+     * to do is enter a blocking pcap loop (or scan the PACKET_MMAP ring, if
+     * we were able to set one up at open time) */
+
+#ifdef TPACKET3_HDRLEN
+    if (local_wifi->use_mmap_ring) {
+        char ringerrstr[STATUS_MAX];
+        ringerrstr[0] = '\0';
+
+        mmap_ring_loop(caph, ringerrstr);
+
+        snprintf(errstr, PCAP_ERRBUF_SIZE, "Interface '%s' closed: %s",
+                local_wifi->cap_interface,
+                strlen(ringerrstr) == 0 ? "interface closed" : ringerrstr);
+    } else {
+#endif
 
     pcap_loop(local_wifi->pd, -1, pcap_dispatch_cb, (u_char *) caph);
 
     pcap_errstr = pcap_geterr(local_wifi->pd);
 
-    snprintf(errstr, PCAP_ERRBUF_SIZE, "Interface '%s' closed: %s", 
-            local_wifi->cap_interface, 
+    snprintf(errstr, PCAP_ERRBUF_SIZE, "Interface '%s' closed: %s",
+            local_wifi->cap_interface,
             strlen(pcap_errstr) == 0 ? "interface closed" : pcap_errstr );
 
+#ifdef TPACKET3_HDRLEN
+    }
+#endif
+
     cf_send_error(caph, 0, errstr);
 
     ifret = ifconfig_get_flags(local_wifi->cap_interface, iferrstr, &ifflags);
@@ -1640,6 +1829,12 @@ int main(int argc, char *argv[]) {
         .cap_interface = NULL,
         .datalink_type = -1,
         .override_dlt = -1,
+        .use_mmap_ring = 0,
+        .ring_fd = -1,
+        .ring_buf = NULL,
+        .ring_buf_sz = 0,
+        .ring_block_sz = 0,
+        .ring_block_cnt = 0,
         .use_mac80211_vif = 1,
         .use_mac80211_channels = 1,
         .mac80211_socket = NULL,
@@ -1708,6 +1903,15 @@ int main(int argc, char *argv[]) {
     /* Support remote capture by launching the remote loop */
     cf_handler_remote_capture(caph);
 
+    /* Offer the server a shared-memory data ring; we keep using the pipe
+     * if it can't be made or the server declines.  This has to happen
+     * before we jail the filesystem since the ring lives on a tmpfs. */
+    cf_handler_shm_ring(caph, 1024 * 512);
+
+    /* Batch data reports so busy channels don't pay the framing overhead
+     * per packet */
+    cf_handler_set_data_batching(caph, 1024 * 32, 2000);
+
     /* Jail our ns */
     cf_jail_filesystem(caph);
 
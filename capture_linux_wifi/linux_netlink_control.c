@@ -427,7 +427,7 @@ static int nl80211_freqlist_cb(struct nl_msg *msg, void *arg) {
     struct nl80211_channel_block *chanb = (struct nl80211_channel_block *) arg;
     char channel_str[32];
     int band_ht40, band_ht80, band_ht160;
-    unsigned int hti;
+    const wifi_channel *htchan;
 
     struct nl80211_channel_list *chan_list_new;
 
@@ -500,43 +500,18 @@ static int nl80211_freqlist_cb(struct nl_msg *msg, void *arg) {
                     chanb->chan_list_last->next = chan_list_new;
                     chanb->chan_list_last = chan_list_new;
 
-                    /* Look us up in the wifi_ht_channels list and add channels if we
-                     * need to add HT capabilities.  We could convert this to a channel
-                     * but it's better to do a frequency lookup */
-                    for (hti = 0; hti < MAX_WIFI_HT_CHANNEL; hti++) {
-                        if (wifi_ht_channels[hti].freq == freq) {
-                            if (band_ht40 && (chanb->extended_flags & MAC80211_GET_HT)) {
-                                if (wifi_ht_channels[hti].flags & WIFI_HT_HT40MINUS) {
-                                    chan_list_new = (struct nl80211_channel_list *) malloc(sizeof(struct nl80211_channel_list));
-                                    snprintf(channel_str, 32, 
-                                            "%uHT40-", mac80211_freq_to_chan(freq));
-                                    chan_list_new->channel = strdup(channel_str);
-
-                                    chan_list_new->next = NULL;
-                                    chanb->nfreqs++;
-                                    chanb->chan_list_last->next = chan_list_new;
-                                    chanb->chan_list_last = chan_list_new;
-                                }
-
-                                if (wifi_ht_channels[hti].flags & WIFI_HT_HT40PLUS) {
-                                    chan_list_new = (struct nl80211_channel_list *) malloc(sizeof(struct nl80211_channel_list));
-
-                                    snprintf(channel_str, 32, 
-                                            "%uHT40+", mac80211_freq_to_chan(freq));
-                                    chan_list_new->channel = strdup(channel_str);
-
-                                    chan_list_new->next = NULL;
-                                    chanb->nfreqs++;
-                                    chanb->chan_list_last->next = chan_list_new;
-                                    chanb->chan_list_last = chan_list_new;
-                                }
-                            }
+                    /* Look us up in the wifi_ht_channels table and add channels
+                     * if we need to add HT capabilities; the table is indexed
+                     * by channel so the frequency buckets straight to a record
+                     * instead of scanning the list */
+                    htchan = wifi_get_ht_channel_freq(freq);
 
-                            if (band_ht80 && wifi_ht_channels[hti].flags & WIFI_HT_HT80 &&
-                                    (chanb->extended_flags & MAC80211_GET_VHT)) {
+                    if (htchan != NULL) {
+                        if (band_ht40 && (chanb->extended_flags & MAC80211_GET_HT)) {
+                            if (htchan->flags & WIFI_HT_HT40MINUS) {
                                 chan_list_new = (struct nl80211_channel_list *) malloc(sizeof(struct nl80211_channel_list));
-                                snprintf(channel_str, 32, 
-                                        "%uVHT80", mac80211_freq_to_chan(freq));
+                                snprintf(channel_str, 32,
+                                        "%uHT40-", mac80211_freq_to_chan(freq));
                                 chan_list_new->channel = strdup(channel_str);
 
                                 chan_list_new->next = NULL;
@@ -545,11 +520,11 @@ static int nl80211_freqlist_cb(struct nl_msg *msg, void *arg) {
                                 chanb->chan_list_last = chan_list_new;
                             }
 
-                            if (band_ht160 && wifi_ht_channels[hti].flags & WIFI_HT_HT160 &&
-                                    (chanb->extended_flags & MAC80211_GET_VHT)) {
+                            if (htchan->flags & WIFI_HT_HT40PLUS) {
                                 chan_list_new = (struct nl80211_channel_list *) malloc(sizeof(struct nl80211_channel_list));
-                                snprintf(channel_str, 32, 
-                                        "%uVHT160", mac80211_freq_to_chan(freq));
+
+                                snprintf(channel_str, 32,
+                                        "%uHT40+", mac80211_freq_to_chan(freq));
                                 chan_list_new->channel = strdup(channel_str);
 
                                 chan_list_new->next = NULL;
@@ -557,8 +532,32 @@ static int nl80211_freqlist_cb(struct nl_msg *msg, void *arg) {
                                 chanb->chan_list_last->next = chan_list_new;
                                 chanb->chan_list_last = chan_list_new;
                             }
+                        }
+
+                        if (band_ht80 && htchan->flags & WIFI_HT_HT80 &&
+                                (chanb->extended_flags & MAC80211_GET_VHT)) {
+                            chan_list_new = (struct nl80211_channel_list *) malloc(sizeof(struct nl80211_channel_list));
+                            snprintf(channel_str, 32,
+                                    "%uVHT80", mac80211_freq_to_chan(freq));
+                            chan_list_new->channel = strdup(channel_str);
+
+                            chan_list_new->next = NULL;
+                            chanb->nfreqs++;
+                            chanb->chan_list_last->next = chan_list_new;
+                            chanb->chan_list_last = chan_list_new;
+                        }
 
-                            break;
+                        if (band_ht160 && htchan->flags & WIFI_HT_HT160 &&
+                                (chanb->extended_flags & MAC80211_GET_VHT)) {
+                            chan_list_new = (struct nl80211_channel_list *) malloc(sizeof(struct nl80211_channel_list));
+                            snprintf(channel_str, 32,
+                                    "%uVHT160", mac80211_freq_to_chan(freq));
+                            chan_list_new->channel = strdup(channel_str);
+
+                            chan_list_new->next = NULL;
+                            chanb->nfreqs++;
+                            chanb->chan_list_last->next = chan_list_new;
+                            chanb->chan_list_last = chan_list_new;
                         }
                     }
                 }
@@ -0,0 +1,316 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <cmath>
+#include <string>
+
+#include "globalregistry.h"
+#include "trackedelement.h"
+#include "macaddr.h"
+#include "entrytracker.h"
+#include "uuid.h"
+#include "devicetracker_component.h"
+#include "cbor_adapter.h"
+
+// Emit a CBOR item head - major type in the top 3 bits, the value (an
+// actual small integer, or the length of the string/array/map which
+// follows) in the shortest encoding which holds it
+static void CborHead(std::ostream &stream, uint8_t major, uint64_t value) {
+    uint8_t b[9];
+
+    major = major << 5;
+
+    if (value < 24) {
+        b[0] = major | (uint8_t) value;
+        stream.write((const char *) b, 1);
+    } else if (value <= 0xFF) {
+        b[0] = major | 24;
+        b[1] = (uint8_t) value;
+        stream.write((const char *) b, 2);
+    } else if (value <= 0xFFFF) {
+        b[0] = major | 25;
+        b[1] = (uint8_t) (value >> 8);
+        b[2] = (uint8_t) value;
+        stream.write((const char *) b, 3);
+    } else if (value <= 0xFFFFFFFF) {
+        b[0] = major | 26;
+        b[1] = (uint8_t) (value >> 24);
+        b[2] = (uint8_t) (value >> 16);
+        b[3] = (uint8_t) (value >> 8);
+        b[4] = (uint8_t) value;
+        stream.write((const char *) b, 5);
+    } else {
+        b[0] = major | 27;
+        b[1] = (uint8_t) (value >> 56);
+        b[2] = (uint8_t) (value >> 48);
+        b[3] = (uint8_t) (value >> 40);
+        b[4] = (uint8_t) (value >> 32);
+        b[5] = (uint8_t) (value >> 24);
+        b[6] = (uint8_t) (value >> 16);
+        b[7] = (uint8_t) (value >> 8);
+        b[8] = (uint8_t) value;
+        stream.write((const char *) b, 9);
+    }
+}
+
+// Signed values split into major type 0 (positive) or 1 (negative,
+// stored as -1 - n)
+static void CborInt(std::ostream &stream, int64_t value) {
+    if (value >= 0)
+        CborHead(stream, 0, (uint64_t) value);
+    else
+        CborHead(stream, 1, (uint64_t) (-1 - value));
+}
+
+static void CborString(std::ostream &stream, const std::string& value) {
+    CborHead(stream, 3, value.length());
+    stream.write(value.data(), value.length());
+}
+
+// Doubles always go out as 64-bit big-endian IEEE754 (major 7, ai 27);
+// NaN and Inf collapse to integer 0 to match the JSON serializer
+static void CborDouble(std::ostream &stream, double value) {
+    uint64_t ieee;
+    uint8_t b[9];
+
+    if (std::isnan(value) || std::isinf(value)) {
+        CborHead(stream, 0, 0);
+        return;
+    }
+
+    memcpy(&ieee, &value, sizeof(uint64_t));
+
+    b[0] = (7 << 5) | 27;
+    b[1] = (uint8_t) (ieee >> 56);
+    b[2] = (uint8_t) (ieee >> 48);
+    b[3] = (uint8_t) (ieee >> 40);
+    b[4] = (uint8_t) (ieee >> 32);
+    b[5] = (uint8_t) (ieee >> 24);
+    b[6] = (uint8_t) (ieee >> 16);
+    b[7] = (uint8_t) (ieee >> 8);
+    b[8] = (uint8_t) ieee;
+    stream.write((const char *) b, 9);
+}
+
+void CborAdapter::Pack(GlobalRegistry *globalreg, std::ostream &stream,
+    SharedTrackerElement e, TrackerElementSerializer::rename_map *name_map) {
+
+    // Match the json adapter's handling of missing elements
+    if (e == NULL) {
+        CborHead(stream, 0, 0);
+        return;
+    }
+
+    SerializerScope s(e, name_map);
+
+    TrackerElement::tracked_vector *tvec;
+    TrackerElement::vector_iterator vec_iter;
+
+    TrackerElement::tracked_map *tmap;
+    TrackerElement::map_iterator map_iter;
+
+    TrackerElement::tracked_int_map *tintmap;
+    TrackerElement::int_map_iterator int_map_iter;
+
+    TrackerElement::tracked_mac_map *tmacmap;
+    TrackerElement::mac_map_iterator mac_map_iter;
+
+    TrackerElement::tracked_string_map *tstringmap;
+    TrackerElement::string_map_iterator string_map_iter;
+
+    TrackerElement::tracked_double_map *tdoublemap;
+    TrackerElement::double_map_iterator double_map_iter;
+
+    TrackerElement::tracked_key_map *tkeymap;
+
+    mac_addr mac;
+    uuid euuid;
+
+    std::string tname;
+
+    std::shared_ptr<uint8_t> bytes;
+
+    size_t sz;
+
+    switch (e->get_type()) {
+        case TrackerString:
+            CborString(stream, GetTrackerValue<std::string>(e));
+            break;
+        case TrackerInt8:
+            CborInt(stream, GetTrackerValue<int8_t>(e));
+            break;
+        case TrackerUInt8:
+            CborHead(stream, 0, GetTrackerValue<uint8_t>(e));
+            break;
+        case TrackerInt16:
+            CborInt(stream, GetTrackerValue<int16_t>(e));
+            break;
+        case TrackerUInt16:
+            CborHead(stream, 0, GetTrackerValue<uint16_t>(e));
+            break;
+        case TrackerInt32:
+            CborInt(stream, GetTrackerValue<int32_t>(e));
+            break;
+        case TrackerUInt32:
+            CborHead(stream, 0, GetTrackerValue<uint32_t>(e));
+            break;
+        case TrackerInt64:
+            CborInt(stream, GetTrackerValue<int64_t>(e));
+            break;
+        case TrackerUInt64:
+            CborHead(stream, 0, GetTrackerValue<uint64_t>(e));
+            break;
+        case TrackerFloat:
+            CborDouble(stream, GetTrackerValue<float>(e));
+            break;
+        case TrackerDouble:
+            CborDouble(stream, GetTrackerValue<double>(e));
+            break;
+        case TrackerMac:
+            // Mac carried as its string form, mac only, as in json
+            mac = GetTrackerValue<mac_addr>(e);
+            CborString(stream, mac.Mac2String());
+            break;
+        case TrackerUuid:
+            euuid = GetTrackerValue<uuid>(e);
+            CborString(stream, euuid.UUID2String());
+            break;
+        case TrackerKey:
+            CborString(stream, GetTrackerValue<TrackedDeviceKey>(e).as_string());
+            break;
+        case TrackerVector:
+            tvec = e->get_vector();
+
+            CborHead(stream, 4, tvec->size());
+            for (vec_iter = tvec->begin(); vec_iter != tvec->end(); ++vec_iter) {
+                CborAdapter::Pack(globalreg, stream, *vec_iter, name_map);
+            }
+            break;
+        case TrackerMap:
+            tmap = e->get_map();
+
+            CborHead(stream, 5, tmap->size());
+
+            for (map_iter = tmap->begin(); map_iter != tmap->end(); ++map_iter) {
+                bool named = false;
+
+                if (name_map != NULL) {
+                    TrackerElementSerializer::rename_map::iterator nmi =
+                        name_map->find(map_iter->second);
+                    if (nmi != name_map->end() && nmi->second->rename.length() != 0) {
+                        tname = nmi->second->rename;
+                        named = true;
+                    }
+                }
+
+                if (!named) {
+                    if (map_iter->second == NULL) {
+                        tname = globalreg->entrytracker->GetFieldName(map_iter->first);
+                    } else {
+                        if ((tname = map_iter->second->get_local_name()) == "")
+                            tname =
+                                globalreg->entrytracker->GetFieldName(map_iter->first);
+                    }
+                }
+
+                CborString(stream, tname);
+
+                CborAdapter::Pack(globalreg, stream, map_iter->second, name_map);
+            }
+            break;
+        case TrackerIntMap:
+            tintmap = e->get_intmap();
+
+            CborHead(stream, 5, tintmap->size());
+
+            for (int_map_iter = tintmap->begin(); int_map_iter != tintmap->end();
+                    ++int_map_iter) {
+                // Integer dictionary keys stay native integers in cbor
+                CborInt(stream, int_map_iter->first);
+                CborAdapter::Pack(globalreg, stream, int_map_iter->second, name_map);
+            }
+            break;
+        case TrackerMacMap:
+            tmacmap = e->get_macmap();
+
+            CborHead(stream, 5, tmacmap->size());
+
+            for (mac_map_iter = tmacmap->begin();
+                    mac_map_iter != tmacmap->end(); ++mac_map_iter) {
+                // Mac keys are strings and we push only the mac not the mask
+                CborString(stream, mac_map_iter->first.Mac2String());
+                CborAdapter::Pack(globalreg, stream, mac_map_iter->second, name_map);
+            }
+            break;
+        case TrackerStringMap:
+            tstringmap = e->get_stringmap();
+
+            CborHead(stream, 5, tstringmap->size());
+
+            for (string_map_iter = tstringmap->begin();
+                    string_map_iter != tstringmap->end(); ++string_map_iter) {
+                CborString(stream, string_map_iter->first);
+                CborAdapter::Pack(globalreg, stream, string_map_iter->second, name_map);
+            }
+            break;
+        case TrackerDoubleMap:
+            tdoublemap = e->get_doublemap();
+
+            CborHead(stream, 5, tdoublemap->size());
+
+            for (double_map_iter = tdoublemap->begin();
+                    double_map_iter != tdoublemap->end(); ++double_map_iter) {
+                // Double keys stay native doubles in cbor
+                CborDouble(stream, double_map_iter->first);
+                CborAdapter::Pack(globalreg, stream, double_map_iter->second, name_map);
+            }
+            break;
+        case TrackerKeyMap:
+            tkeymap = e->get_keymap();
+
+            CborHead(stream, 5, tkeymap->size());
+
+            for (auto i = tkeymap->begin(); i != tkeymap->end(); ++i) {
+                // Keymap keys are handled as strings
+                CborString(stream, i->first.as_string());
+                CborAdapter::Pack(globalreg, stream, i->second, name_map);
+            }
+            break;
+        case TrackerByteArray:
+            // Byte arrays go out raw as a cbor byte string instead of the
+            // doubled-size hex encoding json needs
+            bytes = e->get_bytearray();
+            sz = e->get_bytearray_size();
+
+            CborHead(stream, 2, sz);
+            stream.write((const char *) bytes.get(), sz);
+
+            break;
+
+        default:
+            // Unknown types still need a placeholder item since the
+            // enclosing array/map count was already committed
+            stream.put((char) 0xF6);
+            break;
+    }
+}
@@ -0,0 +1,59 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __CBOR_ADAPTER_H__
+#define __CBOR_ADAPTER_H__
+
+#include "config.h"
+
+#include "globalregistry.h"
+#include "trackedelement.h"
+#include "devicetracker_component.h"
+
+// Binary serialization adapter emitting RFC 7049 CBOR.  Produces the same
+// object model as the JSON serializer - maps keyed by field name, macs and
+// uuids as their string forms - so a client can decode either format into
+// identical structures, but integers, doubles and byte arrays are packed
+// in their native widths instead of being rendered as text.  On large
+// exports (the full device list) this roughly quarters the payload and
+// skips all the number-to-string formatting work.
+//
+// CBOR was picked over msgpack because it can be emitted with no library
+// dependency; we only ever encode, never decode.
+//
+// Selected like every other serializer, by the type suffix on the endpoint
+// URL (devices/all_devices.cbor etc)
+namespace CborAdapter {
+
+void Pack(GlobalRegistry *globalreg, std::ostream &stream, SharedTrackerElement e,
+        TrackerElementSerializer::rename_map *name_map = NULL);
+
+class Serializer : public TrackerElementSerializer {
+public:
+    Serializer(GlobalRegistry *in_globalreg) :
+        TrackerElementSerializer(in_globalreg) { }
+
+    virtual void serialize(SharedTrackerElement in_elem, std::ostream &stream,
+            rename_map *name_map = NULL) {
+        Pack(globalreg, stream, in_elem, name_map);
+    }
+};
+
+}
+
+#endif
@@ -18,6 +18,51 @@
 
 #include "chainbuf.h"
 #include "util.h"
+#include "kis_mempool.h"
+
+kis_recursive_timed_mutex Chainbuf::pool_mutex;
+std::map<size_t, std::vector<uint8_t *> > Chainbuf::chunk_pool;
+
+uint8_t *Chainbuf::alloc_chunk(size_t in_sz) {
+    {
+        local_locker lock(&pool_mutex);
+
+        auto p = chunk_pool.find(in_sz);
+
+        if (p != chunk_pool.end() && p->second.size() > 0) {
+            uint8_t *chunk = p->second.back();
+            p->second.pop_back();
+            return chunk;
+        }
+    }
+
+    // Pool-dry chunks come from the preallocated region when it's
+    // enabled, keeping the buffer working set inside the hugepage
+    // reservation
+    uint8_t *chunk = (uint8_t *) kis_mem_pool::take(in_sz);
+    if (chunk != NULL)
+        return chunk;
+
+    return new uint8_t[in_sz];
+}
+
+void Chainbuf::recycle_chunk(uint8_t *in_chunk, size_t in_sz) {
+    {
+        local_locker lock(&pool_mutex);
+
+        std::vector<uint8_t *> &pool = chunk_pool[in_sz];
+
+        if (pool.size() < max_pool_chunks) {
+            pool.push_back(in_chunk);
+            return;
+        }
+    }
+
+    if (kis_mem_pool::give(in_chunk))
+        return;
+
+    delete[] in_chunk;
+}
 
 Chainbuf::Chainbuf(size_t in_chunk, size_t pre_allocate) {
     chunk_sz = in_chunk;
@@ -26,7 +71,7 @@ Chainbuf::Chainbuf(size_t in_chunk, size_t pre_allocate) {
     buff_vec = std::vector<uint8_t *>();
     buff_vec.reserve(pre_allocate);
 
-    buff_vec.push_back(new uint8_t[chunk_sz]);
+    buff_vec.push_back(alloc_chunk(chunk_sz));
 
     used_sz = 0;
     total_sz = 0;
@@ -55,8 +100,10 @@ Chainbuf::~Chainbuf() {
 void Chainbuf::clear() {
     local_locker lock(&write_mutex);
 
-    for (auto x : buff_vec) 
-        delete[](x);
+    for (auto x : buff_vec) {
+        if (x != NULL)
+            recycle_chunk(x, chunk_sz);
+    }
 
     buff_vec.clear();
 }
@@ -105,7 +152,7 @@ ssize_t Chainbuf::write(uint8_t *in_data, size_t in_sz) {
 
         // If we got here and we have more data, then we must need another chunk
         if (total_written < in_sz) {
-            uint8_t *newchunk = new uint8_t[chunk_sz];
+            uint8_t *newchunk = alloc_chunk(chunk_sz);
             buff_vec.push_back(newchunk);
             write_block++;
             write_buf = buff_vec[write_block];
@@ -278,9 +325,9 @@ size_t Chainbuf::consume(size_t in_sz) {
             // Data consuming block offt jumps
             block_offt++;
 
-            // Remove the old read block and set the slot to null
+            // Recycle the old read block and set the slot to null
             // fprintf(stderr, "debug - chainbuf read_block freeing %u\n", read_block);
-            delete[](buff_vec[read_block]);
+            recycle_chunk(buff_vec[read_block], chunk_sz);
             buff_vec[read_block] = NULL;
 
             // Move the global read pointer
@@ -308,6 +355,8 @@ ssize_t Chainbuf::reserve(unsigned char **data, size_t in_sz) {
         throw std::runtime_error("chainbuf already locked");
     }
 
+    write_reserved = true;
+
     // If we can fit inside the chunk we're in now...
     if (in_sz < chunk_sz - write_offt) {
         *data = write_buf + write_offt;
@@ -25,6 +25,7 @@
 #include <unistd.h>
 #include <pthread.h>
 
+#include <map>
 #include <vector>
 #include <mutex>
 
@@ -103,6 +104,19 @@ protected:
 
     size_t alloc_delta;
 
+    // Global pool of recycled chunks shared by all chainbufs; http
+    // streaming pushes thousands of identically-sized chunks through the
+    // allocator per large response, so consumed chunks go back on a
+    // freelist instead of to delete[].  Retention is bounded per chunk
+    // size; overflow chunks are freed normally.
+    static kis_recursive_timed_mutex pool_mutex;
+    static std::map<size_t, std::vector<uint8_t *> > chunk_pool;
+    static const size_t max_pool_chunks = 64;
+
+    // Fetch a chunk from the pool, allocating if the pool is dry
+    static uint8_t *alloc_chunk(size_t in_sz);
+    // Return a chunk to the pool, freeing it if the pool is full
+    static void recycle_chunk(uint8_t *in_chunk, size_t in_sz);
 };
 
 #endif
@@ -188,6 +188,10 @@ protected:
 
 
 int Channeltracker_V2::timetracker_event(int event_id __attribute__((unused))) {
+    // Fold the staged per-packet counts in first so the device worker and
+    // activity queries see a current view
+    flush_staged_counts();
+
     local_locker locker(&lock);
 
     channeltracker_v2_device_worker worker(globalreg, this);
@@ -207,6 +211,25 @@ int Channeltracker_V2::timetracker_event(int event_id __attribute__((unused))) {
     return 1;
 }
 
+double Channeltracker_V2::get_channel_activity(std::string in_chan) {
+    local_locker locker(&lock);
+
+    TrackerElement::string_map_iterator smi = channel_map->string_find(in_chan);
+
+    if (smi == channel_map->string_end())
+        return -1;
+
+    std::shared_ptr<Channeltracker_V2_Channel> channel =
+        std::static_pointer_cast<Channeltracker_V2_Channel>(smi->second);
+
+    // A channel we haven't seen a packet on in over a minute still has the
+    // old samples in the RRD; report it as idle instead
+    if (time(0) - channel->get_packets_rrd()->get_last_time() > 60)
+        return 0;
+
+    return (double) channel->get_packets_rrd()->combine_minute();
+}
+
 void Channeltracker_V2::update_device_counts(std::map<double, unsigned int> in_counts) {
     local_locker locker(&lock);
     time_t ts = time(0);
@@ -230,61 +253,58 @@ void Channeltracker_V2::update_device_counts(std::map<double, unsigned int> in_c
 int Channeltracker_V2::PacketChainHandler(CHAINCALL_PARMS) {
     Channeltracker_V2 *cv2 = (Channeltracker_V2 *) auxdata;
 
-    local_locker locker(&(cv2->lock));
-
     kis_layer1_packinfo *l1info =
         (kis_layer1_packinfo *) in_pack->fetch(cv2->pack_comp_l1data);
-	kis_common_info *common = 
+	kis_common_info *common =
 		(kis_common_info *) in_pack->fetch(cv2->pack_comp_common);
 
     // Nothing to do with no l1info
     if (l1info == NULL)
         return 1;
 
-    std::shared_ptr<Channeltracker_V2_Channel> freq_channel;
-    std::shared_ptr<Channeltracker_V2_Channel> chan_channel;
+    // Stage the counts under the narrow staging lock; the tracked channel
+    // records are only updated once a second by the timer
+    local_locker locker(&(cv2->stage_mutex));
 
-    // Find or make a frequency record if we know our frequency
+    std::shared_ptr<Channeltracker_V2_Stage> freq_stage;
+    std::shared_ptr<Channeltracker_V2_Stage> chan_stage;
+
+    // Find or make a frequency staging record if we know our frequency
     if (l1info->freq_khz != 0) {
-        TrackerElement::double_map_iterator imi =
-            cv2->frequency_map->double_find(l1info->freq_khz);
+        auto fsi = cv2->frequency_stage_map.find(l1info->freq_khz);
 
-        if (imi == cv2->frequency_map->double_end()) {
-            freq_channel.reset(new Channeltracker_V2_Channel(cv2->globalreg, cv2->channel_entry_id));
-            freq_channel->set_frequency(l1info->freq_khz);
-            cv2->frequency_map->add_doublemap(l1info->freq_khz, freq_channel);
+        if (fsi == cv2->frequency_stage_map.end()) {
+            freq_stage.reset(new Channeltracker_V2_Stage());
+            cv2->frequency_stage_map[l1info->freq_khz] = freq_stage;
         } else {
-            freq_channel = std::static_pointer_cast<Channeltracker_V2_Channel>(imi->second);
+            freq_stage = fsi->second;
         }
     }
 
     if (common != NULL) {
         if (!(common->channel == "0") && !(common->channel == "")) {
-            TrackerElement::string_map_iterator smi =
-                cv2->channel_map->string_find(common->channel);
+            auto csi = cv2->channel_stage_map.find(common->channel);
 
-            if (smi == cv2->channel_map->string_end()) {
-                chan_channel.reset(new Channeltracker_V2_Channel(cv2->globalreg, cv2->channel_entry_id));
-                chan_channel->set_channel(common->channel);
-                cv2->channel_map->add_stringmap(common->channel, chan_channel);
+            if (csi == cv2->channel_stage_map.end()) {
+                chan_stage.reset(new Channeltracker_V2_Stage());
+                cv2->channel_stage_map[common->channel] = chan_stage;
             } else {
-                chan_channel = std::static_pointer_cast<Channeltracker_V2_Channel>(smi->second);
+                chan_stage = csi->second;
             }
         }
     }
 
     // didn't find anything
-    if (freq_channel == NULL && chan_channel == NULL)
+    if (freq_stage == NULL && chan_stage == NULL)
         return 1;
 
-    time_t stime = time(0);
-
-    if (freq_channel) {
-        (*(freq_channel->get_signal_data())) += *(l1info);
-        freq_channel->get_packets_rrd()->add_sample(1, stime);
+    if (freq_stage) {
+        freq_stage->packets++;
+        freq_stage->stage_signal(l1info);
 
         if (common != NULL) {
-            freq_channel->get_data_rrd()->add_sample(common->datasize, stime);
+            freq_stage->data += common->datasize;
+            freq_stage->data_seen = true;
 
             /*
             freq_channel->seen_device_map[common->device] = true;
@@ -293,12 +313,13 @@ int Channeltracker_V2::PacketChainHandler(CHAINCALL_PARMS) {
 
     }
 
-    if (chan_channel) {
-        (*(chan_channel->get_signal_data())) += *(l1info);
-        chan_channel->get_packets_rrd()->add_sample(1, stime);
+    if (chan_stage) {
+        chan_stage->packets++;
+        chan_stage->stage_signal(l1info);
 
         if (common != NULL) {
-            chan_channel->get_data_rrd()->add_sample(common->datasize, stime);
+            chan_stage->data += common->datasize;
+            chan_stage->data_seen = true;
         }
 
         /*
@@ -321,3 +342,161 @@ int Channeltracker_V2::PacketChainHandler(CHAINCALL_PARMS) {
     return 1;
 }
 
+void Channeltracker_V2::flush_staged_counts() {
+    std::map<std::string, std::shared_ptr<Channeltracker_V2_Stage> > chan_stage;
+    std::map<double, std::shared_ptr<Channeltracker_V2_Stage> > freq_stage;
+
+    {
+        // Pull the staged maps out from under the packet handler; packets
+        // arriving during the fold start fresh staging records
+        local_locker slock(&stage_mutex);
+        chan_stage.swap(channel_stage_map);
+        freq_stage.swap(frequency_stage_map);
+    }
+
+    if (chan_stage.size() == 0 && freq_stage.size() == 0)
+        return;
+
+    local_locker locker(&lock);
+
+    time_t stime = Timetracker::GetCachedTime();
+
+    for (auto i : freq_stage) {
+        std::shared_ptr<Channeltracker_V2_Channel> freq_channel;
+
+        TrackerElement::double_map_iterator imi =
+            frequency_map->double_find(i.first);
+
+        if (imi == frequency_map->double_end()) {
+            freq_channel.reset(new Channeltracker_V2_Channel(globalreg, channel_entry_id));
+            freq_channel->set_frequency(i.first);
+            frequency_map->add_doublemap(i.first, freq_channel);
+        } else {
+            freq_channel = std::static_pointer_cast<Channeltracker_V2_Channel>(imi->second);
+        }
+
+        i.second->flush(freq_channel, stime);
+    }
+
+    for (auto i : chan_stage) {
+        std::shared_ptr<Channeltracker_V2_Channel> chan_channel;
+
+        TrackerElement::string_map_iterator smi =
+            channel_map->string_find(i.first);
+
+        if (smi == channel_map->string_end()) {
+            chan_channel.reset(new Channeltracker_V2_Channel(globalreg, channel_entry_id));
+            chan_channel->set_channel(i.first);
+            channel_map->add_stringmap(i.first, chan_channel);
+        } else {
+            chan_channel = std::static_pointer_cast<Channeltracker_V2_Channel>(smi->second);
+        }
+
+        i.second->flush(chan_channel, stime);
+    }
+}
+
+void Channeltracker_V2_Stage::stage_signal(kis_layer1_packinfo *l1info) {
+    if (l1info->signal_type == kis_l1_signal_type_dbm) {
+        dbm_seen = true;
+
+        if (l1info->signal_dbm != 0) {
+            last_signal_dbm = l1info->signal_dbm;
+
+            if (min_signal_dbm == 0 || min_signal_dbm > l1info->signal_dbm)
+                min_signal_dbm = l1info->signal_dbm;
+
+            if (max_signal_dbm == 0 || max_signal_dbm < l1info->signal_dbm)
+                max_signal_dbm = l1info->signal_dbm;
+        }
+
+        if (l1info->noise_dbm != 0) {
+            last_noise_dbm = l1info->noise_dbm;
+
+            if (min_noise_dbm == 0 || min_noise_dbm > l1info->noise_dbm)
+                min_noise_dbm = l1info->noise_dbm;
+
+            if (max_noise_dbm == 0 || max_noise_dbm < l1info->noise_dbm)
+                max_noise_dbm = l1info->noise_dbm;
+        }
+    } else if (l1info->signal_type == kis_l1_signal_type_rssi) {
+        rssi_seen = true;
+
+        if (l1info->signal_rssi != 0) {
+            last_signal_rssi = l1info->signal_rssi;
+
+            if (min_signal_rssi == 0 || min_signal_rssi > l1info->signal_rssi)
+                min_signal_rssi = l1info->signal_rssi;
+
+            if (max_signal_rssi == 0 || max_signal_rssi < l1info->signal_rssi)
+                max_signal_rssi = l1info->signal_rssi;
+        }
+
+        if (l1info->noise_rssi != 0) {
+            last_noise_rssi = l1info->noise_rssi;
+
+            if (min_noise_rssi == 0 || min_noise_rssi > l1info->noise_rssi)
+                min_noise_rssi = l1info->noise_rssi;
+
+            if (max_noise_rssi == 0 || max_noise_rssi < l1info->noise_rssi)
+                max_noise_rssi = l1info->noise_rssi;
+        }
+
+        carrierset |= (uint64_t) l1info->carrier;
+        encodingset |= (uint64_t) l1info->encoding;
+
+        if (maxseenrate < l1info->datarate)
+            maxseenrate = l1info->datarate;
+    }
+}
+
+void Channeltracker_V2_Stage::flush(std::shared_ptr<Channeltracker_V2_Channel> channel,
+        time_t ts) {
+    if (packets != 0)
+        channel->get_packets_rrd()->add_sample(packets, ts);
+
+    if (data_seen)
+        channel->get_data_rrd()->add_sample(data, ts);
+
+    // Replay the staged signal extremes through the signal tracker as
+    // synthetic l1 records; feeding min, max, and last in that order
+    // produces the same min/max/last state as the original packet stream
+    kis_layer1_packinfo syn;
+
+    if (dbm_seen) {
+        syn.signal_type = kis_l1_signal_type_dbm;
+
+        syn.signal_dbm = min_signal_dbm;
+        syn.noise_dbm = min_noise_dbm;
+        (*(channel->get_signal_data())) += syn;
+
+        syn.signal_dbm = max_signal_dbm;
+        syn.noise_dbm = max_noise_dbm;
+        (*(channel->get_signal_data())) += syn;
+
+        syn.signal_dbm = last_signal_dbm;
+        syn.noise_dbm = last_noise_dbm;
+        (*(channel->get_signal_data())) += syn;
+    }
+
+    if (rssi_seen) {
+        syn.reset();
+        syn.signal_type = kis_l1_signal_type_rssi;
+
+        syn.signal_rssi = min_signal_rssi;
+        syn.noise_rssi = min_noise_rssi;
+        (*(channel->get_signal_data())) += syn;
+
+        syn.signal_rssi = max_signal_rssi;
+        syn.noise_rssi = max_noise_rssi;
+        (*(channel->get_signal_data())) += syn;
+
+        syn.signal_rssi = last_signal_rssi;
+        syn.noise_rssi = last_noise_rssi;
+        syn.carrier = (phy_carrier_type) carrierset;
+        syn.encoding = (phy_encoding_type) encodingset;
+        syn.datarate = maxseenrate;
+        (*(channel->get_signal_data())) += syn;
+    }
+}
+
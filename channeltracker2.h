@@ -23,6 +23,7 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 
 #include "globalregistry.h"
 #include "kis_mutex.h"
@@ -72,7 +73,7 @@ public:
     /*
     // C++-domain map of devices we've seen in the last second for computing if we
     // increase the RRD record
-    map<mac_addr, bool> seen_device_map;
+    std::unordered_map<mac_addr, bool> seen_device_map;
     time_t last_device_sec;
     */
 
@@ -160,8 +161,58 @@ protected:
 
 };
 
-class Channeltracker_V2 : public tracker_component, 
-    public Kis_Net_Httpd_CPPStream_Handler, public LifetimeGlobal, 
+// Staged per-packet accounting for a single channel or frequency.  The
+// packet chain handler only updates staging records under a narrow lock;
+// the one-second timer folds them into the tracked channel records, so
+// per-packet work never touches the main channel lock or the tracked
+// element tree.
+class Channeltracker_V2_Stage {
+public:
+    Channeltracker_V2_Stage() {
+        packets = 0;
+        data = 0;
+        data_seen = false;
+
+        dbm_seen = false;
+        last_signal_dbm = min_signal_dbm = max_signal_dbm = 0;
+        last_noise_dbm = min_noise_dbm = max_noise_dbm = 0;
+
+        rssi_seen = false;
+        last_signal_rssi = min_signal_rssi = max_signal_rssi = 0;
+        last_noise_rssi = min_noise_rssi = max_noise_rssi = 0;
+
+        carrierset = 0;
+        encodingset = 0;
+        maxseenrate = 0;
+    }
+
+    // Fold a packet's l1 signal info into the staged record
+    void stage_signal(kis_layer1_packinfo *l1info);
+
+    // Fold the staged record into a channel entry
+    void flush(std::shared_ptr<Channeltracker_V2_Channel> channel, time_t ts);
+
+    uint64_t packets;
+    uint64_t data;
+    bool data_seen;
+
+    // Staged signal info, following the signal tracker convention of 0
+    // meaning unseen
+    bool dbm_seen;
+    int last_signal_dbm, min_signal_dbm, max_signal_dbm;
+    int last_noise_dbm, min_noise_dbm, max_noise_dbm;
+
+    bool rssi_seen;
+    int last_signal_rssi, min_signal_rssi, max_signal_rssi;
+    int last_noise_rssi, min_noise_rssi, max_noise_rssi;
+
+    uint64_t carrierset;
+    uint64_t encodingset;
+    double maxseenrate;
+};
+
+class Channeltracker_V2 : public tracker_component,
+    public Kis_Net_Httpd_CPPStream_Handler, public LifetimeGlobal,
     public TimetrackerEvent {
 public:
     static std::shared_ptr<Channeltracker_V2> create_channeltracker(GlobalRegistry *in_globalreg) {
@@ -191,6 +242,11 @@ public:
     // Update device counts
     void update_device_counts(std::map<double, unsigned int> in_counts);
 
+    // Fetch the recent packet activity (average packets per second over the
+    // past minute) of a logical channel; returns -1 if we have no record of
+    // the channel at all, and 0 if the record has gone stale
+    double get_channel_activity(std::string in_chan);
+
     int device_decay;
 
 protected:
@@ -219,6 +275,16 @@ protected:
     int pack_comp_l1data, pack_comp_devinfo, pack_comp_common, pack_comp_device;
 
     int timer_id;
+
+    // Per-packet staging; the stage mutex guards the staging maps and is
+    // the only lock the packet chain handler takes
+    kis_recursive_timed_mutex stage_mutex;
+
+    std::map<std::string, std::shared_ptr<Channeltracker_V2_Stage> > channel_stage_map;
+    std::map<double, std::shared_ptr<Channeltracker_V2_Stage> > frequency_stage_map;
+
+    // Fold the staged counts into the tracked channel records
+    void flush_staged_counts();
 };
 
 #endif
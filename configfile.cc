@@ -76,6 +76,8 @@ int ConfigFile::ParseConfig(const char *in_fname) {
 
     config_override_file_list.empty();
 
+    RefreshOptHandles();
+
     return r;
 }
 
@@ -347,6 +349,114 @@ unsigned int ConfigFile::FetchOptUInt(std::string in_key, unsigned int dvalue) {
     return r;
 }
 
+int ConfigFile::ResolveOptHandle(std::string in_key) {
+    local_locker lock(&config_locker);
+
+    std::string lkey = StrLower(in_key);
+
+    auto hitr = opt_handle_map.find(lkey);
+    if (hitr != opt_handle_map.end())
+        return hitr->second;
+
+    int handle = opt_handle_keys.size();
+
+    opt_handle_keys.push_back(lkey);
+    opt_handle_map[lkey] = handle;
+
+    auto cmitr = config_map.find(lkey);
+    if (cmitr == config_map.end())
+        opt_handle_values.push_back(NULL);
+    else
+        opt_handle_values.push_back(&(cmitr->second));
+
+    return handle;
+}
+
+void ConfigFile::RefreshOptHandles() {
+    local_locker lock(&config_locker);
+
+    for (unsigned int x = 0; x < opt_handle_keys.size(); x++) {
+        auto cmitr = config_map.find(opt_handle_keys[x]);
+
+        if (cmitr == config_map.end())
+            opt_handle_values[x] = NULL;
+        else
+            opt_handle_values[x] = &(cmitr->second);
+    }
+}
+
+std::string ConfigFile::FetchOpt(int in_handle) {
+    local_locker lock(&config_locker);
+
+    if (in_handle < 0 || (unsigned int) in_handle >= opt_handle_values.size())
+        return "";
+
+    const std::vector<config_entity> *ent = opt_handle_values[in_handle];
+
+    if (ent == NULL || ent->size() == 0)
+        return "";
+
+    return (*ent)[0].value;
+}
+
+std::vector<std::string> ConfigFile::FetchOptVec(int in_handle) {
+    local_locker lock(&config_locker);
+
+    std::vector<std::string> eretvec;
+
+    if (in_handle < 0 || (unsigned int) in_handle >= opt_handle_values.size())
+        return eretvec;
+
+    const std::vector<config_entity> *ent = opt_handle_values[in_handle];
+
+    if (ent == NULL)
+        return eretvec;
+
+    for (unsigned int i = 0; i < ent->size(); i++) {
+        eretvec.push_back((*ent)[i].value);
+    }
+
+    return eretvec;
+}
+
+int ConfigFile::FetchOptBoolean(int in_handle, int dvalue) {
+    std::string v = StrLower(FetchOpt(in_handle));
+    int r;
+
+    r = StringToBool(v);
+
+    if (r == -1)
+        return dvalue;
+
+    return r;
+}
+
+int ConfigFile::FetchOptInt(int in_handle, int dvalue) {
+    std::string v = StrLower(FetchOpt(in_handle));
+    int r;
+
+    try {
+        r = StringToInt(v);
+    } catch (const std::runtime_error e) {
+        return dvalue;
+    }
+
+    return r;
+}
+
+unsigned int ConfigFile::FetchOptUInt(int in_handle, unsigned int dvalue) {
+    std::string v = FetchOpt(in_handle);
+    unsigned int r;
+
+    try {
+        r = StringToUInt(v);
+    } catch (const std::runtime_error e) {
+        return dvalue;
+    }
+
+    return r;
+}
+
 unsigned long ConfigFile::FetchOptULong(std::string in_key, unsigned long dvalue) {
     std::string v = FetchOpt(in_key);
     std::stringstream ss(v);
@@ -381,6 +491,7 @@ void ConfigFile::SetOpt(std::string in_key, std::string in_val, int in_dirty) {
     v.push_back(e);
     config_map[StrLower(in_key)] = v;
     SetOptDirty(in_key, in_dirty);
+    RefreshOptHandles();
 }
 
 void ConfigFile::SetOptVec(std::string in_key, 
@@ -395,6 +506,7 @@ void ConfigFile::SetOptVec(std::string in_key,
 
     config_map[StrLower(in_key)] = cev;
     SetOptDirty(in_key, in_dirty);
+    RefreshOptHandles();
 }
 
 
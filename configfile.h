@@ -58,6 +58,20 @@ public:
     unsigned int FetchOptUInt(std::string in_key, unsigned int dvalue);
     unsigned long int FetchOptULong(std::string in_key, unsigned long dvalue);
 
+    // Resolve a config key to an integer handle; the handle-based fetch
+    // calls below skip the lowercase pass and map probe on every access,
+    // for options checked repeatedly at runtime rather than at startup.
+    // Handles stay valid for the lifetime of the ConfigFile and track
+    // later SetOpt changes; resolving a key that isn't present returns a
+    // usable handle which reports empty until the key is set.
+    int ResolveOptHandle(std::string in_key);
+
+    std::string FetchOpt(int in_handle);
+    std::vector<std::string> FetchOptVec(int in_handle);
+    int FetchOptBoolean(int in_handle, int dvalue);
+    int FetchOptInt(int in_handle, int dvalue);
+    unsigned int FetchOptUInt(int in_handle, unsigned int dvalue);
+
 	int FetchOptDirty(std::string in_key);
 	void SetOptDirty(std::string in_key, int in_dirty);
 
@@ -101,8 +115,19 @@ protected:
 
     std::string filename;
 
+    // Re-point the resolved handles at the current config_map entries;
+    // called after parsing and whenever an option is set
+    void RefreshOptHandles();
+
     std::map<std::string, std::vector<config_entity> > config_map;
     std::map<std::string, int> config_map_dirty;
+
+    // Interned key handles; each handle caches the lowercased key and a
+    // pointer to the value vector inside config_map (map nodes are
+    // address-stable, and SetOpt assigns into the existing node)
+    std::vector<std::string> opt_handle_keys;
+    std::vector<const std::vector<config_entity> *> opt_handle_values;
+    std::map<std::string, int> opt_handle_map;
     uint32_t checksum;
     std::string ckstring;
 
@@ -66,12 +66,26 @@ void KisDatasourceLinuxBluetooth::handle_packet_linuxbtdevice(uint32_t in_seqno,
         return;
     }
 
-    if (report.has_message()) 
+    if (report.has_message())
         _MSG(report.message().msgtext(), report.message().msgtype());
 
     if (report.has_warning())
         set_int_source_warning(report.warning());
 
+    // Interval-coalesced reports carry a batch of devices; fall back to the
+    // single device record for older capture tools
+    if (report.btdevice_list_size() > 0) {
+        for (auto d : report.btdevice_list())
+            handle_bt_device_record(report, d);
+    } else if (report.has_btdevice()) {
+        handle_bt_device_record(report, report.btdevice());
+    }
+}
+
+void KisDatasourceLinuxBluetooth::handle_bt_device_record(
+        KismetLinuxBluetooth::LinuxBluetoothDataReport& report,
+        const KismetLinuxBluetooth::SubLinuxBluetoothDevice& btdevice) {
+
     kis_packet *packet = packetchain->GeneratePacket();
     bluetooth_packinfo *bpi = new bluetooth_packinfo();
 
@@ -90,17 +104,17 @@ void KisDatasourceLinuxBluetooth::handle_packet_linuxbtdevice(uint32_t in_seqno,
         packet->insert(pack_comp_gps, gpsinfo);
     }
 
-    packet->ts.tv_sec = report.btdevice().time_sec();
-    packet->ts.tv_usec = report.btdevice().time_usec();
+    packet->ts.tv_sec = btdevice.time_sec();
+    packet->ts.tv_usec = btdevice.time_usec();
 
-    bpi->address = mac_addr(report.btdevice().address());
-    bpi->name = MungeToPrintable(report.btdevice().name());
-    bpi->txpower = report.btdevice().txpower();
-    bpi->type = report.btdevice().type();
+    bpi->address = mac_addr(btdevice.address());
+    bpi->name = MungeToPrintable(btdevice.name());
+    bpi->txpower = btdevice.txpower();
+    bpi->type = btdevice.type();
 
-    for (auto u : report.btdevice().uuid_list()) 
+    for (auto u : btdevice.uuid_list())
         bpi->service_uuid_vec.push_back(uuid(u));
-   
+
     packetchain_comp_datasource *datasrcinfo = new packetchain_comp_datasource();
     datasrcinfo->ref_source = this;
 
@@ -111,7 +125,6 @@ void KisDatasourceLinuxBluetooth::handle_packet_linuxbtdevice(uint32_t in_seqno,
 
     // Inject the packet into the packetchain if we have one
     packetchain->ProcessPacket(packet);
-
 }
 
 #endif
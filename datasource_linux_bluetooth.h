@@ -25,6 +25,11 @@
 
 #include "kis_datasource.h"
 
+namespace KismetLinuxBluetooth {
+    class LinuxBluetoothDataReport;
+    class SubLinuxBluetoothDevice;
+}
+
 class KisDatasourceLinuxBluetooth;
 typedef std::shared_ptr<KisDatasourceLinuxBluetooth> SharedDatasourceLinuxBluetooth;
 
@@ -40,6 +45,10 @@ protected:
   
     virtual void handle_packet_linuxbtdevice(uint32_t in_seqno, std::string in_content);
 
+    // Inject a single device record from a report into the packetchain
+    virtual void handle_bt_device_record(KismetLinuxBluetooth::LinuxBluetoothDataReport& report,
+            const KismetLinuxBluetooth::SubLinuxBluetoothDevice& btdevice);
+
     int pack_comp_btdevice;
 };
 
@@ -19,7 +19,8 @@
 #include "config.h"
 #include "kis_datasource.h"
 #include "datasource_rtl433.h"
-#include "kismet_json.h"
+#include "flat_json.h"
+#include "timetracker.h"
 #include "phy_rtl433.h"
 
 KisDatasourceRtl433::KisDatasourceRtl433(GlobalRegistry *in_globalreg,
@@ -107,92 +108,73 @@ int KisDatasourceRtl433::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
         return MHD_NO;
 
     if (tokenurl[4] == "update") {
-        Json::Value device_json;
-        Json::Value gps_json;
-        Json::Value meta_json;
-
-        try {
-            std::stringstream ss;
-            
-            ss.str(concls->variable_cache["device"]->str());
-            ss >> device_json;
-
-            ss.str(concls->variable_cache["meta"]->str());
-            ss >> meta_json;
-
-            if (concls->variable_cache.find("gps") != concls->variable_cache.end()) {
-                ss.str(concls->variable_cache["gps"]->str());
-                ss >> gps_json;
-            }
-        } catch (std::exception& e) {
-            concls->response_stream << "Invalid request:  could not parse JSON: " << e.what();
+        // The helper reports are flat single-level json arriving at packet
+        // rate; scan them in place instead of building a DOM per report
+        FlatJsonReport device_json;
+        FlatJsonReport gps_json;
+        FlatJsonReport meta_json;
+
+        bool has_gps = false;
+
+        if (!device_json.parse(concls->variable_cache["device"]->str()) ||
+                !meta_json.parse(concls->variable_cache["meta"]->str())) {
+            concls->response_stream << "Invalid request:  could not parse JSON";
             concls->httpcode = 400;
             return MHD_YES;
         }
 
-        kis_packet *packet = packetchain->GeneratePacket();
-
-        try {
-            if (clobber_timestamp) {
-                gettimeofday(&(packet->ts), NULL);
-            } else {
-                auto tv_sec_j = meta_json["tv_sec"];
-                auto tv_usec_j = meta_json["tv_usec"];
-
-                packet->ts.tv_sec = tv_sec_j.asUInt64();
-                packet->ts.tv_usec = tv_usec_j.asUInt64();
+        if (concls->variable_cache.find("gps") != concls->variable_cache.end()) {
+            if (!gps_json.parse(concls->variable_cache["gps"]->str())) {
+                concls->response_stream << "Invalid request:  could not parse JSON";
+                concls->httpcode = 400;
+                return MHD_YES;
             }
 
-            if (gps_json.isObject()) {
-                auto lat_j = gps_json["lat"];
-                auto lon_j = gps_json["lon"];
-                auto alt_j = gps_json["alt"];
-                auto spd_j = gps_json["speed"];
-                auto head_j = gps_json["heading"];
-                auto prec_j = gps_json["precision"];
-                auto time_j = gps_json["time"];
-                auto fix_j = gps_json["fix"];
+            has_gps = true;
+        }
 
-                if (lat_j.isNumeric() && lon_j.isNumeric()) {
-                    kis_gps_packinfo *gpsinfo = new kis_gps_packinfo();
+        kis_packet *packet = packetchain->GeneratePacket();
 
-                    gpsinfo->lat = lat_j.asDouble();
-                    gpsinfo->lon = lon_j.asDouble();
+        if (clobber_timestamp) {
+            gettimeofday(&(packet->ts), NULL);
+        } else {
+            packet->ts.tv_sec = (uint64_t) meta_json.getNumber("tv_sec", 0);
+            packet->ts.tv_usec = (uint64_t) meta_json.getNumber("tv_usec", 0);
+        }
+
+        if (has_gps) {
+            if (gps_json.isNumber("lat") && gps_json.isNumber("lon")) {
+                kis_gps_packinfo *gpsinfo = new kis_gps_packinfo();
 
-                    gpsinfo->fix = 2;
+                gpsinfo->lat = gps_json.getNumber("lat", 0);
+                gpsinfo->lon = gps_json.getNumber("lon", 0);
 
-                    if (alt_j.isNumeric()) {
-                        gpsinfo->alt = alt_j.asDouble();
-                        gpsinfo->fix = 3;
-                    }
+                gpsinfo->fix = 2;
 
-                    if (fix_j.isNumeric()) 
-                        gpsinfo->fix = fix_j.asUInt();
+                if (gps_json.isNumber("alt")) {
+                    gpsinfo->alt = gps_json.getNumber("alt", 0);
+                    gpsinfo->fix = 3;
+                }
 
-                    if (spd_j.isNumeric())
-                        gpsinfo->speed = spd_j.asDouble();
+                if (gps_json.isNumber("fix"))
+                    gpsinfo->fix = (unsigned int) gps_json.getNumber("fix", 0);
 
-                    if (head_j.isNumeric()) 
-                        gpsinfo->heading = head_j.asDouble();
+                if (gps_json.isNumber("speed"))
+                    gpsinfo->speed = gps_json.getNumber("speed", 0);
 
-                    if (prec_j.isNumeric())
-                        gpsinfo->precision = prec_j.asDouble();
+                if (gps_json.isNumber("heading"))
+                    gpsinfo->heading = gps_json.getNumber("heading", 0);
 
-                    if (time_j.isNumeric()) {
-                        gpsinfo->tv.tv_sec = time_j.asUInt64();
-                        gpsinfo->tv.tv_usec = 0;
-                    }
+                if (gps_json.isNumber("precision"))
+                    gpsinfo->precision = gps_json.getNumber("precision", 0);
 
-                    packet->insert(pack_comp_gps, gpsinfo);
+                if (gps_json.isNumber("time")) {
+                    gpsinfo->tv.tv_sec = (uint64_t) gps_json.getNumber("time", 0);
+                    gpsinfo->tv.tv_usec = 0;
                 }
-            }
-        } catch (std::exception& e) {
-            packetchain->DestroyPacket(packet);
-            packet = NULL;
 
-            concls->response_stream << "Invalid request:  could not process packet: " << e.what();
-            concls->httpcode = 400;
-            return MHD_YES;
+                packet->insert(pack_comp_gps, gpsinfo);
+            }
         }
 
         // Put the parsed JSON in a rtl433
@@ -209,7 +191,7 @@ int KisDatasourceRtl433::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
         packet->insert(pack_comp_datasrc, datasrcinfo);
 
         inc_source_num_packets(1);
-        get_source_packet_rrd()->add_sample(1, time(0));
+        get_source_packet_rrd()->add_sample(1, Timetracker::GetCachedTime());
 
         packetchain->ProcessPacket(packet);
     }
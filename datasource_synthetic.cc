@@ -0,0 +1,353 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+#include "kis_datasource.h"
+#include "datasource_synthetic.h"
+#include "timetracker.h"
+
+// Largest frame any builder emits; beacons with a full tag set stay
+// well under this
+#define KIS_SYNTH_MAX_FRAME     256
+
+// Synthetic APs round-robin across the common non-overlapping 2.4GHz
+// channels
+static const unsigned int synth_channels[3] = { 1, 6, 11 };
+static const double synth_freqs_khz[3] = { 2412000, 2437000, 2462000 };
+
+KisDatasourceSynthetic::KisDatasourceSynthetic(GlobalRegistry *in_globalreg,
+        SharedDatasourceBuilder in_builder) :
+    KisDatasource(in_globalreg, in_builder) {
+
+    gen_shutdown = false;
+    gen_running = false;
+
+    num_aps = 10;
+    num_clients = 4;
+    pps_start = 100;
+    pps_ramp = 0;
+    pps_max = 0;
+
+    frames_generated = 0;
+    seqno_counter = 0;
+
+    set_int_source_cap_interface("synthetic");
+    set_int_source_hardware("synthetic");
+    set_int_source_retry(false);
+}
+
+KisDatasourceSynthetic::~KisDatasourceSynthetic() {
+    if (gen_running) {
+        gen_shutdown = true;
+        pthread_join(gen_thread, NULL);
+        gen_running = false;
+    }
+}
+
+void KisDatasourceSynthetic::open_interface(std::string in_definition,
+        unsigned int in_transaction, open_callback_t in_cb) {
+    local_locker lock(&ext_mutex);
+
+    set_int_source_definition(in_definition);
+
+    if (!parse_interface_definition(in_definition)) {
+        if (in_cb != NULL)
+            in_cb(in_transaction, false, "Malformed source config");
+
+        return;
+    }
+
+    num_aps = (unsigned int) get_definition_opt_double("aps", 10);
+    num_clients = (unsigned int) get_definition_opt_double("clients", 4);
+    pps_start = get_definition_opt_double("pps", 100);
+    pps_ramp = get_definition_opt_double("ramp", 0);
+    pps_max = get_definition_opt_double("maxpps", 0);
+
+    if (num_aps < 1)
+        num_aps = 1;
+    if (num_clients < 1)
+        num_clients = 1;
+    if (pps_start < 1)
+        pps_start = 1;
+
+    // No capture binary ever reports a UUID for us; generate an ephemeral
+    // one like any other passively opened source
+    if (get_source_uuid().error && !local_uuid) {
+        uuid nuuid;
+
+        nuuid.GenerateTimeUUID((uint8_t *) "\x00\x00\x00\x00\x00\x00");
+
+        set_source_uuid(nuuid);
+        set_source_key(Adler32Checksum(nuuid.UUID2String()));
+    }
+
+    set_int_source_retry_attempts(0);
+
+    set_int_source_running(1);
+    set_int_source_error(0);
+
+    if (!gen_running) {
+        gen_shutdown = false;
+        gen_running = true;
+
+        pthread_create(&gen_thread, NULL,
+                &KisDatasourceSynthetic::synthetic_generator, this);
+    }
+
+    _MSG("Synthetic datasource generating " + UIntToString(num_aps) + " APs with " +
+            UIntToString(num_clients) + " clients each at " +
+            IntToString((int) pps_start) + " packets/sec" +
+            (pps_ramp > 0 ?
+                ", ramping " + IntToString((int) pps_ramp) + " pps/sec" : ""),
+            MSGFLAG_INFO);
+
+    if (in_cb != NULL)
+        in_cb(in_transaction, true, "Synthetic source running");
+}
+
+void KisDatasourceSynthetic::close_source() {
+    if (gen_running) {
+        gen_shutdown = true;
+        pthread_join(gen_thread, NULL);
+        gen_running = false;
+    }
+
+    KisDatasource::close_source();
+}
+
+void *KisDatasourceSynthetic::synthetic_generator(void *in_arg) {
+    KisDatasourceSynthetic *synth = (KisDatasourceSynthetic *) in_arg;
+
+    synth->generator_loop();
+
+    return NULL;
+}
+
+void KisDatasourceSynthetic::generator_loop() {
+    double cur_pps = pps_start;
+    double accum = 0;
+    unsigned int slice = 0;
+
+    // Generate in 100ms slices; carry the fractional remainder forward so
+    // low rates still average out exactly
+    while (!gen_shutdown) {
+        usleep(100000);
+
+        slice++;
+
+        if (pps_ramp > 0 && (slice % 10) == 0) {
+            cur_pps += pps_ramp;
+
+            if (pps_max > 0 && cur_pps > pps_max)
+                cur_pps = pps_max;
+        }
+
+        if (get_source_paused())
+            continue;
+
+        accum += cur_pps / 10.0;
+
+        unsigned int burst = (unsigned int) accum;
+        accum -= burst;
+
+        for (unsigned int p = 0; p < burst && !gen_shutdown; p++)
+            emit_frame();
+    }
+}
+
+void KisDatasourceSynthetic::emit_frame() {
+    uint8_t buf[KIS_SYNTH_MAX_FRAME];
+    size_t len;
+
+    uint64_t n = frames_generated++;
+
+    unsigned int ap = (unsigned int) ((n / 10) % num_aps);
+    unsigned int client = (unsigned int) (n % num_clients);
+
+    int signal;
+
+    // One beacon and one probe request per ten frames, the rest data;
+    // roughly the shape of a busy but healthy BSS.  Signal levels are
+    // derived from the indexes so each device keeps a stable RSSI
+    if ((n % 10) == 0) {
+        len = build_beacon(buf, ap);
+        signal = -40 - (int) (ap % 30);
+    } else if ((n % 10) == 9) {
+        len = build_probe_req(buf, ap, client);
+        signal = -50 - (int) ((ap * 7 + client) % 30);
+    } else {
+        len = build_data(buf, ap, client);
+        signal = -50 - (int) ((ap * 7 + client) % 30);
+    }
+
+    kis_packet *packet = packetchain->GeneratePacket();
+
+    gettimeofday(&(packet->ts), NULL);
+
+    kis_datachunk *datachunk = new kis_datachunk();
+    datachunk->dlt = KDLT_IEEE802_11;
+    datachunk->source_id = (uint16_t) get_source_number();
+    datachunk->copy_data(buf, len);
+    packet->insert(pack_comp_linkframe, datachunk);
+
+    kis_layer1_packinfo *siginfo = new kis_layer1_packinfo();
+    siginfo->signal_type = kis_l1_signal_type_dbm;
+    siginfo->signal_dbm = signal;
+    siginfo->channel = UIntToString(synth_channels[ap % 3]);
+    siginfo->freq_khz = synth_freqs_khz[ap % 3];
+    packet->insert(pack_comp_l1info, siginfo);
+
+    packetchain_comp_datasource *datasrcinfo = new packetchain_comp_datasource();
+    datasrcinfo->ref_source = this;
+    packet->insert(pack_comp_datasrc, datasrcinfo);
+
+    inc_source_num_packets(1);
+    get_source_packet_rrd()->add_sample(1, Timetracker::GetCachedTime());
+
+    packetchain->ProcessPacket(packet);
+}
+
+void KisDatasourceSynthetic::fill_ap_mac(uint8_t *dest, unsigned int ap) {
+    // Locally administered OUI, 'SYN'; APs keyed by index
+    dest[0] = 0x02;
+    dest[1] = 0x53;
+    dest[2] = 0x59;
+    dest[3] = 0x4E;
+    dest[4] = (ap >> 8) & 0xFF;
+    dest[5] = ap & 0xFF;
+}
+
+void KisDatasourceSynthetic::fill_client_mac(uint8_t *dest, unsigned int ap,
+        unsigned int client) {
+    // Locally administered OUI, 'SYC'; clients keyed by AP and index
+    dest[0] = 0x02;
+    dest[1] = 0x53;
+    dest[2] = 0x59;
+    dest[3] = 0x43;
+    dest[4] = ap & 0xFF;
+    dest[5] = client & 0xFF;
+}
+
+size_t KisDatasourceSynthetic::build_beacon(uint8_t *buf, unsigned int ap) {
+    memset(buf, 0, KIS_SYNTH_MAX_FRAME);
+
+    // Management header; beacon to broadcast from the AP
+    buf[0] = 0x80;
+    memset(buf + 4, 0xFF, 6);
+    fill_ap_mac(buf + 10, ap);
+    fill_ap_mac(buf + 16, ap);
+
+    uint16_t seq = seqno_counter++;
+    buf[22] = (seq << 4) & 0xFF;
+    buf[23] = (seq >> 4) & 0xFF;
+
+    size_t offt = 24;
+
+    // Fixed parameters: TSF timestamp, 100TU beacon interval, ESS capability
+    uint64_t tsf = frames_generated * 1024;
+    for (unsigned int b = 0; b < 8; b++)
+        buf[offt + b] = (tsf >> (b * 8)) & 0xFF;
+    offt += 8;
+
+    buf[offt++] = 0x64;
+    buf[offt++] = 0x00;
+    buf[offt++] = 0x01;
+    buf[offt++] = 0x00;
+
+    // SSID tag
+    std::string ssid = "SYNTH-" + UIntToString(ap);
+    buf[offt++] = 0x00;
+    buf[offt++] = (uint8_t) ssid.length();
+    memcpy(buf + offt, ssid.data(), ssid.length());
+    offt += ssid.length();
+
+    // Supported rates tag, standard 802.11b/g set
+    static const uint8_t rates[8] = { 0x82, 0x84, 0x8b, 0x96, 0x0c, 0x12, 0x18, 0x24 };
+    buf[offt++] = 0x01;
+    buf[offt++] = sizeof(rates);
+    memcpy(buf + offt, rates, sizeof(rates));
+    offt += sizeof(rates);
+
+    // DS parameter set tag (channel)
+    buf[offt++] = 0x03;
+    buf[offt++] = 0x01;
+    buf[offt++] = (uint8_t) synth_channels[ap % 3];
+
+    return offt;
+}
+
+size_t KisDatasourceSynthetic::build_data(uint8_t *buf, unsigned int ap,
+        unsigned int client) {
+    memset(buf, 0, KIS_SYNTH_MAX_FRAME);
+
+    // Data frame, to-DS, from a client through its AP
+    buf[0] = 0x08;
+    buf[1] = 0x01;
+    fill_ap_mac(buf + 4, ap);
+    fill_client_mac(buf + 10, ap, client);
+    memset(buf + 16, 0xFF, 6);
+
+    uint16_t seq = seqno_counter++;
+    buf[22] = (seq << 4) & 0xFF;
+    buf[23] = (seq >> 4) & 0xFF;
+
+    size_t offt = 24;
+
+    // LLC SNAP header, IPv4 ethertype
+    static const uint8_t llc[8] = { 0xaa, 0xaa, 0x03, 0x00, 0x00, 0x00, 0x08, 0x00 };
+    memcpy(buf + offt, llc, sizeof(llc));
+    offt += sizeof(llc);
+
+    // Deterministic filler payload; not a valid IP frame, the dissectors
+    // discard it past the 802.11 layer, which is the load we're after
+    for (unsigned int b = 0; b < 64; b++)
+        buf[offt + b] = (ap + client + b) & 0xFF;
+    offt += 64;
+
+    return offt;
+}
+
+size_t KisDatasourceSynthetic::build_probe_req(uint8_t *buf, unsigned int ap,
+        unsigned int client) {
+    memset(buf, 0, KIS_SYNTH_MAX_FRAME);
+
+    // Broadcast probe request from a client
+    buf[0] = 0x40;
+    memset(buf + 4, 0xFF, 6);
+    fill_client_mac(buf + 10, ap, client);
+    memset(buf + 16, 0xFF, 6);
+
+    uint16_t seq = seqno_counter++;
+    buf[22] = (seq << 4) & 0xFF;
+    buf[23] = (seq >> 4) & 0xFF;
+
+    size_t offt = 24;
+
+    // Wildcard SSID tag
+    buf[offt++] = 0x00;
+    buf[offt++] = 0x00;
+
+    // Supported rates tag
+    static const uint8_t rates[8] = { 0x82, 0x84, 0x8b, 0x96, 0x0c, 0x12, 0x18, 0x24 };
+    buf[offt++] = 0x01;
+    buf[offt++] = sizeof(rates);
+    memcpy(buf + offt, rates, sizeof(rates));
+    offt += sizeof(rates);
+
+    return offt;
+}
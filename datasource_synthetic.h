@@ -0,0 +1,141 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __DATASOURCE_SYNTHETIC_H__
+#define __DATASOURCE_SYNTHETIC_H__
+
+#include "config.h"
+
+#include <atomic>
+
+#include "kis_datasource.h"
+
+/* A deterministic synthetic 802.11 traffic generator, the packet-side
+ * sibling of gpsfake.  It runs entirely in-process - no capture binary,
+ * no IPC - and injects parameterized beacon/data/mgmt traffic straight
+ * into the packet chain, so a configuration's breaking point can be
+ * found reproducibly before deploying it on real radios.
+ *
+ * Source definition options:
+ *   aps=N      number of synthetic access points (default 10)
+ *   clients=M  clients per AP (default 4)
+ *   pps=R      starting packet rate (default 100)
+ *   ramp=S     packets-per-second added every second (default 0)
+ *   maxpps=L   rate cap when ramping (default 0, uncapped)
+ *
+ * All MAC addresses, SSIDs, and frame contents are derived from the AP
+ * and client indexes, so two runs with the same options generate the
+ * same device population.
+ */
+
+class KisDatasourceSynthetic;
+typedef std::shared_ptr<KisDatasourceSynthetic> SharedDatasourceSynthetic;
+
+class KisDatasourceSynthetic : public KisDatasource {
+public:
+    KisDatasourceSynthetic(GlobalRegistry *in_globalreg,
+            SharedDatasourceBuilder in_builder);
+    virtual ~KisDatasourceSynthetic();
+
+    // Synthetic sources open entirely locally; there's no capture binary
+    // to launch and no channel state to negotiate
+    virtual void open_interface(std::string in_definition, unsigned int in_transaction,
+            open_callback_t in_cb);
+
+    virtual void close_source();
+
+protected:
+    static void *synthetic_generator(void *in_arg);
+    void generator_loop();
+
+    // Emit one frame of the rotating beacon/data/mgmt schedule
+    void emit_frame();
+
+    // Frame builders; each returns the frame length written into buf,
+    // which must be at least KIS_SYNTH_MAX_FRAME bytes
+    size_t build_beacon(uint8_t *buf, unsigned int ap);
+    size_t build_data(uint8_t *buf, unsigned int ap, unsigned int client);
+    size_t build_probe_req(uint8_t *buf, unsigned int ap, unsigned int client);
+
+    void fill_ap_mac(uint8_t *dest, unsigned int ap);
+    void fill_client_mac(uint8_t *dest, unsigned int ap, unsigned int client);
+
+    pthread_t gen_thread;
+    std::atomic<bool> gen_shutdown;
+    bool gen_running;
+
+    // Generation parameters from the source definition
+    unsigned int num_aps, num_clients;
+    double pps_start, pps_ramp, pps_max;
+
+    // Rotating frame schedule position; also seeds timestamps and
+    // sequence numbers so runs are reproducible
+    uint64_t frames_generated;
+    uint16_t seqno_counter;
+};
+
+class DatasourceSyntheticBuilder : public KisDatasourceBuilder {
+public:
+    DatasourceSyntheticBuilder(GlobalRegistry *in_globalreg, int in_id) :
+        KisDatasourceBuilder(in_globalreg, in_id) {
+
+        register_fields();
+        reserve_fields(NULL);
+        initialize();
+    }
+
+    DatasourceSyntheticBuilder(GlobalRegistry *in_globalreg, int in_id,
+        SharedTrackerElement e) :
+        KisDatasourceBuilder(in_globalreg, in_id, e) {
+
+        register_fields();
+        reserve_fields(e);
+        initialize();
+    }
+
+    DatasourceSyntheticBuilder(GlobalRegistry *in_globalreg) :
+        KisDatasourceBuilder(in_globalreg, 0) {
+
+        register_fields();
+        reserve_fields(NULL);
+        initialize();
+    }
+
+    virtual ~DatasourceSyntheticBuilder() { }
+
+    virtual SharedDatasource build_datasource(SharedDatasourceBuilder in_sh_this) {
+        return SharedDatasourceSynthetic(new KisDatasourceSynthetic(globalreg,
+                    in_sh_this));
+    }
+
+    virtual void initialize() {
+        set_source_type("synthetic");
+        set_source_description("Deterministic synthetic 802.11 traffic generator");
+
+        // Entirely local; there's nothing to probe or list, no remote
+        // component, and no channel to tune
+        set_probe_capable(false);
+        set_list_capable(false);
+        set_local_capable(true);
+        set_remote_capable(false);
+        set_passive_capable(false);
+        set_tune_capable(false);
+    }
+};
+
+#endif
@@ -35,6 +35,7 @@
 #include "kis_httpd_registry.h"
 #include "endian_magic.h"
 #include "kis_databaselogfile.h"
+#include "channeltracker2.h"
 
 DST_DatasourceProbe::DST_DatasourceProbe(GlobalRegistry *in_globalreg, 
         std::string in_definition, SharedTrackerElement in_protovec) {
@@ -443,6 +444,31 @@ Datasourcetracker::Datasourcetracker(GlobalRegistry *in_globalreg) :
         database_log_timer = -1;
     }
 
+    if (globalreg->kismet_config->FetchOptBoolean("channel_adaptive_hop", false)) {
+        unsigned int rebalance_rate =
+            globalreg->kismet_config->FetchOptUInt("channel_adaptive_hop_rate", 30);
+
+        adaptive_hop_max_weight =
+            globalreg->kismet_config->FetchOptUInt("channel_adaptive_hop_max_weight", 4);
+
+        if (adaptive_hop_max_weight < 2)
+            adaptive_hop_max_weight = 2;
+
+        _MSG("Enabling adaptive channel hopping; hop patterns will be re-weighted "
+                "by observed channel activity every " + UIntToString(rebalance_rate) +
+                " seconds.", MSGFLAG_INFO);
+
+        adaptive_hop_timer =
+            timetracker->RegisterTimer(SERVER_TIMESLICES_SEC * rebalance_rate, NULL, 1,
+                    [this](int) -> int {
+                        rebalance_adaptive_hop();
+                        return 1;
+                    });
+    } else {
+        adaptive_hop_timer = -1;
+        adaptive_hop_max_weight = 0;
+    }
+
 }
 
 Datasourcetracker::~Datasourcetracker() {
@@ -458,6 +484,9 @@ Datasourcetracker::~Datasourcetracker() {
         databaselog_write_datasources();
     }
 
+    if (adaptive_hop_timer >= 0)
+        timetracker->RemoveTimer(adaptive_hop_timer);
+
     for (auto i = probing_map.begin(); i != probing_map.end(); ++i) {
         i->second->cancel();
     }
@@ -545,12 +574,30 @@ void Datasourcetracker::Deferred_Startup() {
         return;
     }
 
+    // All the opens are issued at once and complete independently as each
+    // IPC handshake finishes, so total startup cost is the slowest single
+    // source, not the sum; count completions so we can tell the user when
+    // the last one has landed.  Completion callbacks all fire from the main
+    // service loop so a plain counter is fine.
+    std::shared_ptr<unsigned int> completed_sources(new unsigned int(0));
+    unsigned int num_sources = src_vec.size();
+
+    struct timeval start_tv;
+    gettimeofday(&start_tv, NULL);
+
     for (unsigned int i = 0; i < src_vec.size(); i++) {
-        open_datasource(src_vec[i], 
-                [this, src_vec, i](bool success, std::string reason, SharedDatasource) {
+        open_datasource(src_vec[i],
+                [this, src_vec, i, completed_sources, num_sources,
+                 start_tv](bool success, std::string reason, SharedDatasource ds) {
             if (success) {
-                _MSG("Data source '" + src_vec[i] + "' launched successfully.", 
-                        MSGFLAG_INFO);
+                if (ds != NULL) {
+                    _MSG("Data source '" + src_vec[i] + "' launched successfully in " +
+                            FloatToString(ds->get_source_open_time_us() / 1000000.0f) +
+                            " seconds.", MSGFLAG_INFO);
+                } else {
+                    _MSG("Data source '" + src_vec[i] + "' launched successfully.",
+                            MSGFLAG_INFO);
+                }
             } else {
                 if (reason.length() != 0) {
                     _MSG("Data source '" + src_vec[i] + "' failed to launch: " + reason,
@@ -560,6 +607,20 @@ void Datasourcetracker::Deferred_Startup() {
                             "no error given.", MSGFLAG_ERROR);
                 }
             }
+
+            (*completed_sources)++;
+
+            if (*completed_sources == num_sources) {
+                struct timeval end_tv;
+                gettimeofday(&end_tv, NULL);
+
+                float elapsed = (end_tv.tv_sec - start_tv.tv_sec) +
+                    (end_tv.tv_usec - start_tv.tv_usec) / 1000000.0f;
+
+                _MSG("All " + UIntToString(num_sources) + " data sources have "
+                        "completed opening in " + FloatToString(elapsed) +
+                        " seconds.", MSGFLAG_INFO);
+            }
         });
     }
 
@@ -1133,6 +1194,93 @@ void Datasourcetracker::calculate_source_hopping(SharedDatasource in_ds) {
     }
 }
 
+void Datasourcetracker::rebalance_adaptive_hop() {
+    std::shared_ptr<Channeltracker_V2> channeltracker =
+        Globalreg::FetchGlobalAs<Channeltracker_V2>(globalreg, "CHANNEL_TRACKER");
+
+    // Channel tracker may not be up yet
+    if (channeltracker == NULL)
+        return;
+
+    local_locker lock(&dst_lock);
+
+    TrackerElementVector dsv(datasource_vec);
+
+    for (auto i = dsv.begin(); i != dsv.end(); ++i) {
+        SharedDatasource ds = std::static_pointer_cast<KisDatasource>(*i);
+
+        if (!ds->get_source_running() || !ds->get_source_hopping())
+            continue;
+
+        // Collapse the current hop vector back to unique channels so we
+        // re-weight from scratch every pass instead of compounding the
+        // weights of the previous pass
+        std::vector<std::string> unique_chans;
+
+        TrackerElementVector hvec(ds->get_source_hop_vec());
+
+        for (auto c = hvec.begin(); c != hvec.end(); ++c) {
+            std::string chan = GetTrackerValue<std::string>(*c);
+
+            if (std::find(unique_chans.begin(), unique_chans.end(), chan) ==
+                    unique_chans.end())
+                unique_chans.push_back(chan);
+        }
+
+        // Nothing to weight on a locked or single-channel source
+        if (unique_chans.size() <= 1)
+            continue;
+
+        double max_activity = 0;
+        std::vector<double> activity;
+
+        for (auto c = unique_chans.begin(); c != unique_chans.end(); ++c) {
+            double a = channeltracker->get_channel_activity(*c);
+
+            activity.push_back(a);
+
+            if (a > max_activity)
+                max_activity = a;
+        }
+
+        // Build the weighted hop pattern; each channel gets between 1 and
+        // max_weight slots proportional to its share of the observed
+        // activity.  Channels we have no record of stay at the floor.
+        std::vector<std::string> weighted_chans;
+
+        for (unsigned int x = 0; x < unique_chans.size(); x++) {
+            unsigned int weight = 1;
+
+            if (max_activity > 0 && activity[x] > 0)
+                weight += (unsigned int)
+                    ((activity[x] / max_activity) * (adaptive_hop_max_weight - 1) + 0.5);
+
+            if (weight > adaptive_hop_max_weight)
+                weight = adaptive_hop_max_weight;
+
+            for (unsigned int r = 0; r < weight; r++)
+                weighted_chans.push_back(unique_chans[x]);
+        }
+
+        // Skip the reconfigure if the pattern hasn't changed
+        bool changed = (weighted_chans.size() != hvec.size());
+
+        if (!changed) {
+            for (unsigned int x = 0; x < weighted_chans.size(); x++) {
+                if (weighted_chans[x] != GetTrackerValue<std::string>(*(hvec.begin() + x))) {
+                    changed = true;
+                    break;
+                }
+            }
+        }
+
+        if (!changed)
+            continue;
+
+        ds->set_channel_hop_list(weighted_chans, 0, NULL);
+    }
+}
+
 void Datasourcetracker::queue_dead_remote(dst_incoming_remote *in_dead) {
     local_locker lock(&dst_lock);
 
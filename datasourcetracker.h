@@ -484,10 +484,20 @@ protected:
     // Our pcap http interface
     std::shared_ptr<Datasourcetracker_Httpd_Pcap> httpd_pcap;
 
+    // Re-weight the hop pattern of hopping sources based on observed
+    // per-channel activity from the channel tracker; busy channels are
+    // repeated in the hop vector so they get proportionally more dwell
+    // time, with a floor of one slot so quiet channels are still sampled
+    void rebalance_adaptive_hop();
+
     // Datasource logging
     int database_log_timer;
     bool database_log_enabled, database_logging;
 
+    // Adaptive hop rebalancing
+    int adaptive_hop_timer;
+    unsigned int adaptive_hop_max_weight;
+
 };
 
 /* This implements the core 'all data' pcap, and pcap filtered by datasource UUID.
@@ -22,8 +22,16 @@
 
 #include <stdio.h>
 #include <time.h>
+#include <sys/resource.h>
+#ifdef SYS_LINUX
+#include <sys/syscall.h>
+#endif
+#include <atomic>
+#include <condition_variable>
 #include <list>
 #include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "kismet_algorithm.h"
@@ -44,12 +52,14 @@
 #include "entrytracker.h"
 #include "devicetracker_component.h"
 #include "json_adapter.h"
+#include "kis_threads.h"
 #include "structured.h"
 #include "kismet_json.h"
 #include "storageloader.h"
 #include "base64.h"
 #include "kis_datasource.h"
 #include "kis_databaselogfile.h"
+#include "logtracker.h"
 
 #include "zstr.hpp"
 
@@ -69,8 +79,9 @@ void kis_tracked_device_base::inc_frequency_count(double frequency) {
     }
 }
 
-void kis_tracked_device_base::inc_seenby_count(KisDatasource *source, 
-        time_t tv_sec, int frequency, Packinfo_Sig_Combo *siginfo) {
+void kis_tracked_device_base::inc_seenby_count(KisDatasource *source,
+        time_t tv_sec, int frequency, Packinfo_Sig_Combo *siginfo,
+        unsigned int max_frequencies, unsigned int band_khz) {
     TrackerElement::map_iterator seenby_iter;
     std::shared_ptr<kis_tracked_seenby_data> seenby;
 
@@ -83,28 +94,19 @@ void kis_tracked_device_base::inc_seenby_count(KisDatasource *source,
         seenby->set_src_uuid(source->get_source_uuid());
         seenby->set_first_time(tv_sec);
         seenby->set_last_time(tv_sec);
-        seenby->set_num_packets(1);
-
-        if (frequency > 0)
-            seenby->inc_frequency_count(frequency);
-
-        if (siginfo != NULL)
-            (*(seenby->get_signal_data())) += *siginfo;
 
         seenby_map->add_intmap(source->get_source_key(), seenby);
-
     } else {
         seenby = std::static_pointer_cast<kis_tracked_seenby_data>(seenby_iter->second);
+    }
 
-        seenby->set_last_time(tv_sec);
-        seenby->inc_num_packets();
-
-        if (frequency > 0)
-            seenby->inc_frequency_count(frequency);
+    // Time, packet count, and the frequency histogram are staged in plain
+    // accumulators inside the seenby record and merged into the tracked
+    // fields when the device is serialized
+    seenby->stage_update(tv_sec, frequency, max_frequencies, band_khz);
 
-        if (siginfo != NULL)
-            (*(seenby->get_signal_data())) += *siginfo;
-    }
+    if (siginfo != NULL)
+        (*(seenby->get_signal_data())) += *siginfo;
 }
 
 void kis_tracked_device_base::register_fields() {
@@ -253,32 +255,42 @@ void kis_tracked_device_base::reserve_fields(SharedTrackerElement e) {
             signal_data.reset(new kis_tracked_signal_data(globalreg, signal_data_id,
                     e->get_map_value(signal_data_id)));
 
-            location.reset(new kis_tracked_location(globalreg, location_id,
-                    e->get_map_value(location_id)));
-
-            location_cloud.reset(new kis_location_history(globalreg, location_cloud_id,
-                    e->get_map_value(location_cloud_id)));
-
             packets_rrd.reset(new kis_tracked_rrd<>(globalreg,
                     packets_rrd_id, e->get_map_value(packets_rrd_id)));
 
-            data_rrd.reset(new kis_tracked_rrd<>(globalreg,
-                    data_rrd_id, e->get_map_value(data_rrd_id)));
+            // Only re-inflate the optional subtrees present in the stored
+            // record; the dynamic proxies materialize the rest on demand
+            if (e->get_map_value(location_id) != NULL)
+                location.reset(new kis_tracked_location(globalreg, location_id,
+                        e->get_map_value(location_id)));
+
+            if (e->get_map_value(location_cloud_id) != NULL)
+                location_cloud.reset(new kis_location_history(globalreg, location_cloud_id,
+                        e->get_map_value(location_cloud_id)));
 
-            packet_rrd_bin_250.reset(new kis_tracked_minute_rrd<>(globalreg,
-                    packet_rrd_bin_250_id, e->get_map_value(packet_rrd_bin_250_id)));
+            if (e->get_map_value(data_rrd_id) != NULL)
+                data_rrd.reset(new kis_tracked_rrd<>(globalreg,
+                        data_rrd_id, e->get_map_value(data_rrd_id)));
 
-            packet_rrd_bin_500.reset(new kis_tracked_minute_rrd<>(globalreg,
-                    packet_rrd_bin_500_id, e->get_map_value(packet_rrd_bin_500_id)));
+            if (e->get_map_value(packet_rrd_bin_250_id) != NULL)
+                packet_rrd_bin_250.reset(new kis_tracked_minute_rrd<>(globalreg,
+                        packet_rrd_bin_250_id, e->get_map_value(packet_rrd_bin_250_id)));
 
-            packet_rrd_bin_1000.reset(new kis_tracked_minute_rrd<>(globalreg,
-                    packet_rrd_bin_1000_id, e->get_map_value(packet_rrd_bin_1000_id)));
+            if (e->get_map_value(packet_rrd_bin_500_id) != NULL)
+                packet_rrd_bin_500.reset(new kis_tracked_minute_rrd<>(globalreg,
+                        packet_rrd_bin_500_id, e->get_map_value(packet_rrd_bin_500_id)));
 
-            packet_rrd_bin_1500.reset(new kis_tracked_minute_rrd<>(globalreg,
-                    packet_rrd_bin_1500_id, e->get_map_value(packet_rrd_bin_1500_id)));
+            if (e->get_map_value(packet_rrd_bin_1000_id) != NULL)
+                packet_rrd_bin_1000.reset(new kis_tracked_minute_rrd<>(globalreg,
+                        packet_rrd_bin_1000_id, e->get_map_value(packet_rrd_bin_1000_id)));
 
-            packet_rrd_bin_jumbo.reset(new kis_tracked_minute_rrd<>(globalreg,
-                    packet_rrd_bin_jumbo_id, e->get_map_value(packet_rrd_bin_jumbo_id)));
+            if (e->get_map_value(packet_rrd_bin_1500_id) != NULL)
+                packet_rrd_bin_1500.reset(new kis_tracked_minute_rrd<>(globalreg,
+                        packet_rrd_bin_1500_id, e->get_map_value(packet_rrd_bin_1500_id)));
+
+            if (e->get_map_value(packet_rrd_bin_jumbo_id) != NULL)
+                packet_rrd_bin_jumbo.reset(new kis_tracked_minute_rrd<>(globalreg,
+                        packet_rrd_bin_jumbo_id, e->get_map_value(packet_rrd_bin_jumbo_id)));
 
             // If we're inheriting, it's our responsibility to kick submaps with
             // complex types as well; since they're not themselves complex objects
@@ -295,17 +307,29 @@ void kis_tracked_device_base::reserve_fields(SharedTrackerElement e) {
             packets_rrd.reset(new kis_tracked_rrd<>(globalreg, packets_rrd_id));
         }
 
-        // add using known fields b/c we might add null
+        // The per-packet fields are always present; the optional subtrees
+        // join the map when they materialize, rather than sitting in every
+        // device as empty placeholder slots.  Most devices are one-frame
+        // probes which never populate them.
         add_map(signal_data_id, signal_data);
-        add_map(location_id, location);
-        add_map(location_cloud_id, location_cloud);
         add_map(packets_rrd_id, packets_rrd);
-        add_map(data_rrd_id, data_rrd);
-        add_map(packet_rrd_bin_250_id, packet_rrd_bin_250);
-        add_map(packet_rrd_bin_500_id, packet_rrd_bin_500);
-        add_map(packet_rrd_bin_1000_id, packet_rrd_bin_1000);
-        add_map(packet_rrd_bin_1500_id, packet_rrd_bin_1500);
-        add_map(packet_rrd_bin_jumbo_id, packet_rrd_bin_jumbo);
+
+        if (location != NULL)
+            add_map(location_id, location);
+        if (location_cloud != NULL)
+            add_map(location_cloud_id, location_cloud);
+        if (data_rrd != NULL)
+            add_map(data_rrd_id, data_rrd);
+        if (packet_rrd_bin_250 != NULL)
+            add_map(packet_rrd_bin_250_id, packet_rrd_bin_250);
+        if (packet_rrd_bin_500 != NULL)
+            add_map(packet_rrd_bin_500_id, packet_rrd_bin_500);
+        if (packet_rrd_bin_1000 != NULL)
+            add_map(packet_rrd_bin_1000_id, packet_rrd_bin_1000);
+        if (packet_rrd_bin_1500 != NULL)
+            add_map(packet_rrd_bin_1500_id, packet_rrd_bin_1500);
+        if (packet_rrd_bin_jumbo != NULL)
+            add_map(packet_rrd_bin_jumbo_id, packet_rrd_bin_jumbo);
 
     }
 
@@ -323,9 +347,16 @@ Devicetracker::Devicetracker(GlobalRegistry *in_globalreg) :
     SharedTrackerElement itve(new TrackerElement(TrackerVector));
     immutable_tracked_vec = TrackerElementVector(itve);
 
+    devicelist_generation = 1;
+    devicelist_snapshot_generation = 0;
+
+    kis_mutex_set_name(&devicelist_mutex, "devicelist");
+
     // Create the pcap httpd
     httpd_pcap.reset(new Devicetracker_Httpd_Pcap(globalreg));
 
+    monitor_timer_id = -1;
+
     entrytracker =
         Globalreg::FetchGlobalAs<EntryTracker>(globalreg, "ENTRY_TRACKER");
 
@@ -333,6 +364,8 @@ Devicetracker::Devicetracker(GlobalRegistry *in_globalreg) :
         entrytracker->RegisterField("kismet.device.base", 
                 std::shared_ptr<kis_tracked_device_base>(new kis_tracked_device_base(globalreg, 0)),
                 "core device record");
+    device_base_prototype.reset(new kis_tracked_device_base(globalreg, device_base_id));
+
     device_list_base_id =
         entrytracker->RegisterField("kismet.device.list",
                 TrackerVector, "list of devices");
@@ -368,6 +401,13 @@ Devicetracker::Devicetracker(GlobalRegistry *in_globalreg) :
         entrytracker->RegisterField("kismet.datatables.draw", TrackerUInt64,
                 "Datatable records draw ID");
 
+    view_devices_id =
+        entrytracker->RegisterField("kismet.deviceview.devices", TrackerVector,
+                "sorted view device page");
+    view_cursor_id =
+        entrytracker->RegisterField("kismet.deviceview.cursor", TrackerString,
+                "sorted view next-page cursor");
+
     packets_rrd.reset(new kis_tracked_rrd<>(globalreg, 0));
     packets_rrd_id =
         globalreg->entrytracker->RegisterField("kismet.device.packets_rrd",
@@ -376,8 +416,18 @@ Devicetracker::Devicetracker(GlobalRegistry *in_globalreg) :
 	num_packets = num_datapackets = num_errorpackets =
 		num_filterpackets = 0;
 
+    for (unsigned int p = 0; p < max_tracked_phys; p++) {
+        phy_counters[p].packets = 0;
+        phy_counters[p].datapackets = 0;
+        phy_counters[p].errorpackets = 0;
+        phy_counters[p].filterpackets = 0;
+    }
+
 	next_phy_id = 0;
 
+    for (unsigned int p = 0; p < max_tracked_phys; p++)
+        phy_handler_array[p] = NULL;
+
     std::shared_ptr<Packetchain> packetchain =
         Globalreg::FetchMandatoryGlobalAs<Packetchain>(globalreg, "PACKETCHAIN");
 
@@ -468,9 +518,11 @@ Devicetracker::Devicetracker(GlobalRegistry *in_globalreg) :
 
                             devices_storing = true;
 
-                            // Run the device storage in its own thread
+                            // Run the device storage in its own thread;
+                            // only devices modified since the last
+                            // checkpoint get rewritten
                             std::thread t([this] {
-                                store_devices(immutable_tracked_vec);
+                                store_devices();
 
                                 {
                                     local_locker l(&storing_mutex);
@@ -612,12 +664,42 @@ Devicetracker::Devicetracker(GlobalRegistry *in_globalreg) :
                 "keep_datasource_signal_history=true", MSGFLAG_INFO);
     }
 
+    max_seenby_frequencies =
+        globalreg->kismet_config->FetchOptUInt("tracker_max_seenby_frequencies", 0);
+    seenby_frequency_band_khz =
+        globalreg->kismet_config->FetchOptUInt("tracker_seenby_frequency_band_khz", 5000);
+
+    if (max_seenby_frequencies != 0) {
+        _MSG("Limiting per-source frequency tracking to " +
+                UIntToString(max_seenby_frequencies) + " frequencies, "
+                "aggregating the remainder into " +
+                UIntToString(seenby_frequency_band_khz) + "KHz bands", MSGFLAG_INFO);
+    }
+
     // Open and upgrade the DB, default path
     Database_Open("");
     Database_UpgradeDB();
+
+    // Spawn the graveyard reaper which drops references to removed
+    // devices outside the device list lock
+    graveyard_sleeping = false;
+    graveyard_shutdown = false;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+
+    pthread_create(&graveyard_thread, &attr, &graveyard_processor, this);
+
+    pthread_attr_destroy(&attr);
 }
 
 Devicetracker::~Devicetracker() {
+    // Stop the graveyard reaper; anything still parked is released on
+    // the main thread below
+    graveyard_shutdown = true;
+    graveyard_condition.unlock(0);
+    pthread_join(graveyard_thread, NULL);
+
     local_eol_locker lock(&devicelist_mutex);
 
     store_all_devices();
@@ -644,6 +726,9 @@ Devicetracker::~Devicetracker() {
         timetracker->RemoveTimer(device_idle_timer);
         timetracker->RemoveTimer(max_devices_timer);
         timetracker->RemoveTimer(device_storage_timer);
+
+        if (monitor_timer_id >= 0)
+            timetracker->RemoveTimer(monitor_timer_id);
     }
 
     // TODO broken for now
@@ -652,30 +737,37 @@ Devicetracker::~Devicetracker() {
 		delete track_filter;
     */
 
-    for (auto p = phy_handler_map.begin(); p != phy_handler_map.end(); ++p) {
-        delete p->second;
+    for (unsigned int p = 0; p < max_tracked_phys; p++) {
+        Kis_Phy_Handler *phyh = phy_handler_array[p].load();
+
+        if (phyh != NULL)
+            delete phyh;
     }
 
     tracked_vec.clear();
     immutable_tracked_vec.clear();
     tracked_mac_multimap.clear();
+    tracked_mac_prefix_index.clear();
+    last_time_index.clear();
 }
 
 Kis_Phy_Handler *Devicetracker::FetchPhyHandler(int in_phy) {
-	std::map<int, Kis_Phy_Handler *>::iterator i = phy_handler_map.find(in_phy);
-
-	if (i == phy_handler_map.end())
-		return NULL;
+    // Phy registration is frozen after startup, so this is a bounds check
+    // and one lock-free load on the per-packet classifier path
+    if (in_phy < 0 || (unsigned int) in_phy >= max_tracked_phys)
+        return NULL;
 
-	return i->second;
+    return phy_handler_array[in_phy].load(std::memory_order_acquire);
 }
 
 Kis_Phy_Handler *Devicetracker::FetchPhyHandlerByName(std::string in_name) {
-    for (auto i = phy_handler_map.begin(); i != phy_handler_map.end(); ++i) {
-        if (i->second->FetchPhyName() == in_name) {
-            return i->second;
-        }
+    for (unsigned int p = 0; p < max_tracked_phys; p++) {
+        Kis_Phy_Handler *phyh = phy_handler_array[p].load(std::memory_order_acquire);
+
+        if (phyh != NULL && phyh->FetchPhyName() == in_name)
+            return phyh;
     }
+
     return NULL;
 }
 
@@ -694,9 +786,14 @@ std::string Devicetracker::FetchPhyName(int in_phy) {
 }
 
 int Devicetracker::FetchNumDevices() {
-    local_locker lock(&devicelist_mutex);
+    int num = 0;
+
+    for (unsigned int s = 0; s < devicemap_shards; s++) {
+        local_locker lock(&(devicemap_mutex[s]));
+        num += tracked_map[s].size();
+    }
 
-    return tracked_map.size();
+    return num;
 }
 
 int Devicetracker::FetchNumPackets() {
@@ -707,15 +804,18 @@ int Devicetracker::FetchNumPackets() {
 int Devicetracker::RegisterPhyHandler(Kis_Phy_Handler *in_weak_handler) {
 	int num = next_phy_id++;
 
+    if ((unsigned int) num >= max_tracked_phys) {
+        _MSG("Devicetracker can only account for " +
+                UIntToString(max_tracked_phys) + " phy handlers; increase "
+                "max_tracked_phys and rebuild.", MSGFLAG_FATAL);
+        globalreg->fatal_condition = 1;
+        return -1;
+    }
+
 	Kis_Phy_Handler *strongphy =
 		in_weak_handler->CreatePhyHandler(globalreg, this, num);
 
-	phy_handler_map[num] = strongphy;
-
-	phy_packets[num] = 0;
-	phy_datapackets[num] = 0;
-	phy_errorpackets[num] = 0;
-	phy_filterpackets[num] = 0;
+    phy_handler_array[num].store(strongphy, std::memory_order_release);
 
 	_MSG("Registered PHY handler '" + strongphy->FetchPhyName() + "' as ID " +
 		 IntToString(num), MSGFLAG_INFO);
@@ -728,19 +828,14 @@ void Devicetracker::UpdateFullRefresh() {
 }
 
 std::shared_ptr<kis_tracked_device_base> Devicetracker::FetchDevice(TrackedDeviceKey in_key) {
-    local_locker lock(&devicelist_mutex);
+    unsigned int shard = DeviceKeyShard(in_key);
 
-	device_itr i = tracked_map.find(in_key);
+    local_locker lock(&(devicemap_mutex[shard]));
 
-	if (i != tracked_map.end())
-		return i->second;
-
-	return NULL;
+	return tracked_map[shard].find(in_key);
 }
 
 int Devicetracker::CommonTracker(kis_packet *in_pack) {
-    local_locker lock(&devicelist_mutex);
-
 	if (in_pack->error) {
 		// and bail
 		num_errorpackets++;
@@ -750,7 +845,11 @@ int Devicetracker::CommonTracker(kis_packet *in_pack) {
 	kis_common_info *pack_common =
 		(kis_common_info *) in_pack->fetch(pack_comp_common);
 
-    packets_rrd->add_sample(1, globalreg->timestamp.tv_sec);
+    {
+        // The RRD isn't atomic; it keeps its own narrow lock
+        local_locker lock(&packet_stats_mutex);
+        packets_rrd->add_sample(1, Timetracker::GetCachedTime());
+    }
 
 	num_packets++;
 
@@ -763,8 +862,8 @@ int Devicetracker::CommonTracker(kis_packet *in_pack) {
 		// and bail
 		num_errorpackets++;
 
-		if (phy_handler_map.find(pack_common->phyid) != phy_handler_map.end()) {
-			phy_errorpackets[pack_common->phyid]++;
+		if (FetchPhyHandler(pack_common->phyid) != NULL) {
+			phy_counters[pack_common->phyid].errorpackets++;
 		}
 
 		return 0;
@@ -775,25 +874,25 @@ int Devicetracker::CommonTracker(kis_packet *in_pack) {
 	}
 
 	// Make sure our PHY is sane
-	if (phy_handler_map.find(pack_common->phyid) == phy_handler_map.end()) {
+	if (FetchPhyHandler(pack_common->phyid) == NULL) {
 		_MSG("Invalid phy id " + IntToString(pack_common->phyid) + " in packet "
 			 "something is wrong.", MSGFLAG_ERROR);
 		return 0;
 	}
 
-	phy_packets[pack_common->phyid]++;
+	phy_counters[pack_common->phyid].packets++;
 
 	if (in_pack->error || pack_common->error) {
-		phy_errorpackets[pack_common->phyid]++;
+		phy_counters[pack_common->phyid].errorpackets++;
 	}
 
 	if (in_pack->filtered) {
-		phy_filterpackets[pack_common->phyid]++;
+		phy_counters[pack_common->phyid].filterpackets++;
 		num_filterpackets++;
 	} else {
 		if (pack_common->type == packet_basic_data) {
 			num_datapackets++;
-			phy_datapackets[pack_common->phyid]++;
+			phy_counters[pack_common->phyid].datapackets++;
 		}
 	}
 
@@ -832,21 +931,31 @@ std::shared_ptr<kis_tracked_device_base>
         if (in_flags & UCD_UPDATE_EXISTING_ONLY)
             return NULL;
 
-        device.reset(new kis_tracked_device_base(globalreg, device_base_id));
-        // Device ID is the size of the vector so a new device always gets put
-        // in it's numbered slot
-        device->set_kis_internal_id(immutable_tracked_vec.size());
+        // In ondemand persistent mode, inflate the stored device on first
+        // touch instead of starting from a blank record; this is a no-op
+        // outside of ondemand mode, and a cheap in-memory index probe for
+        // macs that were never stored
+        if ((device = load_device(in_phy, in_mac)) != NULL) {
+            device->set_kis_internal_id(immutable_tracked_vec.size());
+            device->set_key(key);
+        } else {
+            // Clone the prototype rather than re-running field registration
+            device.reset(new kis_tracked_device_base(globalreg, device_base_prototype.get()));
+            // Device ID is the size of the vector so a new device always gets put
+            // in it's numbered slot
+            device->set_kis_internal_id(immutable_tracked_vec.size());
 
-        device->set_key(key);
-        device->set_macaddr(in_mac);
-        device->set_phyname(in_phy->FetchPhyName());
+            device->set_key(key);
+            device->set_macaddr(in_mac);
+            device->set_phyname(in_phy->FetchPhyName());
 
-        device->set_server_uuid(globalreg->server_uuid);
+            device->set_server_uuid(globalreg->server_uuid);
 
-        device->set_first_time(in_pack->ts.tv_sec);
+            device->set_first_time(in_pack->ts.tv_sec);
 
-        if (globalreg->manufdb != NULL)
-            device->set_manuf(globalreg->manufdb->LookupOUI(in_mac));
+            if (globalreg->manufdb != NULL)
+                device->set_manuf(globalreg->manufdb->LookupOUI(in_mac));
+        }
 
         load_stored_username(device);
         load_stored_tags(device);
@@ -872,13 +981,22 @@ std::shared_ptr<kis_tracked_device_base>
     // Update the mod data
     device->update_modtime();
 
-    if (device->get_last_time() < in_pack->ts.tv_sec)
+    if (device->get_last_time() < in_pack->ts.tv_sec) {
+        time_t old_time = device->get_last_time();
+
         device->set_last_time(in_pack->ts.tv_sec);
 
+        // New devices get indexed when they're inserted into the lists below
+        if (!new_device)
+            UpdateDeviceLastTimeIndex(device, old_time, in_pack->ts.tv_sec);
+    }
+
     if (in_flags & UCD_UPDATE_PACKETS) {
+        time_t rrd_ts = Timetracker::GetCachedTime();
+
         device->inc_packets();
 
-        device->get_packets_rrd()->add_sample(1, globalreg->timestamp.tv_sec);
+        device->get_packets_rrd()->add_sample(1, rrd_ts);
 
         if (pack_common != NULL) {
             if (pack_common->error)
@@ -888,24 +1006,18 @@ std::shared_ptr<kis_tracked_device_base>
                 // TODO fix directional data
                 device->inc_data_packets();
                 device->inc_datasize(pack_common->datasize);
-                device->get_data_rrd()->add_sample(pack_common->datasize,
-                        globalreg->timestamp.tv_sec);
+                device->get_data_rrd()->add_sample(pack_common->datasize, rrd_ts);
 
                 if (pack_common->datasize <= 250)
-                    device->get_packet_rrd_bin_250()->add_sample(1, 
-                            globalreg->timestamp.tv_sec);
+                    device->get_packet_rrd_bin_250()->add_sample(1, rrd_ts);
                 else if (pack_common->datasize <= 500)
-                    device->get_packet_rrd_bin_500()->add_sample(1, 
-                            globalreg->timestamp.tv_sec);
+                    device->get_packet_rrd_bin_500()->add_sample(1, rrd_ts);
                 else if (pack_common->datasize <= 1000)
-                    device->get_packet_rrd_bin_1000()->add_sample(1, 
-                            globalreg->timestamp.tv_sec);
+                    device->get_packet_rrd_bin_1000()->add_sample(1, rrd_ts);
                 else if (pack_common->datasize <= 1500)
-                    device->get_packet_rrd_bin_1500()->add_sample(1, 
-                            globalreg->timestamp.tv_sec);
+                    device->get_packet_rrd_bin_1500()->add_sample(1, rrd_ts);
                 else 
-                    device->get_packet_rrd_bin_jumbo()->add_sample(1, 
-                            globalreg->timestamp.tv_sec);
+                    device->get_packet_rrd_bin_jumbo()->add_sample(1, rrd_ts);
 
             } else if (pack_common->type == packet_basic_mgmt ||
                     pack_common->type == packet_basic_phy) {
@@ -953,24 +1065,22 @@ std::shared_ptr<kis_tracked_device_base>
         // data from swamping the cloud
         if (track_history_cloud && pack_gpsinfo->fix >= 2 &&
                 in_pack->ts.tv_sec - device->get_location_cloud()->get_last_sample_ts() >= 1) {
-            std::shared_ptr<kis_historic_location> histloc(new kis_historic_location(globalreg, 0));
-
-            histloc->set_lat(pack_gpsinfo->lat);
-            histloc->set_lon(pack_gpsinfo->lon);
-            histloc->set_alt(pack_gpsinfo->alt);
-            histloc->set_speed(pack_gpsinfo->speed);
-            histloc->set_heading(pack_gpsinfo->heading);
-
-            histloc->set_time_sec(in_pack->ts.tv_sec);
+            double histfreq = 0;
+            int32_t histsignal = 0;
 
             if (pack_l1info != NULL) {
-                histloc->set_frequency(pack_l1info->freq_khz);
+                histfreq = pack_l1info->freq_khz;
                 if (pack_l1info->signal_dbm != 0)
-                    histloc->set_signal(pack_l1info->signal_dbm);
+                    histsignal = pack_l1info->signal_dbm;
                 else
-                    histloc->set_signal(pack_l1info->signal_rssi);
+                    histsignal = pack_l1info->signal_rssi;
             }
 
+            kis_historic_location_packed histloc;
+            histloc.pack(pack_gpsinfo->lat, pack_gpsinfo->lon, pack_gpsinfo->alt,
+                    pack_gpsinfo->speed, pack_gpsinfo->heading, histfreq,
+                    histsignal, in_pack->ts.tv_sec);
+
             device->get_location_cloud()->add_sample(histloc);
         }
     }
@@ -989,7 +1099,8 @@ std::shared_ptr<kis_tracked_device_base>
             sc = new Packinfo_Sig_Combo(pack_l1info, pack_gpsinfo);
         }
 
-        device->inc_seenby_count(pack_datasrc->ref_source, in_pack->ts.tv_sec, f, sc);
+        device->inc_seenby_count(pack_datasrc->ref_source, in_pack->ts.tv_sec, f, sc,
+                max_seenby_frequencies, seenby_frequency_band_khz);
 
         if (sc != NULL)
             delete(sc);
@@ -1001,42 +1112,176 @@ std::shared_ptr<kis_tracked_device_base>
     // Add the new device at the end once we've populated it
     if (new_device) {
         local_locker devlocker(&devicelist_mutex);
-        tracked_map[key] = device;
+
+        {
+            unsigned int shard = DeviceKeyShard(key);
+            local_locker shardlocker(&(devicemap_mutex[shard]));
+            tracked_map[shard].insert(key, device);
+        }
+
         tracked_vec.push_back(device);
         immutable_tracked_vec.push_back(device);
         tracked_mac_multimap.emplace(in_mac, device);
+        tracked_mac_prefix_index.emplace(in_mac.longmac, device);
+
+        UpdateDeviceLastTimeIndex(device, 0, device->get_last_time());
+
+        devicelist_generation++;
     }
 
     return device;
 }
 
+void Devicetracker::UpdateDeviceLastTimeIndex(std::shared_ptr<kis_tracked_device_base> in_dev,
+        time_t in_old, time_t in_new) {
+    local_locker lock(&last_time_index_mutex);
+
+    auto oi = last_time_index.find(in_old);
+
+    if (oi != last_time_index.end()) {
+        oi->second.erase(in_dev->get_key());
+
+        if (oi->second.size() == 0)
+            last_time_index.erase(oi);
+    }
+
+    last_time_index[in_new][in_dev->get_key()] = in_dev;
+}
+
+void Devicetracker::RemoveDeviceLastTimeIndex(std::shared_ptr<kis_tracked_device_base> in_dev) {
+    local_locker lock(&last_time_index_mutex);
+
+    auto oi = last_time_index.find(in_dev->get_last_time());
+
+    if (oi != last_time_index.end()) {
+        oi->second.erase(in_dev->get_key());
+
+        if (oi->second.size() == 0)
+            last_time_index.erase(oi);
+    }
+}
+
+SharedTrackerElement Devicetracker::FetchDevicesSince(time_t in_ts) {
+    SharedTrackerElement devvec(new TrackerElement(TrackerVector));
+
+    local_locker lock(&last_time_index_mutex);
+
+    for (auto bi = last_time_index.upper_bound(in_ts);
+            bi != last_time_index.end(); ++bi) {
+        for (auto di : bi->second)
+            devvec->add_vector(di.second);
+    }
+
+    return devvec;
+}
+
 // Sort based on internal kismet ID
 bool devicetracker_sort_internal_id(std::shared_ptr<kis_tracked_device_base> a,
 	std::shared_ptr<kis_tracked_device_base> b) {
 	return a->get_kis_internal_id() < b->get_kis_internal_id();
 }
 
-void Devicetracker::MatchOnDevices(DevicetrackerFilterWorker *worker, 
+void Devicetracker::MatchOnDevices(DevicetrackerFilterWorker *worker,
         TrackerElementVector vec, bool batch) {
 
-    kismet__for_each(vec.begin(), vec.end(), [&](SharedTrackerElement val) {
-                if (val == NULL)
-                    return;
+    // Snapshot the caller-provided subset under the list lock; matching
+    // runs against the stable snapshot, so a device insert from the packet
+    // path can't reallocate the vector out from under the match threads
+    // and no devicetracker-wide lock is held while the workers run
+    std::shared_ptr<std::vector<SharedTrackerElement> > snapshot(
+            new std::vector<SharedTrackerElement>());
+    {
+        local_locker lock(&devicelist_mutex);
+        *snapshot = std::vector<SharedTrackerElement>(vec.begin(), vec.end());
+    }
 
-                std::shared_ptr<kis_tracked_device_base> v = 
-                    std::static_pointer_cast<kis_tracked_device_base>(val);
+    MatchOnDeviceSnapshot(worker, snapshot);
+}
 
-                bool m;
+std::shared_ptr<const std::vector<SharedTrackerElement> >
+Devicetracker::FetchDeviceSnapshot() {
+    local_locker slock(&snapshot_mutex);
 
-                // Lock the device itself inside the worker op
-                {
-                    local_locker devlocker(&(v->device_mutex));
-                    m = worker->MatchDevice(this, v);
-                }
+    uint64_t gen = devicelist_generation.load();
+
+    if (devicelist_snapshot != NULL && devicelist_snapshot_generation == gen)
+        return devicelist_snapshot;
+
+    // Rebuild and publish; mutations take the list lock so the copy is
+    // stable, and a mutation landing between the generation read and the
+    // copy only means the next reader rebuilds again
+    std::shared_ptr<std::vector<SharedTrackerElement> > snapshot(
+            new std::vector<SharedTrackerElement>());
+
+    {
+        local_locker lock(&devicelist_mutex);
+
+        snapshot->reserve(immutable_tracked_vec.size());
 
-                if (m) 
-                    worker->MatchedDevice(v);
-            });
+        for (auto v : immutable_tracked_vec)
+            snapshot->push_back(v);
+    }
+
+    devicelist_snapshot = snapshot;
+    devicelist_snapshot_generation = gen;
+
+    return devicelist_snapshot;
+}
+
+void Devicetracker::MatchOnDeviceSnapshot(DevicetrackerFilterWorker *worker,
+        std::shared_ptr<const std::vector<SharedTrackerElement> > snapshot) {
+
+    // Partition the device list across a pool of match threads; a serial
+    // regex or stringmatch scan over a large list can take seconds.
+    // MatchDevice is called with the device locked and MatchedDevice
+    // serializes internally, so workers see the same semantics they did
+    // under the serial loop; Finalize still runs once on the calling
+    // thread after all matching completes.
+    unsigned int nthreads = std::thread::hardware_concurrency();
+
+    if (nthreads < 1)
+        nthreads = 1;
+
+    // Small lists aren't worth the thread churn
+    if (snapshot->size() < 128)
+        nthreads = 1;
+
+    // Stride the indexes across the threads so a clustered run of
+    // expensive devices doesn't land on a single thread
+    auto match_partial = [&](unsigned int offt) {
+        for (size_t x = offt; x < snapshot->size(); x += nthreads) {
+            SharedTrackerElement val = (*snapshot)[x];
+
+            if (val == NULL)
+                continue;
+
+            std::shared_ptr<kis_tracked_device_base> v =
+                std::static_pointer_cast<kis_tracked_device_base>(val);
+
+            bool m;
+
+            // Lock the device itself inside the worker op
+            {
+                local_locker devlocker(&(v->device_mutex));
+                m = worker->MatchDevice(this, v);
+            }
+
+            if (m)
+                worker->MatchedDevice(v);
+        }
+    };
+
+    if (nthreads == 1) {
+        match_partial(0);
+    } else {
+        std::vector<std::thread> match_threads;
+
+        for (unsigned int t = 0; t < nthreads; t++)
+            match_threads.push_back(std::thread(match_partial, t));
+
+        for (auto& t : match_threads)
+            t.join();
+    }
 
     worker->Finalize(this);
 
@@ -1111,7 +1356,36 @@ void Devicetracker::MatchOnDevices(DevicetrackerFilterWorker *worker,
 }
 
 void Devicetracker::MatchOnDevices(DevicetrackerFilterWorker *worker, bool batch) {
-    MatchOnDevices(worker, immutable_tracked_vec, batch);
+    // Full-list matches run against the published generation snapshot; if
+    // the list hasn't changed since the last query this is copy-free
+    MatchOnDeviceSnapshot(worker, FetchDeviceSnapshot());
+}
+
+std::vector<std::shared_ptr<kis_tracked_device_base> >
+Devicetracker::FetchDevicesByMacPrefix(uint64_t in_term, unsigned int in_len) {
+    std::vector<std::shared_ptr<kis_tracked_device_base> > ret;
+
+    if (in_len == 0 || in_len > MAC_LEN_MAX)
+        return ret;
+
+    // An N-byte prefix owns a contiguous range of longmac keys; shift the
+    // term back up to full address width and take everything below the
+    // next prefix value
+    uint64_t low = in_term << ((MAC_LEN_MAX - in_len) * 8);
+
+    local_locker lock(&devicelist_mutex);
+
+    auto pi = tracked_mac_prefix_index.lower_bound(low);
+
+    // An all-FF term has no successor prefix; run to the end of the index
+    auto pe = tracked_mac_prefix_index.end();
+    if (in_term + 1 < (1ULL << (in_len * 8)))
+        pe = tracked_mac_prefix_index.lower_bound((in_term + 1) << ((MAC_LEN_MAX - in_len) * 8));
+
+    for (; pi != pe; ++pi)
+        ret.push_back(pi->second);
+
+    return ret;
 }
 
 // Simple std::sort comparison function to order by the least frequently
@@ -1129,51 +1403,92 @@ int Devicetracker::timetracker_event(int eventid) {
         time_t ts_now = globalreg->timestamp.tv_sec;
         bool purged = false;
 
-        // Find all eligible devices, remove them from the tracked vec
-        tracked_vec.erase(std::remove_if(tracked_vec.begin(), tracked_vec.end(),
-                [&](std::shared_ptr<kis_tracked_device_base> d) {
-                    // Lock the device itself
-                    local_locker devlocker(&(d->device_mutex));
+        // Harvest expiry candidates from the last_time buckets instead of
+        // sweeping the whole device list; the common tracker re-buckets a
+        // device on activity, so only buckets older than the expiration
+        // window get looked at and an all-active list costs nothing
+        std::vector<std::shared_ptr<kis_tracked_device_base> > candidates;
 
-                    if (ts_now - d->get_last_time() > device_idle_expiration &&
-                            (d->get_packets() < device_idle_min_packets || 
-                             device_idle_min_packets <= 0)) {
-                        device_itr mi = tracked_map.find(d->get_key());
+        {
+            local_locker idxlock(&last_time_index_mutex);
 
-                        if (mi != tracked_map.end())
-                            tracked_map.erase(mi);
+            for (auto bi = last_time_index.begin();
+                    bi != last_time_index.end(); ++bi) {
+                // Buckets are time-ordered; stop at the first live one
+                if (ts_now - bi->first <= device_idle_expiration)
+                    break;
 
-                        // Erase it from the multimap
-                        auto mmp = tracked_mac_multimap.equal_range(d->get_macaddr());
+                for (auto di : bi->second)
+                    candidates.push_back(di.second);
+            }
+        }
 
-                        for (auto mmpi = mmp.first; mmpi != mmp.second; ++mmpi) {
-                            if (mmpi->second->get_key() == d->get_key()) {
-                                tracked_mac_multimap.erase(mmpi);
-                                break;
-                            }
-                        }
+        std::set<TrackedDeviceKey> purge_keys;
+        std::vector<std::shared_ptr<kis_tracked_device_base> > buried;
 
-                        // Forget it from the immutable vec, but keep its 
-                        // position; we need to have vecpos = devid
-                        auto iti = immutable_tracked_vec.begin() + d->get_kis_internal_id();
-                        (*iti).reset();
+        for (auto d : candidates) {
+            // Lock the device itself
+            local_locker devlocker(&(d->device_mutex));
 
+            if (ts_now - d->get_last_time() > device_idle_expiration &&
+                    (d->get_packets() < device_idle_min_packets ||
+                     device_idle_min_packets <= 0)) {
+                unsigned int shard = DeviceKeyShard(d->get_key());
+                local_locker shardlocker(&(devicemap_mutex[shard]));
 
-                        purged = true;
+                tracked_map[shard].erase(d->get_key());
 
-                        // fprintf(stderr, "debug - thinking we're purging %s refcount %d\n", d->get_macaddr().Mac2String().c_str(), d.use_count());
+                // Erase it from the multimap
+                auto mmp = tracked_mac_multimap.equal_range(d->get_macaddr());
 
+                for (auto mmpi = mmp.first; mmpi != mmp.second; ++mmpi) {
+                    if (mmpi->second->get_key() == d->get_key()) {
+                        tracked_mac_multimap.erase(mmpi);
+                        break;
+                    }
+                }
+
+                // And from the prefix index
+                auto pmp = tracked_mac_prefix_index.equal_range(d->get_macaddr().longmac);
 
-                        return true;
+                for (auto pmpi = pmp.first; pmpi != pmp.second; ++pmpi) {
+                    if (pmpi->second->get_key() == d->get_key()) {
+                        tracked_mac_prefix_index.erase(pmpi);
+                        break;
                     }
+                }
+
+                // Forget it from the immutable vec, but keep its 
+                // position; we need to have vecpos = devid
+                auto iti = immutable_tracked_vec.begin() + d->get_kis_internal_id();
+                (*iti).reset();
+
+                RemoveDeviceLastTimeIndex(d);
+
+                purge_keys.insert(d->get_key());
+                buried.push_back(d);
+
+                purged = true;
+            }
+        }
 
-                    return false;
-         
+        // Only pay for a pass over the full vector when something expired
+        if (purged) {
+            tracked_vec.erase(std::remove_if(tracked_vec.begin(), tracked_vec.end(),
+                    [&](std::shared_ptr<kis_tracked_device_base> d) {
+                        return purge_keys.find(d->get_key()) != purge_keys.end();
                     }), tracked_vec.end());
 
-        if (purged)
             UpdateFullRefresh();
 
+            devicelist_generation++;
+
+            // Hand the corpses to the reaper; the references dropped in
+            // this scope are never the last ones so the teardown cost
+            // leaves the timer thread
+            BuryDevices(buried);
+        }
+
     } else if (eventid == max_devices_timer) {
 		local_locker lock(&devicelist_mutex);
 
@@ -1191,18 +1506,36 @@ int Devicetracker::timetracker_event(int eventid) {
 		// Now things start getting expensive.  Start by sorting the
 		// vector of devices - anything else that has to sort the entire list
         // has to sort it themselves
-		kismet__stable_sort(tracked_vec.begin(), tracked_vec.end(), 
+		kismet__stable_sort(tracked_vec.begin(), tracked_vec.end(),
                 devicetracker_sort_lastseen);
 
+        // Spill the least-recently-seen tail to the state store before
+        // dropping it, and register the evictions in the stored key index,
+        // so an evicted device transparently re-inflates with its history
+        // if it reappears; RSS stays bounded without losing continuity
+        if (persistent_storage && statestore != NULL && statestore->Database_Valid()) {
+            SharedTrackerElement spill(new TrackerElement(TrackerVector));
+            TrackerElementVector spillvec(spill);
+
+            for (auto i = tracked_vec.begin() + max_num_devices;
+                    i != tracked_vec.end(); ++i)
+                spillvec.push_back(*i);
+
+            statestore->store_devices(spillvec);
+            statestore->index_devices(spillvec);
+        }
+
+        std::vector<std::shared_ptr<kis_tracked_device_base> > buried;
+
         tracked_vec.erase(std::remove_if(tracked_vec.begin() + max_num_devices, tracked_vec.end(),
                 [&](std::shared_ptr<kis_tracked_device_base> d) {
                     // Lock the device itself
                     local_locker devlocker(&(d->device_mutex));
 
-                    device_itr mi = tracked_map.find(d->get_key());
+                    unsigned int shard = DeviceKeyShard(d->get_key());
+                    local_locker shardlocker(&(devicemap_mutex[shard]));
 
-                    if (mi != tracked_map.end())
-                        tracked_map.erase(mi);
+                    tracked_map[shard].erase(d->get_key());
 
                     // Erase it from the multimap
                     auto mmp = tracked_mac_multimap.equal_range(d->get_macaddr());
@@ -1214,20 +1547,102 @@ int Devicetracker::timetracker_event(int eventid) {
                         }
                     }
 
+                    // And from the prefix index
+                    auto pmp = tracked_mac_prefix_index.equal_range(d->get_macaddr().longmac);
+
+                    for (auto pmpi = pmp.first; pmpi != pmp.second; ++pmpi) {
+                        if (pmpi->second->get_key() == d->get_key()) {
+                            tracked_mac_prefix_index.erase(pmpi);
+                            break;
+                        }
+                    }
+
                     // Forget it from the immutable vec, but keep its 
                     // position; we need to have vecpos = devid
                     auto iti = immutable_tracked_vec.begin() + d->get_kis_internal_id();
                     (*iti).reset();
 
+                    RemoveDeviceLastTimeIndex(d);
+
+                    buried.push_back(d);
+
                     return true;
-         
+
                     }), tracked_vec.end());
+
+        devicelist_generation++;
+
+        BuryDevices(buried);
 	}
 
     // Loop
     return 1;
 }
 
+void Devicetracker::BuryDevices(
+        std::vector<std::shared_ptr<kis_tracked_device_base> >& in_devs) {
+    if (in_devs.size() == 0)
+        return;
+
+    {
+        local_locker lock(&graveyard_mutex);
+
+        for (auto d : in_devs)
+            device_graveyard.push_back(d);
+    }
+
+    in_devs.clear();
+
+    if (graveyard_sleeping)
+        graveyard_condition.unlock(0);
+}
+
+void *Devicetracker::graveyard_processor(void *in_tracker) {
+    Devicetracker *tracker = (Devicetracker *) in_tracker;
+
+    Kis_Thread_Setup(tracker->globalreg, "graveyard", "housekeeping");
+
+#ifdef SYS_LINUX
+    // Reclaiming memory is never urgent; run below everything else
+    setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+#endif
+
+    while (1) {
+        std::vector<std::shared_ptr<kis_tracked_device_base> > dead;
+
+        {
+            local_locker lock(&tracker->graveyard_mutex);
+            dead.swap(tracker->device_graveyard);
+        }
+
+        // The references die here, outside any tracker lock; this is
+        // where the component trees are actually torn down
+        dead.clear();
+
+        if (tracker->graveyard_shutdown)
+            return NULL;
+
+        tracker->graveyard_condition.lock();
+        tracker->graveyard_sleeping.store(true);
+
+        {
+            local_locker lock(&tracker->graveyard_mutex);
+
+            if (tracker->device_graveyard.size() != 0 ||
+                    tracker->graveyard_shutdown) {
+                tracker->graveyard_sleeping.store(false);
+                tracker->graveyard_condition.unlock();
+                continue;
+            }
+        }
+
+        tracker->graveyard_condition.block_until();
+        tracker->graveyard_sleeping.store(false);
+    }
+
+    return NULL;
+}
+
 void Devicetracker::usage(const char *name __attribute__((unused))) {
     printf("\n");
 	printf(" *** Device Tracking Options ***\n");
@@ -1235,6 +1650,231 @@ void Devicetracker::usage(const char *name __attribute__((unused))) {
           );
 }
 
+std::vector<std::shared_ptr<kis_tracked_device_base> > Devicetracker::FetchDeviceListCopy() {
+    local_locker lock(&devicelist_mutex);
+
+    return tracked_vec;
+}
+
+DevicetrackerSortedView::DevicetrackerSortedView(GlobalRegistry *in_globalreg,
+        Devicetracker *in_tracker, std::vector<int> in_path, bool in_descending) {
+    globalreg = in_globalreg;
+    devicetracker = in_tracker;
+    resolved_path = in_path;
+    descending = in_descending;
+    last_refresh = 0;
+}
+
+double DevicetrackerSortedView::device_sort_value(std::shared_ptr<kis_tracked_device_base> in_dev) {
+    SharedTrackerElement e = GetTrackerElementPath(resolved_path, in_dev);
+
+    double v = 0;
+
+    if (e != NULL) {
+        switch (e->get_type()) {
+            case TrackerInt8:
+                v = GetTrackerValue<int8_t>(e);
+                break;
+            case TrackerUInt8:
+                v = GetTrackerValue<uint8_t>(e);
+                break;
+            case TrackerInt16:
+                v = GetTrackerValue<int16_t>(e);
+                break;
+            case TrackerUInt16:
+                v = GetTrackerValue<uint16_t>(e);
+                break;
+            case TrackerInt32:
+                v = GetTrackerValue<int32_t>(e);
+                break;
+            case TrackerUInt32:
+                v = GetTrackerValue<uint32_t>(e);
+                break;
+            case TrackerInt64:
+                v = GetTrackerValue<int64_t>(e);
+                break;
+            case TrackerUInt64:
+                v = GetTrackerValue<uint64_t>(e);
+                break;
+            case TrackerFloat:
+                v = GetTrackerValue<float>(e);
+                break;
+            case TrackerDouble:
+                v = GetTrackerValue<double>(e);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Negate so descending views still page forward through the multimap
+    if (descending)
+        return -v;
+
+    return v;
+}
+
+void DevicetrackerSortedView::UpdateDevice(std::shared_ptr<kis_tracked_device_base> in_dev) {
+    local_locker lock(&view_mutex);
+
+    double v = device_sort_value(in_dev);
+
+    auto pi = device_positions.find(in_dev->get_key());
+
+    if (pi != device_positions.end()) {
+        // Don't touch the order if the value hasn't moved
+        if (pi->second == v)
+            return;
+
+        auto sp = sorted_devices.equal_range(pi->second);
+
+        for (auto si = sp.first; si != sp.second; ++si) {
+            if (si->second->get_key() == in_dev->get_key()) {
+                sorted_devices.erase(si);
+                break;
+            }
+        }
+
+        pi->second = v;
+    } else {
+        device_positions[in_dev->get_key()] = v;
+    }
+
+    sorted_devices.emplace(v, in_dev);
+}
+
+void DevicetrackerSortedView::Refresh() {
+    time_t now = time(0);
+
+    // Any device which changed also advanced its last_time, so the
+    // activity buckets give us exactly the re-position set
+    TrackerElementVector active(devicetracker->FetchDevicesSince(last_refresh - 1));
+
+    for (auto d : active) {
+        if (d == NULL)
+            continue;
+
+        UpdateDevice(std::static_pointer_cast<kis_tracked_device_base>(d));
+    }
+
+    last_refresh = now;
+}
+
+std::string DevicetrackerSortedView::FetchPage(std::string in_cursor, unsigned int in_count,
+        std::vector<std::shared_ptr<kis_tracked_device_base> > &out_vec) {
+    Refresh();
+
+    local_locker lock(&view_mutex);
+
+    auto si = sorted_devices.begin();
+
+    if (in_cursor.length() != 0) {
+        size_t split = in_cursor.find('|');
+
+        if (split == std::string::npos)
+            throw std::runtime_error("expected 'sortval|key' cursor");
+
+        double cv;
+        if (sscanf(in_cursor.substr(0, split).c_str(), "%lf", &cv) != 1)
+            throw std::runtime_error("unparseable cursor sort value");
+
+        TrackedDeviceKey ck(in_cursor.substr(split + 1));
+
+        if (ck.get_error())
+            throw std::runtime_error("unparseable cursor key");
+
+        // Resume after the cursor device; if it moved or expired we resume
+        // from its old position
+        si = sorted_devices.lower_bound(cv);
+
+        while (si != sorted_devices.end() && si->first == cv) {
+            bool was_cursor = (si->second->get_key() == ck);
+
+            ++si;
+
+            if (was_cursor)
+                break;
+        }
+    }
+
+    double last_val = 0;
+    TrackedDeviceKey last_key;
+
+    while (si != sorted_devices.end() && out_vec.size() < in_count) {
+        std::shared_ptr<kis_tracked_device_base> d = si->second;
+
+        // Lazily drop devices expired out of the tracker
+        if (devicetracker->FetchDevice(d->get_key()) == NULL) {
+            device_positions.erase(d->get_key());
+            si = sorted_devices.erase(si);
+            continue;
+        }
+
+        last_val = si->first;
+        last_key = d->get_key();
+
+        out_vec.push_back(d);
+        ++si;
+    }
+
+    // No next page if we drained the view
+    if (out_vec.size() < in_count || si == sorted_devices.end())
+        return "";
+
+    char cbuf[64];
+    snprintf(cbuf, 64, "%.17g|", last_val);
+
+    return std::string(cbuf) + last_key.as_string();
+}
+
+std::shared_ptr<DevicetrackerSortedView> Devicetracker::FetchSortedView(std::string in_field,
+        bool in_descending) {
+    local_locker lock(&sorted_view_mutex);
+
+    std::string viewkey = in_field + (in_descending ? "-" : "+");
+
+    auto vi = sorted_views.find(viewkey);
+
+    if (vi != sorted_views.end())
+        return vi->second;
+
+    std::vector<int> path;
+
+    for (auto p : StrTokenize(in_field, "/")) {
+        if (p.length() == 0)
+            continue;
+
+        int id = entrytracker->GetFieldId(p);
+
+        if (id < 0)
+            throw std::runtime_error("unknown field in view path: " + p);
+
+        path.push_back(id);
+    }
+
+    std::shared_ptr<DevicetrackerSortedView> view(new DevicetrackerSortedView(globalreg,
+                this, path, in_descending));
+
+    // Seed with the current population; after this the view refreshes
+    // incrementally from the activity buckets
+    {
+        local_locker listlock(&devicelist_mutex);
+
+        for (auto v : immutable_tracked_vec) {
+            if (v == NULL)
+                continue;
+
+            view->UpdateDevice(std::static_pointer_cast<kis_tracked_device_base>(v));
+        }
+    }
+
+    view->last_refresh = time(0);
+
+    sorted_views[viewkey] = view;
+
+    return view;
+}
+
 void Devicetracker::lock_devicelist() {
     local_eol_locker lock(&devicelist_mutex);
 }
@@ -1341,25 +1981,41 @@ void Devicetracker::AddDevice(std::shared_ptr<kis_tracked_device_base> device) {
     // in it's numbered slot
     device->set_kis_internal_id(immutable_tracked_vec.size());
 
-    tracked_map[device->get_key()] = device;
+    {
+        unsigned int shard = DeviceKeyShard(device->get_key());
+        local_locker shardlocker(&(devicemap_mutex[shard]));
+        tracked_map[shard].insert(device->get_key(), device);
+    }
+
     tracked_vec.push_back(device);
     immutable_tracked_vec.push_back(device);
     tracked_mac_multimap.emplace(device->get_macaddr(), device);
+    tracked_mac_prefix_index.emplace(device->get_macaddr().longmac, device);
+
+    UpdateDeviceLastTimeIndex(device, 0, device->get_last_time());
+
+    devicelist_generation++;
 }
 
 int Devicetracker::store_devices() {
     SharedTrackerElement devs(new TrackerElement(TrackerVector));
     TrackerElementVector dv(devs);
 
-    // Find anything that has changed
-    for (auto v : immutable_tracked_vec) {
-        if (v == NULL)
-            continue;
+    // Snapshot the dirty set under the list lock; the serialization
+    // itself happens on the storage thread against the snapshot
+    {
+        local_locker lock(&devicelist_mutex);
 
-        std::shared_ptr<kis_tracked_device_base> kdb =
-            std::static_pointer_cast<kis_tracked_device_base>(v);
-        if (kdb->get_mod_time() > last_database_logged)
-            dv.push_back(v);
+        // Find anything that has changed since the last checkpoint
+        for (auto v : immutable_tracked_vec) {
+            if (v == NULL)
+                continue;
+
+            std::shared_ptr<kis_tracked_device_base> kdb =
+                std::static_pointer_cast<kis_tracked_device_base>(v);
+            if (kdb->get_mod_time() > last_devicelist_saved)
+                dv.push_back(v);
+        }
     }
 
     last_devicelist_saved = time(0);
@@ -1389,15 +2045,28 @@ void Devicetracker::databaselog_write_devices() {
     SharedTrackerElement devs(new TrackerElement(TrackerVector));
     TrackerElementVector dv(devs);
 
-    // Find anything that has changed
+    // Find anything that has changed; the generation counter catches any
+    // mutation of the record tree, including nested records which don't
+    // touch the top-level mod time.  Devices which haven't changed keep
+    // their row from the previous snapshot as their checkpoint.
     for (auto v : immutable_tracked_vec) {
         if (v == NULL)
             continue;
 
         std::shared_ptr<kis_tracked_device_base> kdb =
             std::static_pointer_cast<kis_tracked_device_base>(v);
-        if (kdb->get_mod_time() > last_database_logged)
-            dv.push_back(v);
+
+        uint64_t gen = kdb->tree_generation();
+
+        if (gen == kdb->get_databaselog_generation())
+            continue;
+
+        // Stamp the pre-serialization generation; if the device mutates
+        // between here and serialization the worst case is an extra copy
+        // in the next snapshot, never a missed change
+        kdb->set_databaselog_generation(gen);
+
+        dv.push_back(v);
     }
 
     last_database_logged = time(0);
@@ -1412,14 +2081,15 @@ void Devicetracker::databaselog_write_all_devices() {
 }
 
 void Devicetracker::databaselog_write_devices(TrackerElementVector vec) {
-    std::shared_ptr<KisDatabaseLogfile> dbf =
-        Globalreg::FetchGlobalAs<KisDatabaseLogfile>(globalreg, "DATABASELOG");
-    
-    if (dbf == NULL)
+    std::shared_ptr<LogTracker> logtracker =
+        Globalreg::FetchGlobalAs<LogTracker>(globalreg, "LOGTRACKER");
+
+    if (logtracker == NULL)
         return;
 
-    // Fire off a database log
-    dbf->log_devices(vec);
+    // Hand the snapshot to the log tracker fan-out, which serializes each
+    // device once and feeds every open device-accepting log
+    logtracker->log_device_snapshot(vec);
 }
 
 int Devicetracker::load_devices() {
@@ -1428,15 +2098,20 @@ int Devicetracker::load_devices() {
     // be quiet during startup; we don't want a long load process to break the
     // mutex timers
 
-    if (!persistent_storage || persistent_mode != MODE_ONSTART || statestore == NULL)
+    if (!persistent_storage || statestore == NULL)
         return 0;
 
     if (!Database_Valid())
         return 0;
 
     int r;
-    
-    r = statestore->load_devices();
+
+    if (persistent_mode == MODE_ONSTART)
+        r = statestore->load_devices();
+    else if (persistent_mode == MODE_ONDEMAND)
+        r = statestore->load_device_index();
+    else
+        return 0;
 
     if (r < 0)
         return r;
@@ -1451,7 +2126,9 @@ int Devicetracker::load_devices() {
 std::shared_ptr<kis_tracked_device_base> Devicetracker::load_device(Kis_Phy_Handler *in_phy,
         mac_addr in_mac) {
 
-    if (!persistent_storage || persistent_mode != MODE_ONDEMAND || statestore == NULL)
+    // Not gated on ondemand mode; spilled LRU evictions register in the
+    // stored key index in any mode and re-inflate when they reappear
+    if (!persistent_storage || statestore == NULL)
         return NULL;
 
     if (!statestore->Database_Valid())
@@ -1496,8 +2173,12 @@ Devicetracker::convert_stored_device(mac_addr macaddr,
             kdb(new kis_tracked_device_base(globalreg, device_base_id, e));
 
         // Give all the phys a shot at it
-        for (auto p : phy_handler_map)
-            p.second->LoadPhyStorage(e, kdb);
+        for (unsigned int p = 0; p < max_tracked_phys; p++) {
+            Kis_Phy_Handler *phyh = phy_handler_array[p].load();
+
+            if (phyh != NULL)
+                phyh->LoadPhyStorage(e, kdb);
+        }
 
         // Update the server uuid in case we don't have it
         if (kdb->get_server_uuid().error)
@@ -1927,7 +2608,57 @@ int DevicetrackerStateStore::load_devices() {
     _MSG("Loading stored devices.  This may take some time, depending on the speed of "
             "your system and the number of stored devices.", MSGFLAG_INFO);
 
-    unsigned int num_devices = 0;
+    // Inflating the stored records - decompression, JSON parsing, and tree
+    // building - dominates load time, so spread it across a pool of worker
+    // threads and keep this thread stepping the database; a bounded queue
+    // keeps the resident set of undigested blobs small
+    unsigned int n_workers = std::thread::hardware_concurrency();
+    if (n_workers < 1)
+        n_workers = 1;
+
+    std::list<std::pair<mac_addr, std::string> > work_queue;
+    std::mutex work_mutex;
+    std::condition_variable work_cond;
+    std::condition_variable space_cond;
+    bool work_complete = false;
+
+    std::atomic<unsigned int> num_devices;
+    num_devices.store(0);
+
+    auto inflate_worker = [&]() {
+        while (1) {
+            std::pair<mac_addr, std::string> job;
+
+            {
+                std::unique_lock<std::mutex> lk(work_mutex);
+
+                while (work_queue.empty() && !work_complete)
+                    work_cond.wait(lk);
+
+                if (work_queue.empty() && work_complete)
+                    return;
+
+                job = work_queue.front();
+                work_queue.pop_front();
+
+                space_cond.notify_one();
+            }
+
+            std::shared_ptr<kis_tracked_device_base> kdb =
+                devicetracker->convert_stored_device(job.first,
+                        (const unsigned char *) job.second.data(),
+                        job.second.length());
+
+            if (kdb != NULL) {
+                devicetracker->AddDevice(kdb);
+                num_devices++;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < n_workers; t++)
+        workers.push_back(std::thread(inflate_worker));
 
     sqlite3_reset(stmt);
 
@@ -1953,13 +2684,16 @@ int DevicetrackerStateStore::load_devices() {
             rowstr = (const unsigned char *) sqlite3_column_blob(stmt, 1);
             rowlen = sqlite3_column_bytes(stmt, 1);
 
-            // Adopt it into a device
-            std::shared_ptr<kis_tracked_device_base> kdb =
-                devicetracker->convert_stored_device(m, rowstr, rowlen);
+            {
+                std::unique_lock<std::mutex> lk(work_mutex);
 
-            if (kdb != NULL) {
-                devicetracker->AddDevice(kdb);
-                num_devices++;
+                while (work_queue.size() > 4096)
+                    space_cond.wait(lk);
+
+                work_queue.push_back(std::make_pair(m,
+                            std::string((const char *) rowstr, rowlen)));
+
+                work_cond.notify_one();
             }
         } else if (r == SQLITE_DONE) {
             break;
@@ -1970,11 +2704,133 @@ int DevicetrackerStateStore::load_devices() {
         }
     }
 
+    {
+        std::unique_lock<std::mutex> lk(work_mutex);
+        work_complete = true;
+        work_cond.notify_all();
+    }
+
+    for (auto& w : workers)
+        w.join();
+
     sqlite3_finalize(stmt);
 
     return 1;
 }
 
+int DevicetrackerStateStore::load_device_index() {
+    if (!Database_Valid())
+        return 0;
+
+    local_locker dblock(&ds_mutex);
+
+    std::string sql;
+
+    int r;
+    sqlite3_stmt *stmt = NULL;
+    const char *pz = NULL;
+
+    sql =
+        "SELECT devmac, phyname FROM device_storage";
+
+    // If we have a timeout, apply that
+    if (devicetracker->persistent_storage_timeout != 0) {
+        std::stringstream timess;
+
+        timess << sql << " WHERE (last_time > " <<
+            time(0) - devicetracker->persistent_storage_timeout << ")";
+        sql = timess.str();
+    }
+
+    r = sqlite3_prepare(db, sql.c_str(), sql.length(), &stmt, &pz);
+
+    if (r != SQLITE_OK) {
+        _MSG("Devicetracker unable to prepare database query for the stored device "
+                "index in " + ds_dbfile + ":" + std::string(sqlite3_errmsg(db)),
+                MSGFLAG_ERROR);
+        return -1;
+    }
+
+    sqlite3_reset(stmt);
+
+    local_locker idxlock(&index_mutex);
+
+    while (1) {
+        r = sqlite3_step(stmt);
+
+        if (r == SQLITE_ROW) {
+            const unsigned char *rowstr;
+
+            mac_addr m;
+
+            rowstr = sqlite3_column_text(stmt, 0);
+            m = mac_addr((const char *) rowstr);
+
+            if (m.error)
+                continue;
+
+            rowstr = sqlite3_column_text(stmt, 1);
+
+            stored_device_index.emplace(m, std::string((const char *) rowstr));
+        } else if (r == SQLITE_DONE) {
+            break;
+        } else {
+            _MSG("Encountered an error loading the stored device index: " +
+                    std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+            break;
+        }
+    }
+
+    sqlite3_finalize(stmt);
+
+    _MSG("Indexed " + UIntToString(stored_device_index.size()) + " stored devices, "
+            "devices will be loaded from storage as they are seen.", MSGFLAG_INFO);
+
+    return 1;
+}
+
+void DevicetrackerStateStore::index_devices(TrackerElementVector devices) {
+    local_locker idxlock(&index_mutex);
+
+    for (auto v : devices) {
+        if (v == NULL)
+            continue;
+
+        std::shared_ptr<kis_tracked_device_base> kdb =
+            std::static_pointer_cast<kis_tracked_device_base>(v);
+
+        mac_addr m = kdb->get_macaddr();
+        std::string phyname = kdb->get_phyname();
+
+        bool present = false;
+
+        auto range = stored_device_index.equal_range(m);
+
+        for (auto i = range.first; i != range.second; ++i) {
+            if (i->second == phyname) {
+                present = true;
+                break;
+            }
+        }
+
+        if (!present)
+            stored_device_index.emplace(m, phyname);
+    }
+}
+
+bool DevicetrackerStateStore::device_stored(Kis_Phy_Handler *in_phy, mac_addr in_mac) {
+    local_locker idxlock(&index_mutex);
+
+    auto range = stored_device_index.equal_range(in_mac);
+
+    for (auto i = range.first; i != range.second; ++i) {
+        if (i->second == in_phy->FetchPhyName())
+            return true;
+    }
+
+    return false;
+}
+
 // Attempt to load a single device from the database, return NULL if it wasn't found
 // or if there was an error
 std::shared_ptr<kis_tracked_device_base> 
@@ -1982,6 +2838,11 @@ DevicetrackerStateStore::load_device(Kis_Phy_Handler *in_phy, mac_addr in_mac) {
     if (!Database_Valid())
         return NULL;
 
+    // Consult the eagerly-loaded key index before touching the database;
+    // most first-touch macs were never stored and shouldn't cost a query
+    if (!device_stored(in_phy, in_mac))
+        return NULL;
+
     // Lock the database; we're doing a single query
     local_locker dblock(&ds_mutex);
 
@@ -2019,6 +2880,21 @@ DevicetrackerStateStore::load_device(Kis_Phy_Handler *in_phy, mac_addr in_mac) {
             rowstr = (const unsigned char *) sqlite3_column_blob(stmt, 0);
             rowlen = sqlite3_column_bytes(stmt, 0);
 
+            // Drop the key index entry; once the device is tracked we never
+            // come back through here for it
+            {
+                local_locker idxlock(&index_mutex);
+
+                auto range = stored_device_index.equal_range(in_mac);
+
+                for (auto i = range.first; i != range.second; ++i) {
+                    if (i->second == in_phy->FetchPhyName()) {
+                        stored_device_index.erase(i);
+                        break;
+                    }
+                }
+            }
+
             return devicetracker->convert_stored_device(in_mac, rowstr, rowlen);
         } else if (r == SQLITE_DONE) {
             break;
@@ -2062,65 +2938,67 @@ int DevicetrackerStateStore::store_devices(TrackerElementVector devices) {
         return -1;
     }
 
-    // Use a function worker to insert it into the db
-    devicetracker_function_worker fw(globalreg,
-            [this, &stmt] 
-                (Devicetracker *, std::shared_ptr<kis_tracked_device_base> d) -> bool {
-                std::shared_ptr<kis_tracked_device_base> kdb =
-                    std::static_pointer_cast<kis_tracked_device_base>(d);
+    // Iterate the snapshot directly on this (storage) thread; the match
+    // workers now run parallel and can't share the sqlite statement, and
+    // we only need the per-device lock, not the list lock, to pack a
+    // record
 
-                std::string serialstring;
-                std::string macstring;
-                std::string phystring;
+    // Perform the write as a single transaction
+    sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, NULL);
 
-                // Prep the compression buf
-                std::stringbuf sbuf;
-                zstr::ostreambuf zobuf(&sbuf, 1 << 16, true);
-                std::ostream zstream(&zobuf);
+    for (auto v : devices) {
+        if (v == NULL)
+            continue;
 
-                // Standard noncompression buf
-                std::ostream sstream(&sbuf);
+        std::shared_ptr<kis_tracked_device_base> kdb =
+            std::static_pointer_cast<kis_tracked_device_base>(v);
 
-                std::ostream *serialstream;
+        std::string serialstring;
+        std::string macstring;
+        std::string phystring;
 
-                if (devicetracker->persistent_compression)
-                serialstream = &zstream;
-                else
-                    serialstream = &sstream;
+        // Prep the compression buf
+        std::stringbuf sbuf;
+        zstr::ostreambuf zobuf(&sbuf, 1 << 16, true);
+        std::ostream zstream(&zobuf);
 
+        // Standard noncompression buf
+        std::ostream sstream(&sbuf);
 
-                sbuf.str("");
-                sqlite3_reset(stmt);
+        std::ostream *serialstream;
 
-                // Pack a storage formatted blob
-                {
-                    local_locker lock(&(devicetracker->devicelist_mutex));
-                    StorageJsonAdapter::Pack(globalreg, *serialstream, d, NULL);
-                }
+        if (devicetracker->persistent_compression)
+            serialstream = &zstream;
+        else
+            serialstream = &sstream;
 
-                // Sync the buffers
-                zobuf.pubsync();
-                sbuf.pubsync();
+        sbuf.str("");
+        sqlite3_reset(stmt);
 
-                serialstring = sbuf.str();
+        // Pack a storage formatted blob
+        {
+            local_locker devlock(&(kdb->device_mutex));
+            StorageJsonAdapter::Pack(globalreg, *serialstream, v, NULL);
+        }
 
-                macstring = kdb->get_macaddr().Mac2String();
-                phystring = kdb->get_phyname();
+        // Sync the buffers
+        zobuf.pubsync();
+        sbuf.pubsync();
 
-                sqlite3_bind_int(stmt, 1, kdb->get_first_time());
-                sqlite3_bind_int(stmt, 2, kdb->get_mod_time());
-                sqlite3_bind_text(stmt, 3, phystring.c_str(), phystring.length(), 0);
-                sqlite3_bind_text(stmt, 4, macstring.c_str(), macstring.length(), 0);
-                sqlite3_bind_blob(stmt, 5, serialstring.data(), serialstring.length(), 0);
+        serialstring = sbuf.str();
 
-                sqlite3_step(stmt);
+        macstring = kdb->get_macaddr().Mac2String();
+        phystring = kdb->get_phyname();
 
-                return false;
-            }, NULL);
+        sqlite3_bind_int(stmt, 1, kdb->get_first_time());
+        sqlite3_bind_int(stmt, 2, kdb->get_mod_time());
+        sqlite3_bind_text(stmt, 3, phystring.c_str(), phystring.length(), 0);
+        sqlite3_bind_text(stmt, 4, macstring.c_str(), macstring.length(), 0);
+        sqlite3_bind_blob(stmt, 5, serialstring.data(), serialstring.length(), 0);
+
+        sqlite3_step(stmt);
+    }
 
-    // Perform the write as a single transaction
-    sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, NULL);
-    devicetracker->MatchOnDevices(&fw, devices);
     sqlite3_exec(db, "END TRANSACTION", NULL, NULL, NULL);
 
     sqlite3_finalize(stmt);
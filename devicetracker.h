@@ -23,8 +23,10 @@
 
 #include <stdio.h>
 #include <time.h>
+#include <atomic>
 #include <list>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <algorithm>
 #include <string>
@@ -107,6 +109,9 @@ public:
     kis_tracked_device_base(GlobalRegistry *in_globalreg, int in_id) :
         tracker_component(in_globalreg, in_id) {
 
+        cached_json_generation = 0;
+        databaselog_generation = 0;
+
         register_fields();
         reserve_fields(NULL);
     }
@@ -114,10 +119,26 @@ public:
     kis_tracked_device_base(GlobalRegistry *in_globalreg, int in_id,
             SharedTrackerElement e) : tracker_component(in_globalreg, in_id) {
         
+        cached_json_generation = 0;
+        databaselog_generation = 0;
+
         register_fields();
         reserve_fields(e);
     }
 
+    // Prototype-clone constructor; copies the complete field tree of a
+    // fully built device record without going back through the
+    // entrytracker registration machinery for every field
+    kis_tracked_device_base(GlobalRegistry *in_globalreg,
+            kis_tracked_device_base *proto) :
+        tracker_component(in_globalreg, proto->get_id()) {
+
+        cached_json_generation = 0;
+        databaselog_generation = 0;
+
+        clone_from_prototype(proto);
+    }
+
     virtual ~kis_tracked_device_base() { }
 
     virtual SharedTrackerElement clone_type() {
@@ -239,7 +260,8 @@ public:
     }
 
     void inc_seenby_count(KisDatasource *source, time_t tv_sec, int frequency,
-            Packinfo_Sig_Combo *siginfo);
+            Packinfo_Sig_Combo *siginfo, unsigned int max_frequencies,
+            unsigned int band_khz);
 
     __ProxyTrackable(tag_map, TrackerElement, tag_map);
 
@@ -271,6 +293,41 @@ public:
         local_unlocker unlock(&device_mutex);
     }
 
+    // Cached render of the complete device; the web UI polls the same
+    // devices over and over, and most polls hit devices which haven't
+    // changed, so the serialized blob can be reused verbatim while the
+    // tree generation matches.  Emits the cached copy and returns true,
+    // or returns false if the cache is stale
+    bool fetch_cached_json(uint64_t in_generation, std::ostream& stream) {
+        local_locker lock(&device_mutex);
+
+        if (in_generation != 0 && in_generation == cached_json_generation &&
+                cached_json.size() > 0) {
+            stream << cached_json;
+            return true;
+        }
+
+        return false;
+    }
+
+    void store_cached_json(uint64_t in_generation, const std::string& in_json) {
+        local_locker lock(&device_mutex);
+
+        cached_json_generation = in_generation;
+        cached_json = in_json;
+    }
+
+    // Tree generation the last time this device was written to the unified
+    // database log; bookkeeping only, not a tracked field, used by the
+    // devicetracker to skip re-serializing unchanged devices each snapshot
+    uint64_t get_databaselog_generation() {
+        return databaselog_generation;
+    }
+
+    void set_databaselog_generation(uint64_t in_generation) {
+        databaselog_generation = in_generation;
+    }
+
     // Protective per-device mutex, should be managed by pre/post serialization
     // functions, and by anything modifying the device or any of the per-phy records
     // inside it
@@ -280,6 +337,13 @@ protected:
     virtual void register_fields();
     virtual void reserve_fields(SharedTrackerElement e);
 
+    // Serialization cache, reused while the tree generation matches
+    uint64_t cached_json_generation;
+    std::string cached_json;
+
+    // Tree generation at the last database log snapshot
+    uint64_t databaselog_generation;
+
     // Unique, meaningless, incremental ID.  Practically, this is the order
     // in which kismet saw devices; it has no purpose other than a sorting
     // key which will always preserve order - time, etc, will not.  Used for breaking
@@ -409,7 +473,7 @@ public:
 		self_destruct = 1;
 	}
 
-    std::map<mac_addr, std::shared_ptr<kis_tracked_device_base> > devrefs;
+    std::unordered_map<mac_addr, std::shared_ptr<kis_tracked_device_base> > devrefs;
 };
 
 // Filter-handler class.  Subclassed by a filter supplicant to be passed to the
@@ -462,6 +526,11 @@ public:
     // Iterate over all phys and load from the database
     virtual int load_devices();
 
+    // Eagerly load only the mac+phy keys of the stored devices; used in
+    // ondemand mode so the first-touch probe for a never-stored mac is an
+    // in-memory lookup instead of a database query
+    virtual int load_device_index();
+
     // Clear out devices too old
     virtual int clear_old_devices();
 
@@ -472,8 +541,254 @@ public:
     std::shared_ptr<kis_tracked_device_base> load_device(Kis_Phy_Handler *in_phy,
             mac_addr in_mac);
 
+    // Add devices to the stored key index; used when evicted devices are
+    // spilled so they re-inflate if they reappear
+    void index_devices(TrackerElementVector devices);
+
 protected:
+    // Is a device present in the stored key index?
+    bool device_stored(Kis_Phy_Handler *in_phy, mac_addr in_mac);
+
     Devicetracker *devicetracker;
+
+    // Stored device key index, mac to phyname; entries are removed as
+    // devices are inflated
+    std::multimap<mac_addr, std::string> stored_device_index;
+    kis_recursive_timed_mutex index_mutex;
+};
+
+// Incrementally maintained sorted device view.
+//
+// The web UI wants 'top N by X' and paged slices without pulling and
+// sorting the whole device list client-side.  A view keeps devices
+// ordered by a numeric field; instead of re-sorting per query, a
+// refresh repositions only devices active since the last refresh (via
+// the last_time index), so maintenance cost tracks churn rather than
+// population.  Devices expired from the tracker are dropped lazily as
+// pages walk over them.
+//
+// Views are created on demand per (field, direction) by
+// Devicetracker::FetchSortedView; descending views store negated sort
+// values so pagination always walks forward.
+//
+// Page cursors are '<sortval>|<devicekey>' of the last device returned;
+// a device whose sort value moves between pages resumes from its old
+// position, which can skip or repeat a row in a live view - acceptable
+// for UI paging.
+class DevicetrackerSortedView {
+    friend class Devicetracker;
+
+public:
+    DevicetrackerSortedView(GlobalRegistry *in_globalreg, Devicetracker *in_tracker,
+            std::vector<int> in_path, bool in_descending);
+
+    // Insert a device or re-position it after a field change
+    void UpdateDevice(std::shared_ptr<kis_tracked_device_base> in_dev);
+
+    // Fetch a page of up to in_count devices after in_cursor (empty string
+    // for the first page), filling out_vec; returns the cursor for the
+    // next page, or an empty string at the end of the view.  Throws on an
+    // unparseable cursor.
+    std::string FetchPage(std::string in_cursor, unsigned int in_count,
+            std::vector<std::shared_ptr<kis_tracked_device_base> > &out_vec);
+
+protected:
+    // Re-position devices active since the last refresh
+    void Refresh();
+
+    double device_sort_value(std::shared_ptr<kis_tracked_device_base> in_dev);
+
+    GlobalRegistry *globalreg;
+    Devicetracker *devicetracker;
+
+    std::vector<int> resolved_path;
+    bool descending;
+
+    std::multimap<double, std::shared_ptr<kis_tracked_device_base> > sorted_devices;
+    std::unordered_map<TrackedDeviceKey, double> device_positions;
+
+    time_t last_refresh;
+
+    kis_recursive_timed_mutex view_mutex;
+};
+
+// Open-addressing hash index for device lookup.
+//
+// Resolving a MAC to a device record happens for every packet, and the
+// tree-based key maps paid a pointer-chasing traversal per lookup.  The
+// device key carries its mixed hash precomputed at construction (see
+// TrackedDeviceKey::mix_hash), so a probe is an index, a compare, and a
+// return, with no comparison chain; the table linear-probes a flat
+// power-of-two slot array, leaves tombstones on erase, and rehashes
+// (dropping tombstones) at 3/4 load.  Not internally locked; callers
+// hold the shard mutex.
+class DeviceKeyHashIndex {
+public:
+    DeviceKeyHashIndex() {
+        slots.resize(1024);
+        nelem = 0;
+        ntombstone = 0;
+    }
+
+    std::shared_ptr<kis_tracked_device_base> find(const TrackedDeviceKey& in_key) const {
+        size_t mask = slots.size() - 1;
+        size_t pos = (size_t) in_key.get_hkey() & mask;
+
+        for (size_t probe = 0; probe < slots.size(); probe++) {
+            const hash_slot& s = slots[pos];
+
+            if (s.state == slot_empty)
+                return NULL;
+
+            if (s.state == slot_full && s.spkey == in_key.get_spkey() &&
+                    s.dkey == in_key.get_dkey())
+                return s.device;
+
+            pos = (pos + 1) & mask;
+        }
+
+        return NULL;
+    }
+
+    void insert(const TrackedDeviceKey& in_key,
+            std::shared_ptr<kis_tracked_device_base> in_dev) {
+        if ((nelem + ntombstone + 1) * 4 >= slots.size() * 3)
+            rehash(slots.size() * 2);
+
+        size_t mask = slots.size() - 1;
+        size_t pos = (size_t) in_key.get_hkey() & mask;
+        size_t first_tombstone = slots.size();
+
+        while (1) {
+            hash_slot& s = slots[pos];
+
+            if (s.state == slot_full && s.spkey == in_key.get_spkey() &&
+                    s.dkey == in_key.get_dkey()) {
+                s.device = in_dev;
+                return;
+            }
+
+            if (s.state == slot_tombstone && first_tombstone == slots.size())
+                first_tombstone = pos;
+
+            if (s.state == slot_empty) {
+                // Prefer re-filling the first tombstone we probed past
+                if (first_tombstone != slots.size()) {
+                    pos = first_tombstone;
+                    ntombstone--;
+                }
+
+                slots[pos].spkey = in_key.get_spkey();
+                slots[pos].dkey = in_key.get_dkey();
+                slots[pos].device = in_dev;
+                slots[pos].state = slot_full;
+                nelem++;
+                return;
+            }
+
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    void erase(const TrackedDeviceKey& in_key) {
+        size_t mask = slots.size() - 1;
+        size_t pos = (size_t) in_key.get_hkey() & mask;
+
+        for (size_t probe = 0; probe < slots.size(); probe++) {
+            hash_slot& s = slots[pos];
+
+            if (s.state == slot_empty)
+                return;
+
+            if (s.state == slot_full && s.spkey == in_key.get_spkey() &&
+                    s.dkey == in_key.get_dkey()) {
+                s.device.reset();
+                s.state = slot_tombstone;
+                nelem--;
+                ntombstone++;
+                return;
+            }
+
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    size_t size() const {
+        return nelem;
+    }
+
+protected:
+    static const uint8_t slot_empty = 0;
+    static const uint8_t slot_full = 1;
+    static const uint8_t slot_tombstone = 2;
+
+    struct hash_slot {
+        hash_slot() {
+            spkey = 0;
+            dkey = 0;
+            state = slot_empty;
+        }
+
+        uint64_t spkey;
+        uint64_t dkey;
+        std::shared_ptr<kis_tracked_device_base> device;
+        uint8_t state;
+    };
+
+    void rehash(size_t newsize) {
+        std::vector<hash_slot> old;
+        old.swap(slots);
+
+        slots.resize(newsize);
+        nelem = 0;
+        ntombstone = 0;
+
+        for (auto si = old.begin(); si != old.end(); ++si) {
+            if (si->state != slot_full)
+                continue;
+
+            insert(TrackedDeviceKey(si->spkey, si->dkey), si->device);
+        }
+    }
+
+    std::vector<hash_slot> slots;
+    size_t nelem;
+    size_t ntombstone;
+};
+
+// Subscription state for the /devices/monitor push stream; one per
+// connected client.  A coalescing timer in the tracker walks the device
+// list and writes a summarized record for anything whose record tree
+// generation has advanced since the subscriber last saw it, so idle
+// clients cost nothing and busy devices collapse to one delta per flush.
+class DevicetrackerMonitorSubscription {
+public:
+    DevicetrackerMonitorSubscription() {
+        streambuf = NULL;
+        rate = 1;
+        last_flush = 0;
+        init_ts = 0;
+    }
+
+    // Stream buffer feeding the client connection; owned by the connection
+    // aux and deleted by its cleanup handler after the subscription has
+    // been deregistered
+    BufferHandlerOStreambuf *streambuf;
+
+    // Field simplification mask requested by the subscriber
+    std::vector<SharedElementSummary> summary_vec;
+
+    // Minimum seconds between flushes
+    unsigned int rate;
+    time_t last_flush;
+
+    // Devices idle since before this time are excluded from the initial
+    // flush; 0 sends the full current state first
+    time_t init_ts;
+
+    // Last record generation pushed to this subscriber, indexed by device
+    // internal id
+    std::vector<uint64_t> seen_generations;
 };
 
 class Devicetracker : public Kis_Net_Httpd_Chain_Stream_Handler,
@@ -531,9 +846,24 @@ public:
 
     // Perform a device filter as above, but provide a source vec rather than the
     // list of ALL devices
-    void MatchOnDevices(DevicetrackerFilterWorker *worker, 
+    void MatchOnDevices(DevicetrackerFilterWorker *worker,
             TrackerElementVector source_vec, bool batch = true);
 
+    // Fetch all devices whose MAC begins with a partial address prepared
+    // with mac_addr::PrepareSearchTerm; resolved as a range scan of the
+    // ordered prefix index, so OUI and prefix searches don't walk the
+    // full device list
+    std::vector<std::shared_ptr<kis_tracked_device_base> >
+        FetchDevicesByMacPrefix(uint64_t in_term, unsigned int in_len);
+
+    // Fetch the published snapshot of the full device list.  Writers bump
+    // the list generation on any mutation and the next reader republishes;
+    // an unchanged list between queries is re-used with no copy and no
+    // list lock.  A pinned snapshot stays valid (and keeps its devices
+    // alive) while the packet path inserts or expires devices, so
+    // serialization never holds the device list lock.
+    std::shared_ptr<const std::vector<SharedTrackerElement> > FetchDeviceSnapshot();
+
 	typedef std::map<TrackedDeviceKey, std::shared_ptr<kis_tracked_device_base> >::iterator device_itr;
 	typedef std::map<TrackedDeviceKey, std::shared_ptr<kis_tracked_device_base> >::const_iterator const_device_itr;
 
@@ -602,6 +932,11 @@ public:
             const char *url, const char *method, const char *upload_data,
             size_t *upload_data_size);
 
+    // Strong validators derived from the device generation counters, so
+    // the UI's per-second polls collapse into 304s while nothing changes
+    virtual bool Httpd_GetETag(Kis_Net_Httpd_Connection *connection,
+            const char *url, std::string& in_tag);
+
     virtual int Httpd_PostComplete(Kis_Net_Httpd_Connection *concls);
     
     // Generate a list of all phys, serialized appropriately.  If specified,
@@ -619,6 +954,22 @@ public:
     void lock_devicelist();
     void unlock_devicelist();
 
+    // Fetch (building on first use) an incrementally sorted device view on
+    // a numeric field path; throws on an unknown field
+    std::shared_ptr<DevicetrackerSortedView> FetchSortedView(std::string in_field,
+            bool in_descending);
+
+    // Snapshot copy of the tracked device list.  REST readers sort and
+    // iterate the copy so they never hold devicelist_mutex across
+    // summarization or serialization; the per-device device_mutex still
+    // guards the contents of each record.
+    std::vector<std::shared_ptr<kis_tracked_device_base> > FetchDeviceListCopy();
+
+    // Fetch devices with activity more recent than the given timestamp,
+    // using the last_time bucket index; returns a TrackerVector element.
+    // The UI polls this every second so it must not scan the full list.
+    SharedTrackerElement FetchDevicesSince(time_t in_ts);
+
     std::shared_ptr<kis_tracked_rrd<> > get_packets_rrd() {
         return packets_rrd;
     }
@@ -646,22 +997,38 @@ protected:
 
     // Base IDs for tracker components
     int device_list_base_id, device_base_id, phy_base_id, phy_entry_id;
+
+    // Fully built default device record cloned to make new devices without
+    // re-running per-field registration
+    std::shared_ptr<kis_tracked_device_base> device_base_prototype;
     int device_summary_base_id;
     int device_update_required_id, device_update_timestamp_id;
 
     int dt_length_id, dt_filter_id, dt_draw_id;
 
+    int view_devices_id, view_cursor_id;
+
 	// Total # of packets
-	int num_packets;
-	int num_datapackets;
-	int num_errorpackets;
-	int num_filterpackets;
+	std::atomic<int> num_packets;
+	std::atomic<int> num_datapackets;
+	std::atomic<int> num_errorpackets;
+	std::atomic<int> num_filterpackets;
+
+    // Per-phy packet counters; updated for every packet from the packet
+    // chain so they're lock-free atomics in a fixed array indexed by phy
+    // id, with each phy's counters padded out to a cache line so phys
+    // feeding from different capture threads don't false-share
+    static const unsigned int max_tracked_phys = 32;
+
+    struct phy_packet_counters {
+        std::atomic<int> packets;
+        std::atomic<int> datapackets;
+        std::atomic<int> errorpackets;
+        std::atomic<int> filterpackets;
+        uint8_t pad[64 - (4 * sizeof(std::atomic<int>))];
+    };
 
-	// Per-phy #s of packets
-    std::map<int, int> phy_packets;
-	std::map<int, int> phy_datapackets;
-	std::map<int, int> phy_errorpackets;
-	std::map<int, int> phy_filterpackets;
+    phy_packet_counters phy_counters[max_tracked_phys];
 
     // Total packet history
     int packets_rrd_id;
@@ -689,6 +1056,11 @@ protected:
     bool track_history_cloud;
     bool track_persource_history;
 
+    // Cap on distinct frequencies tracked per seenby source before new
+    // frequencies are aggregated into bands; 0 for unlimited
+    unsigned int max_seenby_frequencies;
+    unsigned int seenby_frequency_band_khz;
+
 	// Common device component
 	int devcomp_ref_common;
 
@@ -696,14 +1068,34 @@ protected:
 	int pack_comp_device, pack_comp_common, pack_comp_basicdata,
 		pack_comp_radiodata, pack_comp_gps, pack_comp_datasrc;
 
-	// Tracked devices
-    std::map<TrackedDeviceKey, std::shared_ptr<kis_tracked_device_base> > tracked_map;
+	// Tracked devices, in flat open-addressed hash tables sharded by
+	// device key hash, so the per-packet lookup and insert path is a
+	// probe of one flat array and doesn't contend with long-running list
+	// scans and serialization holding devicelist_mutex; each shard is
+	// locked independently.  Lock ordering is always devicelist_mutex
+	// before a shard mutex when both are needed.
+    static const unsigned int devicemap_shards = 16;
+
+    kis_recursive_timed_mutex devicemap_mutex[devicemap_shards];
+    DeviceKeyHashIndex tracked_map[devicemap_shards];
+
+    unsigned int DeviceKeyShard(TrackedDeviceKey in_key) {
+        return in_key.get_dkey() % devicemap_shards;
+    }
 	// Vector of tracked devices so we can iterate them quickly
     std::vector<std::shared_ptr<kis_tracked_device_base> > tracked_vec;
     // MAC address lookups are incredibly expensive from the webui if we don't
     // track by map; in theory multiple objects in different PHYs could have the
     // same MAC so it's not a simple 1:1 map
-    std::multimap<mac_addr, std::shared_ptr<kis_tracked_device_base> > tracked_mac_multimap;
+    std::unordered_multimap<mac_addr, std::shared_ptr<kis_tracked_device_base> > tracked_mac_multimap;
+
+    // Ordered companion index to the mac multimap, keyed by the raw
+    // longmac; a partial address of N bytes maps to a contiguous key
+    // range, so prefix (OUI) searches from the UI become a range scan
+    // instead of a stringify-and-substring pass over every device.
+    // Maintained in lockstep with tracked_mac_multimap under the
+    // devicelist mutex.
+    std::multimap<uint64_t, std::shared_ptr<kis_tracked_device_base> > tracked_mac_prefix_index;
 
     // Immutable vector, one entry per device; may never be sorted.  Devices
     // which are removed are set to 'null'.  Each position corresponds to the
@@ -713,17 +1105,92 @@ protected:
 	// Filtering
 	FilterCore *track_filter;
 
-	// Registered PHY types
+	// Registered PHY types; phy ids are small sequential ints assigned at
+	// registration, so handlers live in a fixed array of atomic pointers
+	// sized by max_tracked_phys.  Registration happens during startup and
+	// only ever appends, which makes the per-packet lookup in the
+	// classifier path a bounds check and one lock-free load.
 	int next_phy_id;
-    std::map<int, Kis_Phy_Handler *> phy_handler_map;
+    std::atomic<Kis_Phy_Handler *> phy_handler_array[max_tracked_phys];
 
     // Insert a device directly into the records
     void AddDevice(std::shared_ptr<kis_tracked_device_base> device);
 
+    // Secondary index of devices bucketed by last_time second.  A device
+    // lives in exactly one bucket and is moved when the common tracker
+    // advances its last_time, so 'active since T' queries walk only the
+    // buckets newer than T instead of scanning the whole device list.
+    std::map<time_t, std::unordered_map<TrackedDeviceKey, std::shared_ptr<kis_tracked_device_base> > > last_time_index;
+    kis_recursive_timed_mutex last_time_index_mutex;
+
+    // Sorted views built on demand, keyed by field path + direction
+    std::map<std::string, std::shared_ptr<DevicetrackerSortedView> > sorted_views;
+    kis_recursive_timed_mutex sorted_view_mutex;
+
+    // Compiled summary vectors keyed by the raw field spec; the UI re-uses
+    // the same few field sets for every poll, so repeat requests skip the
+    // parse and field-id resolution entirely
+    std::map<std::string, std::vector<SharedElementSummary> > summary_cache;
+    kis_recursive_timed_mutex summary_cache_mutex;
+
+    // Move a device from the bucket for in_old to the bucket for in_new
+    void UpdateDeviceLastTimeIndex(std::shared_ptr<kis_tracked_device_base> in_dev,
+            time_t in_old, time_t in_new);
+    // Remove a device from the index entirely (timeout / trim)
+    void RemoveDeviceLastTimeIndex(std::shared_ptr<kis_tracked_device_base> in_dev);
+
     kis_recursive_timed_mutex devicelist_mutex;
 
+    // Deferred destruction of removed devices.  Tearing down a large
+    // device component tree releases thousands of shared pointers; doing
+    // that inline in the expiry sweeps stalls the timer thread while the
+    // device list is locked.  Removed devices are parked in the graveyard
+    // and their references dropped by a low-priority background thread.
+    void BuryDevices(std::vector<std::shared_ptr<kis_tracked_device_base> >& in_devs);
+
+    static void *graveyard_processor(void *in_tracker);
+
+    kis_recursive_timed_mutex graveyard_mutex;
+    std::vector<std::shared_ptr<kis_tracked_device_base> > device_graveyard;
+    conditional_locker<int> graveyard_condition;
+    std::atomic<bool> graveyard_sleeping;
+    std::atomic<bool> graveyard_shutdown;
+    pthread_t graveyard_thread;
+
+    // Generation count of the device list, bumped by any insert or purge,
+    // and the published snapshot of the generation it was built against;
+    // see FetchDeviceSnapshot
+    std::atomic<uint64_t> devicelist_generation;
+    uint64_t devicelist_snapshot_generation;
+    std::shared_ptr<const std::vector<SharedTrackerElement> > devicelist_snapshot;
+    kis_recursive_timed_mutex snapshot_mutex;
+
+    // Run the partitioned filter workers over a pinned snapshot
+    void MatchOnDeviceSnapshot(DevicetrackerFilterWorker *worker,
+            std::shared_ptr<const std::vector<SharedTrackerElement> > snapshot);
+
+    // The packet rate RRD is updated for every packet and isn't atomic;
+    // it gets its own narrow lock so the packet chain never has to wait
+    // on devicelist_mutex
+    kis_recursive_timed_mutex packet_stats_mutex;
+
     std::shared_ptr<Devicetracker_Httpd_Pcap> httpd_pcap;
 
+    // Push-stream monitor subscriptions; the flush timer only exists while
+    // at least one subscriber is connected, so an idle server does no
+    // monitor work at all
+    kis_recursive_timed_mutex monitor_mutex;
+    std::vector<std::shared_ptr<DevicetrackerMonitorSubscription> > monitor_subs;
+    int monitor_timer_id;
+
+    // Drop a subscription when its connection closes; cancels the flush
+    // timer when the last subscriber goes away
+    void RemoveMonitorSubscription(DevicetrackerMonitorSubscription *sub);
+
+    // Flush timer callback; writes coalesced change records to each
+    // subscriber which is due for a flush
+    int FlushMonitorSubscriptions();
+
     // Load a specific device
     virtual std::shared_ptr<kis_tracked_device_base> load_device(Kis_Phy_Handler *phy, 
             mac_addr mac);
@@ -906,11 +1373,20 @@ public:
         ~pcre_filter() {
             if (re != NULL)
                 pcre_free(re);
-            if (study != NULL)
+            if (study != NULL) {
+#ifdef PCRE_STUDY_JIT_COMPILE
+                // JIT-studied patterns have to be released via the study API
+                pcre_free_study(study);
+#else
                 pcre_free(study);
+#endif
+            }
         }
 
         std::string target;
+        // Target path resolved to field IDs once at worker creation so
+        // per-device matching doesn't re-tokenize and re-look-up names
+        std::vector<int> resolved_path;
         pcre *re;
         pcre_extra *study;
     };
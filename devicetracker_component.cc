@@ -31,6 +31,7 @@
 #include <pthread.h>
 
 #include "devicetracker_component.h"
+#include "timetracker.h"
 
 kis_tracked_ip_data::kis_tracked_ip_data(GlobalRegistry *in_globalreg, int in_id) : 
     tracker_component(in_globalreg, in_id) {
@@ -80,68 +81,50 @@ SharedTrackerElement kis_tracked_signal_data::clone_type() {
 kis_tracked_signal_data& kis_tracked_signal_data::operator+= (const kis_layer1_packinfo& lay1) {
     if (lay1.signal_type == kis_l1_signal_type_dbm) {
         if (lay1.signal_dbm != 0) {
+            pod_last_signal_dbm = lay1.signal_dbm;
 
-            last_signal_dbm->set((int32_t) lay1.signal_dbm);
+            if (pod_min_signal_dbm == 0 || pod_min_signal_dbm > lay1.signal_dbm)
+                pod_min_signal_dbm = lay1.signal_dbm;
 
-            if ((*min_signal_dbm) == (int32_t) 0 ||
-                    (*min_signal_dbm) > (int32_t) lay1.signal_dbm) {
-                min_signal_dbm->set((int32_t) lay1.signal_dbm);
-            }
-
-            if ((*max_signal_dbm) == (int32_t) 0 ||
-                    (*max_signal_dbm) < (int32_t) lay1.signal_dbm) {
-                max_signal_dbm->set((int32_t) lay1.signal_dbm);
-            }
+            if (pod_max_signal_dbm == 0 || pod_max_signal_dbm < lay1.signal_dbm)
+                pod_max_signal_dbm = lay1.signal_dbm;
         }
 
         if (lay1.noise_dbm != 0) {
-            last_noise_dbm->set((int32_t) lay1.noise_dbm);
+            pod_last_noise_dbm = lay1.noise_dbm;
 
-            if ((*min_noise_dbm) == (int32_t) 0 ||
-                    (*min_noise_dbm) > (int32_t) lay1.noise_dbm) {
-                min_noise_dbm->set((int32_t) lay1.noise_dbm);
-            }
+            if (pod_min_noise_dbm == 0 || pod_min_noise_dbm > lay1.noise_dbm)
+                pod_min_noise_dbm = lay1.noise_dbm;
 
-            if ((*max_noise_dbm) == (int32_t) 0 ||
-                    (*max_noise_dbm) < (int32_t) lay1.noise_dbm) {
-                max_noise_dbm->set((int32_t) lay1.noise_dbm);
-            }
+            if (pod_max_noise_dbm == 0 || pod_max_noise_dbm < lay1.noise_dbm)
+                pod_max_noise_dbm = lay1.noise_dbm;
         }
     } else if (lay1.signal_type == kis_l1_signal_type_rssi) {
         if (lay1.signal_rssi != 0) {
-            last_signal_rssi->set((int32_t) lay1.signal_rssi);
+            pod_last_signal_rssi = lay1.signal_rssi;
 
-            if ((*min_signal_rssi) == (int32_t) 0 ||
-                    (*min_signal_rssi) > (int32_t) lay1.signal_rssi) {
-                min_signal_dbm->set((int32_t) lay1.signal_rssi);
-            }
+            if (pod_min_signal_rssi == 0 || pod_min_signal_rssi > lay1.signal_rssi)
+                pod_min_signal_rssi = lay1.signal_rssi;
 
-            if ((*max_signal_rssi) == (int32_t) 0 ||
-                    (*max_signal_rssi) < (int32_t) lay1.signal_rssi) {
-                max_signal_rssi->set((int32_t) lay1.signal_rssi);
-            }
+            if (pod_max_signal_rssi == 0 || pod_max_signal_rssi < lay1.signal_rssi)
+                pod_max_signal_rssi = lay1.signal_rssi;
         }
 
         if (lay1.noise_rssi != 0) {
-            last_noise_rssi->set((int32_t) lay1.noise_rssi);
+            pod_last_noise_rssi = lay1.noise_rssi;
 
-            if ((*min_noise_rssi) == (int32_t) 0 ||
-                    (*min_noise_rssi) > (int32_t) lay1.noise_rssi) {
-                min_noise_rssi->set((int32_t) lay1.noise_rssi);
-            }
+            if (pod_min_noise_rssi == 0 || pod_min_noise_rssi > lay1.noise_rssi)
+                pod_min_noise_rssi = lay1.noise_rssi;
 
-            if ((*max_noise_rssi) == (int32_t) 0 ||
-                    (*max_noise_rssi) < (int32_t) lay1.noise_rssi) {
-                max_noise_rssi->set((int32_t) lay1.noise_rssi);
-            }
+            if (pod_max_noise_rssi == 0 || pod_max_noise_rssi < lay1.noise_rssi)
+                pod_max_noise_rssi = lay1.noise_rssi;
         }
 
-        (*carrierset) |= (uint64_t) lay1.carrier;
-        (*encodingset) |= (uint64_t) lay1.encoding;
+        pod_carrierset |= (uint64_t) lay1.carrier;
+        pod_encodingset |= (uint64_t) lay1.encoding;
 
-        if ((*maxseenrate) < (double) lay1.datarate) {
-            maxseenrate->set((double) lay1.datarate);
-        }
+        if (pod_maxseenrate < (double) lay1.datarate)
+            pod_maxseenrate = (double) lay1.datarate;
     }
 
     return *this;
@@ -151,86 +134,70 @@ kis_tracked_signal_data& kis_tracked_signal_data::operator+= (const Packinfo_Sig
     if (in.lay1 != NULL) {
         if (in.lay1->signal_type == kis_l1_signal_type_dbm) {
             if (in.lay1->signal_dbm != 0) {
+                pod_last_signal_dbm = in.lay1->signal_dbm;
 
-                last_signal_dbm->set((int32_t) in.lay1->signal_dbm);
+                if (pod_min_signal_dbm == 0 || pod_min_signal_dbm > in.lay1->signal_dbm)
+                    pod_min_signal_dbm = in.lay1->signal_dbm;
 
-                if ((*min_signal_dbm) == (int32_t) 0 ||
-                        (*min_signal_dbm) > (int32_t) in.lay1->signal_dbm) {
-                    min_signal_dbm->set((int32_t) in.lay1->signal_dbm);
-                }
-
-                if ((*max_signal_dbm) == (int32_t) 0 ||
-                        (*max_signal_dbm) < (int32_t) in.lay1->signal_dbm) {
-                    max_signal_dbm->set((int32_t) in.lay1->signal_dbm);
+                if (pod_max_signal_dbm == 0 || pod_max_signal_dbm < in.lay1->signal_dbm) {
+                    pod_max_signal_dbm = in.lay1->signal_dbm;
 
                     if (in.gps != NULL) {
-                        get_peak_loc()->set(in.gps->lat, in.gps->lon, in.gps->alt, 
+                        get_peak_loc()->set(in.gps->lat, in.gps->lon, in.gps->alt,
                                 in.gps->fix);
                     }
                 }
 
-                get_signal_min_rrd()->add_sample(in.lay1->signal_dbm, 
-                        globalreg->timestamp.tv_sec);
+                get_signal_min_rrd()->add_sample(in.lay1->signal_dbm,
+                        Timetracker::GetCachedTime());
             }
 
             if (in.lay1->noise_dbm != 0) {
-                last_noise_dbm->set((int32_t) in.lay1->noise_dbm);
+                pod_last_noise_dbm = in.lay1->noise_dbm;
 
-                if ((*min_noise_dbm) == (int32_t) 0 ||
-                        (*min_noise_dbm) > (int32_t) in.lay1->noise_dbm) {
-                    min_noise_dbm->set((int32_t) in.lay1->noise_dbm);
-                }
+                if (pod_min_noise_dbm == 0 || pod_min_noise_dbm > in.lay1->noise_dbm)
+                    pod_min_noise_dbm = in.lay1->noise_dbm;
 
-                if ((*max_noise_dbm) == (int32_t) 0 ||
-                        (*max_noise_dbm) < (int32_t) in.lay1->noise_dbm) {
-                    max_noise_dbm->set((int32_t) in.lay1->noise_dbm);
-                }
+                if (pod_max_noise_dbm == 0 || pod_max_noise_dbm < in.lay1->noise_dbm)
+                    pod_max_noise_dbm = in.lay1->noise_dbm;
             }
         } else if (in.lay1->signal_type == kis_l1_signal_type_rssi) {
             if (in.lay1->signal_rssi != 0) {
-                last_signal_rssi->set((int32_t) in.lay1->signal_rssi);
+                pod_last_signal_rssi = in.lay1->signal_rssi;
 
-                if ((*min_signal_rssi) == (int32_t) 0 ||
-                        (*min_signal_rssi) > (int32_t) in.lay1->signal_rssi) {
-                    min_signal_dbm->set((int32_t) in.lay1->signal_rssi);
-                }
+                if (pod_min_signal_rssi == 0 || pod_min_signal_rssi > in.lay1->signal_rssi)
+                    pod_min_signal_rssi = in.lay1->signal_rssi;
 
-                if ((*max_signal_rssi) == (int32_t) 0 ||
-                        (*max_signal_rssi) < (int32_t) in.lay1->signal_rssi) {
-                    max_signal_rssi->set((int32_t) in.lay1->signal_rssi);
+                if (pod_max_signal_rssi == 0 || pod_max_signal_rssi < in.lay1->signal_rssi) {
+                    pod_max_signal_rssi = in.lay1->signal_rssi;
 
                     if (in.gps != NULL) {
-                        get_peak_loc()->set(in.gps->lat, in.gps->lon, in.gps->alt, 
+                        get_peak_loc()->set(in.gps->lat, in.gps->lon, in.gps->alt,
                                 in.gps->fix);
                     }
                 }
 
-                get_signal_min_rrd()->add_sample(in.lay1->signal_rssi, 
-                        globalreg->timestamp.tv_sec);
+                get_signal_min_rrd()->add_sample(in.lay1->signal_rssi,
+                        Timetracker::GetCachedTime());
             }
 
             if (in.lay1->noise_rssi != 0) {
-                last_noise_rssi->set((int32_t) in.lay1->noise_rssi);
+                pod_last_noise_rssi = in.lay1->noise_rssi;
 
-                if ((*min_noise_rssi) == (int32_t) 0 ||
-                        (*min_noise_rssi) > (int32_t) in.lay1->noise_rssi) {
-                    min_noise_rssi->set((int32_t) in.lay1->noise_rssi);
-                }
+                if (pod_min_noise_rssi == 0 || pod_min_noise_rssi > in.lay1->noise_rssi)
+                    pod_min_noise_rssi = in.lay1->noise_rssi;
 
-                if ((*max_noise_rssi) == (int32_t) 0 ||
-                        (*max_noise_rssi) < (int32_t) in.lay1->noise_rssi) {
-                    max_noise_rssi->set((int32_t) in.lay1->noise_rssi);
-                }
+                if (pod_max_noise_rssi == 0 || pod_max_noise_rssi < in.lay1->noise_rssi)
+                    pod_max_noise_rssi = in.lay1->noise_rssi;
             }
 
         }
 
-        (*carrierset) |= (uint64_t) in.lay1->carrier;
-        (*encodingset) |= (uint64_t) in.lay1->encoding;
+        pod_carrierset |= (uint64_t) in.lay1->carrier;
+        pod_encodingset |= (uint64_t) in.lay1->encoding;
 
-        if ((*maxseenrate) < (double) in.lay1->datarate) {
-            maxseenrate->set((double) in.lay1->datarate);
-        }
+        if (pod_maxseenrate < (double) in.lay1->datarate)
+            pod_maxseenrate = (double) in.lay1->datarate;
     }
 
     return *this;
@@ -294,24 +261,85 @@ void kis_tracked_signal_data::reserve_fields(SharedTrackerElement e) {
     tracker_component::reserve_fields(e);
 
     if (e != NULL) {
-        peak_loc.reset(new kis_tracked_location_triplet(globalreg, peak_loc_id,
-                    e->get_map_value(peak_loc_id))); 
+        if (e->get_map_value(peak_loc_id) != NULL)
+            peak_loc.reset(new kis_tracked_location_triplet(globalreg, peak_loc_id,
+                        e->get_map_value(peak_loc_id)));
+
+        if (e->get_map_value(signal_min_rrd_id) != NULL)
+            signal_min_rrd.reset(new kis_tracked_minute_rrd<kis_tracked_rrd_peak_signal_aggregator>(globalreg, signal_min_rrd_id, e->get_map_value(signal_min_rrd_id)));
+    }
+
+    // Optional subtrees join the map when they materialize rather than
+    // leaving a placeholder slot in every record
+    if (peak_loc != NULL)
+        add_map(peak_loc_id, peak_loc);
+    if (signal_min_rrd != NULL)
+        add_map(signal_min_rrd_id, signal_min_rrd);
+
+    // Seed the running aggregates from the tracked fields; zero for a new
+    // record, the stored values when re-inflating from storage
+    pod_last_signal_dbm = GetTrackerValue<int32_t>(last_signal_dbm);
+    pod_min_signal_dbm = GetTrackerValue<int32_t>(min_signal_dbm);
+    pod_max_signal_dbm = GetTrackerValue<int32_t>(max_signal_dbm);
+
+    pod_last_noise_dbm = GetTrackerValue<int32_t>(last_noise_dbm);
+    pod_min_noise_dbm = GetTrackerValue<int32_t>(min_noise_dbm);
+    pod_max_noise_dbm = GetTrackerValue<int32_t>(max_noise_dbm);
+
+    pod_last_signal_rssi = GetTrackerValue<int32_t>(last_signal_rssi);
+    pod_min_signal_rssi = GetTrackerValue<int32_t>(min_signal_rssi);
+    pod_max_signal_rssi = GetTrackerValue<int32_t>(max_signal_rssi);
+
+    pod_last_noise_rssi = GetTrackerValue<int32_t>(last_noise_rssi);
+    pod_min_noise_rssi = GetTrackerValue<int32_t>(min_noise_rssi);
+    pod_max_noise_rssi = GetTrackerValue<int32_t>(max_noise_rssi);
+
+    pod_carrierset = GetTrackerValue<uint64_t>(carrierset);
+    pod_encodingset = GetTrackerValue<uint64_t>(encodingset);
+    pod_maxseenrate = GetTrackerValue<double>(maxseenrate);
+}
+
+void kis_tracked_signal_data::pre_serialize() {
+    tracker_component::pre_serialize();
+
+    // Sync the running aggregates into the tracked fields
+    last_signal_dbm->set(pod_last_signal_dbm);
+    min_signal_dbm->set(pod_min_signal_dbm);
+    max_signal_dbm->set(pod_max_signal_dbm);
+
+    last_noise_dbm->set(pod_last_noise_dbm);
+    min_noise_dbm->set(pod_min_noise_dbm);
+    max_noise_dbm->set(pod_max_noise_dbm);
 
-        signal_min_rrd.reset(new kis_tracked_minute_rrd<kis_tracked_rrd_peak_signal_aggregator>(globalreg, signal_min_rrd_id, e->get_map_value(signal_min_rrd_id)));
-    } 
+    last_signal_rssi->set(pod_last_signal_rssi);
+    min_signal_rssi->set(pod_min_signal_rssi);
+    max_signal_rssi->set(pod_max_signal_rssi);
 
-    add_map(peak_loc_id, peak_loc);
-    add_map(signal_min_rrd_id, signal_min_rrd);
+    last_noise_rssi->set(pod_last_noise_rssi);
+    min_noise_rssi->set(pod_min_noise_rssi);
+    max_noise_rssi->set(pod_max_noise_rssi);
+
+    carrierset->set(pod_carrierset);
+    encodingset->set(pod_encodingset);
+    maxseenrate->set(pod_maxseenrate);
 }
 
-kis_tracked_seenby_data::kis_tracked_seenby_data(GlobalRegistry *in_globalreg, int in_id) : 
-    tracker_component(in_globalreg, in_id) { 
+kis_tracked_seenby_data::kis_tracked_seenby_data(GlobalRegistry *in_globalreg, int in_id) :
+    tracker_component(in_globalreg, in_id) {
+    staged_packets = 0;
+    staged_last_time = 0;
+    distinct_freqs = 0;
+
     register_fields();
     reserve_fields(NULL);
-} 
+}
 
-kis_tracked_seenby_data::kis_tracked_seenby_data(GlobalRegistry *in_globalreg, int in_id, 
+kis_tracked_seenby_data::kis_tracked_seenby_data(GlobalRegistry *in_globalreg, int in_id,
         SharedTrackerElement e) : tracker_component(in_globalreg, in_id) {
+    staged_packets = 0;
+    staged_last_time = 0;
+    distinct_freqs = 0;
+
     register_fields();
     reserve_fields(e);
 }
@@ -324,15 +352,87 @@ void kis_tracked_seenby_data::inc_frequency_count(int frequency) {
     TrackerElement::map_iterator i = freq_khz_map->find(frequency);
 
     if (i == freq_khz_map->end()) {
-        SharedTrackerElement e = 
+        SharedTrackerElement e =
             globalreg->entrytracker->GetTrackedInstance(frequency_val_id);
         e->set((uint64_t) 1);
         freq_khz_map->add_intmap(frequency, e);
+        distinct_freqs++;
     } else {
         (*(i->second))++;
     }
 }
 
+void kis_tracked_seenby_data::stage_update(time_t tv_sec, int frequency,
+        unsigned int max_frequencies, unsigned int band_khz) {
+    staged_packets++;
+
+    if (tv_sec > staged_last_time)
+        staged_last_time = tv_sec;
+
+    if (frequency <= 0)
+        return;
+
+    auto si = staged_freq.find(frequency);
+    if (si != staged_freq.end()) {
+        si->second++;
+        return;
+    }
+
+    // A frequency we haven't staged yet; if it's new to the tracked map as
+    // well and we're at the cap, collapse it into its band bucket instead
+    // of growing the map further
+    if (freq_khz_map->find(frequency) == freq_khz_map->end()) {
+        if (max_frequencies != 0 && band_khz != 0 &&
+                distinct_freqs >= max_frequencies) {
+            frequency -= frequency % (int) band_khz;
+
+            si = staged_freq.find(frequency);
+            if (si != staged_freq.end()) {
+                si->second++;
+                return;
+            }
+
+            if (freq_khz_map->find(frequency) == freq_khz_map->end())
+                distinct_freqs++;
+        } else {
+            distinct_freqs++;
+        }
+    }
+
+    staged_freq[frequency] = 1;
+}
+
+void kis_tracked_seenby_data::pre_serialize() {
+    tracker_component::pre_serialize();
+
+    if (staged_packets != 0) {
+        set_num_packets(get_num_packets() + staged_packets);
+        staged_packets = 0;
+    }
+
+    if (staged_last_time > (time_t) get_last_time())
+        set_last_time(staged_last_time);
+
+    if (staged_freq.empty())
+        return;
+
+    for (auto si : staged_freq) {
+        TrackerElement::map_iterator i = freq_khz_map->find(si.first);
+
+        if (i == freq_khz_map->end()) {
+            SharedTrackerElement e =
+                globalreg->entrytracker->GetTrackedInstance(frequency_val_id);
+            e->set((uint64_t) si.second);
+            freq_khz_map->add_intmap(si.first, e);
+        } else {
+            i->second->set((uint64_t)
+                    (GetTrackerValue<uint64_t>(i->second) + si.second));
+        }
+    }
+
+    staged_freq.clear();
+}
+
 void kis_tracked_seenby_data::register_fields() {
     tracker_component::register_fields();
 
@@ -361,11 +461,15 @@ void kis_tracked_seenby_data::register_fields() {
 void kis_tracked_seenby_data::reserve_fields(SharedTrackerElement e) {
     tracker_component::reserve_fields(e);
 
-    if (e != NULL) {
+    if (e != NULL && e->get_map_value(signal_data_id) != NULL) {
         signal_data.reset(new kis_tracked_signal_data(globalreg, signal_data_id,
                     e->get_map_value(signal_data_id)));
     }
 
-    add_map(signal_data_id, signal_data);
+    if (signal_data != NULL)
+        add_map(signal_data_id, signal_data);
+
+    // Seed the cardinality counter when re-inflated from storage
+    distinct_freqs = freq_khz_map->size();
 }
 
@@ -89,25 +89,29 @@ public:
     kis_tracked_signal_data& operator+= (const kis_layer1_packinfo& lay1);
 	kis_tracked_signal_data& operator+= (const Packinfo_Sig_Combo& in);
 
-    __ProxyGet(last_signal_dbm, int32_t, int, last_signal_dbm);
-    __ProxyGet(min_signal_dbm, int32_t, int, min_signal_dbm);
-    __ProxyGet(max_signal_dbm, int32_t, int, max_signal_dbm);
-
-    __ProxyGet(last_noise_dbm, int32_t, int, last_noise_dbm);
-    __ProxyGet(min_noise_dbm, int32_t, int, min_noise_dbm);
-    __ProxyGet(max_noise_dbm, int32_t, int, max_noise_dbm);
-
-    __ProxyGet(last_signal_rssi, int32_t, int, last_signal_rssi);
-    __ProxyGet(min_signal_rssi, int32_t, int, min_signal_rssi);
-    __ProxyGet(max_signal_rssi, int32_t, int, max_signal_rssi);
-
-    __ProxyGet(last_noise_rssi, int32_t, int, last_noise_rssi);
-    __ProxyGet(min_noise_rssi, int32_t, int, min_noise_rssi);
-    __ProxyGet(max_noise_rssi, int32_t, int, max_noise_rssi);
-
-    __ProxyGet(maxseenrate, double, double, maxseenrate);
-    __ProxyGet(encodingset, uint64_t, uint64_t, encodingset);
-    __ProxyGet(carrierset, uint64_t, uint64_t, carrierset);
+    // The running aggregates live in plain fields updated per packet and
+    // are synced into the tracked elements only at serialization time, so
+    // the per-packet cost is a handful of integer compares instead of
+    // TrackerElement set() calls
+    int get_last_signal_dbm() const { return pod_last_signal_dbm; }
+    int get_min_signal_dbm() const { return pod_min_signal_dbm; }
+    int get_max_signal_dbm() const { return pod_max_signal_dbm; }
+
+    int get_last_noise_dbm() const { return pod_last_noise_dbm; }
+    int get_min_noise_dbm() const { return pod_min_noise_dbm; }
+    int get_max_noise_dbm() const { return pod_max_noise_dbm; }
+
+    int get_last_signal_rssi() const { return pod_last_signal_rssi; }
+    int get_min_signal_rssi() const { return pod_min_signal_rssi; }
+    int get_max_signal_rssi() const { return pod_max_signal_rssi; }
+
+    int get_last_noise_rssi() const { return pod_last_noise_rssi; }
+    int get_min_noise_rssi() const { return pod_min_noise_rssi; }
+    int get_max_noise_rssi() const { return pod_max_noise_rssi; }
+
+    double get_maxseenrate() const { return pod_maxseenrate; }
+    uint64_t get_encodingset() const { return pod_encodingset; }
+    uint64_t get_carrierset() const { return pod_carrierset; }
 
     typedef kis_tracked_minute_rrd<kis_tracked_rrd_peak_signal_aggregator> msig_rrd;
     __ProxyDynamicTrackable(signal_min_rrd, msig_rrd, signal_min_rrd, signal_min_rrd_id);
@@ -115,6 +119,8 @@ public:
     __ProxyDynamicTrackable(peak_loc, kis_tracked_location_triplet, 
             peak_loc, peak_loc_id);
 
+    virtual void pre_serialize();
+
 protected:
     virtual void register_fields();
     virtual void reserve_fields(SharedTrackerElement e);
@@ -127,6 +133,15 @@ protected:
     SharedTrackerElement min_signal_rssi, min_noise_rssi;
     SharedTrackerElement max_signal_rssi, max_noise_rssi;
 
+    // Per-packet running aggregates; synced into the tracked elements in
+    // pre_serialize
+    int32_t pod_last_signal_dbm, pod_min_signal_dbm, pod_max_signal_dbm;
+    int32_t pod_last_noise_dbm, pod_min_noise_dbm, pod_max_noise_dbm;
+    int32_t pod_last_signal_rssi, pod_min_signal_rssi, pod_max_signal_rssi;
+    int32_t pod_last_noise_rssi, pod_min_noise_rssi, pod_max_noise_rssi;
+    uint64_t pod_carrierset, pod_encodingset;
+    double pod_maxseenrate;
+
     int peak_loc_id;
     std::shared_ptr<kis_tracked_location_triplet> peak_loc;
 
@@ -146,11 +161,12 @@ public:
 
     virtual SharedTrackerElement clone_type();
 
-    __Proxy(src_uuid, uuid, uuid, uuid, src_uuid);
-    __Proxy(first_time, uint64_t, time_t, time_t, first_time);
-    __Proxy(last_time, uint64_t, time_t, time_t, last_time);
-    __Proxy(num_packets, uint64_t, uint64_t, uint64_t, num_packets);
-    __ProxyIncDec(num_packets, uint64_t, uint64_t, num_packets);
+    // Updated per packet; static dispatch keeps the accessors inline
+    __ProxyStatic(src_uuid, uuid, uuid, uuid, src_uuid);
+    __ProxyStatic(first_time, uint64_t, time_t, time_t, first_time);
+    __ProxyStatic(last_time, uint64_t, time_t, time_t, last_time);
+    __ProxyStatic(num_packets, uint64_t, uint64_t, uint64_t, num_packets);
+    __ProxyStaticIncDec(num_packets, uint64_t, uint64_t, num_packets);
 
     __ProxyTrackable(freq_khz_map, TrackerElement, freq_khz_map);
     __ProxyDynamicTrackable(signal_data, kis_tracked_signal_data,
@@ -158,18 +174,38 @@ public:
 
     void inc_frequency_count(int frequency);
 
+    // Stage a per-packet update (last time, packet count, frequency
+    // histogram) in plain accumulators; staged values are merged into the
+    // tracked fields in pre_serialize, so the packet path never touches
+    // the element tree.  Once max_frequencies distinct frequencies are
+    // tracked, new frequencies are collapsed into band_khz-wide buckets;
+    // 0 for either disables the cap.
+    void stage_update(time_t tv_sec, int frequency,
+            unsigned int max_frequencies, unsigned int band_khz);
+
+    virtual void pre_serialize();
+
 protected:
     virtual void register_fields();
     virtual void reserve_fields(SharedTrackerElement e);
 
     SharedTrackerElement src_uuid;
-    SharedTrackerElement first_time; 
+    SharedTrackerElement first_time;
     SharedTrackerElement last_time;
     SharedTrackerElement num_packets;
 
     SharedTrackerElement freq_khz_map;
     int frequency_val_id;
 
+    // Per-packet staging synced in pre_serialize
+    std::map<int, uint64_t> staged_freq;
+    uint64_t staged_packets;
+    time_t staged_last_time;
+
+    // Distinct frequencies across the tracked map and the staged
+    // accumulator, checked against the configured cap
+    size_t distinct_freqs;
+
     std::shared_ptr<kis_tracked_signal_data> signal_data;
     int signal_data_id;
 };
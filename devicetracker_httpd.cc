@@ -164,6 +164,14 @@ bool Devicetracker::Httpd_VerifyPath(const char *path, const char *method) {
 
             } else if (tokenurl[2] == "summary") {
                 return Httpd_CanSerialize(tokenurl[3]);
+            } else if (tokenurl[2] == "monitor") {
+                // Explicit ekjson; the push stream is a sequence of
+                // records, not a single document
+                return tokenurl[3] == "devices.ekjson";
+            } else if (tokenurl[2] == "multi-key") {
+                return Httpd_CanSerialize(tokenurl[3]);
+            } else if (tokenurl[2] == "views") {
+                return Httpd_CanSerialize(tokenurl[3]);
             } else if (tokenurl[2] == "last-time") {
                 if (tokenurl.size() < 5) {
                     return false;
@@ -264,16 +272,92 @@ void Devicetracker::httpd_all_phys(std::string path, std::ostream &stream,
     anyphy->set_from_phy(this, KIS_PHY_ANY);
     phyvec->add_vector(anyphy);
 
-    std::map<int, Kis_Phy_Handler *>::iterator mi;
-    for (mi = phy_handler_map.begin(); mi != phy_handler_map.end(); ++mi) {
+    for (unsigned int phy = 0; phy < max_tracked_phys; phy++) {
+        if (phy_handler_array[phy].load() == NULL)
+            continue;
+
         std::shared_ptr<kis_tracked_phy> p(new kis_tracked_phy(globalreg, phy_base_id));
-        p->set_from_phy(this, mi->first);
+        p->set_from_phy(this, phy);
         phyvec->add_vector(p);
     }
 
     entrytracker->Serialize(httpd->GetSuffix(path), stream, wrapper, NULL);
 }
 
+bool Devicetracker::Httpd_GetETag(
+        Kis_Net_Httpd_Connection *connection __attribute__((unused)),
+        const char *path, std::string& in_tag) {
+
+    std::vector<std::string> tokenurl = StrTokenize(path, "/");
+
+    // Only tag the simple per-device and by-mac records; field paths and
+    // the firehose endpoints are too varied to validate cheaply
+    if (tokenurl.size() != 5)
+        return false;
+
+    if (tokenurl[1] != "devices")
+        return false;
+
+    if (!Httpd_CanSerialize(tokenurl[4]))
+        return false;
+
+    std::ostringstream tagstream;
+
+    if (tokenurl[2] == "by-key") {
+        if (Httpd_StripSuffix(tokenurl[4]) != "device")
+            return false;
+
+        TrackedDeviceKey key(tokenurl[3]);
+        auto dev = FetchDevice(key);
+
+        if (dev == NULL)
+            return false;
+
+        // Seed with the server start time so a tag from a previous run
+        // can't falsely validate against a fresh generation counter
+        tagstream << "\"" << globalreg->start_time << "-" << tokenurl[3] <<
+            "-" << dev->tree_generation() << "\"";
+
+        in_tag = tagstream.str();
+
+        return true;
+    }
+
+    if (tokenurl[2] == "by-mac") {
+        mac_addr mac = mac_addr(tokenurl[3]);
+
+        if (mac.error)
+            return false;
+
+        // Fold every matching device's generation together; a change in
+        // membership or content changes the tag
+        uint64_t h = (uint64_t) globalreg->start_time;
+        unsigned int matched = 0;
+
+        {
+            local_locker lock(&devicelist_mutex);
+
+            auto mmp = tracked_mac_multimap.equal_range(mac);
+            for (auto mmpi = mmp.first; mmpi != mmp.second; ++mmpi) {
+                h = h * 31 + mmpi->second->tree_generation();
+                h = h * 31 + std::hash<mac_addr>()(mmpi->second->get_macaddr());
+                matched++;
+            }
+        }
+
+        if (matched == 0)
+            return false;
+
+        tagstream << "\"" << tokenurl[3] << "-" << h << "\"";
+
+        in_tag = tagstream.str();
+
+        return true;
+    }
+
+    return false;
+}
+
 int Devicetracker::Httpd_CreateStreamResponse(
         Kis_Net_Httpd *httpd __attribute__((unused)),
         Kis_Net_Httpd_Connection *connection,
@@ -288,12 +372,15 @@ int Devicetracker::Httpd_CreateStreamResponse(
     Kis_Net_Httpd_Buffer_Stream_Aux *saux = 
         (Kis_Net_Httpd_Buffer_Stream_Aux *) connection->custom_extension;
 
-    BufferHandlerOStringStreambuf *streambuf = 
-        new BufferHandlerOStringStreambuf(saux->get_rbhandler());
+    // The streambuf buffers its own put area in chunk units, so the
+    // serializers write straight through to the chainbuf without an
+    // interstitial string cache
+    BufferHandlerOStreambuf *streambuf =
+        new BufferHandlerOStreambuf(saux->get_rbhandler());
     std::ostream stream(streambuf);
 
     // Set our cleanup function
-    saux->set_aux(streambuf, 
+    saux->set_aux(streambuf,
             [](Kis_Net_Httpd_Buffer_Stream_Aux *aux) {
                 if (aux->aux != NULL)
                     delete((BufferHandlerOStreambuf *) (aux->aux));
@@ -303,26 +390,36 @@ int Devicetracker::Httpd_CreateStreamResponse(
     // clean up...
     saux->set_sync([streambuf](Kis_Net_Httpd_Buffer_Stream_Aux *aux) {
             if (aux->aux != NULL) {
-                ((BufferHandlerOStringStreambuf *) aux->aux)->pubsync();
+                ((BufferHandlerOStreambuf *) aux->aux)->pubsync();
                 }
             });
 
 
     if (strcmp(path, "/devices/all_devices.ekjson") == 0) {
         // Instantiate a manual serializer
-        JsonAdapter::Serializer serial(globalreg); 
+        JsonAdapter::Serializer serial(globalreg);
+
+        // Snapshot the device list under the list lock and serialize from
+        // the snapshot in this generator thread; a full dump then holds
+        // each device lock only long enough to write that one device, so
+        // the packet path never stalls behind a slow client
+        std::vector<SharedTrackerElement> snapshot;
+        {
+            local_locker lock(&devicelist_mutex);
+            snapshot = std::vector<SharedTrackerElement>(immutable_tracked_vec.begin(),
+                    immutable_tracked_vec.end());
+        }
 
-        devicetracker_function_worker fw(globalreg, 
-                [this, &stream, &serial](Devicetracker *, std::shared_ptr<kis_tracked_device_base> d) -> bool {
-                    serial.serialize(d, stream);
-                    stream << "\n";
+        for (auto i : snapshot) {
+            std::shared_ptr<kis_tracked_device_base> d =
+                std::static_pointer_cast<kis_tracked_device_base>(i);
 
-                    // Return false because we're not building a list, we're serializing
-                    // per element
-                    return false;
-                }, NULL);
+            local_locker devlocker(&(d->device_mutex));
+
+            serial.serialize(d, stream);
+            stream << "\n";
+        }
 
-        MatchOnDevices(&fw);
         return MHD_YES;
     }
 
@@ -385,6 +482,28 @@ int Devicetracker::Httpd_CreateStreamResponse(
                     return MHD_YES;
                 }
 
+                // The UI polls the complete device record; if nothing in the
+                // tree has changed since the last render, replay the cached
+                // blob instead of re-serializing the whole device
+                if (httpd->GetSuffix(tokenurl[4]) == "json") {
+                    uint64_t gen = dev->tree_generation();
+
+                    if (dev->fetch_cached_json(gen, stream))
+                        return MHD_YES;
+
+                    std::stringstream cachestream;
+
+                    entrytracker->Serialize("json", cachestream, dev, NULL);
+
+                    // Stamp with the post-serialization generation since
+                    // pre_serialize may have updated computed fields
+                    dev->store_cached_json(dev->tree_generation(), cachestream.str());
+
+                    stream << cachestream.rdbuf();
+
+                    return MHD_YES;
+                }
+
                 entrytracker->Serialize(httpd->GetSuffix(tokenurl[4]), stream, dev, NULL);
 
                 return MHD_YES;
@@ -398,8 +517,6 @@ int Devicetracker::Httpd_CreateStreamResponse(
             if (!Httpd_CanSerialize(tokenurl[4]))
                 return MHD_YES;
 
-            local_locker lock(&devicelist_mutex);
-
             mac_addr mac = mac_addr(tokenurl[3]);
 
             if (mac.error) {
@@ -408,9 +525,15 @@ int Devicetracker::Httpd_CreateStreamResponse(
 
             SharedTrackerElement devvec(new TrackerElement(TrackerVector));
 
-            auto mmp = tracked_mac_multimap.equal_range(mac);
-            for (auto mmpi = mmp.first; mmpi != mmp.second; ++mmpi) {
-                devvec->add_vector(mmpi->second);
+            // Copy the matching devices under the list lock, but serialize
+            // them outside it
+            {
+                local_locker lock(&devicelist_mutex);
+
+                auto mmp = tracked_mac_multimap.equal_range(mac);
+                for (auto mmpi = mmp.first; mmpi != mmp.second; ++mmpi) {
+                    devvec->add_vector(mmpi->second);
+                }
             }
 
             entrytracker->Serialize(httpd->GetSuffix(tokenurl[4]), stream, devvec, NULL);
@@ -434,18 +557,8 @@ int Devicetracker::Httpd_CreateStreamResponse(
             if (!Httpd_CanSerialize(tokenurl[4]))
                 return MHD_YES;
 
-            SharedTrackerElement devvec;
-
-            devicetracker_function_worker fw(globalreg, 
-                    [this, &stream, devvec, lastts](Devicetracker *, 
-                        std::shared_ptr<kis_tracked_device_base> d) -> bool {
-                        if (d->get_last_time() <= lastts)
-                            return false;
-
-                        return true;
-                    }, NULL);
-            MatchOnDevices(&fw);
-            devvec = fw.GetMatchedDevices();
+            // Pull from the last_time index rather than scanning the list
+            SharedTrackerElement devvec = FetchDevicesSince(lastts);
 
             entrytracker->Serialize(httpd->GetSuffix(tokenurl[4]), stream, devvec, NULL);
 
@@ -478,7 +591,7 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
     // clean up...
     saux->set_sync([streambuf](Kis_Net_Httpd_Buffer_Stream_Aux *aux) {
             if (aux->aux != NULL) {
-                ((BufferHandlerOStringStreambuf *) aux->aux)->pubsync();
+                ((BufferHandlerOStreambuf *) aux->aux)->pubsync();
                 }
             });
 
@@ -525,12 +638,16 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
             SharedStructured fields = structdata->getStructuredByKey("fields");
             StructuredData::structured_vec fvec = fields->getStructuredArray();
 
-            for (StructuredData::structured_vec::iterator i = fvec.begin(); 
+            // Build a cache key out of the raw field spec; the UI asks for
+            // the same few field sets on every poll, so we almost always get
+            // to re-use an already-compiled summary vector
+            std::string field_cache_key;
+
+            for (StructuredData::structured_vec::iterator i = fvec.begin();
                     i != fvec.end(); ++i) {
                 if ((*i)->isString()) {
-                    SharedElementSummary s(new TrackerElementSummary((*i)->getString(), 
-                                entrytracker));
-                    summary_vec.push_back(s);
+                    field_cache_key += (*i)->getString();
+                    field_cache_key += "\n";
                 } else if ((*i)->isArray()) {
                     StructuredData::string_vec mapvec = (*i)->getStringVec();
 
@@ -541,9 +658,58 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
                         return MHD_YES;
                     }
 
-                    SharedElementSummary s(new TrackerElementSummary(mapvec[0], 
-                                mapvec[1], entrytracker));
-                    summary_vec.push_back(s);
+                    field_cache_key += mapvec[0];
+                    field_cache_key += "\x1e";
+                    field_cache_key += mapvec[1];
+                    field_cache_key += "\n";
+                }
+            }
+
+            {
+                local_locker sc_locker(&summary_cache_mutex);
+
+                auto sci = summary_cache.find(field_cache_key);
+
+                if (sci != summary_cache.end()) {
+                    summary_vec = sci->second;
+                } else {
+                    for (StructuredData::structured_vec::iterator i = fvec.begin();
+                            i != fvec.end(); ++i) {
+                        if ((*i)->isString()) {
+                            SharedElementSummary s(new TrackerElementSummary((*i)->getString(),
+                                        entrytracker));
+                            summary_vec.push_back(s);
+                        } else if ((*i)->isArray()) {
+                            StructuredData::string_vec mapvec = (*i)->getStringVec();
+
+                            SharedElementSummary s(new TrackerElementSummary(mapvec[0],
+                                        mapvec[1], entrytracker));
+                            summary_vec.push_back(s);
+                        }
+                    }
+
+                    // Only cache fully resolved sets; a path which didn't
+                    // resolve may belong to a phy or plugin which hasn't
+                    // registered its fields yet, and we don't want to freeze
+                    // that miss
+                    bool complete = true;
+
+                    for (auto s : summary_vec) {
+                        for (auto id : s->resolved_path) {
+                            if (id < 0) {
+                                complete = false;
+                                break;
+                            }
+                        }
+                    }
+
+                    // Don't let a client cycling through field sets grow the
+                    // cache without bound
+                    if (summary_cache.size() > 32)
+                        summary_cache.clear();
+
+                    if (complete)
+                        summary_cache[field_cache_key] = summary_vec;
                 }
             }
         }
@@ -572,7 +738,63 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
 
     try {
         if (tokenurl[1] == "devices") {
-            if (tokenurl[2] == "by-mac") {
+            if (tokenurl[2] == "monitor") {
+                // Long-lived push stream; the client posts a field mask and
+                // flush rate once, then receives summarized records for
+                // changed devices until it disconnects.  Replaces polling
+                // last-time in a loop.
+                if (tokenurl.size() < 4 || tokenurl[3] != "devices.ekjson") {
+                    stream << "Invalid request";
+                    concls->httpcode = 400;
+                    return MHD_YES;
+                }
+
+                std::shared_ptr<DevicetrackerMonitorSubscription> sub(
+                        new DevicetrackerMonitorSubscription());
+
+                sub->streambuf = streambuf;
+                sub->summary_vec = summary_vec;
+                sub->init_ts = post_ts;
+
+                double req_rate = structdata->getKeyAsNumber("rate", 1);
+                if (req_rate < 1)
+                    req_rate = 1;
+                sub->rate = req_rate;
+
+                {
+                    local_locker lock(&monitor_mutex);
+
+                    monitor_subs.push_back(sub);
+
+                    // Spin up the flush timer with the first subscriber
+                    if (monitor_timer_id < 0) {
+                        std::shared_ptr<Timetracker> timetracker =
+                            Globalreg::FetchGlobalAs<Timetracker>(globalreg, "TIMETRACKER");
+
+                        monitor_timer_id =
+                            timetracker->RegisterTimer(SERVER_TIMESLICES_SEC, NULL, 1,
+                                    [this](int) -> int {
+                                        return FlushMonitorSubscriptions();
+                                    });
+                    }
+                }
+
+                // Replace the default stream cleanup; when the client goes
+                // away the subscription has to be pulled before the
+                // streambuf is destroyed so the flush timer can't write
+                // into a dead buffer
+                DevicetrackerMonitorSubscription *rawsub = sub.get();
+                saux->set_aux(streambuf,
+                        [this, rawsub](Kis_Net_Httpd_Buffer_Stream_Aux *aux) {
+                            RemoveMonitorSubscription(rawsub);
+
+                            if (aux->aux != NULL)
+                                delete((BufferHandlerOStreambuf *) (aux->aux));
+                        });
+
+                // Leave the stream open; the timer feeds it from now on
+                return MHD_NO;
+            } else if (tokenurl[2] == "by-mac") {
                 if (tokenurl.size() < 5) {
                     stream << "Invalid request";
                     concls->httpcode = 400;
@@ -614,14 +836,21 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
                 if (target == "devices") {
                     SharedTrackerElement devvec(new TrackerElement(TrackerVector));
 
+                    // Copy the matching devices while locked; holding the
+                    // iterators across the unlock isn't safe, and we don't
+                    // want to summarize under the list lock
+                    std::vector<std::shared_ptr<kis_tracked_device_base> > matchvec;
+
                     lock.lock();
                     auto mmp = tracked_mac_multimap.equal_range(mac);
+                    for (auto mmpi = mmp.first; mmpi != mmp.second; ++mmpi)
+                        matchvec.push_back(mmpi->second);
                     lock.unlock();
 
-                    for (auto mmpi = mmp.first; mmpi != mmp.second; ++mmpi) {
+                    for (auto mvi : matchvec) {
                         SharedTrackerElement simple;
 
-                        SummarizeTrackerElement(entrytracker, mmpi->second, summary_vec,
+                        SummarizeTrackerElement(entrytracker, mvi, summary_vec,
                                 simple, rename_map);
 
                         devvec->add_vector(simple);
@@ -712,6 +941,62 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
                     return MHD_YES;
                 }
 
+            } else if (tokenurl[2] == "multi-key") {
+                // Bulk fetch of an explicit key list in one request; pays
+                // dispatch and serializer setup once instead of once per
+                // device, and the rename cache carries across records
+                if (!Httpd_CanSerialize(tokenurl[3])) {
+                    stream << "Invalid request";
+                    concls->httpcode = 400;
+                    return MHD_YES;
+                }
+
+                if (!structdata->hasKey("devices"))
+                    throw std::runtime_error("expected devices key list");
+
+                StructuredData::string_vec keyvec =
+                    structdata->getStructuredByKey("devices")->getStringVec();
+
+                SharedTrackerElement outdevs(new TrackerElement(TrackerVector));
+
+                for (auto ks : keyvec) {
+                    TrackedDeviceKey key(ks);
+
+                    if (key.get_error())
+                        throw std::runtime_error("invalid device key in list");
+
+                    // One probe of the sharded map per key
+                    auto dev = FetchDevice(key);
+
+                    // Skip unknown keys; a bulk fetch shouldn't fail
+                    // wholesale because one selection went stale
+                    if (dev == NULL)
+                        continue;
+
+                    SharedTrackerElement simple;
+
+                    {
+                        local_locker devlock(&(dev->device_mutex));
+                        SummarizeTrackerElement(entrytracker, dev, summary_vec,
+                                simple, rename_map);
+                    }
+
+                    outdevs->add_vector(simple);
+                }
+
+                if (wrapper_name != "") {
+                    SharedTrackerElement wrapper(new TrackerElement(TrackerMap));
+                    wrapper->add_map(outdevs);
+                    outdevs->set_local_name(wrapper_name);
+
+                    entrytracker->Serialize(httpd->GetSuffix(tokenurl[3]), stream,
+                            wrapper, &rename_map);
+                } else {
+                    entrytracker->Serialize(httpd->GetSuffix(tokenurl[3]), stream,
+                            outdevs, &rename_map);
+                }
+
+                return MHD_YES;
             } else if (tokenurl[2] == "summary") {
                 // We don't lock device list up here because we use workers since it
                 // can be a multi-device return
@@ -877,7 +1162,7 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
                                 for (auto ofi : dt_order_fields) {
                                     if (fa == NULL || (fa != NULL && 
                                         fa->get_type() == TrackerString &&
-                                        GetTrackerValue<std::string>(fa) == "")) {
+                                        fa->get_string_raw() == "")) {
                                         fa = 
                                             GetTrackerElementPath(ofi, a);
                                     } else {
@@ -886,7 +1171,7 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
 
                                     if (fb == NULL || (fb != NULL && 
                                         fb->get_type() == TrackerString &&
-                                        GetTrackerValue<std::string>(fb) == "")) {
+                                        fb->get_string_raw() == "")) {
                                         fb = 
                                             GetTrackerElementPath(ofi, b);
                                     } else {
@@ -927,11 +1212,30 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
                     // which we have flagged as searchable, and which is a string or
                     // mac which we can treat as a string.
 
-                    devicetracker_stringmatch_worker worker(globalreg, dt_search, 
-                            dt_search_paths);
-                    MatchOnDevices(&worker);
+                    SharedTrackerElement matchdevs;
+
+                    uint64_t mac_term;
+                    unsigned int mac_term_len = 0;
+
+                    if (dt_search.find(':') != std::string::npos &&
+                            mac_addr::PrepareSearchTerm(dt_search, mac_term, mac_term_len) &&
+                            mac_term_len != 0) {
+                        // Colon-form queries are MAC prefix / OUI searches;
+                        // resolve them as a range scan of the longmac prefix
+                        // index instead of walking the full device list
+                        matchdevs.reset(new TrackerElement(TrackerVector));
+                        TrackerElementVector prefixvec(matchdevs);
+
+                        for (auto pd : FetchDevicesByMacPrefix(mac_term, mac_term_len))
+                            prefixvec.push_back(pd);
+                    } else {
+                        devicetracker_stringmatch_worker worker(globalreg, dt_search,
+                                dt_search_paths);
+                        MatchOnDevices(&worker);
+
+                        matchdevs = worker.GetMatchedDevices();
+                    }
 
-                    SharedTrackerElement matchdevs = worker.GetMatchedDevices();
                     TrackerElementVector matchvec(matchdevs);
 
                     if (dt_order_col >= 0 && dt_order_fields.size() > 0) {
@@ -944,7 +1248,7 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
                                 for (auto ofi : dt_order_fields) {
                                     if (fa == NULL || (fa != NULL && 
                                         fa->get_type() == TrackerString &&
-                                        GetTrackerValue<std::string>(fa) == "")) {
+                                        fa->get_string_raw() == "")) {
                                         fa = 
                                             GetTrackerElementPath(ofi, a);
                                     } else {
@@ -953,7 +1257,7 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
 
                                     if (fb == NULL || (fb != NULL && 
                                         fb->get_type() == TrackerString &&
-                                        GetTrackerValue<std::string>(fb) == "")) {
+                                        fb->get_string_raw() == "")) {
                                         fb = 
                                             GetTrackerElementPath(ofi, b);
                                     } else {
@@ -996,17 +1300,21 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
                         outdevs->add_vector(simple);
                     }
                 } else {
-                    local_locker listlock(&devicelist_mutex);
+                    // Work against a snapshot of the device list so we don't
+                    // hold the list lock - and stall the packet path - while
+                    // we sort and summarize
+                    std::vector<std::shared_ptr<kis_tracked_device_base> > list_copy =
+                        FetchDeviceListCopy();
 
                     // Check DT ranges
-                    if (dt_start >= tracked_vec.size())
+                    if (dt_start >= list_copy.size())
                         dt_start = 0;
 
                     if (dt_filter_elem != NULL)
-                        dt_filter_elem->set((uint64_t) tracked_vec.size());
+                        dt_filter_elem->set((uint64_t) list_copy.size());
 
                     if (dt_order_col >= 0 && dt_order_fields.size() > 0) {
-                        kismet__stable_sort(tracked_vec.begin(), tracked_vec.end(), 
+                        kismet__stable_sort(list_copy.begin(), list_copy.end(),
                                 [&](SharedTrackerElement a, SharedTrackerElement b) {
                                 SharedTrackerElement fa;
                                 SharedTrackerElement fb;
@@ -1015,7 +1323,7 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
                                 for (auto ofi : dt_order_fields) {
                                     if (fa == NULL || (fa != NULL && 
                                         fa->get_type() == TrackerString &&
-                                        GetTrackerValue<std::string>(fa) == "")) {
+                                        fa->get_string_raw() == "")) {
                                         fa = 
                                             GetTrackerElementPath(ofi, a);
                                     } else {
@@ -1024,7 +1332,7 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
 
                                     if (fb == NULL || (fb != NULL && 
                                         fb->get_type() == TrackerString &&
-                                        GetTrackerValue<std::string>(fb) == "")) {
+                                        fb->get_string_raw() == "")) {
                                         fb = 
                                             GetTrackerElementPath(ofi, b);
                                     } else {
@@ -1047,12 +1355,12 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
 
                     // Set the iterator endpoint for our length
                     if (dt_length == 0 ||
-                            dt_length + dt_start >= tracked_vec.size())
-                        ei = tracked_vec.end();
+                            dt_length + dt_start >= list_copy.size())
+                        ei = list_copy.end();
                     else
-                        ei = tracked_vec.begin() + dt_start + dt_length;
+                        ei = list_copy.begin() + dt_start + dt_length;
 
-                    for (vi = tracked_vec.begin() + dt_start; vi != ei; ++vi) {
+                    for (vi = list_copy.begin() + dt_start; vi != ei; ++vi) {
                         SharedTrackerElement simple;
 
                         SummarizeTrackerElement(entrytracker,
@@ -1076,6 +1384,61 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
                         wrapper, &rename_map);
                 return MHD_YES;
 
+            } else if (tokenurl[2] == "views") {
+                // Cursor-paged slice of a server-side sorted view
+                std::string sort_field = structdata->getKeyAsString("sort_field", "");
+
+                if (sort_field.length() == 0) {
+                    stream << "Invalid request: expected sort_field";
+                    concls->httpcode = 400;
+                    return MHD_YES;
+                }
+
+                bool view_desc = structdata->getKeyAsBool("descending", false);
+                std::string cursor = structdata->getKeyAsString("cursor", "");
+
+                unsigned int page_len = structdata->getKeyAsNumber("length", 100);
+
+                // Views exist to keep payloads small; clamp the page
+                if (page_len == 0)
+                    page_len = 100;
+                if (page_len > 1000)
+                    page_len = 1000;
+
+                std::shared_ptr<DevicetrackerSortedView> view =
+                    FetchSortedView(sort_field, view_desc);
+
+                std::vector<std::shared_ptr<kis_tracked_device_base> > page;
+                std::string next_cursor = view->FetchPage(cursor, page_len, page);
+
+                TrackerElementSerializer::rename_map rename_map;
+
+                SharedTrackerElement outdevs(new TrackerElement(TrackerVector,
+                            view_devices_id));
+                outdevs->set_local_name("devices");
+
+                for (auto d : page) {
+                    local_locker devlock(&d->device_mutex);
+
+                    SharedTrackerElement simple;
+
+                    SummarizeTrackerElement(entrytracker, d, summary_vec, simple, rename_map);
+
+                    outdevs->add_vector(simple);
+                }
+
+                SharedTrackerElement cursor_elem(new TrackerElement(TrackerString,
+                            view_cursor_id));
+                cursor_elem->set(next_cursor);
+                cursor_elem->set_local_name("cursor");
+
+                SharedTrackerElement wrapper(new TrackerElement(TrackerMap));
+                wrapper->add_map(outdevs);
+                wrapper->add_map(cursor_elem);
+
+                entrytracker->Serialize(httpd->GetSuffix(tokenurl[3]), stream,
+                        wrapper, &rename_map);
+                return MHD_YES;
             } else if (tokenurl[2] == "last-time") {
                 // We don't lock the device list since we use workers
 
@@ -1109,16 +1472,8 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
                 //  List of devices that pass the regex filter
                 SharedTrackerElement regexdevs(new TrackerElement(TrackerVector));
 
-                devicetracker_function_worker tw(globalreg, 
-                        [this, &stream, lastts](Devicetracker *, std::shared_ptr<kis_tracked_device_base> d) -> bool {
-
-                        if (d->get_last_time() <= lastts)
-                        return false;
-
-                        return true;
-                        }, NULL);
-                MatchOnDevices(&tw);
-                timedevs = tw.GetMatchedDevices();
+                // Pull from the last_time index rather than scanning the list
+                timedevs = FetchDevicesSince(lastts);
 
                 if (regexdata != NULL) {
                     devicetracker_pcre_worker worker(globalreg, regexdata);
@@ -1176,17 +1531,7 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
                 SharedTrackerElement regexdevs;
 
 
-                // Filter by time first, it's fast
-                devicetracker_function_worker tw(globalreg, 
-                        [this, &stream, post_ts](Devicetracker *, std::shared_ptr<kis_tracked_device_base> d) -> bool {
-
-                        if (d->get_last_time() <= post_ts)
-                        return false;
-
-                        return true;
-                        }, NULL);
-
-                devicetracker_function_worker pw(globalreg, 
+                devicetracker_function_worker pw(globalreg,
                         [this, &stream, phydevs, phy](Devicetracker *, std::shared_ptr<kis_tracked_device_base> d) -> bool {
                         if (d->get_phyname() != phy->FetchPhyName())
                         return false;
@@ -1195,9 +1540,8 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
                         }, NULL);
 
                 if (post_ts != 0) {
-                    // time-match then phy-match then pass to regex
-                    MatchOnDevices(&tw);
-                    timedevs = tw.GetMatchedDevices();
+                    // time-match via the index, then phy-match, then pass to regex
+                    timedevs = FetchDevicesSince(post_ts);
                     MatchOnDevices(&pw, timedevs);
                     phydevs = pw.GetMatchedDevices();
                 }  else {
@@ -1247,3 +1591,100 @@ int Devicetracker::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
     return MHD_YES;
 }
 
+void Devicetracker::RemoveMonitorSubscription(DevicetrackerMonitorSubscription *sub) {
+    local_locker lock(&monitor_mutex);
+
+    for (auto i = monitor_subs.begin(); i != monitor_subs.end(); ++i) {
+        if ((*i).get() == sub) {
+            monitor_subs.erase(i);
+            break;
+        }
+    }
+
+    // Tear the flush timer down with the last subscriber so an idle server
+    // does no monitor work at all
+    if (monitor_subs.size() == 0 && monitor_timer_id >= 0) {
+        std::shared_ptr<Timetracker> timetracker =
+            Globalreg::FetchGlobalAs<Timetracker>(globalreg, "TIMETRACKER");
+
+        if (timetracker != NULL)
+            timetracker->RemoveTimer(monitor_timer_id);
+
+        monitor_timer_id = -1;
+    }
+}
+
+int Devicetracker::FlushMonitorSubscriptions() {
+    // Hold the monitor lock for the duration; disconnect cleanup takes the
+    // same lock, so a subscriber can't be torn down mid-write
+    local_locker lock(&monitor_mutex);
+
+    if (monitor_subs.size() == 0)
+        return 1;
+
+    time_t now = time(0);
+
+    // Snapshot the device list so summarization never holds the list lock
+    std::vector<SharedTrackerElement> snapshot;
+
+    {
+        local_locker listlock(&devicelist_mutex);
+        snapshot = std::vector<SharedTrackerElement>(immutable_tracked_vec.begin(),
+                immutable_tracked_vec.end());
+    }
+
+    for (auto sub : monitor_subs) {
+        if (now - sub->last_flush < (time_t) sub->rate)
+            continue;
+
+        sub->last_flush = now;
+
+        if (sub->seen_generations.size() < snapshot.size())
+            sub->seen_generations.resize(snapshot.size(), 0);
+
+        std::ostream stream(sub->streambuf);
+
+        for (unsigned int x = 0; x < snapshot.size(); x++) {
+            if (snapshot[x] == NULL)
+                continue;
+
+            std::shared_ptr<kis_tracked_device_base> kdb =
+                std::static_pointer_cast<kis_tracked_device_base>(snapshot[x]);
+
+            // The generation counter catches any mutation of the record
+            // tree; however many changes landed since the last flush, the
+            // subscriber gets one delta
+            uint64_t gen = kdb->tree_generation();
+
+            if (gen == sub->seen_generations[x])
+                continue;
+
+            // Devices idle since before the requested start time are
+            // stamped as seen without being sent
+            if (sub->seen_generations[x] == 0 && sub->init_ts != 0 &&
+                    kdb->get_mod_time() < sub->init_ts) {
+                sub->seen_generations[x] = gen;
+                continue;
+            }
+
+            sub->seen_generations[x] = gen;
+
+            TrackerElementSerializer::rename_map rename_map;
+            SharedTrackerElement simple;
+
+            {
+                local_locker devlocker(&(kdb->device_mutex));
+                SummarizeTrackerElement(entrytracker, snapshot[x], sub->summary_vec,
+                        simple, rename_map);
+            }
+
+            entrytracker->Serialize("ekjson", stream, simple, &rename_map);
+            stream << "\n";
+        }
+
+        sub->streambuf->pubsync();
+    }
+
+    return 1;
+}
+
@@ -114,14 +114,17 @@ int Devicetracker_Httpd_Pcap::Httpd_CreateStreamResponse(Kis_Net_Httpd *httpd,
     Pcap_Stream_Ringbuf *psrb = new Pcap_Stream_Ringbuf(http_globalreg,
             saux->get_rbhandler(), 
             [key, pack_comp_device](kis_packet *packet) -> bool {
-                kis_tracked_device_info *devinfo = 
+                kis_tracked_device_info *devinfo =
                     (kis_tracked_device_info *) packet->fetch(pack_comp_device);
 
                 if (devinfo == NULL) {
                     return false;
                 }
 
-                for (auto dri : devinfo->devrefs) {
+                // Walk the refs by reference; this runs for every packet on
+                // every open stream and copying the map entries would spin
+                // the shared_ptr refcounts for each ref on each packet
+                for (const auto& dri : devinfo->devrefs) {
                     if (dri.second->get_key() == key)
                         return true;
                 }
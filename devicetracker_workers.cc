@@ -150,6 +150,20 @@ devicetracker_pcre_worker::devicetracker_pcre_worker(GlobalRegistry *in_globalre
 
     filter_vec = in_filter_vec;
     error = false;
+
+    // Resolve any target paths the caller didn't, once, so per-device
+    // matching works on field IDs
+    for (auto fi : filter_vec) {
+        if (fi->resolved_path.size() != 0)
+            continue;
+
+        for (auto p : StrTokenize(fi->target, "/")) {
+            if (p.length() == 0)
+                continue;
+
+            fi->resolved_path.push_back(entrytracker->GetFieldId(p));
+        }
+    }
 }
 
 devicetracker_pcre_worker::devicetracker_pcre_worker(GlobalRegistry *in_globalreg,
@@ -192,13 +206,26 @@ devicetracker_pcre_worker::devicetracker_pcre_worker(GlobalRegistry *in_globalre
             throw std::runtime_error(errordesc.str());
         }
 
+#ifdef PCRE_STUDY_JIT_COMPILE
+        // JIT the pattern when the pcre build supports it; interactive
+        // searches run it against every device
+        filter->study = pcre_study(filter->re, PCRE_STUDY_JIT_COMPILE, &study_error);
+#else
         filter->study = pcre_study(filter->re, 0, &study_error);
+#endif
         if (study_error != NULL) {
             errordesc << "Could not parse PCRE expression, study/optimization "
                 "failure: " << study_error;
             throw std::runtime_error(errordesc.str());
         }
 
+        for (auto p : StrTokenize(filter->target, "/")) {
+            if (p.length() == 0)
+                continue;
+
+            filter->resolved_path.push_back(entrytracker->GetFieldId(p));
+        }
+
         filter_vec.push_back(filter);
     }
 }
@@ -239,13 +266,26 @@ devicetracker_pcre_worker::devicetracker_pcre_worker(GlobalRegistry *in_globalre
             throw std::runtime_error(errordesc.str());
         }
 
+#ifdef PCRE_STUDY_JIT_COMPILE
+        // JIT the pattern when the pcre build supports it; interactive
+        // searches run it against every device
+        filter->study = pcre_study(filter->re, PCRE_STUDY_JIT_COMPILE, &study_error);
+#else
         filter->study = pcre_study(filter->re, 0, &study_error);
+#endif
         if (study_error != NULL) {
             errordesc << "Could not parse PCRE expression, study/optimization "
                 "failure: " << study_error;
             throw std::runtime_error(errordesc.str());
         }
 
+        for (auto p : StrTokenize(filter->target, "/")) {
+            if (p.length() == 0)
+                continue;
+
+            filter->resolved_path.push_back(entrytracker->GetFieldId(p));
+        }
+
         filter_vec.push_back(filter);
     }
 }
@@ -263,9 +303,10 @@ bool devicetracker_pcre_worker::MatchDevice(Devicetracker *devicetracker __attri
     for (i = filter_vec.begin(); i != filter_vec.end(); ++i) {
 
         // Get complex fields - this lets us search nested vectors
-        // or strings or whatnot
-        std::vector<SharedTrackerElement> fields = 
-            GetTrackerElementMultiPath((*i)->target, device, entrytracker);
+        // or strings or whatnot; the path was resolved to IDs when the
+        // worker was built
+        std::vector<SharedTrackerElement> fields =
+            GetTrackerElementMultiPath((*i)->resolved_path, device);
 
         for (std::vector<SharedTrackerElement>::iterator fi = fields.begin();
                 fi != fields.end(); ++fi) {
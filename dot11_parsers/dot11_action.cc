@@ -20,8 +20,20 @@
 
 void dot11_action::parse(std::shared_ptr<kaitai::kstream> p_io) {
     m_category_code = p_io->read_u1();
-    m_action_data = p_io->read_bytes_full();
-    m_action_data_stream.reset(new kaitai::kstream(m_action_data));
+
+    // Borrow the action body from the source buffer when we can, fall back
+    // to copying when the source is an istream
+    size_t action_sz = p_io->size() - p_io->pos();
+    const char *borrow = p_io->read_bytes_ptr(action_sz);
+
+    if (borrow != NULL) {
+        m_action_data_view = kaitai::kbytes(borrow, action_sz);
+        m_action_data_stream.reset(new kaitai::kstream(borrow, action_sz));
+    } else {
+        m_action_data = p_io->read_bytes_full();
+        m_action_data_view = kaitai::kbytes(m_action_data.data(), m_action_data.length());
+        m_action_data_stream.reset(new kaitai::kstream(m_action_data));
+    }
     if (category_code() == category_code_radio_measurement) {
         std::shared_ptr<action_rmm> r(new action_rmm());
         r->parse(m_action_data_stream);
@@ -32,6 +44,16 @@ void dot11_action::parse(std::shared_ptr<kaitai::kstream> p_io) {
 void dot11_action::action_rmm::parse(std::shared_ptr<kaitai::kstream> p_io) {
     m_rmm_action_code = p_io->read_u1();
     m_dialog_token = p_io->read_u1();
-    m_tags_data = p_io->read_bytes_full();
-    m_tags_data_stream.reset(new kaitai::kstream(m_tags_data));
+
+    size_t tags_sz = p_io->size() - p_io->pos();
+    const char *borrow = p_io->read_bytes_ptr(tags_sz);
+
+    if (borrow != NULL) {
+        m_tags_data_view = kaitai::kbytes(borrow, tags_sz);
+        m_tags_data_stream.reset(new kaitai::kstream(borrow, tags_sz));
+    } else {
+        m_tags_data = p_io->read_bytes_full();
+        m_tags_data_view = kaitai::kbytes(m_tags_data.data(), m_tags_data.length());
+        m_tags_data_stream.reset(new kaitai::kstream(m_tags_data));
+    }
 }
@@ -75,7 +75,13 @@ public:
     }
 
     std::string action_rmm_data() {
-        return m_action_data;
+        return m_action_data_view.to_string();
+    }
+
+    // Borrowed view of the action body, valid only as long as the buffer
+    // the parent stream wraps
+    kaitai::kbytes action_rmm_data_view() {
+        return m_action_data_view;
     }
 
     std::shared_ptr<kaitai::kstream> action_rmm_data_stream() {
@@ -94,6 +100,7 @@ public:
 
 protected:
     uint8_t m_category_code;
+    kaitai::kbytes m_action_data_view;
     std::string m_action_data;
     std::shared_ptr<kaitai::kstream> m_action_data_stream;
     std::shared_ptr<action_frame_common> m_action_frame;
@@ -130,7 +137,11 @@ public:
         }
 
         std::string tags_data() {
-            return m_tags_data;
+            return m_tags_data_view.to_string();
+        }
+
+        kaitai::kbytes tags_data_view() {
+            return m_tags_data_view;
         }
 
         std::shared_ptr<kaitai::kstream> tags_data_stream() {
@@ -140,6 +151,7 @@ public:
     protected:
         uint8_t m_rmm_action_code;
         uint8_t m_dialog_token;
+        kaitai::kbytes m_tags_data_view;
         std::string m_tags_data;
         std::shared_ptr<kaitai::kstream> m_tags_data_stream;
 
@@ -18,20 +18,47 @@
 
 #include "dot11_ie.h"
 
-void dot11_ie::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_tags.reset(new shared_ie_tag_vector());
+int dot11_ie::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    m_tags.reset(new ie_tag_vector());
 
     while (!p_io->is_eof()) {
-        std::shared_ptr<dot11_ie_tag> t(new dot11_ie_tag());
-        t->parse(p_io);
-        m_tags->push_back(t);
+        m_tags->push_back(dot11_ie_tag());
+
+        // A truncated trailing tag invalidates the whole tag list; a
+        // frame clipped mid-IE is as suspect as one clipped mid-header
+        if (m_tags->back().parse(p_io) < 0) {
+            m_tags->pop_back();
+            return -1;
+        }
     }
+
+    return 0;
 }
 
-void dot11_ie::dot11_ie_tag::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie::dot11_ie_tag::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    // Bounds-check the header and the declared contents up front; after
+    // this no read in the tag can fail, so garbage costs a comparison
+    // instead of an unwind
+    if (p_io->remaining() < 2)
+        return -1;
+
     m_tag_num = p_io->read_u1();
     m_tag_len = p_io->read_u1();
-    m_tag_data = p_io->read_bytes(tag_len());
-    m_tag_data_stream.reset(new kaitai::kstream(m_tag_data));
+
+    if (p_io->remaining() < tag_len())
+        return -1;
+
+    // Record where the tag contents live; the typed data stream isn't built
+    // unless a consumer asks for this tag.  Borrow the contents out of the
+    // source buffer when we can so that splitting a beacon into tags copies
+    // nothing; fall back to copying when the source is an istream
+    const char *borrow = p_io->read_bytes_ptr(tag_len());
+
+    if (borrow != NULL)
+        m_tag_data_view = kaitai::kbytes(borrow, tag_len());
+    else
+        m_tag_data = p_io->read_bytes(tag_len());
+
+    return 0;
 }
 
@@ -21,11 +21,17 @@
 
 /* Parse a dot11 ie stream into individual objects.
  *
- * This uses the kaitai stream buffer from the kaitai runtime as it is a 
+ * This uses the kaitai stream buffer from the kaitai runtime as it is a
  * solid implementation of buffer-bounded operations and data extraction.
  *
  * Much of this is modeled on how kaitai generates parsers.
  *
+ * Truncated and corrupt frames are routine over RF, so the ie parser
+ * family reports malformed input with result codes instead of throwing
+ * through the kaitai stream:  parse() returns 0 on success and negative
+ * when the input is shorter than the structure, after explicit bounds
+ * checks and without unwinding.  Exceptions out of the kaitai runtime
+ * still backstop programmer errors like reading past a checked length.
  */
 
 #include <string>
@@ -36,7 +42,11 @@
 class dot11_ie {
 public:
     class dot11_ie_tag;
-    typedef std::vector<std::shared_ptr<dot11_ie_tag> > shared_ie_tag_vector;
+
+    // Tags are held by value in a flat vector; parsing a frame indexes the
+    // tags but doesn't build per-tag parse streams until a consumer asks
+    // for one
+    typedef std::vector<dot11_ie_tag> ie_tag_vector;
 
     dot11_ie() {
 
@@ -46,14 +56,14 @@ public:
 
     }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
-    std::shared_ptr<shared_ie_tag_vector> tags() {
+    std::shared_ptr<ie_tag_vector> tags() {
         return m_tags;
     }
 
 protected:
-    std::shared_ptr<shared_ie_tag_vector> m_tags;
+    std::shared_ptr<ie_tag_vector> m_tags;
 
 public:
     class dot11_ie_tag {
@@ -61,7 +71,7 @@ public:
         dot11_ie_tag() { } 
         ~dot11_ie_tag() { }
 
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        int parse(std::shared_ptr<kaitai::kstream> p_io);
 
         uint8_t tag_num() {
             return m_tag_num;
@@ -72,16 +82,36 @@ public:
         }
 
         std::string tag_data() {
-            return m_tag_data;
+            return tag_data_view().to_string();
         }
 
+        // Borrowed view of the tag contents; when the source stream wraps
+        // the packet buffer directly this points into the packet and is
+        // only valid for the life of the packet
+        kaitai::kbytes tag_data_view() {
+            // Copied-data tags view their own copy; built on demand because
+            // the owning string moves while the tag vector grows
+            if (m_tag_data_view.data() == NULL)
+                return kaitai::kbytes(m_tag_data.data(), m_tag_data.length());
+
+            return m_tag_data_view;
+        }
+
+        // Parse stream over the tag contents, built lazily; most tags of
+        // most frames are never fed to a typed parser
         std::shared_ptr<kaitai::kstream> tag_data_stream() {
+            if (m_tag_data_stream == NULL) {
+                kaitai::kbytes v = tag_data_view();
+                m_tag_data_stream.reset(new kaitai::kstream(v.data(), v.length()));
+            }
+
             return m_tag_data_stream;
         }
 
     protected:
         uint8_t m_tag_num;
         uint8_t m_tag_len;
+        kaitai::kbytes m_tag_data_view;
         std::string m_tag_data;
         std::shared_ptr<kaitai::kstream> m_tag_data_stream;
     };
@@ -36,7 +36,7 @@ public:
     dot11_ie_11_qbss() { }
     ~dot11_ie_11_qbss() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
     uint16_t station_count() {
         return m_station_count;
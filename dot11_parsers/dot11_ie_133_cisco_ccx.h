@@ -35,7 +35,7 @@ public:
     dot11_ie_133_cisco_ccx() { }
     ~dot11_ie_133_cisco_ccx() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
     std::string ccx_unk1() {
         return m_ccx_unk1;
@@ -18,11 +18,16 @@
 
 #include "dot11_ie_191_vht_cap.h"
 
-void dot11_ie_191_vht_cap::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_191_vht_cap::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 12)
+        return -1;
+
     m_vht_capabilities = p_io->read_u4le();
     m_rx_mcs_map = p_io->read_u2le();
     m_rx_mcs_set = p_io->read_u2le();
     m_tx_mcs_map = p_io->read_u2le();
     m_tx_mcs_set = p_io->read_u2le();
+
+    return 0;
 }
 
@@ -35,7 +35,7 @@ public:
     dot11_ie_191_vht_cap() { } 
     ~dot11_ie_191_vht_cap() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
     uint32_t vht_capabilities() {
         return m_vht_capabilities;
@@ -18,10 +18,15 @@
 
 #include "dot11_ie_192_vht_op.h"
 
-void dot11_ie_192_vht_op::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_192_vht_op::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 5)
+        return -1;
+
     m_channel_width = p_io->read_u1();
     m_center1 = p_io->read_u1();
     m_center2 = p_io->read_u1();
     m_basic_mcs_map = p_io->read_u2be();
+
+    return 0;
 }
 
@@ -42,7 +42,7 @@ public:
         ch_80_80 = 3
     };
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
     ch_channel_width channel_width() {
         return (ch_channel_width) m_channel_width;
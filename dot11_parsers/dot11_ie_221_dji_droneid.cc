@@ -18,7 +18,10 @@
 
 #include "dot11_ie_221_dji_droneid.h"
 
-void dot11_ie_221_dji_droneid::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_dji_droneid::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 4)
+        return -1;
+
     m_vendor_type = p_io->read_u1();
     m_unk1 = p_io->read_u1();
     m_unk2 = p_io->read_u1();
@@ -29,16 +32,24 @@ void dot11_ie_221_dji_droneid::parse(std::shared_ptr<kaitai::kstream> p_io) {
 
     if (subcommand() == subcommand_flightreg) {
         std::shared_ptr<dji_subcommand_flight_reg> fr(new dji_subcommand_flight_reg());
-        fr->parse(m_raw_record_data_stream);
+        if (fr->parse(m_raw_record_data_stream) < 0)
+            return -1;
         m_record = fr;
     } else if (subcommand() == subcommand_flightpurpose) {
         std::shared_ptr<dji_subcommand_flight_purpose> fp(new dji_subcommand_flight_purpose());
-        fp->parse(m_raw_record_data_stream);
+        if (fp->parse(m_raw_record_data_stream) < 0)
+            return -1;
         m_record = fp;
     }
+
+    return 0;
 }
 
-void dot11_ie_221_dji_droneid::dji_subcommand_flight_reg::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_dji_droneid::dji_subcommand_flight_reg::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    // Fixed 55 byte layout before the variable length uuid
+    if (p_io->remaining() < 55)
+        return -1;
+
     m_version = p_io->read_u1();
     m_seq = p_io->read_u2le();
     m_state_info = p_io->read_u2le();
@@ -57,10 +68,19 @@ void dot11_ie_221_dji_droneid::dji_subcommand_flight_reg::parse(std::shared_ptr<
     m_raw_home_lat = p_io->read_s4le();
     m_product_type = p_io->read_u1();
     m_uuid_len = p_io->read_u1();
+
+    if (p_io->remaining() < uuid_len())
+        return -1;
+
     m_uuid = p_io->read_bytes(uuid_len());
+
+    return 0;
 }
 
-void dot11_ie_221_dji_droneid::dji_subcommand_flight_purpose::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_dji_droneid::dji_subcommand_flight_purpose::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 28)
+        return -1;
+
     m_serialnumber = p_io->read_bytes(16);
     m_drone_id_len = p_io->read_u1();
     // Fixed size but obey the length field
@@ -70,5 +90,6 @@ void dot11_ie_221_dji_droneid::dji_subcommand_flight_purpose::parse(std::shared_
     // for the length specified
     m_purpose_len = p_io->read_u1();
     m_purpose = p_io->read_bytes_full().substr(0, purpose_len());
-}
 
+    return 0;
+}
@@ -65,7 +65,7 @@ public:
         return 0x263712;
     }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
     uint8_t vendor_type() {
         return m_vendor_type;
@@ -118,7 +118,7 @@ public:
         dji_subcommand_common() { }
         virtual ~dji_subcommand_common() { }
 
-        virtual void parse(std::shared_ptr<kaitai::kstream> p_io __attribute__((unused))) { }
+        virtual int parse(std::shared_ptr<kaitai::kstream> p_io __attribute__((unused))) { return 0; }
     };
 
     class dji_subcommand_flight_reg : public dji_subcommand_common {
@@ -126,7 +126,7 @@ public:
         dji_subcommand_flight_reg() { }
         virtual ~dji_subcommand_flight_reg() { }
 
-        virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+        virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
         uint8_t version() {
             return m_version;
@@ -307,7 +307,7 @@ public:
         dji_subcommand_flight_purpose() { }
         virtual ~dji_subcommand_flight_purpose() { }
 
-        virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+        virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
         std::string serialnumber() {
             return m_serialnumber;
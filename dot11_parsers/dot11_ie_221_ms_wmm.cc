@@ -18,7 +18,12 @@
 
 #include "dot11_ie_221_ms_wmm.h"
 
-void dot11_ie_221_ms_wmm::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_ms_wmm::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 1)
+        return -1;
+
     m_wme_subtype = p_io->read_u1();
+
+    return 0;
 }
 
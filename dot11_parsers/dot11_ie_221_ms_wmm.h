@@ -36,7 +36,7 @@ public:
     dot11_ie_221_ms_wmm() { } 
     ~dot11_ie_221_ms_wmm() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
     uint8_t wme_subtype() {
         return m_wme_subtype;
@@ -18,96 +18,157 @@
 
 #include "dot11_ie_221_ms_wps.h"
 
-void dot11_ie_221_ms_wps::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_ms_wps::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 1)
+        return -1;
+
     m_vendor_subtype = p_io->read_u1();
     m_wps_elements.reset(new shared_wps_de_sub_element_vector());
     while (!p_io->is_eof()) {
         std::shared_ptr<wps_de_sub_element> e(new wps_de_sub_element());
-        e->parse(p_io);
+        if (e->parse(p_io) < 0)
+            return -1;
         m_wps_elements->push_back(e);
     }
+
+    return 0;
 }
 
-void dot11_ie_221_ms_wps::wps_de_sub_element::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_ms_wps::wps_de_sub_element::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 4)
+        return -1;
+
     m_wps_de_type = p_io->read_u2be();
     m_wps_de_len = p_io->read_u2be();
+
+    if (p_io->remaining() < wps_de_len())
+        return -1;
+
     m_wps_de_content = p_io->read_bytes(wps_de_len());
     m_wps_de_content_data_stream.reset(new kaitai::kstream(m_wps_de_content));
 
     if (wps_de_type() == wps_de_device_name) {
         std::shared_ptr<wps_de_sub_string> s(new wps_de_sub_string());
-        s->parse(m_wps_de_content_data_stream);
+        if (s->parse(m_wps_de_content_data_stream) < 0)
+            return -1;
         m_sub_element = s;
     } else if (wps_de_type() == wps_de_manuf) {
         std::shared_ptr<wps_de_sub_string> s(new wps_de_sub_string());
-        s->parse(m_wps_de_content_data_stream);
+        if (s->parse(m_wps_de_content_data_stream) < 0)
+            return -1;
         m_sub_element = s;
     } else if (wps_de_type() == wps_de_model) {
         std::shared_ptr<wps_de_sub_string> s(new wps_de_sub_string());
-        s->parse(m_wps_de_content_data_stream);
+        if (s->parse(m_wps_de_content_data_stream) < 0)
+            return -1;
         m_sub_element = s;
     } else if (wps_de_type() == wps_de_model_num) {
         std::shared_ptr<wps_de_sub_string> s(new wps_de_sub_string());
-        s->parse(m_wps_de_content_data_stream);
+        if (s->parse(m_wps_de_content_data_stream) < 0)
+            return -1;
         m_sub_element = s;
     } else if (wps_de_type() == wps_de_rfbands) {
         std::shared_ptr<wps_de_sub_rfband> s(new wps_de_sub_rfband());
-        s->parse(m_wps_de_content_data_stream);
+        if (s->parse(m_wps_de_content_data_stream) < 0)
+            return -1;
         m_sub_element = s;
     } else if (wps_de_type() == wps_de_serial) {
         std::shared_ptr<wps_de_sub_string> s(new wps_de_sub_string());
-        s->parse(m_wps_de_content_data_stream);
+        if (s->parse(m_wps_de_content_data_stream) < 0)
+            return -1;
         m_sub_element = s;
     } else if (wps_de_type() == wps_de_state) {
         std::shared_ptr<wps_de_sub_state> s(new wps_de_sub_state());
-        s->parse(m_wps_de_content_data_stream);
+        if (s->parse(m_wps_de_content_data_stream) < 0)
+            return -1;
         m_sub_element = s;
     } else {
         std::shared_ptr<wps_de_sub_generic> s(new wps_de_sub_generic());
-        s->parse(m_wps_de_content_data_stream);
+        if (s->parse(m_wps_de_content_data_stream) < 0)
+            return -1;
         m_sub_element = s;
     }
+
+    return 0;
 }
 
-void dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_string::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_string::parse(std::shared_ptr<kaitai::kstream> p_io) {
     m_str = p_io->read_bytes_full();
+
+    return 0;
 }
 
-void dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_rfband::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_rfband::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 1)
+        return -1;
+
     m_rfband = p_io->read_u1();
+
+    return 0;
 }
 
-void dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_state::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_state::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 1)
+        return -1;
+
     m_state = p_io->read_u1();
+
+    return 0;
 }
 
-void dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_uuid_e::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_uuid_e::parse(std::shared_ptr<kaitai::kstream> p_io) {
     m_uuid = p_io->read_bytes_full();
+
+    return 0;
 }
 
-void dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_primary_type::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_primary_type::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 8)
+        return -1;
+
     m_category = p_io->read_u2be();
     m_typedata = p_io->read_u4be();
     m_subcategory = p_io->read_u2be();
+
+    return 0;
 }
 
-void dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_vendor_extension::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_vendor_extension::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 5)
+        return -1;
+
     m_vendor_id = p_io->read_bytes(3);
     m_wfa_sub_id = p_io->read_u1();
     m_wfa_sub_len = p_io->read_u1();
+
+    if (p_io->remaining() < wfa_sub_len())
+        return -1;
+
     m_wfa_sub_data = p_io->read_bytes(wfa_sub_len());
+
+    return 0;
 }
 
-void dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_version::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_version::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 1)
+        return -1;
+
     m_version = p_io->read_u1();
+
+    return 0;
 }
 
-void dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_ap_setup::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_ap_setup::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 1)
+        return -1;
+
     m_ap_setup_locked = p_io->read_u1();
-}
 
-void dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_generic::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_wps_de_data = p_io->read_bytes_full();
+    return 0;
 }
 
+int dot11_ie_221_ms_wps::wps_de_sub_element::wps_de_sub_generic::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    m_wps_de_data = p_io->read_bytes_full();
 
+    return 0;
+}
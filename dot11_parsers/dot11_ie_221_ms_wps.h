@@ -39,7 +39,7 @@ public:
     dot11_ie_221_ms_wps() { }
     ~dot11_ie_221_ms_wps() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
     uint8_t vendor_subtype() {
         return m_vendor_subtype;
@@ -94,7 +94,7 @@ public:
         wps_de_sub_element() {};
         ~wps_de_sub_element() {};
 
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        int parse(std::shared_ptr<kaitai::kstream> p_io);
 
         wps_de_type_e wps_de_type() {
             return (wps_de_type_e) m_wps_de_type;
@@ -175,7 +175,7 @@ public:
             wps_de_sub_common() { };
             virtual ~wps_de_sub_common() { };
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io) { }
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io __attribute__((unused))) { return 0; }
         };
 
         class wps_de_sub_string : public wps_de_sub_common {
@@ -183,7 +183,7 @@ public:
             wps_de_sub_string() { }
             virtual ~wps_de_sub_string() { }
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
             std::string str() {
                 return m_str;
@@ -198,7 +198,7 @@ public:
             wps_de_sub_rfband() { }
             virtual ~wps_de_sub_rfband() { }
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
             uint8_t rfband() {
                 return m_rfband;
@@ -221,7 +221,7 @@ public:
             wps_de_sub_state() { }
             virtual ~wps_de_sub_state() { }
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
             uint8_t state() {
                 return m_state;
@@ -240,7 +240,7 @@ public:
             wps_de_sub_uuid_e() { }
             virtual ~wps_de_sub_uuid_e() { }
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
             std::string uuid() {
                 return m_uuid;
@@ -255,7 +255,7 @@ public:
             wps_de_sub_primary_type() { }
             virtual ~wps_de_sub_primary_type() { }
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
             uint16_t category() {
                 return m_category;
@@ -280,7 +280,7 @@ public:
             wps_de_sub_vendor_extension() { }
             virtual ~wps_de_sub_vendor_extension() { }
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
             std::string vendor_id() {
                 return m_vendor_id;
@@ -310,7 +310,7 @@ public:
             wps_de_sub_version() { }
             virtual ~wps_de_sub_version() { }
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
             uint8_t version() {
                 return m_version;
@@ -325,7 +325,7 @@ public:
             wps_de_sub_ap_setup() { }
             virtual ~wps_de_sub_ap_setup() { }
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
             uint8_t ap_setup_locked() {
                 return m_ap_setup_locked;
@@ -340,7 +340,7 @@ public:
             wps_de_sub_generic() { }
             virtual ~wps_de_sub_generic() { }
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
             std::string wps_de_data() {
                 return m_wps_de_data;
@@ -18,12 +18,34 @@
 
 #include "dot11_ie_221_vendor.h"
 
-void dot11_ie_221_vendor::parse(std::shared_ptr<kaitai::kstream> p_io) {
-    m_vendor_oui = p_io->read_bytes(3);
-    m_vendor_tag = p_io->read_bytes_full();
-    m_vendor_tag_stream.reset(new kaitai::kstream(m_vendor_tag));
+int dot11_ie_221_vendor::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 3)
+        return -1;
 
-    if (m_vendor_tag.length() >= 1)
-        m_vendor_oui_type = m_vendor_tag[0];
+    // Borrow the OUI and tag body from the source buffer when we can so
+    // that prepping a 221 for the sub-parsers copies nothing; fall back to
+    // copying when the source is an istream
+    const char *borrow = p_io->read_bytes_ptr(3);
+
+    if (borrow != NULL) {
+        m_vendor_oui_view = kaitai::kbytes(borrow, 3);
+
+        size_t tag_sz = p_io->size() - p_io->pos();
+        borrow = p_io->read_bytes_ptr(tag_sz);
+        m_vendor_tag_view = kaitai::kbytes(borrow, tag_sz);
+        m_vendor_tag_stream.reset(new kaitai::kstream(borrow, tag_sz));
+    } else {
+        m_vendor_oui = p_io->read_bytes(3);
+        m_vendor_oui_view = kaitai::kbytes(m_vendor_oui.data(), m_vendor_oui.length());
+
+        m_vendor_tag = p_io->read_bytes_full();
+        m_vendor_tag_view = kaitai::kbytes(m_vendor_tag.data(), m_vendor_tag.length());
+        m_vendor_tag_stream.reset(new kaitai::kstream(m_vendor_tag));
+    }
+
+    if (m_vendor_tag_view.length() >= 1)
+        m_vendor_oui_type = m_vendor_tag_view[0];
+
+    return 0;
 }
 
@@ -36,26 +36,36 @@ public:
     dot11_ie_221_vendor() { } 
     ~dot11_ie_221_vendor() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
     std::string vendor_oui() {
-        return m_vendor_oui;
+        return m_vendor_oui_view.to_string();
     }
 
     std::string vendor_tag() {
-        return m_vendor_tag;
+        return m_vendor_tag_view.to_string();
+    }
+
+    // Borrowed views of the OUI and tag contents, valid only as long as
+    // the buffer the parent stream wraps
+    kaitai::kbytes vendor_oui_view() {
+        return m_vendor_oui_view;
+    }
+
+    kaitai::kbytes vendor_tag_view() {
+        return m_vendor_tag_view;
     }
 
     std::shared_ptr<kaitai::kstream> vendor_tag_stream() {
         return m_vendor_tag_stream;
     }
 
-    // Process the vendor tag 
+    // Process the vendor tag
     uint32_t vendor_oui_int() {
         return (uint32_t) (
-                (vendor_oui()[0] << 16) + 
-                (vendor_oui()[1] << 8) +
-                (vendor_oui()[2]));
+                (m_vendor_oui_view[0] << 16) +
+                (m_vendor_oui_view[1] << 8) +
+                (m_vendor_oui_view[2]));
     }
 
     uint8_t vendor_oui_type() {
@@ -63,6 +73,8 @@ public:
     }
 
 protected:
+    kaitai::kbytes m_vendor_oui_view;
+    kaitai::kbytes m_vendor_tag_view;
     std::string m_vendor_oui;
     std::string m_vendor_tag;
     std::shared_ptr<kaitai::kstream> m_vendor_tag_stream;
@@ -18,28 +18,57 @@
 
 #include "dot11_ie_221_wfa_wpa.h"
 
-void dot11_ie_221_wfa_wpa::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_wfa_wpa::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 3)
+        return -1;
     m_vendor_subtype = p_io->read_u1();
     m_wpa_version = p_io->read_u2le();
+
     m_multicast_cipher.reset(new wpa_v1_cipher());
-    m_multicast_cipher->parse(p_io);
+    if (m_multicast_cipher->parse(p_io) < 0)
+        return -1;
+
+    if (p_io->remaining() < 2)
+        return -1;
     m_unicast_count = p_io->read_u2le();
+
+    // Bound the declared counts against the remaining length so forged
+    // counts fail before the per-entry allocation loop
+    if (p_io->remaining() < unicast_count() * 4UL)
+        return -1;
+
     m_unicast_ciphers.reset(new shared_wpa_v1_cipher_vector());
     for (uint16_t i = 0; i < unicast_count(); i++) {
         std::shared_ptr<wpa_v1_cipher> c(new wpa_v1_cipher());
-        c->parse(p_io);
+        if (c->parse(p_io) < 0)
+            return -1;
         m_unicast_ciphers->push_back(c);
     }
+
+    if (p_io->remaining() < 2)
+        return -1;
     m_akm_count = p_io->read_u2le();
+
+    if (p_io->remaining() < akm_count() * 4UL)
+        return -1;
+
     m_akm_ciphers.reset(new shared_wpa_v1_cipher_vector());
     for (uint16_t i = 0; i < akm_count(); i++) {
         std::shared_ptr<wpa_v1_cipher> c(new wpa_v1_cipher());
-        c->parse(p_io);
+        if (c->parse(p_io) < 0)
+            return -1;
         m_akm_ciphers->push_back(c);
     }
+
+    return 0;
 }
 
-void dot11_ie_221_wfa_wpa::wpa_v1_cipher::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_221_wfa_wpa::wpa_v1_cipher::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 4)
+        return -1;
+
     m_oui = p_io->read_bytes(3);
     m_cipher_type = p_io->read_u1();
+
+    return 0;
 }
@@ -46,7 +46,7 @@ public:
         return 0x01;
     }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
     uint8_t vendor_subtype() {
         return m_vendor_subtype;
@@ -113,7 +113,7 @@ public:
         wpa_v1_cipher() {}
         ~wpa_v1_cipher() {}
 
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        int parse(std::shared_ptr<kaitai::kstream> p_io);
 
         std::string oui() {
             return m_oui;
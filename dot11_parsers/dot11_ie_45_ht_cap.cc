@@ -18,19 +18,31 @@
 
 #include "dot11_ie_45_ht_cap.h"
 
-void dot11_ie_45_ht_cap::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_45_ht_cap::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    // Fixed 26 byte layout including the 16 byte mcs record
+    if (p_io->remaining() < 26)
+        return -1;
+
     m_ht_capabilities = p_io->read_u2le();
     m_ampdu = p_io->read_u1();
     m_mcs.reset(new dot11_ie_45_rx_mcs());
-    m_mcs->parse(p_io);
+    if (m_mcs->parse(p_io) < 0)
+        return -1;
     m_ht_extended_caps = p_io->read_u2be();
     m_txbf_caps = p_io->read_u4be();
     m_asel_caps = p_io->read_u1();
+
+    return 0;
 }
 
-void dot11_ie_45_ht_cap::dot11_ie_45_rx_mcs::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_45_ht_cap::dot11_ie_45_rx_mcs::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 16)
+        return -1;
+
     m_rx_mcs = p_io->read_bytes(10);
     m_supported_data_rate = p_io->read_u2le();
     m_txflags = p_io->read_u4be();
+
+    return 0;
 }
 
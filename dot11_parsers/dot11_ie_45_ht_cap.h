@@ -37,7 +37,7 @@ public:
     dot11_ie_45_ht_cap() { }
     ~dot11_ie_45_ht_cap() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
     uint16_t ht_capabilities() {
         return m_ht_capabilities;
@@ -138,7 +138,7 @@ public:
 
         }
 
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        int parse(std::shared_ptr<kaitai::kstream> p_io);
 
         std::string rx_mcs() {
             return m_rx_mcs;
@@ -18,40 +18,79 @@
 
 #include "dot11_ie_48_rsn.h"
 
-void dot11_ie_48_rsn::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_48_rsn::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 2)
+        return -1;
     m_rsn_version = p_io->read_u2le();
+
     m_group_cipher.reset(new dot11_ie_48_rsn::dot11_ie_48_rsn_rsn_cipher());
-    m_group_cipher->parse(p_io);
+    if (m_group_cipher->parse(p_io) < 0)
+        return -1;
+
+    if (p_io->remaining() < 2)
+        return -1;
     m_pairwise_count = p_io->read_u2le();
+
+    // Bound the declared counts against the remaining length before
+    // looping; a forged count field otherwise costs an allocation per
+    // claimed entry before the reads run out of buffer
+    if (p_io->remaining() < pairwise_count() * 4UL)
+        return -1;
+
     m_pairwise_ciphers.reset(new shared_rsn_cipher_vector());
     for (unsigned int i = 0; i < pairwise_count(); i++) {
         std::shared_ptr<dot11_ie_48_rsn_rsn_cipher> c(new dot11_ie_48_rsn_rsn_cipher());
-        c->parse(p_io);
+        if (c->parse(p_io) < 0)
+            return -1;
         m_pairwise_ciphers->push_back(c);
     }
+
+    if (p_io->remaining() < 2)
+        return -1;
     m_akm_count = p_io->read_u2le();
+
+    if (p_io->remaining() < akm_count() * 4UL)
+        return -1;
+
     m_akm_ciphers.reset(new shared_rsn_management_vector());
     for (unsigned int i = 0; i < akm_count(); i++) {
         std::shared_ptr<dot11_ie_48_rsn_rsn_management> a(new dot11_ie_48_rsn_rsn_management());
-        a->parse(p_io);
+        if (a->parse(p_io) < 0)
+            return -1;
         m_akm_ciphers->push_back(a);
     }
 
+    return 0;
 }
 
-void dot11_ie_48_rsn::dot11_ie_48_rsn_rsn_cipher::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_48_rsn::dot11_ie_48_rsn_rsn_cipher::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 4)
+        return -1;
+
     m_cipher_suite_oui = p_io->read_bytes(3);
     m_cipher_type = p_io->read_u1();
+
+    return 0;
 }
 
-void dot11_ie_48_rsn::dot11_ie_48_rsn_rsn_management::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_48_rsn::dot11_ie_48_rsn_rsn_management::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 4)
+        return -1;
+
     m_management_suite_oui = p_io->read_bytes(3);
     m_management_type = p_io->read_u1();
+
+    return 0;
 }
 
-void dot11_ie_48_rsn_partial::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_48_rsn_partial::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 8)
+        return -1;
+
     m_rsn_version = p_io->read_u2le();
     m_group_cipher = p_io->read_bytes(4);
     m_pairwise_count = p_io->read_u2le();
+
+    return 0;
 }
 
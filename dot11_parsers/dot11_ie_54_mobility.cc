@@ -18,8 +18,13 @@
 
 #include "dot11_ie_54_mobility.h"
 
-void dot11_ie_54_mobility::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_54_mobility::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 3)
+        return -1;
+
     m_mobility_domain = p_io->read_u2le();
     m_mobility_policy = p_io->read_u1();
+
+    return 0;
 }
 
@@ -39,7 +39,7 @@ public:
     dot11_ie_55_fastbss() { }
     ~dot11_ie_55_fastbss() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
     std::shared_ptr<sub_mic_control> mic_control() {
         return m_mic_control;
@@ -74,7 +74,7 @@ public:
         sub_mic_control() { }
         ~sub_mic_control() { }
 
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        int parse(std::shared_ptr<kaitai::kstream> p_io);
 
         uint8_t element_count() {
             return m_element_count;
@@ -103,7 +103,7 @@ public:
         sub_element() { }
         ~sub_element() { }
 
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        int parse(std::shared_ptr<kaitai::kstream> p_io);
 
         sub_type sub_id() {
             return (sub_type) m_sub_id;
@@ -152,7 +152,7 @@ public:
             sub_element_data() { };
             virtual ~sub_element_data() { };
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io) { };
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io __attribute__((unused))) { return 0; };
         };
 
         class sub_element_data_pmk_r1_keyholder : public sub_element_data {
@@ -160,7 +160,7 @@ public:
             sub_element_data_pmk_r1_keyholder() { }
             virtual ~sub_element_data_pmk_r1_keyholder() { }
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
             std::string keyholder_id() {
                 return m_keyholder_id;
@@ -175,7 +175,7 @@ public:
             sub_element_data_pmk_r0_kh_id() { };
             virtual ~sub_element_data_pmk_r0_kh_id() { };
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
             std::string keyholder_id() {
                 return m_keyholder_id;
@@ -192,7 +192,7 @@ public:
             sub_element_data_gtk() { }
             virtual ~sub_element_data_gtk() { }
 
-            void parse(std::shared_ptr<kaitai::kstream> p_io);
+            int parse(std::shared_ptr<kaitai::kstream> p_io);
 
         protected:
             std::shared_ptr<sub_element_data_gtk_sub_keyinfo> m_gtk_keyinfo;
@@ -206,7 +206,7 @@ public:
                 sub_element_data_gtk_sub_keyinfo() { }
                 ~sub_element_data_gtk_sub_keyinfo() { }
 
-                void parse(std::shared_ptr<kaitai::kstream> p_io);
+                int parse(std::shared_ptr<kaitai::kstream> p_io);
 
                 uint16_t keyinfo() {
                     return m_keyinfo;
@@ -225,7 +225,7 @@ public:
             sub_element_data_generic() { }
             virtual ~sub_element_data_generic() { }
 
-            virtual void parse(std::shared_ptr<kaitai::kstream> p_io);
+            virtual int parse(std::shared_ptr<kaitai::kstream> p_io);
 
             std::string data() {
                 return m_data;
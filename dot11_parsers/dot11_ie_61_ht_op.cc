@@ -18,11 +18,16 @@
 
 #include "dot11_ie_61_ht_op.h"
 
-void dot11_ie_61_ht_op::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_61_ht_op::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 8)
+        return -1;
+
     m_primary_channel = p_io->read_u1();
     m_info_subset_1 = p_io->read_u1();
     m_info_subset_2 = p_io->read_u2be();
     m_info_subset_3 = p_io->read_u2be();
     m_rx_coding_scheme = p_io->read_u2le();
+
+    return 0;
 }
 
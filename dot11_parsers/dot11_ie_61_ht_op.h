@@ -35,7 +35,7 @@ public:
     dot11_ie_61_ht_op() { }
     ~dot11_ie_61_ht_op() { }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
     uint8_t primary_channel() {
         return m_primary_channel;
@@ -18,30 +18,40 @@
 
 #include "dot11_ie_7_country.h"
 
-void dot11_ie_7_country::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_7_country::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 3)
+        return -1;
+
     m_country_code = p_io->read_bytes(2);
     m_environment = p_io->read_u1();
     m_country_list.reset(new shared_dot11d_country_triplet_vector());
     while (!p_io->is_eof()) {
         // Do our best to read all the channel codings; if we allow broken
         // country tags, read as far as we can and then stop, otherwise
-        // pass the error upstream
-        try {
-            std::shared_ptr<dot11d_country_triplet> c(new dot11d_country_triplet());
-            c->parse(p_io);
-            m_country_list->push_back(c);
-        } catch (std::exception& e) {
+        // report the error upstream
+        std::shared_ptr<dot11d_country_triplet> c(new dot11d_country_triplet());
+
+        if (c->parse(p_io) < 0) {
             if (i_allow_fragments)
                 break;
             else
-                throw(e);
+                return -1;
         }
+
+        m_country_list->push_back(c);
     }
+
+    return 0;
 }
 
-void dot11_ie_7_country::dot11d_country_triplet::parse(std::shared_ptr<kaitai::kstream> p_io) {
+int dot11_ie_7_country::dot11d_country_triplet::parse(std::shared_ptr<kaitai::kstream> p_io) {
+    if (p_io->remaining() < 3)
+        return -1;
+
     m_first_channel = p_io->read_u1();
     m_num_channels = p_io->read_u1();
     m_max_power = p_io->read_u1();
+
+    return 0;
 }
 
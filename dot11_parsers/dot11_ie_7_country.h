@@ -51,7 +51,7 @@ public:
         i_allow_fragments = in_f;
     }
 
-    void parse(std::shared_ptr<kaitai::kstream> p_io);
+    int parse(std::shared_ptr<kaitai::kstream> p_io);
 
     std::string country_code() {
         return m_country_code;
@@ -78,7 +78,7 @@ public:
         dot11d_country_triplet() {}
         ~dot11d_country_triplet() {}
 
-        void parse(std::shared_ptr<kaitai::kstream> p_io);
+        int parse(std::shared_ptr<kaitai::kstream> p_io);
 
         uint8_t first_channel() {
             return m_first_channel;
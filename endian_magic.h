@@ -21,6 +21,9 @@
 
 #include "config.h"
 
+#include <stdint.h>
+#include <string.h>
+
 // Byteswap magic
 #ifdef WORDS_BIGENDIAN
 
@@ -43,6 +46,9 @@
 #define kis_letoh32(x) kis_swap32((x))
 #define kis_betoh32(x) (x)
 
+#define kis_letoh64(x) kis_swap64((x))
+#define kis_betoh64(x) (x)
+
 #define kis_htole16(x) kis_swap16((x))
 #define kis_htobe16(x) (x)
 
@@ -73,6 +79,9 @@
 #define kis_betoh32(x) kis_swap32((x))
 #define kis_letoh32(x) (x)
 
+#define kis_betoh64(x) kis_swap64((x))
+#define kis_letoh64(x) (x)
+
 #define kis_htole16(x) (x)
 #define kis_htobe16(x) kis_swap16((x))
 
@@ -84,7 +93,17 @@
 
 #endif
 
-// Swap magic
+// Swap magic; use the compiler byteswap intrinsics when we have them so
+// a swap compiles to a single instruction, and keep the shift-and-mask
+// forms for compilers without the builtins
+#if defined(__GNUC__) || defined(__clang__)
+
+#define kis_swap16(x) __builtin_bswap16((uint16_t) (x))
+#define kis_swap32(x) __builtin_bswap32((uint32_t) (x))
+#define kis_swap64(x) __builtin_bswap64((uint64_t) (x))
+
+#else
+
 #define kis_swap16(x) \
 ({ \
     uint16_t __x = (x); \
@@ -117,46 +136,53 @@
         (uint64_t)(((uint64_t)(__x) & (uint64_t)0xff00000000000000ULL) >> 56) )); \
 })
 
-// Extract magic, also cribbed from tcpdump/ethereal
-#define kis_extractLE16(x) \
-	((uint16_t)((uint16_t)*((const uint8_t *)(x) + 1) << 8 | \
- 	(uint16_t)*((const uint8_t *)(x) + 0))) 
-
-#define kis_extractLE32(x) \
-	((uint32_t)((uint32_t)*((const uint8_t *)(x) + 1) << 24 | \
-	((uint32_t)((uint32_t)*((const uint8_t *)(x) + 0) << 16 | \
-	((uint32_t)((uint32_t)*((const uint8_t *)(x) + 3) << 8 | \
- 	(uint32_t)*((const uint8_t *)(x) + 2))) 
-
-#define kis_extractLE64(x) \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 1) << 56 | \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 0) << 48 | \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 3) << 40 | \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 2) << 32 | \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 5) << 24 | \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 4) << 16 | \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 7) << 8 | \
- 	(uint64_t)*((const uint8_t *)(x) + 6))) 
-
-#define kis_extractBE16(x) \
-	((uint16_t)((uint16_t)*((const uint8_t *)(x) + 0) << 8 | \
- 	(uint16_t)*((const uint8_t *)(x) + 1))) 
-
-#define kis_extractBE32(x) \
-	((uint32_t)((uint32_t)*((const uint8_t *)(x) + 0) << 24 | \
-	((uint32_t)((uint32_t)*((const uint8_t *)(x) + 1) << 16 | \
-	((uint32_t)((uint32_t)*((const uint8_t *)(x) + 2) << 8 | \
- 	(uint32_t)*((const uint8_t *)(x) + 3))) 
-
-#define kis_extractBE64(x) \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 0) << 56 | \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 1) << 48 | \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 2) << 40 | \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 3) << 32 | \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 4) << 24 | \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 5) << 16 | \
-	((uint64_t)((uint64_t)*((const uint8_t *)(x) + 6) << 8 | \
- 	(uint64_t)*((const uint8_t *)(x) + 7))) 
+#endif
+
+// Unaligned load/store helpers.  The memcpy idiom is the only portable
+// way to read a multibyte field at an arbitrary offset in a packet
+// buffer; compilers collapse a fixed-size memcpy into a single load or
+// store on platforms that allow unaligned access, so these replace
+// assembling fields byte-by-byte in the dissectors
+static inline uint16_t kis_unaligned_load16(const void *p) {
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t kis_unaligned_load32(const void *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t kis_unaligned_load64(const void *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void kis_unaligned_store16(void *p, uint16_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline void kis_unaligned_store32(void *p, uint32_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline void kis_unaligned_store64(void *p, uint64_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+// Extract magic; read a field of explicit wire endianness at any
+// alignment as one load plus at most one swap
+#define kis_extractLE8(x)  (*((const uint8_t *) (x)))
+#define kis_extractLE16(x) ((uint16_t) kis_letoh16(kis_unaligned_load16(x)))
+#define kis_extractLE32(x) ((uint32_t) kis_letoh32(kis_unaligned_load32(x)))
+#define kis_extractLE64(x) ((uint64_t) kis_letoh64(kis_unaligned_load64(x)))
+
+#define kis_extractBE16(x) ((uint16_t) kis_betoh16(kis_unaligned_load16(x)))
+#define kis_extractBE32(x) ((uint32_t) kis_betoh32(kis_unaligned_load32(x)))
+#define kis_extractBE64(x) ((uint64_t) kis_betoh64(kis_unaligned_load64(x)))
 
 #endif
 
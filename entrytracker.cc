@@ -16,6 +16,7 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+#include <algorithm>
 #include <string>
 #include <sstream>
 
@@ -79,6 +80,8 @@ int EntryTracker::RegisterField(std::string in_name, TrackerType in_type, std::s
     field_name_map[mod_name] = definition;
     field_id_map[definition->field_id] = definition;
 
+    CompileFieldTables();
+
     return definition->field_id;
 }
 
@@ -115,6 +118,8 @@ int EntryTracker::RegisterField(std::string in_name, std::shared_ptr<TrackerElem
     field_name_map[mod_name] = definition;
     field_id_map[definition->field_id] = definition;
 
+    CompileFieldTables();
+
     // Set the builders ID now that we know it
     definition->builder->set_id(definition->field_id);
 
@@ -124,54 +129,95 @@ int EntryTracker::RegisterField(std::string in_name, std::shared_ptr<TrackerElem
     return definition->field_id;
 }
 
-int EntryTracker::GetFieldId(std::string in_name) {
-    local_locker lock(&entry_mutex);
+void EntryTracker::CompileFieldTables() {
+    auto idt = std::make_shared<field_id_table_t>();
+    idt->resize(next_field_num);
+
+    for (auto i = field_id_map.begin(); i != field_id_map.end(); ++i) {
+        if (i->first >= 0 && i->first < next_field_num)
+            (*idt)[i->first] = i->second;
+    }
+
+    auto nt = std::make_shared<field_name_table_t>();
+    nt->reserve(field_name_map.size());
+
+    // std::map iteration is already sorted by name
+    for (auto i = field_name_map.begin(); i != field_name_map.end(); ++i)
+        nt->push_back(*i);
+
+    std::atomic_store(&field_id_table,
+            std::shared_ptr<const field_id_table_t>(idt));
+    std::atomic_store(&field_name_table,
+            std::shared_ptr<const field_name_table_t>(nt));
+}
+
+std::shared_ptr<EntryTracker::reserved_field> EntryTracker::FetchFieldDefinition(int in_id) {
+    auto table = std::atomic_load(&field_id_table);
+
+    if (table == NULL)
+        return NULL;
+
+    if (in_id < 0 || (size_t) in_id >= table->size())
+        return NULL;
+
+    return (*table)[in_id];
+}
+
+std::shared_ptr<EntryTracker::reserved_field> 
+    EntryTracker::FetchFieldDefinition(const std::string& in_mod_name) {
+    auto table = std::atomic_load(&field_name_table);
+
+    if (table == NULL)
+        return NULL;
+
+    auto i = std::lower_bound(table->begin(), table->end(), in_mod_name,
+            [](const std::pair<std::string, std::shared_ptr<reserved_field> >& a,
+                const std::string& b) -> bool {
+                return a.first < b;
+            });
+
+    if (i == table->end() || i->first != in_mod_name)
+        return NULL;
+
+    return i->second;
+}
 
+int EntryTracker::GetFieldId(std::string in_name) {
     std::string mod_name = StrLower(in_name);
 
-    name_itr iter = field_name_map.find(mod_name);
+    auto def = FetchFieldDefinition(mod_name);
 
-    if (iter == field_name_map.end()) {
+    if (def == NULL)
         return -1;
-    }
 
-    return iter->second->field_id;
+    return def->field_id;
 }
 
 std::string EntryTracker::GetFieldName(int in_id) {
-    local_locker lock(&entry_mutex);
+    auto def = FetchFieldDefinition(in_id);
 
-    id_itr iter = field_id_map.find(in_id);
-
-    if (iter == field_id_map.end()) {
+    if (def == NULL)
         return "field.unknown.not.registered";
-    }
 
-    return iter->second->field_name;
+    return def->field_name;
 }
 
 std::string EntryTracker::GetFieldDescription(int in_id) {
-    local_locker lock(&entry_mutex);
+    auto def = FetchFieldDefinition(in_id);
 
-    id_itr iter = field_id_map.find(in_id);
-
-    if (iter == field_id_map.end()) {
+    if (def == NULL)
         return "untracked field, description not available";
-    }
 
-    return iter->second->field_description;
+    return def->field_description;
 }
 
 TrackerType EntryTracker::GetFieldType(int in_id) {
-    local_locker lock(&entry_mutex);
+    auto def = FetchFieldDefinition(in_id);
 
-    id_itr iter = field_id_map.find(in_id);
-
-    if (iter == field_id_map.end()) {
+    if (def == NULL)
         return TrackerMap;
-    }
 
-    return iter->second->track_type;
+    return def->track_type;
 
 }
 
@@ -185,7 +231,8 @@ std::shared_ptr<TrackerElement> EntryTracker::RegisterAndGetField(std::string in
 
     fn = RegisterField(in_name, in_type, in_desc);
 
-    return std::shared_ptr<TrackerElement>(new TrackerElement(in_type, fn));
+    return std::allocate_shared<TrackerElement>(
+            tracker_element_pool_allocator<TrackerElement>(), in_type, fn);
 }
 
 std::shared_ptr<TrackerElement> EntryTracker::RegisterAndGetField(std::string in_name, 
@@ -203,48 +250,34 @@ std::shared_ptr<TrackerElement> EntryTracker::RegisterAndGetField(std::string in
 
 
 std::shared_ptr<TrackerElement> EntryTracker::GetTrackedInstance(int in_id) {
-    local_demand_locker lock(&entry_mutex);
+    std::shared_ptr<reserved_field> definition = FetchFieldDefinition(in_id);
 
-    lock.lock();
-
-    id_itr iter = field_id_map.find(in_id);
-
-    if (iter == field_id_map.end()) {
+    if (definition == NULL) {
         return NULL;
     }
 
-    std::shared_ptr<reserved_field> definition = iter->second;
-
-    lock.unlock();
-
     if (definition->builder == NULL)
-        return std::shared_ptr<TrackerElement>(new TrackerElement(definition->track_type, 
-                    definition->field_id));
+        return std::allocate_shared<TrackerElement>(
+                tracker_element_pool_allocator<TrackerElement>(),
+                definition->track_type, definition->field_id);
     else
         return definition->builder->clone_type(definition->field_id);
 }
 
 std::shared_ptr<TrackerElement> EntryTracker::GetTrackedInstance(std::string in_name) {
-    local_demand_locker lock(&entry_mutex);
-
     std::string mod_name = StrLower(in_name);
 
-    lock.lock();
-
-    name_itr iter = field_name_map.find(mod_name);
+    std::shared_ptr<reserved_field> definition = FetchFieldDefinition(mod_name);
 
     // We don't know this
-    if (iter == field_name_map.end()) {
+    if (definition == NULL) {
         return NULL;
     }
 
-    std::shared_ptr<reserved_field> definition = iter->second;
-
-    lock.unlock();
-
     if (definition->builder == NULL)
-        return std::shared_ptr<TrackerElement>(new TrackerElement(definition->track_type, 
-                    definition->field_id));
+        return std::allocate_shared<TrackerElement>(
+                tracker_element_pool_allocator<TrackerElement>(),
+                definition->track_type, definition->field_id);
     else
         return definition->builder->clone_type(definition->field_id);
 }
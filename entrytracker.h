@@ -132,6 +132,26 @@ protected:
     std::map<std::string, std::shared_ptr<TrackerElementSerializer> > serializer_map;
     typedef std::map<std::string, std::shared_ptr<TrackerElementSerializer> >::iterator serial_itr;
 
+    // Frozen read-side lookup tables, rebuilt under entry_mutex after every
+    // registration and swapped in atomically; the per-packet and per-request
+    // lookup paths read them with no lock at all.  Field ids are small and
+    // sequential, so the id table is a direct-index vector; names live in a
+    // sorted vector searched by binary search.  Registration effectively
+    // stops once startup completes, so rebuilds are rare.
+    typedef std::vector<std::shared_ptr<reserved_field> > field_id_table_t;
+    typedef std::vector<std::pair<std::string, std::shared_ptr<reserved_field> > > field_name_table_t;
+
+    std::shared_ptr<const field_id_table_t> field_id_table;
+    std::shared_ptr<const field_name_table_t> field_name_table;
+
+    // Rebuild the frozen tables; caller must hold entry_mutex
+    void CompileFieldTables();
+
+    // Lock-free fetch of a field definition from the frozen tables
+    std::shared_ptr<reserved_field> FetchFieldDefinition(int in_id);
+    // Name must already be lowercased
+    std::shared_ptr<reserved_field> FetchFieldDefinition(const std::string& in_mod_name);
+
 };
 
 class SerializerScope {
@@ -547,8 +547,13 @@ int FilterCore::AddFilterLine(std::string filter_str) {
 	}
 #endif
 
+	// Recompile the flattened programs to match the new tables
+	CompileProgram(bssid_map, bssid_program);
+	CompileProgram(source_map, source_program);
+	CompileProgram(dest_map, dest_program);
+
 	return 1;
-	
+
 #if 0
     // Break it into filter terms
     size_t parse_pos = 0;
@@ -704,29 +709,76 @@ int FilterCore::AddFilterLine(std::string filter_str) {
 #endif
 }
 
+void FilterCore::CompileProgram(macmap<int>& in_map, filter_program& in_prog) {
+	in_prog.exact_bloom = 0;
+	in_prog.exact_macs.clear();
+	in_prog.mask_tables.clear();
+
+	for (macmap<int>::iterator i = in_map.begin(); i != in_map.end(); ++i) {
+		mac_addr m = i->first;
+
+		if (m.longmask == (uint64_t) -1) {
+			in_prog.exact_macs.push_back(m.longmac);
+			continue;
+		}
+
+		filter_program::mask_table *table = NULL;
+
+		for (unsigned int x = 0; x < in_prog.mask_tables.size(); x++) {
+			if (in_prog.mask_tables[x].mask == m.longmask) {
+				table = &(in_prog.mask_tables[x]);
+				break;
+			}
+		}
+
+		if (table == NULL) {
+			filter_program::mask_table mt;
+			mt.mask = m.longmask;
+			in_prog.mask_tables.push_back(mt);
+			table = &(in_prog.mask_tables.back());
+		}
+
+		table->macs.push_back(m.longmac & m.longmask);
+	}
+
+	std::sort(in_prog.exact_macs.begin(), in_prog.exact_macs.end());
+	in_prog.exact_macs.erase(std::unique(in_prog.exact_macs.begin(),
+				in_prog.exact_macs.end()), in_prog.exact_macs.end());
+
+	for (unsigned int x = 0; x < in_prog.mask_tables.size(); x++) {
+		std::vector<uint64_t>& mv = in_prog.mask_tables[x].macs;
+		std::sort(mv.begin(), mv.end());
+		mv.erase(std::unique(mv.begin(), mv.end()), mv.end());
+	}
+
+	for (unsigned int x = 0; x < in_prog.exact_macs.size(); x++)
+		in_prog.exact_bloom |= BloomBits(in_prog.exact_macs[x]);
+}
+
 int FilterCore::RunFilter(mac_addr bssidmac, mac_addr sourcemac,
 						  mac_addr destmac) {
 	int hit = 0;
-	// Clumsy artifact of how iters are defined for macmap currently, must
-	// be defined as an assign
-	macmap<int>::iterator fitr = bssid_map.find(bssidmac);
-	
-	if ((fitr != bssid_map.end() && bssid_invert == 1) ||
-		(fitr == bssid_map.end() && bssid_invert == 0)) {
+
+	// Single pass over the compiled programs; the bloom prefilter and
+	// sorted tables settle each address without touching the macmaps
+	bool match = MatchProgram(bssid_program, bssidmac);
+
+	if ((match && bssid_invert == 1) ||
+		(!match && bssid_invert == 0)) {
 		bssid_hit++;
 		hit = 1;
 	}
 
-	fitr = source_map.find(sourcemac);
-	if ((fitr != source_map.end() && source_invert == 1) ||
-		(fitr == source_map.end() && source_invert == 0)) {
+	match = MatchProgram(source_program, sourcemac);
+	if ((match && source_invert == 1) ||
+		(!match && source_invert == 0)) {
 		source_hit++;
 		hit = 1;
 	}
 
-	fitr = dest_map.find(destmac);
-	if ((fitr != dest_map.end() && dest_invert == 1) ||
-		(fitr == dest_map.end() && dest_invert == 0)) {
+	match = MatchProgram(dest_program, destmac);
+	if ((match && dest_invert == 1) ||
+		(!match && dest_invert == 0)) {
 		dest_hit++;
 		hit = 1;
 	}
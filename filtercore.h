@@ -77,11 +77,75 @@ public:
 	int FetchPCREHits();
 
 protected:
+	// Compiled, flattened form of one address filter dimension; rebuilt
+	// whenever a filter line is parsed so the per-packet evaluation is a
+	// single pass over sorted tables instead of macmap traversals
+	struct filter_program {
+		filter_program() {
+			exact_bloom = 0;
+		}
+
+		// Coarse prefilter over the exact table; if an address' bits
+		// aren't present the table can't contain it and the search is
+		// skipped entirely, which is the common case on a busy channel
+		uint64_t exact_bloom;
+
+		// Fully-specified addresses, sorted for binary search
+		std::vector<uint64_t> exact_macs;
+
+		// One table per distinct mask, sorted by the pre-masked address;
+		// filters rarely use more than one or two mask widths
+		struct mask_table {
+			uint64_t mask;
+			std::vector<uint64_t> macs;
+		};
+
+		std::vector<mask_table> mask_tables;
+	};
+
+	// Two bloom bits derived from a mixed address
+	static inline uint64_t BloomBits(uint64_t in_mac) {
+		uint64_t h = in_mac * 0x9E3779B97F4A7C15ULL;
+		return (1ULL << (h >> 58)) | (1ULL << ((h >> 52) & 0x3F));
+	}
+
+	// Flatten a filter map into a compiled program
+	void CompileProgram(macmap<int>& in_map, filter_program& in_prog);
+
+	// Evaluate a compiled program against a single address
+	inline bool MatchProgram(const filter_program& in_prog,
+			const mac_addr& in_mac) {
+		if (in_prog.exact_macs.size() > 0) {
+			uint64_t bits = BloomBits(in_mac.longmac);
+
+			if ((in_prog.exact_bloom & bits) == bits &&
+					std::binary_search(in_prog.exact_macs.begin(),
+						in_prog.exact_macs.end(), in_mac.longmac))
+				return true;
+		}
+
+		for (unsigned int x = 0; x < in_prog.mask_tables.size(); x++) {
+			const filter_program::mask_table& mt = in_prog.mask_tables[x];
+
+			if (std::binary_search(mt.macs.begin(), mt.macs.end(),
+						in_mac.longmac & mt.mask))
+				return true;
+		}
+
+		return false;
+	}
+
 	GlobalRegistry *globalreg;
 
+	// Canonical filter contents, retained for parsing and joining new
+	// filter lines; never consulted per packet
 	macmap<int> bssid_map;
 	macmap<int> source_map;
 	macmap<int> dest_map;
+
+	filter_program bssid_program;
+	filter_program source_program;
+	filter_program dest_program;
 	int bssid_invert;
 	int source_invert;
 	int dest_invert;
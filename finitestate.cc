@@ -26,39 +26,39 @@ ProbeNoJoinAutomata::ProbeNoJoinAutomata(GlobalRegistry *in_globalreg,
                                          alert_time_unit in_unit, int in_rate, int in_burstrate) {
     globalreg = in_globalreg;
     alertid = globalreg->alertracker->RegisterAlert("PROBENOJOIN", in_unit, in_rate, in_burstrate);
+
+    sweep_countdown = fsa_sweep_interval;
 }
 
 ProbeNoJoinAutomata::~ProbeNoJoinAutomata() {
-    for (map<mac_addr, _fsa_element *>::iterator iter = bssid_map.begin();
-         iter != bssid_map.end(); ++iter) {
-        delete iter->second;
-    }
+
 }
 
 int ProbeNoJoinAutomata::ProcessPacket(const packet_info *in_info) {
     _fsa_element *elem;
-    map<mac_addr, _fsa_element *>::iterator iter;
+
+    // Periodically shed entries which haven't been touched; ten minutes
+    // comfortably outlives any legitimate probe/response exchange
+    if (--sweep_countdown <= 0) {
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        bssid_table.sweep(now.tv_sec, 600);
+        sweep_countdown = fsa_sweep_interval;
+    }
 
     if (in_info->type == packet_management && in_info->subtype == packet_sub_probe_req) {
         // For probe reqs we look at the source MAC and see what we have.  We'll let someone
         // probe as much as they want, they'd just better answer if a network starts talking to
         // them.  Just make a tracking record that they've been probing
-        if ((iter = bssid_map.find(in_info->source_mac)) == bssid_map.end()) {
-            elem = new _fsa_element;
-            bssid_map[in_info->source_mac] = elem;
-            return 1;
-        } else {
-            return 1;
-        }
+        elem = bssid_table.fetch_or_insert(in_info->source_mac.longmac);
+        gettimeofday(&elem->last_time, NULL);
+
+        return 1;
     } else if (in_info->type == packet_management && in_info->subtype == packet_sub_probe_resp) {
         // Responses create an element if none exists for the destination, and we set anyone getting a
         // response to state 1
-        if ((iter = bssid_map.find(in_info->dest_mac)) == bssid_map.end()) {
-            elem = new _fsa_element;
-            bssid_map[in_info->dest_mac] = elem;
-        } else {
-            elem = iter->second;
-        }
+        elem = bssid_table.fetch_or_insert(in_info->dest_mac.longmac);
+        gettimeofday(&elem->last_time, NULL);
 
         if (elem->state <= 1) {
             elem->state = 1;
@@ -68,8 +68,8 @@ int ProbeNoJoinAutomata::ProcessPacket(const packet_info *in_info) {
             if (elem->counter > 25) {
                 char atext[STATUS_MAX];
                 snprintf(atext, STATUS_MAX, "Suspicious client %s - probing networks but never participating.",
-                         iter->first.Mac2String().c_str());
-                globalreg->alertracker->RaiseAlert(alertid, 0, iter->first, 0, 0, in_info->channel, atext);
+                         in_info->dest_mac.Mac2String().c_str());
+                globalreg->alertracker->RaiseAlert(alertid, 0, in_info->dest_mac, 0, 0, in_info->channel, atext);
             }
 
         }
@@ -82,12 +82,8 @@ int ProbeNoJoinAutomata::ProcessPacket(const packet_info *in_info) {
             return 1;
 
         // If the source is our person, they're exonerated - they're doing normal traffic
-        if ((iter = bssid_map.find(in_info->source_mac)) == bssid_map.end()) {
-            elem = new _fsa_element;
-            bssid_map[in_info->source_mac] = elem;
-        } else {
-            elem = iter->second;
-        }
+        elem = bssid_table.fetch_or_insert(in_info->source_mac.longmac);
+        gettimeofday(&elem->last_time, NULL);
 
         elem->state = 2;
 
@@ -102,6 +98,8 @@ DisassocTrafficAutomata::DisassocTrafficAutomata(GlobalRegistry *in_globalreg,
                         alert_time_unit in_unit, int in_rate, int in_burstrate) {
     globalreg = in_globalreg;
     alertid = globalreg->alertracker->RegisterAlert("DISASSOCTRAFFIC", in_unit, in_rate, in_burstrate);
+
+    sweep_countdown = fsa_sweep_interval;
 }
 
 DisassocTrafficAutomata::~DisassocTrafficAutomata() {
@@ -110,43 +108,33 @@ DisassocTrafficAutomata::~DisassocTrafficAutomata() {
 
 int DisassocTrafficAutomata::ProcessPacket(const packet_info *in_info) {
     _fsa_element *elem;
-    map<mac_addr, _fsa_element *>::iterator iter;
     char atext[STATUS_MAX];
 
-    if (in_info->type == packet_management && in_info->subtype == packet_sub_disassociation) {
-        iter = source_map.find(in_info->source_mac);
+    // Periodically shed entries which aged out of the alert window without
+    // the data frame that would have erased them
+    if (--sweep_countdown <= 0) {
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        source_table.sweep(now.tv_sec, 60);
+        sweep_countdown = fsa_sweep_interval;
+    }
 
-        if (iter == source_map.end()) {
-            elem = new _fsa_element;
-            source_map[in_info->source_mac] = elem;
-            elem->counter = 0;
-        } else {
-            elem = iter->second;
-        }
+    if (in_info->type == packet_management && in_info->subtype == packet_sub_disassociation) {
+        elem = source_table.fetch_or_insert(in_info->source_mac.longmac);
 
         elem->state = 0;
         gettimeofday(&elem->last_time, NULL);
     } else if (in_info->type == packet_management && in_info->subtype == packet_sub_deauthentication) {
-        iter = source_map.find(in_info->source_mac);
-
-        if (iter == source_map.end()) {
-            elem = new _fsa_element;
-            source_map[in_info->source_mac] = elem;
-            elem->counter = 0;
-        } else {
-            elem = iter->second;
-        }
+        elem = source_table.fetch_or_insert(in_info->source_mac.longmac);
 
         elem->state = 1;
         gettimeofday(&elem->last_time, NULL);
     } else if (in_info->type == packet_data) {
-        iter = source_map.find(in_info->source_mac);
+        elem = source_table.fetch(in_info->source_mac.longmac);
 
-        if (iter == source_map.end())
+        if (elem == NULL)
             return 0;
 
-        elem = iter->second;
-
         struct timeval tv;
         gettimeofday(&tv, NULL);
 
@@ -156,13 +144,12 @@ int DisassocTrafficAutomata::ProcessPacket(const packet_info *in_info) {
 
             snprintf(atext, STATUS_MAX, "Suspicious traffic on %s.  Data traffic within 10 seconds of disassociate.",
                      in_info->source_mac.Mac2String().c_str());
-            globalreg->alertracker->RaiseAlert(alertid, in_info->bssid_mac, in_info->source_mac, 
+            globalreg->alertracker->RaiseAlert(alertid, in_info->bssid_mac, in_info->source_mac,
                                                0, 0, in_info->channel, atext);
 
             return 1;
         } else {
-            delete[] iter->second;
-            source_map.erase(iter);
+            source_table.erase(in_info->source_mac.longmac);
         }
 
     }
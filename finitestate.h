@@ -51,6 +51,155 @@ public:
         int counter;
     };
 
+    // Flat open-addressing state table keyed by the packed 64bit MAC.
+    // State lives inline in the slot array, so the per-packet lookup is a
+    // hash and a short linear probe over contiguous slots instead of
+    // chasing a tree of individually allocated elements.  Stale entries
+    // are reclaimed by periodic epoch sweeps instead of per-packet scans.
+    class _fsa_statetable {
+    public:
+        static const int slot_empty = 0;
+        static const int slot_occupied = 1;
+        // Erased slots become tombstones so probe chains stay intact;
+        // they're recycled on insert and cleared by the sweep rebuild
+        static const int slot_tombstone = 2;
+
+        class _fsa_slot {
+        public:
+            _fsa_slot() {
+                longmac = 0;
+                slotstate = slot_empty;
+            }
+
+            uint64_t longmac;
+            int slotstate;
+            _fsa_element elem;
+        };
+
+        _fsa_statetable() {
+            slots.resize(256);
+            occupied_count = 0;
+        }
+
+        // Fibonacci multiplicative hash; the table length is always a
+        // power of two
+        size_t hash_slot(uint64_t in_longmac, size_t in_len) {
+            return (size_t) ((in_longmac * 0x9E3779B97F4A7C15ULL) & (in_len - 1));
+        }
+
+        // Find an existing entry, NULL if we aren't tracking this MAC
+        _fsa_element *fetch(uint64_t in_longmac) {
+            size_t pos = hash_slot(in_longmac, slots.size());
+
+            for (size_t x = 0; x < slots.size(); x++) {
+                _fsa_slot *s = &(slots[(pos + x) & (slots.size() - 1)]);
+
+                if (s->slotstate == slot_empty)
+                    return NULL;
+
+                if (s->slotstate == slot_occupied && s->longmac == in_longmac)
+                    return &(s->elem);
+            }
+
+            return NULL;
+        }
+
+        // Find or create an entry; new entries are default-initialized
+        _fsa_element *fetch_or_insert(uint64_t in_longmac) {
+            _fsa_element *elem = fetch(in_longmac);
+
+            if (elem != NULL)
+                return elem;
+
+            // Grow at 3/4 load so probe chains stay short
+            if (occupied_count + 1 > (slots.size() / 4) * 3)
+                rehash(slots.size() * 2);
+
+            size_t pos = hash_slot(in_longmac, slots.size());
+
+            for (size_t x = 0; x < slots.size(); x++) {
+                _fsa_slot *s = &(slots[(pos + x) & (slots.size() - 1)]);
+
+                if (s->slotstate != slot_occupied) {
+                    s->slotstate = slot_occupied;
+                    s->longmac = in_longmac;
+                    s->elem = _fsa_element();
+                    occupied_count++;
+                    return &(s->elem);
+                }
+            }
+
+            return NULL;
+        }
+
+        void erase(uint64_t in_longmac) {
+            size_t pos = hash_slot(in_longmac, slots.size());
+
+            for (size_t x = 0; x < slots.size(); x++) {
+                _fsa_slot *s = &(slots[(pos + x) & (slots.size() - 1)]);
+
+                if (s->slotstate == slot_empty)
+                    return;
+
+                if (s->slotstate == slot_occupied && s->longmac == in_longmac) {
+                    s->slotstate = slot_tombstone;
+                    occupied_count--;
+                    return;
+                }
+            }
+        }
+
+        // Epoch sweep - drop entries which haven't been touched within the
+        // timeout, then rebuild, which clears accumulated tombstones and
+        // shrinks the table if the population fell
+        void sweep(time_t in_now, time_t in_timeout) {
+            for (size_t x = 0; x < slots.size(); x++) {
+                if (slots[x].slotstate != slot_occupied)
+                    continue;
+
+                if (in_now - slots[x].elem.last_time.tv_sec > in_timeout) {
+                    slots[x].slotstate = slot_tombstone;
+                    occupied_count--;
+                }
+            }
+
+            size_t target = 256;
+            while (target < occupied_count * 2)
+                target *= 2;
+
+            rehash(target);
+        }
+
+    protected:
+        void rehash(size_t in_len) {
+            std::vector<_fsa_slot> old_slots;
+            old_slots.swap(slots);
+
+            slots.resize(in_len);
+            occupied_count = 0;
+
+            for (size_t x = 0; x < old_slots.size(); x++) {
+                if (old_slots[x].slotstate != slot_occupied)
+                    continue;
+
+                size_t pos = hash_slot(old_slots[x].longmac, in_len);
+
+                for (size_t y = 0; y < in_len; y++) {
+                    _fsa_slot *s = &(slots[(pos + y) & (in_len - 1)]);
+
+                    if (s->slotstate == slot_empty) {
+                        *s = old_slots[x];
+                        occupied_count++;
+                        break;
+                    }
+                }
+            }
+        }
+
+        std::vector<_fsa_slot> slots;
+        size_t occupied_count;
+    };
+
     virtual ~FiniteAutomata() { }
 
     // Handle a packet
@@ -59,6 +208,9 @@ public:
     int FetchAlertRef() { return alertid; }
 
 protected:
+    // How many processed packets between epoch sweeps of the state table
+    static const int fsa_sweep_interval = 1024;
+
     GlobalRegistry *globalreg;
     int alertid;
 };
@@ -80,9 +232,11 @@ public:
     int ProcessPacket(const packet_info *in_info);
 
 protected:
-    // Map of probing clients to responding people.  If the client sends any "normal" data
-    // destined to that network, we reset them.
-    map<mac_addr, _fsa_element *> bssid_map;
+    // Table of probing clients to responding people.  If the client sends
+    // any "normal" data destined to that network, we reset them.
+    _fsa_statetable bssid_table;
+
+    int sweep_countdown;
 };
 
 // FSA to look for a disassociate/deauth from a client who then keeps talking.  This is
@@ -98,7 +252,9 @@ public:
 protected:
     // State 0 - got a disassoc
     // State 1 - got a deauth
-    map<mac_addr, _fsa_element *> source_map;
+    _fsa_statetable source_table;
+
+    int sweep_countdown;
 };
 
 // FSA to look for spoofing via BSS timestamp. 
@@ -0,0 +1,356 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "flat_json.h"
+
+// Scanner cursor over the raw report text
+struct flatjson_cursor {
+    const char *p;
+    const char *end;
+};
+
+static void flatjson_skip_ws(flatjson_cursor *c) {
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\t' ||
+                *c->p == '\r' || *c->p == '\n'))
+        c->p++;
+}
+
+// Decode a string token, cursor on the opening quote; handles the standard
+// escapes and utf16 \u escapes (encoded out as utf8)
+static bool flatjson_parse_string(flatjson_cursor *c, std::string& out) {
+    if (c->p >= c->end || *c->p != '"')
+        return false;
+
+    c->p++;
+
+    out.clear();
+
+    while (c->p < c->end) {
+        char ch = *c->p;
+
+        if (ch == '"') {
+            c->p++;
+            return true;
+        }
+
+        if (ch != '\\') {
+            out += ch;
+            c->p++;
+            continue;
+        }
+
+        if (c->p + 1 >= c->end)
+            return false;
+
+        c->p++;
+        ch = *c->p;
+        c->p++;
+
+        switch (ch) {
+            case '"':
+            case '\\':
+            case '/':
+                out += ch;
+                break;
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u': {
+                if (c->p + 4 > c->end)
+                    return false;
+
+                unsigned int cp = 0;
+                for (int x = 0; x < 4; x++) {
+                    char h = c->p[x];
+                    cp <<= 4;
+                    if (h >= '0' && h <= '9')
+                        cp |= (h - '0');
+                    else if (h >= 'a' && h <= 'f')
+                        cp |= (h - 'a' + 10);
+                    else if (h >= 'A' && h <= 'F')
+                        cp |= (h - 'A' + 10);
+                    else
+                        return false;
+                }
+                c->p += 4;
+
+                // Encode as utf8; surrogate pairs are out of scope for the
+                // sensor reports, a lone surrogate comes out as-is
+                if (cp < 0x80) {
+                    out += (char) cp;
+                } else if (cp < 0x800) {
+                    out += (char) (0xC0 | (cp >> 6));
+                    out += (char) (0x80 | (cp & 0x3F));
+                } else {
+                    out += (char) (0xE0 | (cp >> 12));
+                    out += (char) (0x80 | ((cp >> 6) & 0x3F));
+                    out += (char) (0x80 | (cp & 0x3F));
+                }
+
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    return false;
+}
+
+// Step over any value, tracking container depth; used for the nested
+// containers we don't retain
+static bool flatjson_skip_value(flatjson_cursor *c) {
+    flatjson_skip_ws(c);
+
+    if (c->p >= c->end)
+        return false;
+
+    if (*c->p == '"') {
+        std::string junk;
+        return flatjson_parse_string(c, junk);
+    }
+
+    if (*c->p == '{' || *c->p == '[') {
+        int depth = 0;
+
+        while (c->p < c->end) {
+            char ch = *c->p;
+
+            if (ch == '"') {
+                std::string junk;
+                if (!flatjson_parse_string(c, junk))
+                    return false;
+                continue;
+            }
+
+            if (ch == '{' || ch == '[')
+                depth++;
+            else if (ch == '}' || ch == ']')
+                depth--;
+
+            c->p++;
+
+            if (depth == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    // Bare token - number, bool, null
+    while (c->p < c->end && *c->p != ',' && *c->p != '}' && *c->p != ']' &&
+            *c->p != ' ' && *c->p != '\t' && *c->p != '\r' && *c->p != '\n')
+        c->p++;
+
+    return true;
+}
+
+bool FlatJsonReport::parse(const std::string& in_data) {
+    return parse(in_data.data(), in_data.length());
+}
+
+bool FlatJsonReport::parse(const char *in_data, size_t in_len) {
+    flatjson_cursor c;
+
+    c.p = in_data;
+    c.end = in_data + in_len;
+
+    field_map.clear();
+
+    flatjson_skip_ws(&c);
+
+    if (c.p >= c.end || *c.p != '{') {
+        field_map.clear();
+        return false;
+    }
+
+    c.p++;
+
+    flatjson_skip_ws(&c);
+
+    // Empty object
+    if (c.p < c.end && *c.p == '}')
+        return true;
+
+    while (c.p < c.end) {
+        flatjson_skip_ws(&c);
+
+        std::string key;
+        if (!flatjson_parse_string(&c, key)) {
+            field_map.clear();
+            return false;
+        }
+
+        flatjson_skip_ws(&c);
+
+        if (c.p >= c.end || *c.p != ':') {
+            field_map.clear();
+            return false;
+        }
+
+        c.p++;
+
+        flatjson_skip_ws(&c);
+
+        if (c.p >= c.end) {
+            field_map.clear();
+            return false;
+        }
+
+        field_value fv;
+
+        char ch = *c.p;
+
+        if (ch == '"') {
+            fv.type = field_string;
+            if (!flatjson_parse_string(&c, fv.str)) {
+                field_map.clear();
+                return false;
+            }
+        } else if (ch == '{' || ch == '[') {
+            // Nested container; step over it without building anything
+            if (!flatjson_skip_value(&c)) {
+                field_map.clear();
+                return false;
+            }
+        } else if (ch == 't' && c.end - c.p >= 4 && strncmp(c.p, "true", 4) == 0) {
+            fv.type = field_bool;
+            fv.bval = true;
+            c.p += 4;
+        } else if (ch == 'f' && c.end - c.p >= 5 && strncmp(c.p, "false", 5) == 0) {
+            fv.type = field_bool;
+            fv.bval = false;
+            c.p += 5;
+        } else if (ch == 'n' && c.end - c.p >= 4 && strncmp(c.p, "null", 4) == 0) {
+            // Absent field; don't record it
+            fv.type = field_none;
+            c.p += 4;
+        } else if (ch == '-' || (ch >= '0' && ch <= '9')) {
+            char *numend = NULL;
+            fv.num = strtod(c.p, &numend);
+
+            if (numend == c.p || numend > c.end) {
+                field_map.clear();
+                return false;
+            }
+
+            fv.type = field_number;
+            c.p = numend;
+        } else {
+            field_map.clear();
+            return false;
+        }
+
+        if (fv.type != field_none)
+            field_map[key] = fv;
+
+        flatjson_skip_ws(&c);
+
+        if (c.p >= c.end) {
+            field_map.clear();
+            return false;
+        }
+
+        if (*c.p == ',') {
+            c.p++;
+            continue;
+        }
+
+        if (*c.p == '}')
+            return true;
+
+        field_map.clear();
+        return false;
+    }
+
+    field_map.clear();
+    return false;
+}
+
+const FlatJsonReport::field_value *FlatJsonReport::fetch_field(const std::string& key) const {
+    auto i = field_map.find(key);
+
+    if (i == field_map.end())
+        return NULL;
+
+    return &(i->second);
+}
+
+bool FlatJsonReport::hasField(const std::string& key) const {
+    return fetch_field(key) != NULL;
+}
+
+bool FlatJsonReport::isNumber(const std::string& key) const {
+    const field_value *f = fetch_field(key);
+    return f != NULL && f->type == field_number;
+}
+
+bool FlatJsonReport::isString(const std::string& key) const {
+    const field_value *f = fetch_field(key);
+    return f != NULL && f->type == field_string;
+}
+
+bool FlatJsonReport::isBool(const std::string& key) const {
+    const field_value *f = fetch_field(key);
+    return f != NULL && f->type == field_bool;
+}
+
+double FlatJsonReport::getNumber(const std::string& key, double def) const {
+    const field_value *f = fetch_field(key);
+
+    if (f == NULL || f->type != field_number)
+        return def;
+
+    return f->num;
+}
+
+std::string FlatJsonReport::getString(const std::string& key, const std::string& def) const {
+    const field_value *f = fetch_field(key);
+
+    if (f == NULL || f->type != field_string)
+        return def;
+
+    return f->str;
+}
+
+bool FlatJsonReport::getBool(const std::string& key, bool def) const {
+    const field_value *f = fetch_field(key);
+
+    if (f == NULL || f->type != field_bool)
+        return def;
+
+    return f->bval;
+}
+
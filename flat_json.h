@@ -0,0 +1,86 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __FLAT_JSON_H__
+#define __FLAT_JSON_H__
+
+#include "config.h"
+
+#include <string>
+#include <unordered_map>
+
+/* Minimal single-pass scanner for the flat JSON reports generated by the
+ * sensor capture helpers (rtl433 and similar), which arrive at packet rate.
+ *
+ * These reports are a single object of scalar fields; running each one
+ * through the full jsoncpp DOM builds and tears down a tree of Json::Value
+ * per packet just to read back a handful of keys.  This scanner walks the
+ * text once and keeps the scalar fields in a small flat table; nested
+ * arrays and objects are skipped over rather than built, since the report
+ * schemas we consume never put interesting data there.
+ *
+ * It is NOT a general replacement for StructuredJson and shouldn't be used
+ * for the rich command dictionaries on the REST interface.
+ */
+class FlatJsonReport {
+public:
+    FlatJsonReport() { }
+
+    // Parse a complete JSON object.  Scalar fields are retained, nested
+    // containers are skipped.  Returns false on malformed input, leaving
+    // any partially-scanned fields cleared.
+    bool parse(const char *in_data, size_t in_len);
+    bool parse(const std::string& in_data);
+
+    bool hasField(const std::string& key) const;
+    bool isNumber(const std::string& key) const;
+    bool isString(const std::string& key) const;
+    bool isBool(const std::string& key) const;
+
+    // Typed fetches return the default when the field is absent or not of
+    // the requested type
+    double getNumber(const std::string& key, double def) const;
+    std::string getString(const std::string& key, const std::string& def) const;
+    bool getBool(const std::string& key, bool def) const;
+
+protected:
+    static const int field_none = 0;
+    static const int field_number = 1;
+    static const int field_string = 2;
+    static const int field_bool = 3;
+
+    struct field_value {
+        field_value() {
+            type = field_none;
+            num = 0;
+            bval = false;
+        }
+
+        int type;
+        std::string str;
+        double num;
+        bool bval;
+    };
+
+    const field_value *fetch_field(const std::string& key) const;
+
+    std::unordered_map<std::string, field_value> field_map;
+};
+
+#endif
+
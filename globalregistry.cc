@@ -36,6 +36,9 @@ GlobalRegistry::GlobalRegistry() {
 	getopt_long_num = 127;
 
 	next_ext_ref = 0;
+	ext_frozen = false;
+
+	kis_mutex_set_name(&ext_mutex, "globalreg_ext");
 
 	messagebus = NULL;
 	packetchain = NULL;
@@ -109,30 +112,37 @@ int GlobalRegistry::FetchGlobalRef(std::string in_name) {
 }
 
 std::shared_ptr<void> GlobalRegistry::FetchGlobal(int in_ref) {
-    local_locker lock(&ext_mutex);
+    local_demand_locker lock(&ext_mutex);
 
-	if (ext_data_map.find(in_ref) == ext_data_map.end())
-		return NULL;
+    // Until the table is frozen at the end of startup an insert may still
+    // grow the vector, so fetches have to serialize; after the freeze the
+    // storage is stable and this is a bare indexed load
+    if (!ext_frozen)
+        lock.lock();
+
+    if (in_ref < 1 || (size_t) in_ref >= ext_data_vec.size())
+        return NULL;
 
-	return ext_data_map[in_ref];
+    return ext_data_vec[in_ref];
 }
 
 std::shared_ptr<void> GlobalRegistry::FetchGlobal(std::string in_name) {
-    //local_locker lock(&ext_mutex);
-
 	int ref;
 
 	if ((ref = FetchGlobalRef(in_name)) < 0) {
 		return NULL;
 	}
 
-	return ext_data_map[ref];
+	return FetchGlobal(ref);
 }
 
 int GlobalRegistry::InsertGlobal(int in_ref, std::shared_ptr<void> in_data) {
-    local_locker lock(&ext_mutex);
+	local_locker lock(&ext_mutex);
+
+	if ((size_t) in_ref >= ext_data_vec.size())
+		ext_data_vec.resize(in_ref + 1);
 
-	ext_data_map[in_ref] = in_data;
+	ext_data_vec[in_ref] = in_data;
 
 	return 1;
 }
@@ -140,9 +150,18 @@ int GlobalRegistry::InsertGlobal(int in_ref, std::shared_ptr<void> in_data) {
 void GlobalRegistry::RemoveGlobal(int in_ref) {
     local_locker lock(&ext_mutex);
 
-    if (ext_data_map.find(in_ref) != ext_data_map.end()) {
-        ext_data_map.erase(ext_data_map.find(in_ref));
-    }
+    if (in_ref >= 1 && (size_t) in_ref < ext_data_vec.size())
+        ext_data_vec[in_ref].reset();
+}
+
+void GlobalRegistry::Freeze_Globals() {
+    local_locker lock(&ext_mutex);
+
+    // Leave headroom so a straggling registration (a late plugin, for
+    // instance) doesn't force a reallocation under lock-free readers
+    ext_data_vec.reserve(ext_data_vec.size() + 64);
+
+    ext_frozen = true;
 }
 
 int GlobalRegistry::InsertGlobal(std::string in_name, std::shared_ptr<void> in_data) {
@@ -262,7 +262,7 @@ public:
 	// Alert references
 	int alertref_map[ALERT_REF_MAX];
 
-	unsigned int crc32_table[256];
+	unsigned int crc32_table[4][256];
 
 	// Critical failure elements
     std::vector<critical_fail> critfail_vec;
@@ -284,6 +284,13 @@ public:
     void RemoveGlobal(int in_ref);
     void RemoveGlobal(std::string in_name);
 
+    // Freeze the global table once startup has registered everything;
+    // after this, fetching by ref is a bare indexed load with no lock,
+    // so hot-path consumers should resolve their refs once and fetch by
+    // ref.  Registration and insertion still work after the freeze but
+    // go back through the lock.
+    void Freeze_Globals();
+
     // Add a CLI extension
     typedef void (*usage_func)(const char *);
     void RegisterUsageFunc(usage_func in_cli);
@@ -307,8 +314,11 @@ protected:
     kis_recursive_timed_mutex ext_mutex;
     // Exernal global references, string to intid
     std::map<std::string, int> ext_name_map;
-    // External globals
-    std::map<int, std::shared_ptr<void> > ext_data_map;
+    // External globals, indexed directly by ref.  Once ext_frozen is set
+    // the vector never reallocates (Freeze_Globals reserves headroom for
+    // stragglers), so readers can index it without the lock.
+    std::vector<std::shared_ptr<void> > ext_data_vec;
+    bool ext_frozen;
     int next_ext_ref;
 
     kis_recursive_timed_mutex lifetime_mutex;
@@ -330,16 +340,31 @@ namespace Globalreg {
         return std::static_pointer_cast<T>(in_globalreg->FetchGlobal(in_name));
     }
 
-    template<typename T> std::shared_ptr<T> FetchMandatoryGlobalAs(GlobalRegistry *in_globalreg, 
+    template<typename T> std::shared_ptr<T> FetchMandatoryGlobalAs(GlobalRegistry *in_globalreg,
             std::string in_name) {
         std::shared_ptr<T> r = std::static_pointer_cast<T>(in_globalreg->FetchGlobal(in_name));
 
-        if (r == NULL) 
+        if (r == NULL)
             throw std::runtime_error(std::string("Unable to find '" + in_name + "' in "
                         "the global registry, code initialization may be out of order."));
 
         return r;
     }
+
+    // Fetch by a pre-resolved ref; use this on packet-rate paths, with
+    // the ref resolved once via RegisterGlobal, so the fetch is an
+    // indexed load instead of a string map walk
+    template<typename T> std::shared_ptr<T> FetchMandatoryGlobalAs(GlobalRegistry *in_globalreg,
+            int in_ref) {
+        std::shared_ptr<T> r = std::static_pointer_cast<T>(in_globalreg->FetchGlobal(in_ref));
+
+        if (r == NULL)
+            throw std::runtime_error(std::string("Unable to find global ref " +
+                        IntToString(in_ref) + " in the global registry, code "
+                        "initialization may be out of order."));
+
+        return r;
+    }
 }
 
 
@@ -19,10 +19,11 @@
 #include "config.h"
 
 #include "gpsgpsd2.h"
+#include "flat_json.h"
+#include "nmea_parse.h"
 #include "util.h"
 #include "time.h"
 #include "gpstracker.h"
-#include "kismet_json.h"
 #include "pollabletracker.h"
 #include "timetracker.h"
 
@@ -183,166 +184,103 @@ void GPSGpsdV2::BufferAvailable(size_t in_amt) {
     bool set_fix;
     bool set_heading;
 
-    std::vector<std::string> inptok = StrTokenize(std::string(buf, buf_sz), "\n", 0);
-    tcphandler->PeekFreeReadBufferData(buf);
-
-    if (inptok.size() < 1) {
-        return;
-    }
-
     set_lat_lon = false;
     set_alt = false;
     set_speed = false;
     set_fix = false;
     set_heading = false;
 
-    for (unsigned int it = 0; it < inptok.size(); it++) {
-        // Consume the data from the ringbuffer
-        tcphandler->ConsumeReadBufferData(inptok[it].length() + 1);
+    // Walk the complete lines in place in the peeked buffer; no copies of
+    // the buffer or lines are made, and a trailing partial line stays in
+    // the ring until the rest of it arrives
+    size_t consumed_sz = 0;
+    size_t pos = 0;
 
-        // Trip the garbage out of it
-        inptok[it] = StrPrintable(inptok[it]);
+    while (pos < buf_sz) {
+        const char *line = buf + pos;
+        const char *eol = (const char *) memchr(line, '\n', buf_sz - pos);
 
-        // We don't know what we're going to get from GPSD.  If it starts with 
-        // { then it probably is json, try to parse it
-        if (inptok[it][0] == '{') {
-            Json::Value json;
+        if (eol == NULL)
+            break;
 
-            try {
-                std::stringstream ss(inptok[it]);
-                ss >> json;
+        size_t line_len = eol - line;
 
-                std::string msg_class = json["class"].asString();
+        pos += line_len + 1;
+        consumed_sz = pos;
 
-                if (msg_class == "VERSION") {
-                    std::string version  = MungeToPrintable(json["release"].asString());
+        // Trim the CR garbage off the end
+        while (line_len > 0 && line[line_len - 1] == '\r')
+            line_len--;
 
-                    _MSG("GPSGpsdV2 connected to a JSON-enabled GPSD version " +
-                            version + ", turning on JSON mode", MSGFLAG_INFO);
+        if (line_len == 0)
+            continue;
 
-                    // Set JSON mode
-                    poll_mode = 10;
-                    // We get speed in meters/sec
-                    si_units = 1;
+        // We don't know what we're going to get from GPSD.  If it starts with
+        // { then it probably is json, try to parse it
+        if (line[0] == '{') {
+            FlatJsonReport json;
 
-                    // Send a JSON message that we want future communication in JSON
-                    std::string json_msg = "?WATCH={\"json\":true};\n";
+            if (!json.parse(line, line_len)) {
+                _MSG("GPSGpsdV2 - Invalid JSON block from GPSD", MSGFLAG_ERROR);
+                continue;
+            }
 
-                    if (tcphandler->PutWriteBufferData((void *) json_msg.c_str(), 
-                                json_msg.length(), true) < json_msg.length()) {
-                        _MSG("GPSGpsdV2 could not not write JSON enable command",
-                                MSGFLAG_ERROR);
-                    }
-                } else if (msg_class == "TPV") {
-                    if (json.isMember("mode")) {
-                        new_location->fix = json["mode"].asInt();
-                        set_fix = true;
-                    }
+            std::string msg_class = json.getString("class", "");
 
-                    // If we have a valid alt, use it
-                    if (set_fix && new_location->fix > 2) {
-                        if (json.isMember("alt")) {
-                            new_location->alt = json["alt"].asDouble();
-                            set_alt = true;
-                        }
-                    } 
+            if (msg_class == "VERSION") {
+                std::string version = MungeToPrintable(json.getString("release", ""));
 
-                    if (set_fix && new_location->fix >= 2) {
-                        // If we have LAT and LON, use them
-                        if (json.isMember("lat") && json.isMember("lon")) {
-                            new_location->lat = json["lat"].asDouble();
-                            new_location->lon = json["lon"].asDouble();
+                _MSG("GPSGpsdV2 connected to a JSON-enabled GPSD version " +
+                        version + ", turning on JSON mode", MSGFLAG_INFO);
 
-                            set_lat_lon = true;
-                        }
+                // Set JSON mode
+                poll_mode = 10;
+                // We get speed in meters/sec
+                si_units = 1;
 
-#if 0
-                        // If we have HDOP and VDOP, use them
-                        n = JSON_dict_get_number(json, "epx", err);
-                        if (err.length() == 0) {
-                            in_hdop = n;
-
-                            n = JSON_dict_get_number(json, "epy", err);
-                            if (err.length() == 0) {
-                                in_vdop = n;
-
-                                use_dop = 1;
-                            }
-                        }
-#endif
+                // Send a JSON message that we want future communication in JSON
+                std::string json_msg = "?WATCH={\"json\":true};\n";
 
-                        if (json.isMember("track")) {
-                            new_location->heading = json["track"].asDouble();
-                            set_heading = true;
-                        }
+                if (tcphandler->PutWriteBufferData((void *) json_msg.c_str(),
+                            json_msg.length(), true) < json_msg.length()) {
+                    _MSG("GPSGpsdV2 could not not write JSON enable command",
+                            MSGFLAG_ERROR);
+                }
+            } else if (msg_class == "TPV") {
+                if (json.isNumber("mode")) {
+                    new_location->fix = (int) json.getNumber("mode", 0);
+                    set_fix = true;
+                }
 
-                        if (json.isMember("speed")) {
-                            new_location->speed = json["speed"].asDouble();
-                            set_speed = true;
-                        }
+                // If we have a valid alt, use it
+                if (set_fix && new_location->fix > 2) {
+                    if (json.isNumber("alt")) {
+                        new_location->alt = json.getNumber("alt", 0);
+                        set_alt = true;
                     }
-#if 0
-                } else if (msg_class == "SKY") {
-                    GPSCore::sat_pos sp;
-                    struct JSON_value *v = NULL, *s = NULL;
-
-                    gps_connected = 1;
-
-                    v = JSON_dict_get_value(json, "satellites", err);
-
-                    if (err.length() == 0 && v != NULL) {
-                        sat_pos_map.clear();
-
-                        if (v->value.tok_type == JSON_arrstart) {
-                            for (unsigned int z = 0; z < v->value_array.size(); z++) {
-                                float prn, ele, az, snr;
-                                int valid = 1;
-
-                                s = v->value_array[z];
-
-                                // If we're not a dictionary in the sat array, skip
-                                if (s->value.tok_type != JSON_start) {
-                                    continue;
-                                }
-
-                                prn = JSON_dict_get_number(s, "PRN", err);
-                                if (err.length() != 0) 
-                                    valid = 0;
-
-                                ele = JSON_dict_get_number(s, "el", err);
-                                if (err.length() != 0)
-                                    valid = 0;
-
-                                az = JSON_dict_get_number(s, "az", err);
-                                if (err.length() != 0)
-                                    valid = 0;
-
-                                snr = JSON_dict_get_number(s, "ss", err);
-                                if (err.length() != 0)
-                                    valid = 0;
+                }
 
-                                if (valid) {
-                                    sp.prn = prn;
-                                    sp.elevation = ele;
-                                    sp.azimuth = az;
-                                    sp.snr = snr;
+                if (set_fix && new_location->fix >= 2) {
+                    // If we have LAT and LON, use them
+                    if (json.isNumber("lat") && json.isNumber("lon")) {
+                        new_location->lat = json.getNumber("lat", 0);
+                        new_location->lon = json.getNumber("lon", 0);
 
-                                    sat_pos_map[prn] = sp;
-                                }
-                            }
+                        set_lat_lon = true;
+                    }
 
-                        }
+                    if (json.isNumber("track")) {
+                        new_location->heading = json.getNumber("track", 0);
+                        set_heading = true;
+                    }
 
+                    if (json.isNumber("speed")) {
+                        new_location->speed = json.getNumber("speed", 0);
+                        set_speed = true;
                     }
-#endif
                 }
-
-            } catch (std::exception& e) {
-                _MSG(std::string("GPSGpsdV2 - Invalid JSON block from GPSD: ") + 
-                        std::string(e.what()), MSGFLAG_ERROR);
-                continue;
             }
-        } else if (poll_mode == 0 && inptok[it] == "GPSD") {
+        } else if (poll_mode == 0 && line_len == 4 && memcmp(line, "GPSD", 4) == 0) {
             // Look for a really old gpsd which doesn't do anything intelligent
             // with the L (version) command.  Only do this once, if we've already
             // figured out a poll mode then there's not much point in hammering
@@ -358,7 +296,8 @@ void GPSGpsdV2::BufferAvailable(size_t in_amt) {
             }
 
             continue;
-        } else if (poll_mode < 10 && inptok[it].substr(0, 15) == "GPSD,L=2 1.0-25") {
+        } else if (poll_mode < 10 && line_len >= 15 &&
+                memcmp(line, "GPSD,L=2 1.0-25", 15) == 0) {
             // Maemo ships a broken,broken GPS which doesn't parse NMEA correctly
             // and results in no alt or fix in watcher or polling modes, so we
             // have to detect this version and kick it into debug R=1 mode
@@ -372,14 +311,16 @@ void GPSGpsdV2::BufferAvailable(size_t in_amt) {
 
             // Use raw for position
             si_raw = 1;
-        } else if (poll_mode < 10 && inptok[it].substr(0, 7) == "GPSD,L=") {
+        } else if (poll_mode < 10 && line_len >= 7 &&
+                memcmp(line, "GPSD,L=", 7) == 0) {
             // Look for the version response
-            std::vector<std::string> lvec = StrTokenize(inptok[it], " ");
+            nmea_field_view lvec[8];
+            char tmp[32];
             int gma, gmi;
 
-            if (lvec.size() < 3) {
+            if (nmea_split(line, line_len, ' ', lvec, 8) < 3) {
                 poll_mode = 1;
-            } else if (sscanf(lvec[1].c_str(), "%d.%d", &gma, &gmi) != 2) {
+            } else if (sscanf(lvec[1].to_buf(tmp, sizeof(tmp)), "%d.%d", &gma, &gmi) != 2) {
                 poll_mode = 1;
             } else {
                 if (gma < 2 || (gma == 2 && gmi < 34)) {
@@ -413,31 +354,36 @@ void GPSGpsdV2::BufferAvailable(size_t in_amt) {
             }
 
 
-        } else if (poll_mode < 10 && inptok[it].substr(0, 7) == "GPSD,P=") {
+        } else if (poll_mode < 10 && line_len >= 7 &&
+                memcmp(line, "GPSD,P=", 7) == 0) {
             // Poll lines
-            std::vector<std::string> pollvec = StrTokenize(inptok[it], ",");
+            nmea_field_view pollvec[8];
+            char tmp[64];
 
-            if (pollvec.size() < 5) {
+            if (nmea_split(line, line_len, ',', pollvec, 8) < 5) {
                 continue;
             }
 
-            if (sscanf(pollvec[1].c_str(), "P=%lf %lf", 
+            if (sscanf(pollvec[1].to_buf(tmp, sizeof(tmp)), "P=%lf %lf",
                         &(new_location->lat), &(new_location->lon)) != 2) {
                 continue;
             }
 
-            if (sscanf(pollvec[4].c_str(), "M=%d", &(new_location->fix)) != 1) {
+            if (sscanf(pollvec[4].to_buf(tmp, sizeof(tmp)), "M=%d",
+                        &(new_location->fix)) != 1) {
                 continue;
             }
 
-            if (sscanf(pollvec[2].c_str(), "A=%lf", &(new_location->alt)) != 1)
+            if (sscanf(pollvec[2].to_buf(tmp, sizeof(tmp)), "A=%lf",
+                        &(new_location->alt)) != 1)
                 set_alt = false;
             else
                 set_alt = true;
 
-            if (sscanf(pollvec[3].c_str(), "V=%lf", &(new_location->speed)) != 1)
+            if (sscanf(pollvec[3].to_buf(tmp, sizeof(tmp)), "V=%lf",
+                        &(new_location->speed)) != 1)
                 set_speed = false;
-            else 
+            else
                 set_speed = true;
 
             if (set_alt && new_location->fix < 3)
@@ -450,25 +396,26 @@ void GPSGpsdV2::BufferAvailable(size_t in_amt) {
             set_fix = true;
             set_lat_lon = true;
 
-        } else if (poll_mode < 10 && inptok[it].substr(0, 7) == "GPSD,O=") {
+        } else if (poll_mode < 10 && line_len >= 7 &&
+                memcmp(line, "GPSD,O=", 7) == 0) {
             // Look for O= watch lines
-            std::vector<std::string> ggavec = StrTokenize(inptok[it], " ");
+            nmea_field_view ggavec[24];
 
-            if (ggavec.size() < 15) {
+            if (nmea_split(line, line_len, ' ', ggavec, 24) < 15) {
                 continue;
             }
 
             // Total fail if we can't get lat/lon/mode
-            if (sscanf(ggavec[3].c_str(), "%lf", &(new_location->lat)) != 1)
+            if (!nmea_field_double(ggavec[3], &(new_location->lat)))
                 continue;
 
-            if (sscanf(ggavec[4].c_str(), "%lf", &(new_location->lon)) != 1)
+            if (!nmea_field_double(ggavec[4], &(new_location->lon)))
                 continue;
 
-            if (sscanf(ggavec[14].c_str(), "%d", &(new_location->fix)) != 1)
+            if (!nmea_field_int(ggavec[14], &(new_location->fix)))
                 continue;
 
-            if (sscanf(ggavec[5].c_str(), "%lf", &(new_location->alt)) != 1)
+            if (!nmea_field_double(ggavec[5], &(new_location->alt)))
                 set_alt = false;
             else
                 set_alt = true;
@@ -481,12 +428,12 @@ void GPSGpsdV2::BufferAvailable(size_t in_amt) {
                 use_dop = 0;
 #endif
 
-            if (sscanf(ggavec[8].c_str(), "%lf", &(new_location->heading)) != 1)
+            if (!nmea_field_double(ggavec[8], &(new_location->heading)))
                 set_heading = false;
             else
                 set_heading = true;
 
-            if (sscanf(ggavec[9].c_str(), "%lf", &(new_location->speed)) != 1)
+            if (!nmea_field_double(ggavec[9], &(new_location->speed)))
                 set_speed = false;
             else
                 set_speed = true;
@@ -505,47 +452,49 @@ void GPSGpsdV2::BufferAvailable(size_t in_amt) {
 
             set_fix = true;
             set_lat_lon = true;
-        } else if (poll_mode < 10 && si_raw && inptok[it].substr(0, 6) == "$GPGSA") {
-            std::vector<std::string> savec = StrTokenize(inptok[it], ",");
+        } else if (poll_mode < 10 && si_raw && line_len >= 6 &&
+                memcmp(line, "$GPGSA", 6) == 0) {
+            nmea_field_view savec[24];
 
-            if (savec.size() != 18)
+            if (nmea_split(line, line_len, ',', savec, 24) != 18)
                 continue;
 
-            if (sscanf(savec[2].c_str(), "%d", &(new_location->fix)) != 1)
+            if (!nmea_field_int(savec[2], &(new_location->fix)))
                 continue;
 
             set_fix = true;
-        } else if (si_raw && inptok[it].substr(0, 6) == "$GPVTG") {
-            std::vector<std::string> vtvec = StrTokenize(inptok[it], ",");
+        } else if (si_raw && line_len >= 6 && memcmp(line, "$GPVTG", 6) == 0) {
+            nmea_field_view vtvec[24];
 
-            if (vtvec.size() != 10)
+            if (nmea_split(line, line_len, ',', vtvec, 24) != 10)
                 continue;
 
-            if (sscanf(vtvec[7].c_str(), "%lf", &(new_location->speed)) != 1)
+            if (!nmea_field_double(vtvec[7], &(new_location->speed)))
                 continue;
 
             set_speed = true;
-        } else if (poll_mode < 10 && si_raw && inptok[it].substr(0, 6) == "$GPGGA") {
-            std::vector<std::string> gavec = StrTokenize(inptok[it], ",");
-            int tint;
+        } else if (poll_mode < 10 && si_raw && line_len >= 6 &&
+                memcmp(line, "$GPGGA", 6) == 0) {
+            nmea_field_view gavec[24];
+            double coord;
             float tfloat;
 
-            if (gavec.size() != 15)
+            if (nmea_split(line, line_len, ',', gavec, 24) != 15)
                 continue;
 
-            if (sscanf(gavec[2].c_str(), "%2d%f", &tint, &tfloat) != 2)
+            if (!nmea_field_coord(gavec[2], 2, &coord))
                 continue;
-            new_location->lat = (float) tint + (tfloat / 60);
-            if (gavec[3] == "S")
+            new_location->lat = coord;
+            if (gavec[3].equals("S"))
                 new_location->lat *= -1;
 
-            if (sscanf(gavec[4].c_str(), "%3d%f", &tint, &tfloat) != 2)
+            if (!nmea_field_coord(gavec[4], 3, &coord))
                 continue;
-            new_location->lon = (float) tint + (tfloat / 60);
-            if (gavec[5] == "W")
+            new_location->lon = coord;
+            if (gavec[5].equals("W"))
                 new_location->lon *= -1;
 
-            if (sscanf(gavec[9].c_str(), "%f", &tfloat) != 1)
+            if (!nmea_field_float(gavec[9], &tfloat))
                 continue;
             new_location->alt = tfloat;
 
@@ -603,6 +552,12 @@ void GPSGpsdV2::BufferAvailable(size_t in_amt) {
         } 
     }
 
+    // Unlock the peek and consume the complete lines we processed
+    tcphandler->PeekFreeReadBufferData(buf);
+
+    if (consumed_sz > 0)
+        tcphandler->ConsumeReadBufferData(consumed_sz);
+
     // fprintf(stderr, "gps set loc %d alt %d spd %d fix %d heading %d\n", set_lat_lon, set_alt, set_speed, set_fix, set_heading);
 
     if (set_alt || set_speed || set_lat_lon || set_fix || set_heading) {
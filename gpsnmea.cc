@@ -21,6 +21,7 @@
 #include <time.h>
 
 #include "gpsnmea.h"
+#include "nmea_parse.h"
 #include "util.h"
 #include "gpstracker.h"
 #include "pollabletracker.h"
@@ -35,18 +36,6 @@ void GPSNMEA::BufferAvailable(size_t in_amt) {
     buf_sz = nmeahandler->PeekReadBufferData((void **) &buf, 
             nmeahandler->GetReadBufferAvailable());
 
-    // Aggregate into a new location; then copy into the main location
-    // depending on what we found.  Locations can come in multiple sentences
-    // so if we're within a second of the previous one we can aggregate them
-    std::vector<std::string> inptok = StrTokenize(std::string(buf, buf_sz), "\n", 0);
-
-    // We've tokenized a copy of the buffer so unlock what we peeked
-    nmeahandler->PeekFreeReadBufferData(buf);
-
-    if (inptok.size() < 1) {
-        return;
-    }
-
     kis_gps_packinfo *new_location = new kis_gps_packinfo;
     bool set_lat_lon;
     bool set_alt;
@@ -58,49 +47,68 @@ void GPSNMEA::BufferAvailable(size_t in_amt) {
     set_speed = false;
     set_fix = false;
 
-    // TODO fix assumptions about token length and spacing...
-    for (unsigned int it = 0; it < inptok.size(); it++) {
-        // Consume the data from the ringbuffer
-        nmeahandler->ConsumeReadBufferData(inptok[it].length() + 1);
+    // Aggregate into a new location; then copy into the main location
+    // depending on what we found.  Locations can come in multiple sentences
+    // so if we're within a second of the previous one we can aggregate them.
+    //
+    // Walk the complete lines in place in the peeked buffer - no copies of
+    // the buffer or sentences are made.  A trailing partial line stays in
+    // the ring until the rest of it arrives.
+    size_t consumed_sz = 0;
+    size_t pos = 0;
 
-        if (inptok[it].length() < 4)
-            continue;
+    while (pos < buf_sz) {
+        const char *line = buf + pos;
+        const char *eol = (const char *) memchr(line, '\n', buf_sz - pos);
 
-        // $GPGGA,012527.000,4142.6918,N,07355.8711,W,1,07,1.2,57.8,M,-34.0,M,,0000*57
+        if (eol == NULL)
+            break;
 
-        std::vector<std::string> gpstoks = StrTokenize(inptok[it], ",");
+        size_t line_len = eol - line;
 
-        if (gpstoks.size() == 0)
+        pos += line_len + 1;
+        consumed_sz = pos;
+
+        // Trim trailing CR
+        while (line_len > 0 && line[line_len - 1] == '\r')
+            line_len--;
+
+        // Everything we know starts with a 6 byte sentence type; dispatch
+        // on that before splitting anything
+        if (line_len < 6)
             continue;
 
-        if (gpstoks[0] == "$GPGGA") {
-            int tint;
+        // $GPGGA,012527.000,4142.6918,N,07355.8711,W,1,07,1.2,57.8,M,-34.0,M,,0000*57
+
+        if (memcmp(line, "$GPGGA", 6) == 0) {
+            nmea_field_view gpstoks[24];
+            double coord;
             float tfloat;
 
-            if (gpstoks.size() < 15)
+            if (nmea_split(line, line_len, ',', gpstoks, 24) < 15)
                 continue;
 
             // Parse the basic gps coodinate string
             // $GPGGA,time,lat,NS,lon,EW,quality,#sats,hdop,alt,M,geopos,M,
             // dgps1,dgps2,checksum
 
-            if (sscanf(gpstoks[2].c_str(), "%2d%f", &tint, &tfloat) != 2)
+            if (!nmea_field_coord(gpstoks[2], 2, &coord))
                 continue;
-            new_location->lat = (float) tint + (tfloat / 60);
-            if (gpstoks[3] == "S")
+            new_location->lat = coord;
+            if (gpstoks[3].equals("S"))
                 new_location->lat *= -1;
 
-            if (sscanf(gpstoks[4].c_str(), "%3d%f", &tint, &tfloat) != 2)
+            if (!nmea_field_coord(gpstoks[4], 3, &coord))
                 continue;
-            new_location->lon = (float) tint + (tfloat / 60);
-            if (gpstoks[5] == "W")
+            new_location->lon = coord;
+            if (gpstoks[5].equals("W"))
                 new_location->lon *= -1;
 
             set_lat_lon = true;
             if (new_location->fix < 2)
                 new_location->fix = 2;
 
-            if (sscanf(gpstoks[9].c_str(), "%f", &tfloat) != 1)
+            if (!nmea_field_float(gpstoks[9], &tfloat))
                 continue;
 
             new_location->alt = tfloat;
@@ -114,18 +122,19 @@ void GPSNMEA::BufferAvailable(size_t in_amt) {
             continue;
         }
 
-        if (gpstoks[0] == "$GPRMC") {
+        if (memcmp(line, "$GPRMC", 6) == 0) {
             // recommended minimum
             // $GPRMC,time,valid,lat,lathemi,lon,lonhemi,speed-knots,bearing,utc,,checksum
-            int tint;
+            nmea_field_view gpstoks[24];
+            double coord;
             float tfloat;
 
-            if (gpstoks.size() < 12)
+            if (nmea_split(line, line_len, ',', gpstoks, 24) < 12)
                 continue;
 
-            if (gpstoks[2] == "A") {
+            if (gpstoks[2].equals("A")) {
                 // Kluge - if we have a 3d fix, we're getting another sentence
-                // which contains better information, so we don't override it. 
+                // which contains better information, so we don't override it.
                 // If we < a 2d fix, we up it to 2d.
                 if (new_location->fix < 2)
                     new_location->fix = 2;
@@ -134,23 +143,23 @@ void GPSNMEA::BufferAvailable(size_t in_amt) {
                 continue;
             }
 
-            if (sscanf(gpstoks[3].c_str(), "%2d%f", &tint, &tfloat) != 2)
+            if (!nmea_field_coord(gpstoks[3], 2, &coord))
                 continue;
-            new_location->lat = (float) tint + (tfloat / 60);
-            if (gpstoks[4] == "S")
+            new_location->lat = coord;
+            if (gpstoks[4].equals("S"))
                 new_location->lat *= -1;
 
-            if (sscanf(gpstoks[5].c_str(), "%3d%f", &tint, &tfloat) != 2)
+            if (!nmea_field_coord(gpstoks[5], 3, &coord))
                 continue;
-            new_location->lon = (float) tint + (tfloat / 60);
-            if (gpstoks[6] == "W")
+            new_location->lon = coord;
+            if (gpstoks[6].equals("W"))
                 new_location->lon *= -1;
 
             if (new_location->fix < 2)
                 new_location->fix = 2;
             set_fix = true;
 
-            if (sscanf(gpstoks[7].c_str(), "%f", &tfloat) != 1) 
+            if (!nmea_field_float(gpstoks[7], &tfloat))
                 continue;
             new_location->speed = tfloat;
             set_speed = true;
@@ -204,29 +213,30 @@ A        Auto selection of 2D or 3D fix (M = manual)
 #endif
 
         // Travel made good, also a source of speed
-        if (gpstoks[0] == "$GPVTG") {
+        if (memcmp(line, "$GPVTG", 6) == 0) {
             // $GPVTG,,T,,M,0.00,N,0.0,K,A*13
+            nmea_field_view gpstoks[24];
             float tfloat;
 
-            if (gpstoks.size() < 10) {
+            if (nmea_split(line, line_len, ',', gpstoks, 24) < 10) {
                 continue;
             }
 
             // Only use VTG if we didn't get our speed from another sentence
             // in this series
             if (set_speed == 0) {
-                if (sscanf(gpstoks[7].c_str(), "%f", &tfloat) != 1) 
+                if (!nmea_field_float(gpstoks[7], &tfloat))
                     continue;
                 new_location->speed = tfloat;
                 set_speed = 1;
             }
 
             continue;
-        } 
+        }
 
         // Satellites in view
         // TODO figure out if we can use this data and so something smarter with it
-        if (inptok[it].substr(0, 6) == "$GPGSV") {
+        if (memcmp(line, "$GPGSV", 6) == 0) {
             // $GPGSV,3,1,09,22,80,170,40,14,58,305,19,01,46,291,,18,44,140,33*7B
             // $GPGSV,3,2,09,05,39,105,31,12,34,088,32,30,31,137,31,09,26,047,34*72
             // $GPGSV,3,3,09,31,26,222,31*46
@@ -276,6 +286,12 @@ A        Auto selection of 2D or 3D fix (M = manual)
 
     }
 
+    // Unlock the peek and consume the complete lines we processed
+    nmeahandler->PeekFreeReadBufferData(buf);
+
+    if (consumed_sz > 0)
+        nmeahandler->ConsumeReadBufferData(consumed_sz);
+
     if (set_alt || set_speed || set_lat_lon || set_fix) {
         ever_seen_gps = true;
 
@@ -43,6 +43,8 @@ GpsTracker::GpsTracker(GlobalRegistry *in_globalreg) :
 
     globalreg = in_globalreg;
 
+    location_snapshot = NULL;
+
     // Register the gps component
     _PCM(PACK_COMP_GPS) =
         globalreg->packetchain->RegisterPacketComponent("gps");
@@ -102,6 +104,10 @@ GpsTracker::~GpsTracker() {
         Globalreg::FetchMandatoryGlobalAs<Timetracker>(globalreg, "TIMETRACKER");
 
     timetracker->RemoveTimer(log_snapshot_timer);
+
+    // Drop our reference to the shared fix snapshot
+    if (location_snapshot != NULL)
+        snapshot_releaser.release(location_snapshot);
 }
 
 void GpsTracker::log_snapshot_gps() {
@@ -244,6 +250,51 @@ kis_gps_packinfo *GpsTracker::get_best_location() {
     return NULL;
 }
 
+kis_gps_packinfo *GpsTracker::get_best_location_snapshot() {
+    local_locker lock(&gpsmanager_mutex);
+
+    for (auto d : gps_instances_vec) {
+        SharedGps gps = std::static_pointer_cast<KisGps>(d);
+
+        if (gps->get_gps_data_only())
+            continue;
+
+        if (gps->get_location_valid()) {
+            kis_gps_packinfo *loc = gps->get_location();
+
+            // Re-use the snapshot if we're still in the same fix epoch;
+            // every packet between fix updates shares one record
+            if (location_snapshot != NULL &&
+                    location_snapshot->tv.tv_sec == loc->tv.tv_sec &&
+                    location_snapshot->tv.tv_usec == loc->tv.tv_usec &&
+                    location_snapshot->gpsuuid == gps->get_gps_uuid()) {
+                location_snapshot->snapshot_refcount++;
+                return location_snapshot;
+            }
+
+            // The fix changed; drop our reference to the old snapshot and
+            // build a new one
+            if (location_snapshot != NULL)
+                snapshot_releaser.release(location_snapshot);
+
+            kis_gps_packinfo *pi = new kis_gps_packinfo(loc);
+
+            pi->gpsuuid = gps->get_gps_uuid();
+            pi->gpsname = gps->get_gps_name();
+
+            // One reference for us, one for the caller
+            pi->component_pool = &snapshot_releaser;
+            pi->snapshot_refcount = 2;
+
+            location_snapshot = pi;
+
+            return pi;
+        }
+    }
+
+    return NULL;
+}
+
 int GpsTracker::kis_gpspack_hook(CHAINCALL_PARMS) {
     // We're an 'external user' of GpsTracker despite being inside it,
     // so don't do thread locking - that's up to GpsTracker internals
@@ -255,7 +306,7 @@ int GpsTracker::kis_gpspack_hook(CHAINCALL_PARMS) {
     if (in_pack->fetch(_PCM(PACK_COMP_GPS)) != NULL)
         return 1;
 
-    kis_gps_packinfo *gpsloc = gpstracker->get_best_location();
+    kis_gps_packinfo *gpsloc = gpstracker->get_best_location_snapshot();
 
     if (gpsloc == NULL)
         return 0;
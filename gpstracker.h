@@ -21,6 +21,7 @@
 
 #include "config.h"
 
+#include <atomic>
 
 #include "kis_mutex.h"
 #include "packetchain.h"
@@ -44,9 +45,12 @@ public:
 		fix = 0;
         tv.tv_sec = 0;
         tv.tv_usec = 0;
+        snapshot_refcount = 0;
 	}
 
     kis_gps_packinfo(kis_gps_packinfo *src) {
+        snapshot_refcount = 0;
+
         if (src != NULL) {
             self_destruct = src->self_destruct;
 
@@ -100,6 +104,23 @@ public:
 
     // Name of GPS that created us
     std::string gpsname;
+
+    // References held when we're a shared fix snapshot; the snapshot
+    // releaser deletes us when the last reference drops
+    std::atomic<unsigned int> snapshot_refcount;
+};
+
+// Releaser for shared fix snapshots; rides the packet component pool hook
+// so a packet tearing down drops a reference to the shared snapshot
+// instead of deleting it
+class kis_gps_packinfo_snapshot_releaser : public packet_component_pool_base {
+public:
+    virtual void release(packet_component *in_component) {
+        kis_gps_packinfo *pi = static_cast<kis_gps_packinfo *>(in_component);
+
+        if (pi->snapshot_refcount.fetch_sub(1) == 1)
+            delete pi;
+    }
 };
 
 /* GPS manager which handles configuring GPS sources and deciding which one
@@ -138,10 +159,15 @@ public:
     // Set a primary GPS
     bool set_primary_gps(uuid in_uuid);
 
-    // Get the 'best' location - returns a NEW gpspackinfo which the caller is 
+    // Get the 'best' location - returns a NEW gpspackinfo which the caller is
     // responsible for deleting.
     kis_gps_packinfo *get_best_location();
 
+    // Get the 'best' location as a shared refcounted snapshot; packets
+    // captured during the same fix epoch share one record, and the
+    // reference is dropped through the packet component teardown path
+    kis_gps_packinfo *get_best_location_snapshot();
+
     // Populate packets that don't have a GPS location
     static int kis_gpspack_hook(CHAINCALL_PARMS);
 
@@ -153,11 +179,16 @@ protected:
     SharedTrackerElement gps_prototypes;
     TrackerElementVector gps_prototypes_vec;
 
-    // GPS instances, as a vector, sorted by priority; we don't mind doing a 
+    // GPS instances, as a vector, sorted by priority; we don't mind doing a
     // linear search because we'll typically have very few GPS devices
     SharedTrackerElement gps_instances;
     TrackerElementVector gps_instances_vec;
 
+    // Shared snapshot of the current fix epoch; we hold one reference,
+    // each tagged packet holds another
+    kis_gps_packinfo *location_snapshot;
+    kis_gps_packinfo_snapshot_releaser snapshot_releaser;
+
     // Extra field we insert into a location triplet
     int tracked_uuid_addition_id;
 
@@ -22,8 +22,11 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <spawn.h>
 #include <sstream>
 
+extern char **environ;
+
 #include "util.h"
 #include "messagebus.h"
 #include "ipc_remote2.h"
@@ -217,69 +220,70 @@ int IPCRemoteV2::launch_kis_explicit_binary(std::string cmdpath, std::vector<std
 
     sigprocmask(SIG_BLOCK, &mask, &oldmask);
 
-    if ((child_pid = fork()) < 0) {
-        _MSG("IPC could not fork()", MSGFLAG_ERROR);
-        local_unlocker ulock(&ipc_locker);
-    } else if (child_pid == 0) {
-        // We're the child process
-      
-#if 0
-        cmdarg = new char*[args.size() + 8];
-
-        cmdarg[0] = strdup("valgrind");
-        cmdarg[1] = strdup("--tool=memcheck");
-        cmdarg[2] = strdup("--leak-check=full");
-        cmdarg[3] = strdup("--show-leak-kinds=all");
-        cmdarg[4] = strdup(cmdpath.c_str());
-
-        // Child reads from inpair
-        arg << "--in-fd=" << inpipepair[0];
-        cmdarg[5] = strdup(arg.str().c_str());
-        arg.str("");
-
-        // Child writes to writepair
-        arg << "--out-fd=" << outpipepair[1];
-        cmdarg[6] = strdup(arg.str().c_str());
-
-        for (unsigned int x = 0; x < args.size(); x++)
-            cmdarg[x+7] = strdup(args[x].c_str());
-
-        cmdarg[args.size() + 7] = NULL;
-#else
-        // argv[0], "--in-fd" "--out-fd" ... NULL
-        cmdarg = new char*[args.size() + 4];
-        cmdarg[0] = strdup(cmdpath.c_str());
+    // Build the command line in our own process; with posix_spawn there is
+    // no forked child to build it in, and no copy-on-write clone of our
+    // heap for the capture binary launch to fault against
+    //
+    // argv[0], "--in-fd" "--out-fd" ... NULL
+    cmdarg = new char*[args.size() + 4];
+    cmdarg[0] = strdup(cmdpath.c_str());
 
-        // Child reads from inpair
-        arg << "--in-fd=" << inpipepair[0];
-        cmdarg[1] = strdup(arg.str().c_str());
-        arg.str("");
+    // Child reads from inpair
+    arg << "--in-fd=" << inpipepair[0];
+    cmdarg[1] = strdup(arg.str().c_str());
+    arg.str("");
 
-        // Child writes to writepair
-        arg << "--out-fd=" << outpipepair[1];
-        cmdarg[2] = strdup(arg.str().c_str());
+    // Child writes to writepair
+    arg << "--out-fd=" << outpipepair[1];
+    cmdarg[2] = strdup(arg.str().c_str());
 
-        for (unsigned int x = 0; x < args.size(); x++)
-            cmdarg[x+3] = strdup(args[x].c_str());
+    for (unsigned int x = 0; x < args.size(); x++)
+        cmdarg[x+3] = strdup(args[x].c_str());
 
-        cmdarg[args.size() + 3] = NULL;
-#endif
+    cmdarg[args.size() + 3] = NULL;
+
+    posix_spawn_file_actions_t fileactions;
+    posix_spawn_file_actions_init(&fileactions);
+
+    // Close our halves of the pairs in the child; its halves are passed
+    // by number via --in-fd/--out-fd
+    posix_spawn_file_actions_addclose(&fileactions, inpipepair[1]);
+    posix_spawn_file_actions_addclose(&fileactions, outpipepair[0]);
+
+    posix_spawnattr_t spawnattr;
+    posix_spawnattr_init(&spawnattr);
+
+    // Launch the child with the original signal mask, not our blocked one
+    posix_spawnattr_setsigmask(&spawnattr, &oldmask);
+    posix_spawnattr_setflags(&spawnattr, POSIX_SPAWN_SETSIGMASK);
+
+    int sret = posix_spawnp(&child_pid, cmdpath.c_str(), &fileactions,
+            &spawnattr, cmdarg, environ);
 
-        // Close the unused half of the pairs on the child
+    posix_spawn_file_actions_destroy(&fileactions);
+    posix_spawnattr_destroy(&spawnattr);
+
+    for (unsigned int x = 0; cmdarg[x] != NULL; x++)
+        free(cmdarg[x]);
+    delete[] cmdarg;
+
+    if (sret != 0) {
+        _MSG("IPC could not launch '" + cmdpath + "': " + kis_strerror_r(sret),
+                MSGFLAG_ERROR);
+
+        close(inpipepair[0]);
         close(inpipepair[1]);
         close(outpipepair[0]);
+        close(outpipepair[1]);
 
-        // Un-mask the child signals
         sigprocmask(SIG_UNBLOCK, &mask, &oldmask);
 
-        // fprintf(stderr, "debug - ipcremote2 - exec %s\n", cmdarg[0]);
-        execvp(cmdarg[0], cmdarg);
+        local_unlocker ulock(&ipc_locker);
+        return -1;
+    }
 
-        exit(255);
-    } 
-   
     // Parent process
-   
+
     // fprintf(stderr, "debug - ipcremote2 creating pipeclient\n");
 
     pipeclient.reset(new PipeClient(globalreg, ipchandler));
@@ -374,36 +378,61 @@ int IPCRemoteV2::launch_standard_explicit_binary(std::string cmdpath, std::vecto
 
     sigprocmask(SIG_BLOCK, &mask, &oldmask);
 
-    if ((child_pid = fork()) < 0) {
-        _MSG("IPC could not fork()", MSGFLAG_ERROR);
-        local_unlocker ulock(&ipc_locker);
-    } else if (child_pid == 0) {
-        // We're the child process
-        
-        // argv[0], "--in-fd" "--out-fd" ... NULL
-        cmdarg = new char*[args.size() + 1];
-        cmdarg[0] = strdup(cmdpath.c_str());
+    // Build the command line in our own process; with posix_spawn there is
+    // no forked child to build it in
+    //
+    // argv[0], ... NULL
+    cmdarg = new char*[args.size() + 2];
+    cmdarg[0] = strdup(cmdpath.c_str());
+
+    for (unsigned int x = 0; x < args.size(); x++)
+        cmdarg[x+1] = strdup(args[x].c_str());
+
+    cmdarg[args.size() + 1] = NULL;
+
+    posix_spawn_file_actions_t fileactions;
+    posix_spawn_file_actions_init(&fileactions);
+
+    // Clone over the stdin/stdout and close the pipe fds in the child
+    posix_spawn_file_actions_adddup2(&fileactions, inpipepair[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&fileactions, outpipepair[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&fileactions, inpipepair[0]);
+    posix_spawn_file_actions_addclose(&fileactions, inpipepair[1]);
+    posix_spawn_file_actions_addclose(&fileactions, outpipepair[0]);
+    posix_spawn_file_actions_addclose(&fileactions, outpipepair[1]);
+
+    posix_spawnattr_t spawnattr;
+    posix_spawnattr_init(&spawnattr);
+
+    // Launch the child with the original signal mask, not our blocked one
+    posix_spawnattr_setsigmask(&spawnattr, &oldmask);
+    posix_spawnattr_setflags(&spawnattr, POSIX_SPAWN_SETSIGMASK);
 
-        for (unsigned int x = 0; x < args.size(); x++)
-            cmdarg[x+3] = strdup(args[x].c_str());
+    int sret = posix_spawnp(&child_pid, cmdpath.c_str(), &fileactions,
+            &spawnattr, cmdarg, environ);
 
-        cmdarg[args.size() + 1] = NULL;
+    posix_spawn_file_actions_destroy(&fileactions);
+    posix_spawnattr_destroy(&spawnattr);
 
-        // Clone over the stdin/stdout
-        dup2(inpipepair[0], STDIN_FILENO);
-        dup2(outpipepair[1], STDOUT_FILENO);
+    for (unsigned int x = 0; cmdarg[x] != NULL; x++)
+        free(cmdarg[x]);
+    delete[] cmdarg;
+
+    if (sret != 0) {
+        _MSG("IPC could not launch '" + cmdpath + "': " + kis_strerror_r(sret),
+                MSGFLAG_ERROR);
 
-        // Close the remote side of the pipes
         close(inpipepair[0]);
+        close(inpipepair[1]);
+        close(outpipepair[0]);
         close(outpipepair[1]);
 
-        execvp(cmdarg[0], cmdarg);
+        sigprocmask(SIG_UNBLOCK, &mask, &oldmask);
 
-        exit(255);
-    } 
+        local_unlocker ulock(&ipc_locker);
+        return -1;
+    }
 
-    // Only reach here if we're the parent process
-    
     // Close the remote side of the pipes
     close(inpipepair[1]);
     close(outpipepair[0]);
@@ -19,6 +19,7 @@
 #include "config.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include <list>
 #include <map>
@@ -36,11 +37,224 @@
 #include "devicetracker_component.h"
 #include "json_adapter.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Find the first character needing a json escape (backslash or quote) at
+// or after pos; returns the string length when the remainder is clean.
+// String escaping sits near the top of the serialization profile and the
+// overwhelming majority of strings need no escaping, so the scan is
+// vectorized where we can and runs 8 bytes at a time everywhere else.
+static size_t json_find_escapable(const char *data, size_t len, size_t pos) {
+#ifdef __SSE2__
+    const __m128i v_bs = _mm_set1_epi8('\\');
+    const __m128i v_qt = _mm_set1_epi8('"');
+
+    while (pos + 16 <= len) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) (data + pos));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, v_bs),
+                _mm_cmpeq_epi8(chunk, v_qt));
+
+        int mask = _mm_movemask_epi8(hits);
+
+        if (mask != 0)
+            return pos + __builtin_ctz(mask);
+
+        pos += 16;
+    }
+#else
+    // SWAR byte-equality scan; a byte of (x ^ pattern) is zero exactly
+    // where x matched the pattern
+    const uint64_t rep_bs = (uint64_t) 0x0101010101010101ULL * '\\';
+    const uint64_t rep_qt = (uint64_t) 0x0101010101010101ULL * '"';
+    const uint64_t lo = (uint64_t) 0x0101010101010101ULL;
+    const uint64_t hi = (uint64_t) 0x8080808080808080ULL;
+
+    while (pos + 8 <= len) {
+        uint64_t chunk;
+        memcpy(&chunk, data + pos, 8);
+
+        uint64_t x_bs = chunk ^ rep_bs;
+        uint64_t x_qt = chunk ^ rep_qt;
+
+        uint64_t hitmask = (((x_bs - lo) & ~x_bs) | ((x_qt - lo) & ~x_qt)) & hi;
+
+        if (hitmask != 0)
+            break;
+
+        pos += 8;
+    }
+#endif
+
+    while (pos < len) {
+        if (data[pos] == '\\' || data[pos] == '"')
+            return pos;
+        pos++;
+    }
+
+    return len;
+}
+
+// Two-digit lookup used by the integer formatter; writing digit pairs
+// halves the divisions and the final reverse
+static const char json_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Format an unsigned int into buf (which must hold 20 digits), returning
+// the length; digits are written in pairs from the tail
+static size_t json_utoa(uint64_t v, char *buf) {
+    char tmp[20];
+    char *p = tmp + 20;
+
+    while (v >= 100) {
+        unsigned int pair = (unsigned int) (v % 100) * 2;
+        v /= 100;
+        *(--p) = json_digit_pairs[pair + 1];
+        *(--p) = json_digit_pairs[pair];
+    }
+
+    if (v >= 10) {
+        unsigned int pair = (unsigned int) v * 2;
+        *(--p) = json_digit_pairs[pair + 1];
+        *(--p) = json_digit_pairs[pair];
+    } else {
+        *(--p) = '0' + (char) v;
+    }
+
+    size_t len = (tmp + 20) - p;
+    memcpy(buf, p, len);
+    return len;
+}
+
+static void json_write_uint(std::ostream& stream, uint64_t v) {
+    char buf[20];
+    stream.write(buf, json_utoa(v, buf));
+}
+
+static void json_write_int(std::ostream& stream, int64_t v) {
+    char buf[21];
+    char *p = buf;
+
+    uint64_t uv;
+
+    if (v < 0) {
+        *p++ = '-';
+        uv = ((uint64_t) ~v) + 1;
+    } else {
+        uv = (uint64_t) v;
+    }
+
+    stream.write(buf, (p - buf) + json_utoa(uv, p));
+}
+
+// Format a finite double the way the serializer always has - fixed point,
+// six fractional digits - without going through the ostream numeric
+// machinery, which dominates the profile on large dumps full of signal,
+// location, and timestamp values.  Magnitudes past the uint64 integer
+// range are rare (and already past the point where fixed-point output is
+// meaningful) and fall back to snprintf.
+static void json_write_double(std::ostream& stream, double v) {
+    char buf[48];
+    char *p = buf;
+
+    // Value cases are screened for nan/inf before getting here, but map
+    // keys arrive unscreened
+    if (std::isnan(v) || std::isinf(v)) {
+        int n = snprintf(buf, sizeof(buf), "%f", v);
+        stream.write(buf, n);
+        return;
+    }
+
+    if (v < 0) {
+        *p++ = '-';
+        v = -v;
+    }
+
+    if (v >= 1.8e19) {
+        int n = snprintf(p, sizeof(buf) - (p - buf), "%f", v);
+        stream.write(buf, (p - buf) + n);
+        return;
+    }
+
+    uint64_t ip = (uint64_t) v;
+    uint64_t frac = (uint64_t) ((v - (double) ip) * 1000000.0 + 0.5);
+
+    if (frac >= 1000000) {
+        ip++;
+        frac = 0;
+    }
+
+    p += json_utoa(ip, p);
+
+    *p++ = '.';
+
+    // Six zero-padded fractional digits
+    for (int x = 4; x >= 0; x -= 2) {
+        unsigned int pair = (unsigned int) (frac % 100) * 2;
+        frac /= 100;
+        p[x + 1] = json_digit_pairs[pair + 1];
+        p[x] = json_digit_pairs[pair];
+    }
+    p += 6;
+
+    stream.write(buf, p - buf);
+}
 
 std::string JsonAdapter::SanitizeString(std::string in) {
-    std::string itr = MultiReplaceAll(in, "\\", "\\\\");
-    itr = MultiReplaceAll(itr, "\"", "\\\"");
-    return itr;
+    size_t esc = json_find_escapable(in.data(), in.length(), 0);
+
+    // Hand clean strings straight back
+    if (esc == in.length())
+        return in;
+
+    std::string r;
+    r.reserve(in.length() + 8);
+
+    size_t pos = 0;
+
+    while (true) {
+        r.append(in, pos, esc - pos);
+
+        if (esc == in.length())
+            break;
+
+        r += '\\';
+        r += in[esc];
+
+        pos = esc + 1;
+        esc = json_find_escapable(in.data(), in.length(), pos);
+    }
+
+    return r;
+}
+
+void JsonAdapter::SanitizeStringTo(std::ostream& stream, const std::string& in) {
+    size_t pos = 0;
+    size_t esc = json_find_escapable(in.data(), in.length(), 0);
+
+    while (true) {
+        if (esc != pos)
+            stream.write(in.data() + pos, esc - pos);
+
+        if (esc == in.length())
+            return;
+
+        stream.write("\\", 1);
+        stream.write(in.data() + esc, 1);
+
+        pos = esc + 1;
+        esc = json_find_escapable(in.data(), in.length(), pos);
+    }
 }
 
 void JsonAdapter::Pack(GlobalRegistry *globalreg, std::ostream &stream,
@@ -84,6 +298,7 @@ void JsonAdapter::Pack(GlobalRegistry *globalreg, std::ostream &stream,
 
     mac_addr mac;
     uuid euuid;
+    char ubuf[UUID_STR_LEN];
 
     std::string tname;
 
@@ -92,58 +307,65 @@ void JsonAdapter::Pack(GlobalRegistry *globalreg, std::ostream &stream,
     size_t sz;
     std::ios::fmtflags fflags;
 
+    // The switch establishes the concrete type, so the per-case reads use
+    // the unchecked raw accessors instead of re-verifying it on every field
     switch (e->get_type()) {
         case TrackerString:
-            stream << "\"" << SanitizeString(GetTrackerValue<std::string>(e)) << "\"";
+            stream << "\"";
+            SanitizeStringTo(stream, e->get_string_raw());
+            stream << "\"";
             break;
         case TrackerInt8:
-            stream << (int) GetTrackerValue<int8_t>(e);
+            json_write_int(stream, e->get_int8_raw());
             break;
         case TrackerUInt8:
-            stream << (unsigned int) GetTrackerValue<uint8_t>(e);
+            json_write_uint(stream, e->get_uint8_raw());
             break;
         case TrackerInt16:
-            stream << (int) GetTrackerValue<int16_t>(e);
+            json_write_int(stream, e->get_int16_raw());
             break;
         case TrackerUInt16:
-            stream << (unsigned int) GetTrackerValue<uint16_t>(e);
+            json_write_uint(stream, e->get_uint16_raw());
             break;
         case TrackerInt32:
-            stream << GetTrackerValue<int32_t>(e);
+            json_write_int(stream, e->get_int32_raw());
             break;
         case TrackerUInt32:
-            stream << GetTrackerValue<uint32_t>(e);
+            json_write_uint(stream, e->get_uint32_raw());
             break;
         case TrackerInt64:
-            stream << GetTrackerValue<int64_t>(e);
+            json_write_int(stream, e->get_int64_raw());
             break;
         case TrackerUInt64:
-            stream << GetTrackerValue<uint64_t>(e);
+            json_write_uint(stream, e->get_uint64_raw());
             break;
         case TrackerFloat:
-            if (std::isnan(GetTrackerValue<float>(e)) || std::isinf(GetTrackerValue<float>(e)))
+            if (std::isnan(e->get_float_raw()) || std::isinf(e->get_float_raw()))
                 stream << 0;
             else
-                stream << std::fixed << GetTrackerValue<float>(e);
+                json_write_double(stream, e->get_float_raw());
             break;
         case TrackerDouble:
-            if (std::isnan(GetTrackerValue<double>(e)) || std::isinf(GetTrackerValue<double>(e)))
+            if (std::isnan(e->get_double_raw()) || std::isinf(e->get_double_raw()))
                 stream << 0;
             else
-                stream << std::fixed << GetTrackerValue<double>(e);
+                json_write_double(stream, e->get_double_raw());
             break;
         case TrackerMac:
-            mac = GetTrackerValue<mac_addr>(e);
+            mac = e->get_mac_raw();
             // Mac is quoted as a string value, mac only
             stream << "\"" << mac.Mac2String() << "\"";
             break;
         case TrackerUuid:
-            euuid = GetTrackerValue<uuid>(e);
-            // UUID is quoted as a string value
-            stream << "\"" << euuid.UUID2String() << "\"";
+            euuid = e->get_uuid_raw();
+            // UUID is quoted as a string value; formatted into a stack
+            // buffer to keep the per-record allocation off the source
+            // polling path
+            euuid.UUID2StringBuf(ubuf);
+            stream << "\"" << ubuf << "\"";
             break;
         case TrackerKey:
-            stream << "\"" << GetTrackerValue<TrackedDeviceKey>(e).as_string() << "\"";
+            stream << "\"" << e->get_key_raw().as_string() << "\"";
             break;
         case TrackerVector:
             tvec = e->get_vector();
@@ -278,7 +500,9 @@ void JsonAdapter::Pack(GlobalRegistry *globalreg, std::ostream &stream,
             for (double_map_iter = tdoublemap->begin();
                     double_map_iter != tdoublemap->end(); /* */) {
                 // Double keys are handled as strings in json
-                stream << indent << "\"" << std::fixed << double_map_iter->first << "\": ";
+                stream << indent << "\"";
+                json_write_double(stream, double_map_iter->first);
+                stream << "\": ";
                 JsonAdapter::Pack(globalreg, stream, double_map_iter->second, name_map,
                         prettyprint, depth + 1);
                 if (++double_map_iter != tdoublemap->end())
@@ -360,6 +584,7 @@ void StorageJsonAdapter::Pack(GlobalRegistry *globalreg, std::ostream &stream,
 
     mac_addr mac;
     uuid euuid;
+    char ubuf[UUID_STR_LEN];
     TrackedDeviceKey key;
 
     std::string tname;
@@ -387,43 +612,45 @@ void StorageJsonAdapter::Pack(GlobalRegistry *globalreg, std::ostream &stream,
 
     switch (e->get_type()) {
         case TrackerString:
-            stream << "\"" << JsonAdapter::SanitizeString(GetTrackerValue<std::string>(e)) << "\"";
+            stream << "\"";
+            JsonAdapter::SanitizeStringTo(stream, GetTrackerValue<std::string>(e));
+            stream << "\"";
             break;
         case TrackerInt8:
-            stream << (int) GetTrackerValue<int8_t>(e);
+            json_write_int(stream, GetTrackerValue<int8_t>(e));
             break;
         case TrackerUInt8:
-            stream << (unsigned int) GetTrackerValue<uint8_t>(e);
+            json_write_uint(stream, GetTrackerValue<uint8_t>(e));
             break;
         case TrackerInt16:
-            stream << (int) GetTrackerValue<int16_t>(e);
+            json_write_int(stream, GetTrackerValue<int16_t>(e));
             break;
         case TrackerUInt16:
-            stream << (unsigned int) GetTrackerValue<uint16_t>(e);
+            json_write_uint(stream, GetTrackerValue<uint16_t>(e));
             break;
         case TrackerInt32:
-            stream << GetTrackerValue<int32_t>(e);
+            json_write_int(stream, GetTrackerValue<int32_t>(e));
             break;
         case TrackerUInt32:
-            stream << GetTrackerValue<uint32_t>(e);
+            json_write_uint(stream, GetTrackerValue<uint32_t>(e));
             break;
         case TrackerInt64:
-            stream << GetTrackerValue<int64_t>(e);
+            json_write_int(stream, GetTrackerValue<int64_t>(e));
             break;
         case TrackerUInt64:
-            stream << GetTrackerValue<uint64_t>(e);
+            json_write_uint(stream, GetTrackerValue<uint64_t>(e));
             break;
         case TrackerFloat:
             if (std::isnan(GetTrackerValue<float>(e)) || std::isinf(GetTrackerValue<float>(e)))
                 stream << 0;
             else
-                stream << std::fixed << GetTrackerValue<float>(e);
+                json_write_double(stream, GetTrackerValue<float>(e));
             break;
         case TrackerDouble:
             if (std::isnan(GetTrackerValue<double>(e)) || std::isinf(GetTrackerValue<double>(e)))
                 stream << 0;
             else
-                stream << std::fixed << GetTrackerValue<double>(e);
+                json_write_double(stream, GetTrackerValue<double>(e));
             break;
         case TrackerMac:
             mac = GetTrackerValue<mac_addr>(e);
@@ -432,8 +659,10 @@ void StorageJsonAdapter::Pack(GlobalRegistry *globalreg, std::ostream &stream,
             break;
         case TrackerUuid:
             euuid = GetTrackerValue<uuid>(e);
-            // UUID is quoted as a string value
-            stream << "\"" << euuid.UUID2String() << "\"";
+            // UUID is quoted as a string value; formatted into a stack
+            // buffer to avoid the per-record allocation
+            euuid.UUID2StringBuf(ubuf);
+            stream << "\"" << ubuf << "\"";
             break;
         case TrackerKey:
             key = GetTrackerValue<TrackedDeviceKey>(e);
@@ -544,7 +773,9 @@ void StorageJsonAdapter::Pack(GlobalRegistry *globalreg, std::ostream &stream,
             for (double_map_iter = tdoublemap->begin();
                     double_map_iter != tdoublemap->end(); /* */) {
                 // Double keys are handled as strings in json
-                stream << "\"" << std::fixed << double_map_iter->first << "\": ";
+                stream << "\"";
+                json_write_double(stream, double_map_iter->first);
+                stream << "\": ";
                 StorageJsonAdapter::Pack(globalreg, stream, double_map_iter->second, name_map);
                 if (++double_map_iter != tdoublemap->end())
                     stream << ",";
@@ -38,6 +38,10 @@ void Pack(GlobalRegistry *globalreg, std::ostream &stream, SharedTrackerElement
 
 std::string SanitizeString(std::string in);
 
+// Escape directly into the output sink, writing clean runs in bulk; the
+// common case of a string with nothing to escape is a single write
+void SanitizeStringTo(std::ostream& stream, const std::string& in);
+
 class Serializer : public TrackerElementSerializer {
 public:
     Serializer(GlobalRegistry *in_globalreg) :
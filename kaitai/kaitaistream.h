@@ -12,6 +12,38 @@
 
 namespace kaitai {
 
+/**
+ * Minimal string_view-style borrowed byte range (kaitai::kbytes).
+ *
+ * Exposes a run of bytes inside a containing buffer without copying them;
+ * a view is only valid as long as the buffer it was taken from, so views
+ * handed out by parsers over a packet buffer must not outlive the packet.
+ */
+class kbytes {
+public:
+    kbytes() : m_data(NULL), m_length(0) { }
+    kbytes(const char *data, size_t length) : m_data(data), m_length(length) { }
+
+    const char *data() const { return m_data; }
+    size_t length() const { return m_length; }
+    bool empty() const { return m_length == 0; }
+
+    char operator[](size_t pos) const { return m_data[pos]; }
+
+    const char *begin() const { return m_data; }
+    const char *end() const { return m_data + m_length; }
+
+    /**
+     * Materialize the view as an owned string, for callers which need the
+     * data past the lifetime of the underlying buffer.
+     */
+    std::string to_string() const { return std::string(m_data, m_length); }
+
+private:
+    const char *m_data;
+    size_t m_length;
+};
+
 /**
  * Kaitai Stream class (kaitai::kstream) is an implementation of
  * <a href="https://github.com/kaitai-io/kaitai_struct/wiki/Kaitai-Struct-stream-API">Kaitai Struct stream API</a>
@@ -44,6 +76,16 @@ public:
      */
     kstream(std::string& data);
 
+    /**
+     * Constructs new Kaitai Stream object over a borrowed in-memory data
+     * buffer, without copying it or taking ownership; the buffer must
+     * outlive the stream and anything parsed from it.  Reads operate
+     * directly on the buffer instead of going through an STL stream.
+     * \param data borrowed data buffer to use for this Kaitai Stream
+     * \param len length of the borrowed buffer in bytes
+     */
+    kstream(const char *data, size_t len);
+
     void close();
 
     /** @name Stream positioning */
@@ -75,6 +117,17 @@ public:
      * \return size of the stream in bytes
      */
     uint64_t size();
+
+    /**
+     * Get the number of unread bytes left in the stream.  Parsers which
+     * signal malformed input with result codes instead of exceptions
+     * check this before a group of fixed-size reads; a read that fits in
+     * the remaining length cannot throw.
+     * \return bytes between the stream pointer and the end of the stream
+     */
+    uint64_t remaining() {
+        return size() - pos();
+    }
     //@}
 
     /** @name Integer numbers */
@@ -157,6 +210,16 @@ public:
     //@{
 
     std::string read_bytes(ssize_t len);
+
+    /**
+     * Reads len bytes as a borrowed pointer into the underlying buffer,
+     * advancing the stream without copying the data.  Only available when
+     * the stream was constructed over a borrowed buffer; returns NULL when
+     * the stream is istream-backed and the caller must fall back to
+     * read_bytes().
+     */
+    const char *read_bytes_ptr(ssize_t len);
+
     std::string read_bytes_full();
     std::string read_bytes_term(char term, bool include, bool consume, bool eos_error);
     std::string ensure_fixed_contents(std::string expected);
@@ -233,11 +296,19 @@ public:
 private:
     std::istream* m_io;
     std::istringstream m_io_str;
+
+    // Borrowed-buffer mode; when m_mem is set, reads bypass the istream
+    // and operate directly on the borrowed memory
+    const char *m_mem;
+    size_t m_mem_sz;
+    size_t m_mem_pos;
+
     int m_bits_left;
     uint64_t m_bits;
 
     void init();
     void exceptions_enable() const;
+    void read_raw(char *dst, size_t len);
 
     static uint64_t get_mask_ones(int n);
 
@@ -6,14 +6,29 @@
 #include <iostream>
 #include <vector>
 #include <stdexcept>
+#include <cstring>
 
 kaitai::kstream::kstream(std::istream* io) {
     m_io = io;
+    m_mem = NULL;
+    m_mem_sz = 0;
+    m_mem_pos = 0;
     init();
 }
 
 kaitai::kstream::kstream(std::string& data): m_io_str(data) {
     m_io = &m_io_str;
+    m_mem = NULL;
+    m_mem_sz = 0;
+    m_mem_pos = 0;
+    init();
+}
+
+kaitai::kstream::kstream(const char *data, size_t len) {
+    m_io = NULL;
+    m_mem = data;
+    m_mem_sz = len;
+    m_mem_pos = 0;
     init();
 }
 
@@ -27,6 +42,9 @@ void kaitai::kstream::close() {
 }
 
 void kaitai::kstream::exceptions_enable() const {
+    if (m_io == NULL)
+        return;
+
     m_io->exceptions(
         std::istream::eofbit |
         std::istream::failbit |
@@ -38,7 +56,26 @@ void kaitai::kstream::exceptions_enable() const {
 // Stream positioning
 // ========================================================================
 
+// Raw read off the underlying storage; borrowed-memory streams are
+// bounds-checked directly, istream-backed streams signal errors through the
+// stream exception flags
+void kaitai::kstream::read_raw(char *dst, size_t len) {
+    if (m_mem != NULL) {
+        if (m_mem_pos + len > m_mem_sz)
+            throw std::runtime_error("read past end of borrowed stream");
+
+        memcpy(dst, m_mem + m_mem_pos, len);
+        m_mem_pos += len;
+        return;
+    }
+
+    m_io->read(dst, len);
+}
+
 bool kaitai::kstream::is_eof() const {
+    if (m_mem != NULL)
+        return m_mem_pos >= m_mem_sz;
+
     char t;
     m_io->exceptions(
         std::istream::badbit
@@ -56,14 +93,28 @@ bool kaitai::kstream::is_eof() const {
 }
 
 void kaitai::kstream::seek(uint64_t pos) {
+    if (m_mem != NULL) {
+        if (pos > m_mem_sz)
+            throw std::runtime_error("seek past end of borrowed stream");
+
+        m_mem_pos = pos;
+        return;
+    }
+
     m_io->seekg(pos);
 }
 
 uint64_t kaitai::kstream::pos() {
+    if (m_mem != NULL)
+        return m_mem_pos;
+
     return m_io->tellg();
 }
 
 uint64_t kaitai::kstream::size() {
+    if (m_mem != NULL)
+        return m_mem_sz;
+
     std::ifstream::pos_type cur_pos = m_io->tellg();
     m_io->seekg(0, std::ios::end);
     std::ifstream::pos_type len = m_io->tellg();
@@ -81,7 +132,7 @@ uint64_t kaitai::kstream::size() {
 
 int8_t kaitai::kstream::read_s1() {
     char t;
-    m_io->get(t);
+    read_raw(&t, 1);
     return t;
 }
 
@@ -91,7 +142,7 @@ int8_t kaitai::kstream::read_s1() {
 
 int16_t kaitai::kstream::read_s2be() {
     int16_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 2);
+    read_raw(reinterpret_cast<char *>(&t), 2);
 #if __BYTE_ORDER == __LITTLE_ENDIAN
     t = bswap_16(t);
 #endif
@@ -100,7 +151,7 @@ int16_t kaitai::kstream::read_s2be() {
 
 int32_t kaitai::kstream::read_s4be() {
     int32_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 4);
+    read_raw(reinterpret_cast<char *>(&t), 4);
 #if __BYTE_ORDER == __LITTLE_ENDIAN
     t = bswap_32(t);
 #endif
@@ -109,7 +160,7 @@ int32_t kaitai::kstream::read_s4be() {
 
 int64_t kaitai::kstream::read_s8be() {
     int64_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 8);
+    read_raw(reinterpret_cast<char *>(&t), 8);
 #if __BYTE_ORDER == __LITTLE_ENDIAN
     t = bswap_64(t);
 #endif
@@ -122,7 +173,7 @@ int64_t kaitai::kstream::read_s8be() {
 
 int16_t kaitai::kstream::read_s2le() {
     int16_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 2);
+    read_raw(reinterpret_cast<char *>(&t), 2);
 #if __BYTE_ORDER == __BIG_ENDIAN
     t = bswap_16(t);
 #endif
@@ -131,7 +182,7 @@ int16_t kaitai::kstream::read_s2le() {
 
 int32_t kaitai::kstream::read_s4le() {
     int32_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 4);
+    read_raw(reinterpret_cast<char *>(&t), 4);
 #if __BYTE_ORDER == __BIG_ENDIAN
     t = bswap_32(t);
 #endif
@@ -140,7 +191,7 @@ int32_t kaitai::kstream::read_s4le() {
 
 int64_t kaitai::kstream::read_s8le() {
     int64_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 8);
+    read_raw(reinterpret_cast<char *>(&t), 8);
 #if __BYTE_ORDER == __BIG_ENDIAN
     t = bswap_64(t);
 #endif
@@ -153,7 +204,7 @@ int64_t kaitai::kstream::read_s8le() {
 
 uint8_t kaitai::kstream::read_u1() {
     char t;
-    m_io->get(t);
+    read_raw(&t, 1);
     return t;
 }
 
@@ -163,7 +214,7 @@ uint8_t kaitai::kstream::read_u1() {
 
 uint16_t kaitai::kstream::read_u2be() {
     uint16_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 2);
+    read_raw(reinterpret_cast<char *>(&t), 2);
 #if __BYTE_ORDER == __LITTLE_ENDIAN
     t = bswap_16(t);
 #endif
@@ -172,7 +223,7 @@ uint16_t kaitai::kstream::read_u2be() {
 
 uint32_t kaitai::kstream::read_u4be() {
     uint32_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 4);
+    read_raw(reinterpret_cast<char *>(&t), 4);
 #if __BYTE_ORDER == __LITTLE_ENDIAN
     t = bswap_32(t);
 #endif
@@ -181,7 +232,7 @@ uint32_t kaitai::kstream::read_u4be() {
 
 uint64_t kaitai::kstream::read_u8be() {
     uint64_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 8);
+    read_raw(reinterpret_cast<char *>(&t), 8);
 #if __BYTE_ORDER == __LITTLE_ENDIAN
     t = bswap_64(t);
 #endif
@@ -194,7 +245,7 @@ uint64_t kaitai::kstream::read_u8be() {
 
 uint16_t kaitai::kstream::read_u2le() {
     uint16_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 2);
+    read_raw(reinterpret_cast<char *>(&t), 2);
 #if __BYTE_ORDER == __BIG_ENDIAN
     t = bswap_16(t);
 #endif
@@ -203,7 +254,7 @@ uint16_t kaitai::kstream::read_u2le() {
 
 uint32_t kaitai::kstream::read_u4le() {
     uint32_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 4);
+    read_raw(reinterpret_cast<char *>(&t), 4);
 #if __BYTE_ORDER == __BIG_ENDIAN
     t = bswap_32(t);
 #endif
@@ -212,7 +263,7 @@ uint32_t kaitai::kstream::read_u4le() {
 
 uint64_t kaitai::kstream::read_u8le() {
     uint64_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 8);
+    read_raw(reinterpret_cast<char *>(&t), 8);
 #if __BYTE_ORDER == __BIG_ENDIAN
     t = bswap_64(t);
 #endif
@@ -229,7 +280,7 @@ uint64_t kaitai::kstream::read_u8le() {
 
 float kaitai::kstream::read_f4be() {
     uint32_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 4);
+    read_raw(reinterpret_cast<char *>(&t), 4);
 #if __BYTE_ORDER == __LITTLE_ENDIAN
     t = bswap_32(t);
 #endif
@@ -238,7 +289,7 @@ float kaitai::kstream::read_f4be() {
 
 double kaitai::kstream::read_f8be() {
     uint64_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 8);
+    read_raw(reinterpret_cast<char *>(&t), 8);
 #if __BYTE_ORDER == __LITTLE_ENDIAN
     t = bswap_64(t);
 #endif
@@ -251,7 +302,7 @@ double kaitai::kstream::read_f8be() {
 
 float kaitai::kstream::read_f4le() {
     uint32_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 4);
+    read_raw(reinterpret_cast<char *>(&t), 4);
 #if __BYTE_ORDER == __BIG_ENDIAN
     t = bswap_32(t);
 #endif
@@ -260,7 +311,7 @@ float kaitai::kstream::read_f4le() {
 
 double kaitai::kstream::read_f8le() {
     uint64_t t;
-    m_io->read(reinterpret_cast<char *>(&t), 8);
+    read_raw(reinterpret_cast<char *>(&t), 8);
 #if __BYTE_ORDER == __BIG_ENDIAN
     t = bswap_64(t);
 #endif
@@ -286,7 +337,7 @@ uint64_t kaitai::kstream::read_bits_int(int n) {
         if (bytes_needed > 8)
             throw std::runtime_error("read_bits_int: more than 8 bytes requested");
         char buf[8];
-        m_io->read(buf, bytes_needed);
+        read_raw(buf, bytes_needed);
         for (int i = 0; i < bytes_needed; i++) {
             uint8_t b = buf[i];
             m_bits <<= 8;
@@ -323,12 +374,39 @@ uint64_t kaitai::kstream::get_mask_ones(int n) {
 // ========================================================================
 
 std::string kaitai::kstream::read_bytes(ssize_t len) {
+    if (m_mem != NULL) {
+        if (m_mem_pos + len > m_mem_sz)
+            throw std::runtime_error("read past end of borrowed stream");
+
+        std::string result(m_mem + m_mem_pos, len);
+        m_mem_pos += len;
+        return result;
+    }
+
     std::vector<char> result(len);
     m_io->read(&result[0], len);
     return std::string(result.begin(), result.end());
 }
 
+const char *kaitai::kstream::read_bytes_ptr(ssize_t len) {
+    if (m_mem == NULL)
+        return NULL;
+
+    if (m_mem_pos + len > m_mem_sz)
+        throw std::runtime_error("read past end of borrowed stream");
+
+    const char *r = m_mem + m_mem_pos;
+    m_mem_pos += len;
+    return r;
+}
+
 std::string kaitai::kstream::read_bytes_full() {
+    if (m_mem != NULL) {
+        std::string result(m_mem + m_mem_pos, m_mem_sz - m_mem_pos);
+        m_mem_pos = m_mem_sz;
+        return result;
+    }
+
     std::ifstream::pos_type p1 = m_io->tellg();
     m_io->seekg(0, std::ios::end);
     std::ifstream::pos_type p2 = m_io->tellg();
@@ -346,6 +424,30 @@ std::string kaitai::kstream::read_bytes_full() {
 }
 
 std::string kaitai::kstream::read_bytes_term(char term, bool include, bool consume, bool eos_error) {
+    if (m_mem != NULL) {
+        const char *t = (const char *) memchr(m_mem + m_mem_pos, term, m_mem_sz - m_mem_pos);
+
+        if (t == NULL) {
+            // encountered EOF
+            if (eos_error) {
+                // throw exception here
+            }
+
+            std::string result(m_mem + m_mem_pos, m_mem_sz - m_mem_pos);
+            m_mem_pos = m_mem_sz;
+            return result;
+        }
+
+        // encountered terminator
+        std::string result(m_mem + m_mem_pos, t - (m_mem + m_mem_pos));
+        m_mem_pos = t - m_mem;
+        if (include)
+            result.push_back(term);
+        if (consume)
+            m_mem_pos++;
+        return result;
+    }
+
     std::string result;
     std::getline(*m_io, result, term);
     if (m_io->eof()) {
@@ -24,9 +24,42 @@
 #include "json_adapter.h"
 #include "packetchain.h"
 #include "kis_datasource.h"
+#include "zstr.hpp"
+#include "kis_perfcounter.h"
 
 #include "kis_databaselogfile.h"
 
+// Compress a serialized record with the same zlib stream wrapper the device
+// state store uses; compressed rows carry the standard zlib header so readers
+// can detect them per-row and older uncompressed rows coexist in the same log
+static std::string compress_log_blob(const std::string& in_blob) {
+    std::stringbuf sbuf;
+    zstr::ostreambuf zobuf(&sbuf, 1 << 16, Z_DEFAULT_COMPRESSION);
+    std::ostream zstream(&zobuf);
+
+    zstream << in_blob;
+
+    zobuf.pubsync();
+    sbuf.pubsync();
+
+    return sbuf.str();
+}
+
+// 64-bit FNV-1a over a packet payload, used to content-address capture
+// blobs.  Not cryptographic, but collision odds within a single log are
+// negligible and a collision would only substitute one frame body for
+// another in the log, not in live processing
+static uint64_t hash_log_blob(const std::string& in_blob) {
+    uint64_t h = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < in_blob.length(); i++) {
+        h ^= (uint64_t) (uint8_t) in_blob[i];
+        h *= 1099511628211ULL;
+    }
+
+    return h;
+}
+
 KisDatabaseLogfile::KisDatabaseLogfile(GlobalRegistry *in_globalreg):
     KisLogfile(in_globalreg, SharedLogBuilder(NULL)), 
     KisDatabase(in_globalreg, "kismetlog") {
@@ -52,6 +85,15 @@ KisDatabaseLogfile::KisDatabaseLogfile(GlobalRegistry *in_globalreg):
     packet_stmt = NULL;
     packet_pz = NULL;
 
+    packet_batch_stmt = NULL;
+    packet_batch_pz = NULL;
+
+    blob_stmt = NULL;
+    blob_pz = NULL;
+
+    blob_ref_stmt = NULL;
+    blob_ref_pz = NULL;
+
     datasource_stmt = NULL;
     datasource_pz = NULL;
 
@@ -72,11 +114,115 @@ KisDatabaseLogfile::KisDatabaseLogfile(GlobalRegistry *in_globalreg):
 
     db_enabled = false;
 
+    log_duplicate_packets = true;
+    log_compression = false;
+    log_dedup = true;
+
+    transaction_rows = 0;
+    transaction_row_limit = 0;
+
+    writer_queue = NULL;
+    writer_sleeping = false;
+    writer_shutdown = false;
+    writer_failed = false;
+    dropped_log_rows = 0;
+    last_drop_warning = 0;
+
+    stmt_count = 0;
+    stmt_total_usec = 0;
+    stmt_max_usec = 0;
+
+    for (unsigned int b = 0; b < PACKETCHAIN_LAT_BUCKETS; b++)
+        stmt_latency_buckets[b] = 0;
+
+    // Anything slower than this lands in the slow-op ring; sqlite inserts
+    // should be well under a millisecond when storage is healthy
+    slow_op_threshold_usec =
+        globalreg->kismet_config->FetchOptUInt("kis_log_slow_op_ms", 100) * 1000;
+
+    slow_ops.resize(32);
+    slow_op_pos = 0;
+
+    stats_count_id =
+        globalreg->entrytracker->RegisterField("kismet.kismetdb.stat_count",
+                TrackerUInt64, "total timed statement executions");
+    stats_total_usec_id =
+        globalreg->entrytracker->RegisterField("kismet.kismetdb.stat_total_usec",
+                TrackerUInt64, "total time in statement executions (usec)");
+    stats_max_usec_id =
+        globalreg->entrytracker->RegisterField("kismet.kismetdb.stat_max_usec",
+                TrackerUInt64, "slowest single statement execution (usec)");
+    stats_queue_id =
+        globalreg->entrytracker->RegisterField("kismet.kismetdb.queue_depth",
+                TrackerUInt64, "log rows waiting on the writer thread");
+    stats_dropped_id =
+        globalreg->entrytracker->RegisterField("kismet.kismetdb.dropped_rows",
+                TrackerUInt64, "log rows dropped due to writer backlog");
+    stats_histo_id =
+        globalreg->entrytracker->RegisterField("kismet.kismetdb.latency_histogram",
+                TrackerIntMap, "statement counts keyed by latency bucket floor (usec)");
+    stats_histo_count_id =
+        globalreg->entrytracker->RegisterField("kismet.kismetdb.latency_histogram.count",
+                TrackerUInt64, "statements in latency bucket");
+    stats_slow_vec_id =
+        globalreg->entrytracker->RegisterField("kismet.kismetdb.slow_ops",
+                TrackerVector, "recent operations over the slow-op threshold");
+    stats_slow_op_id =
+        globalreg->entrytracker->RegisterField("kismet.kismetdb.slow_op.op",
+                TrackerString, "statement type");
+    stats_slow_usec_id =
+        globalreg->entrytracker->RegisterField("kismet.kismetdb.slow_op.usec",
+                TrackerUInt64, "statement duration (usec)");
+    stats_slow_rows_id =
+        globalreg->entrytracker->RegisterField("kismet.kismetdb.slow_op.rows",
+                TrackerUInt64, "rows changed by statement");
+    stats_slow_ts_id =
+        globalreg->entrytracker->RegisterField("kismet.kismetdb.slow_op.timestamp",
+                TrackerUInt64, "wall-clock time of statement");
+
+    std::shared_ptr<PerfCounterRegistry> perfcounters =
+        Globalreg::FetchGlobalAs<PerfCounterRegistry>(globalreg, "PERFCOUNTERS");
+
+    if (perfcounters != NULL) {
+        KisDatabaseLogfile *log = this;
+
+        perfcounters->RegisterCounter("kismet.databaselog.queue_depth",
+                "log rows waiting on the sqlite writer thread",
+                PerfCounterRegistry::PERF_GAUGE,
+                [log]() -> uint64_t {
+                    if (log->writer_queue == NULL)
+                        return 0;
+                    return log->writer_queue->approx_size();
+                });
+
+        perfcounters->RegisterCounter("kismet.databaselog.dropped_rows",
+                "log rows dropped due to writer backlog",
+                PerfCounterRegistry::PERF_COUNTER,
+                [log]() -> uint64_t {
+                    return log->dropped_log_rows;
+                });
+
+        perfcounters->RegisterCounter("kismet.memory.sqlite_bytes",
+                "memory currently held by sqlite (all databases)",
+                PerfCounterRegistry::PERF_GAUGE,
+                []() -> uint64_t {
+                    return (uint64_t) sqlite3_memory_used();
+                });
+    }
 }
 
 KisDatabaseLogfile::~KisDatabaseLogfile() {
     local_eol_locker dblock(&ds_mutex);
 
+    std::shared_ptr<PerfCounterRegistry> perfcounters =
+        Globalreg::FetchGlobalAs<PerfCounterRegistry>(globalreg, "PERFCOUNTERS");
+
+    if (perfcounters != NULL) {
+        perfcounters->RemoveCounter("kismet.databaselog.queue_depth");
+        perfcounters->RemoveCounter("kismet.databaselog.dropped_rows");
+        perfcounters->RemoveCounter("kismet.memory.sqlite_bytes");
+    }
+
     Log_Close();
 }
 
@@ -96,6 +242,15 @@ bool KisDatabaseLogfile::Log_Open(std::string in_path) {
 
 	_MSG("Opened kismetdb log file '" + in_path + "'", MSGFLAG_INFO);
 
+    log_duplicate_packets =
+        globalreg->kismet_config->FetchOptBoolean("kis_log_duplicate_packets", true);
+
+    log_compression =
+        globalreg->kismet_config->FetchOptBoolean("kis_log_compression", true);
+
+    log_dedup =
+        globalreg->kismet_config->FetchOptBoolean("kis_log_packet_dedup", true);
+
     if (globalreg->kismet_config->FetchOptBoolean("kis_log_packets", true)) {
         _MSG("Saving packets to the Kismet database log.", MSGFLAG_INFO);
         std::shared_ptr<Packetchain> packetchain =
@@ -105,30 +260,214 @@ bool KisDatabaseLogfile::Log_Open(std::string in_path) {
                 CHAINPOS_LOGGING, -100);
     }
 
+    // Spin up the dedicated writer thread; all inserts are handed to it
+    // as bound closures so sqlite never runs on the packet chain or the
+    // timetracker
+    writer_shutdown = false;
+    writer_failed = false;
+    writer_sleeping = false;
+    writer_queue =
+        new mpsc_bounded_queue<std::function<void ()> *>(
+                globalreg->kismet_config->FetchOptUInt("kis_log_queue_size", 8192));
+
+    pthread_create(&writer_thread, NULL,
+            &KisDatabaseLogfile::database_writer_processor, this);
+
     db_enabled = true;
 
-    sqlite3_exec(db, "PRAGMA journal_mode=PERSIST", NULL, NULL, NULL);
-    
-    // Go into transactional mode where we only commit every 10 seconds
+    // WAL journaling keeps writers from stalling on the storage device;
+    // committing a batch appends to the write-ahead log instead of
+    // rewriting pages in place, and with synchronous=NORMAL the commit
+    // doesn't wait on an fsync at all
+    sqlite3_exec(db, "PRAGMA journal_mode=WAL", NULL, NULL, NULL);
+    sqlite3_exec(db, "PRAGMA synchronous=NORMAL", NULL, NULL, NULL);
+
+    // Go into transactional mode where we batch commits by time and
+    // row count
     sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, NULL);
 
-    std::shared_ptr<Timetracker> timetracker = 
+    transaction_rows = 0;
+    transaction_row_limit =
+        globalreg->kismet_config->FetchOptUInt("kis_log_transaction_rows", 100000);
+
+    unsigned int transaction_time =
+        globalreg->kismet_config->FetchOptUInt("kis_log_transaction_time", 10000);
+
+    // The timetracker resolves no finer than a timeslice
+    unsigned int transaction_slices =
+        (transaction_time * SERVER_TIMESLICES_SEC) / 1000;
+    if (transaction_slices < 1)
+        transaction_slices = 1;
+
+    std::shared_ptr<Timetracker> timetracker =
         Globalreg::FetchMandatoryGlobalAs<Timetracker>(globalreg, "TIMETRACKER");
-    transaction_timer = 
-        timetracker->RegisterTimer(SERVER_TIMESLICES_SEC * 10, NULL, 1,
+    transaction_timer =
+        timetracker->RegisterTimer(transaction_slices, NULL, 1,
             [this](int) -> int {
 
-            local_locker lock(&transaction_mutex);
+            // A fatal write error in the writer thread closes the log
+            // from here, outside the writer's own context
+            if (writer_failed) {
+                Log_Close();
+                return 0;
+            }
 
-            sqlite3_exec(db, "END TRANSACTION", NULL, NULL, NULL);
-            sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, NULL);
+            CommitTransaction();
 
             return 1;
         });
 
+    // Seed the file with the complete current device list; with dirty-only
+    // snapshotting, devices which never change again would otherwise only
+    // exist in a rotated-out log
+    if (devicetracker == NULL)
+        devicetracker =
+            Globalreg::FetchGlobalAs<Devicetracker>(globalreg, "DEVICE_TRACKER");
+
+    if (devicetracker != NULL)
+        devicetracker->databaselog_write_all_devices();
+
     return true;
 }
 
+void *KisDatabaseLogfile::database_writer_processor(void *in_arg) {
+    KisDatabaseLogfile *logfile = (KisDatabaseLogfile *) in_arg;
+    std::function<void ()> *work = NULL;
+
+    while (1) {
+        // Drain everything queued before honoring a shutdown so no
+        // accepted row goes unlogged
+        if (logfile->writer_queue->dequeue(work)) {
+            (*work)();
+            delete work;
+            continue;
+        }
+
+        if (logfile->writer_shutdown)
+            return NULL;
+
+        logfile->writer_condition.lock();
+        logfile->writer_sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (logfile->writer_queue->approx_size() != 0 ||
+                logfile->writer_shutdown) {
+            logfile->writer_sleeping.store(false);
+            logfile->writer_condition.unlock();
+            continue;
+        }
+
+        logfile->writer_condition.block_until();
+        logfile->writer_sleeping.store(false);
+    }
+}
+
+void KisDatabaseLogfile::EnqueueWrite(std::function<void ()> *in_work) {
+    if (writer_failed) {
+        delete in_work;
+        return;
+    }
+
+    // With no writer thread running (log still opening) execute inline
+    if (writer_queue == NULL) {
+        (*in_work)();
+        delete in_work;
+        return;
+    }
+
+    if (!writer_queue->enqueue(in_work)) {
+        // The ring is single-consumer so the producer side can't safely
+        // evict the oldest entry; shed the incoming row and count it
+        delete in_work;
+
+        uint64_t total = ++dropped_log_rows;
+
+        time_t offt = time(0) - last_drop_warning;
+        if (offt > 30) {
+            last_drop_warning = time(0);
+
+            _MSG("The Kismet database log is dropping records; the writer "
+                    "queue is full and " + ULongToString(total) + " records "
+                    "have been dropped so far.  Your storage device may not "
+                    "be fast enough to sustain the current log rate.",
+                    MSGFLAG_ERROR);
+        }
+
+        return;
+    }
+
+    // Wake the writer only if it's advertised that it's asleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writer_sleeping.load())
+        writer_condition.unlock();
+}
+
+void KisDatabaseLogfile::CommitTransaction() {
+    // Fold any partially staged packet batch into the transaction before
+    // committing, so low-rate captures don't hold rows in memory across
+    // commit windows
+    {
+        local_locker plock(&packet_mutex);
+        FlushPacketBatch();
+    }
+
+    local_locker lock(&transaction_mutex);
+
+    sqlite3_exec(db, "END TRANSACTION", NULL, NULL, NULL);
+    sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, NULL);
+
+    transaction_rows = 0;
+}
+
+void KisDatabaseLogfile::CountTransactionRow() {
+    local_locker lock(&transaction_mutex);
+
+    if (transaction_row_limit > 0 && ++transaction_rows >= transaction_row_limit)
+        CommitTransaction();
+}
+
+int KisDatabaseLogfile::timed_step(sqlite3_stmt *stmt, const char *in_op) {
+    struct timespec start_t, end_t;
+
+    clock_gettime(CLOCK_MONOTONIC, &start_t);
+
+    int r = sqlite3_step(stmt);
+
+    clock_gettime(CLOCK_MONOTONIC, &end_t);
+
+    int64_t usec =
+        (int64_t) (end_t.tv_sec - start_t.tv_sec) * 1000000LL +
+        (end_t.tv_nsec - start_t.tv_nsec) / 1000LL;
+
+    if (usec < 0)
+        usec = 0;
+
+    uint64_t rows = sqlite3_changes(db);
+
+    local_locker lock(&stats_mutex);
+
+    stmt_count++;
+    stmt_total_usec += usec;
+
+    if ((uint64_t) usec > stmt_max_usec)
+        stmt_max_usec = usec;
+
+    stmt_latency_buckets[Packetchain::LatencyBucket(usec)]++;
+
+    if ((uint64_t) usec >= slow_op_threshold_usec) {
+        slow_op_rec& rec = slow_ops[slow_op_pos % slow_ops.size()];
+
+        rec.op = in_op;
+        rec.usec = usec;
+        rec.rows = rows;
+        rec.ts = time(0);
+
+        slow_op_pos++;
+    }
+
+    return r;
+}
+
 void KisDatabaseLogfile::Log_Close() {
     local_locker dblock(&ds_mutex);
 
@@ -140,19 +479,27 @@ void KisDatabaseLogfile::Log_Close() {
     if (timetracker != NULL)
         timetracker->RemoveTimer(transaction_timer);
 
-    // End the transaction
-    {
-        local_eol_locker translock(&transaction_mutex);
-        sqlite3_exec(db, "END TRANSACTION", NULL, NULL, NULL);
-    }
-
     db_enabled = false;
 
     std::shared_ptr<Packetchain> packetchain =
         Globalreg::FetchGlobalAs<Packetchain>(globalreg, "PACKETCHAIN");
-    if (packetchain != NULL) 
+    if (packetchain != NULL)
         packetchain->RemoveHandler(&KisDatabaseLogfile::packet_handler, CHAINPOS_LOGGING);
 
+    // Shut down the writer thread, which drains everything already queued
+    // before exiting; must happen before the statements are finalized
+    if (writer_queue != NULL) {
+        writer_shutdown = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (writer_sleeping.load())
+            writer_condition.unlock();
+
+        pthread_join(writer_thread, NULL);
+
+        delete writer_queue;
+        writer_queue = NULL;
+    }
+
     {
         local_eol_locker lock(&device_mutex);
         if (device_stmt != NULL)
@@ -162,9 +509,27 @@ void KisDatabaseLogfile::Log_Close() {
 
     {
         local_eol_locker lock(&packet_mutex);
+
+        // Push any remaining staged packet rows before tearing down
+        FlushPacketBatch();
+
         if (packet_stmt != NULL)
             sqlite3_finalize(packet_stmt);
         packet_stmt = NULL;
+
+        if (packet_batch_stmt != NULL)
+            sqlite3_finalize(packet_batch_stmt);
+        packet_batch_stmt = NULL;
+
+        if (blob_stmt != NULL)
+            sqlite3_finalize(blob_stmt);
+        blob_stmt = NULL;
+
+        if (blob_ref_stmt != NULL)
+            sqlite3_finalize(blob_ref_stmt);
+        blob_ref_stmt = NULL;
+
+        known_blob_hashes.clear();
     }
 
     {
@@ -202,6 +567,16 @@ void KisDatabaseLogfile::Log_Close() {
         snapshot_stmt = NULL;
     }
 
+    // End the transaction; taken after the per-table locks to match the
+    // insert paths, which hold their table lock when they count a row
+    // against the batch limit
+    {
+        local_eol_locker translock(&transaction_mutex);
+        sqlite3_exec(db, "END TRANSACTION", NULL, NULL, NULL);
+    }
+
+    // Drop back to a rollback journal, which also checkpoints and removes
+    // the WAL sidecar file so the log is a single self-contained database
     sqlite3_exec(db, "PRAGMA journal_mode=DELETE", NULL, NULL, NULL);
     sqlite3_exec(db, "BEGIN_EXCLUSIVE", NULL, NULL, NULL);
     sqlite3_exec(db, "COMMIT", NULL, NULL, NULL);
@@ -288,6 +663,8 @@ int KisDatabaseLogfile::Database_UpgradeDB() {
             "dlt INT, " // pcap data - datalinktype and packet bin
             "packet BLOB, "
 
+            "packet_hash INT, " // Content hash into packet_blobs
+
             "error INT" // Packet was flagged as invalid
             ")";
 
@@ -433,7 +810,68 @@ int KisDatabaseLogfile::Database_UpgradeDB() {
 
     }
 
-    Database_SetDBVersion(4);
+    // Version 5 marks the potential presence of zlib-compressed JSON blobs
+    // in the devices, data, and snapshots tables; the table layouts are
+    // unchanged, and compressed rows are detectable per-row by the zlib
+    // header since raw JSON rows always begin with '{'
+
+    // Version 6 adds the content-addressed payload store; logs older than
+    // v6 carried payloads inline in the packets table only
+    if (dbv >= 1 && dbv < 6) {
+        sqlite3_exec(db, "ALTER TABLE packets ADD COLUMN packet_hash INT",
+                NULL, NULL, NULL);
+    }
+
+    if (dbv < 6) {
+        // Distinct payloads stored once, keyed by hash, with a reference
+        // count so pruning tools can tell which blobs are shared
+        sql =
+            "CREATE TABLE IF NOT EXISTS packet_blobs ("
+
+            "hash INT, " // Content hash of the payload
+
+            "refcount INT, " // Packet rows referencing this payload
+
+            "packet BLOB, " // Payload bytes
+
+            "UNIQUE(hash) ON CONFLICT IGNORE)";
+
+        r = sqlite3_exec(db, sql.c_str(),
+                [] (void *, int, char **, char **) -> int { return 0; }, NULL, &sErrMsg);
+
+        if (r != SQLITE_OK) {
+            _MSG("Kismet log was unable to create packet_blobs table in " + ds_dbfile + ": " +
+                    std::string(sErrMsg), MSGFLAG_ERROR);
+            Log_Close();
+            return -1;
+        }
+
+        // Transparent extraction view; resolves content-addressed payloads
+        // and falls back to the inline blob for rows logged before v6 or
+        // with deduplication disabled
+        sql =
+            "CREATE VIEW IF NOT EXISTS packet_data AS "
+            "SELECT p.ts_sec, p.ts_usec, p.phyname, "
+            "p.sourcemac, p.destmac, p.transmac, "
+            "p.frequency, p.devkey, p.lat, p.lon, "
+            "p.packet_len, p.signal, p.datasource, p.dlt, "
+            "COALESCE(b.packet, p.packet) AS packet, "
+            "p.error "
+            "FROM packets AS p LEFT JOIN packet_blobs AS b "
+            "ON p.packet_hash = b.hash";
+
+        r = sqlite3_exec(db, sql.c_str(),
+                [] (void *, int, char **, char **) -> int { return 0; }, NULL, &sErrMsg);
+
+        if (r != SQLITE_OK) {
+            _MSG("Kismet log was unable to create packet_data view in " + ds_dbfile + ": " +
+                    std::string(sErrMsg), MSGFLAG_ERROR);
+            Log_Close();
+            return -1;
+        }
+    }
+
+    Database_SetDBVersion(6);
 
     // Prepare the statements we'll need later
     //
@@ -461,9 +899,9 @@ int KisDatabaseLogfile::Database_UpgradeDB() {
         "lat, lon, "
         "packet_len, signal, "
         "datasource, "
-        "dlt, packet, "
+        "dlt, packet, packet_hash, "
         "error) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
 
     r = sqlite3_prepare(db, sql.c_str(), sql.length(), &packet_stmt, &packet_pz);
 
@@ -474,6 +912,64 @@ int KisDatabaseLogfile::Database_UpgradeDB() {
         return -1;
     }
 
+    // Multi-row variant of the packet insert used for full batches; the
+    // single-row statement above handles the remainder at flush time
+    sql =
+        "INSERT INTO packets "
+        "(ts_sec, ts_usec, phyname, "
+        "sourcemac, destmac, transmac, devkey, frequency, "
+        "lat, lon, "
+        "packet_len, signal, "
+        "datasource, "
+        "dlt, packet, packet_hash, "
+        "error) "
+        "VALUES ";
+
+    for (unsigned int pi = 0; pi < packet_batch_rows; pi++) {
+        if (pi != 0)
+            sql += ", ";
+        sql += "(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+    }
+
+    r = sqlite3_prepare(db, sql.c_str(), sql.length(), &packet_batch_stmt, &packet_batch_pz);
+
+    if (r != SQLITE_OK) {
+        _MSG("KisDatabaseLogfile unable to prepare batched database insert for "
+                "packets in " + ds_dbfile + ":" + std::string(sqlite3_errmsg(db)),
+                MSGFLAG_ERROR);
+        Log_Close();
+        return -1;
+    }
+
+    // Duplicate hashes fall through to the UNIQUE conflict clause
+    sql =
+        "INSERT INTO packet_blobs "
+        "(hash, refcount, packet) "
+        "VALUES (?, 0, ?)";
+
+    r = sqlite3_prepare(db, sql.c_str(), sql.length(), &blob_stmt, &blob_pz);
+
+    if (r != SQLITE_OK) {
+        _MSG("KisDatabaseLogfile unable to prepare database insert for packet "
+                "blobs in " + ds_dbfile + ":" + std::string(sqlite3_errmsg(db)),
+                MSGFLAG_ERROR);
+        Log_Close();
+        return -1;
+    }
+
+    sql =
+        "UPDATE packet_blobs SET refcount = refcount + ? WHERE hash = ?";
+
+    r = sqlite3_prepare(db, sql.c_str(), sql.length(), &blob_ref_stmt, &blob_ref_pz);
+
+    if (r != SQLITE_OK) {
+        _MSG("KisDatabaseLogfile unable to prepare refcount update for packet "
+                "blobs in " + ds_dbfile + ":" + std::string(sqlite3_errmsg(db)),
+                MSGFLAG_ERROR);
+        Log_Close();
+        return -1;
+    }
+
     sql =
         "INSERT INTO data "
         "(ts_sec, ts_usec, "
@@ -561,97 +1057,263 @@ int KisDatabaseLogfile::Database_UpgradeDB() {
     return 1;
 }
 
-int KisDatabaseLogfile::log_devices(TrackerElementVector in_devices) {
-    // We avoid using external mutexes here and try to let sqlite3 handle its own
-    // internal locking state; we don't want a huge device list write to block packet
-    // writes for instance
-    
-    local_locker lock(&device_mutex);
-
+void KisDatabaseLogfile::Log_Device(SharedTrackerElement in_device,
+        std::shared_ptr<const std::string> in_json) {
     if (!db_enabled)
-        return 0;
+        return;
 
-    std::string sql;
+    if (in_device == NULL)
+        return;
 
-    std::string phystring;
-    std::string macstring;
-    std::string typestring;
-    std::string keystring;
+    {
+        std::shared_ptr<kis_tracked_device_base> d =
+            std::static_pointer_cast<kis_tracked_device_base>(in_device);
 
-    for (auto i : in_devices) {
-        if (i == NULL)
-            continue;
+        // Extract the row values on the calling thread, which holds the
+        // device list; the writer thread only sees the finished values and
+        // the shared pre-serialized record
+        std::string phystring = d->get_phyname();
+        std::string macstring = d->get_macaddr().Mac2String();
+        std::string typestring = d->get_type_string();
+        std::string keystring = d->get_key().as_string();
 
-        sqlite3_reset(device_stmt);
+        int64_t first_time = d->get_first_time();
+        int64_t last_time = d->get_last_time();
+        int max_signal = d->get_signal_data()->get_max_signal_dbm();
+        int64_t datasize = d->get_datasize();
 
-        std::shared_ptr<kis_tracked_device_base> d =
-            std::static_pointer_cast<kis_tracked_device_base>(i);
+        int64_t min_lat = 0, min_lon = 0, max_lat = 0, max_lon = 0,
+                avg_lat = 0, avg_lon = 0;
 
-        phystring = d->get_phyname();
-        macstring = d->get_macaddr().Mac2String();
-        typestring = d->get_type_string();
-        keystring = d->get_key().as_string();
+        if (d->get_tracker_location() != NULL) {
+            min_lat = d->get_location()->get_min_loc()->get_lat() * 100000;
+            min_lon = d->get_location()->get_min_loc()->get_lon() * 100000;
+            max_lat = d->get_location()->get_max_loc()->get_lat() * 100000;
+            max_lon = d->get_location()->get_max_loc()->get_lon() * 100000;
+            avg_lat = d->get_location()->get_avg_loc()->get_lat() * 100000;
+            avg_lon = d->get_location()->get_avg_loc()->get_lon() * 100000;
+        }
 
-        int spos = 1;
+        EnqueueWrite(new std::function<void ()>(
+                [this, first_time, last_time, keystring, phystring, macstring,
+                max_signal, min_lat, min_lon, max_lat, max_lon, avg_lat,
+                avg_lon, datasize, typestring, in_json]() {
 
-        sqlite3_bind_int64(device_stmt, spos++, d->get_first_time());
-        sqlite3_bind_int64(device_stmt, spos++, d->get_last_time());
-        sqlite3_bind_text(device_stmt, spos++, keystring.c_str(), keystring.length(), 0);
-        sqlite3_bind_text(device_stmt, spos++, phystring.c_str(), phystring.length(), 0);
-        sqlite3_bind_text(device_stmt, spos++, macstring.c_str(), macstring.length(), 0);
-        sqlite3_bind_int(device_stmt, spos++, d->get_signal_data()->get_max_signal_dbm());
+            local_locker lock(&device_mutex);
 
-        if (d->get_tracker_location() != NULL) {
-            sqlite3_bind_int64(device_stmt, spos++, 
-                    d->get_location()->get_min_loc()->get_lat() * 100000);
-            sqlite3_bind_int64(device_stmt, spos++,
-                    d->get_location()->get_min_loc()->get_lon() * 100000);
-            sqlite3_bind_int64(device_stmt, spos++,
-                    d->get_location()->get_max_loc()->get_lat() * 100000);
-            sqlite3_bind_int64(device_stmt, spos++,
-                    d->get_location()->get_max_loc()->get_lon() * 100000);
-            sqlite3_bind_int64(device_stmt, spos++,
-                    d->get_location()->get_avg_loc()->get_lat() * 100000);
-            sqlite3_bind_int64(device_stmt, spos++,
-                    d->get_location()->get_avg_loc()->get_lon() * 100000);
+            if (device_stmt == NULL)
+                return;
+
+            sqlite3_reset(device_stmt);
+
+            int spos = 1;
+
+            sqlite3_bind_int64(device_stmt, spos++, first_time);
+            sqlite3_bind_int64(device_stmt, spos++, last_time);
+            sqlite3_bind_text(device_stmt, spos++, keystring.c_str(), keystring.length(), 0);
+            sqlite3_bind_text(device_stmt, spos++, phystring.c_str(), phystring.length(), 0);
+            sqlite3_bind_text(device_stmt, spos++, macstring.c_str(), macstring.length(), 0);
+            sqlite3_bind_int(device_stmt, spos++, max_signal);
+
+            sqlite3_bind_int64(device_stmt, spos++, min_lat);
+            sqlite3_bind_int64(device_stmt, spos++, min_lon);
+            sqlite3_bind_int64(device_stmt, spos++, max_lat);
+            sqlite3_bind_int64(device_stmt, spos++, max_lon);
+            sqlite3_bind_int64(device_stmt, spos++, avg_lat);
+            sqlite3_bind_int64(device_stmt, spos++, avg_lon);
+
+            sqlite3_bind_int64(device_stmt, spos++, datasize);
+            sqlite3_bind_text(device_stmt, spos++, typestring.c_str(), typestring.length(), 0);
+
+            // Compress on the writer thread, not the device list thread;
+            // the blob must stay in scope until the step completes
+            std::string devblob = *in_json;
+            if (log_compression)
+                devblob = compress_log_blob(*in_json);
+
+            sqlite3_bind_blob(device_stmt, spos++, devblob.data(), devblob.length(), 0);
+
+            if (timed_step(device_stmt, "device") != SQLITE_DONE) {
+                _MSG("KisDatabaseLogfile unable to insert device in " +
+                        ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+                writer_failed = true;
+                return;
+            }
+
+            CountTransactionRow();
+        }));
+    }
+}
+
+int KisDatabaseLogfile::BindPacketRow(sqlite3_stmt *stmt, int in_col,
+        const db_packet_row& row) {
+    int col = in_col;
+
+    // Strings and the capture blob bind SQLITE_STATIC against the staging
+    // storage, which is stable until the batch is cleared after the step
+    sqlite3_bind_int64(stmt, col++, row.ts_sec);
+    sqlite3_bind_int64(stmt, col++, row.ts_usec);
+
+    sqlite3_bind_text(stmt, col++, row.phystring.c_str(), row.phystring.length(), 0);
+    sqlite3_bind_text(stmt, col++, row.macstring.c_str(), row.macstring.length(), 0);
+    sqlite3_bind_text(stmt, col++, row.deststring.c_str(), row.deststring.length(), 0);
+    sqlite3_bind_text(stmt, col++, row.transstring.c_str(), row.transstring.length(), 0);
+    sqlite3_bind_text(stmt, col++, row.keystring.c_str(), row.keystring.length(), 0);
+    sqlite3_bind_double(stmt, col++, row.frequency);
+
+    sqlite3_bind_int64(stmt, col++, row.lat);
+    sqlite3_bind_int64(stmt, col++, row.lon);
+
+    sqlite3_bind_int64(stmt, col++, row.chunk_length);
+    sqlite3_bind_int(stmt, col++, row.signal_dbm);
+
+    sqlite3_bind_text(stmt, col++, row.sourceuuidstring.c_str(),
+            row.sourceuuidstring.length(), 0);
+
+    if (row.chunk_dlt >= 0) {
+        sqlite3_bind_int(stmt, col++, row.chunk_dlt);
+
+        // Content-addressed rows carry only the hash; the payload lives in
+        // the packet_blobs table
+        if (log_dedup) {
+            sqlite3_bind_null(stmt, col++);
+            sqlite3_bind_int64(stmt, col++, (int64_t) row.chunk_hash);
         } else {
-            // Empty location
-            sqlite3_bind_int(device_stmt, spos++, 0);
-            sqlite3_bind_int(device_stmt, spos++, 0);
-            sqlite3_bind_int(device_stmt, spos++, 0);
-            sqlite3_bind_int(device_stmt, spos++, 0);
-            sqlite3_bind_int(device_stmt, spos++, 0);
-            sqlite3_bind_int(device_stmt, spos++, 0);
+            sqlite3_bind_blob(stmt, col++, row.chunk_data.data(),
+                    row.chunk_data.length(), 0);
+            sqlite3_bind_null(stmt, col++);
         }
+    } else {
+        sqlite3_bind_int(stmt, col++, -1);
+        sqlite3_bind_text(stmt, col++, "", 0, 0);
+        sqlite3_bind_null(stmt, col++);
+    }
 
-        sqlite3_bind_int64(device_stmt, spos++, d->get_datasize());
-        sqlite3_bind_text(device_stmt, spos++, typestring.c_str(), typestring.length(), 0);
+    sqlite3_bind_int(stmt, col++, row.pack_error);
 
-        std::stringstream sstr;
+    return col;
+}
 
-        // Serialize the device
-        JsonAdapter::Pack(globalreg, sstr, d, NULL);
-        std::string streamstring = sstr.str();
-        sqlite3_bind_text(device_stmt, spos++, streamstring.c_str(), streamstring.length(), 0);
+void KisDatabaseLogfile::FlushPacketBatch() {
+    // Caller holds packet_mutex
+    if (packet_batch.size() == 0)
+        return;
 
-        if (sqlite3_step(device_stmt) != SQLITE_DONE) {
-            _MSG("KisDatabaseLogfile unable to insert device in " +
+    if (packet_stmt == NULL) {
+        packet_batch.clear();
+        return;
+    }
+
+    size_t n = 0;
+    size_t flushed = 0;
+
+    // Content-address the payloads first so every packet row's hash has a
+    // backing blob row in the same transaction; distinct payloads insert
+    // once and the reference counts batch into one update per hash
+    if (log_dedup && blob_stmt != NULL && blob_ref_stmt != NULL) {
+        std::map<uint64_t, uint64_t> hash_counts;
+
+        for (auto& row : packet_batch) {
+            if (row.chunk_dlt < 0)
+                continue;
+
+            row.chunk_hash = hash_log_blob(row.chunk_data);
+            hash_counts[row.chunk_hash]++;
+
+            if (known_blob_hashes.size() > known_blob_cache_max)
+                known_blob_hashes.clear();
+
+            if (known_blob_hashes.insert(row.chunk_hash).second) {
+                sqlite3_reset(blob_stmt);
+
+                sqlite3_bind_int64(blob_stmt, 1, (int64_t) row.chunk_hash);
+                sqlite3_bind_blob(blob_stmt, 2, row.chunk_data.data(),
+                        row.chunk_data.length(), 0);
+
+                if (timed_step(blob_stmt, "packet_blob") != SQLITE_DONE) {
+                    _MSG("KisDatabaseLogfile unable to insert packet blob in " +
+                            ds_dbfile + ":" + std::string(sqlite3_errmsg(db)),
+                            MSGFLAG_ERROR);
+                    writer_failed = true;
+                    packet_batch.clear();
+                    return;
+                }
+
+                flushed++;
+            }
+        }
+
+        for (auto hc : hash_counts) {
+            sqlite3_reset(blob_ref_stmt);
+
+            sqlite3_bind_int64(blob_ref_stmt, 1, (int64_t) hc.second);
+            sqlite3_bind_int64(blob_ref_stmt, 2, (int64_t) hc.first);
+
+            if (timed_step(blob_ref_stmt, "packet_blob_ref") != SQLITE_DONE) {
+                _MSG("KisDatabaseLogfile unable to update packet blob refcount in " +
+                        ds_dbfile + ":" + std::string(sqlite3_errmsg(db)),
+                        MSGFLAG_ERROR);
+                writer_failed = true;
+                packet_batch.clear();
+                return;
+            }
+        }
+    }
+
+    // Full batches through the multi-row statement
+    while (packet_batch_stmt != NULL &&
+            packet_batch.size() - n >= packet_batch_rows) {
+        sqlite3_reset(packet_batch_stmt);
+
+        int col = 1;
+        for (size_t r = 0; r < packet_batch_rows; r++)
+            col = BindPacketRow(packet_batch_stmt, col, packet_batch[n + r]);
+
+        if (timed_step(packet_batch_stmt, "packet_batch") != SQLITE_DONE) {
+            _MSG("KisDatabaseLogfile unable to insert packets in " +
                     ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
-            Log_Close();
-            return -1;
+            writer_failed = true;
+            packet_batch.clear();
+            return;
         }
+
+        n += packet_batch_rows;
+        flushed += packet_batch_rows;
     }
 
-    return 1;
+    // Remainder one at a time through the single-row statement
+    for (; n < packet_batch.size(); n++) {
+        sqlite3_reset(packet_stmt);
+        BindPacketRow(packet_stmt, 1, packet_batch[n]);
+
+        if (timed_step(packet_stmt, "packet") != SQLITE_DONE) {
+            _MSG("KisDatabaseLogfile unable to insert packet in " +
+                    ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+            writer_failed = true;
+            packet_batch.clear();
+            return;
+        }
+
+        flushed++;
+    }
+
+    // Clear the staging vector before counting rows against the
+    // transaction batch; a commit triggered by the count re-enters the
+    // flush and finds it empty
+    packet_batch.clear();
+
+    for (size_t i = 0; i < flushed; i++)
+        CountTransactionRow();
 }
 
 int KisDatabaseLogfile::log_packet(kis_packet *in_pack) {
-    local_locker lock(&packet_mutex);
-    
     if (!db_enabled)
         return 0;
 
-    sqlite3_reset(packet_stmt);
+    // Duplicate copies of a frame heard by overlapping datasources can be
+    // skipped to shrink the log
+    if (!log_duplicate_packets && in_pack->duplicate)
+        return 0;
 
     std::string phystring;
     std::string macstring;
@@ -661,10 +1323,10 @@ int KisDatabaseLogfile::log_packet(kis_packet *in_pack) {
     std::string sourceuuidstring;
     double frequency;
 
-    kis_datachunk *chunk = 
+    kis_datachunk *chunk =
         (kis_datachunk *) in_pack->fetch(pack_comp_linkframe);
 
-    kis_layer1_packinfo *radioinfo = 
+    kis_layer1_packinfo *radioinfo =
         (kis_layer1_packinfo *) in_pack->fetch(pack_comp_radiodata);
 
     kis_gps_packinfo *gpsdata =
@@ -710,54 +1372,56 @@ int KisDatabaseLogfile::log_packet(kis_packet *in_pack) {
         sourceuuidstring = "00000000-0000-0000-0000-000000000000";
     }
 
-    sqlite3_bind_int64(packet_stmt, 1, in_pack->ts.tv_sec);
-    sqlite3_bind_int64(packet_stmt, 2, in_pack->ts.tv_usec);
-
-    sqlite3_bind_text(packet_stmt, 3, phystring.c_str(), phystring.length(), 0);
-    sqlite3_bind_text(packet_stmt, 4, macstring.c_str(), macstring.length(), 0);
-    sqlite3_bind_text(packet_stmt, 5, deststring.c_str(), deststring.length(), 0);
-    sqlite3_bind_text(packet_stmt, 6, transstring.c_str(), transstring.length(), 0);
-    sqlite3_bind_text(packet_stmt, 7, keystring.c_str(), keystring.length(), 0);
-    sqlite3_bind_double(packet_stmt, 8, frequency);
-
+    // Copy everything out of the packet record; the packet itself is
+    // recycled as soon as the logging chain returns, so the closure must
+    // be entirely self-contained
+    db_packet_row row;
+
+    row.ts_sec = in_pack->ts.tv_sec;
+    row.ts_usec = in_pack->ts.tv_usec;
+    row.pack_error = in_pack->error;
+
+    row.phystring = phystring;
+    row.macstring = macstring;
+    row.deststring = deststring;
+    row.transstring = transstring;
+    row.keystring = keystring;
+    row.sourceuuidstring = sourceuuidstring;
+    row.frequency = frequency;
+
+    row.lat = 0;
+    row.lon = 0;
     if (gpsdata != NULL) {
-        sqlite3_bind_int64(packet_stmt, 9, gpsdata->lat * 100000);
-        sqlite3_bind_int64(packet_stmt, 10, gpsdata->lon * 100000);
-    } else {
-        sqlite3_bind_int(packet_stmt, 9, 0);
-        sqlite3_bind_int(packet_stmt, 10, 0);
+        row.lat = gpsdata->lat * 100000;
+        row.lon = gpsdata->lon * 100000;
     }
 
+    row.chunk_length = 0;
+    row.chunk_dlt = -1;
+    row.chunk_hash = 0;
     if (chunk != NULL) {
-        sqlite3_bind_int64(packet_stmt, 11, chunk->length);
-    } else {
-        sqlite3_bind_int(packet_stmt, 11, 0);
+        row.chunk_length = chunk->length;
+        row.chunk_dlt = chunk->dlt;
+        row.chunk_data.assign((const char *) chunk->data, chunk->length);
     }
 
-    if (radioinfo != NULL) {
-        sqlite3_bind_int(packet_stmt, 12, radioinfo->signal_dbm);
-    } else {
-        sqlite3_bind_int(packet_stmt, 12, 0);
-    }
+    row.signal_dbm = 0;
+    if (radioinfo != NULL)
+        row.signal_dbm = radioinfo->signal_dbm;
 
-    sqlite3_bind_text(packet_stmt, 13, sourceuuidstring.c_str(), sourceuuidstring.length(), 0);
+    EnqueueWrite(new std::function<void ()>([this, row]() mutable {
+        local_locker lock(&packet_mutex);
 
-    if (chunk != NULL) {
-        sqlite3_bind_int(packet_stmt, 14, chunk->dlt);
-        sqlite3_bind_blob(packet_stmt, 15, (const char *) chunk->data, chunk->length, 0);
-    } else {
-        sqlite3_bind_int(packet_stmt, 14, -1);
-        sqlite3_bind_text(packet_stmt, 15, "", 0, 0);
-    }
+        if (packet_stmt == NULL)
+            return;
 
-    sqlite3_bind_int(packet_stmt, 16, in_pack->error);
+        // Stage the row; full batches go through the multi-row insert,
+        // and partial batches are folded in by the transaction commit
+        packet_batch.push_back(std::move(row));
 
-    if (sqlite3_step(packet_stmt) != SQLITE_DONE) {
-        _MSG("KisDatabaseLogfile unable to insert packet in " +
-                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
-        Log_Close();
-        return -1;
-    }
+        if (packet_batch.size() >= packet_batch_rows)
+            FlushPacketBatch();
+    }));
 
     // If the packet has a metablob record, log that
     if (metablob != NULL) {
@@ -767,7 +1431,7 @@ int KisDatabaseLogfile::log_packet(kis_packet *in_pack) {
         if (commoninfo != NULL)
             smac = commoninfo->source;
 
-        if (datasrc != NULL) 
+        if (datasrc != NULL)
             puuid = datasrc->ref_source->get_source_uuid();
 
         log_data(gpsdata, in_pack->ts, phystring, smac, puuid,
@@ -777,44 +1441,63 @@ int KisDatabaseLogfile::log_packet(kis_packet *in_pack) {
     return 1;
 }
 
-int KisDatabaseLogfile::log_data(kis_gps_packinfo *gps, struct timeval tv, 
-        std::string phystring, mac_addr devmac, uuid datasource_uuid, 
+int KisDatabaseLogfile::log_data(kis_gps_packinfo *gps, struct timeval tv,
+        std::string phystring, mac_addr devmac, uuid datasource_uuid,
         std::string type, std::string json) {
-    local_locker lock(&data_mutex);
-
     if (!db_enabled)
         return 0;
 
-    sqlite3_reset(data_stmt);
-
     std::string macstring = devmac.Mac2String();
     std::string uuidstring = datasource_uuid.UUID2String();
 
-    sqlite3_bind_int64(data_stmt, 1, tv.tv_sec);
-    sqlite3_bind_int64(data_stmt, 2, tv.tv_usec);
-
-    sqlite3_bind_text(data_stmt, 3, phystring.c_str(), phystring.length(), 0);
-    sqlite3_bind_text(data_stmt, 4, macstring.c_str(), macstring.length(), 0);
+    int64_t ts_sec = tv.tv_sec;
+    int64_t ts_usec = tv.tv_usec;
 
+    int64_t lat = 0, lon = 0;
     if (gps != NULL) {
-        sqlite3_bind_int64(data_stmt, 5, gps->lat * 100000);
-        sqlite3_bind_int64(data_stmt, 6, gps->lon * 100000);
-    } else {
-        sqlite3_bind_int(data_stmt, 5, 0);
-        sqlite3_bind_int(data_stmt, 6, 0);
+        lat = gps->lat * 100000;
+        lon = gps->lon * 100000;
     }
 
-    sqlite3_bind_text(data_stmt, 7, uuidstring.c_str(), uuidstring.length(), 0);
+    EnqueueWrite(new std::function<void ()>(
+            [this, ts_sec, ts_usec, phystring, macstring, lat, lon,
+            uuidstring, type, json]() {
 
-    sqlite3_bind_text(data_stmt, 8, type.data(), type.length(), 0);
-    sqlite3_bind_text(data_stmt, 9, json.data(), json.length(), 0);
+        local_locker lock(&data_mutex);
 
-    if (sqlite3_step(data_stmt) != SQLITE_DONE) {
-        _MSG("KisDatabaseLogfile unable to insert data in " +
-                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
-        Log_Close();
-        return -1;
-    }
+        if (data_stmt == NULL)
+            return;
+
+        sqlite3_reset(data_stmt);
+
+        sqlite3_bind_int64(data_stmt, 1, ts_sec);
+        sqlite3_bind_int64(data_stmt, 2, ts_usec);
+
+        sqlite3_bind_text(data_stmt, 3, phystring.c_str(), phystring.length(), 0);
+        sqlite3_bind_text(data_stmt, 4, macstring.c_str(), macstring.length(), 0);
+
+        sqlite3_bind_int64(data_stmt, 5, lat);
+        sqlite3_bind_int64(data_stmt, 6, lon);
+
+        sqlite3_bind_text(data_stmt, 7, uuidstring.c_str(), uuidstring.length(), 0);
+
+        sqlite3_bind_text(data_stmt, 8, type.data(), type.length(), 0);
+
+        std::string jsonblob = json;
+        if (log_compression)
+            jsonblob = compress_log_blob(json);
+
+        sqlite3_bind_blob(data_stmt, 9, jsonblob.data(), jsonblob.length(), 0);
+
+        if (timed_step(data_stmt, "data") != SQLITE_DONE) {
+            _MSG("KisDatabaseLogfile unable to insert data in " +
+                    ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+            writer_failed = true;
+            return;
+        }
+
+        CountTransactionRow();
+    }));
 
     return 1;
 }
@@ -838,16 +1521,12 @@ int KisDatabaseLogfile::log_datasources(SharedTrackerElement in_datasource_vec)
 }
 
 int KisDatabaseLogfile::log_datasource(SharedTrackerElement in_datasource) {
-    local_locker lock(&datasource_mutex);
-
     if (!db_enabled)
         return 0;
 
     std::shared_ptr<KisDatasource> ds =
         std::static_pointer_cast<KisDatasource>(in_datasource);
 
-    sqlite3_reset(datasource_stmt);
-
     std::string uuidstring = ds->get_source_uuid().UUID2String();
     std::string typestring = ds->get_source_builder()->get_source_type();
     std::string defstring = ds->get_source_definition();
@@ -855,75 +1534,99 @@ int KisDatabaseLogfile::log_datasource(SharedTrackerElement in_datasource) {
     std::string intfstring = ds->get_source_interface();
 
     std::stringstream ss;
-    std::string jsonstring;
+    JsonAdapter::Pack(globalreg, ss, in_datasource, NULL);
+    std::string jsonstring = ss.str();
 
-    sqlite3_bind_text(datasource_stmt, 1, uuidstring.data(), uuidstring.length(), 0);
-    sqlite3_bind_text(datasource_stmt, 2, typestring.data(), typestring.length(), 0);
-    sqlite3_bind_text(datasource_stmt, 3, defstring.data(), defstring.length(), 0);
-    sqlite3_bind_text(datasource_stmt, 4, namestring.data(), namestring.length(), 0);
-    sqlite3_bind_text(datasource_stmt, 5, intfstring.data(), intfstring.length(), 0);
+    EnqueueWrite(new std::function<void ()>(
+            [this, uuidstring, typestring, defstring, namestring, intfstring,
+            jsonstring]() {
 
-    JsonAdapter::Pack(globalreg, ss, in_datasource, NULL);
-    jsonstring = ss.str();
+        local_locker lock(&datasource_mutex);
 
-    sqlite3_bind_text(datasource_stmt, 6, jsonstring.data(), jsonstring.length(), 0);
+        if (datasource_stmt == NULL)
+            return;
 
-    if (sqlite3_step(datasource_stmt) != SQLITE_DONE) {
-        _MSG("KisDatabaseLogfile unable to insert datasource in " +
-                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
-        Log_Close();
-        return -1;
-    }
+        sqlite3_reset(datasource_stmt);
+
+        sqlite3_bind_text(datasource_stmt, 1, uuidstring.data(), uuidstring.length(), 0);
+        sqlite3_bind_text(datasource_stmt, 2, typestring.data(), typestring.length(), 0);
+        sqlite3_bind_text(datasource_stmt, 3, defstring.data(), defstring.length(), 0);
+        sqlite3_bind_text(datasource_stmt, 4, namestring.data(), namestring.length(), 0);
+        sqlite3_bind_text(datasource_stmt, 5, intfstring.data(), intfstring.length(), 0);
+
+        sqlite3_bind_text(datasource_stmt, 6, jsonstring.data(), jsonstring.length(), 0);
+
+        if (timed_step(datasource_stmt, "datasource") != SQLITE_DONE) {
+            _MSG("KisDatabaseLogfile unable to insert datasource in " +
+                    ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+            writer_failed = true;
+            return;
+        }
+
+        CountTransactionRow();
+    }));
 
     return 1;
 }
 
 int KisDatabaseLogfile::log_alert(std::shared_ptr<tracked_alert> in_alert) {
-    local_locker lock(&alert_mutex);
-
     if (!db_enabled)
         return 0;
 
-    sqlite3_reset(alert_stmt);
-
     std::string macstring = in_alert->get_transmitter_mac().Mac2String();
     std::string phystring = devicetracker->FetchPhyName(in_alert->get_phy());
     std::string headerstring = in_alert->get_header();
 
-    std::stringstream ss;
-    std::string jsonstring;
-
     // Break the double timestamp into two integers
     double intpart, fractpart;
     fractpart = modf(in_alert->get_timestamp(), &intpart);
 
-    sqlite3_bind_int64(alert_stmt, 1, intpart);
-    sqlite3_bind_int64(alert_stmt, 2, fractpart * 1000000);
-
-    sqlite3_bind_text(alert_stmt, 3, phystring.c_str(), phystring.length(), 0);
-    sqlite3_bind_text(alert_stmt, 4, macstring.c_str(), macstring.length(), 0);
+    int64_t ts_sec = intpart;
+    int64_t ts_usec = fractpart * 1000000;
 
+    int64_t lat = 0, lon = 0;
     if (in_alert->get_location()->get_valid()) {
-        sqlite3_bind_int64(alert_stmt, 5, in_alert->get_location()->get_lat() * 100000);
-        sqlite3_bind_int64(alert_stmt, 6, in_alert->get_location()->get_lon() * 100000);
-    } else {
-        sqlite3_bind_int(alert_stmt, 5, 0);
-        sqlite3_bind_int(alert_stmt, 6, 0);
+        lat = in_alert->get_location()->get_lat() * 100000;
+        lon = in_alert->get_location()->get_lon() * 100000;
     }
 
-    sqlite3_bind_text(alert_stmt, 7, headerstring.c_str(), headerstring.length(), 0);
-
+    std::stringstream ss;
     JsonAdapter::Pack(globalreg, ss, in_alert, NULL);
-    jsonstring = ss.str();
+    std::string jsonstring = ss.str();
 
-    sqlite3_bind_text(alert_stmt, 8, jsonstring.data(), jsonstring.length(), 0);
+    EnqueueWrite(new std::function<void ()>(
+            [this, ts_sec, ts_usec, phystring, macstring, lat, lon,
+            headerstring, jsonstring]() {
 
-    if (sqlite3_step(alert_stmt) != SQLITE_DONE) {
-        _MSG("KisDatabaseLogfile unable to insert alert in " +
-                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
-        Log_Close();
-        return -1;
-    }
+        local_locker lock(&alert_mutex);
+
+        if (alert_stmt == NULL)
+            return;
+
+        sqlite3_reset(alert_stmt);
+
+        sqlite3_bind_int64(alert_stmt, 1, ts_sec);
+        sqlite3_bind_int64(alert_stmt, 2, ts_usec);
+
+        sqlite3_bind_text(alert_stmt, 3, phystring.c_str(), phystring.length(), 0);
+        sqlite3_bind_text(alert_stmt, 4, macstring.c_str(), macstring.length(), 0);
+
+        sqlite3_bind_int64(alert_stmt, 5, lat);
+        sqlite3_bind_int64(alert_stmt, 6, lon);
+
+        sqlite3_bind_text(alert_stmt, 7, headerstring.c_str(), headerstring.length(), 0);
+
+        sqlite3_bind_text(alert_stmt, 8, jsonstring.data(), jsonstring.length(), 0);
+
+        if (timed_step(alert_stmt, "alert") != SQLITE_DONE) {
+            _MSG("KisDatabaseLogfile unable to insert alert in " +
+                    ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+            writer_failed = true;
+            return;
+        }
+
+        CountTransactionRow();
+    }));
 
     return 1;
 }
@@ -931,34 +1634,51 @@ int KisDatabaseLogfile::log_alert(std::shared_ptr<tracked_alert> in_alert) {
 int KisDatabaseLogfile::log_snapshot(kis_gps_packinfo *gps, struct timeval tv,
         std::string snaptype, std::string json) {
 
-    local_locker lock(&snapshot_mutex);
-
     if (!db_enabled)
         return 0;
 
+    int64_t ts_sec = tv.tv_sec;
+    int64_t ts_usec = tv.tv_usec;
 
-    sqlite3_reset(snapshot_stmt);
-
-    sqlite3_bind_int64(snapshot_stmt, 1, tv.tv_sec);
-    sqlite3_bind_int64(snapshot_stmt, 2, tv.tv_usec);
-
+    int64_t lat = 0, lon = 0;
     if (gps != NULL) {
-        sqlite3_bind_int64(snapshot_stmt, 3, gps->lat * 100000);
-        sqlite3_bind_int64(snapshot_stmt, 4, gps->lon * 100000);
-    } else {
-        sqlite3_bind_int(snapshot_stmt, 3, 0);
-        sqlite3_bind_int(snapshot_stmt, 4, 0);
+        lat = gps->lat * 100000;
+        lon = gps->lon * 100000;
     }
 
-    sqlite3_bind_text(snapshot_stmt, 5, snaptype.c_str(), snaptype.length(), 0);
-    sqlite3_bind_text(snapshot_stmt, 6, json.data(), json.length(), 0);
+    EnqueueWrite(new std::function<void ()>(
+            [this, ts_sec, ts_usec, lat, lon, snaptype, json]() {
 
-    if (sqlite3_step(snapshot_stmt) != SQLITE_DONE) {
-        _MSG("KisDatabaseLogfile unable to insert snapshot in " +
-                ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
-        Log_Close();
-        return -1;
-    }
+        local_locker lock(&snapshot_mutex);
+
+        if (snapshot_stmt == NULL)
+            return;
+
+        sqlite3_reset(snapshot_stmt);
+
+        sqlite3_bind_int64(snapshot_stmt, 1, ts_sec);
+        sqlite3_bind_int64(snapshot_stmt, 2, ts_usec);
+
+        sqlite3_bind_int64(snapshot_stmt, 3, lat);
+        sqlite3_bind_int64(snapshot_stmt, 4, lon);
+
+        sqlite3_bind_text(snapshot_stmt, 5, snaptype.c_str(), snaptype.length(), 0);
+
+        std::string jsonblob = json;
+        if (log_compression)
+            jsonblob = compress_log_blob(json);
+
+        sqlite3_bind_blob(snapshot_stmt, 6, jsonblob.data(), jsonblob.length(), 0);
+
+        if (timed_step(snapshot_stmt, "snapshot") != SQLITE_DONE) {
+            _MSG("KisDatabaseLogfile unable to insert snapshot in " +
+                    ds_dbfile + ":" + std::string(sqlite3_errmsg(db)), MSGFLAG_ERROR);
+            writer_failed = true;
+            return;
+        }
+
+        CountTransactionRow();
+    }));
 
     return 1;
 }
@@ -976,16 +1696,122 @@ void KisDatabaseLogfile::Usage(const char *argv0) {
 }
 
 bool KisDatabaseLogfile::Httpd_VerifyPath(const char *path, const char *method) {
+    if (strcmp(method, "GET") != 0)
+        return false;
+
+    if (!Httpd_CanSerialize(path))
+        return false;
+
+    if (Httpd_StripSuffix(path) == "/logging/kismetdb/stats")
+        return true;
 
     return false;
 }
 
 int KisDatabaseLogfile::Httpd_CreateStreamResponse(Kis_Net_Httpd *httpd,
             Kis_Net_Httpd_Connection *connection,
-            const char *url, const char *method, const char *upload_data,
+            const char *path, const char *method, const char *upload_data,
             size_t *upload_data_size) {
 
-    return 0;
+    if (strcmp(method, "GET") != 0)
+        return MHD_YES;
+
+    if (Httpd_StripSuffix(path) != "/logging/kismetdb/stats")
+        return MHD_YES;
+
+    Kis_Net_Httpd_Buffer_Stream_Aux *saux =
+        (Kis_Net_Httpd_Buffer_Stream_Aux *) connection->custom_extension;
+
+    BufferHandlerOStreambuf *streambuf =
+        new BufferHandlerOStreambuf(saux->get_rbhandler());
+    std::ostream stream(streambuf);
+
+    saux->set_aux(streambuf,
+            [](Kis_Net_Httpd_Buffer_Stream_Aux *aux) {
+                if (aux->aux != NULL)
+                    delete((BufferHandlerOStreambuf *) (aux->aux));
+            });
+
+    saux->set_sync([streambuf](Kis_Net_Httpd_Buffer_Stream_Aux *aux) {
+            if (aux->aux != NULL) {
+                ((BufferHandlerOStreambuf *) aux->aux)->pubsync();
+                }
+            });
+
+    SharedTrackerElement statmap(new TrackerElement(TrackerMap, 0));
+
+    auto add_stat = [&statmap](int id, uint64_t v) {
+        SharedTrackerElement e(new TrackerElement(TrackerUInt64, id));
+        e->set(v);
+        statmap->add_map(e);
+    };
+
+    SharedTrackerElement histo(new TrackerElement(TrackerIntMap, stats_histo_id));
+    TrackerElementIntMap hmap(histo);
+
+    SharedTrackerElement slowvec(new TrackerElement(TrackerVector, stats_slow_vec_id));
+    TrackerElementVector svec(slowvec);
+
+    {
+        local_locker lock(&stats_mutex);
+
+        add_stat(stats_count_id, stmt_count);
+        add_stat(stats_total_usec_id, stmt_total_usec);
+        add_stat(stats_max_usec_id, stmt_max_usec);
+
+        for (unsigned int b = 0; b < PACKETCHAIN_LAT_BUCKETS; b++) {
+            if (stmt_latency_buckets[b] == 0)
+                continue;
+
+            SharedTrackerElement c(new TrackerElement(TrackerUInt64,
+                        stats_histo_count_id));
+            c->set(stmt_latency_buckets[b]);
+
+            hmap.insert(TrackerElementIntMap::pair(Packetchain::LatencyBucketFloor(b), c));
+        }
+
+        // Walk the ring oldest-first so the output reads chronologically
+        size_t nslow = slow_op_pos < slow_ops.size() ? slow_op_pos : slow_ops.size();
+        size_t start = slow_op_pos < slow_ops.size() ? 0 : slow_op_pos % slow_ops.size();
+
+        for (size_t s = 0; s < nslow; s++) {
+            const slow_op_rec& rec = slow_ops[(start + s) % slow_ops.size()];
+
+            SharedTrackerElement op(new TrackerElement(TrackerMap, 0));
+
+            SharedTrackerElement opname(new TrackerElement(TrackerString,
+                        stats_slow_op_id));
+            opname->set(rec.op);
+            op->add_map(opname);
+
+            SharedTrackerElement opusec(new TrackerElement(TrackerUInt64,
+                        stats_slow_usec_id));
+            opusec->set(rec.usec);
+            op->add_map(opusec);
+
+            SharedTrackerElement oprows(new TrackerElement(TrackerUInt64,
+                        stats_slow_rows_id));
+            oprows->set(rec.rows);
+            op->add_map(oprows);
+
+            SharedTrackerElement opts(new TrackerElement(TrackerUInt64,
+                        stats_slow_ts_id));
+            opts->set((uint64_t) rec.ts);
+            op->add_map(opts);
+
+            svec.push_back(op);
+        }
+    }
+
+    add_stat(stats_queue_id, writer_queue == NULL ? 0 : writer_queue->approx_size());
+    add_stat(stats_dropped_id, dropped_log_rows);
+
+    statmap->add_map(histo);
+    statmap->add_map(slowvec);
+
+    globalreg->entrytracker->Serialize(httpd->GetSuffix(path), stream, statmap, NULL);
+
+    return MHD_YES;
 }
 
 int KisDatabaseLogfile::Httpd_PostComplete(Kis_Net_Httpd_Connection *concls) {
@@ -37,8 +37,11 @@
 
 #include "config.h"
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <string>
+#include <unordered_set>
 
 #include "globalregistry.h"
 #include "kis_mutex.h"
@@ -75,8 +78,11 @@ public:
 
     virtual int Database_UpgradeDB();
 
-    // Log a vector of multiple devices, replacing any old device records
-    virtual int log_devices(TrackerElementVector in_devices);
+    // Log a device snapshot record; the json blob comes pre-serialized
+    // from the log tracker fan-out and is shared with any other sinks
+    virtual bool Log_AcceptsDevices() { return true; }
+    virtual void Log_Device(SharedTrackerElement in_device,
+            std::shared_ptr<const std::string> in_json);
 
     // Device logs are non-streaming; we need to know the last time we generated
     // device logs so that we can update just the logs we need.
@@ -123,6 +129,16 @@ protected:
     // Is the database even enabled?
     bool db_enabled;
 
+    // Do we log duplicate copies of frames heard by multiple datasources?
+    bool log_duplicate_packets;
+
+    // Do we zlib-compress JSON blobs before inserting them?
+    bool log_compression;
+
+    // Do we content-address packet payloads into the refcounted blob
+    // table instead of storing a copy per packet row?
+    bool log_dedup;
+
     // Per-table mutexes to prevent clobbering prepared statements
     kis_recursive_timed_mutex device_mutex, packet_mutex, data_mutex,
         alert_mutex, msg_mutex, snapshot_mutex, datasource_mutex;
@@ -142,6 +158,57 @@ protected:
     sqlite3_stmt *packet_stmt;
     const char *packet_pz;
 
+    // One staged packet insert; strings and the capture blob are bound
+    // SQLITE_STATIC straight out of this storage when the batch flushes
+    struct db_packet_row {
+        int64_t ts_sec, ts_usec;
+        std::string phystring, macstring, deststring, transstring, keystring;
+        double frequency;
+        int64_t lat, lon;
+        int64_t chunk_length;
+        int signal_dbm;
+        std::string sourceuuidstring;
+        int chunk_dlt;
+        std::string chunk_data;
+        uint64_t chunk_hash;
+        int pack_error;
+    };
+
+    // Packet inserts are staged on the writer thread and inserted in groups
+    // through a multi-row VALUES statement, cutting the per-row
+    // bind/step/reset overhead; partial batches are folded in by the
+    // transaction commit so rows never wait past a commit window.  Sized to
+    // stay under the sqlite default 999 bound-parameter limit (17 columns
+    // per row)
+    static const size_t packet_batch_rows = 32;
+
+    sqlite3_stmt *packet_batch_stmt;
+    const char *packet_batch_pz;
+
+    std::vector<db_packet_row> packet_batch;
+
+    // Content-addressed payload storage; distinct payloads are inserted
+    // once into the packet_blobs table keyed by hash and refcounted
+    sqlite3_stmt *blob_stmt;
+    const char *blob_pz;
+
+    sqlite3_stmt *blob_ref_stmt;
+    const char *blob_ref_pz;
+
+    // Hashes already known to have a blob row, so repeats skip even the
+    // conflict-ignored insert.  Purely an optimization - clearing it just
+    // costs redundant ignored inserts - so it's bounded by flushing it
+    // rather than growing with every distinct payload
+    static const size_t known_blob_cache_max = 262144;
+    std::unordered_set<uint64_t> known_blob_hashes;
+
+    // Bind one row's columns starting at in_col, returning the next free
+    // column index
+    int BindPacketRow(sqlite3_stmt *stmt, int in_col, const db_packet_row& row);
+
+    // Insert everything staged; the caller must hold packet_mutex
+    void FlushPacketBatch();
+
     sqlite3_stmt *datasource_stmt;
     const char *datasource_pz;
 
@@ -163,6 +230,74 @@ protected:
     // commit state we run a 10 second tranasction commit loop
     kis_recursive_timed_mutex transaction_mutex;
     int transaction_timer;
+
+    // Batch commit controls; the open transaction is committed and
+    // re-opened every kis_log_transaction_time milliseconds, or after
+    // kis_log_transaction_rows inserted rows, whichever comes first
+    unsigned int transaction_rows;
+    unsigned int transaction_row_limit;
+
+    // Commit the open transaction and start the next batch
+    void CommitTransaction();
+    // Count an inserted row against the batch limit, committing if the
+    // batch is full
+    void CountTransactionRow();
+
+    // Dedicated writer thread; inserts are bound into self-contained
+    // closures by the calling thread and executed here in order, so log
+    // pressure backs up this queue - and eventually sheds log rows -
+    // instead of stalling the packet chain or the timetracker
+    static void *database_writer_processor(void *in_arg);
+
+    // Hand a write closure to the writer thread, taking ownership; if the
+    // queue is full the row is dropped and counted
+    void EnqueueWrite(std::function<void ()> *in_work);
+
+    mpsc_bounded_queue<std::function<void ()> *> *writer_queue;
+    conditional_locker<int> writer_condition;
+    std::atomic<bool> writer_sleeping;
+    std::atomic<bool> writer_shutdown;
+    pthread_t writer_thread;
+
+    // A write failure in the writer thread can't close the log from its
+    // own context; it flags the failure and the transaction timer closes
+    // the log from the main loop
+    std::atomic<bool> writer_failed;
+
+    std::atomic<uint64_t> dropped_log_rows;
+    time_t last_drop_warning;
+
+    // Statement timing; every prepared-statement execution on the writer
+    // thread goes through timed_step, which accumulates a log-linear
+    // latency histogram (sharing the packetchain bucket geometry) and a
+    // ring of recent slow operations, so storage stalls can be separated
+    // from chain backpressure when the log falls behind
+    int timed_step(sqlite3_stmt *stmt, const char *in_op);
+
+    struct slow_op_rec {
+        std::string op;
+        uint64_t usec;
+        uint64_t rows;
+        time_t ts;
+    };
+
+    kis_recursive_timed_mutex stats_mutex;
+
+    uint64_t stmt_count, stmt_total_usec, stmt_max_usec;
+    uint64_t stmt_latency_buckets[PACKETCHAIN_LAT_BUCKETS];
+
+    // Ring of operations slower than the threshold, newest overwriting
+    // oldest; slow_op_pos counts total slow ops seen
+    std::vector<slow_op_rec> slow_ops;
+    size_t slow_op_pos;
+    uint64_t slow_op_threshold_usec;
+
+    // Entrytracker ids for the REST stats record
+    int stats_count_id, stats_total_usec_id, stats_max_usec_id,
+        stats_queue_id, stats_dropped_id,
+        stats_histo_id, stats_histo_count_id,
+        stats_slow_vec_id, stats_slow_op_id, stats_slow_usec_id,
+        stats_slow_rows_id, stats_slow_ts_id;
 };
 
 class KisDatabaseLogfileBuilder : public KisLogfileBuilder {
@@ -25,6 +25,11 @@
 #include "entrytracker.h"
 #include "alertracker.h"
 
+// Shared recycling pools for the components we generate for nearly every
+// packet from every source; packets return them here on destruction
+static packet_component_pool<kis_layer1_packinfo> siginfo_component_pool;
+static packet_component_pool<kis_datachunk> datachunk_component_pool;
+
 // We never instantiate from a generic tracker component or from a stored
 // record so we always re-allocate ourselves
 KisDatasource::KisDatasource(GlobalRegistry *in_globalreg, 
@@ -59,9 +64,17 @@ KisDatasource::KisDatasource(GlobalRegistry *in_globalreg,
     error_timer_id = -1;
     ping_timer_id = -1;
 
+    stat_packets.v = 0;
+    stat_error_packets.v = 0;
+
+    clock_offset_est_us = 0;
+    clock_offset_valid = false;
+
     mode_probing = false;
     mode_listing = false;
 
+    gettimeofday(&open_start_tv, NULL);
+
     std::shared_ptr<EntryTracker> entrytracker = 
         Globalreg::FetchGlobalAs<EntryTracker>(globalreg, "ENTRY_TRACKER");
     listed_interface_builder =
@@ -208,6 +221,9 @@ void KisDatasource::open_interface(std::string in_definition, unsigned int in_tr
     if (error_timer_id > 0)
         timetracker->RemoveTimer(error_timer_id);
 
+    // Clock the open so the open report can record how long it took
+    gettimeofday(&open_start_tv, NULL);
+
     // Launch the IPC
     launch_ipc();
 
@@ -579,6 +595,9 @@ bool KisDatasource::dispatch_rx_packet(std::shared_ptr<KismetExternal::Command>
     } else if (c->command() == "KDSDATAREPORT") {
         handle_packet_data_report(c->seqno(), c->content());
         return true;
+    } else if (c->command() == "KDSDATABATCH") {
+        handle_packet_data_batch(c->seqno(), c->content());
+        return true;
     } else if (c->command() == "KDSERRORREPORT") {
         handle_packet_error_report(c->seqno(), c->content());
         return true;
@@ -842,6 +861,14 @@ void KisDatasource::handle_packet_opensource_report(uint32_t in_seqno, std::stri
     set_int_source_running(report.success().success());
     set_int_source_error(!report.success().success());
 
+    // Record how long the open took, end to end, including the IPC launch
+    // and handshake
+    struct timeval open_end_tv;
+    gettimeofday(&open_end_tv, NULL);
+    set_int_source_open_time_us(
+            (uint64_t) (open_end_tv.tv_sec - open_start_tv.tv_sec) * 1000000ULL +
+            (open_end_tv.tv_usec - open_start_tv.tv_usec));
+
     uint32_t seq = report.success().seqno();
     auto ci = command_ack_map.find(seq);
     if (ci != command_ack_map.end()) {
@@ -1034,7 +1061,34 @@ void KisDatasource::handle_packet_data_report(uint32_t in_seqno, std::string in_
         return;
     }
 
-    if (report.has_message()) 
+    handle_data_report(report);
+}
+
+void KisDatasource::handle_packet_data_batch(uint32_t in_seqno, std::string in_content) {
+    // If we're paused, throw away the whole batch
+    {
+        local_locker lock(&ext_mutex);
+
+        if (get_source_paused())
+            return;
+    }
+
+    KismetDatasource::DataReportBatch batch;
+
+    if (!batch.ParseFromString(in_content)) {
+        _MSG(std::string("Kismet datasource driver ") + get_source_builder()->get_source_type() +
+                std::string(" could not parse the batched data report, something is wrong "
+                    "with the remote capture tool"), MSGFLAG_ERROR);
+        trigger_error("Invalid KDSDATABATCH");
+        return;
+    }
+
+    for (int r = 0; r < batch.reports_size(); r++)
+        handle_data_report(batch.reports(r));
+}
+
+void KisDatasource::handle_data_report(const KismetDatasource::DataReport& report) {
+    if (report.has_message())
         _MSG(report.message().msgtext(), report.message().msgtype());
 
     if (report.has_warning())
@@ -1062,14 +1116,14 @@ void KisDatasource::handle_packet_data_report(uint32_t in_seqno, std::string in_
     }
 
     // TODO handle spectrum
-   
+
     packetchain_comp_datasource *datasrcinfo = new packetchain_comp_datasource();
     datasrcinfo->ref_source = this;
 
     packet->insert(pack_comp_datasrc, datasrcinfo);
 
     inc_source_num_packets(1);
-    get_source_packet_rrd()->add_sample(1, time(0));
+    get_source_packet_rrd()->add_sample(1, Timetracker::GetCachedTime());
 
     // Inject the packet into the packetchain if we have one
     packetchain->ProcessPacket(packet);
@@ -1096,7 +1150,7 @@ void KisDatasource::handle_packet_warning_report(uint32_t in_seqno, std::string
 kis_layer1_packinfo *KisDatasource::handle_sub_signal(KismetDatasource::SubSignal in_sig) {
     // Extract l1 info from a KV pair so we can add it to a packet
     
-    kis_layer1_packinfo *siginfo = new kis_layer1_packinfo();
+    kis_layer1_packinfo *siginfo = siginfo_component_pool.acquire();
 
     if (in_sig.has_signal_dbm()) {
         siginfo->signal_type = kis_l1_signal_type_dbm;
@@ -1153,13 +1207,35 @@ kis_packet *KisDatasource::handle_sub_packet(KismetDatasource::SubPacket in_pack
     // Extract a packet record
     
     kis_packet *packet = packetchain->GeneratePacket();
-    kis_datachunk *datachunk = new kis_datachunk();
+    kis_datachunk *datachunk = datachunk_component_pool.acquire();
 
     packet->ts.tv_sec = in_packet.time_sec();
     packet->ts.tv_usec = in_packet.time_usec();
 
+    // Track how far the capture timestamps sit from our own clock; when
+    // multiple sources see the same traffic this lets analysis correlate
+    // them without us silently rewriting the capture stamps.  The estimate
+    // necessarily includes delivery latency, so it bounds the skew rather
+    // than measuring it exactly.
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    int64_t off = (int64_t) (now.tv_sec - packet->ts.tv_sec) * 1000000L +
+        (now.tv_usec - packet->ts.tv_usec);
+
+    if (!clock_offset_valid) {
+        clock_offset_est_us = off;
+        clock_offset_valid = true;
+    } else {
+        int64_t est = clock_offset_est_us;
+        clock_offset_est_us = est + ((off - est) / 16);
+    }
+
     datachunk->dlt = in_packet.dlt();
-    datachunk->copy_data((const uint8_t *) in_packet.data().data(), in_packet.data().length());
+
+    // Steal the decoded payload instead of copying it; the report object is
+    // ours and dies as soon as we return
+    datachunk->set_data(*(in_packet.mutable_data()));
 
     packet->insert(pack_comp_linkframe, datachunk);
 
@@ -1353,6 +1429,21 @@ unsigned int KisDatasource::send_list_interfaces(unsigned int in_transaction, li
 }
 
 
+void KisDatasource::pre_serialize() {
+    tracker_component::pre_serialize();
+
+    // Refresh the tracked record from the lock-free counters; the capture
+    // read path only ever touches the atomics, so serving the source list
+    // never contends with packet ingest
+    set_source_num_packets(stat_packets.v);
+    set_source_num_error_packets(stat_error_packets.v);
+    set_source_ring_overflows(io_ring_overflows);
+    set_source_ipc_stalls(io_stall_count);
+
+    if (clock_offset_valid)
+        set_source_clock_offset_us(clock_offset_est_us);
+}
+
 void KisDatasource::register_fields() {
     tracker_component::register_fields();
 
@@ -1430,10 +1521,27 @@ void KisDatasource::register_fields() {
 
     RegisterField("kismet.datasource.num_packets", TrackerUInt64,
             "Number of packets seen by source", &source_num_packets);
+
+    RegisterField("kismet.datasource.open_time_us", TrackerUInt64,
+            "Time taken by the last open of this source, in microseconds",
+            &source_open_time_us);
     RegisterField("kismet.datasource.num_error_packets", TrackerUInt64,
             "Number of invalid/error packets seen by source",
             &source_num_error_packets);
 
+    RegisterField("kismet.datasource.ring_overflows", TrackerUInt64,
+            "Frames or blocks too large for the IO buffers of this source",
+            &source_ring_overflows);
+    RegisterField("kismet.datasource.ipc_stalls", TrackerUInt64,
+            "Times the channel to the capture tool could not make progress "
+            "because a buffer was full",
+            &source_ipc_stalls);
+
+    RegisterField("kismet.datasource.clock_offset_us", TrackerInt64,
+            "Estimated offset of capture timestamps from the server clock "
+            "in microseconds (EWMA, includes delivery latency)",
+            &source_clock_offset_us);
+
     packet_rate_rrd_id = RegisterComplexField("kismet.datasource.packets_rrd", 
             std::shared_ptr<kis_tracked_minute_rrd<> >(new kis_tracked_minute_rrd<>(globalreg, 0)), 
             "packet rate over past minute");
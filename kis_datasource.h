@@ -21,6 +21,7 @@
 
 #include "config.h"
 
+#include <atomic>
 #include <functional>
 
 #include "globalregistry.h"
@@ -197,17 +198,34 @@ public:
 
     __ProxyGet(source_running, uint8_t, bool, source_running);
 
+    // How long the last open of this source took, in microseconds, so a
+    // slow radio in a multi-source config can be spotted
+    __ProxyGet(source_open_time_us, uint64_t, uint64_t, source_open_time_us);
+
     __ProxyGet(source_remote, uint8_t, bool, source_remote);
     __ProxyGet(source_passive, uint8_t, bool, source_passive);
 
     __Proxy(source_num_packets, uint64_t, uint64_t, uint64_t, source_num_packets);
-    __ProxyIncDec(source_num_packets, uint64_t, uint64_t, source_num_packets);
-
-    __Proxy(source_num_error_packets, uint64_t, uint64_t, uint64_t, 
-            source_num_error_packets);
-    __ProxyIncDec(source_num_error_packets, uint64_t, uint64_t, 
+    __Proxy(source_num_error_packets, uint64_t, uint64_t, uint64_t,
             source_num_error_packets);
 
+    __Proxy(source_ring_overflows, uint64_t, uint64_t, uint64_t, source_ring_overflows);
+    __Proxy(source_ipc_stalls, uint64_t, uint64_t, uint64_t, source_ipc_stalls);
+
+    // Estimated offset between this source's capture timestamps and the
+    // server clock, in microseconds
+    __Proxy(source_clock_offset_us, int64_t, int64_t, int64_t, source_clock_offset_us);
+
+    // Packet totals are bumped on the capture read path for every frame,
+    // so they live in padded atomics rather than behind the tracked
+    // elements; the tracked fields are refreshed in pre_serialize when
+    // the source record is served
+    void inc_source_num_packets(uint64_t i) { stat_packets.v += i; }
+    void inc_source_num_error_packets(uint64_t i) { stat_error_packets.v += i; }
+
+    // Sync the lock-free counters into the tracked record
+    virtual void pre_serialize();
+
     __ProxyDynamicTrackable(source_packet_rrd, kis_tracked_minute_rrd<>, 
             packet_rate_rrd, packet_rate_rrd_id);
 
@@ -327,12 +345,17 @@ protected:
 
     virtual void handle_packet_configure_report(uint32_t in_seqno, std::string in_packet);
     virtual void handle_packet_data_report(uint32_t in_seqno, std::string in_packet);
+    virtual void handle_packet_data_batch(uint32_t in_seqno, std::string in_packet);
     virtual void handle_packet_error_report(uint32_t in_seqno, std::string in_packet);
     virtual void handle_packet_interfaces_report(uint32_t in_seqno, std::string in_packet);
     virtual void handle_packet_opensource_report(uint32_t in_seqno, std::string in_packet);
     virtual void handle_packet_probesource_report(uint32_t in_seqno, std::string in_packet);
     virtual void handle_packet_warning_report(uint32_t in_seqno, std::string in_packet);
 
+    // Process a single data report; shared by the single-report and batched
+    // data paths
+    virtual void handle_data_report(const KismetDatasource::DataReport& in_report);
+
     virtual unsigned int send_configure_channel(std::string in_channel, unsigned int in_transaction,
             configure_callback_t in_cb);
     virtual unsigned int send_configure_channel_hop(double in_rate, SharedTrackerElement in_chans,
@@ -379,6 +402,8 @@ protected:
 
     __ProxySet(int_source_warning, std::string, std::string, source_warning);
 
+    __ProxySet(int_source_open_time_us, uint64_t, uint64_t, source_open_time_us);
+
     __ProxySet(int_source_hopping, uint8_t, bool, source_hopping);
     __ProxySet(int_source_channel, std::string, std::string, source_channel);
     __ProxySet(int_source_hop_rate, double, double, source_hop_rate);
@@ -440,6 +465,34 @@ protected:
     SharedTrackerElement source_num_packets;
     SharedTrackerElement source_num_error_packets;
 
+    SharedTrackerElement source_ring_overflows;
+    SharedTrackerElement source_ipc_stalls;
+
+    // Hot-path packet totals; one cache line apiece so the capture read
+    // path incrementing them never false-shares with a REST thread
+    // sampling the neighbor
+    struct alignas(64) padded_stat {
+        std::atomic<uint64_t> v;
+    };
+
+    padded_stat stat_packets;
+    padded_stat stat_error_packets;
+
+    SharedTrackerElement source_clock_offset_us;
+
+    // Running EWMA of (server arrival - capture timestamp) per packet,
+    // updated on the capture read path and synced into the tracked record
+    // in pre_serialize.  It includes delivery latency, so it bounds rather
+    // than measures pure clock skew, but a source whose estimate drifts
+    // relative to its peers has a skewed capture clock
+    std::atomic<int64_t> clock_offset_est_us;
+    std::atomic<bool> clock_offset_valid;
+
+    SharedTrackerElement source_open_time_us;
+
+    // When the in-progress open was launched
+    struct timeval open_start_tv;
+
     int packet_rate_rrd_id;
     std::shared_ptr<kis_tracked_minute_rrd<> > packet_rate_rrd;
 
@@ -19,6 +19,7 @@
 #include "config.h"
 
 #include "globalregistry.h"
+#include "configfile.h"
 #include "util.h"
 #include "endian_magic.h"
 #include "messagebus.h"
@@ -57,6 +58,20 @@ Kis_Dissector_IPdata::Kis_Dissector_IPdata(GlobalRegistry *in_globalreg) {
                 "MAC of the packet.  A client which fails to do so may "
                 "be attempting to exhaust the DHCP pool with spoofed requests.");
 
+    consumer_count = 0;
+
+    // Force the dissector on regardless of registered consumers, for
+    // external tooling which expects the dissected records
+    if (globalreg->kismet_config->FetchOptBoolean("ipdata_dissection", 0))
+        RegisterConsumer();
+}
+
+void Kis_Dissector_IPdata::RegisterConsumer() {
+    consumer_count++;
+}
+
+void Kis_Dissector_IPdata::RemoveConsumer() {
+    consumer_count--;
 }
 
 Kis_Dissector_IPdata::~Kis_Dissector_IPdata() {
@@ -171,6 +186,14 @@ int Kis_Dissector_IPdata::HandlePacket(kis_packet *in_pack) {
 	if (in_pack->error)
 		return 0;
 
+	// Demand gate - the dissected record is only read by registered
+	// consumers and the DHCPCLIENTID alert; if nobody is listening, skip
+	// the protocol parse entirely.  On encrypted networks nearly every
+	// data frame otherwise pays this cost for nothing.
+	if (consumer_count.load(std::memory_order_relaxed) == 0 &&
+			!globalreg->alertracker->PotentialAlert(alert_dhcpclient_ref))
+		return 0;
+
 	kis_datachunk *chunk =
 		(kis_datachunk *) in_pack->fetch(pack_comp_datapayload);
 
@@ -21,6 +21,8 @@
 
 #include "config.h"
 
+#include <atomic>
+
 #include "globalregistry.h"
 #include "packet.h"
 #include "packetchain.h"
@@ -36,6 +38,15 @@ public:
 
 	virtual int HandlePacket(kis_packet *in_pack);
 
+    // Demand-side interest registration.  Dissecting ARP/DHCP/UDP/TCP out
+    // of every data frame is wasted work when nothing reads the result;
+    // the dissector only runs while at least one consumer is registered or
+    // the DHCPCLIENTID alert is live.  Plugins and logging components
+    // which read the BASICDATA record should hold a registration for
+    // their lifetime.
+    void RegisterConsumer();
+    void RemoveConsumer();
+
 	~Kis_Dissector_IPdata();
 
 protected:
@@ -43,6 +54,8 @@ protected:
 
 	int pack_comp_datapayload, pack_comp_basicdata, pack_comp_common;
 	int alert_dhcpclient_ref;
+
+    std::atomic<int> consumer_count;
 };
 
 #endif
@@ -314,7 +314,7 @@ int Kis_DLT_PPI::HandlePacket(kis_packet *in_pack) {
 	if (capsrc != NULL && capsrc->ref_source->FetchValidateCRC() && fcschunk != NULL) {
 		// Compare it and flag the packet
 		uint32_t calc_crc =
-			crc32_le_80211(globalreg->crc32_table, decapchunk->data, 
+			crc32_le_80211x4(globalreg->crc32_table, decapchunk->data,
 						   decapchunk->length);
 
 		if (memcmp(fcschunk->checksum_ptr, &calc_crc, 4)) {
@@ -52,8 +52,6 @@
 
 #include "kis_datasource.h"
 
-#include "tcpdump-extract.h"
-
 // Extension to radiotap header not yet included in all BSD's
 #ifndef IEEE80211_RADIOTAP_F_FCS
 #define IEEE80211_RADIOTAP_F_FCS        0x10    /* frame includes FCS */
@@ -74,8 +72,6 @@ Kis_DLT_Radiotap::Kis_DLT_Radiotap(GlobalRegistry *in_globalreg) :
 	globalreg->InsertGlobal("DLT_RADIOTAP", std::shared_ptr<Kis_DLT_Radiotap>(this));
 
 	_MSG("Registering support for DLT_RADIOTAP packet header decoding", MSGFLAG_INFO);
-
-    crc32_init_table_80211(crc32_table);
 }
 
 Kis_DLT_Radiotap::~Kis_DLT_Radiotap() {
@@ -124,6 +120,90 @@ Kis_DLT_Radiotap::~Kis_DLT_Radiotap() {
 #define BITNO_4(x) (((x) >> 2) ? 2 + BITNO_2((x) >> 2) : BITNO_2((x)))
 #define BITNO_2(x) (((x) & 2) ? 1 : 0)
 #define BIT(n)	(1 << n)
+
+// Walk a present bitmap chain once and record the absolute offset of every
+// field we know the size of; per-packet extraction then becomes a few direct
+// loads at the planned offsets.  Mirrors the old inline walk: an unknown
+// field ends the walk of its bitmap word, since field sizes past it can't
+// be known.
+void Kis_DLT_Radiotap::build_radiotap_plan(const std::vector<uint32_t>& present_words,
+        radiotap_plan *plan) {
+    u_int32_t present, next_present;
+    int bit, bit0;
+    unsigned int f_size, f_align;
+
+    // Data starts after the fixed header and the present word chain
+    unsigned int offset =
+        sizeof(struct ieee80211_radiotap_header) +
+        ((unsigned int) present_words.size() - 1) * sizeof(u_int32_t);
+
+    plan->fields.clear();
+    plan->min_len = offset;
+
+    bit0 = 0;
+    for (auto w : present_words) {
+        for (present = w; present; present = next_present) {
+            /* clear the least significant bit that is set */
+            next_present = present & (present - 1);
+
+            /* extract the least significant bit that is set */
+            bit = bit0 + BITNO_32(present ^ next_present);
+
+            switch (bit) {
+                case IEEE80211_RADIOTAP_FLAGS:
+                case IEEE80211_RADIOTAP_RATE:
+                case IEEE80211_RADIOTAP_DBM_ANTSIGNAL:
+                case IEEE80211_RADIOTAP_DBM_ANTNOISE:
+                case IEEE80211_RADIOTAP_ANTENNA:
+                case IEEE80211_RADIOTAP_DBM_TX_POWER:
+                    f_size = 1;
+                    f_align = 1;
+                    break;
+                case IEEE80211_RADIOTAP_CHANNEL:
+                    f_size = 4;
+                    f_align = 2;
+                    break;
+                case IEEE80211_RADIOTAP_FHSS:
+                case IEEE80211_RADIOTAP_LOCK_QUALITY:
+                case IEEE80211_RADIOTAP_TX_ATTENUATION:
+                case IEEE80211_RADIOTAP_DB_TX_ATTENUATION:
+                    f_size = 2;
+                    f_align = 2;
+                    break;
+                case IEEE80211_RADIOTAP_TSFT:
+                    f_size = 8;
+                    f_align = 8;
+                    break;
+#if defined(SYS_OPENBSD)
+                case IEEE80211_RADIOTAP_RSSI:
+                    f_size = 2;
+                    f_align = 1;
+                    break;
+#endif
+                default:
+                    /* this bit indicates a field whose size we do not
+                     * know, so we cannot plan past it */
+                    next_present = 0;
+                    continue;
+            }
+
+            offset += ALIGN_OFFSET(offset, f_align);
+
+            radiotap_plan_field pf;
+            pf.bit = bit;
+            pf.offset = offset;
+            plan->fields.push_back(pf);
+
+            offset += f_size;
+
+            if (offset > plan->min_len)
+                plan->min_len = offset;
+        }
+
+        bit0 += 32;
+    }
+}
+
 int Kis_DLT_Radiotap::HandlePacket(kis_packet *in_pack) {
     static int packnum = 0;
 
@@ -178,13 +258,9 @@ int Kis_DLT_Radiotap::HandlePacket(kis_packet *in_pack) {
 	u2.u64 = 0;
 
 	struct ieee80211_radiotap_header *hdr;
-	u_int32_t present, next_present;
 	u_int32_t *presentp, *last_presentp;
-	enum ieee80211_radiotap_type bit;
-	int bit0;
 	const u_char *iter;
 	const u_char *iter_start;
-	unsigned int iter_align;
 	int fcs_cut = 0; // Is the FCS bit set?
     bool fcs_flag_invalid = false; // Do we have a flag that tells us the fcs is known bad?
 
@@ -198,7 +274,7 @@ int Kis_DLT_Radiotap::HandlePacket(kis_packet *in_pack) {
 
 	// Assign it to the callback data
     hdr = (struct ieee80211_radiotap_header *) linkchunk->data;
-    if (linkchunk->length < EXTRACT_LE_16BITS(&hdr->it_len)) {
+    if (linkchunk->length < kis_extractLE16(&hdr->it_len)) {
 		// snprintf(errstr, STATUS_MAX, "pcap radiotap converter got corrupted " "Radiotap header length");
 		// globalreg->messagebus->InjectMessage(errstr, MSGFLAG_ERROR);
         return 0;
@@ -206,12 +282,12 @@ int Kis_DLT_Radiotap::HandlePacket(kis_packet *in_pack) {
 
 	// null-statement for-loop
     for (last_presentp = &hdr->it_present;
-         (EXTRACT_LE_32BITS(last_presentp) & BIT(IEEE80211_RADIOTAP_EXT)) != 0 &&
+         (kis_extractLE32(last_presentp) & BIT(IEEE80211_RADIOTAP_EXT)) != 0 &&
          (u_char *) (last_presentp + 1) <= linkchunk->data + 
-		 EXTRACT_LE_16BITS(&(hdr->it_len)); last_presentp++);
+		 kis_extractLE16(&(hdr->it_len)); last_presentp++);
 
     /* are there more bitmap extensions than bytes in header? */
-    if ((EXTRACT_LE_32BITS(last_presentp) & BIT(IEEE80211_RADIOTAP_EXT)) != 0) {
+    if ((kis_extractLE32(last_presentp) & BIT(IEEE80211_RADIOTAP_EXT)) != 0) {
 		// snprintf(errstr, STATUS_MAX, "pcap radiotap converter got corrupted " "Radiotap bitmap length");
 		// globalreg->messagebus->InjectMessage(errstr, MSGFLAG_ERROR);
         return 0;
@@ -221,158 +297,139 @@ int Kis_DLT_Radiotap::HandlePacket(kis_packet *in_pack) {
 	radioheader = new kis_layer1_packinfo;
 
 	decapchunk->dlt = KDLT_IEEE802_11;
-	
-    iter = (u_char*)(last_presentp + 1); 
-    // Alignment in Radiotap must be done from the beginning of the header, 
-    // not from the byte following the last bitmap. 
-    iter_start = (u_char*)(linkchunk->data); 
 
-    for (bit0 = 0, presentp = &hdr->it_present; presentp <= last_presentp;
-         presentp++, bit0 += 32) {
-        for (present = EXTRACT_LE_32BITS(presentp); present; present = next_present) {
-            /* clear the least significant bit that is set */
-            next_present = present & (present - 1);
+    // Collect the present bitmap chain and look up (or build) the extraction
+    // plan for it
+    std::vector<uint32_t> present_words;
+    for (presentp = &hdr->it_present; presentp <= last_presentp; presentp++)
+        present_words.push_back(kis_extractLE32(presentp));
 
-            /* extract the least significant bit that is set */
-            bit = (enum ieee80211_radiotap_type)
-                (bit0 + BITNO_32(present ^ next_present));
+    radiotap_plan uncached_plan;
+    radiotap_plan *plan = NULL;
 
-            switch (bit) {
-                case IEEE80211_RADIOTAP_FLAGS:
-                case IEEE80211_RADIOTAP_RATE:
-				/*
-                case IEEE80211_RADIOTAP_DB_ANTSIGNAL:
-                case IEEE80211_RADIOTAP_DB_ANTNOISE:
-				*/
-                case IEEE80211_RADIOTAP_DBM_ANTSIGNAL:
-                case IEEE80211_RADIOTAP_DBM_ANTNOISE:
-                case IEEE80211_RADIOTAP_ANTENNA:
-                    u.u8 = *iter++;
-                    break;
-                case IEEE80211_RADIOTAP_DBM_TX_POWER:
-                    u.i8 = *iter++;
-                    break;
-                case IEEE80211_RADIOTAP_CHANNEL:
-					iter_align = ALIGN_OFFSET((unsigned int) (iter - iter_start), 2);
-					iter += iter_align;
+    if (present_words.size() <= 2) {
+        uint64_t plan_key = present_words[0];
 
-                    u.u16 = EXTRACT_LE_16BITS(iter);
-                    iter += sizeof(u.u16);
-                    u2.u16 = EXTRACT_LE_16BITS(iter);
-                    iter += sizeof(u2.u16);
-                    break;
-                case IEEE80211_RADIOTAP_FHSS:
-                case IEEE80211_RADIOTAP_LOCK_QUALITY:
-                case IEEE80211_RADIOTAP_TX_ATTENUATION:
-                case IEEE80211_RADIOTAP_DB_TX_ATTENUATION:
-					iter_align = ALIGN_OFFSET((unsigned int) (iter - iter_start), 2);
-					iter += iter_align;
+        if (present_words.size() == 2)
+            plan_key |= ((uint64_t) present_words[1]) << 32;
 
-                    u.u16 = EXTRACT_LE_16BITS(iter);
-                    iter += sizeof(u.u16);
-                    break;
-                case IEEE80211_RADIOTAP_TSFT:
-					iter_align = ALIGN_OFFSET((unsigned int) (iter - iter_start), 8);
-					iter += iter_align;
+        // Plan entries are never erased, so a pointer into the cache stays
+        // valid once we drop the lock
+        local_locker lock(&plan_mutex);
 
-                    u.u64 = EXTRACT_LE_64BITS(iter);
-                    iter += sizeof(u.u64);
-                    break;
-#if defined(SYS_OPENBSD)
-                case IEEE80211_RADIOTAP_RSSI:
-                    u.u8 = EXTRACT_LE_8BITS(iter);
-                    iter += sizeof(u.u8);
-                    u2.u8 = EXTRACT_LE_8BITS(iter);
-                    iter += sizeof(u2.u8);
-                    break;
-#endif
-                default:
-                    /* this bit indicates a field whose
-                     * size we do not know, so we cannot
-                     * proceed.
-                     */
-                    next_present = 0;
-                    continue;
-            }
+        auto pci = plan_cache.find(plan_key);
 
-			// static int pnum = 0;
-            switch (bit) {
-                case IEEE80211_RADIOTAP_CHANNEL:
-                    // radioheader->channel = ieee80211_mhz2ieee(u.u16, u2.u16);
-                    radioheader->freq_khz = (double) u.u16 * 1000;
-					// printf("debug - %d freq %u\n", pnum++, radioheader->freq_mhz);
-                    if (IEEE80211_IS_CHAN_FHSS(u2.u16))
-                        radioheader->carrier = carrier_80211fhss;
-                    else if (IEEE80211_IS_CHAN_A(u2.u16))
-                        radioheader->carrier = carrier_80211a;
-                    else if (IEEE80211_IS_CHAN_BPLUS(u2.u16))
-                        radioheader->carrier = carrier_80211bplus;
-                    else if (IEEE80211_IS_CHAN_B(u2.u16))
-                        radioheader->carrier = carrier_80211b;
-                    else if (IEEE80211_IS_CHAN_PUREG(u2.u16))
-                        radioheader->carrier = carrier_80211g;
-                    else if (IEEE80211_IS_CHAN_G(u2.u16))
-                        radioheader->carrier = carrier_80211g;
-                    else if (IEEE80211_IS_CHAN_T(u2.u16))
-                        radioheader->carrier = carrier_80211a;/*XXX*/
-                    else
-                        radioheader->carrier = carrier_unknown;
-                    if ((u2.u16 & IEEE80211_CHAN_CCK) == IEEE80211_CHAN_CCK)
-                        radioheader->encoding = encoding_cck;
-                    else if ((u2.u16 & IEEE80211_CHAN_OFDM) == IEEE80211_CHAN_OFDM)
-                        radioheader->encoding = encoding_ofdm;
-                    else if ((u2.u16 & IEEE80211_CHAN_DYN) == IEEE80211_CHAN_DYN)
-                        radioheader->encoding = encoding_dynamiccck;
-                    else if ((u2.u16 & IEEE80211_CHAN_GFSK) == IEEE80211_CHAN_GFSK)
-                        radioheader->encoding = encoding_gfsk;
-                    else
-                        radioheader->encoding = encoding_unknown;
-                    break;
-                case IEEE80211_RADIOTAP_RATE:
-					/* strip basic rate bit & convert to kismet units */
-                    radioheader->datarate = ((u.u8 &~ 0x80) / 2) * 10;
-                    break;
-				/* ignore DB values, they're not helpful
-                case IEEE80211_RADIOTAP_DB_ANTSIGNAL:
-                    radioheader->signal_dbm = u.i8;
-                    break;
-                case IEEE80211_RADIOTAP_DB_ANTNOISE:
-                    radioheader->noise_dbm = u.i8;
-                    break;
-				*/
-				case IEEE80211_RADIOTAP_DBM_ANTSIGNAL:
-                    radioheader->signal_type = kis_l1_signal_type_dbm;
-					radioheader->signal_dbm = u.i8;
-					break;
-				case IEEE80211_RADIOTAP_DBM_ANTNOISE:
-                    radioheader->signal_type = kis_l1_signal_type_dbm;
-					radioheader->noise_dbm = u.i8;
-					break;
-                case IEEE80211_RADIOTAP_FLAGS:
-                    if (u.u8 & IEEE80211_RADIOTAP_F_FCS) {
-						fcs_cut = 4;
-					}
+        if (pci == plan_cache.end()) {
+            build_radiotap_plan(present_words, &(plan_cache[plan_key]));
+            pci = plan_cache.find(plan_key);
+        }
+
+        plan = &(pci->second);
+    } else {
+        build_radiotap_plan(present_words, &uncached_plan);
+        plan = &uncached_plan;
+    }
 
-                    if (u.u8 & IEEE80211_RADIOTAP_F_BADFCS) {
-                        fcs_flag_invalid = true;
-                    }
+    if (plan->min_len > linkchunk->length) {
+		delete decapchunk;
+		delete radioheader;
+        return 0;
+    }
 
-                    break;
+    // Alignment in Radiotap must be done from the beginning of the header,
+    // not from the byte following the last bitmap; the plan offsets are
+    // absolute for the same reason.
+    iter_start = (u_char*)(linkchunk->data); 
+
+    for (auto& pf : plan->fields) {
+        iter = iter_start + pf.offset;
+
+        switch (pf.bit) {
+            case IEEE80211_RADIOTAP_CHANNEL:
+                u.u16 = kis_extractLE16(iter);
+                u2.u16 = kis_extractLE16(iter + sizeof(u.u16));
+
+                // radioheader->channel = ieee80211_mhz2ieee(u.u16, u2.u16);
+                radioheader->freq_khz = (double) u.u16 * 1000;
+                if (IEEE80211_IS_CHAN_FHSS(u2.u16))
+                    radioheader->carrier = carrier_80211fhss;
+                else if (IEEE80211_IS_CHAN_A(u2.u16))
+                    radioheader->carrier = carrier_80211a;
+                else if (IEEE80211_IS_CHAN_BPLUS(u2.u16))
+                    radioheader->carrier = carrier_80211bplus;
+                else if (IEEE80211_IS_CHAN_B(u2.u16))
+                    radioheader->carrier = carrier_80211b;
+                else if (IEEE80211_IS_CHAN_PUREG(u2.u16))
+                    radioheader->carrier = carrier_80211g;
+                else if (IEEE80211_IS_CHAN_G(u2.u16))
+                    radioheader->carrier = carrier_80211g;
+                else if (IEEE80211_IS_CHAN_T(u2.u16))
+                    radioheader->carrier = carrier_80211a;/*XXX*/
+                else
+                    radioheader->carrier = carrier_unknown;
+                if ((u2.u16 & IEEE80211_CHAN_CCK) == IEEE80211_CHAN_CCK)
+                    radioheader->encoding = encoding_cck;
+                else if ((u2.u16 & IEEE80211_CHAN_OFDM) == IEEE80211_CHAN_OFDM)
+                    radioheader->encoding = encoding_ofdm;
+                else if ((u2.u16 & IEEE80211_CHAN_DYN) == IEEE80211_CHAN_DYN)
+                    radioheader->encoding = encoding_dynamiccck;
+                else if ((u2.u16 & IEEE80211_CHAN_GFSK) == IEEE80211_CHAN_GFSK)
+                    radioheader->encoding = encoding_gfsk;
+                else
+                    radioheader->encoding = encoding_unknown;
+                break;
+            case IEEE80211_RADIOTAP_RATE:
+                /* strip basic rate bit & convert to kismet units */
+                u.u8 = *iter;
+                radioheader->datarate = ((u.u8 &~ 0x80) / 2) * 10;
+                break;
+            /* ignore DB values, they're not helpful
+            case IEEE80211_RADIOTAP_DB_ANTSIGNAL:
+                radioheader->signal_dbm = u.i8;
+                break;
+            case IEEE80211_RADIOTAP_DB_ANTNOISE:
+                radioheader->noise_dbm = u.i8;
+                break;
+            */
+            case IEEE80211_RADIOTAP_DBM_ANTSIGNAL:
+                u.u8 = *iter;
+                radioheader->signal_type = kis_l1_signal_type_dbm;
+                radioheader->signal_dbm = u.i8;
+                break;
+            case IEEE80211_RADIOTAP_DBM_ANTNOISE:
+                u.u8 = *iter;
+                radioheader->signal_type = kis_l1_signal_type_dbm;
+                radioheader->noise_dbm = u.i8;
+                break;
+            case IEEE80211_RADIOTAP_FLAGS:
+                u.u8 = *iter;
+
+                if (u.u8 & IEEE80211_RADIOTAP_F_FCS) {
+                    fcs_cut = 4;
+                }
+
+                if (u.u8 & IEEE80211_RADIOTAP_F_BADFCS) {
+                    fcs_flag_invalid = true;
+                }
+
+                break;
 #if defined(SYS_OPENBSD)
-                case IEEE80211_RADIOTAP_RSSI:
-                    /* Convert to Kismet units...  No reason to use RSSI units
-					 * here since we know the conversion factor */
-                    radioheader->signal_type = kis_l1_signal_type_dbm;
-                    radioheader->signal_dbm = int((float(u.u8) / float(u2.u8) * 255));
-                    break;
+            case IEEE80211_RADIOTAP_RSSI:
+                u.u8 = kis_extractLE8(iter);
+                u2.u8 = kis_extractLE8(iter + sizeof(u.u8));
+
+                /* Convert to Kismet units...  No reason to use RSSI units
+                 * here since we know the conversion factor */
+                radioheader->signal_type = kis_l1_signal_type_dbm;
+                radioheader->signal_dbm = int((float(u.u8) / float(u2.u8) * 255));
+                break;
 #endif
-                default:
-                    break;
-            }
+            default:
+                break;
         }
     }
 
-	if (EXTRACT_LE_16BITS(&(hdr->it_len)) + fcs_cut > (int) linkchunk->length) {
+	if (kis_extractLE16(&(hdr->it_len)) + fcs_cut > (int) linkchunk->length) {
 		/*
 		_MSG("Pcap Radiotap converter got corrupted Radiotap frame, not "
 			 "long enough for radiotap header plus indicated FCS", MSGFLAG_ERROR);
@@ -382,8 +439,8 @@ int Kis_DLT_Radiotap::HandlePacket(kis_packet *in_pack) {
         return 0;
 	}
 
-    decapchunk->set_data(linkchunk->data + EXTRACT_LE_16BITS(&(hdr->it_len)),
-            (linkchunk->length - EXTRACT_LE_16BITS(&(hdr->it_len)) - 
+    decapchunk->set_data(linkchunk->data + kis_extractLE16(&(hdr->it_len)),
+            (linkchunk->length - kis_extractLE16(&(hdr->it_len)) - 
              fcs_cut), false);
 
 	in_pack->insert(pack_comp_radiodata, radioheader);
@@ -428,7 +485,7 @@ int Kis_DLT_Radiotap::HandlePacket(kis_packet *in_pack) {
 
 		// Compare it and flag the packet
 		uint32_t calc_crc =
-			crc32_le_80211(globalreg->crc32_table, decapchunk->data, 
+			crc32_le_80211x4(globalreg->crc32_table, decapchunk->data,
 						   decapchunk->length);
         uint32_t flipped_crc = kis_swap32(calc_crc);
 
@@ -459,47 +516,3 @@ int Kis_DLT_Radiotap::HandlePacket(kis_packet *in_pack) {
 #undef BITNO_2
 #undef BIT
 
-// Taken from the BBN USRP 802.11 encoding code
-unsigned int Kis_DLT_Radiotap::update_crc32_80211(unsigned int crc, const unsigned char *data,
-        int len, unsigned int poly) {
-	int i, j;
-	unsigned short ch;
-
-	for ( i = 0; i < len; ++i) {
-		ch = data[i];
-		for (j = 0; j < 8; ++j) {
-			if ((crc ^ ch) & 0x0001) {
-				crc = (crc >> 1) ^ poly;
-			} else {
-				crc = (crc >> 1);
-			}
-			ch >>= 1;
-		}
-	}
-	return crc;
-}
-
-void Kis_DLT_Radiotap::crc32_init_table_80211(unsigned int *crc32_table) {
-	int i;
-	unsigned char c;
-
-	for (i = 0; i < 256; ++i) {
-		c = (unsigned char) i;
-		crc32_table[i] = update_crc32_80211(0, &c, 1, IEEE_802_3_CRC32_POLY);
-	}
-}
-
-unsigned int Kis_DLT_Radiotap::crc32_le_80211(unsigned int *crc32_table, 
-        const unsigned char *buf, int len) {
-	int i;
-	unsigned int crc = 0xFFFFFFFF;
-
-	for (i = 0; i < len; ++i) {
-		crc = (crc >> 8) ^ crc32_table[(crc ^ buf[i]) & 0xFF];
-	}
-
-	crc ^= 0xFFFFFFFF;
-
-	return crc;
-}
-
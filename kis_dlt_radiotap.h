@@ -42,12 +42,29 @@ public:
 	~Kis_DLT_Radiotap();
 
 protected:
-    unsigned int update_crc32_80211(unsigned int crc, const unsigned char *data,
-            int len, unsigned int poly);
-    void crc32_init_table_80211(unsigned int *crc32_table);
-    unsigned int crc32_le_80211(unsigned int *crc32_table, const unsigned char *buf, int len);
+    // Precomputed extraction plan for a radiotap present bitmap; the field
+    // offsets and alignment depend only on the bitmap, and a given driver
+    // emits only a handful of distinct bitmaps, so the per-field alignment
+    // walk is done once per bitmap instead of once per packet
+    struct radiotap_plan_field {
+        int bit;
+        unsigned int offset;
+    };
 
-    unsigned int crc32_table[256];
+    struct radiotap_plan {
+        // Minimum link frame length needed to extract every planned field
+        unsigned int min_len;
+        std::vector<radiotap_plan_field> fields;
+    };
+
+    void build_radiotap_plan(const std::vector<uint32_t>& present_words,
+            radiotap_plan *plan);
+
+    // Plans for one- and two-word present bitmaps, keyed by the packed
+    // bitmap words; longer extension chains are rare enough to re-plan
+    // per packet
+    kis_recursive_timed_mutex plan_mutex;
+    std::map<uint64_t, radiotap_plan> plan_cache;
 };
 
 #endif
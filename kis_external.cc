@@ -18,6 +18,8 @@
 
 #include <memory>
 
+#include <zlib.h>
+
 #include "configfile.h"
 
 #include "kis_external.h"
@@ -37,10 +39,14 @@ KisExternalInterface::KisExternalInterface(GlobalRegistry *in_globalreg) :
 
     seqno = 0;
 
+    io_ring_overflows = 0;
+    io_stall_count = 0;
+
     last_pong = 0;
 
     ping_timer_id = -1;
 
+    shm_ring = NULL;
 }
 
 KisExternalInterface::~KisExternalInterface() {
@@ -58,6 +64,11 @@ KisExternalInterface::~KisExternalInterface() {
 
     // Remove the IPC remote reference
     ipc_remote.reset();
+
+    if (shm_ring != NULL) {
+        kis_shm_ring_free(shm_ring);
+        shm_ring = NULL;
+    }
 }
 
 void KisExternalInterface::connect_buffer(std::shared_ptr<BufferHandlerGeneric> in_ringbuf) {
@@ -87,6 +98,11 @@ void KisExternalInterface::trigger_error(std::string in_error) {
     // Remove the IPC remote reference
     ipc_remote.reset();
 
+    if (shm_ring != NULL) {
+        kis_shm_ring_free(shm_ring);
+        shm_ring = NULL;
+    }
+
     BufferError(in_error);
 }
 
@@ -138,6 +154,8 @@ void KisExternalInterface::BufferAvailable(size_t in_amt __attribute__((unused))
 
         // If we'll never be able to read it, blow up
         if ((long int) frame_sz >= ringbuf_handler->GetReadBufferAvailable()) {
+            io_ring_overflows++;
+
             ringbuf_handler->PeekFreeReadBufferData(buf);
 
             std::stringstream ss;
@@ -173,8 +191,15 @@ void KisExternalInterface::BufferAvailable(size_t in_amt __attribute__((unused))
             return;
         }
 
-        // Process the data payload as a protobuf frame
-        std::shared_ptr<KismetExternal::Command> cmd(new KismetExternal::Command());
+        // Process the data payload as a protobuf frame; the command message
+        // is recycled between frames so repeated parses re-use the string
+        // storage it has already grown instead of hammering malloc
+        if (rx_cmd == NULL)
+            rx_cmd.reset(new KismetExternal::Command());
+        else
+            rx_cmd->Clear();
+
+        std::shared_ptr<KismetExternal::Command> cmd = rx_cmd;
 
         if (!cmd->ParseFromArray(frame->data, data_sz)) {
             ringbuf_handler->PeekFreeReadBufferData(buf);
@@ -258,11 +283,16 @@ void KisExternalInterface::close_external() {
         ringbuf_handler.reset();
     }
 
-    if (ipc_remote != NULL) 
+    if (ipc_remote != NULL)
         ipc_remote->soft_kill();
 
     // Remove the IPC remote reference
     ipc_remote.reset();
+
+    if (shm_ring != NULL) {
+        kis_shm_ring_free(shm_ring);
+        shm_ring = NULL;
+    }
 }
 
 unsigned int KisExternalInterface::send_packet(std::shared_ptr<KismetExternal::Command> c) {
@@ -292,6 +322,8 @@ unsigned int KisExternalInterface::send_packet(std::shared_ptr<KismetExternal::C
 
     // Reserve the frame in the buffer
     if (ringbuf_handler->ReserveWriteBufferData((void **) &frame, frame_sz) < frame_sz) {
+        io_stall_count++;
+
         ringbuf_handler->CommitWriteBufferData(NULL, 0);
         _MSG("Kismet external interface couldn't find space in the output buffer for "
                 "the next command, something may have stalled.", MSGFLAG_ERROR);
@@ -331,6 +363,18 @@ bool KisExternalInterface::dispatch_rx_packet(std::shared_ptr<KismetExternal::Co
     } else if (c->command() == "SHUTDOWN") {
         handle_packet_shutdown(c->seqno(), c->content());
         return true;
+    } else if (c->command() == "SHMRINGOFFER") {
+        handle_packet_shm_offer(c->seqno(), c->content());
+        return true;
+    } else if (c->command() == "SHMRINGDATA") {
+        handle_packet_shm_data(c->seqno(), c->content());
+        return true;
+    } else if (c->command() == "COMPOFFER") {
+        handle_packet_comp_offer(c->seqno(), c->content());
+        return true;
+    } else if (c->command() == "COMPBLOCK") {
+        handle_packet_comp_block(c->seqno(), c->content());
+        return true;
     }
 
     return false;
@@ -375,10 +419,183 @@ void KisExternalInterface::handle_packet_shutdown(uint32_t in_seqno, std::string
         return;
     }
 
-    _MSG(std::string("Kismet external interface shutting down: ") + s.reason(), MSGFLAG_INFO); 
+    _MSG(std::string("Kismet external interface shutting down: ") + s.reason(), MSGFLAG_INFO);
     trigger_error(std::string("Remote connection requesting shutdown: ") + s.reason());
 }
 
+void KisExternalInterface::handle_packet_shm_offer(uint32_t in_seqno, std::string in_content) {
+    local_locker lock(&ext_mutex);
+
+    KismetExternal::ShmRingOffer offer;
+
+    if (!offer.ParseFromString(in_content)) {
+        _MSG("Kismet external interface got an unparseable SHMRINGOFFER", MSGFLAG_ERROR);
+        trigger_error("Invalid SHMRINGOFFER");
+        return;
+    }
+
+    // Only accept shared memory from helpers we launched ourselves; a remote
+    // connection has no business telling us to map local files
+    if (ipc_remote != NULL && shm_ring == NULL) {
+        shm_ring = kis_shm_ring_attach(offer.path().c_str());
+
+        if (shm_ring != NULL) {
+            // Both sides have it mapped now, remove the backing file; the
+            // helper may be jailed away from the filesystem by the time
+            // negotiation completes so cleanup falls to us
+            kis_shm_ring_unlink(shm_ring);
+        }
+    }
+
+    std::shared_ptr<KismetExternal::Command> c(new KismetExternal::Command());
+
+    c->set_command("SHMRINGRESULT");
+
+    KismetExternal::ShmRingResult r;
+    r.set_accepted(shm_ring != NULL);
+
+    c->set_content(r.SerializeAsString());
+
+    send_packet(c);
+}
+
+void KisExternalInterface::handle_packet_shm_data(uint32_t in_seqno, std::string in_content) {
+    local_locker lock(&ext_mutex);
+
+    unsigned char *buf;
+    ssize_t reserved;
+    size_t read_sz;
+
+    if (shm_ring == NULL || ringbuf_handler == NULL)
+        return;
+
+    // Drain the ring into our read buffer; the frames in the ring are the
+    // same wire format as the pipe so committing them triggers the normal
+    // frame parser in BufferAvailable
+    while (1) {
+        size_t used = kis_shm_ring_used(shm_ring);
+
+        if (used == 0)
+            break;
+
+        if (ringbuf_handler->GetReadBufferAvailable() <= 0) {
+            // Data is waiting in the shm ring but the parser hasn't caught
+            // up; it'll be drained on the next doorbell
+            io_stall_count++;
+            break;
+        }
+
+        if (used > (size_t) ringbuf_handler->GetReadBufferAvailable())
+            used = ringbuf_handler->GetReadBufferAvailable();
+
+        reserved = ringbuf_handler->ZeroCopyReserveReadBufferData((void **) &buf, used);
+
+        if (reserved <= 0) {
+            ringbuf_handler->CommitReadBufferData(buf, 0);
+            break;
+        }
+
+        read_sz = kis_shm_ring_read(shm_ring, buf, reserved);
+
+        ringbuf_handler->CommitReadBufferData(buf, read_sz);
+    }
+}
+
+void KisExternalInterface::handle_packet_comp_offer(uint32_t in_seqno, std::string in_content) {
+    local_locker lock(&ext_mutex);
+
+    KismetExternal::CompressionOffer offer;
+
+    if (!offer.ParseFromString(in_content)) {
+        _MSG("Kismet external interface got an unparseable COMPOFFER", MSGFLAG_ERROR);
+        trigger_error("Invalid COMPOFFER");
+        return;
+    }
+
+    // zlib is the only method we speak; we don't need any per-connection
+    // state to accept it since each block is a self-contained stream
+    bool accepted = (offer.method() == "zlib");
+
+    std::shared_ptr<KismetExternal::Command> c(new KismetExternal::Command());
+
+    c->set_command("COMPRESULT");
+
+    KismetExternal::CompressionResult r;
+    r.set_accepted(accepted);
+
+    if (accepted)
+        r.set_method("zlib");
+
+    c->set_content(r.SerializeAsString());
+
+    send_packet(c);
+}
+
+void KisExternalInterface::handle_packet_comp_block(uint32_t in_seqno, std::string in_content) {
+    local_locker lock(&ext_mutex);
+
+    unsigned char *buf;
+    ssize_t reserved;
+    z_stream zs;
+    int zret;
+
+    if (ringbuf_handler == NULL)
+        return;
+
+    memset(&zs, 0, sizeof(zs));
+
+    if (inflateInit(&zs) != Z_OK) {
+        trigger_error("could not initialize decompression");
+        return;
+    }
+
+    zs.next_in = (Bytef *) in_content.data();
+    zs.avail_in = in_content.size();
+
+    // Inflate the block into our read buffer in chunks; the decompressed
+    // bytes are normal wire-format frames so committing them triggers the
+    // standard frame parser, which also consumes data and keeps the buffer
+    // from pinning full on large blocks
+    while (1) {
+        if (ringbuf_handler->GetReadBufferAvailable() <= 0) {
+            io_ring_overflows++;
+            trigger_error("decompressed block too large for buffer");
+            break;
+        }
+
+        reserved = ringbuf_handler->ZeroCopyReserveReadBufferData((void **) &buf,
+                ringbuf_handler->GetReadBufferAvailable());
+
+        if (reserved <= 0) {
+            io_ring_overflows++;
+            ringbuf_handler->CommitReadBufferData(buf, 0);
+            trigger_error("decompressed block too large for buffer");
+            break;
+        }
+
+        zs.next_out = (Bytef *) buf;
+        zs.avail_out = reserved;
+
+        zret = inflate(&zs, Z_NO_FLUSH);
+
+        if (zret != Z_OK && zret != Z_STREAM_END) {
+            ringbuf_handler->CommitReadBufferData(buf, 0);
+
+            _MSG("Kismet external interface got a corrupt compressed data block",
+                    MSGFLAG_ERROR);
+            trigger_error("corrupt compressed data block");
+            break;
+        }
+
+        ringbuf_handler->CommitReadBufferData(buf, reserved - zs.avail_out);
+
+        if (zret == Z_STREAM_END)
+            break;
+    }
+
+    inflateEnd(&zs);
+}
+
 unsigned int KisExternalInterface::send_ping() {
     std::shared_ptr<KismetExternal::Command> c(new KismetExternal::Command());
 
@@ -32,12 +32,14 @@
 
 #include "config.h"
 
+#include <atomic>
 #include <functional>
 
 #include "globalregistry.h"
 #include "buffer_handler.h"
 #include "ipc_remote2.h"
 #include "kis_net_microhttpd.h"
+#include "simple_shm_ring.h"
 
 // Namespace stub and forward class definition to make deps hopefully
 // easier going forward
@@ -97,6 +99,10 @@ protected:
     virtual void handle_packet_ping(uint32_t in_seqno, std::string in_content);
     virtual void handle_packet_pong(uint32_t in_seqno, std::string in_content);
     virtual void handle_packet_shutdown(uint32_t in_seqno, std::string in_content);
+    virtual void handle_packet_shm_offer(uint32_t in_seqno, std::string in_content);
+    virtual void handle_packet_shm_data(uint32_t in_seqno, std::string in_content);
+    virtual void handle_packet_comp_offer(uint32_t in_seqno, std::string in_content);
+    virtual void handle_packet_comp_block(uint32_t in_seqno, std::string in_content);
 
     unsigned int send_ping();
     unsigned int send_pong(uint32_t ping_seqno);
@@ -108,10 +114,27 @@ protected:
     // incoming read buffer, we're agnostic if it's a network or IPC buffer.
     std::shared_ptr<BufferHandlerGeneric> ringbuf_handler;
 
+    // Link distress accounting - frames too large for the ring, and times
+    // the channel couldn't make progress because a buffer was pinned full.
+    // Atomics so subclasses can publish them without taking ext_mutex
+    std::atomic<uint64_t> io_ring_overflows;
+    std::atomic<uint64_t> io_stall_count;
+
     // If we're an IPC instance, the IPC control.  The ringbuf_handler is associated
     // with the IPC instance.
     std::shared_ptr<IPCRemoteV2> ipc_remote;
 
+    // Optional shared-memory data ring offered by a local helper; bulk data
+    // frames arrive here instead of over the pipe, which carries only the
+    // doorbell commands telling us to drain it
+    kis_shm_ring_t *shm_ring;
+
+    // Re-usable rx command; we clear and re-parse into the same message for
+    // every inbound frame so the heap storage it retains acts as a
+    // per-connection arena, instead of allocating a fresh command tens of
+    // thousands of times a second on a busy source
+    std::shared_ptr<KismetExternal::Command> rx_cmd;
+
     GlobalRegistry *globalreg;
 
     std::shared_ptr<Timetracker> timetracker;
@@ -0,0 +1,483 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "kis_federation.h"
+#include "util.h"
+#include "configfile.h"
+#include "entrytracker.h"
+#include "structured.h"
+#include "kismet_json.h"
+
+// Minimal form encoding for the 'json=' post variable; the subscription
+// body is ASCII JSON so only the reserved characters need escaping
+static std::string federation_formencode(std::string in) {
+    std::stringstream ss;
+
+    for (size_t p = 0; p < in.length(); p++) {
+        char c = in[p];
+
+        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            ss << c;
+        } else {
+            char enc[8];
+            snprintf(enc, 8, "%%%02X", (unsigned char) c);
+            ss << enc;
+        }
+    }
+
+    return ss.str();
+}
+
+void tracked_federated_device::seen_by_peer(std::string in_peer, uint64_t in_ts,
+        uint64_t in_packets) {
+
+    peer_packets[in_peer] = in_packets;
+
+    uint64_t total = 0;
+    for (auto i : peer_packets)
+        total += i.second;
+    set_packets(total);
+
+    TrackerElementStringMap smap(seenby_peers);
+
+    auto i = smap.find(in_peer);
+
+    if (i != smap.end()) {
+        i->second->set((uint64_t) in_ts);
+    } else {
+        SharedTrackerElement e(new TrackerElement(TrackerUInt64));
+        e->set((uint64_t) in_ts);
+        smap.insert(TrackerElementStringMap::pair(in_peer, e));
+    }
+}
+
+FederationPeer::FederationPeer(GlobalRegistry *in_globalreg, int in_id,
+        FederationTracker *in_tracker) :
+    tracker_component(in_globalreg, in_id) {
+
+    register_fields();
+    reserve_fields(NULL);
+
+    tracker = in_tracker;
+
+    peerhandler = NULL;
+    in_body = false;
+
+    pollabletracker =
+        Globalreg::FetchMandatoryGlobalAs<PollableTracker>(globalreg, "POLLABLETRACKER");
+}
+
+FederationPeer::~FederationPeer() {
+    disconnect_peer();
+
+    if (peerhandler != NULL)
+        delete peerhandler;
+}
+
+void FederationPeer::connect_peer() {
+    if (tracker == NULL)
+        return;
+
+    // Tear down any previous connection state before reconnecting
+    disconnect_peer();
+
+    if (peerhandler != NULL) {
+        delete peerhandler;
+        peerhandler = NULL;
+    }
+
+    in_body = false;
+
+    // Oversized read buffer; a record line must fit in the ring in one piece
+    peerhandler = new BufferHandler<RingbufV2>(32768, 2048);
+    peerhandler->SetReadBufferInterface(this);
+
+    tcpclient.reset(new TcpClientV2(globalreg, peerhandler));
+
+    if (tcpclient->Connect(get_peer_host(), get_peer_port()) < 0) {
+        set_peer_connected(false);
+        return;
+    }
+
+    pollabletracker->RegisterPollable(std::static_pointer_cast<Pollable>(tcpclient));
+
+    // Queue the subscription request now; it flushes out of the write buffer
+    // once the nonblocking connect completes
+    peerhandler->PutWriteBufferData(tracker->monitor_request(get_peer_host(),
+                get_peer_port()));
+
+    set_peer_connected(true);
+}
+
+void FederationPeer::disconnect_peer() {
+    if (tcpclient != NULL) {
+        pollabletracker->RemovePollable(tcpclient);
+        tcpclient->Disconnect();
+        tcpclient.reset();
+    }
+
+    set_peer_connected(false);
+}
+
+void FederationPeer::BufferAvailable(size_t in_amt) {
+    size_t buf_sz;
+    char *buf;
+
+    if (peerhandler == NULL || tracker == NULL)
+        return;
+
+    buf_sz = peerhandler->PeekReadBufferData((void **) &buf,
+            peerhandler->GetReadBufferAvailable());
+
+    // Walk the complete lines in place in the peeked buffer; a trailing
+    // partial record stays in the ring until the rest arrives
+    size_t consumed_sz = 0;
+    size_t pos = 0;
+    bool broken = false;
+
+    while (pos < buf_sz) {
+        const char *line = buf + pos;
+        const char *eol = (const char *) memchr(line, '\n', buf_sz - pos);
+
+        if (eol == NULL) {
+            // A partial line filling the whole ring can never complete;
+            // drop it rather than wedging the stream
+            if (pos == 0 && buf_sz >= (size_t) peerhandler->GetReadBufferSize()) {
+                consumed_sz = buf_sz;
+                inc_num_error_records(1);
+            }
+
+            break;
+        }
+
+        size_t line_len = eol - line;
+
+        pos += line_len + 1;
+        consumed_sz = pos;
+
+        // Trim trailing CR
+        while (line_len > 0 && line[line_len - 1] == '\r')
+            line_len--;
+
+        // Consume the HTTP response headers; records start after the
+        // blank line
+        if (!in_body) {
+            if (line_len == 0) {
+                in_body = true;
+                continue;
+            }
+
+            std::string hdr(line, line_len);
+
+            if (hdr.compare(0, 5, "HTTP/") == 0 &&
+                    hdr.find(" 200 ") == std::string::npos) {
+                _MSG("Federation peer '" + get_peer_name() + "' rejected the "
+                        "device stream subscription: " + hdr, MSGFLAG_ERROR);
+                broken = true;
+                break;
+            }
+
+            continue;
+        }
+
+        if (line_len == 0)
+            continue;
+
+        inc_num_records(1);
+        set_last_record_time(time(0));
+
+        tracker->handle_peer_record(this, std::string(line, line_len));
+    }
+
+    peerhandler->PeekFreeReadBufferData(buf);
+
+    if (consumed_sz > 0)
+        peerhandler->ConsumeReadBufferData(consumed_sz);
+
+    if (broken)
+        disconnect_peer();
+}
+
+void FederationPeer::BufferError(std::string in_error) {
+    _MSG("Federation peer '" + get_peer_name() + "' connection error: " + in_error,
+            MSGFLAG_ERROR);
+
+    inc_num_reconnects(1);
+    disconnect_peer();
+}
+
+FederationTracker::FederationTracker(GlobalRegistry *in_globalreg) :
+    Kis_Net_Httpd_CPPStream_Handler(in_globalreg),
+    LifetimeGlobal() {
+
+    globalreg = in_globalreg;
+
+    entrytracker =
+        Globalreg::FetchMandatoryGlobalAs<EntryTracker>(globalreg, "ENTRY_TRACKER");
+
+    std::shared_ptr<tracked_federated_device> dev_builder(
+            new tracked_federated_device(globalreg, 0));
+    fed_device_entry_id =
+        entrytracker->RegisterField("kismet.federation.device", dev_builder,
+                "Federated device record");
+
+    std::shared_ptr<FederationPeer> peer_builder(new FederationPeer(globalreg, 0));
+    fed_peer_entry_id =
+        entrytracker->RegisterField("kismet.federation.peer", peer_builder,
+                "Federation peer");
+
+    fed_rate = globalreg->kismet_config->FetchOptUInt("federation_rate", 5);
+    if (fed_rate < 1)
+        fed_rate = 1;
+
+    fed_backfill =
+        globalreg->kismet_config->FetchOptUInt("federation_backfill", 3600);
+
+    reconnect_timer_id = -1;
+
+    std::vector<std::string> peerlines =
+        globalreg->kismet_config->FetchOptVec("federation_peer");
+
+    for (auto p : peerlines) {
+        std::vector<opt_pair> popts;
+
+        StringToOpts(p, ",", &popts);
+
+        std::string phost = FetchOpt("host", &popts);
+        std::string pname = FetchOpt("name", &popts);
+        std::string pport_s = FetchOpt("port", &popts);
+
+        if (phost == "") {
+            _MSG("Federation expected host= in federation_peer line '" + p + "'",
+                    MSGFLAG_ERROR);
+            continue;
+        }
+
+        if (pname == "")
+            pname = phost;
+
+        unsigned int pport = 2501;
+        if (pport_s != "") {
+            if (sscanf(pport_s.c_str(), "%u", &pport) != 1) {
+                _MSG("Federation expected port number in federation_peer line '" +
+                        p + "'", MSGFLAG_ERROR);
+                continue;
+            }
+        }
+
+        std::shared_ptr<FederationPeer> peer(
+                new FederationPeer(globalreg, fed_peer_entry_id, this));
+
+        peer->set_peer_name(pname);
+        peer->set_peer_host(phost);
+        peer->set_peer_port(pport);
+
+        peers.push_back(peer);
+
+        _MSG("Federation subscribing to device stream of '" + pname + "' (" +
+                phost + ":" + UIntToString(pport) + ")", MSGFLAG_INFO);
+
+        peer->connect_peer();
+    }
+
+    if (peers.size() > 0) {
+        std::shared_ptr<Timetracker> timetracker =
+            Globalreg::FetchMandatoryGlobalAs<Timetracker>(globalreg, "TIMETRACKER");
+
+        reconnect_timer_id =
+            timetracker->RegisterTimer(SERVER_TIMESLICES_SEC * 10, NULL, 1,
+                    [this](int) -> int {
+                        local_locker lock(&fed_mutex);
+
+                        for (auto p : peers) {
+                            if (!p->get_peer_connected())
+                                p->connect_peer();
+                        }
+
+                        return 1;
+                    });
+    }
+}
+
+FederationTracker::~FederationTracker() {
+    local_eol_locker lock(&fed_mutex);
+
+    globalreg->RemoveGlobal("FEDERATIONTRACKER");
+
+    std::shared_ptr<Timetracker> timetracker =
+        Globalreg::FetchGlobalAs<Timetracker>(globalreg, "TIMETRACKER");
+    if (timetracker != NULL && reconnect_timer_id >= 0)
+        timetracker->RemoveTimer(reconnect_timer_id);
+
+    for (auto p : peers)
+        p->disconnect_peer();
+}
+
+std::string FederationTracker::monitor_request(std::string in_host,
+        unsigned int in_port) {
+    std::stringstream json;
+
+    // Field mask keeps upstream serialization and the wire format to the
+    // handful of attributes the merged view tracks
+    json << "{\"fields\": [" <<
+        "\"kismet.device.base.key\", " <<
+        "\"kismet.device.base.macaddr\", " <<
+        "\"kismet.device.base.phyname\", " <<
+        "\"kismet.device.base.name\", " <<
+        "\"kismet.device.base.channel\", " <<
+        "\"kismet.device.base.first_time\", " <<
+        "\"kismet.device.base.last_time\", " <<
+        "\"kismet.device.base.packets.total\"], " <<
+        "\"rate\": " << fed_rate << ", " <<
+        "\"last_time\": -" << fed_backfill << "}";
+
+    std::string body = "json=" + federation_formencode(json.str());
+
+    std::stringstream req;
+
+    req << "POST /devices/monitor/devices.ekjson HTTP/1.0\r\n";
+    req << "Host: " << in_host << ":" << in_port << "\r\n";
+    req << "Content-Type: application/x-www-form-urlencoded\r\n";
+    req << "Content-Length: " << body.length() << "\r\n";
+    req << "\r\n";
+    req << body;
+
+    return req.str();
+}
+
+void FederationTracker::handle_peer_record(FederationPeer *peer,
+        std::string in_record) {
+    local_locker lock(&fed_mutex);
+
+    SharedStructured js;
+
+    try {
+        js.reset(new StructuredJson(in_record));
+    } catch (const StructuredDataException& e) {
+        peer->inc_num_error_records(1);
+        return;
+    }
+
+    try {
+        std::string key = js->getKeyAsString("kismet.device.base.key", "");
+
+        if (key == "") {
+            peer->inc_num_error_records(1);
+            return;
+        }
+
+        std::shared_ptr<tracked_federated_device> dev;
+
+        auto di = fed_devices.find(key);
+
+        if (di == fed_devices.end()) {
+            dev.reset(new tracked_federated_device(globalreg, fed_device_entry_id));
+
+            dev->set_device_key(key);
+            dev->set_macaddr(
+                    mac_addr(js->getKeyAsString("kismet.device.base.macaddr", "")));
+
+            fed_devices[key] = dev;
+        } else {
+            dev = di->second;
+        }
+
+        // Most recent record wins for the descriptive fields
+        dev->set_phyname(js->getKeyAsString("kismet.device.base.phyname",
+                    dev->get_phyname()));
+        dev->set_devicename(js->getKeyAsString("kismet.device.base.name",
+                    dev->get_devicename()));
+        dev->set_channel(js->getKeyAsString("kismet.device.base.channel",
+                    dev->get_channel()));
+
+        uint64_t first_ts =
+            (uint64_t) js->getKeyAsNumber("kismet.device.base.first_time", 0);
+        uint64_t last_ts =
+            (uint64_t) js->getKeyAsNumber("kismet.device.base.last_time", 0);
+        uint64_t packets =
+            (uint64_t) js->getKeyAsNumber("kismet.device.base.packets.total", 0);
+
+        // Merge the time window across peers
+        if (first_ts != 0 &&
+                (dev->get_first_time() == 0 ||
+                 first_ts < (uint64_t) dev->get_first_time()))
+            dev->set_first_time(first_ts);
+
+        if (last_ts > (uint64_t) dev->get_last_time())
+            dev->set_last_time(last_ts);
+
+        dev->seen_by_peer(peer->get_peer_name(), last_ts, packets);
+    } catch (const StructuredDataException& e) {
+        peer->inc_num_error_records(1);
+    }
+}
+
+bool FederationTracker::Httpd_VerifyPath(const char *path, const char *method) {
+    if (strcmp(method, "GET") != 0)
+        return false;
+
+    std::string stripped = Httpd_StripSuffix(path);
+
+    if (stripped == "/federation/peers" && Httpd_CanSerialize(path))
+        return true;
+
+    if (stripped == "/federation/devices" && Httpd_CanSerialize(path))
+        return true;
+
+    return false;
+}
+
+void FederationTracker::Httpd_CreateStreamResponse(Kis_Net_Httpd *httpd,
+        Kis_Net_Httpd_Connection *connection,
+        const char *path, const char *method, const char *upload_data,
+        size_t *upload_data_size, std::stringstream &stream) {
+
+    if (strcmp(method, "GET") != 0)
+        return;
+
+    std::string stripped = Httpd_StripSuffix(path);
+
+    if (!Httpd_CanSerialize(path))
+        return;
+
+    local_locker lock(&fed_mutex);
+
+    SharedTrackerElement wrapper(new TrackerElement(TrackerVector));
+    TrackerElementVector wvec(wrapper);
+
+    if (stripped == "/federation/peers") {
+        for (auto p : peers)
+            wvec.push_back(p);
+
+        entrytracker->Serialize(httpd->GetSuffix(path), stream, wrapper, NULL);
+        return;
+    }
+
+    if (stripped == "/federation/devices") {
+        for (auto d : fed_devices)
+            wvec.push_back(d.second);
+
+        entrytracker->Serialize(httpd->GetSuffix(path), stream, wrapper, NULL);
+        return;
+    }
+}
@@ -0,0 +1,272 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __KIS_FEDERATION_H__
+#define __KIS_FEDERATION_H__
+
+#include "config.h"
+
+#include <memory>
+#include <string>
+#include <map>
+#include <vector>
+
+#include "globalregistry.h"
+#include "kis_mutex.h"
+#include "trackedelement.h"
+#include "kis_net_microhttpd.h"
+#include "buffer_handler.h"
+#include "ringbuf2.h"
+#include "tcpclient2.h"
+#include "pollabletracker.h"
+#include "timetracker.h"
+
+// Multi-server federation.
+//
+// A downstream server can subscribe to the device delta stream of any number
+// of upstream servers (the POST /devices/monitor/devices.ekjson push
+// endpoint) and maintain a merged view of every device all the sites have
+// seen, without the O(full-dump) periodic REST polling external aggregation
+// scripts have to do.
+//
+// Peers are defined in the config as
+//   federation_peer=name=site1,host=10.0.0.1,port=2501
+// with one line per upstream server; 'federation_rate' controls the delta
+// rate requested from the peers and 'federation_backfill' how many seconds
+// of history each peer replays when the subscription (re)opens.
+//
+// Remote records can't be re-dissected into the per-phy device components,
+// so federated devices live in their own merged view keyed by the upstream
+// device key, with per-peer attribution, served from /federation/devices
+// and /federation/peers.
+
+class FederationTracker;
+
+// Merged record for a device reported by one or more upstream peers
+class tracked_federated_device : public tracker_component {
+public:
+    tracked_federated_device(GlobalRegistry *in_globalreg, int in_id) :
+        tracker_component(in_globalreg, in_id) {
+        register_fields();
+        reserve_fields(NULL);
+    }
+
+    tracked_federated_device(GlobalRegistry *in_globalreg, int in_id,
+            SharedTrackerElement e) :
+        tracker_component(in_globalreg, in_id) {
+        register_fields();
+        reserve_fields(e);
+    }
+
+    virtual SharedTrackerElement clone_type() {
+        return SharedTrackerElement(new tracked_federated_device(globalreg, get_id()));
+    }
+
+    __Proxy(device_key, std::string, std::string, std::string, device_key);
+    __Proxy(macaddr, mac_addr, mac_addr, mac_addr, macaddr);
+    __Proxy(phyname, std::string, std::string, std::string, phyname);
+    __Proxy(devicename, std::string, std::string, std::string, devicename);
+    __Proxy(channel, std::string, std::string, std::string, channel);
+
+    __Proxy(first_time, uint64_t, time_t, time_t, first_time);
+    __Proxy(last_time, uint64_t, time_t, time_t, last_time);
+
+    __Proxy(packets, uint64_t, uint64_t, uint64_t, packets);
+
+    // Record a report from a peer; updates the per-peer seenby map and
+    // re-sums the packet total across peers
+    void seen_by_peer(std::string in_peer, uint64_t in_ts, uint64_t in_packets);
+
+protected:
+    virtual void register_fields() {
+        tracker_component::register_fields();
+
+        RegisterField("kismet.federation.device.key", TrackerString,
+                "Device key on the upstream server", &device_key);
+        RegisterField("kismet.federation.device.macaddr", TrackerMac,
+                "Device MAC address", &macaddr);
+        RegisterField("kismet.federation.device.phyname", TrackerString,
+                "Phy type", &phyname);
+        RegisterField("kismet.federation.device.name", TrackerString,
+                "Device name", &devicename);
+        RegisterField("kismet.federation.device.channel", TrackerString,
+                "Last reported channel", &channel);
+        RegisterField("kismet.federation.device.first_time", TrackerUInt64,
+                "Earliest time seen by any peer", &first_time);
+        RegisterField("kismet.federation.device.last_time", TrackerUInt64,
+                "Latest time seen by any peer", &last_time);
+        RegisterField("kismet.federation.device.packets", TrackerUInt64,
+                "Packet count summed across peers", &packets);
+        RegisterField("kismet.federation.device.seenby_peers", TrackerStringMap,
+                "Peers reporting this device, by last report time", &seenby_peers);
+    }
+
+    SharedTrackerElement device_key;
+    SharedTrackerElement macaddr;
+    SharedTrackerElement phyname;
+    SharedTrackerElement devicename;
+    SharedTrackerElement channel;
+    SharedTrackerElement first_time;
+    SharedTrackerElement last_time;
+    SharedTrackerElement packets;
+    SharedTrackerElement seenby_peers;
+
+    // Last packet count each peer reported; the tracked total is the sum
+    std::map<std::string, uint64_t> peer_packets;
+};
+
+// Client connection to a single upstream peer; subscribes to the delta
+// stream and hands complete records up to the federation tracker
+class FederationPeer : public tracker_component, public BufferInterface {
+public:
+    FederationPeer(GlobalRegistry *in_globalreg, int in_id,
+            FederationTracker *in_tracker);
+
+    FederationPeer(GlobalRegistry *in_globalreg, int in_id) :
+        tracker_component(in_globalreg, in_id) {
+        register_fields();
+        reserve_fields(NULL);
+        tracker = NULL;
+        peerhandler = NULL;
+        in_body = false;
+    }
+
+    virtual ~FederationPeer();
+
+    virtual SharedTrackerElement clone_type() {
+        return SharedTrackerElement(new FederationPeer(globalreg, get_id()));
+    }
+
+    __Proxy(peer_name, std::string, std::string, std::string, peer_name);
+    __Proxy(peer_host, std::string, std::string, std::string, peer_host);
+    __Proxy(peer_port, uint32_t, uint32_t, uint32_t, peer_port);
+    __Proxy(peer_connected, uint8_t, bool, bool, peer_connected);
+    __Proxy(num_records, uint64_t, uint64_t, uint64_t, num_records);
+    __ProxyIncDec(num_records, uint64_t, uint64_t, num_records);
+    __Proxy(num_error_records, uint64_t, uint64_t, uint64_t, num_error_records);
+    __ProxyIncDec(num_error_records, uint64_t, uint64_t, num_error_records);
+    __Proxy(num_reconnects, uint64_t, uint64_t, uint64_t, num_reconnects);
+    __ProxyIncDec(num_reconnects, uint64_t, uint64_t, num_reconnects);
+    __Proxy(last_record_time, uint64_t, time_t, time_t, last_record_time);
+
+    // (Re)open the TCP connection and queue the subscription request; the
+    // request flushes once the nonblocking connect completes
+    void connect_peer();
+    void disconnect_peer();
+
+    // BufferInterface API
+    virtual void BufferAvailable(size_t in_amt);
+    virtual void BufferError(std::string in_error);
+
+protected:
+    virtual void register_fields() {
+        tracker_component::register_fields();
+
+        RegisterField("kismet.federation.peer.name", TrackerString,
+                "Peer name", &peer_name);
+        RegisterField("kismet.federation.peer.host", TrackerString,
+                "Peer host", &peer_host);
+        RegisterField("kismet.federation.peer.port", TrackerUInt32,
+                "Peer port", &peer_port);
+        RegisterField("kismet.federation.peer.connected", TrackerUInt8,
+                "Peer connection established", &peer_connected);
+        RegisterField("kismet.federation.peer.num_records", TrackerUInt64,
+                "Device records received", &num_records);
+        RegisterField("kismet.federation.peer.num_error_records", TrackerUInt64,
+                "Records which could not be parsed", &num_error_records);
+        RegisterField("kismet.federation.peer.num_reconnects", TrackerUInt64,
+                "Times the connection has been re-established", &num_reconnects);
+        RegisterField("kismet.federation.peer.last_record_time", TrackerUInt64,
+                "Time of the last received record", &last_record_time);
+    }
+
+    SharedTrackerElement peer_name;
+    SharedTrackerElement peer_host;
+    SharedTrackerElement peer_port;
+    SharedTrackerElement peer_connected;
+    SharedTrackerElement num_records;
+    SharedTrackerElement num_error_records;
+    SharedTrackerElement num_reconnects;
+    SharedTrackerElement last_record_time;
+
+    FederationTracker *tracker;
+
+    std::shared_ptr<PollableTracker> pollabletracker;
+
+    BufferHandlerGeneric *peerhandler;
+    std::shared_ptr<TcpClientV2> tcpclient;
+
+    // Past the HTTP response headers?
+    bool in_body;
+};
+
+class FederationTracker : public Kis_Net_Httpd_CPPStream_Handler,
+    public LifetimeGlobal {
+public:
+    static std::shared_ptr<FederationTracker>
+        create_federationtracker(GlobalRegistry *in_globalreg) {
+        std::shared_ptr<FederationTracker> mon(new FederationTracker(in_globalreg));
+        in_globalreg->RegisterLifetimeGlobal(mon);
+        in_globalreg->InsertGlobal("FEDERATIONTRACKER", mon);
+        return mon;
+    }
+
+private:
+    FederationTracker(GlobalRegistry *in_globalreg);
+
+public:
+    virtual ~FederationTracker();
+
+    // HTTP API
+    virtual bool Httpd_VerifyPath(const char *path, const char *method);
+
+    virtual void Httpd_CreateStreamResponse(Kis_Net_Httpd *httpd,
+            Kis_Net_Httpd_Connection *connection,
+            const char *url, const char *method, const char *upload_data,
+            size_t *upload_data_size, std::stringstream &stream);
+
+    // Merge one complete JSON record from a peer into the federated view;
+    // called from the peer buffer interface
+    void handle_peer_record(FederationPeer *peer, std::string in_record);
+
+    // Subscription request text sent to a peer once the TCP session opens
+    std::string monitor_request(std::string in_host, unsigned int in_port);
+
+protected:
+    GlobalRegistry *globalreg;
+
+    kis_recursive_timed_mutex fed_mutex;
+
+    std::shared_ptr<EntryTracker> entrytracker;
+
+    int fed_device_entry_id;
+    int fed_peer_entry_id;
+
+    // Delta rate and backfill window requested from peers
+    unsigned int fed_rate;
+    unsigned int fed_backfill;
+
+    std::vector<std::shared_ptr<FederationPeer> > peers;
+
+    // Merged device view keyed by upstream device key
+    std::map<std::string, std::shared_ptr<tracked_federated_device> > fed_devices;
+
+    int reconnect_timer_id;
+};
+
+#endif
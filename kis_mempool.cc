@@ -0,0 +1,171 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include <string.h>
+
+#include <sys/mman.h>
+
+#include "kis_mempool.h"
+
+kis_recursive_timed_mutex kis_mem_pool::pool_mutex;
+
+uint8_t *kis_mem_pool::region = NULL;
+size_t kis_mem_pool::region_sz = 0;
+size_t kis_mem_pool::region_offt = 0;
+bool kis_mem_pool::region_hugetlb = false;
+
+size_t kis_mem_pool::taken_bytes = 0;
+uint64_t kis_mem_pool::fallback_count = 0;
+
+std::map<size_t, std::vector<uint8_t *> > kis_mem_pool::free_blocks;
+
+bool kis_mem_pool::reserve(size_t in_bytes, bool in_hugetlb) {
+    local_locker lock(&pool_mutex);
+
+    if (region != NULL)
+        return true;
+
+    if (in_bytes == 0)
+        return false;
+
+    void *m = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (in_hugetlb) {
+        // Explicit hugepages need the size rounded to the hugepage
+        // granularity; 2MB is the baseline size on every platform we
+        // care about
+        size_t huge_sz = (in_bytes + (2 * 1024 * 1024) - 1) & ~((size_t) (2 * 1024 * 1024) - 1);
+
+        m = mmap(NULL, huge_sz, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (m != MAP_FAILED) {
+            region = (uint8_t *) m;
+            region_sz = huge_sz;
+            region_hugetlb = true;
+            return true;
+        }
+    }
+#endif
+
+    // No explicit hugepages (or none configured on the system); take a
+    // normal anonymous mapping and ask for transparent hugepage backing
+    m = mmap(NULL, in_bytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (m == MAP_FAILED)
+        return false;
+
+#ifdef MADV_HUGEPAGE
+    madvise(m, in_bytes, MADV_HUGEPAGE);
+#endif
+
+    region = (uint8_t *) m;
+    region_sz = in_bytes;
+    region_hugetlb = false;
+
+    return true;
+}
+
+bool kis_mem_pool::active() {
+    return region != NULL;
+}
+
+bool kis_mem_pool::hugepages_active() {
+    return region_hugetlb;
+}
+
+void *kis_mem_pool::take(size_t in_len) {
+    if (region == NULL)
+        return NULL;
+
+    // Total footprint: header plus payload, rounded to the block
+    // alignment so every class stays aligned
+    size_t total = (sizeof(block_header) + in_len + block_align - 1) &
+        ~((size_t) block_align - 1);
+
+    local_locker lock(&pool_mutex);
+
+    auto fi = free_blocks.find(total);
+
+    if (fi != free_blocks.end() && fi->second.size() > 0) {
+        uint8_t *b = fi->second.back();
+        fi->second.pop_back();
+
+        taken_bytes += total;
+
+        return b + sizeof(block_header);
+    }
+
+    if (region_offt + total > region_sz) {
+        fallback_count++;
+        return NULL;
+    }
+
+    uint8_t *b = region + region_offt;
+    region_offt += total;
+
+    ((block_header *) b)->total_sz = total;
+
+    taken_bytes += total;
+
+    return b + sizeof(block_header);
+}
+
+bool kis_mem_pool::give(void *in_block) {
+    if (region == NULL || in_block == NULL)
+        return false;
+
+    uint8_t *b = ((uint8_t *) in_block) - sizeof(block_header);
+
+    // Heap fallback blocks are freed by the caller as usual
+    if (b < region || b >= region + region_sz)
+        return false;
+
+    local_locker lock(&pool_mutex);
+
+    size_t total = ((block_header *) b)->total_sz;
+
+    free_blocks[total].push_back(b);
+
+    taken_bytes -= total;
+
+    return true;
+}
+
+size_t kis_mem_pool::reserved_bytes() {
+    return region_sz;
+}
+
+size_t kis_mem_pool::committed_bytes() {
+    local_locker lock(&pool_mutex);
+    return region_offt;
+}
+
+size_t kis_mem_pool::outstanding_bytes() {
+    local_locker lock(&pool_mutex);
+    return taken_bytes;
+}
+
+uint64_t kis_mem_pool::heap_fallbacks() {
+    local_locker lock(&pool_mutex);
+    return fallback_count;
+}
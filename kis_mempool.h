@@ -0,0 +1,107 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __KIS_MEMPOOL_H__
+#define __KIS_MEMPOOL_H__
+
+#include "config.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <map>
+#include <vector>
+
+#include "kis_mutex.h"
+
+// Optional preallocated memory mode for long-running deployments.
+//
+// Over multi-week uptimes the recycling pools (packetchain packets,
+// chainbuf chunks, tracked-element node blocks) keep allocation *rates*
+// down, but the blocks themselves still come from the glibc heap, which
+// fragments across arenas and scatters the hot working set across the
+// address space.  When enabled at startup, a single anonymous mapping is
+// reserved up front - hugepage-backed where the system allows it - and
+// the pools carve their blocks from it instead.  Blocks are recycled
+// through per-size freelists inside the reservation and never returned
+// to the OS, so resident memory is flat and predictable and the hot
+// structures share a small set of (ideally huge) pages.
+//
+// The pool is deliberately a bump allocator plus freelists: every block
+// that enters circulation stays the same size for its lifetime, which is
+// exactly how the recycling pools behave, so there is no fragmentation
+// to manage.  When the reservation runs dry callers fall back to the
+// normal heap; the fallback count is exported so an operator can see the
+// reservation was undersized.
+class kis_mem_pool {
+public:
+    // Reserve the backing region; called once at startup before any
+    // subsystems allocate.  When in_hugetlb is true an explicit
+    // MAP_HUGETLB mapping is attempted first, falling back to a normal
+    // mapping advised MADV_HUGEPAGE (THP).  Returns false if no region
+    // could be mapped, in which case the pool stays inactive and all
+    // allocation goes to the heap as before.
+    static bool reserve(size_t in_bytes, bool in_hugetlb);
+
+    static bool active();
+
+    // True when the reservation is backed by explicit hugepages rather
+    // than transparent-hugepage advice
+    static bool hugepages_active();
+
+    // Carve a block of at least in_len bytes, preferring a recycled
+    // block of the same size class.  Returns NULL when the pool is
+    // inactive or the reservation is exhausted; the caller falls back
+    // to the normal heap.
+    static void *take(size_t in_len);
+
+    // Return a block obtained from take() for recycling.  Returns false
+    // if the pointer is not inside the reservation (a heap fallback
+    // block), in which case the caller frees it as it always did.
+    static bool give(void *in_block);
+
+    // Occupancy, for the memory accounting endpoint
+    static size_t reserved_bytes();
+    static size_t committed_bytes();
+    static size_t outstanding_bytes();
+    static uint64_t heap_fallbacks();
+
+protected:
+    // Each block carries a hidden header recording its total (aligned)
+    // size so give() can freelist it without the caller tracking sizes
+    struct block_header {
+        size_t total_sz;
+    };
+
+    static const size_t block_align = 16;
+
+    static kis_recursive_timed_mutex pool_mutex;
+
+    static uint8_t *region;
+    static size_t region_sz;
+    static size_t region_offt;
+    static bool region_hugetlb;
+
+    static size_t taken_bytes;
+    static uint64_t fallback_count;
+
+    // Recycled blocks by total size
+    static std::map<size_t, std::vector<uint8_t *> > free_blocks;
+};
+
+#endif
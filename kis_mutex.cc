@@ -0,0 +1,199 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "kis_mutex.h"
+
+#ifdef KIS_MUTEX_PROFILE
+
+/* The registry has to outlive any global-scope mutex, and mutexes are
+ * constructed from global constructors before main, so it lives in
+ * function-local statics instead of file-scope globals to dodge
+ * initialization ordering */
+static pthread_mutex_t *profile_registry_mutex() {
+    static pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER;
+    return &m;
+}
+
+static std::vector<kis_recursive_timed_mutex *> *profile_registry() {
+    static std::vector<kis_recursive_timed_mutex *> *v =
+        new std::vector<kis_recursive_timed_mutex *>();
+    return v;
+}
+
+static uint64_t ts_diff_usec(const struct timespec& start,
+        const struct timespec& end) {
+    return (uint64_t) (end.tv_sec - start.tv_sec) * 1000000ULL +
+        (end.tv_nsec - start.tv_nsec) / 1000;
+}
+
+kis_recursive_timed_mutex::kis_recursive_timed_mutex() {
+    pthread_mutexattr_t mutexattr;
+    pthread_mutexattr_init(&mutexattr);
+    pthread_mutexattr_settype(&mutexattr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mutex, &mutexattr);
+
+    name[0] = '\0';
+    depth = 0;
+
+    acquisitions = 0;
+    contentions = 0;
+    wait_usec = 0;
+    hold_usec = 0;
+    max_hold_usec = 0;
+
+    pthread_mutex_lock(profile_registry_mutex());
+    profile_registry()->push_back(this);
+    pthread_mutex_unlock(profile_registry_mutex());
+}
+
+kis_recursive_timed_mutex::~kis_recursive_timed_mutex() {
+    pthread_mutex_lock(profile_registry_mutex());
+
+    std::vector<kis_recursive_timed_mutex *> *reg = profile_registry();
+    for (auto i = reg->begin(); i != reg->end(); ++i) {
+        if (*i == this) {
+            reg->erase(i);
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(profile_registry_mutex());
+
+    pthread_mutex_destroy(&mutex);
+}
+
+void kis_recursive_timed_mutex::set_mutex_name(const char *in_name) {
+    snprintf(name, sizeof(name), "%s", in_name);
+}
+
+void kis_recursive_timed_mutex::note_acquire(bool contended, uint64_t waited_usec) {
+    acquisitions++;
+
+    if (contended) {
+        contentions++;
+        wait_usec += waited_usec;
+    }
+
+    if (depth++ == 0)
+        clock_gettime(CLOCK_MONOTONIC, &first_acquire);
+}
+
+void kis_recursive_timed_mutex::lock() {
+    // An uncontended acquire is the common case; take it without
+    // touching the clock
+    if (pthread_mutex_trylock(&mutex) == 0) {
+        note_acquire(false, 0);
+        return;
+    }
+
+    struct timespec ws, we;
+    clock_gettime(CLOCK_MONOTONIC, &ws);
+
+    pthread_mutex_lock(&mutex);
+
+    clock_gettime(CLOCK_MONOTONIC, &we);
+
+    note_acquire(true, ts_diff_usec(ws, we));
+}
+
+bool kis_recursive_timed_mutex::try_lock_for(const std::chrono::seconds& d) {
+    if (pthread_mutex_trylock(&mutex) == 0) {
+        note_acquire(false, 0);
+        return true;
+    }
+
+    struct timespec ws, we;
+    clock_gettime(CLOCK_MONOTONIC, &ws);
+
+#if defined(HAVE_PTHREAD_TIMELOCK) && !defined(DISABLE_MUTEX_TIMEOUT)
+    struct timespec t;
+
+    clock_gettime(CLOCK_REALTIME, &t);
+    t.tv_sec += d.count();
+
+    if (pthread_mutex_timedlock(&mutex, &t) != 0) {
+        // We can't safely touch the counters without holding the mutex;
+        // a timed-out acquire goes unrecorded
+        return false;
+    }
+#else
+    pthread_mutex_lock(&mutex);
+#endif
+
+    clock_gettime(CLOCK_MONOTONIC, &we);
+
+    note_acquire(true, ts_diff_usec(ws, we));
+
+    return true;
+}
+
+void kis_recursive_timed_mutex::unlock() {
+    if (depth > 0 && --depth == 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        uint64_t held = ts_diff_usec(first_acquire, now);
+
+        hold_usec += held;
+        if (held > max_hold_usec)
+            max_hold_usec = held;
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
+
+void kis_recursive_timed_mutex::fetch_profile(kis_mutex_profile_record *r) {
+    r->address = this;
+    r->name = std::string(name);
+    r->acquisitions = acquisitions;
+    r->contentions = contentions;
+    r->wait_usec = wait_usec;
+    r->hold_usec = hold_usec;
+    r->max_hold_usec = max_hold_usec;
+}
+
+std::vector<kis_mutex_profile_record> kis_mutex_profile_snapshot() {
+    std::vector<kis_mutex_profile_record> ret;
+
+    pthread_mutex_lock(profile_registry_mutex());
+
+    std::vector<kis_recursive_timed_mutex *> *reg = profile_registry();
+
+    ret.resize(reg->size());
+    for (size_t x = 0; x < reg->size(); x++)
+        (*reg)[x]->fetch_profile(&ret[x]);
+
+    pthread_mutex_unlock(profile_registry_mutex());
+
+    return ret;
+}
+
+#else
+
+std::vector<kis_mutex_profile_record> kis_mutex_profile_snapshot() {
+    return std::vector<kis_mutex_profile_record>();
+}
+
+#endif
+
@@ -31,6 +31,11 @@
 
 #include <mutex>
 #include <chrono>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <stdint.h>
 
 // Seconds a lock is allowed to be held before throwing a timeout error
 #define KIS_THREAD_DEADLOCK_TIMEOUT     30
@@ -38,7 +43,67 @@
 // Force the custom c++ workaround mutex to always be on; undefine to turn off
 #define ALWAYS_USE_KISMET_MUTEX         1
 
-#if defined (ALWAYS_USE_KISMET_MUTEX) || (defined (GCC_VERSION_MAJOR) && (GCC_VERSION_MAJOR < 4 || (GCC_VERSION_MAJOR == 4 && GCC_VERSION_MINOR < 9)))
+// Snapshot of one mutex from the profile registry; only populated when
+// built with --enable-mutexprofile
+struct kis_mutex_profile_record {
+    const void *address;
+    std::string name;
+    uint64_t acquisitions;
+    uint64_t contentions;
+    uint64_t wait_usec;
+    uint64_t hold_usec;
+    uint64_t max_hold_usec;
+};
+
+// Snapshot all live mutexes; returns an empty vector when profiling is
+// not compiled in
+std::vector<kis_mutex_profile_record> kis_mutex_profile_snapshot();
+
+#if defined (KIS_MUTEX_PROFILE)
+
+/* Instrumented variant, selected with --enable-mutexprofile.  Every
+ * mutex registers itself in a process-wide table and counts
+ * acquisitions, contended acquisitions, time spent waiting, and time
+ * held, dumped through /system/mutex_profile.  The counters are only
+ * written while the mutex is held; the snapshot reads them without
+ * synchronization, which can tear a reading but can't corrupt anything,
+ * an acceptable trade for not perturbing what we're measuring.
+ */
+class kis_recursive_timed_mutex {
+public:
+    kis_recursive_timed_mutex();
+    ~kis_recursive_timed_mutex();
+
+    // Label for the profile report; keep it short, it's truncated
+    void set_mutex_name(const char *in_name);
+
+    bool try_lock_for(const std::chrono::seconds& d);
+    void lock();
+    void unlock();
+
+    void fetch_profile(kis_mutex_profile_record *r);
+
+protected:
+    // Called with the mutex held
+    void note_acquire(bool contended, uint64_t waited_usec);
+
+    pthread_mutex_t mutex;
+
+    char name[32];
+
+    // Recursion depth; hold time runs from the outermost acquire to the
+    // final release
+    unsigned int depth;
+    struct timespec first_acquire;
+
+    uint64_t acquisitions;
+    uint64_t contentions;
+    uint64_t wait_usec;
+    uint64_t hold_usec;
+    uint64_t max_hold_usec;
+};
+
+#elif defined (ALWAYS_USE_KISMET_MUTEX) || (defined (GCC_VERSION_MAJOR) && (GCC_VERSION_MAJOR < 4 || (GCC_VERSION_MAJOR == 4 && GCC_VERSION_MINOR < 9)))
 
 class kis_recursive_timed_mutex {
 public:
@@ -219,5 +284,13 @@ protected:
     kis_recursive_timed_mutex *cpplock;
 };
 
+// Name a mutex for the profile report; compiles away unless profiling
+// is enabled
+inline void kis_mutex_set_name(kis_recursive_timed_mutex *m, const char *name) {
+#ifdef KIS_MUTEX_PROFILE
+    m->set_mutex_name(name);
+#endif
+}
+
 #endif
 
@@ -29,17 +29,27 @@
 #include <string.h>
 #include <errno.h>
 #include <microhttpd.h>
+#include <zlib.h>
+#include <pthread.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 #include <memory>
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include "globalregistry.h"
 #include "messagebus.h"
 #include "configfile.h"
 #include "kis_net_microhttpd.h"
+#include "kis_threads.h"
 #include "base64.h"
 #include "entrytracker.h"
 #include "kis_httpd_websession.h"
@@ -100,9 +110,19 @@ Kis_Net_Httpd::Kis_Net_Httpd(GlobalRegistry *in_globalreg) {
         RegisterHandler(new Kis_Net_Httpd_No_Files_Handler());
     }
 
+    // Always serve the per-endpoint request metrics report
+    RegisterHandler(new Kis_Net_Httpd_Metrics_Endpoint());
+
     session_timeout = 
         globalreg->kismet_config->FetchOptUInt("httpd_session_timeout", 7200);
 
+    post_body_limit =
+        globalreg->kismet_config->FetchOptULong("httpd_post_body_limit",
+                1024 * 1024 * 4);
+
+    static_cache_time =
+        globalreg->kismet_config->FetchOptUInt("httpd_static_cache_time", 3600);
+
     use_ssl = globalreg->kismet_config->FetchOptBoolean("httpd_ssl", false);
     pem_path = globalreg->kismet_config->FetchOpt("httpd_ssl_cert");
     key_path = globalreg->kismet_config->FetchOpt("httpd_ssl_key");
@@ -115,6 +135,7 @@ Kis_Net_Httpd::Kis_Net_Httpd(GlobalRegistry *in_globalreg) {
     RegisterMimeType("ico", "image/x-icon");
     RegisterMimeType("json", "application/json");
     RegisterMimeType("ekjson", "application/json");
+    RegisterMimeType("cbor", "application/cbor");
     RegisterMimeType("pcap", "application/vnd.tcpdump.pcap");
 
     std::vector<std::string> mimeopts = globalreg->kismet_config->FetchOptVec("httpd_mime");
@@ -187,6 +208,8 @@ Kis_Net_Httpd::Kis_Net_Httpd(GlobalRegistry *in_globalreg) {
             }
         }
     }
+
+    RebuildSessionCache();
 }
 
 Kis_Net_Httpd::~Kis_Net_Httpd() {
@@ -338,20 +361,46 @@ int Kis_Net_Httpd::StartHttpd() {
     }
 
 
+    // Map the static assets up front so the first UI load doesn't turn
+    // into dozens of individual disk opens on slow media
+    if (http_serve_files || http_serve_user_files)
+        PreloadStaticCache();
+
+    // Microhttpd spawns its listener (and from it, per-connection threads)
+    // internally, so pin them by briefly taking the configured 'httpd'
+    // affinity on the calling thread; the pool inherits the mask at spawn
+    // and we restore our own afterwards
+#ifdef __linux__
+    cpu_set_t saved_affinity;
+    bool restore_affinity =
+        (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                &saved_affinity) == 0);
+#endif
+
+    std::string httpd_cpus = Kis_Thread_Apply_Class(globalreg, "httpd");
+
     if (!use_ssl) {
         microhttpd = MHD_start_daemon(MHD_USE_THREAD_PER_CONNECTION,
-                http_port, NULL, NULL, 
-                &http_request_handler, this, 
+                http_port, NULL, NULL,
+                &http_request_handler, this,
                 MHD_OPTION_NOTIFY_COMPLETED, &http_request_completed, NULL,
-                MHD_OPTION_END); 
+                MHD_OPTION_END);
     } else {
         microhttpd = MHD_start_daemon(MHD_USE_THREAD_PER_CONNECTION | MHD_USE_SSL,
-                http_port, NULL, NULL, &http_request_handler, this, 
+                http_port, NULL, NULL, &http_request_handler, this,
                 MHD_OPTION_HTTPS_MEM_KEY, cert_key,
                 MHD_OPTION_HTTPS_MEM_CERT, cert_pem,
-                MHD_OPTION_END); 
+                MHD_OPTION_END);
     }
 
+#ifdef __linux__
+    if (httpd_cpus != "" && restore_affinity)
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                &saved_affinity);
+#endif
+
+    Kis_Thread_Record_External("httpd-pool", "httpd", httpd_cpus);
+
 
     if (microhttpd == NULL) {
         _MSG("Failed to start http server on port " + UIntToString(http_port),
@@ -415,10 +464,68 @@ void Kis_Net_Httpd::MHD_Panic(void *cls, const char *file __attribute__((unused)
     httpd->microhttpd = NULL;
 }
 
+std::shared_ptr<Kis_Net_Httpd_Endpoint_Metrics>
+Kis_Net_Httpd::FetchEndpointMetrics(std::string in_uri) {
+    local_locker lock(&metrics_mutex);
+
+    auto mi = endpoint_metrics_map.find(in_uri);
+
+    if (mi != endpoint_metrics_map.end())
+        return mi->second;
+
+    // Cap the table; per-key and per-mac uris would otherwise grow it one
+    // record per device
+    if (endpoint_metrics_map.size() >= 256) {
+        in_uri = "(other)";
+
+        mi = endpoint_metrics_map.find(in_uri);
+
+        if (mi != endpoint_metrics_map.end())
+            return mi->second;
+    }
+
+    auto metrics = std::make_shared<Kis_Net_Httpd_Endpoint_Metrics>();
+    endpoint_metrics_map[in_uri] = metrics;
+
+    return metrics;
+}
+
+std::map<std::string, std::shared_ptr<Kis_Net_Httpd_Endpoint_Metrics> >
+Kis_Net_Httpd::FetchAllEndpointMetrics() {
+    local_locker lock(&metrics_mutex);
+
+    return std::map<std::string,
+        std::shared_ptr<Kis_Net_Httpd_Endpoint_Metrics> >(endpoint_metrics_map.begin(),
+                endpoint_metrics_map.end());
+}
+
+void Kis_Net_Httpd::RebuildSessionCache() {
+    std::shared_ptr<const session_cache_map> cache(
+            new session_cache_map(session_map.begin(), session_map.end()));
+
+    std::atomic_store(&session_cache, cache);
+}
+
+std::shared_ptr<Kis_Net_Httpd_Session> Kis_Net_Httpd::FindSession(const std::string& in_token) {
+    // One unlocked hash probe against the read-mostly snapshot
+    std::shared_ptr<const session_cache_map> cache = std::atomic_load(&session_cache);
+
+    if (cache == NULL)
+        return NULL;
+
+    auto si = cache->find(in_token);
+
+    if (si == cache->end())
+        return NULL;
+
+    return si->second;
+}
+
 void Kis_Net_Httpd::AddSession(std::shared_ptr<Kis_Net_Httpd_Session> in_session) {
     local_locker lock(&controller_mutex);
 
     session_map.emplace(in_session->sessionid, in_session);
+    RebuildSessionCache();
     WriteSessions();
 }
 
@@ -429,6 +536,7 @@ void Kis_Net_Httpd::DelSession(std::string in_key) {
 
     if (i != session_map.end()) {
         session_map.erase(i);
+        RebuildSessionCache();
         WriteSessions();
     }
 
@@ -439,6 +547,7 @@ void Kis_Net_Httpd::DelSession(std::map<std::string, std::shared_ptr<Kis_Net_Htt
 
     if (in_itr != session_map.end()) {
         session_map.erase(in_itr);
+        RebuildSessionCache();
         WriteSessions();
     }
 }
@@ -489,21 +598,21 @@ int Kis_Net_Httpd::http_request_handler(void *cls, struct MHD_Connection *connec
             MHD_COOKIE_KIND, KIS_SESSION_COOKIE);
 
     if (cookieval != NULL) {
-        auto si = kishttpd->session_map.find(cookieval);
+        s = kishttpd->FindSession(cookieval);
 
-        if (si != kishttpd->session_map.end()) {
+        if (s != NULL) {
             // Delete if the session has expired and don't assign as a session
-            if (si->second->session_lifetime != 0 &&
-                    si->second->session_seen + si->second->session_lifetime < 
+            if (s->session_lifetime != 0 &&
+                    s->session_seen + s->session_lifetime <
                     kishttpd->globalreg->timestamp.tv_sec) {
-                kishttpd->DelSession(si);
+                kishttpd->DelSession(s->sessionid);
+                s = NULL;
             } else {
                 // Update the last seen, assign as the current session
-                s = si->second;
                 s->session_seen = kishttpd->globalreg->timestamp.tv_sec;
             }
         }
-    } 
+    }
     
     Kis_Net_Httpd_Handler *handler = NULL;
     
@@ -534,10 +643,27 @@ int Kis_Net_Httpd::http_request_handler(void *cls, struct MHD_Connection *connec
         concls->url = std::string(url);
         concls->connection = connection;
 
+        // Stamp the start of the request for the endpoint metrics
+        gettimeofday(&(concls->request_start), NULL);
+
         /* Set up a POST handler */
         if (strcmp(method, "POST") == 0) {
             concls->connection_type = Kis_Net_Httpd_Connection::CONNECTION_POST;
 
+            // If the client announces a body over the cache limit, flag
+            // it now so we answer 413 without buffering any of it
+            const char *clen =
+                MHD_lookup_connection_value(connection, MHD_HEADER_KIND,
+                        MHD_HTTP_HEADER_CONTENT_LENGTH);
+
+            if (clen != NULL && kishttpd->post_body_limit != 0) {
+                unsigned long long announced;
+
+                if (sscanf(clen, "%llu", &announced) == 1 &&
+                        announced > (unsigned long long) kishttpd->post_body_limit)
+                    concls->post_too_large = true;
+            }
+
             concls->postprocessor =
                 MHD_create_post_processor(connection, KIS_HTTPD_POSTBUFFERSZ,
                         kishttpd->http_post_handler, (void *) concls);
@@ -579,7 +705,22 @@ int Kis_Net_Httpd::http_request_handler(void *cls, struct MHD_Connection *connec
 
     if (strcmp(method, "POST") == 0) {
         // Handle post
-        
+
+        // A body over the limit gets a 413 as soon as we notice, with the
+        // rest of the upload consumed and discarded
+        if (concls->post_too_large) {
+            *upload_data_size = 0;
+
+            std::string toolarge = "413";
+
+            struct MHD_Response *response =
+                MHD_create_response_from_buffer(toolarge.length(),
+                        (void *) toolarge.c_str(), MHD_RESPMEM_MUST_COPY);
+
+            return MHD_queue_response(connection, MHD_HTTP_REQUEST_ENTITY_TOO_LARGE,
+                    response);
+        }
+
         // If we still have data to process
         if (*upload_data_size != 0) {
             // Process regardless of size to get our completion
@@ -619,6 +760,18 @@ int Kis_Net_Httpd::http_post_handler(void *coninfo_cls, enum MHD_ValueKind kind,
         return (concls->httpdhandler)->Httpd_PostIterator(coninfo_cls, kind,
                 key, filename, content_type, transfer_encoding, data, off, size);
     } else {
+        // Enforce the body cache limit; streaming custom iterators above
+        // manage their own buffering and aren't subject to it
+        concls->post_bytes += size;
+
+        if (concls->httpd->post_body_limit != 0 &&
+                concls->post_bytes > concls->httpd->post_body_limit) {
+            concls->post_too_large = true;
+            concls->variable_cache.clear();
+
+            return MHD_NO;
+        }
+
         // Cache all the variables by name until we're complete
         if (concls->variable_cache.find(key) == concls->variable_cache.end())
             concls->variable_cache[key] = 
@@ -639,6 +792,21 @@ void Kis_Net_Httpd::http_request_completed(void *cls __attribute__((unused)),
     if (con_info == NULL)
         return;
 
+    // Credit the endpoint metrics; serializer variants of a uri aggregate
+    // into one record
+    if (con_info->httpd != NULL && con_info->url != "") {
+        struct timeval now, delta;
+
+        gettimeofday(&now, NULL);
+        timersub(&now, &(con_info->request_start), &delta);
+
+        auto metrics = con_info->httpd->FetchEndpointMetrics(
+                Kis_Net_Httpd::StripSuffix(con_info->url));
+
+        metrics->hits++;
+        metrics->RecordLatency((uint64_t) delta.tv_sec * 1000000L + delta.tv_usec);
+    }
+
     // Lock and shut it down
     {
         std::lock_guard<std::mutex> lk(con_info->connection_mutex);
@@ -667,6 +835,169 @@ static void free_callback(void *cls) {
     fclose(file);
 }
 
+// Reader state for a cached static asset; holds a reference to the cache
+// entry so a file replaced on disk can't be unmapped mid-send
+struct cached_file_reader_state {
+    std::shared_ptr<void> entry;
+    const char *data;
+    size_t len;
+};
+
+static ssize_t cached_file_reader(void *cls, uint64_t pos, char *buf, size_t max) {
+    cached_file_reader_state *state = (cached_file_reader_state *) cls;
+
+    if (pos >= state->len)
+        return MHD_CONTENT_READER_END_OF_STREAM;
+
+    size_t sz = std::min((size_t) max, state->len - (size_t) pos);
+
+    memcpy(buf, state->data + pos, sz);
+
+    return sz;
+}
+
+static void cached_file_free_callback(void *cls) {
+    delete (cached_file_reader_state *) cls;
+}
+
+Kis_Net_Httpd::static_file_cache_entry::~static_file_cache_entry() {
+    if (map != NULL && map != MAP_FAILED)
+        munmap(map, len);
+}
+
+std::shared_ptr<Kis_Net_Httpd::static_file_cache_entry>
+Kis_Net_Httpd::FetchStaticCacheEntry(std::string in_path, std::string in_suffix) {
+    struct stat buf;
+
+    if (stat(in_path.c_str(), &buf) != 0 || !S_ISREG(buf.st_mode) || buf.st_size == 0)
+        return NULL;
+
+    auto ci = static_file_cache.find(in_path);
+
+    if (ci != static_file_cache.end() &&
+            ci->second->mtime == buf.st_mtime &&
+            ci->second->len == (size_t) buf.st_size)
+        return ci->second;
+
+    int fd = open(in_path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        return NULL;
+
+    std::shared_ptr<static_file_cache_entry> entry(new static_file_cache_entry());
+
+    entry->len = buf.st_size;
+    entry->mtime = buf.st_mtime;
+    entry->map = mmap(NULL, entry->len, PROT_READ, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (entry->map == MAP_FAILED)
+        return NULL;
+
+    // Hint the kernel to fault the asset in now; on slow media (sdcard
+    // field units) this front-loads the read instead of paying for it
+    // page by page mid-response
+    posix_madvise(entry->map, entry->len, POSIX_MADV_WILLNEED);
+
+    char lastmod[31];
+    struct tm tmstruct;
+    localtime_r(&(buf.st_mtime), &tmstruct);
+    strftime(lastmod, 31, "%a, %d %b %Y %H:%M:%S %Z", &tmstruct);
+    entry->last_modified = lastmod;
+
+    std::string mime = GetMimeType(in_suffix);
+
+    if (mime != "")
+        entry->mimetype = mime;
+    else
+        entry->mimetype = "text/plain";
+
+    // Replacing an existing record is safe; in-flight responses hold their
+    // own reference to the old mapping
+    static_file_cache[in_path] = entry;
+
+    return entry;
+}
+
+void Kis_Net_Httpd::PreloadStaticCache() {
+    unsigned int mapped = 0;
+
+    for (auto sd : static_dir_vec) {
+        std::vector<std::string> dirs;
+        dirs.push_back(sd.path);
+
+        while (!dirs.empty()) {
+            std::string dir = dirs.back();
+            dirs.pop_back();
+
+            DIR *d = opendir(dir.c_str());
+            if (d == NULL)
+                continue;
+
+            struct dirent *de;
+            while ((de = readdir(d)) != NULL) {
+                if (de->d_name[0] == '.')
+                    continue;
+
+                std::string fpath = dir + "/" + de->d_name;
+
+                struct stat buf;
+                if (stat(fpath.c_str(), &buf) < 0)
+                    continue;
+
+                if (S_ISDIR(buf.st_mode)) {
+                    dirs.push_back(fpath);
+                    continue;
+                }
+
+                if (!S_ISREG(buf.st_mode))
+                    continue;
+
+                // Key the cache by resolved path, the same way the request
+                // path looks entries up
+                char *rp = realpath(fpath.c_str(), NULL);
+                if (rp == NULL)
+                    continue;
+
+                std::string resolved(rp);
+                free(rp);
+
+                // Suffix of the real asset name, skipping a precompressed
+                // wrapper, drives the mime lookup
+                std::string sfile(de->d_name);
+                if (sfile.length() > 3 &&
+                        sfile.compare(sfile.length() - 3, 3, ".gz") == 0)
+                    sfile = sfile.substr(0, sfile.length() - 3);
+
+                if (FetchStaticCacheEntry(resolved, GetSuffix(sfile)) != NULL)
+                    mapped++;
+            }
+
+            closedir(d);
+        }
+    }
+
+    if (mapped != 0)
+        _MSG("Pre-mapped " + UIntToString(mapped) + " static web assets",
+                MSGFLAG_INFO);
+}
+
+void Kis_Net_Httpd::AppendStaticCacheHeaders(struct MHD_Response *response) {
+    // Static assets carry a mtime-validated Last-Modified, so let the
+    // browser cache them for a while and revalidate with 304s; dynamic
+    // content keeps the historical no-cache headers
+    if (static_cache_time != 0) {
+        std::string cc = "max-age=" + UIntToString(static_cache_time);
+        MHD_add_response_header(response, "Cache-Control", cc.c_str());
+    } else {
+        MHD_add_response_header(response, "Cache-Control", "no-cache");
+        MHD_add_response_header(response, "Pragma", "no-cache");
+        MHD_add_response_header(response,
+                "Expires", "Sat, 01 Jan 2000 00:00:00 GMT");
+    }
+}
+
 std::string Kis_Net_Httpd::GetMimeType(std::string ext) {
     std::map<std::string, std::string>::iterator mi = mime_type_map.find(ext);
     if (mi != mime_type_map.end()) {
@@ -728,12 +1059,104 @@ int Kis_Net_Httpd::handle_static_file(void *cls, Kis_Net_Httpd_Connection *conne
             continue;
         }
 
-        // The path is resolved, try to open the file
-        FILE *f = fopen(modified_realpath, "rb");
+        std::string resolved(modified_realpath);
 
         free(modified_realpath);
         free(base_realpath);
 
+        std::string suffix = GetSuffix(surl);
+
+        // Serve out of the mmap cache whenever possible; if the client
+        // accepts gzip and a precompressed variant was installed next to
+        // the asset, prefer that
+        std::shared_ptr<static_file_cache_entry> cache_entry;
+        bool gzipped = false;
+
+        const char *accept_enc =
+            MHD_lookup_connection_value(connection->connection, MHD_HEADER_KIND,
+                    "Accept-Encoding");
+
+        if (accept_enc != NULL && strstr(accept_enc, "gzip") != NULL) {
+            cache_entry = kishttpd->FetchStaticCacheEntry(resolved + ".gz", suffix);
+            gzipped = (cache_entry != NULL);
+        }
+
+        if (cache_entry == NULL)
+            cache_entry = kishttpd->FetchStaticCacheEntry(resolved, suffix);
+
+        if (cache_entry != NULL) {
+            // Revalidation; browsers echo back the exact Last-Modified
+            // string, so a string compare is enough to answer 304 without
+            // touching the mapping
+            const char *if_mod =
+                MHD_lookup_connection_value(connection->connection,
+                        MHD_HEADER_KIND, "If-Modified-Since");
+
+            if (if_mod != NULL && cache_entry->last_modified == if_mod) {
+                struct MHD_Response *response =
+                    MHD_create_response_from_buffer(0, NULL,
+                            MHD_RESPMEM_PERSISTENT);
+
+                if (response != NULL) {
+                    MHD_add_response_header(response, "Last-Modified",
+                            cache_entry->last_modified.c_str());
+                    kishttpd->AppendStaticCacheHeaders(response);
+
+                    MHD_queue_response(connection->connection,
+                            MHD_HTTP_NOT_MODIFIED, response);
+                    MHD_destroy_response(response);
+
+                    return 1;
+                }
+            }
+
+            cached_file_reader_state *state = new cached_file_reader_state();
+            state->entry = cache_entry;
+            state->data = (const char *) cache_entry->map;
+            state->len = cache_entry->len;
+
+            struct MHD_Response *response =
+                MHD_create_response_from_callback(cache_entry->len, 32 * 1024,
+                        &cached_file_reader, state, &cached_file_free_callback);
+
+            if (response == NULL) {
+                delete state;
+                return -1;
+            }
+
+            if (connection->session != NULL) {
+                std::stringstream cookiestr;
+
+                cookiestr << KIS_SESSION_COOKIE << "=";
+                cookiestr << connection->session->sessionid;
+                cookiestr << "; Path=/";
+
+                MHD_add_response_header(response, MHD_HTTP_HEADER_SET_COOKIE,
+                        cookiestr.str().c_str());
+            }
+
+            MHD_add_response_header(response, "Last-Modified",
+                    cache_entry->last_modified.c_str());
+            MHD_add_response_header(response, "Content-Type",
+                    cache_entry->mimetype.c_str());
+
+            if (gzipped)
+                MHD_add_response_header(response, "Content-Encoding", "gzip");
+
+            // Allow any?
+            MHD_add_response_header(response, "Access-Control-Allow-Origin", "*");
+
+            kishttpd->AppendStaticCacheHeaders(response);
+
+            MHD_queue_response(connection->connection, MHD_HTTP_OK, response);
+            MHD_destroy_response(response);
+
+            return 1;
+        }
+
+        // Fall back to streaming the file from disk if it couldn't be mapped
+        FILE *f = fopen(resolved.c_str(), "rb");
+
         if (f != NULL) {
             struct MHD_Response *response;
             struct stat buf;
@@ -784,12 +1207,7 @@ int Kis_Net_Httpd::handle_static_file(void *cls, Kis_Net_Httpd_Connection *conne
             // Allow any?
             MHD_add_response_header(response, "Access-Control-Allow-Origin", "*");
 
-            // Never let the browser cache our responses.  Maybe moderate this
-            // in the future to cache for 60 seconds or something?
-            MHD_add_response_header(response, "Cache-Control", "no-cache");
-            MHD_add_response_header(response, "Pragma", "no-cache");
-            MHD_add_response_header(response, 
-                    "Expires", "Sat, 01 Jan 2000 00:00:00 GMT");
+            kishttpd->AppendStaticCacheHeaders(response);
 
             MHD_queue_response(connection->connection, MHD_HTTP_OK, response);
             MHD_destroy_response(response);
@@ -992,12 +1410,9 @@ bool Kis_Net_Httpd::HasValidSession(Kis_Net_Httpd_Connection *connection,
             MHD_COOKIE_KIND, KIS_SESSION_COOKIE);
 
     if (cookieval != NULL) {
-        auto si = session_map.find(cookieval);
-
-        if (si != session_map.end()) {
-
-            s = si->second;
+        s = FindSession(cookieval);
 
+        if (s != NULL) {
             // Does the session never expire?
             if (s->session_lifetime == 0) {
                 connection->session = s;
@@ -1009,7 +1424,7 @@ bool Kis_Net_Httpd::HasValidSession(Kis_Net_Httpd_Connection *connection,
                 connection->session = s;
                 return true;
             } else {
-                DelSession(si);
+                DelSession(s->sessionid);
                 connection->session = NULL;
             }
         }
@@ -1154,6 +1569,11 @@ Kis_Net_Httpd_Buffer_Stream_Aux::Kis_Net_Httpd_Buffer_Stream_Aux(
 
     in_error = false;
 
+    compression_stream = NULL;
+    compression_finished = false;
+
+    streamed_sz = 0;
+
     // If the buffer encounters an error, unlock the variable and set the error state
     ringbuf_handler->SetProtocolErrorCb([this]() {
             trigger_error();
@@ -1184,6 +1604,53 @@ Kis_Net_Httpd_Buffer_Stream_Aux::~Kis_Net_Httpd_Buffer_Stream_Aux() {
         ringbuf_handler->RemoveWriteBufferInterface();
         ringbuf_handler->SetProtocolErrorCb(NULL);
     }
+
+    if (compression_stream != NULL) {
+        deflateEnd(compression_stream);
+        delete compression_stream;
+    }
+}
+
+void Kis_Net_Httpd_Buffer_Stream_Aux::setup_compression() {
+    compression_stream = new z_stream;
+    memset(compression_stream, 0, sizeof(z_stream));
+
+    // windowbits + 16 asks zlib for a gzip wrapper instead of a raw
+    // deflate stream
+    if (deflateInit2(compression_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        delete compression_stream;
+        compression_stream = NULL;
+    }
+}
+
+ssize_t Kis_Net_Httpd_Buffer_Stream_Aux::compress_chunk(char *out, size_t out_sz,
+        unsigned char *in, size_t in_sz, size_t *in_consumed) {
+    compression_stream->next_in = in;
+    compression_stream->avail_in = in_sz;
+    compression_stream->next_out = (unsigned char *) out;
+    compression_stream->avail_out = out_sz;
+
+    // Sync-flush every chunk; it costs a few bytes of ratio but streamed
+    // consumers (like the ekjson pulls) see records as they're generated
+    // instead of waiting out zlib's internal window
+    deflate(compression_stream, Z_SYNC_FLUSH);
+
+    *in_consumed = in_sz - compression_stream->avail_in;
+
+    return (ssize_t) (out_sz - compression_stream->avail_out);
+}
+
+ssize_t Kis_Net_Httpd_Buffer_Stream_Aux::finish_compression(char *out, size_t out_sz) {
+    compression_stream->next_in = NULL;
+    compression_stream->avail_in = 0;
+    compression_stream->next_out = (unsigned char *) out;
+    compression_stream->avail_out = out_sz;
+
+    if (deflate(compression_stream, Z_FINISH) == Z_STREAM_END)
+        compression_finished = true;
+
+    return (ssize_t) (out_sz - compression_stream->avail_out);
 }
 
 void Kis_Net_Httpd_Buffer_Stream_Aux::BufferAvailable(size_t in_amt __attribute__((unused))) {
@@ -1233,8 +1700,9 @@ ssize_t Kis_Net_Httpd_Buffer_Stream_Handler::buffer_event_cb(void *cls, uint64_t
 
     size_t read_sz = 0;
 
-    // Read from the buffer; currently we have to force a copy into our existing
-    // buffer unfortunately
+    // microhttpd's pull model hands us its own buffer to fill, so the
+    // chainbuf-to-MHD copy can't be eliminated outright; instead we
+    // amortize it by draining every ready chunk into one callback pass
     unsigned char *zbuf;
 
     while (read_sz == 0) {
@@ -1249,6 +1717,19 @@ ssize_t Kis_Net_Httpd_Buffer_Stream_Handler::buffer_event_cb(void *cls, uint64_t
             rbh->PeekFreeWriteBufferData(zbuf);
 
             if (stream_aux->get_in_error()) {
+                // If we're compressing, the generator finishing isn't the end
+                // of the stream; we still owe the client the gzip trailer
+                if (stream_aux->compression_stream != NULL &&
+                        !stream_aux->compression_finished) {
+                    ssize_t flushed = stream_aux->finish_compression(buf, max);
+
+                    if (flushed > 0) {
+                        stream_aux->streamed_sz += flushed;
+                        stream_aux->get_buffer_event_mutex()->unlock();
+                        return flushed;
+                    }
+                }
+
                 // fprintf(stderr, "debug - buffer event %p end of stream\n", stream_aux);
                 stream_aux->get_buffer_event_mutex()->unlock();
                 return MHD_CONTENT_READER_END_OF_STREAM;
@@ -1256,16 +1737,74 @@ ssize_t Kis_Net_Httpd_Buffer_Stream_Handler::buffer_event_cb(void *cls, uint64_t
         }
     }
 
-    if (read_sz != 0 && zbuf != NULL && buf != NULL) {
-        memcpy(buf, zbuf, read_sz);
+    if (stream_aux->compression_stream != NULL) {
+        // Compress in place of the copy; feed successive chunks through
+        // deflate until the output buffer fills or the chainbuf runs dry,
+        // so one callback pass drains everything that's ready instead of
+        // one chunk per round trip through microhttpd
+        ssize_t produced_total = 0;
+
+        while (read_sz != 0) {
+            // Deflate may not accept the entire peeked chunk if the output
+            // buffer fills, so only consume what it actually took
+            size_t consumed = 0;
+            ssize_t produced =
+                stream_aux->compress_chunk(buf + produced_total,
+                        max - produced_total, zbuf, read_sz, &consumed);
+
+            rbh->PeekFreeWriteBufferData(zbuf);
+            rbh->ConsumeWriteBufferData(consumed);
+
+            produced_total += produced;
+
+            // Output window filled before the whole chunk went in; the
+            // rest stays buffered for the next callback
+            if (consumed < read_sz || (size_t) produced_total >= max)
+                break;
+
+            read_sz = rbh->ZeroCopyPeekWriteBufferData((void **) &zbuf,
+                    max - produced_total);
+
+            if (read_sz == 0)
+                rbh->PeekFreeWriteBufferData(zbuf);
+        }
+
+        stream_aux->streamed_sz += produced_total;
+
+        stream_aux->get_buffer_event_mutex()->unlock();
+
+        return produced_total;
+    }
+
+    // The chainbuf only exposes the remainder of the current chunk per
+    // peek, so keep pulling chunks until microhttpd's buffer is full or
+    // the stream runs dry; one callback pass then covers the whole batch
+    // the serializer produced instead of one socket write per chunk
+    size_t copied_total = 0;
+
+    while (read_sz != 0) {
+        memcpy(buf + copied_total, zbuf, read_sz);
+
+        rbh->PeekFreeWriteBufferData(zbuf);
+        rbh->ConsumeWriteBufferData(read_sz);
+
+        copied_total += read_sz;
+
+        if (copied_total >= max)
+            break;
+
+        read_sz = rbh->ZeroCopyPeekWriteBufferData((void **) &zbuf,
+                max - copied_total);
+
+        if (read_sz == 0)
+            rbh->PeekFreeWriteBufferData(zbuf);
     }
 
-    rbh->PeekFreeWriteBufferData(zbuf);
-    rbh->ConsumeWriteBufferData(read_sz);
+    stream_aux->streamed_sz += copied_total;
 
     stream_aux->get_buffer_event_mutex()->unlock();
 
-    return (ssize_t) read_sz;
+    return (ssize_t) copied_total;
 }
 
 static void free_buffer_aux_callback(void *cls) {
@@ -1276,6 +1815,10 @@ static void free_buffer_aux_callback(void *cls) {
     // Wait for the thread to complete
     aux->generator_thread.join();
 
+    // Credit the bytes we moved to the endpoint metrics
+    if (aux->metrics != NULL)
+        aux->metrics->bytes_sent += aux->streamed_sz;
+
     // fprintf(stderr, "debug - generator unlocked %p\n", cls);
 
     if (aux->free_aux_cb != NULL) {
@@ -1298,12 +1841,41 @@ int Kis_Net_Httpd_Buffer_Stream_Handler::Httpd_HandleGetRequest(Kis_Net_Httpd *h
     std::lock_guard<std::mutex> lk(connection->connection_mutex);
 
     if (connection->response == NULL) {
+        // If the handler can produce a strong validator for this URL,
+        // answer a matching conditional poll with an empty 304 before any
+        // generator thread or serialization gets spun up
+        std::string etag;
+        if (Httpd_GetETag(connection, url, etag)) {
+            const char *inm =
+                MHD_lookup_connection_value(connection->connection,
+                        MHD_HEADER_KIND, "If-None-Match");
+
+            if (inm != NULL && etag == std::string(inm)) {
+                connection->response =
+                    MHD_create_response_from_buffer(0, NULL, MHD_RESPMEM_PERSISTENT);
+                MHD_add_response_header(connection->response, "ETag", etag.c_str());
+                connection->httpcode = MHD_HTTP_NOT_MODIFIED;
+
+                return httpd->SendStandardHttpResponse(httpd, connection, url);
+            }
+        }
+
         std::shared_ptr<BufferHandlerGeneric> rbh(allocate_buffer());
 
-        Kis_Net_Httpd_Buffer_Stream_Aux *aux = 
+        Kis_Net_Httpd_Buffer_Stream_Aux *aux =
             new Kis_Net_Httpd_Buffer_Stream_Aux(this, connection, rbh, NULL, NULL);
         connection->custom_extension = aux;
 
+        // If the client takes compressed data, transparently gzip the stream
+        // as chunks pass from the buffer to the webserver
+        const char *accept_enc =
+            MHD_lookup_connection_value(connection->connection, MHD_HEADER_KIND,
+                    "Accept-Encoding");
+        if (accept_enc != NULL && strstr(accept_enc, "gzip") != NULL)
+            aux->setup_compression();
+
+        aux->metrics = httpd->FetchEndpointMetrics(Kis_Net_Httpd::StripSuffix(url));
+
         // Set up a locker to make sure the thread is up and running
         conditional_locker<int> cl;
         cl.lock();
@@ -1332,10 +1904,17 @@ int Kis_Net_Httpd_Buffer_Stream_Handler::Httpd_HandleGetRequest(Kis_Net_Httpd *h
 
         cl.block_until();
 
-        connection->response = 
+        connection->response =
             MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, 32 * 1024,
                     &buffer_event_cb, aux, &free_buffer_aux_callback);
 
+        // Stamp the validator so the next poll can be answered conditionally
+        if (etag != "")
+            MHD_add_response_header(connection->response, "ETag", etag.c_str());
+
+        if (aux->compression_stream != NULL)
+            MHD_add_response_header(connection->response, "Content-Encoding", "gzip");
+
         return httpd->SendStandardHttpResponse(httpd, connection, url);
     }
 
@@ -1362,6 +1941,16 @@ int Kis_Net_Httpd_Buffer_Stream_Handler::Httpd_HandlePostRequest(Kis_Net_Httpd *
 
         // fprintf(stderr, "debug - made post aux %p\n", aux);
 
+        // Post responses compress the same way the get stream does; the big
+        // field-filtered device pulls from the UI arrive as posts
+        const char *accept_enc =
+            MHD_lookup_connection_value(connection->connection, MHD_HEADER_KIND,
+                    "Accept-Encoding");
+        if (accept_enc != NULL && strstr(accept_enc, "gzip") != NULL)
+            aux->setup_compression();
+
+        aux->metrics = httpd->FetchEndpointMetrics(Kis_Net_Httpd::StripSuffix(url));
+
         // Call the post complete and populate our stream;
         // Run it in its own thread and set up the connection streaming object; we MUST pass
         // the aux as a direct pointer because the microhttpd backend can delete the 
@@ -1387,13 +1976,68 @@ int Kis_Net_Httpd_Buffer_Stream_Handler::Httpd_HandlePostRequest(Kis_Net_Httpd *
 
         cl.block_until();
 
-        connection->response = 
+        connection->response =
             MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, 32 * 1024,
                     &buffer_event_cb, aux, &free_buffer_aux_callback);
 
+        if (aux->compression_stream != NULL)
+            MHD_add_response_header(connection->response, "Content-Encoding", "gzip");
+
         return httpd->SendStandardHttpResponse(httpd, connection, url);
     }
 
     return MHD_NO;
 }
 
+
+bool Kis_Net_Httpd_Metrics_Endpoint::Httpd_VerifyPath(const char *path, const char *method) {
+    if (strcmp(method, "GET") != 0)
+        return false;
+
+    if (strcmp(path, "/httpd/endpoint_metrics.json") == 0)
+        return true;
+
+    return false;
+}
+
+void Kis_Net_Httpd_Metrics_Endpoint::Httpd_CreateStreamResponse(Kis_Net_Httpd *httpd,
+        Kis_Net_Httpd_Connection *connection __attribute__((unused)),
+        const char *url, const char *method __attribute__((unused)),
+        const char *upload_data __attribute__((unused)),
+        size_t *upload_data_size __attribute__((unused)),
+        std::stringstream &stream) {
+
+    if (strcmp(url, "/httpd/endpoint_metrics.json") != 0)
+        return;
+
+    auto metrics = httpd->FetchAllEndpointMetrics();
+
+    // Hand-built json; the uris are dynamic keys so this doesn't map onto
+    // the tracked-element serializers
+    stream << "{";
+
+    bool first = true;
+
+    for (auto mi : metrics) {
+        if (!first)
+            stream << ",";
+        first = false;
+
+        std::string uri = MultiReplaceAll(mi.first, "\\", "\\\\");
+        uri = MultiReplaceAll(uri, "\"", "\\\"");
+
+        stream << "\"" << uri << "\": {";
+        stream << "\"hits\": " << mi.second->hits.load() << ",";
+        stream << "\"bytes\": " << mi.second->bytes_sent.load() << ",";
+        stream << "\"latency_usec_total\": " << mi.second->total_usec.load() << ",";
+        stream << "\"latency_histogram\": {";
+        stream << "\"lt_1ms\": " << mi.second->latency_histo[0].load() << ",";
+        stream << "\"lt_10ms\": " << mi.second->latency_histo[1].load() << ",";
+        stream << "\"lt_100ms\": " << mi.second->latency_histo[2].load() << ",";
+        stream << "\"lt_1s\": " << mi.second->latency_histo[3].load() << ",";
+        stream << "\"ge_1s\": " << mi.second->latency_histo[4].load();
+        stream << "}}";
+    }
+
+    stream << "}";
+}
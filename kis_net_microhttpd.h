@@ -29,6 +29,9 @@
 #include <algorithm>
 #include <string>
 #include <sstream>
+#include <unordered_map>
+#include <atomic>
+#include <sys/time.h>
 #include <microhttpd.h>
 #include <memory>
 
@@ -42,6 +45,7 @@
 class Kis_Net_Httpd;
 class Kis_Net_Httpd_Session;
 class Kis_Net_Httpd_Connection;
+class Kis_Net_Httpd_Endpoint_Metrics;
 
 class EntryTracker;
 
@@ -71,6 +75,17 @@ public:
     // Can this handler process this request?
     virtual bool Httpd_VerifyPath(const char *path, const char *method) = 0;
 
+    // Optionally provide a strong validator (ETag) for a GET of this URL;
+    // handlers which can compute one cheaply - typically from a generation
+    // counter - return true and fill in_tag, and a conditional request
+    // carrying a matching If-None-Match is answered with an empty 304
+    // before any serialization happens
+    virtual bool Httpd_GetETag(Kis_Net_Httpd_Connection *connection __attribute__((unused)),
+            const char *url __attribute__((unused)),
+            std::string& in_tag __attribute__((unused))) {
+        return false;
+    }
+
     // Shortcut to checking if the serializer can handle this, since most
     // endpoints will be implementing serialization
     virtual bool Httpd_CanSerialize(std::string path);
@@ -259,7 +274,14 @@ public:
 
 protected:
     virtual std::shared_ptr<BufferHandlerGeneric> allocate_buffer() {
-        return std::static_pointer_cast<BufferHandlerGeneric>(std::shared_ptr<BufferHandler<RingbufV2> >(new BufferHandler<RingbufV2>(0, k_n_h_r_ringbuf_size)));
+        // Start each connection small and let the ring double on write
+        // pressure up to the policy ceiling, so a client which keeps up
+        // never costs more than the initial allocation and a lagging one
+        // costs memory proportional to its actual backlog
+        return std::static_pointer_cast<BufferHandlerGeneric>(
+                std::shared_ptr<BufferHandler<RingbufV2> >(
+                    new BufferHandler<RingbufV2>(NULL,
+                        new RingbufV2(128 * 1024, k_n_h_r_ringbuf_size))));
     }
 };
 
@@ -279,6 +301,10 @@ protected:
 
 };
 
+// Forward def of the zlib stream state so we don't need zlib.h in every
+// consumer of this header
+struct z_stream_s;
+
 // A buffer-stream auxiliary class which is passed to the callback, added to the
 // connection record.  This holds the per-connection states.
 //
@@ -348,6 +374,23 @@ public:
         return &buffer_event_mutex;
     }
 
+    // Start compressing the stream; called during connection setup when the
+    // client negotiates gzip.  The deflate context is reused for every chunk
+    // of the connection.  Silently does nothing if zlib can't initialize,
+    // leaving the stream uncompressed
+    void setup_compression();
+
+    // Compress a chunk of stream data from the buffer into the webserver's
+    // output buffer, sync-flushed so streamed consumers see records as
+    // they're generated; fills in_consumed with the amount of input actually
+    // accepted and returns the compressed size
+    ssize_t compress_chunk(char *out, size_t out_sz, unsigned char *in,
+            size_t in_sz, size_t *in_consumed);
+
+    // Emit the gzip trailer once the generator has finished; may be called
+    // repeatedly until compression_finished is set
+    ssize_t finish_compression(char *out, size_t out_sz);
+
 public:
     kis_recursive_timed_mutex aux_mutex;
     kis_recursive_timed_mutex error_mutex;
@@ -378,10 +421,40 @@ public:
     // Free function
     std::function<void (Kis_Net_Httpd_Buffer_Stream_Aux *)> free_aux_cb;
 
-    // Sync function; called to make sure the buffer is flushed and fully synced 
+    // Sync function; called to make sure the buffer is flushed and fully synced
     // prior to flagging it complete
     std::function<void (Kis_Net_Httpd_Buffer_Stream_Aux *)> sync_cb;
-    
+
+    // Per-connection compression state; NULL when the stream is uncompressed
+    struct z_stream_s *compression_stream;
+
+    // Gzip trailer has been emitted
+    bool compression_finished;
+
+    // Bytes handed to the webserver, credited to the endpoint metrics when
+    // the stream is torn down
+    uint64_t streamed_sz;
+    std::shared_ptr<Kis_Net_Httpd_Endpoint_Metrics> metrics;
+
+};
+
+// Reporting endpoint for the per-uri request metrics, as
+// /httpd/endpoint_metrics.json
+class Kis_Net_Httpd_Metrics_Endpoint : public Kis_Net_Httpd_CPPStream_Handler {
+public:
+    Kis_Net_Httpd_Metrics_Endpoint() : Kis_Net_Httpd_CPPStream_Handler() { }
+
+    Kis_Net_Httpd_Metrics_Endpoint(GlobalRegistry *in_globalreg) :
+        Kis_Net_Httpd_CPPStream_Handler(in_globalreg) { }
+
+    virtual ~Kis_Net_Httpd_Metrics_Endpoint() { }
+
+    virtual bool Httpd_VerifyPath(const char *path, const char *method);
+
+    virtual void Httpd_CreateStreamResponse(Kis_Net_Httpd *httpd,
+            Kis_Net_Httpd_Connection *connection,
+            const char *url, const char *method, const char *upload_data,
+            size_t *upload_data_size, std::stringstream &stream);
 };
 
 
@@ -400,6 +473,8 @@ public:
         httpcode = 200;
         postprocessor = NULL;
         post_complete = false;
+        post_bytes = 0;
+        post_too_large = false;
         connection_type = CONNECTION_GET;
         httpd = NULL;
         httpdhandler = NULL;
@@ -430,6 +505,12 @@ public:
     // Is the post complete?
     bool post_complete;
 
+    // Running total of POST body bytes cached, and whether the body blew
+    // through the configured limit; a too-large request is answered with
+    // a 413 instead of being buffered
+    size_t post_bytes;
+    bool post_too_large;
+
     // Type of request/connection
     int connection_type;
 
@@ -451,6 +532,9 @@ public:
     // Custom arbitrary value inserted by other processors
     void *custom_extension;
 
+    // When the request began, for the endpoint metrics
+    struct timeval request_start;
+
     // Integrity locker
     std::mutex connection_mutex;
 };
@@ -470,6 +554,43 @@ public:
     time_t session_lifetime;
 };
 
+// Per-endpoint request metrics; plain atomics bumped from the request
+// threads with no locking, with latency folded into a coarse log-scale
+// histogram so we can see which endpoints are expensive without the
+// accounting itself costing anything
+class Kis_Net_Httpd_Endpoint_Metrics {
+public:
+    // Number of latency buckets; bounds are <1ms, <10ms, <100ms, <1s,
+    // and everything slower
+    const static int latency_buckets = 5;
+
+    Kis_Net_Httpd_Endpoint_Metrics() :
+        hits(0), bytes_sent(0), total_usec(0) {
+        for (int x = 0; x < latency_buckets; x++)
+            latency_histo[x].store(0);
+    }
+
+    void RecordLatency(uint64_t in_usec) {
+        total_usec += in_usec;
+
+        if (in_usec < 1000)
+            latency_histo[0]++;
+        else if (in_usec < 10000)
+            latency_histo[1]++;
+        else if (in_usec < 100000)
+            latency_histo[2]++;
+        else if (in_usec < 1000000)
+            latency_histo[3]++;
+        else
+            latency_histo[4]++;
+    }
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> bytes_sent;
+    std::atomic<uint64_t> total_usec;
+    std::atomic<uint64_t> latency_histo[latency_buckets];
+};
+
 class Kis_Httpd_Websession;
 
 class Kis_Net_Httpd : public LifetimeGlobal {
@@ -538,6 +659,16 @@ public:
     static void MHD_Panic(void *cls, const char *file, unsigned int line,
             const char *reason);
 
+    // Fetch (creating if necessary) the metrics record for an endpoint;
+    // uris are aggregated with the serializer suffix stripped.  The table
+    // is capped so key-per-url endpoints can't grow it without bound;
+    // overflow lands in a single catch-all record
+    std::shared_ptr<Kis_Net_Httpd_Endpoint_Metrics> FetchEndpointMetrics(std::string in_uri);
+
+    // Copy of the metrics table, for the reporting endpoint
+    std::map<std::string, std::shared_ptr<Kis_Net_Httpd_Endpoint_Metrics> >
+        FetchAllEndpointMetrics();
+
 protected:
     GlobalRegistry *globalreg;
 
@@ -571,6 +702,41 @@ protected:
 
     std::vector<static_dir> static_dir_vec;
 
+    // An mmap'd static asset with its precomputed headers; cached for the
+    // life of the server and refreshed when the file changes on disk, so
+    // UI loads serve straight from the page cache instead of re-reading
+    // files per request
+    class static_file_cache_entry {
+    public:
+        static_file_cache_entry() :
+            map(NULL), len(0), mtime(0) { }
+        ~static_file_cache_entry();
+
+        void *map;
+        size_t len;
+        time_t mtime;
+
+        // Preformatted headers
+        std::string last_modified;
+        std::string mimetype;
+    };
+
+    // Fetch (mapping if necessary) the cache record for a resolved file
+    // path; in_suffix drives the mime lookup.  Returns NULL if the file
+    // can't be mapped, in which case the caller falls back to streaming it
+    // from disk.  Called with the controller mutex held
+    std::shared_ptr<static_file_cache_entry> FetchStaticCacheEntry(std::string in_path,
+            std::string in_suffix);
+
+    std::unordered_map<std::string,
+        std::shared_ptr<static_file_cache_entry> > static_file_cache;
+
+    // Endpoint metrics, keyed by suffix-stripped uri; the mutex guards
+    // only table insertion, the counters themselves are atomic
+    kis_recursive_timed_mutex metrics_mutex;
+    std::unordered_map<std::string,
+        std::shared_ptr<Kis_Net_Httpd_Endpoint_Metrics> > endpoint_metrics_map;
+
     kis_recursive_timed_mutex controller_mutex;
 
     // Handle the requests and dispatch to controllers
@@ -596,8 +762,26 @@ protected:
     void DelSession(std::map<std::string, std::shared_ptr<Kis_Net_Httpd_Session> >::iterator in_itr);
     void WriteSessions();
 
+    // Probe the read-mostly session snapshot for a token; a single
+    // unlocked hash lookup on the per-request path.  Expiry is handled by
+    // the callers, which have different lifetime semantics
+    std::shared_ptr<Kis_Net_Httpd_Session> FindSession(const std::string& in_token);
+
+    // Rebuild the session snapshot from the master map; called under the
+    // controller mutex by anything which changes the session list
+    void RebuildSessionCache();
+
     std::map<std::string, std::shared_ptr<Kis_Net_Httpd_Session> > session_map;
 
+    typedef std::unordered_map<std::string,
+        std::shared_ptr<Kis_Net_Httpd_Session> > session_cache_map;
+
+    // Immutable snapshot of the session map, swapped atomically whenever
+    // sessions change; request threads probe it without taking the
+    // controller mutex.  Sessions change orders of magnitude less often
+    // than they're checked
+    std::shared_ptr<const session_cache_map> session_cache;
+
     bool store_sessions;
     std::string sessiondb_file;
     ConfigFile *session_db;
@@ -605,6 +789,23 @@ protected:
     std::shared_ptr<Kis_Httpd_Websession> websession;
     unsigned int session_timeout;
 
+    // Maximum POST body size cached through the default variable
+    // processing, 0 for unlimited; handlers which stream their input
+    // through Httpd_PostIterator are not subject to it
+    size_t post_body_limit;
+
+    // Browser cache lifetime for static assets in seconds; 0 restores
+    // the historical no-cache behavior.  Dynamic content is never
+    // browser-cached regardless
+    unsigned int static_cache_time;
+
+    // Walk the registered static dirs and map every asset into the cache,
+    // called once at server startup
+    void PreloadStaticCache();
+
+    // Tag a static asset response with the configured cache policy
+    void AppendStaticCacheHeaders(struct MHD_Response *response);
+
 };
 
 #endif
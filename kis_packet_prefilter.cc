@@ -0,0 +1,170 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include "configfile.h"
+#include "globalregistry.h"
+#include "messagebus.h"
+#include "packet.h"
+#include "packetchain.h"
+#include "packet_ieee80211.h"
+#include "kis_packet_prefilter.h"
+
+int kis_prefilter_packethook(CHAINCALL_PARMS) {
+	return ((Kis_Packet_Prefilter *) auxdata)->HandlePacket(in_pack);
+}
+
+Kis_Packet_Prefilter::Kis_Packet_Prefilter(GlobalRegistry *in_globalreg) {
+	globalreg = in_globalreg;
+
+	globalreg->InsertGlobal("PACKET_PREFILTER",
+			std::shared_ptr<Kis_Packet_Prefilter>(this));
+
+	// Run after the DLT handlers (priority 0) have de-encapsulated the
+	// link frame, but ahead of every dissection stage
+	chainid =
+		globalreg->packetchain->RegisterHandler(&kis_prefilter_packethook, this,
+				CHAINPOS_POSTCAP, 100);
+
+	pack_comp_linkframe =
+		globalreg->packetchain->RegisterPacketComponent("LINKFRAME");
+	pack_comp_decap =
+		globalreg->packetchain->RegisterPacketComponent("DECAP");
+
+	num_ignore_macs = 0;
+
+	std::vector<std::string> ignorelines =
+		globalreg->kismet_config->FetchOptVec("prefilter_ignore_mac");
+	for (unsigned int il = 0; il < ignorelines.size(); il++) {
+		mac_addr ma = mac_addr(ignorelines[il]);
+
+		if (ma.error) {
+			_MSG("Invalid prefilter_ignore_mac line '" + ignorelines[il] + "' "
+				 "in the Kismet config file, expected a MAC address or "
+				 "MAC/mask pair.", MSGFLAG_FATAL);
+			globalreg->fatal_condition = 1;
+			return;
+		}
+
+		ignore_macs.insert(ma, 1);
+		num_ignore_macs++;
+	}
+
+	if (num_ignore_macs > 0)
+		_MSG("Pre-filtering frames from " + IntToString(num_ignore_macs) +
+			 " ignored transmitter MACs before dissection", MSGFLAG_INFO);
+
+	// Set up the de-duplication ring
+	recent_packet_checksums_sz =
+		globalreg->kismet_config->FetchOptUInt("packet_dedup_size", 2048);
+	recent_packet_checksums = new dedup_entry[recent_packet_checksums_sz];
+	for (unsigned int x = 0; x < recent_packet_checksums_sz; x++) {
+		recent_packet_checksums[x].csum = 0;
+		recent_packet_checksums[x].ts = 0;
+	}
+	recent_packet_checksum_pos = 0;
+
+	dedup_window =
+		globalreg->kismet_config->FetchOptInt("packet_dedup_window", 2);
+}
+
+Kis_Packet_Prefilter::~Kis_Packet_Prefilter() {
+	globalreg->packetchain->RemoveHandler(chainid, CHAINPOS_POSTCAP);
+	globalreg->RemoveGlobal("PACKET_PREFILTER");
+
+	delete[] recent_packet_checksums;
+}
+
+int Kis_Packet_Prefilter::HandlePacket(kis_packet *in_pack) {
+	if (in_pack->error || in_pack->filtered)
+		return 0;
+
+	kis_datachunk *chunk =
+		(kis_datachunk *) in_pack->fetch(pack_comp_decap);
+
+	if (chunk == NULL)
+		chunk = (kis_datachunk *) in_pack->fetch(pack_comp_linkframe);
+
+	if (chunk == NULL)
+		return 0;
+
+	// We only know how to sanity-check dot11 frames
+	if (chunk->dlt != KDLT_IEEE802_11)
+		return 0;
+
+	// The shortest legal frame is a 10 byte CTS/ACK control header; a
+	// shorter runt can never carry state, so don't bother dissecting it
+	if (chunk->length < 10) {
+		in_pack->error = 1;
+		return 0;
+	}
+
+	frame_control *fc = (frame_control *) chunk->data;
+
+	// The only defined protocol version is 0; anything else is garbage
+	// the dissector would only flag as corrupt anyhow
+	if (fc->version != 0) {
+		in_pack->error = 1;
+		return 0;
+	}
+
+	// Frames long enough to carry a transmitter address get checked
+	// against the ignore list; addr2 is the transmitter for management
+	// and data frames alike
+	if (num_ignore_macs > 0 && chunk->length >= 16) {
+		mac_addr txmac = mac_addr(&(chunk->data[10]), MAC_LEN_MAX);
+
+		if (ignore_macs.find(txmac) != ignore_macs.end()) {
+			in_pack->filtered = 1;
+			return 0;
+		}
+	}
+
+	// Compare the checksum of the frame body against copies recently heard
+	// by any datasource; with overlapping radios on the same channel the
+	// same beacon arrives several times, and only the first copy should
+	// pay for dissection, classification, and logging
+	if (recent_packet_checksums_sz > 0) {
+		uint32_t chunk_csum =
+			Adler32Checksum((const char *) chunk->data, chunk->length);
+
+		local_locker lock(&dedup_mutex);
+
+		for (unsigned int c = 0; c < recent_packet_checksums_sz; c++) {
+			if (recent_packet_checksums[c].csum == 0)
+				break;
+
+			if (recent_packet_checksums[c].csum == chunk_csum &&
+					in_pack->ts.tv_sec - recent_packet_checksums[c].ts <=
+					dedup_window) {
+				in_pack->filtered = 1;
+				in_pack->duplicate = 1;
+				return 0;
+			}
+		}
+
+		unsigned int slot =
+			(recent_packet_checksum_pos++ % recent_packet_checksums_sz);
+		recent_packet_checksums[slot].csum = chunk_csum;
+		recent_packet_checksums[slot].ts = in_pack->ts.tv_sec;
+	}
+
+	return 1;
+}
+
@@ -0,0 +1,75 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __KIS_PACKET_PREFILTER_H__
+#define __KIS_PACKET_PREFILTER_H__
+
+#include "config.h"
+
+#include "globalregistry.h"
+#include "macaddr.h"
+#include "packet.h"
+#include "packetchain.h"
+
+// Early-reject prefilter which runs at the end of the post-capture stage,
+// after the DLT handlers have de-encapsulated the link frame but before
+// any dissection happens.  Frames which can never create state - runts
+// too short to hold a header, frames with a bogus protocol version, and
+// frames transmitted by a MAC on the ignore list - are flagged here so
+// the dissector and classifier stages skip them entirely.
+class Kis_Packet_Prefilter : public SharedGlobalData {
+public:
+	Kis_Packet_Prefilter() {
+		fprintf(stderr, "FATAL OOPS: Kis_Packet_Prefilter()\n");
+		exit(1);
+	}
+
+	Kis_Packet_Prefilter(GlobalRegistry *in_globalreg);
+
+	virtual int HandlePacket(kis_packet *in_pack);
+
+	~Kis_Packet_Prefilter();
+
+protected:
+	GlobalRegistry *globalreg;
+
+	int chainid;
+
+	int pack_comp_linkframe, pack_comp_decap;
+
+	// Transmitter MACs (with optional masks) we discard before dissection
+	macmap<int> ignore_macs;
+	int num_ignore_macs;
+
+	// Ring of recently seen frame checksums for cross-datasource
+	// de-duplication; overlapping radios hear the same frame multiple
+	// times, so fold copies seen inside the dedup window into the first
+	struct dedup_entry {
+		uint32_t csum;
+		time_t ts;
+	};
+
+	kis_recursive_timed_mutex dedup_mutex;
+	dedup_entry *recent_packet_checksums;
+	size_t recent_packet_checksums_sz;
+	unsigned int recent_packet_checksum_pos;
+	int dedup_window;
+};
+
+#endif
+
@@ -0,0 +1,70 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include "kis_perfcounter.h"
+
+PerfCounterRegistry::PerfCounterRegistry(GlobalRegistry *in_globalreg) {
+    globalreg = in_globalreg;
+}
+
+PerfCounterRegistry::~PerfCounterRegistry() {
+    local_eol_locker lock(&counter_mutex);
+
+    globalreg->RemoveGlobal("PERFCOUNTERS");
+
+    counter_map.clear();
+}
+
+void PerfCounterRegistry::RegisterCounter(std::string in_name,
+        std::string in_description, perf_counter_type in_type,
+        std::function<uint64_t ()> in_fetch) {
+    local_locker lock(&counter_mutex);
+
+    perf_counter_record rec;
+    rec.name = in_name;
+    rec.description = in_description;
+    rec.type = in_type;
+    rec.fetch = in_fetch;
+
+    counter_map[in_name] = rec;
+}
+
+void PerfCounterRegistry::RemoveCounter(std::string in_name) {
+    local_locker lock(&counter_mutex);
+
+    auto i = counter_map.find(in_name);
+
+    if (i != counter_map.end())
+        counter_map.erase(i);
+}
+
+std::vector<PerfCounterRegistry::perf_counter_record>
+PerfCounterRegistry::FetchCounters() {
+    local_locker lock(&counter_mutex);
+
+    std::vector<perf_counter_record> ret;
+    ret.reserve(counter_map.size());
+
+    for (auto i : counter_map)
+        ret.push_back(i.second);
+
+    return ret;
+}
+
@@ -0,0 +1,95 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __KIS_PERFCOUNTER_H__
+#define __KIS_PERFCOUNTER_H__
+
+#include "config.h"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "globalregistry.h"
+#include "kis_mutex.h"
+
+/* Registry of internal engine health counters.
+ *
+ * Subsystems own their counters - typically a std::atomic they already
+ * update lock-free on the hot path - and publish them here with a fetch
+ * callback; nothing on the hot path ever touches the registry or a lock.
+ * Systemmonitor samples the registry once a second, records each counter
+ * into an RRD, and serializes everything under the /system/status
+ * endpoint, so external monitoring can graph and alert on queue depths
+ * and drop counts before packets are lost.
+ *
+ * Counters are monotonically increasing totals (alert on the rate);
+ * gauges are instantaneous values like queue depth (alert on the level).
+ */
+
+class PerfCounterRegistry : public LifetimeGlobal {
+public:
+    static std::shared_ptr<PerfCounterRegistry>
+        create_perfcounters(GlobalRegistry *in_globalreg) {
+        std::shared_ptr<PerfCounterRegistry> mon(new PerfCounterRegistry(in_globalreg));
+        in_globalreg->RegisterLifetimeGlobal(mon);
+        in_globalreg->InsertGlobal("PERFCOUNTERS", mon);
+        return mon;
+    }
+
+    enum perf_counter_type {
+        PERF_COUNTER = 0,
+        PERF_GAUGE = 1
+    };
+
+    struct perf_counter_record {
+        std::string name;
+        std::string description;
+        perf_counter_type type;
+        std::function<uint64_t ()> fetch;
+    };
+
+private:
+    PerfCounterRegistry(GlobalRegistry *in_globalreg);
+
+public:
+    virtual ~PerfCounterRegistry();
+
+    // Publish a counter; the fetch callback is invoked from the
+    // monitoring timer, never from the publishing subsystem's hot path.
+    // Re-registering a name replaces the previous record
+    void RegisterCounter(std::string in_name, std::string in_description,
+            perf_counter_type in_type, std::function<uint64_t ()> in_fetch);
+
+    // Withdraw a counter, for subsystems which shut down early
+    void RemoveCounter(std::string in_name);
+
+    // Snapshot of the registered counters for sampling
+    std::vector<perf_counter_record> FetchCounters();
+
+protected:
+    GlobalRegistry *globalreg;
+
+    kis_recursive_timed_mutex counter_mutex;
+
+    std::map<std::string, perf_counter_record> counter_map;
+};
+
+#endif
+
@@ -41,6 +41,9 @@ KisPPILogfile::KisPPILogfile(GlobalRegistry *in_globalreg, SharedLogBuilder in_b
 	dumper = NULL;
     dump_filep = NULL;
 
+    dump_scratch = NULL;
+    dump_scratch_sz = 0;
+
     pack_comp_80211 = globalreg->packetchain->RegisterPacketComponent("PHY80211");
     pack_comp_mangleframe = globalreg->packetchain->RegisterPacketComponent("MANGLEDATA");
     pack_comp_radiodata = globalreg->packetchain->RegisterPacketComponent("RADIODATA");
@@ -81,6 +84,10 @@ bool KisPPILogfile::Log_Open(std::string in_path) {
     // Close it on exec
     fcntl(fileno(dump_filep), F_SETFL, fcntl(fileno(dump_filep), F_GETFL, 0) | O_CLOEXEC);
 
+    // Give stdio a large write buffer so per-packet dumps batch into big
+    // sequential writes instead of hitting the storage device per record
+    setvbuf(dump_filep, NULL, _IOFBF, 1024 * 1024);
+
 	dumper = pcap_dump_fopen(dumpfile, dump_filep);
     if (dumper == NULL) {
         _MSG("Failed to open pcap dump file '" + in_path + "': " +
@@ -122,6 +129,11 @@ void KisPPILogfile::Log_Close() {
 	dumpfile = NULL;
     dump_filep = NULL;
 
+    if (dump_scratch != NULL) {
+        delete[] dump_scratch;
+        dump_scratch = NULL;
+        dump_scratch_sz = 0;
+    }
 }
 
 KisPPILogfile::~KisPPILogfile() {
@@ -256,7 +268,23 @@ int KisPPILogfile::packet_handler(CHAINCALL_PARMS) {
     if (dump_len == 0 || ppi_len == 0)
         return 0;
 
-    dump_data = new u_char[dump_len];
+    // Hold the log mutex for assembly and dump; the logging chain is
+    // serialized so this doesn't contend, but it protects the scratch
+    // buffer and dumper against a log close
+    local_locker lock(&(ppilog->log_mutex));
+
+    if (ppilog->dumper == NULL)
+        return 0;
+
+    // Grow the reusable scratch instead of allocating per packet
+    if (ppilog->dump_scratch_sz < dump_len) {
+        if (ppilog->dump_scratch != NULL)
+            delete[] ppilog->dump_scratch;
+        ppilog->dump_scratch = new u_char[dump_len];
+        ppilog->dump_scratch_sz = dump_len;
+    }
+
+    dump_data = ppilog->dump_scratch;
     //memset(dump_data, 0xcc, dump_len); //Good for debugging ppi stuff.
     ppi_ph = (ppi_packet_header *) dump_data;
 
@@ -426,14 +454,6 @@ int KisPPILogfile::packet_handler(CHAINCALL_PARMS) {
 
     dump_offset = ppi_pos;
 
-    if (dump_len == 0) {
-        delete[] dump_data;
-        return 0;
-    }
-
-    if (dump_data == NULL)
-        dump_data = new u_char[dump_len];
-
     // copy the packet content in, offset if necessary
     if (chunk != NULL) {
         memcpy(&(dump_data[dump_offset]), chunk->data, chunk->length);
@@ -453,12 +473,7 @@ int KisPPILogfile::packet_handler(CHAINCALL_PARMS) {
     wh.caplen = wh.len = dump_len;
 
     // Dump it
-    {
-        local_locker lock(&(ppilog->log_mutex));
-        pcap_dump((u_char *) ppilog->dumper, &wh, dump_data);
-    }
-
-    delete[] dump_data;
+    pcap_dump((u_char *) ppilog->dumper, &wh, dump_data);
 
     ppilog->log_packets++;
     ppilog->log_size += dump_len;
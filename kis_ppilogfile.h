@@ -85,6 +85,11 @@ protected:
 	pcap_dumper_t *dumper;
     FILE *dump_filep;
 
+    // Reusable packet assembly scratch, protected by the log mutex; grown
+    // on demand instead of allocating per packet
+    u_char *dump_scratch;
+    size_t dump_scratch_sz;
+
 	int dlt;
 
 	std::vector<ppi_cb_rec> ppi_cb_vec;
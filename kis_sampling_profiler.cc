@@ -0,0 +1,351 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include <map>
+#include <vector>
+
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <unwind.h>
+
+#ifdef SYS_LINUX
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#endif
+
+#include "backward_wrapper.h"
+
+#include "configfile.h"
+#include "kis_sampling_profiler.h"
+#include "messagebus.h"
+#include "util.h"
+
+// Raw sample storage, written by the SIGPROF handler; preallocated before
+// the capture starts so the handler never allocates
+#define PROFILER_MAX_DEPTH      48
+
+struct profiler_sample {
+    unsigned int depth;
+    void *frames[PROFILER_MAX_DEPTH];
+};
+
+static profiler_sample *profiler_samples = NULL;
+static unsigned int profiler_max_samples = 0;
+static std::atomic<unsigned int> profiler_sample_pos(0);
+static std::atomic<bool> profiler_capture_active(false);
+
+struct profiler_unwind_state {
+    void **frames;
+    unsigned int depth;
+    unsigned int max_depth;
+};
+
+static _Unwind_Reason_Code profiler_unwind_cb(struct _Unwind_Context *ctx,
+        void *arg) {
+    profiler_unwind_state *state = (profiler_unwind_state *) arg;
+
+    if (state->depth >= state->max_depth)
+        return _URC_END_OF_STACK;
+
+    uintptr_t ip = _Unwind_GetIP(ctx);
+
+    if (ip != 0)
+        state->frames[state->depth++] = (void *) ip;
+
+    return _URC_NO_REASON;
+}
+
+// SIGPROF handler; claims a sample slot with an atomic increment and
+// walks the stack with the unwinder directly - raw addresses only, no
+// allocation or locks.  Symbolization happens after the capture on the
+// requesting thread
+static void profiler_signal_handler(int sig __attribute__((unused))) {
+    if (!profiler_capture_active)
+        return;
+
+    unsigned int slot = profiler_sample_pos.fetch_add(1);
+
+    if (slot >= profiler_max_samples)
+        return;
+
+    profiler_unwind_state state;
+    state.frames = profiler_samples[slot].frames;
+    state.depth = 0;
+    state.max_depth = PROFILER_MAX_DEPTH;
+
+    _Unwind_Backtrace(profiler_unwind_cb, &state);
+
+    profiler_samples[slot].depth = state.depth;
+}
+
+#ifndef DISABLE_BACKWARD
+// Minimal stacktrace-shaped view over the unique address list, enough
+// for TraceResolver::load_stacktrace
+struct profiler_addr_view {
+    void **addrs;
+    size_t count;
+
+    size_t size() const {
+        return count;
+    }
+
+    void **begin() {
+        return addrs;
+    }
+};
+#endif
+
+KisSamplingProfiler::KisSamplingProfiler(GlobalRegistry *in_globalreg) :
+    Kis_Net_Httpd_CPPStream_Handler(in_globalreg) {
+    globalreg = in_globalreg;
+
+    default_hz =
+        globalreg->kismet_config->FetchOptUInt("profiler_hz", 101);
+    default_duration =
+        globalreg->kismet_config->FetchOptUInt("profiler_duration", 10);
+}
+
+KisSamplingProfiler::~KisSamplingProfiler() {
+    local_eol_locker lock(&capture_mutex);
+
+    globalreg->RemoveGlobal("SAMPLINGPROFILER");
+}
+
+bool KisSamplingProfiler::Httpd_VerifyPath(const char *path, const char *method) {
+    if (strcmp(method, "GET") != 0)
+        return false;
+
+    if (strcmp(path, "/profiler/profile.folded") == 0)
+        return true;
+
+    return false;
+}
+
+void KisSamplingProfiler::Httpd_CreateStreamResponse(
+        Kis_Net_Httpd *httpd __attribute__((unused)),
+        Kis_Net_Httpd_Connection *connection,
+        const char *path, const char *method,
+        const char *upload_data __attribute__((unused)),
+        size_t *upload_data_size __attribute__((unused)),
+        std::stringstream &stream) {
+
+    if (strcmp(method, "GET") != 0)
+        return;
+
+    if (strcmp(path, "/profiler/profile.folded") != 0)
+        return;
+
+    // Interrupting every thread in the server is privileged
+    if (!httpd->HasValidSession(connection, true))
+        return;
+
+    unsigned int hz = default_hz;
+    unsigned int duration = default_duration;
+
+    const char *carg =
+        MHD_lookup_connection_value(connection->connection,
+                MHD_GET_ARGUMENT_KIND, "hz");
+    if (carg != NULL)
+        if (sscanf(carg, "%u", &hz) != 1)
+            hz = default_hz;
+
+    carg = MHD_lookup_connection_value(connection->connection,
+            MHD_GET_ARGUMENT_KIND, "duration");
+    if (carg != NULL)
+        if (sscanf(carg, "%u", &duration) != 1)
+            duration = default_duration;
+
+    if (hz < 1)
+        hz = 1;
+    if (hz > 1000)
+        hz = 1000;
+
+    if (duration < 1)
+        duration = 1;
+    if (duration > 120)
+        duration = 120;
+
+    RunCapture(hz, duration, stream);
+}
+
+bool KisSamplingProfiler::RunCapture(unsigned int in_hz,
+        unsigned int in_duration, std::stringstream &stream) {
+#ifndef SYS_LINUX
+    stream << "# sampling profiler requires Linux (thread enumeration and "
+        "directed signals)\n";
+    return false;
+#else
+    // Serialize captures; a second request blocks until the first is done
+    local_locker lock(&capture_mutex);
+
+    _MSG("Sampling profiler capturing at " + UIntToString(in_hz) + "Hz for " +
+            UIntToString(in_duration) + " seconds", MSGFLAG_INFO);
+
+    // Budget slots for every thread firing at the full rate, within reason
+    profiler_max_samples = in_hz * in_duration * 64;
+    if (profiler_max_samples > 1048576)
+        profiler_max_samples = 1048576;
+
+    profiler_samples = new profiler_sample[profiler_max_samples];
+    profiler_sample_pos = 0;
+
+    // Prime the unwinder from a normal context; its first use may take
+    // loader locks which must not happen inside the signal handler
+    {
+        profiler_sample prime;
+        profiler_unwind_state state;
+        state.frames = prime.frames;
+        state.depth = 0;
+        state.max_depth = PROFILER_MAX_DEPTH;
+        _Unwind_Backtrace(profiler_unwind_cb, &state);
+    }
+
+    struct sigaction profact, oldact;
+    memset(&profact, 0, sizeof(profact));
+    profact.sa_handler = &profiler_signal_handler;
+    profact.sa_flags = SA_RESTART;
+    sigemptyset(&profact.sa_mask);
+
+    sigaction(SIGPROF, &profact, &oldact);
+
+    profiler_capture_active = true;
+
+    pid_t self_pid = getpid();
+    pid_t self_tid = (pid_t) syscall(SYS_gettid);
+
+    std::vector<pid_t> tids;
+    unsigned long total_ticks = (unsigned long) in_hz * in_duration;
+    unsigned long tick_usec = 1000000 / in_hz;
+
+    for (unsigned long tick = 0; tick < total_ticks; tick++) {
+        // Refresh the thread list about once a second; threads come and
+        // go with datasources and workers
+        if (tick % in_hz == 0) {
+            tids.clear();
+
+            DIR *taskdir = opendir("/proc/self/task");
+            if (taskdir != NULL) {
+                struct dirent *de;
+                while ((de = readdir(taskdir)) != NULL) {
+                    if (de->d_name[0] == '.')
+                        continue;
+
+                    pid_t tid = (pid_t) atoi(de->d_name);
+
+                    // Don't sample the sampling loop itself
+                    if (tid != 0 && tid != self_tid)
+                        tids.push_back(tid);
+                }
+                closedir(taskdir);
+            }
+        }
+
+        for (auto tid : tids)
+            syscall(SYS_tgkill, self_pid, tid, SIGPROF);
+
+        usleep(tick_usec);
+    }
+
+    profiler_capture_active = false;
+
+    // Let any in-flight handlers finish before we touch the samples
+    usleep(10000);
+
+    sigaction(SIGPROF, &oldact, NULL);
+
+    unsigned int captured = profiler_sample_pos;
+    if (captured > profiler_max_samples)
+        captured = profiler_max_samples;
+
+    // Fold identical stacks
+    std::map<std::vector<void *>, unsigned long> folded;
+    std::map<void *, std::string> addr_names;
+
+    for (unsigned int s = 0; s < captured; s++) {
+        std::vector<void *> stack(profiler_samples[s].frames,
+                profiler_samples[s].frames + profiler_samples[s].depth);
+
+        folded[stack]++;
+
+        for (auto a : stack)
+            addr_names[a] = "";
+    }
+
+    // Symbolize each unique address once
+#ifndef DISABLE_BACKWARD
+    {
+        std::vector<void *> uniq;
+        uniq.reserve(addr_names.size());
+        for (auto i : addr_names)
+            uniq.push_back(i.first);
+
+        profiler_addr_view view;
+        view.addrs = uniq.data();
+        view.count = uniq.size();
+
+        backward::TraceResolver resolver;
+        resolver.load_stacktrace(view);
+
+        for (size_t i = 0; i < uniq.size(); i++) {
+            backward::ResolvedTrace rt;
+            rt.addr = uniq[i];
+            rt.idx = i;
+
+            rt = resolver.resolve(rt);
+
+            if (rt.object_function.length() != 0)
+                addr_names[uniq[i]] = rt.object_function;
+        }
+    }
+#endif
+
+    // Addresses the resolver couldn't name stay as raw hex
+    for (auto& i : addr_names) {
+        if (i.second.length() == 0) {
+            char hexname[32];
+            snprintf(hexname, 32, "0x%lx", (unsigned long) i.first);
+            i.second = std::string(hexname);
+        }
+    }
+
+    // Emit folded stacks, root first, as flamegraph tooling expects
+    for (auto f : folded) {
+        stream << "kismet";
+
+        for (auto i = f.first.rbegin(); i != f.first.rend(); ++i)
+            stream << ";" << addr_names[*i];
+
+        stream << " " << f.second << "\n";
+    }
+
+    delete[] profiler_samples;
+    profiler_samples = NULL;
+    profiler_max_samples = 0;
+
+    _MSG("Sampling profiler captured " + UIntToString(captured) + " samples (" +
+            UIntToString((unsigned int) folded.size()) + " unique stacks)",
+            MSGFLAG_INFO);
+
+    return true;
+#endif
+}
+
@@ -0,0 +1,90 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __KIS_SAMPLING_PROFILER_H__
+#define __KIS_SAMPLING_PROFILER_H__
+
+#include "config.h"
+
+#include <string>
+
+#include "globalregistry.h"
+#include "kis_mutex.h"
+#include "kis_net_microhttpd.h"
+
+/* On-demand sampling CPU profiler.
+ *
+ * Hardened field units can't have perf attached, but we already carry the
+ * backward stack machinery for crash traces; this reuses it to answer
+ * 'where is the CPU going' on a live remote server.
+ *
+ * Fetching /profiler/profile.folded interrupts every thread of the
+ * process with SIGPROF at a fixed rate for a fixed window, captures raw
+ * stacks from the signal handler (plain frame pointers via the
+ * unwinder, no allocation), then symbolizes the unique addresses once
+ * with the backward resolver and streams the aggregated stacks in the
+ * 'folded' format flamegraph tooling consumes directly.
+ *
+ * One capture may run at a time, and the capture blocks the requesting
+ * connection for its duration.  Requires a logged-in session.
+ *
+ * Defaults come from profiler_hz / profiler_duration in the config and
+ * can be overridden per request with ?hz= and ?duration=.
+ */
+
+class KisSamplingProfiler : public LifetimeGlobal,
+    public Kis_Net_Httpd_CPPStream_Handler {
+public:
+    static std::shared_ptr<KisSamplingProfiler>
+        create_profiler(GlobalRegistry *in_globalreg) {
+        std::shared_ptr<KisSamplingProfiler> mon(new KisSamplingProfiler(in_globalreg));
+        in_globalreg->RegisterLifetimeGlobal(mon);
+        in_globalreg->InsertGlobal("SAMPLINGPROFILER", mon);
+        return mon;
+    }
+
+private:
+    KisSamplingProfiler(GlobalRegistry *in_globalreg);
+
+public:
+    virtual ~KisSamplingProfiler();
+
+    virtual bool Httpd_VerifyPath(const char *path, const char *method);
+
+    virtual void Httpd_CreateStreamResponse(Kis_Net_Httpd *httpd,
+            Kis_Net_Httpd_Connection *connection,
+            const char *url, const char *method, const char *upload_data,
+            size_t *upload_data_size, std::stringstream &stream);
+
+protected:
+    GlobalRegistry *globalreg;
+
+    // One capture at a time
+    kis_recursive_timed_mutex capture_mutex;
+
+    unsigned int default_hz;
+    unsigned int default_duration;
+
+    // Run a capture and write the folded stacks into the stream; returns
+    // false with a message in the stream on failure
+    bool RunCapture(unsigned int in_hz, unsigned int in_duration,
+            std::stringstream &stream);
+};
+
+#endif
+
@@ -0,0 +1,171 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+#include "kis_threads.h"
+#include "messagebus.h"
+#include "util.h"
+#include "configfile.h"
+#include "kis_mutex.h"
+
+static kis_recursive_timed_mutex inventory_mutex;
+static std::vector<kis_thread_record> thread_inventory;
+
+static unsigned long fetch_tid() {
+#ifdef __linux__
+    return (unsigned long) syscall(SYS_gettid);
+#else
+    return 0;
+#endif
+}
+
+#ifdef __linux__
+// Parse a taskset-style cpu list (0-3,8) into a mask; returns false on a
+// malformed list
+static bool parse_cpu_list(std::string in_list, cpu_set_t *ret_set) {
+    CPU_ZERO(ret_set);
+
+    std::vector<std::string> toks = StrTokenize(in_list, ",");
+
+    if (toks.size() == 0)
+        return false;
+
+    for (auto t : toks) {
+        unsigned int lo, hi;
+
+        if (sscanf(t.c_str(), "%u-%u", &lo, &hi) == 2) {
+            if (hi < lo || hi >= CPU_SETSIZE)
+                return false;
+
+            for (unsigned int c = lo; c <= hi; c++)
+                CPU_SET(c, ret_set);
+        } else if (sscanf(t.c_str(), "%u", &lo) == 1) {
+            if (lo >= CPU_SETSIZE)
+                return false;
+
+            CPU_SET(lo, ret_set);
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
+
+// Look up the configured cpu list for a thread class; empty if unpinned
+static std::string class_cpu_list(GlobalRegistry *globalreg, std::string in_class) {
+    if (globalreg->kismet_config == NULL)
+        return "";
+
+    std::vector<std::string> lines =
+        globalreg->kismet_config->FetchOptVec("thread_affinity");
+
+    for (auto l : lines) {
+        size_t cpos = l.find(':');
+
+        if (cpos == std::string::npos || cpos == 0) {
+            _MSG("Expected thread_affinity=class:cpulist, skipping '" + l + "'",
+                    MSGFLAG_ERROR);
+            continue;
+        }
+
+        if (StrLower(l.substr(0, cpos)) == StrLower(in_class))
+            return l.substr(cpos + 1, l.length());
+    }
+
+    return "";
+}
+
+std::string Kis_Thread_Apply_Class(GlobalRegistry *globalreg,
+        std::string in_class) {
+    std::string cpulist = class_cpu_list(globalreg, in_class);
+
+    if (cpulist == "")
+        return "";
+
+#ifdef __linux__
+    cpu_set_t set;
+
+    if (!parse_cpu_list(cpulist, &set)) {
+        _MSG("Could not parse thread_affinity cpu list '" + cpulist + "' for "
+                "class '" + in_class + "'", MSGFLAG_ERROR);
+        return "";
+    }
+
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) != 0) {
+        _MSG("Could not set affinity '" + cpulist + "' for thread class '" +
+                in_class + "'", MSGFLAG_ERROR);
+        return "";
+    }
+
+    return cpulist;
+#else
+    _MSG("Thread affinity is not supported on this platform, ignoring "
+            "thread_affinity for class '" + in_class + "'", MSGFLAG_ERROR);
+    return "";
+#endif
+}
+
+void Kis_Thread_Setup(GlobalRegistry *globalreg, std::string in_name,
+        std::string in_class) {
+#ifdef __linux__
+    // Kernel limits names to 15 chars + null
+    char sname[16];
+    snprintf(sname, 16, "%s", in_name.c_str());
+    pthread_setname_np(pthread_self(), sname);
+#endif
+
+    std::string applied = Kis_Thread_Apply_Class(globalreg, in_class);
+
+    kis_thread_record rec;
+    rec.name = in_name;
+    rec.thread_class = in_class;
+    rec.cpu_list = applied;
+    rec.tid = fetch_tid();
+
+    local_locker lock(&inventory_mutex);
+    thread_inventory.push_back(rec);
+}
+
+void Kis_Thread_Record_External(std::string in_name, std::string in_class,
+        std::string in_cpu_list) {
+    kis_thread_record rec;
+    rec.name = in_name;
+    rec.thread_class = in_class;
+    rec.cpu_list = in_cpu_list;
+    rec.tid = 0;
+
+    local_locker lock(&inventory_mutex);
+    thread_inventory.push_back(rec);
+}
+
+std::vector<kis_thread_record> Kis_Thread_Inventory() {
+    local_locker lock(&inventory_mutex);
+    return thread_inventory;
+}
@@ -0,0 +1,74 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __KIS_THREADS_H__
+#define __KIS_THREADS_H__
+
+#include "config.h"
+
+#include <string>
+#include <vector>
+
+#include "globalregistry.h"
+
+// Thread naming, affinity, and inventory.
+//
+// Engine threads announce themselves with Kis_Thread_Setup from inside the
+// thread; the thread gets an OS-visible name and, when the config carries a
+//   thread_affinity=<class>:<cpulist>
+// line for its class, is pinned to the listed CPUs.  On a multi-socket
+// aggregator this keeps the packet chain workers on the NUMA node serving
+// the capture NICs and the web server threads off of it, instead of
+// everything floating and dragging cache lines across the interconnect.
+//
+// The cpu list uses the usual taskset syntax, e.g. 0-3,8.  Affinity is a
+// no-op on platforms without sched affinity support; naming and inventory
+// still work where available.
+//
+// Every announced thread lands in a process-wide inventory which the system
+// monitor serves from /system/threads.
+
+struct kis_thread_record {
+    std::string name;
+    std::string thread_class;
+    // Applied cpu list; empty if the thread is unpinned
+    std::string cpu_list;
+    unsigned long tid;
+};
+
+// Name the calling thread, apply any configured affinity for its class, and
+// add it to the inventory; must be called from inside the thread
+void Kis_Thread_Setup(GlobalRegistry *in_globalreg, std::string in_name,
+        std::string in_class);
+
+// Apply the configured affinity for a class to the calling thread without
+// renaming or registering it; returns the applied cpu list, or an empty
+// string if none is configured.  Used to brief thread pools spawned inside
+// libraries, which inherit the creating thread's mask.
+std::string Kis_Thread_Apply_Class(GlobalRegistry *in_globalreg,
+        std::string in_class);
+
+// Record a thread or pool whose affinity was established externally (such
+// as an inherited-mask library pool)
+void Kis_Thread_Record_External(std::string in_name, std::string in_class,
+        std::string in_cpu_list);
+
+// Snapshot of every thread which has announced itself
+std::vector<kis_thread_record> Kis_Thread_Inventory();
+
+#endif
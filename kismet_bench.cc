@@ -0,0 +1,555 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Offline packet chain benchmark.
+ *
+ * Replays a pcap file directly through GeneratePacket()/ProcessPacket(),
+ * bypassing the datasource IPC and the web server, with the full set of
+ * registered dissectors, classifiers, trackers, and (config-enabled) log
+ * handlers in the chain.  Reports wall time, packets per second, peak RSS,
+ * and - when packet_chain_profiling is enabled - the per-handler latency
+ * accounting.
+ *
+ * Built as 'make kismet_bench'; not installed.
+ *
+ * For steady results point the config at a scratch environment, eg
+ *   kismet_bench -f bench.conf foo.pcap
+ * with bench.conf setting configdir to a tmpfs path (the device state
+ * database lives there) and either log_types= (empty, logging disabled) or
+ * log_prefix pointed at tmpfs so log writes don't measure your disk.
+ */
+
+#include "config.h"
+
+#include "version.h"
+
+#include <cstdlib>
+#include <iostream>
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "getopt.h"
+#include <stdlib.h>
+#include <signal.h>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#include "util.h"
+#include "endian_magic.h"
+
+#include "globalregistry.h"
+
+#include "configfile.h"
+#include "messagebus.h"
+
+#include "kis_dlt_ppi.h"
+#include "kis_dlt_radiotap.h"
+
+#include "kis_dissector_ipdata.h"
+
+#include "kis_packet_prefilter.h"
+
+#include "logtracker.h"
+#include "kis_ppilogfile.h"
+#include "kis_databaselogfile.h"
+#include "kis_pcapnglogfile.h"
+
+#include "timetracker.h"
+#include "alertracker.h"
+
+#include "kis_net_microhttpd.h"
+#include "channeltracker2.h"
+#include "kis_httpd_registry.h"
+
+#include "gpstracker.h"
+
+#include "devicetracker.h"
+#include "phy_80211.h"
+#include "phy_rtl433.h"
+#include "phy_zwave.h"
+#include "phy_bluetooth.h"
+#include "phy_uav_drone.h"
+
+#include "manuf.h"
+
+#include "entrytracker.h"
+
+#include "json_adapter.h"
+#include "cbor_adapter.h"
+
+#include "streamtracker.h"
+
+#include "packetchain.h"
+#include "packet.h"
+
+#ifndef exec_name
+char *exec_name;
+#endif
+
+static GlobalRegistry *globalregistry = NULL;
+
+// Classic pcap file format; parsed by hand so the bench doesn't depend on
+// libpcap being compiled in
+#define PCAP_MAGIC_USEC         0xa1b2c3d4
+#define PCAP_MAGIC_NSEC         0xa1b23c4d
+#define PCAP_MAGIC_USEC_SWAP    0xd4c3b2a1
+#define PCAP_MAGIC_NSEC_SWAP    0x4d3cb2a1
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t dlt;
+} bench_pcap_hdr;
+
+typedef struct {
+    uint32_t ts_sec;
+    uint32_t ts_frac;
+    uint32_t caplen;
+    uint32_t len;
+} bench_pcap_rec;
+
+#define PCAP_MAX_SNAPLEN    65535
+
+// Minimal messagebus client; the bench has no ncurses wrapper or silence
+// logic, it just prints
+class BenchMessageClient : public MessageClient {
+public:
+    BenchMessageClient(GlobalRegistry *in_globalreg, void *in_aux) :
+        MessageClient(in_globalreg, in_aux) { }
+
+    virtual ~BenchMessageClient() { }
+
+    void ProcessMessage(std::string in_msg, int in_flags) {
+        if (in_flags & (MSGFLAG_FATAL | MSGFLAG_ERROR))
+            fprintf(stderr, "ERROR: %s\n", in_msg.c_str());
+        else
+            fprintf(stderr, "%s\n", in_msg.c_str());
+    }
+};
+
+static void BenchFatal() {
+    fprintf(stderr, "FATAL: Bench setup failed, cannot continue\n");
+    exit(1);
+}
+
+static int Usage(char *argv) {
+    printf("Usage: %s [OPTION] <pcapfile>\n", argv);
+    printf("Replay a pcap file through the full Kismet packet chain and report\n"
+           "throughput, per-handler timing, and peak memory.\n");
+    printf(" -f, --config-file <file>     Use alternate configuration file\n"
+           " -n, --count <packets>        Stop after this many packets\n"
+           " -j, --json <file>            Write machine-readable results as JSON,\n"
+           "                              for comparison with bench_compare.py\n"
+           " -h, --help                   This text\n");
+    printf("Per-handler timing requires packet_chain_profiling=true in the config.\n"
+           "Point configdir and log_prefix at a tmpfs path (or set log_types=) so\n"
+           "the bench measures the chain, not your disk.\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[], char *envp[]) {
+    exec_name = argv[0];
+    char errstr[STATUS_MAX];
+    char *configfilename = NULL;
+    ConfigFile *conf;
+    int option_idx = 0;
+    unsigned long max_packets = 0;
+    char *pcapname = NULL;
+    char *jsonname = NULL;
+
+    signal(SIGPIPE, SIG_IGN);
+
+    static struct option bench_longopt[] = {
+        { "version", no_argument, 0, 'v' },
+        { "config-file", required_argument, 0, 'f' },
+        { "count", required_argument, 0, 'n' },
+        { "json", required_argument, 0, 'j' },
+        { "help", no_argument, 0, 'h' },
+        { 0, 0, 0, 0 }
+    };
+
+    optind = 0;
+    option_idx = 0;
+    opterr = 0;
+
+    while (1) {
+        int r = getopt_long(argc, argv, "-f:n:j:hv", bench_longopt, &option_idx);
+        if (r < 0) break;
+
+        if (r == 'v') {
+            printf("Kismet %s-%s-%s bench\n", VERSION_MAJOR, VERSION_MINOR, VERSION_TINY);
+            exit(1);
+        } else if (r == 'h') {
+            Usage(argv[0]);
+        } else if (r == 'f') {
+            configfilename = strdup(optarg);
+        } else if (r == 'n') {
+            if (sscanf(optarg, "%lu", &max_packets) != 1)
+                Usage(argv[0]);
+        } else if (r == 'j') {
+            jsonname = strdup(optarg);
+        } else if (r == 1) {
+            pcapname = strdup(optarg);
+        }
+    }
+
+    if (pcapname == NULL)
+        Usage(argv[0]);
+
+    // Bring up the subsystems the chain needs, in the same order as the
+    // server; no IPC, no datasources, no web server start, no plugins
+    globalregistry = new GlobalRegistry;
+
+    globalregistry->version_major = VERSION_MAJOR;
+    globalregistry->version_minor = VERSION_MINOR;
+    globalregistry->version_tiny = VERSION_TINY;
+    globalregistry->revision = REVISION;
+    globalregistry->revdate = REVDATE;
+
+    globalregistry->argc = argc;
+    globalregistry->argv = argv;
+    globalregistry->envp = envp;
+
+    MessageBus::create_messagebus(globalregistry);
+
+    BenchMessageClient *benchmsgcli = new BenchMessageClient(globalregistry, NULL);
+    globalregistry->messagebus->RegisterClient(benchmsgcli, MSGFLAG_ALL);
+
+    if (configfilename == NULL) {
+        configfilename = new char[1024];
+        snprintf(configfilename, 1024, "%s/%s",
+                 getenv("KISMET_CONF") != NULL ? getenv("KISMET_CONF") : SYSCONF_LOC,
+                 "kismet.conf");
+    }
+
+    snprintf(errstr, STATUS_MAX, "Reading from config file %s", configfilename);
+    globalregistry->messagebus->InjectMessage(errstr, MSGFLAG_INFO);
+
+    conf = new ConfigFile(globalregistry);
+    if (conf->ParseConfig(configfilename) < 0) {
+        exit(1);
+    }
+    globalregistry->kismet_config = conf;
+
+    struct stat fstat;
+    std::string configdir;
+
+    if (conf->FetchOpt("configdir") != "") {
+        configdir = conf->ExpandLogPath(conf->FetchOpt("configdir"), "", "", 0, 1);
+    } else {
+        globalregistry->messagebus->InjectMessage("No 'configdir' option in the config file",
+                MSGFLAG_FATAL);
+        BenchFatal();
+    }
+
+    if (stat(configdir.c_str(), &fstat) == -1) {
+        snprintf(errstr, STATUS_MAX, "Local config and cache directory '%s' does not exist, making it",
+                configdir.c_str());
+        globalregistry->messagebus->InjectMessage(errstr, MSGFLAG_INFO);
+        if (mkdir(configdir.c_str(), S_IRUSR | S_IWUSR | S_IXUSR) < 0) {
+            snprintf(errstr, STATUS_MAX, "Could not create config and cache directory: %s",
+                    strerror(errno));
+            globalregistry->messagebus->InjectMessage(errstr, MSGFLAG_FATAL);
+            BenchFatal();
+        }
+    } else if (! S_ISDIR(fstat.st_mode)) {
+        snprintf(errstr, STATUS_MAX, "Local config and cache directory '%s' exists but is not a directory",
+                configdir.c_str());
+        globalregistry->messagebus->InjectMessage(errstr, MSGFLAG_FATAL);
+        BenchFatal();
+    }
+
+    // Ephemeral server uuid; never persisted
+    uuid benchuuid;
+    benchuuid.GenerateTimeUUID((uint8_t *) "KISMET");
+    globalregistry->server_uuid = benchuuid;
+    globalregistry->server_uuid_hash =
+        Adler32Checksum((const char *) benchuuid.uuid_block, 16);
+
+    globalregistry->servername = "Kismet-bench";
+
+    Timetracker::create_timetracker(globalregistry);
+
+    // The httpd global has to exist because nearly every component
+    // registers endpoints with it at construction, but it is never started
+    Kis_Net_Httpd::create_httpd(globalregistry);
+
+    if (globalregistry->fatal_condition)
+        BenchFatal();
+
+    std::shared_ptr<EntryTracker> entrytracker =
+        EntryTracker::create_entrytracker(globalregistry);
+
+    entrytracker->RegisterSerializer("json", std::shared_ptr<TrackerElementSerializer>(new JsonAdapter::Serializer(globalregistry)));
+    entrytracker->RegisterSerializer("ekjson", std::shared_ptr<TrackerElementSerializer>(new EkJsonAdapter::Serializer(globalregistry)));
+    entrytracker->RegisterSerializer("prettyjson", std::shared_ptr<TrackerElementSerializer>(new PrettyJsonAdapter::Serializer(globalregistry)));
+    entrytracker->RegisterSerializer("storagejson", std::shared_ptr<TrackerElementSerializer>(new StorageJsonAdapter::Serializer(globalregistry)));
+    entrytracker->RegisterSerializer("cbor", std::shared_ptr<TrackerElementSerializer>(new CborAdapter::Serializer(globalregistry)));
+
+    globalregistry->manufdb = new Manuf(globalregistry);
+
+    std::shared_ptr<Packetchain> packetchain =
+        Packetchain::create_packetchain(globalregistry);
+
+    StreamTracker::create_streamtracker(globalregistry);
+
+    Kis_Httpd_Registry::create_http_registry(globalregistry);
+
+    Alertracker::create_alertracker(globalregistry);
+
+    std::shared_ptr<Devicetracker> devicetracker =
+        Devicetracker::create_devicetracker(globalregistry);
+
+    Channeltracker_V2::create_channeltracker(globalregistry);
+
+    if (globalregistry->fatal_condition)
+        BenchFatal();
+
+    new Kis_DLT_PPI(globalregistry);
+    new Kis_DLT_Radiotap(globalregistry);
+
+    new Kis_Packet_Prefilter(globalregistry);
+
+    new Kis_Dissector_IPdata(globalregistry);
+
+    devicetracker->RegisterPhyHandler(new Kis_80211_Phy(globalregistry));
+    devicetracker->RegisterPhyHandler(new Kis_RTL433_Phy(globalregistry));
+    devicetracker->RegisterPhyHandler(new Kis_Zwave_Phy(globalregistry));
+    devicetracker->RegisterPhyHandler(new Kis_Bluetooth_Phy(globalregistry));
+    devicetracker->RegisterPhyHandler(new Kis_UAV_Phy(globalregistry));
+
+    if (globalregistry->fatal_condition)
+        BenchFatal();
+
+    // Same log builders as the server; what actually opens is driven by
+    // log_types in the config
+    KisDatabaseLogfile::create_kisdatabaselog(globalregistry);
+
+    LogTracker::create_logtracker(globalregistry);
+
+    Globalreg::FetchMandatoryGlobalAs<LogTracker>(globalregistry, "LOGTRACKER")->register_log(SharedLogBuilder(new KisPPILogfileBuilder(globalregistry)));
+    Globalreg::FetchMandatoryGlobalAs<LogTracker>(globalregistry, "LOGTRACKER")->register_log(SharedLogBuilder(new KisDatabaseLogfileBuilder(globalregistry)));
+    Globalreg::FetchMandatoryGlobalAs<LogTracker>(globalregistry, "LOGTRACKER")->register_log(SharedLogBuilder(new KisPcapNGLogfileBuilder(globalregistry)));
+
+    GpsTracker::create_gpsmanager(globalregistry);
+
+    devicetracker->load_devices();
+
+    // Opens the configured logs (logtracker defers its startup)
+    globalregistry->Start_Deferred();
+
+    if (globalregistry->fatal_condition)
+        BenchFatal();
+
+    // Open and validate the pcap
+    FILE *pf;
+    if ((pf = fopen(pcapname, "rb")) == NULL) {
+        fprintf(stderr, "FATAL: Could not open pcap file '%s': %s\n",
+                pcapname, strerror(errno));
+        exit(1);
+    }
+
+    bench_pcap_hdr phdr;
+    if (fread(&phdr, sizeof(bench_pcap_hdr), 1, pf) != 1) {
+        fprintf(stderr, "FATAL: Could not read pcap header from '%s'\n", pcapname);
+        exit(1);
+    }
+
+    bool swapped = false;
+    bool nanosec = false;
+
+    switch (phdr.magic) {
+        case PCAP_MAGIC_USEC:
+            break;
+        case PCAP_MAGIC_NSEC:
+            nanosec = true;
+            break;
+        case PCAP_MAGIC_USEC_SWAP:
+            swapped = true;
+            break;
+        case PCAP_MAGIC_NSEC_SWAP:
+            swapped = true;
+            nanosec = true;
+            break;
+        default:
+            fprintf(stderr, "FATAL: '%s' does not look like a classic pcap file "
+                    "(unknown magic %08x); pcapng is not supported\n",
+                    pcapname, phdr.magic);
+            exit(1);
+    }
+
+    int dlt = swapped ? (int) kis_swap32(phdr.dlt) : (int) phdr.dlt;
+
+    int pack_comp_linkframe =
+        packetchain->RegisterPacketComponent("LINKFRAME");
+
+    // Stay below the chain's proportional-drop threshold so the replay
+    // exercises chain throughput instead of the drop path
+    unsigned int backlog_limit =
+        conf->FetchOptUInt("packet_backlog_limit", 8192);
+    if (backlog_limit == 0)
+        backlog_limit = 8192;
+    size_t ingest_high_water = backlog_limit / 4;
+    if (ingest_high_water < 128)
+        ingest_high_water = 128;
+
+    snprintf(errstr, STATUS_MAX, "Replaying '%s' (dlt %d) through the packet chain...",
+            pcapname, dlt);
+    globalregistry->messagebus->InjectMessage(errstr, MSGFLAG_INFO);
+
+    uint8_t *pbuf = new uint8_t[PCAP_MAX_SNAPLEN];
+    unsigned long n_packets = 0;
+    unsigned long long n_bytes = 0;
+
+    struct timeval start_tv, end_tv;
+    gettimeofday(&start_tv, NULL);
+
+    while (max_packets == 0 || n_packets < max_packets) {
+        bench_pcap_rec rec;
+
+        if (fread(&rec, sizeof(bench_pcap_rec), 1, pf) != 1)
+            break;
+
+        uint32_t ts_sec = rec.ts_sec;
+        uint32_t ts_frac = rec.ts_frac;
+        uint32_t caplen = rec.caplen;
+
+        if (swapped) {
+            ts_sec = kis_swap32(ts_sec);
+            ts_frac = kis_swap32(ts_frac);
+            caplen = kis_swap32(caplen);
+        }
+
+        if (caplen > PCAP_MAX_SNAPLEN) {
+            fprintf(stderr, "FATAL: Corrupt pcap record (caplen %u) at packet %lu\n",
+                    caplen, n_packets);
+            exit(1);
+        }
+
+        if (fread(pbuf, 1, caplen, pf) != caplen) {
+            fprintf(stderr, "WARNING: Truncated pcap record at packet %lu\n", n_packets);
+            break;
+        }
+
+        kis_packet *pack = packetchain->GeneratePacket();
+
+        pack->ts.tv_sec = ts_sec;
+        pack->ts.tv_usec = nanosec ? ts_frac / 1000 : ts_frac;
+
+        kis_datachunk *linkchunk = new kis_datachunk;
+        linkchunk->dlt = dlt;
+        linkchunk->copy_data(pbuf, caplen);
+
+        pack->insert(pack_comp_linkframe, linkchunk);
+
+        packetchain->ProcessPacket(pack);
+
+        n_packets++;
+        n_bytes += caplen;
+
+        // Periodically advance the cached clock and fire maintenance
+        // timers, standing in for the server's main loop
+        if ((n_packets & 0x3FF) == 0)
+            globalregistry->timetracker->Tick();
+
+        while (packetchain->FetchPendingPackets() > ingest_high_water)
+            usleep(200);
+    }
+
+    delete[] pbuf;
+    fclose(pf);
+
+    // Wait for the chain to drain; the pending count transiently reads
+    // zero during the dissection-to-logging handoff, so require several
+    // consecutive quiet polls
+    int quiet_polls = 0;
+    while (quiet_polls < 5) {
+        if (packetchain->FetchPendingPackets() == 0)
+            quiet_polls++;
+        else
+            quiet_polls = 0;
+
+        globalregistry->timetracker->Tick();
+        usleep(2000);
+    }
+
+    gettimeofday(&end_tv, NULL);
+
+    double elapsed =
+        (double) (end_tv.tv_sec - start_tv.tv_sec) +
+        (double) (end_tv.tv_usec - start_tv.tv_usec) / 1000000.0f;
+    if (elapsed <= 0)
+        elapsed = 0.000001f;
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+
+    printf("\n");
+    printf("Replayed %lu packets (%llu bytes) in %.3f seconds\n",
+            n_packets, n_bytes, elapsed);
+    printf("  %.1f packets/sec, %.2f Mbit/sec\n",
+            (double) n_packets / elapsed,
+            ((double) n_bytes * 8.0f / 1000000.0f) / elapsed);
+    printf("  Peak RSS %ld MB\n", ru.ru_maxrss / 1024);
+    printf("  Devices tracked: %d\n", devicetracker->FetchNumDevices());
+    printf("\n");
+
+    packetchain->ReportHandlerTimings(stdout);
+
+    // Machine-readable results for bench_compare.py; one entry per run so
+    // the schema matches the microbench multi-result layout
+    if (jsonname != NULL) {
+        FILE *jf = fopen(jsonname, "w");
+
+        if (jf == NULL) {
+            fprintf(stderr, "WARNING: Could not write JSON results to '%s': %s\n",
+                    jsonname, strerror(errno));
+        } else {
+            fprintf(jf, "{\"bench\": \"kismet_bench\", \"version\": \"%s-%s-%s\", "
+                    "\"timestamp\": %lu, \"results\": [\n",
+                    VERSION_MAJOR, VERSION_MINOR, VERSION_TINY,
+                    (unsigned long) time(0));
+            fprintf(jf, "  {\"name\": \"replay\", \"packets\": %lu, \"bytes\": %llu, "
+                    "\"elapsed_sec\": %.6f, \"pps\": %.1f, \"mbit_s\": %.2f, "
+                    "\"rss_mb\": %ld, \"devices\": %d}\n",
+                    n_packets, n_bytes, elapsed,
+                    (double) n_packets / elapsed,
+                    ((double) n_bytes * 8.0f / 1000000.0f) / elapsed,
+                    ru.ru_maxrss / 1024,
+                    devicetracker->FetchNumDevices());
+            fprintf(jf, "]}\n");
+            fclose(jf);
+        }
+    }
+
+    // Orderly spindown so log files are flushed and closed
+    globalregistry->Shutdown_Deferred();
+    globalregistry->spindown = 1;
+
+    globalregistry->DeleteLifetimeGlobals();
+
+    return 0;
+}
@@ -0,0 +1,416 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Microbenchmarks for the TrackerElement and serialization primitives.
+ *
+ * Changes to trackedelement ripple into every hot path in the server, so
+ * this pins fixed, deterministic workloads on the core operations -
+ * element construction, component clone, map insert/fetch,
+ * register/reserve_fields, JSON packing of a device-shaped tree, and
+ * summarization - so numbers are comparable across builds.
+ *
+ * Needs no config file or root; built on demand via 'make
+ * kismet_microbench', never installed.  Workload sizes are fixed so the
+ * output is directly diffable between runs.
+ */
+
+#include "config.h"
+
+#include "version.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include <unistd.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <sys/time.h>
+
+#include "util.h"
+
+#include "globalregistry.h"
+
+#include "messagebus.h"
+
+#include "trackedelement.h"
+#include "entrytracker.h"
+
+#include "devicetracker_component.h"
+#include "tracked_location.h"
+
+#include "json_adapter.h"
+
+#ifndef exec_name
+char *exec_name;
+#endif
+
+static GlobalRegistry *globalregistry = NULL;
+
+// Print everything; the microbench produces very little chatter
+class BenchMessageClient : public MessageClient {
+public:
+    BenchMessageClient(GlobalRegistry *in_globalreg, void *in_aux) :
+        MessageClient(in_globalreg, in_aux) { }
+
+    virtual ~BenchMessageClient() { }
+
+    void ProcessMessage(std::string in_msg, int in_flags) {
+        if (in_flags & (MSGFLAG_FATAL | MSGFLAG_ERROR))
+            fprintf(stderr, "ERROR: %s\n", in_msg.c_str());
+        else
+            fprintf(stderr, "%s\n", in_msg.c_str());
+    }
+};
+
+// Optional machine-readable results stream for bench_compare.py; written
+// alongside the human-readable report
+static FILE *json_out = NULL;
+static bool json_first = true;
+
+static double bench_now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double) tv.tv_sec + (double) tv.tv_usec / 1000000.0f;
+}
+
+static void bench_report(const char *name, unsigned long long ops,
+        double elapsed, unsigned long long bytes) {
+    if (elapsed <= 0)
+        elapsed = 0.000001f;
+
+    printf("%-32s %12llu ops  %8.3f sec  %12.0f ops/sec  %10.1f ns/op",
+            name, ops, elapsed, (double) ops / elapsed,
+            elapsed * 1000000000.0f / (double) ops);
+
+    if (bytes != 0)
+        printf("  %8.2f MB/sec", ((double) bytes / 1048576.0f) / elapsed);
+
+    printf("\n");
+
+    if (json_out != NULL) {
+        fprintf(json_out, "%s  {\"name\": \"%s\", \"ops\": %llu, "
+                "\"elapsed_sec\": %.6f, \"ops_sec\": %.1f, \"ns_op\": %.1f",
+                json_first ? "" : ",\n",
+                name, ops, elapsed, (double) ops / elapsed,
+                elapsed * 1000000000.0f / (double) ops);
+
+        if (bytes != 0)
+            fprintf(json_out, ", \"mb_s\": %.2f",
+                    ((double) bytes / 1048576.0f) / elapsed);
+
+        fprintf(json_out, "}");
+
+        json_first = false;
+    }
+}
+
+// Scalar element construction, set, and destruction via the normal
+// shared_ptr lifecycle
+static void bench_element_construct() {
+    const unsigned long long ops = 2000000;
+    uint64_t sink = 0;
+
+    double start = bench_now();
+
+    for (unsigned long long i = 0; i < ops; i++) {
+        SharedTrackerElement e(new TrackerElement(TrackerUInt64, 0));
+        e->set((uint64_t) i);
+        sink += GetTrackerValue<uint64_t>(e);
+    }
+
+    bench_report("element construct/set/destroy", ops, bench_now() - start, 0);
+
+    if (sink == 1)
+        printf("\n");
+}
+
+// Full component clone; exercises register_fields, reserve_fields, and
+// the per-field element construction a component clone implies
+static void bench_component_clone() {
+    const unsigned long long ops = 100000;
+
+    std::shared_ptr<kis_tracked_signal_data> proto(
+            new kis_tracked_signal_data(globalregistry, 0));
+
+    double start = bench_now();
+
+    for (unsigned long long i = 0; i < ops; i++) {
+        SharedTrackerElement c = proto->clone_type();
+    }
+
+    bench_report("signal component clone", ops, bench_now() - start, 0);
+}
+
+// tracker_component construction from scratch; the register/reserve pair
+// every tracked device and sub-record pays on creation
+static void bench_reserve_fields() {
+    const unsigned long long ops = 100000;
+
+    double start = bench_now();
+
+    for (unsigned long long i = 0; i < ops; i++) {
+        std::shared_ptr<kis_tracked_ip_data> ip(
+                new kis_tracked_ip_data(globalregistry, 0));
+        ip->set_ip_addr((uint64_t) i);
+    }
+
+    bench_report("ip component register/reserve", ops, bench_now() - start, 0);
+}
+
+// Keyed map insert and fetch, as used by the ssid/client maps
+static void bench_map_insert_fetch() {
+    const unsigned long long entries = 100000;
+    const unsigned long long passes = 10;
+
+    SharedTrackerElement map_e(new TrackerElement(TrackerIntMap, 0));
+    TrackerElementIntMap imap(map_e);
+
+    double start = bench_now();
+
+    for (unsigned long long i = 0; i < entries; i++) {
+        SharedTrackerElement v(new TrackerElement(TrackerUInt64, 0));
+        v->set((uint64_t) i);
+        imap.insert(TrackerElementIntMap::pair((int) i, v));
+    }
+
+    bench_report("int map insert", entries, bench_now() - start, 0);
+
+    uint64_t sink = 0;
+
+    start = bench_now();
+
+    for (unsigned long long p = 0; p < passes; p++) {
+        for (unsigned long long i = 0; i < entries; i++) {
+            TrackerElementIntMap::iterator f = imap.find((int) i);
+            if (f != imap.end())
+                sink += GetTrackerValue<uint64_t>(f->second);
+        }
+    }
+
+    bench_report("int map fetch", entries * passes, bench_now() - start, 0);
+
+    if (sink == 1)
+        printf("\n");
+}
+
+// Build a device-shaped tree: a map of scalar summary fields, a signal
+// component, a location, and a vector of seenby-like sub-maps.  Field ids
+// are registered once, like the real device records
+static SharedTrackerElement bench_build_device_tree(
+        std::shared_ptr<EntryTracker> entrytracker) {
+    int dev_id = entrytracker->RegisterField("bench.device",
+            TrackerMap, "bench device record");
+    int name_id = entrytracker->RegisterField("bench.device.name",
+            TrackerString, "device name");
+    int type_id = entrytracker->RegisterField("bench.device.type",
+            TrackerString, "device type");
+    int packets_id = entrytracker->RegisterField("bench.device.packets",
+            TrackerUInt64, "packet count");
+    int channel_id = entrytracker->RegisterField("bench.device.channel",
+            TrackerString, "channel");
+    int freq_id = entrytracker->RegisterField("bench.device.frequency",
+            TrackerDouble, "frequency");
+    int seenby_vec_id = entrytracker->RegisterField("bench.device.seenby",
+            TrackerVector, "seenby records");
+    int seenby_id = entrytracker->RegisterField("bench.device.seenby.entry",
+            TrackerMap, "seenby record");
+    int seenby_time_id = entrytracker->RegisterField("bench.device.seenby.last_time",
+            TrackerUInt64, "last time seen");
+    int seenby_packets_id = entrytracker->RegisterField("bench.device.seenby.packets",
+            TrackerUInt64, "packets seen");
+
+    int signal_id =
+        entrytracker->RegisterField("bench.device.signal",
+                std::shared_ptr<kis_tracked_signal_data>(
+                    new kis_tracked_signal_data(globalregistry, 0)),
+                "signal data");
+    int location_id =
+        entrytracker->RegisterField("bench.device.location",
+                std::shared_ptr<kis_tracked_location_triplet>(
+                    new kis_tracked_location_triplet(globalregistry, 0)),
+                "location");
+
+    SharedTrackerElement dev(new TrackerElement(TrackerMap, dev_id));
+
+    SharedTrackerElement name(new TrackerElement(TrackerString, name_id));
+    name->set(std::string("bench device 0123456789abcdef"));
+    dev->add_map(name);
+
+    SharedTrackerElement type(new TrackerElement(TrackerString, type_id));
+    type->set(std::string("Wi-Fi AP"));
+    dev->add_map(type);
+
+    SharedTrackerElement packets(new TrackerElement(TrackerUInt64, packets_id));
+    packets->set((uint64_t) 123456);
+    dev->add_map(packets);
+
+    SharedTrackerElement channel(new TrackerElement(TrackerString, channel_id));
+    channel->set(std::string("6HT40"));
+    dev->add_map(channel);
+
+    SharedTrackerElement freq(new TrackerElement(TrackerDouble, freq_id));
+    freq->set((double) 2437000.0f);
+    dev->add_map(freq);
+
+    std::shared_ptr<kis_tracked_signal_data> sig(
+            new kis_tracked_signal_data(globalregistry, signal_id));
+    dev->add_map(sig);
+
+    std::shared_ptr<kis_tracked_location_triplet> loc(
+            new kis_tracked_location_triplet(globalregistry, location_id));
+    loc->set_lat(42.0f);
+    loc->set_lon(-71.0f);
+    dev->add_map(loc);
+
+    SharedTrackerElement seenby(new TrackerElement(TrackerVector, seenby_vec_id));
+    TrackerElementVector sbvec(seenby);
+
+    for (unsigned int s = 0; s < 16; s++) {
+        SharedTrackerElement sb(new TrackerElement(TrackerMap, seenby_id));
+
+        SharedTrackerElement st(new TrackerElement(TrackerUInt64, seenby_time_id));
+        st->set((uint64_t) (1500000000 + s));
+        sb->add_map(st);
+
+        SharedTrackerElement sp(new TrackerElement(TrackerUInt64, seenby_packets_id));
+        sp->set((uint64_t) (1000 * s));
+        sb->add_map(sp);
+
+        sbvec.push_back(sb);
+    }
+
+    dev->add_map(seenby);
+
+    return dev;
+}
+
+// JSON serialization of the device-shaped tree; the cost every REST
+// device list and eventbus push pays per record
+static void bench_json_pack(SharedTrackerElement dev) {
+    const unsigned long long ops = 20000;
+    unsigned long long bytes = 0;
+
+    double start = bench_now();
+
+    for (unsigned long long i = 0; i < ops; i++) {
+        std::ostringstream stream;
+        JsonAdapter::Pack(globalregistry, stream, dev, NULL);
+        bytes += stream.str().length();
+    }
+
+    bench_report("json pack device tree", ops, bench_now() - start, bytes);
+}
+
+// Summarization (field projection) of the device tree, as used by the
+// summarizing device endpoints; the summary set is compiled once and
+// applied per record, matching the real endpoint pattern
+static void bench_summarize(std::shared_ptr<EntryTracker> entrytracker,
+        SharedTrackerElement dev) {
+    const unsigned long long ops = 200000;
+
+    std::vector<SharedElementSummary> summary_vec;
+    summary_vec.push_back(SharedElementSummary(
+                new TrackerElementSummary("bench.device.name", entrytracker)));
+    summary_vec.push_back(SharedElementSummary(
+                new TrackerElementSummary("bench.device.packets", entrytracker)));
+    summary_vec.push_back(SharedElementSummary(
+                new TrackerElementSummary("bench.device.frequency", entrytracker)));
+
+    double start = bench_now();
+
+    for (unsigned long long i = 0; i < ops; i++) {
+        SharedTrackerElement simple;
+        TrackerElementSerializer::rename_map rename_map;
+
+        SummarizeTrackerElement(entrytracker, dev, summary_vec,
+                simple, rename_map);
+    }
+
+    bench_report("summarize device tree", ops, bench_now() - start, 0);
+}
+
+int main(int argc, char *argv[], char *envp[]) {
+    exec_name = argv[0];
+
+    char *jsonname = NULL;
+
+    for (int a = 1; a < argc; a++) {
+        if ((strcmp(argv[a], "-j") == 0 || strcmp(argv[a], "--json") == 0) &&
+                a + 1 < argc) {
+            jsonname = argv[++a];
+        } else {
+            fprintf(stderr, "Usage: %s [-j results.json]\n", argv[0]);
+            fprintf(stderr, "Run the tracked-element microbenchmarks; -j writes "
+                    "machine-readable results\nfor comparison with bench_compare.py\n");
+            exit(1);
+        }
+    }
+
+    globalregistry = new GlobalRegistry;
+
+    globalregistry->version_major = VERSION_MAJOR;
+    globalregistry->version_minor = VERSION_MINOR;
+    globalregistry->version_tiny = VERSION_TINY;
+    globalregistry->revision = REVISION;
+    globalregistry->revdate = REVDATE;
+
+    MessageBus::create_messagebus(globalregistry);
+
+    BenchMessageClient *benchmsgcli = new BenchMessageClient(globalregistry, NULL);
+    globalregistry->messagebus->RegisterClient(benchmsgcli, MSGFLAG_ALL);
+
+    std::shared_ptr<EntryTracker> entrytracker =
+        EntryTracker::create_entrytracker(globalregistry);
+
+    printf("Kismet %s-%s-%s microbench\n\n",
+            VERSION_MAJOR, VERSION_MINOR, VERSION_TINY);
+
+    if (jsonname != NULL) {
+        json_out = fopen(jsonname, "w");
+
+        if (json_out == NULL) {
+            fprintf(stderr, "WARNING: Could not write JSON results to '%s': %s\n",
+                    jsonname, strerror(errno));
+        } else {
+            fprintf(json_out, "{\"bench\": \"kismet_microbench\", "
+                    "\"version\": \"%s-%s-%s\", \"timestamp\": %lu, \"results\": [\n",
+                    VERSION_MAJOR, VERSION_MINOR, VERSION_TINY,
+                    (unsigned long) time(0));
+        }
+    }
+
+    bench_element_construct();
+    bench_component_clone();
+    bench_reserve_fields();
+    bench_map_insert_fetch();
+
+    SharedTrackerElement dev = bench_build_device_tree(entrytracker);
+
+    bench_json_pack(dev);
+    bench_summarize(entrytracker, dev);
+
+    if (json_out != NULL) {
+        fprintf(json_out, "\n]}\n");
+        fclose(json_out);
+    }
+
+    return 0;
+}
@@ -38,6 +38,7 @@
 #include <signal.h>
 #include <pwd.h>
 #include <string>
+#include <thread>
 #include <vector>
 #include <sstream>
 
@@ -61,6 +62,8 @@
 
 #include "kis_dissector_ipdata.h"
 
+#include "kis_packet_prefilter.h"
+
 #include "kis_datasource.h"
 #include "datasourcetracker.h"
 #include "datasource_pcapfile.h"
@@ -68,6 +71,7 @@
 #include "datasource_linux_bluetooth.h"
 #include "datasource_osx_corewlan_wifi.h"
 #include "datasource_rtl433.h"
+#include "datasource_synthetic.h"
 
 #include "logtracker.h"
 #include "kis_ppilogfile.h"
@@ -77,6 +81,7 @@
 #include "timetracker.h"
 #include "alertracker.h"
 
+#include "kis_mempool.h"
 #include "kis_net_microhttpd.h"
 #include "system_monitor.h"
 #include "channeltracker2.h"
@@ -102,8 +107,15 @@
 #include "entrytracker.h"
 
 #include "json_adapter.h"
+#include "cbor_adapter.h"
 
 #include "streamtracker.h"
+#include "kis_federation.h"
+#include "kis_threads.h"
+
+#include "kis_perfcounter.h"
+#include "kis_sampling_profiler.h"
+#include "ringbuf2.h"
 
 #ifndef exec_name
 char *exec_name;
@@ -246,9 +258,12 @@ void SpindownKismet(std::shared_ptr<PollableTracker> pollabletracker) {
     if (daemonize == 0)
         fprintf(stderr, "\n*** KISMET IS SHUTTING DOWN ***\n");
     time_t shutdown_target = time(0) + 2;
+
+#ifndef SYS_LINUX
     int max_fd = 0;
     fd_set rset, wset;
     struct timeval tm;
+#endif
 
     sigset_t mask, oldmask;
     sigemptyset(&mask);
@@ -256,9 +271,6 @@ void SpindownKismet(std::shared_ptr<PollableTracker> pollabletracker) {
     sigaddset(&mask, SIGCHLD);
 
     while (1) {
-        FD_ZERO(&rset);
-        FD_ZERO(&wset);
-
         if (globalregistry->fatal_condition) {
             break;
         }
@@ -267,6 +279,19 @@ void SpindownKismet(std::shared_ptr<PollableTracker> pollabletracker) {
             break;
         }
 
+#ifdef SYS_LINUX
+        // The epoll path sleeps and dispatches internally
+
+        // Block signals while doing io loops */
+        sigprocmask(SIG_BLOCK, &mask, &oldmask);
+
+        if (pollabletracker->ProcessPollableEpoll(100) < 0) {
+            sigprocmask(SIG_UNBLOCK, &mask, &oldmask);
+            break;
+        }
+
+        sigprocmask(SIG_UNBLOCK, &mask, &oldmask);
+#else
         // Collect all the pollable descriptors
         max_fd = pollabletracker->MergePollableFds(&rset, &wset);
 
@@ -285,6 +310,7 @@ void SpindownKismet(std::shared_ptr<PollableTracker> pollabletracker) {
         pollabletracker->ProcessPollableSelect(rset, wset);
 
         sigprocmask(SIG_UNBLOCK, &mask, &oldmask);
+#endif
 
         if (globalregistry->fatal_condition) {
             break;
@@ -632,6 +658,46 @@ void Load_Kismet_UUID(GlobalRegistry *globalreg) {
     globalreg->server_uuid_hash = Adler32Checksum((const char *) confuuid.uuid_block, 16);
 }
 
+// Wall-clock timing of the startup stages, reported once bring-up completes
+// so slow stages (oui db, database upgrade, device storage) are visible
+static std::vector<std::pair<std::string, double> > startup_stage_times;
+static struct timeval startup_stage_tv;
+
+static double Startup_Stage_Elapsed(struct timeval *start_tv) {
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+
+    return (double) (now.tv_sec - start_tv->tv_sec) +
+        ((double) (now.tv_usec - start_tv->tv_usec) / 1000000.0f);
+}
+
+static void Startup_Stage_Begin() {
+    gettimeofday(&startup_stage_tv, NULL);
+}
+
+static void Startup_Stage_End(std::string in_stage) {
+    startup_stage_times.push_back(std::make_pair(in_stage,
+                Startup_Stage_Elapsed(&startup_stage_tv)));
+    gettimeofday(&startup_stage_tv, NULL);
+}
+
+static void Startup_Stage_Report(GlobalRegistry *globalreg) {
+    std::stringstream ss;
+    double total = 0;
+
+    ss << "Startup timing:";
+
+    for (auto s : startup_stage_times) {
+        ss << " " << s.first << " " << (int) (s.second * 1000) << "ms,";
+        total += s.second;
+    }
+
+    ss << " total " << (int) (total * 1000) << "ms";
+
+    _MSG(ss.str(), MSGFLAG_INFO);
+}
+
 int main(int argc, char *argv[], char *envp[]) {
     exec_name = argv[0];
     char errstr[STATUS_MAX];
@@ -719,9 +785,11 @@ int main(int argc, char *argv[], char *envp[]) {
     // Set up usage functions
     globalregistry->RegisterUsageFunc(Devicetracker::usage);
 
+#ifndef SYS_LINUX
     int max_fd = 0;
     fd_set rset, wset;
     struct timeval tm;
+#endif
 
     const int nlwc = globalregistry->getopt_long_num++;
     const int dwc = globalregistry->getopt_long_num++;
@@ -803,13 +871,19 @@ int main(int argc, char *argv[], char *envp[]) {
 
     snprintf(errstr, STATUS_MAX, "Reading from config file %s", configfilename);
     globalregistry->messagebus->InjectMessage(errstr, MSGFLAG_INFO);
-    
+
+    Startup_Stage_Begin();
+
     conf = new ConfigFile(globalregistry);
     if (conf->ParseConfig(configfilename) < 0) {
         exit(1);
     }
     globalregistry->kismet_config = conf;
 
+    // Name the main thread and apply any configured affinity; the main
+    // thread runs the poll loop and with it all the datasource IPC
+    Kis_Thread_Setup(globalregistry, "main", "main");
+
     struct stat fstat;
     std::string configdir;
 
@@ -862,6 +936,28 @@ int main(int argc, char *argv[], char *envp[]) {
         }
     }
 
+    // Reserve the preallocated memory pool before any subsystem starts
+    // allocating; long-running deployments use this for flat, predictable
+    // resident memory and hugepage backing of the hot pools
+    if (globalregistry->kismet_config->FetchOptBoolean("memory_prealloc", false)) {
+        unsigned int prealloc_mb =
+            globalregistry->kismet_config->FetchOptUInt("memory_prealloc_mb", 256);
+        bool prealloc_huge =
+            globalregistry->kismet_config->FetchOptBoolean("memory_prealloc_hugepages", true);
+
+        if (kis_mem_pool::reserve(prealloc_mb * 1024ULL * 1024ULL, prealloc_huge)) {
+            fprintf(stderr, "INFO: Reserved %uMb preallocated memory pool (%s)\n",
+                    prealloc_mb,
+                    kis_mem_pool::hugepages_active() ?
+                    "explicit hugepages" : "transparent hugepage advised");
+        } else {
+            fprintf(stderr, "WARNING:  Could not reserve %uMb preallocated memory "
+                    "pool, continuing with standard heap allocation\n", prealloc_mb);
+        }
+    }
+
+    Startup_Stage_End("config");
+
     // Make the timetracker
     Timetracker::create_timetracker(globalregistry);
 
@@ -882,10 +978,43 @@ int main(int argc, char *argv[], char *envp[]) {
     entrytracker->RegisterSerializer("ekjson", std::shared_ptr<TrackerElementSerializer>(new EkJsonAdapter::Serializer(globalregistry)));
     entrytracker->RegisterSerializer("prettyjson", std::shared_ptr<TrackerElementSerializer>(new PrettyJsonAdapter::Serializer(globalregistry)));
     entrytracker->RegisterSerializer("storagejson", std::shared_ptr<TrackerElementSerializer>(new StorageJsonAdapter::Serializer(globalregistry)));
+    entrytracker->RegisterSerializer("cbor", std::shared_ptr<TrackerElementSerializer>(new CborAdapter::Serializer(globalregistry)));
 
     entrytracker->RegisterSerializer("jcmd", std::shared_ptr<TrackerElementSerializer>(new JsonAdapter::Serializer(globalregistry)));
     entrytracker->RegisterSerializer("cmd", std::shared_ptr<TrackerElementSerializer>(new JsonAdapter::Serializer(globalregistry)));
 
+    // Engine health counter registry; subsystems created after this point
+    // publish their queue depth and drop counters into it, and the system
+    // monitor samples them into RRDs
+    std::shared_ptr<PerfCounterRegistry> perfcounters =
+        PerfCounterRegistry::create_perfcounters(globalregistry);
+
+    // The ring buffers have no lifetime global of their own; publish their
+    // shared overflow counter here
+    perfcounters->RegisterCounter("kismet.buffer.ring_overflows",
+            "ring buffer writes rejected for lack of space",
+            PerfCounterRegistry::PERF_COUNTER,
+            []() -> uint64_t {
+                return RingbufV2::FetchOverflowCount();
+            });
+
+    perfcounters->RegisterCounter("kismet.memory.ring_buffer_bytes",
+            "bytes allocated to live ring buffers",
+            PerfCounterRegistry::PERF_GAUGE,
+            []() -> uint64_t {
+                return RingbufV2::FetchTotalBytes();
+            });
+
+    // The device tree and every tracked record is built from elements, so
+    // the live element count is the best proxy for that footprint
+    perfcounters->RegisterCounter("kismet.memory.tracked_elements",
+            "live TrackerElement instances",
+            PerfCounterRegistry::PERF_GAUGE,
+            []() -> uint64_t {
+                return TrackerElement::FetchElementCount();
+            });
+
+    Startup_Stage_End("httpd");
 
     if (daemonize) {
         int pid = fork();
@@ -913,6 +1042,15 @@ int main(int argc, char *argv[], char *envp[]) {
         globalregistry->servername = MungeToPrintable(conf->FetchOpt("servername"));
     }
 
+    // Load the manuf db on a worker thread; it's a few MB of text parse
+    // which doesn't need to hold up the rest of bring-up.  It only depends
+    // on the config and messagebus, and nothing consumes it until devices
+    // exist; started after the daemonize fork so the child owns the thread.
+    // We join it before loading stored devices.
+    std::thread manuf_thread([]() {
+            globalregistry->manufdb = new Manuf(globalregistry);
+        });
+
     // Create the IPC handler
     IPCRemoteV2Tracker::create_ipcremote(globalregistry);
 
@@ -926,6 +1064,9 @@ int main(int argc, char *argv[], char *envp[]) {
     // Add the messagebus REST interface
     RestMessageClient::create_messageclient(globalregistry);
 
+    // On-demand sampling profiler
+    KisSamplingProfiler::create_profiler(globalregistry);
+
     // Add login session
     Kis_Httpd_Websession::create_websession(globalregistry);
 
@@ -952,13 +1093,22 @@ int main(int argc, char *argv[], char *envp[]) {
     // Add channel tracking
     Channeltracker_V2::create_channeltracker(globalregistry);
 
+    // Add federation with upstream servers, if any are configured
+    FederationTracker::create_federationtracker(globalregistry);
+
     if (globalregistry->fatal_condition)
         CatchShutdown(-1);
 
+    Startup_Stage_End("trackers");
+
     // Register the DLT handlers
     new Kis_DLT_PPI(globalregistry);
     new Kis_DLT_Radiotap(globalregistry);
 
+    // Register the early-reject prefilter, which runs after the DLT
+    // handlers de-encapsulate
+    new Kis_Packet_Prefilter(globalregistry);
+
     new Kis_Dissector_IPdata(globalregistry);
 
     // Register the base PHYs
@@ -972,15 +1122,18 @@ int main(int argc, char *argv[], char *envp[]) {
 
     Globalreg::FetchMandatoryGlobalAs<Devicetracker>(globalregistry, "DEVICE_TRACKER")->RegisterPhyHandler(new Kis_UAV_Phy(globalregistry));
 
-    if (globalregistry->fatal_condition) 
+    if (globalregistry->fatal_condition)
         CatchShutdown(-1);
 
+    Startup_Stage_End("phys");
+
     // Add the datasources
     datasourcetracker->register_datasource(SharedDatasourceBuilder(new DatasourcePcapfileBuilder(globalregistry)));
     datasourcetracker->register_datasource(SharedDatasourceBuilder(new DatasourceLinuxWifiBuilder(globalregistry)));
     datasourcetracker->register_datasource(SharedDatasourceBuilder(new DatasourceLinuxBluetoothBuilder(globalregistry)));
     datasourcetracker->register_datasource(SharedDatasourceBuilder(new DatasourceOsxCorewlanWifiBuilder(globalregistry)));
     datasourcetracker->register_datasource(SharedDatasourceBuilder(new DatasourceRtl433Builder(globalregistry)));
+    datasourcetracker->register_datasource(SharedDatasourceBuilder(new DatasourceSyntheticBuilder(globalregistry)));
 
     // Create the database logger as a global because it's a special case
     KisDatabaseLogfile::create_kisdatabaselog(globalregistry);
@@ -991,6 +1144,7 @@ int main(int argc, char *argv[], char *envp[]) {
     Globalreg::FetchMandatoryGlobalAs<LogTracker>(globalregistry, "LOGTRACKER")->register_log(SharedLogBuilder(new KisDatabaseLogfileBuilder(globalregistry)));
     Globalreg::FetchMandatoryGlobalAs<LogTracker>(globalregistry, "LOGTRACKER")->register_log(SharedLogBuilder(new KisPcapNGLogfileBuilder(globalregistry)));
 
+    Startup_Stage_End("logging");
 
     std::shared_ptr<Plugintracker> plugintracker;
 
@@ -1016,14 +1170,11 @@ int main(int argc, char *argv[], char *envp[]) {
         }
     }
 
+    Startup_Stage_End("plugins");
+
     // Create the GPS components
     GpsTracker::create_gpsmanager(globalregistry);
 
-    // Create the manuf db
-    globalregistry->manufdb = new Manuf(globalregistry);
-    if (globalregistry->fatal_condition)
-        CatchShutdown(-1);
-
     // Start stateful alert systems
     BSSTSStateAlert *bsstsa;
     bsstsa = new BSSTSStateAlert(globalregistry);
@@ -1039,9 +1190,21 @@ int main(int argc, char *argv[], char *envp[]) {
     // Finalize any plugins which were waiting for other code to load
     plugintracker->FinalizePlugins();
 
+    Startup_Stage_End("gps");
+
+    // Wait for the manuf db load; stored devices get manuf names resolved
+    // as they're reloaded
+    manuf_thread.join();
+    if (globalregistry->fatal_condition)
+        CatchShutdown(-1);
+
+    Startup_Stage_End("manuf");
+
     // We can't call this as a deferred because we don't want to mix
     devicetracker->load_devices();
-    
+
+    Startup_Stage_End("devicestorage");
+
     _MSG("Starting Kismet web server...", MSGFLAG_INFO);
     Globalreg::FetchMandatoryGlobalAs<Kis_Net_Httpd>(globalregistry, "HTTPD_SERVER")->StartHttpd();
 
@@ -1052,6 +1215,13 @@ int main(int argc, char *argv[], char *envp[]) {
     // Start up any code that needs everything to be loaded
     globalregistry->Start_Deferred();
 
+    // Everything is registered; freeze the global table so hot-path
+    // fetches by ref skip the lock
+    globalregistry->Freeze_Globals();
+
+    Startup_Stage_End("webserver");
+    Startup_Stage_Report(globalregistry);
+
     sigset_t mask, oldmask;
     sigemptyset(&mask);
     sigemptyset(&oldmask);
@@ -1063,10 +1233,35 @@ int main(int argc, char *argv[], char *envp[]) {
             break;
         }
 
+#ifdef SYS_LINUX
+        // The epoll path sleeps and dispatches internally, waking with
+        // exactly the ready descriptor set
+
+        // Block signals while doing io loops */
+        sigprocmask(SIG_BLOCK, &mask, &oldmask);
+
+        globalregistry->timetracker->Tick();
+
+        // Sleep only until the next timer deadline, capped at the old
+        // 100ms cadence, so short timers fire on schedule
+        int epoll_timeout =
+            (int) (globalregistry->timetracker->UsecToNextEvent(100000) / 1000);
+
+        if (pollabletracker->ProcessPollableEpoll(epoll_timeout) < 0) {
+            fprintf(stderr, "Main epoll failed: %s\n", strerror(errno));
+            snprintf(errstr, STATUS_MAX, "Main epoll loop failed: %s",
+                     strerror(errno));
+            CatchShutdown(-1);
+        }
+
+        sigprocmask(SIG_UNBLOCK, &mask, &oldmask);
+#else
         max_fd = pollabletracker->MergePollableFds(&rset, &wset);
 
+        // Sleep only until the next timer deadline, capped at the old
+        // 100ms cadence, so short timers fire on schedule
         tm.tv_sec = 0;
-        tm.tv_usec = 100000;
+        tm.tv_usec = globalregistry->timetracker->UsecToNextEvent(100000);
 
         if (select(max_fd + 1, &rset, &wset, NULL, &tm) < 0) {
             if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
@@ -1085,6 +1280,7 @@ int main(int argc, char *argv[], char *envp[]) {
         pollabletracker->ProcessPollableSelect(rset, wset);
 
         sigprocmask(SIG_UNBLOCK, &mask, &oldmask);
+#endif
 
         if (globalregistry->fatal_condition || globalregistry->spindown) {
             break;
@@ -10,6 +10,17 @@ import json
 import struct
 import sqlite3
 import sys
+import zlib
+
+# Newer logs compress device records with zlib; compressed rows carry the
+# standard zlib header, raw rows are plain json
+def decode_device(raw):
+    try:
+        raw = zlib.decompress(bytes(raw))
+    except zlib.error:
+        pass
+
+    return json.loads(str(raw))
 
 parser = argparse.ArgumentParser(description="Kismet to Pcap Log Converter")
 parser.add_argument("--in", action="store", dest="infile", help='Input (.kismet) file')
@@ -72,7 +83,7 @@ c = db.cursor()
 devs = []
 
 for row in c.execute(sql, replacements):
-    devs.append(json.loads(row[0]))
+    devs.append(decode_device(row[0]))
 
 if results.outfile:
     logf = open(results.outfile, "w")
@@ -10,9 +10,20 @@ import json
 import struct
 import sqlite3
 import sys
+import zlib
 import simplekml
 import re
 
+# Newer logs compress device records with zlib; compressed rows carry the
+# standard zlib header, raw rows are plain json
+def decode_device(raw):
+    try:
+        raw = zlib.decompress(bytes(raw))
+    except zlib.error:
+        pass
+
+    return json.loads(str(raw))
+
 parser = argparse.ArgumentParser(description="Kismet to KML Log Converter")
 parser.add_argument("--in", action="store", dest="infile", help='Input (.kismet) file')
 parser.add_argument("--out", action="store", dest="outfile", help='Output filename (optional)')
@@ -83,7 +94,7 @@ num_plotted = 0
 
 for row in c.execute(sql, replacements):
     try:
-        dev = json.loads(row[0])
+        dev = decode_device(row[0])
 
         # Check for the SSID if we're doing that; allow it to trip
         # a KeyError and jump out of processing this device
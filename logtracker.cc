@@ -20,13 +20,17 @@
 
 #include "getopt.h"
 
+#include <sys/stat.h>
+
 #include "logtracker.h"
+#include "timetracker.h"
 #include "globalregistry.h"
 #include "messagebus.h"
 #include "configfile.h"
 #include "alertracker.h"
 #include "structured.h"
 #include "kismet_json.h"
+#include "json_adapter.h"
 #include "base64.h"
 
 LogTracker::LogTracker(GlobalRegistry *in_globalreg) :
@@ -43,6 +47,11 @@ LogTracker::LogTracker(GlobalRegistry *in_globalreg) :
     register_fields();
     reserve_fields(NULL);
 
+    rotation_timer = -1;
+    last_rotation = 0;
+    rotate_time = 0;
+    rotate_size = 0;
+
 }
 
 LogTracker::~LogTracker() {
@@ -50,6 +59,11 @@ LogTracker::~LogTracker() {
 
     globalreg->RemoveGlobal("LOGTRACKER");
 
+    std::shared_ptr<Timetracker> timetracker =
+        Globalreg::FetchGlobalAs<Timetracker>(globalreg, "TIMETRACKER");
+    if (timetracker != NULL && rotation_timer >= 0)
+        timetracker->RemoveTimer(rotation_timer);
+
     TrackerElementVector v(logfile_vec);
 
     for (auto i : v) {
@@ -201,10 +215,44 @@ void LogTracker::Deferred_Startup() {
         open_log(logtype);
     }
 
+    // Start the rotation check if either trigger is configured
+    rotate_time = globalreg->kismet_config->FetchOptUInt("log_rotate_time", 0);
+    rotate_size = (uint64_t) globalreg->kismet_config->FetchOptUInt("log_rotate_size", 0) *
+        1024 * 1024;
+    last_rotation = time(0);
+
+    if (rotate_time != 0 || rotate_size != 0) {
+        _MSG("Rotating log files " +
+                std::string(rotate_time != 0 ?
+                    "every " + UIntToString(rotate_time) + " seconds" : "") +
+                std::string(rotate_time != 0 && rotate_size != 0 ? " or " : "") +
+                std::string(rotate_size != 0 ?
+                    "when larger than " +
+                    ULongToString(rotate_size / (1024 * 1024)) + "MB" : ""),
+                MSGFLAG_INFO);
+
+        std::shared_ptr<Timetracker> timetracker =
+            Globalreg::FetchMandatoryGlobalAs<Timetracker>(globalreg, "TIMETRACKER");
+
+        rotation_timer =
+            timetracker->RegisterTimer(SERVER_TIMESLICES_SEC * 10, NULL, 1,
+                    [this](int) -> int {
+                        rotate_logs();
+                        return 1;
+                    });
+    }
+
     return;
 }
 
 void LogTracker::Deferred_Shutdown() {
+    std::shared_ptr<Timetracker> timetracker =
+        Globalreg::FetchGlobalAs<Timetracker>(globalreg, "TIMETRACKER");
+    if (timetracker != NULL && rotation_timer >= 0) {
+        timetracker->RemoveTimer(rotation_timer);
+        rotation_timer = -1;
+    }
+
     TrackerElementVector logfiles(logfile_vec);
 
     for (auto l : logfiles) {
@@ -309,6 +357,104 @@ int LogTracker::close_log(SharedLogfile in_logfile) {
     return 1;
 }
 
+void LogTracker::rotate_logs() {
+    local_locker lock(&tracker_mutex);
+
+    bool rotate_all = false;
+
+    if (rotate_time != 0 && time(0) - last_rotation >= (time_t) rotate_time)
+        rotate_all = true;
+
+    TrackerElementVector logfiles(logfile_vec);
+
+    for (auto l : logfiles) {
+        SharedLogfile lf = std::static_pointer_cast<KisLogfile>(l);
+
+        if (!lf->get_log_open())
+            continue;
+
+        bool rotate = rotate_all;
+
+        // Check the on-disk size as well as the streamed size; block logs
+        // like the database don't count their stream size
+        if (!rotate && rotate_size != 0) {
+            uint64_t sz = lf->get_log_size();
+
+            struct stat st;
+            if (stat(lf->get_log_path().c_str(), &st) == 0 &&
+                    (uint64_t) st.st_size > sz)
+                sz = st.st_size;
+
+            if (sz >= rotate_size)
+                rotate = true;
+        }
+
+        if (!rotate)
+            continue;
+
+        // Expand a fresh path; the increment field keeps it from colliding
+        // with the file being rotated out
+        std::string newpath =
+            globalreg->kismet_config->ExpandLogPath(get_log_template(),
+                    get_log_title(), lf->get_builder()->get_log_class(), 1, 0);
+
+        _MSG("Rotating " + lf->get_builder()->get_log_class() + " log '" +
+                lf->get_log_path() + "' to '" + newpath + "'", MSGFLAG_INFO);
+
+        // Close flushes and finalizes the old file; the packet chain is
+        // never paused during the handoff, and anything logged in the
+        // brief window between close and open is shed by the log's own
+        // enabled checks
+        lf->Log_Close();
+
+        if (!lf->Log_Open(newpath)) {
+            _MSG("Failed to open rotated " + lf->get_builder()->get_log_class() +
+                    " log " + newpath, MSGFLAG_ERROR);
+        }
+    }
+
+    if (rotate_all)
+        last_rotation = time(0);
+}
+
+void LogTracker::log_device_snapshot(TrackerElementVector in_devices) {
+    std::vector<SharedLogfile> sinks;
+
+    // Snapshot the sinks under the tracker lock; serialization and the
+    // sink handoffs run outside it
+    {
+        local_locker lock(&tracker_mutex);
+
+        TrackerElementVector logfiles(logfile_vec);
+
+        for (auto l : logfiles) {
+            SharedLogfile lf = std::static_pointer_cast<KisLogfile>(l);
+
+            if (lf->get_log_open() && lf->Log_AcceptsDevices())
+                sinks.push_back(lf);
+        }
+    }
+
+    if (sinks.size() == 0)
+        return;
+
+    // Serialize each device exactly once for this cycle; every sink gets
+    // the same shared blob, so adding sinks adds handoffs, not
+    // serializations
+    for (auto d : in_devices) {
+        if (d == NULL)
+            continue;
+
+        std::stringstream sstr;
+        JsonAdapter::Pack(globalreg, sstr, d, NULL);
+
+        std::shared_ptr<const std::string> blob(new std::string(sstr.str()));
+
+        for (auto s : sinks)
+            s->Log_Device(d, blob);
+    }
+}
+
 void LogTracker::Usage(const char *argv0) {
     printf(" *** Logging Options ***\n");
 	printf(" -T, --log-types <types>      Override activated log types\n"
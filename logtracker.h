@@ -164,12 +164,20 @@ public:
         return false; 
     }
 
-    virtual void Log_Close() { 
+    virtual void Log_Close() {
         local_locker lock(&log_mutex);
 
         set_int_log_open(false);
     }
 
+    // Device snapshot fan-out.  Logs which record device snapshots override
+    // these; the json blob is the device record serialized once by the log
+    // tracker and shared by every sink in the snapshot cycle, so enabling
+    // more sinks doesn't multiply the serialization cost.
+    virtual bool Log_AcceptsDevices() { return false; }
+    virtual void Log_Device(SharedTrackerElement in_device __attribute__((unused)),
+            std::shared_ptr<const std::string> in_json __attribute__((unused))) { }
+
     __ProxyPrivSplit(log_uuid, uuid, uuid, uuid, log_uuid);
     __ProxyTrackable(builder, KisLogfileBuilder, builder);
     __ProxyPrivSplit(log_path, std::string, std::string, std::string, log_path);
@@ -238,6 +246,15 @@ public:
     // Close a log
     int close_log(SharedLogfile in_logfile);
 
+    // Rotate any open logs which have hit the rotation time or size,
+    // closing the current file and continuing in a freshly expanded path
+    void rotate_logs();
+
+    // Serialize-once device fan-out; each device in the snapshot is
+    // serialized a single time and the shared blob handed to every open
+    // log which accepts device records
+    void log_device_snapshot(TrackerElementVector in_devices);
+
     static void Usage(const char *argv0);
 private:
     LogTracker(GlobalRegistry *in_globalreg);
@@ -277,6 +294,12 @@ protected:
 
     SharedTrackerElement log_types_vec;
 
+    // Log rotation; 0 disables each trigger
+    int rotation_timer;
+    time_t last_rotation;
+    unsigned int rotate_time;
+    uint64_t rotate_size;
+
 };
 
 #endif
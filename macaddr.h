@@ -38,6 +38,7 @@
 #include <inttypes.h>
 #endif
 #include <algorithm>
+#include <functional>
 #include <string>
 #include <vector>
 #include <map>
@@ -220,12 +221,13 @@ struct mac_addr {
         return (longmac & op.longmac);
     }
 
-    // Masked MAC compare
+    // Masked MAC compare; branchless by comparing under the intersection
+    // of both masks, which for the subnet-style masks used here is the
+    // looser of the two
     inline bool operator== (const mac_addr& op) const {
-        if (longmask < op.longmask)
-            return ((longmac & longmask) == (op.longmac & longmask));
+        uint64_t cm = longmask & op.longmask;
 
-        return ((longmac & op.longmask) == (op.longmac & op.longmask));
+        return ((longmac & cm) == (op.longmac & cm));
     }
 
 	inline bool operator== (const unsigned long int op) const {
@@ -234,10 +236,9 @@ struct mac_addr {
 
     // MAC compare
     inline bool operator!= (const mac_addr& op) const {
-        if (longmask < op.longmask)
-            return ((longmac & longmask) != (op.longmac & longmask));
+        uint64_t cm = longmask & op.longmask;
 
-        return ((longmac & op.longmask) != (op.longmac & op.longmask));
+        return ((longmac & cm) != (op.longmac & cm));
     }
 
     // mac less-than-eq
@@ -336,6 +337,26 @@ struct mac_addr {
 
 };
 
+// Hash support so fully-specified MACs can key unordered containers; the
+// mask is mixed in so masked and unmasked copies of an address don't chain
+// on the same bucket.  Masked *matching* can't be done through a hash -
+// equality is mask-aware but hashing can't be - so mask-style filters
+// should stay in macmap below.
+namespace std {
+    template<> struct hash<mac_addr> {
+        inline std::size_t operator()(const mac_addr& ma) const {
+            uint64_t h = ma.longmac ^ (ma.longmask * 0x9E3779B97F4A7C15ULL);
+
+            // 64bit finalizing mix
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDULL;
+            h ^= h >> 33;
+
+            return (std::size_t) h;
+        }
+    };
+}
+
 
 // A templated container for storing groups of masked mac addresses.  A stl-map 
 // will work for single macs, but we need this for smart mask matching on 
@@ -27,6 +27,8 @@
 Manuf::Manuf(GlobalRegistry *in_globalreg) {
     globalreg = in_globalreg;
 
+    FILE *mfile = NULL;
+
     if (globalreg->kismet_config == NULL) {
         fprintf(stderr, "FATAL OOPS:  Manuf called before kismet_config\n");
         exit(1);
@@ -55,134 +57,82 @@ Manuf::Manuf(GlobalRegistry *in_globalreg) {
         return;
     }
 
-    IndexOUI();
+    LoadOUI(mfile);
+
+    fclose(mfile);
 }
 
-void Manuf::IndexOUI() {
+void Manuf::LoadOUI(FILE *mfile) {
     char buf[1024];
     int line = 0;
-    fpos_t prev_pos;
     short int m[3];
-    uint32_t last_oui = 0;
-
-    if (mfile == NULL)
-        return;
-
-    _MSG("Indexing manufacturer db", MSGFLAG_INFO);
+    char manuf[16];
+    bool sorted = true;
 
-    fgetpos(mfile, &prev_pos);
+    _MSG("Loading manufacturer db", MSGFLAG_INFO);
 
+    // The table is only a few MB of text; load the whole thing into a flat
+    // vector instead of seeking around the file per lookup
     while (!feof(mfile)) {
         if (fgets(buf, 1024, mfile) == NULL || feof(mfile))
             break;
 
-        if ((line % 50) == 0) {
-            if (sscanf(buf, "%hx:%hx:%hx",
-                       &(m[0]), &(m[1]), &(m[2])) == 3) {
-
-                // Log a position at the previous pos - which is the line before
-                // this one, so we're inclusive
-                index_pos ip;
-                uint32_t oui;
-
-                oui = 0;
-                oui |= (uint32_t) m[0] << 16;
-                oui |= (uint32_t) m[1] << 8;
-                oui |= (uint32_t) m[2];
-
-                if (oui < last_oui) {
-                    _MSG("Warning:  Manuf file appears to be out of order, expected "
-                            "sorted manuf OUI data", MSGFLAG_ERROR);
-                }
-
-                ip.oui = oui;
-                ip.pos = prev_pos;
-
-                last_oui = oui;
-
-                index_vec.push_back(ip);
-            } else {
-                // Compensate for not getting a reasonable line (probably a
-                // comment) by decrementing here so we keep trying at each
-                // index point until we get info we're looking for
-                line--;
-            }
-        }
-
-        fgetpos(mfile, &prev_pos);
         line++;
-    }
 
-    _MSG("Completed indexing manufacturer db, " + IntToString(line) + " lines " +
-         IntToString(index_vec.size()) + " indexes", MSGFLAG_INFO);
-}
+        // Skip anything that doesn't parse, probably a comment
+        if (sscanf(buf, "%hx:%hx:%hx\t%10s",
+                    &(m[0]), &(m[1]), &(m[2]), manuf) != 4)
+            continue;
 
-std::string Manuf::LookupOUI(mac_addr in_mac) {
-    uint32_t soui = in_mac.OUI(), toui;
-    int matched = -1;
-    char buf[1024];
-    short int m[3];
-    char manuf[16];
+        manuf_data md;
+        md.oui = mac_addr::OUI(m);
+        md.manuf = MungeToPrintable(std::string(manuf));
 
-    if (mfile == NULL)
-        return "Unknown";
+        if (oui_vec.size() > 0 && md.oui < oui_vec.back().oui)
+            sorted = false;
 
-    // Use the cache first
-    if (oui_map.find(soui) != oui_map.end()) {
-        return oui_map[soui].manuf;
+        oui_vec.push_back(md);
     }
 
-    for (unsigned int x = 0; x < index_vec.size(); x++) {
-        if (soui > index_vec[x].oui) {
-            matched = x;
-            continue;
-        }
+    // The shipped file is sorted already; tolerate one that isn't
+    if (!sorted) {
+        _MSG("Warning:  Manuf file appears to be out of order, expected "
+                "sorted manuf OUI data", MSGFLAG_ERROR);
 
-        break;
+        std::stable_sort(oui_vec.begin(), oui_vec.end(),
+                [](const manuf_data& a, const manuf_data& b) -> bool {
+                    return a.oui < b.oui;
+                });
     }
 
-    // Cache unknown to save us effort in the future
-    if (matched < 0) {
-        manuf_data md;
-        md.oui = soui;
-        md.manuf = "Unknown";
-        oui_map[soui] = md;
+    _MSG("Completed loading manufacturer db, " + IntToString(line) + " lines " +
+         IntToString(oui_vec.size()) + " entries", MSGFLAG_INFO);
+}
 
-        return md.manuf;
-    }
+std::string Manuf::LookupOUI(mac_addr in_mac) {
+    uint32_t soui = in_mac.OUI();
 
-    // Jump backwards one index in the matching unless we're in the first block
-    if (matched > 0)
-        matched -= 1;
+    // The table is immutable once loaded, so this is a lock-free probe of
+    // memory; lookups come from the packet workers and the parallel
+    // storage loader in bursts as new devices arrive
+    if (oui_vec.size() == 0)
+        return "Unknown";
 
-    fsetpos(mfile, &(index_vec[matched].pos));
+    unsigned int low = 0;
+    unsigned int high = oui_vec.size() - 1;
 
-    while (!feof(mfile)) {
-        if (fgets(buf, 1024, mfile) == NULL || feof(mfile))
-            break;
+    while (low <= high) {
+        unsigned int mid = low + ((high - low) / 2);
 
-        if (sscanf(buf, "%hx:%hx:%hx\t%10s",
-                   &(m[0]), &(m[1]), &(m[2]), manuf) == 4) {
-
-            // Log a position at the previous pos - which is the line before
-            // this one, so we're inclusive
-            toui = mac_addr::OUI(m);
-
-            if (toui == soui) {
-                manuf_data md;
-                md.oui = soui;
-                md.manuf = MungeToPrintable(std::string(manuf));
-                oui_map[soui] = md;
-                return md.manuf;
-            }
-
-            if (toui > soui) {
-                manuf_data md;
-                md.oui = soui;
-                md.manuf = "Unknown";
-                oui_map[soui] = md;
-                return md.manuf;
-            }
+        if (oui_vec[mid].oui == soui)
+            return oui_vec[mid].manuf;
+
+        if (oui_vec[mid].oui < soui) {
+            low = mid + 1;
+        } else {
+            if (mid == 0)
+                break;
+            high = mid - 1;
         }
     }
 
@@ -32,6 +32,8 @@
 #ifdef HAVE_INTTYPES_H
 #include <inttypes.h>
 #endif
+#include <vector>
+
 #include "util.h"
 #include "globalregistry.h"
 
@@ -40,28 +42,22 @@ public:
 	Manuf() { fprintf(stderr, "FATAL OOPS: Manuf()\n"); exit(1); }
 	Manuf(GlobalRegistry *in_globalreg);
 
-	void IndexOUI();
-
 	std::string LookupOUI(mac_addr in_mac);
 
-	struct index_pos {
-		uint32_t oui;
-		fpos_t pos;
-	};
-
 	struct manuf_data {
 		uint32_t oui;
 		std::string manuf;
-	}; 
+	};
 
 protected:
-	GlobalRegistry *globalreg;
+	void LoadOUI(FILE *mfile);
 
-	std::vector<index_pos> index_vec;
-
-	std::map<uint32_t, manuf_data> oui_map;
+	GlobalRegistry *globalreg;
 
-	FILE *mfile;
+	// Complete OUI table, sorted by OUI; loaded once at startup and
+	// immutable afterwards, so lookups from the packet workers and the
+	// parallel storage loader binary-search it with no locking
+	std::vector<manuf_data> oui_vec;
 };
 
 #endif
@@ -21,6 +21,9 @@
 #include "messagebus.h"
 #include "entrytracker.h"
 
+// For the mpsc ring shared with the packet chain
+#include "packetchain.h"
+
 #include "util.h"
 
 void StdoutMessageClient::ProcessMessage(std::string in_msg, int in_flags) {
@@ -34,16 +37,80 @@ void StdoutMessageClient::ProcessMessage(std::string in_msg, int in_flags) {
 
 MessageBus::MessageBus(GlobalRegistry *in_globalreg) {
     globalreg = in_globalreg;
+
+    dispatch_shutdown = false;
+    dispatch_sleeping = false;
+    dropped_messages = 0;
+
+    // The bus comes up before the config is parsed so the ring is a
+    // fixed size; messages are low-rate compared to packets and only
+    // overflow when something is flooding status output
+    msg_queue = new mpsc_bounded_queue<stored_msg *>(1024);
+
+    pthread_create(&dispatch_thread, NULL,
+            &MessageBus::message_dispatch_processor, this);
 }
 
 MessageBus::~MessageBus() {
+    // Stop the dispatch thread, which drains anything already queued
+    // before exiting
+    dispatch_shutdown = true;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (dispatch_sleeping.load())
+        dispatch_condition.unlock();
+
+    pthread_join(dispatch_thread, NULL);
+
+    delete msg_queue;
+
     local_eol_locker lock(&msg_mutex);
 
     globalreg->RemoveGlobal("MESSAGEBUS");
     globalreg->messagebus = NULL;
 }
 
-void MessageBus::InjectMessage(std::string in_msg, int in_flags) {
+void *MessageBus::message_dispatch_processor(void *in_arg) {
+    MessageBus *bus = (MessageBus *) in_arg;
+    stored_msg *msg = NULL;
+
+    while (1) {
+        // Drain everything queued before honoring a shutdown so no
+        // accepted message goes undelivered
+        if (bus->msg_queue->dequeue(msg)) {
+            bus->SyncDispatch(msg->msg, msg->flags);
+            delete msg;
+
+            // Surface any overflow once the ring has room again
+            uint64_t dropped = bus->dropped_messages.exchange(0);
+            if (dropped != 0) {
+                bus->SyncDispatch("The message bus dropped " +
+                        ULongToString(dropped) + " messages; something is "
+                        "flooding status messages.", MSGFLAG_ERROR);
+            }
+
+            continue;
+        }
+
+        if (bus->dispatch_shutdown)
+            return NULL;
+
+        bus->dispatch_condition.lock();
+        bus->dispatch_sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (bus->msg_queue->approx_size() != 0 ||
+                bus->dispatch_shutdown) {
+            bus->dispatch_sleeping.store(false);
+            bus->dispatch_condition.unlock();
+            continue;
+        }
+
+        bus->dispatch_condition.block_until();
+        bus->dispatch_sleeping.store(false);
+    }
+}
+
+void MessageBus::SyncDispatch(std::string in_msg, int in_flags) {
     local_locker lock(&msg_mutex);
 
     for (unsigned int x = 0; x < subscribers.size(); x++) {
@@ -54,6 +121,34 @@ void MessageBus::InjectMessage(std::string in_msg, int in_flags) {
     return;
 }
 
+void MessageBus::InjectMessage(std::string in_msg, int in_flags) {
+    // Fatal messages are delivered synchronously; the caller typically
+    // terminates right behind them and they can't be left in the queue
+    if (in_flags & MSGFLAG_FATAL) {
+        SyncDispatch(in_msg, in_flags);
+        return;
+    }
+
+    stored_msg *msg = new stored_msg;
+    msg->msg = in_msg;
+    msg->flags = in_flags;
+
+    if (!msg_queue->enqueue(msg)) {
+        // The ring is single-consumer so the producer side can't safely
+        // evict the oldest record; shed the incoming message and count it
+        delete msg;
+        dropped_messages++;
+        return;
+    }
+
+    // Wake the dispatcher only if it's advertised that it's asleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (dispatch_sleeping.load())
+        dispatch_condition.unlock();
+
+    return;
+}
+
 void MessageBus::RegisterClient(MessageClient *in_subscriber, int in_mask) {
     local_locker lock(&msg_mutex);
 
@@ -22,11 +22,18 @@
 
 #include "config.h"
 
+#include <pthread.h>
+
+#include <atomic>
 #include <string>
 #include <vector>
 
 #include "globalregistry.h"
 #include "kis_mutex.h"
+#include "util.h"
+
+// Queue ring shared with the packetchain; only held by pointer here
+template<class t> class mpsc_bounded_queue;
 
 // Message flags for queuing data
 #define MSGFLAG_NONE    0
@@ -92,7 +99,10 @@ private:
 public:
     virtual ~MessageBus();
 
-    // Inject a message into the bus
+    // Inject a message into the bus.  Normal messages are queued and
+    // dispatched from a dedicated thread so a slow subscriber never
+    // back-pressures the caller; fatal messages are delivered inline
+    // because the caller is usually about to terminate behind them.
     void InjectMessage(std::string in_msg, int in_flags);
 
     // Link a meessage display system
@@ -110,6 +120,29 @@ protected:
     } busclient;
 
     std::vector<MessageBus::busclient *> subscribers;
+
+    // Queued message record handed from the producer to the dispatcher
+    struct stored_msg {
+        std::string msg;
+        int flags;
+    };
+
+    // Deliver a message to every matching subscriber, synchronously
+    void SyncDispatch(std::string in_msg, int in_flags);
+
+    // Dedicated dispatch thread; drains the ring and hands messages to
+    // the subscribers so injection is constant-time for the producer
+    static void *message_dispatch_processor(void *in_arg);
+
+    mpsc_bounded_queue<stored_msg *> *msg_queue;
+    conditional_locker<int> dispatch_condition;
+    std::atomic<bool> dispatch_sleeping;
+    std::atomic<bool> dispatch_shutdown;
+    pthread_t dispatch_thread;
+
+    // Messages shed when the ring is full; surfaced by the dispatcher
+    // once there's room again
+    std::atomic<uint64_t> dropped_messages;
 };
 
 
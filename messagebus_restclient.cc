@@ -52,8 +52,6 @@ RestMessageClient::~RestMessageClient() {
     globalreg->messagebus->RemoveClient(this);
 
     globalreg->RemoveGlobal("REST_MSG_CLIENT");
-
-    message_vec.clear();
 }
 
 void RestMessageClient::ProcessMessage(std::string in_msg, int in_flags) {
@@ -61,20 +59,42 @@ void RestMessageClient::ProcessMessage(std::string in_msg, int in_flags) {
     if (in_flags & MSGFLAG_LOCAL)
         return;
 
-    std::shared_ptr<tracked_message> msg = 
+    std::shared_ptr<tracked_message> msg =
         std::static_pointer_cast<tracked_message>(globalreg->entrytracker->GetTrackedInstance(message_entry_id));
 
     msg->set_from_message(in_msg, in_flags);
 
+    // Serialize once, outside the lock; every future poll of this message is
+    // a plain string copy out of the ring
+    std::stringstream ss;
+    JsonAdapter::Pack(globalreg, ss, msg, NULL);
+
     {
         local_locker lock(&msg_mutex);
 
-        message_vec.push_back(msg);
+        std::shared_ptr<const std::vector<retained_message> > old =
+            std::atomic_load(&message_snapshot);
+
+        std::shared_ptr<std::vector<retained_message> > next(new std::vector<retained_message>());
+        next->reserve(message_retain_len);
+
+        // Carry over the newest retain-1 messages, leaving room for ours
+        if (old != NULL) {
+            size_t start = 0;
+
+            if (old->size() >= message_retain_len)
+                start = old->size() - (message_retain_len - 1);
 
-        // Hardcode a backlog count right now
-        if (message_vec.size() > 50) {
-            message_vec.erase(message_vec.begin());
+            next->insert(next->end(), old->begin() + start, old->end());
         }
+
+        retained_message rm;
+        rm.ts = msg->get_timestamp();
+        rm.json = ss.str();
+        next->push_back(rm);
+
+        std::atomic_store(&message_snapshot,
+                std::shared_ptr<const std::vector<retained_message> >(next));
     }
 }
 
@@ -148,33 +168,46 @@ void RestMessageClient::Httpd_CreateStreamResponse(
         }
     }
 
-    {
-        local_locker lock(&msg_mutex);
+    // Wait-free read; grab the current snapshot and work entirely from it,
+    // never competing with injection for the mutex
+    std::shared_ptr<const std::vector<retained_message> > snap =
+        std::atomic_load(&message_snapshot);
 
-        SharedTrackerElement wrapper;
-        SharedTrackerElement msgvec(globalreg->entrytracker->GetTrackedInstance(message_vec_id));
-       
-        // If we're doing a time-since, wrap the vector
-        if (wrap) {
-            wrapper.reset(new TrackerElement(TrackerMap));
-            wrapper->add_map(msgvec);
-
-            SharedTrackerElement ts =
-                globalreg->entrytracker->GetTrackedInstance(message_timestamp_id);
-            ts->set((uint64_t) globalreg->timestamp.tv_sec);
-            wrapper->add_map(ts);
-        } else {
-            wrapper = msgvec;
-        }
+    // Fast path for pollers - nothing retained, or nothing newer than the
+    // requested timestamp
+    if (wrap && (snap == NULL || since_time >= snap->back().ts)) {
+        stream << "{\"kismet.messagebus.list\": [],\"kismet.messagebus.timestamp\": " <<
+            globalreg->timestamp.tv_sec << "}";
+        return;
+    }
 
-        for (std::vector<std::shared_ptr<tracked_message> >::iterator i = message_vec.begin();
-                i != message_vec.end(); ++i) {
-            if (since_time < (*i)->get_timestamp()) {
-                msgvec->add_vector(*i);
-            }
-        }
+    // The response is a concatenation of fragments serialized at inject
+    // time; the wrapper mirrors the registered kismet.messagebus.list /
+    // kismet.messagebus.timestamp fields
+    if (wrap)
+        stream << "{\"kismet.messagebus.list\": ";
+
+    bool first = true;
+
+    stream << "[";
 
-        Httpd_Serialize(path, stream, wrapper);
+    if (snap != NULL) {
+        for (auto i = snap->begin(); i != snap->end(); ++i) {
+            if (since_time >= i->ts)
+                continue;
+
+            if (!first)
+                stream << ",";
+            first = false;
+
+            stream << i->json;
+        }
     }
+
+    stream << "]";
+
+    if (wrap)
+        stream << ",\"kismet.messagebus.timestamp\": " <<
+            globalreg->timestamp.tv_sec << "}";
 }
 
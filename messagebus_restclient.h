@@ -22,6 +22,7 @@
 
 #include "config.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -114,9 +115,27 @@ public:
             size_t *upload_data_size, std::stringstream &stream);
 
 protected:
+    // Serializes message injection only; the endpoints never take it
     kis_recursive_timed_mutex msg_mutex;
 
-    std::vector<std::shared_ptr<tracked_message> > message_vec;
+    // Retained messages are kept as pre-serialized JSON fragments; the
+    // serialization cost is paid once at inject time and the endpoints just
+    // concatenate the retained fragments.  Only the .json suffix is accepted
+    // on these paths so a cached JSON form is always faithful.
+    struct retained_message {
+        time_t ts;
+        std::string json;
+    };
+
+    static const size_t message_retain_len = 50;
+
+    // The retained window, oldest first, published as an immutable snapshot
+    // swapped with std::atomic_load/atomic_store.  Endpoint reads are
+    // wait-free - they grab the current snapshot and walk it - so polling
+    // /messagebus stays cheap even when the engine is saturated and message
+    // injection is backed up.  Rebuilding the snapshot on inject is cheap
+    // because messages are rare and the window is small.
+    std::shared_ptr<const std::vector<retained_message> > message_snapshot;
 
     int message_vec_id, message_entry_id, message_timestamp_id;
 };
@@ -0,0 +1,117 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __NMEA_PARSE_H__
+#define __NMEA_PARSE_H__
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Zero-allocation helpers for walking NMEA and gpsd line protocols directly
+// in the ring buffer peek region; sentences are split into field views which
+// point at the original buffer, and individual fields are copied to a small
+// stack buffer only when a scanf-style conversion needs a terminated string.
+
+// Field view into a delimited sentence; points at the original buffer
+struct nmea_field_view {
+    const char *data;
+    size_t len;
+
+    bool equals(const char *str) const {
+        size_t sl = strlen(str);
+        return len == sl && memcmp(data, str, sl) == 0;
+    }
+
+    // Copy out to a bounded stack buffer for scanf-style parsers; returns
+    // the NUL-terminated buffer
+    const char *to_buf(char *buf, size_t buf_sz) const {
+        size_t l = len;
+
+        if (l >= buf_sz)
+            l = buf_sz - 1;
+
+        memcpy(buf, data, l);
+        buf[l] = 0;
+
+        return buf;
+    }
+};
+
+// Split a sentence on a delimiter into field views, up to max_fields;
+// returns the number of fields.  Empty fields are preserved.
+inline size_t nmea_split(const char *line, size_t len, char delim,
+        nmea_field_view *fields, size_t max_fields) {
+    size_t num_fields = 0;
+    size_t start = 0;
+
+    for (size_t pos = 0; pos <= len; pos++) {
+        if (pos == len || line[pos] == delim) {
+            if (num_fields >= max_fields)
+                return num_fields;
+
+            fields[num_fields].data = line + start;
+            fields[num_fields].len = pos - start;
+            num_fields++;
+
+            start = pos + 1;
+        }
+    }
+
+    return num_fields;
+}
+
+inline bool nmea_field_float(const nmea_field_view& f, float *ret) {
+    char tmp[32];
+    return sscanf(f.to_buf(tmp, sizeof(tmp)), "%f", ret) == 1;
+}
+
+inline bool nmea_field_double(const nmea_field_view& f, double *ret) {
+    char tmp[32];
+    return sscanf(f.to_buf(tmp, sizeof(tmp)), "%lf", ret) == 1;
+}
+
+inline bool nmea_field_int(const nmea_field_view& f, int *ret) {
+    char tmp[32];
+    return sscanf(f.to_buf(tmp, sizeof(tmp)), "%d", ret) == 1;
+}
+
+// NMEA ddmm.mmmm / dddmm.mmmm coordinate; deg_digits is 2 for latitude and
+// 3 for longitude
+inline bool nmea_field_coord(const nmea_field_view& f, int deg_digits,
+        double *ret) {
+    char tmp[32];
+    int tint;
+    float tfloat;
+
+    if (deg_digits == 2) {
+        if (sscanf(f.to_buf(tmp, sizeof(tmp)), "%2d%f", &tint, &tfloat) != 2)
+            return false;
+    } else {
+        if (sscanf(f.to_buf(tmp, sizeof(tmp)), "%3d%f", &tint, &tfloat) != 2)
+            return false;
+    }
+
+    *ret = (float) tint + (tfloat / 60);
+
+    return true;
+}
+
+#endif
@@ -32,9 +32,26 @@
 
 #include "globalregistry.h"
 #include "packetchain.h"
+#include "kis_mempool.h"
 #include "macaddr.h"
 #include "packet_ieee80211.h"
 
+void *kis_packet::operator new(size_t sz) {
+    void *p = kis_mem_pool::take(sz);
+
+    if (p != NULL)
+        return p;
+
+    return ::operator new(sz);
+}
+
+void kis_packet::operator delete(void *p) {
+    if (kis_mem_pool::give(p))
+        return;
+
+    ::operator delete(p);
+}
+
 kis_packet::kis_packet(GlobalRegistry *in_globalreg) {
 	globalreg = in_globalreg;
 
@@ -42,12 +59,12 @@ kis_packet::kis_packet(GlobalRegistry *in_globalreg) {
 	filtered = 0;
     duplicate = 0;
 
-	// Stock and init the content vector
-	content_vec.resize(MAX_PACKET_COMPONENTS, NULL);
-	/*
-	   for (unsigned int y = 0; y < MAX_PACKET_COMPONENTS; y++)
-	   content_vec[y] = NULL;
-	   */
+	gen_monotime.tv_sec = 0;
+	gen_monotime.tv_nsec = 0;
+
+	// Zero the in-object content slots
+	for (unsigned int y = 0; y < MAX_PACKET_COMPONENTS; y++)
+		content_vec[y] = NULL;
 }
 
 kis_packet::~kis_packet() {
@@ -59,14 +76,42 @@ kis_packet::~kis_packet() {
 		if (pcm == NULL)
 			continue;
 
-		// If it's marked for self-destruction, delete it.  Otherwise, 
-		// someone else is responsible for removing it.
-		if (pcm->self_destruct)
+		// Components drawn from a pool go home to be recycled; otherwise,
+		// if it's marked for self-destruction, delete it.  Anything else
+		// is someone else's responsibility to remove.
+		if (pcm->component_pool != NULL)
+			pcm->component_pool->release(pcm);
+		else if (pcm->self_destruct)
 			delete pcm;
 
 		content_vec[y] = NULL;
 	}
 }
+
+void kis_packet::reset() {
+	// Strip the components as the destructor would, but leave the packet
+	// itself intact for recycling
+	for (unsigned int y = 0; y < MAX_PACKET_COMPONENTS; y++) {
+		packet_component *pcm = content_vec[y];
+
+		if (pcm == NULL)
+			continue;
+
+		if (pcm->component_pool != NULL)
+			pcm->component_pool->release(pcm);
+		else if (pcm->self_destruct)
+			delete pcm;
+
+		content_vec[y] = NULL;
+	}
+
+	error = 0;
+	filtered = 0;
+	duplicate = 0;
+
+	gen_monotime.tv_sec = 0;
+	gen_monotime.tv_nsec = 0;
+}
    
 void kis_packet::insert(const unsigned int index, packet_component *data) {
 	if (index >= MAX_PACKET_COMPONENTS)
@@ -78,13 +123,6 @@ void kis_packet::insert(const unsigned int index, packet_component *data) {
 	content_vec[index] = data;
 }
 
-void *kis_packet::fetch(const unsigned int index) const {
-	if (index >= MAX_PACKET_COMPONENTS)
-		return NULL;
-
-	return content_vec[index];
-}
-
 void kis_packet::erase(const unsigned int index) {
 	if (index >= MAX_PACKET_COMPONENTS)
 		return;
@@ -93,7 +131,9 @@ void kis_packet::erase(const unsigned int index) {
 	// memory.  Whatever inserted it had better expect this
 	// to happen or it will be very unhappy
 	if (content_vec[index] != NULL) {
-		if (content_vec[index]->self_destruct)
+		if (content_vec[index]->component_pool != NULL)
+			content_vec[index]->component_pool->release(content_vec[index]);
+		else if (content_vec[index]->self_destruct)
 			delete content_vec[index];
 
 		content_vec[index] = NULL;
@@ -34,6 +34,7 @@
 #include <map>
 
 #include "globalregistry.h"
+#include "kis_mutex.h"
 #include "macaddr.h"
 #include "packet_ieee80211.h"
 #include "trackedelement.h"
@@ -50,12 +51,85 @@
 // even when we don't have pcap
 #define KDLT_IEEE802_11			105
 
+class packet_component_pool_base;
+
 // High-level packet component so that we can provide our own destructors
 class packet_component {
 public:
-    packet_component() { self_destruct = 1; };
+    packet_component() { self_destruct = 1; component_pool = NULL; };
 	virtual ~packet_component() { }
+
+	// Return to a pristine state for recycling through a component pool;
+	// subclasses drawn from pools must clear everything their constructor
+	// would have set
+	virtual void reset() { }
+
 	int self_destruct;
+
+	// Owning recycler, if any; when set, the packet returns the component
+	// here instead of deleting it
+	packet_component_pool_base *component_pool;
+};
+
+// Type-erased base so a packet can hand components back to their pools
+// without knowing the concrete type
+class packet_component_pool_base {
+public:
+    virtual ~packet_component_pool_base() { }
+    virtual void release(packet_component *in_component) = 0;
+};
+
+// Recycling pool for a single component type; dissectors which generate a
+// component for nearly every packet can draw from one of these instead of
+// making an allocator round-trip per packet.  Components are reset and
+// cached on release, up to a cap, and automatically find their way home
+// when the packet is destroyed.
+template<class ctype>
+class packet_component_pool : public packet_component_pool_base {
+public:
+    packet_component_pool(size_t in_max = 4096) :
+        max_components {in_max} { }
+
+    virtual ~packet_component_pool() {
+        local_locker lock(&pool_mutex);
+
+        for (auto c : component_cache)
+            delete c;
+    }
+
+    ctype *acquire() {
+        local_locker lock(&pool_mutex);
+
+        ctype *c;
+
+        if (component_cache.size() > 0) {
+            c = component_cache.back();
+            component_cache.pop_back();
+        } else {
+            c = new ctype();
+        }
+
+        c->component_pool = this;
+
+        return c;
+    }
+
+    virtual void release(packet_component *in_component) {
+        local_locker lock(&pool_mutex);
+
+        if (component_cache.size() >= max_components) {
+            delete in_component;
+            return;
+        }
+
+        in_component->reset();
+        component_cache.push_back(static_cast<ctype *>(in_component));
+    }
+
+protected:
+    kis_recursive_timed_mutex pool_mutex;
+    std::vector<ctype *> component_cache;
+    size_t max_components;
 };
 
 // Overall packet container that holds packet information
@@ -64,6 +138,12 @@ public:
     // Time of packet creation
     struct timeval ts;
 
+    // Monotonic time the packet object was issued by the packet chain;
+    // compared against a second monotonic read when the logging stage
+    // finishes with the packet to derive end-to-end pipeline latency.
+    // Distinct from ts, which is capture time and may come from the radio
+    struct timespec gen_monotime;
+
     // Do we know this is in error from the capture source
     // itself?
     int error;
@@ -74,9 +154,11 @@ public:
     // Are we a duplicate?
     int duplicate;
 
-	// Actual vector of bits in the packet
-    std::vector<packet_component *> content_vec;
-   
+	// Fixed component slot array, indexed by component id; lives inside the
+	// packet object itself so a packet costs one allocation and component
+	// lookups are a bounds check and an array index
+    packet_component *content_vec[MAX_PACKET_COMPONENTS];
+
     // Init stuff
     kis_packet() {
 		fprintf(stderr, "FATAL: kis_packet()\n"); exit(1);
@@ -84,11 +166,29 @@ public:
 
 	kis_packet(GlobalRegistry *in_globalreg);
     ~kis_packet();
-   
+
+    // When the preallocated memory pool is active, packet objects are
+    // carved from it instead of the heap; the packetchain recycling pool
+    // and all other new/delete call sites work unchanged
+    static void *operator new(size_t sz);
+    static void operator delete(void *p);
+
+    // Strip all components and flags so the packet object itself can be
+    // recycled through the packetchain packet pool instead of freed
+    void reset();
+
     void insert(const unsigned int index, packet_component *data);
-    void *fetch(const unsigned int index) const;
     void erase(const unsigned int index);
 
+    // Called for most components on most packets across the whole chain, so
+    // keep it a branch and an indexed load
+    inline void *fetch(const unsigned int index) const {
+		if (index >= MAX_PACKET_COMPONENTS)
+			return NULL;
+
+		return content_vec[index];
+    }
+
     inline packet_component *operator[] (const unsigned int& index) const {
 		if (index >= MAX_PACKET_COMPONENTS)
 			return NULL;
@@ -177,7 +277,11 @@ public:
 	int dlt;
 	uint16_t source_id;
 	bool self_data;
-   
+
+	// Buffer adopted wholesale from a producer via the move-based
+	// set_data; when populated, 'data' points into it
+    std::string owned_data;
+
     kis_datachunk() {
 		self_destruct = 1; // Our delete() handles everything
 		self_data = true; // We assume for now we have our own data alloc
@@ -193,11 +297,41 @@ public:
         length = 0;
     }
 
+	virtual void reset() {
+		if (data != NULL && self_data)
+			delete[] data;
+
+		// Drop content but keep the capacity for the next adopted buffer
+		owned_data.clear();
+
+		self_data = true;
+		data = NULL;
+		length = 0;
+		dlt = 0;
+		source_id = 0;
+	}
+
+	// Zero-copy ingest path; steal the contents of a producer-side buffer
+	// (such as a decoded report payload) rather than copying it.  The
+	// producer's string is left empty.
+	virtual void set_data(std::string& in_data) {
+		if (data != NULL && self_data)
+			delete[] data;
+
+		owned_data = std::move(in_data);
+
+		data = (uint8_t *) owned_data.data();
+		length = owned_data.length();
+		self_data = false;
+	}
+
 	// Default to copy=true; it's always safe to copy, it's not always safe not to
 	virtual void set_data(uint8_t *in_data, unsigned int in_length, bool copy = true) {
 		if (data != NULL && self_data)
 			delete[] data;
 
+		owned_data.clear();
+
 		if (copy) {
 			data = new uint8_t[in_length];
 			memcpy(data, in_data, in_length);
@@ -214,6 +348,8 @@ public:
 		if (data != NULL && self_data)
 			delete[] data;
 
+		owned_data.clear();
+
         data = new uint8_t[in_length];
         memcpy(data, in_data, in_length);
         self_data = true;
@@ -244,6 +380,12 @@ public:
 		checksum_valid = 0;
 	}
 
+	virtual void reset() {
+		kis_datachunk::reset();
+		checksum_valid = 0;
+		checksum_ptr = NULL;
+	}
+
 	virtual void set_data(uint8_t *in_data, unsigned int in_length, bool copy = true) {
 		kis_datachunk::set_data(in_data, in_length, copy);
 		checksum_ptr = (uint32_t *) data;
@@ -282,6 +424,10 @@ public:
     kis_common_info() {
         self_destruct = 1;
 
+        kis_common_info::reset();
+    }
+
+    virtual void reset() {
         type = packet_basic_unknown;
         direction = packet_direction_unknown;
 
@@ -330,6 +476,10 @@ public:
 		self_destruct = 1;
 	}
 
+	virtual void reset() {
+		extracted_strings.clear();
+	}
+
     std::vector<std::string> extracted_strings;
 };
 
@@ -362,6 +512,11 @@ class kis_data_packinfo : public packet_component {
 public:
 	kis_data_packinfo() {
 		self_destruct = 1; // Safe to delete us
+
+		kis_data_packinfo::reset();
+	}
+
+	virtual void reset() {
 		proto = proto_unknown;
 		ip_source_port = 0;
 		ip_dest_port = 0;
@@ -371,6 +526,12 @@ public:
 		ip_gateway_addr.s_addr = 0;
 		field1 = 0;
         ivset[0] = ivset[1] = ivset[2] = 0;
+		ip_type = proto_unknown;
+		cdp_dev_id.clear();
+		cdp_port_id.clear();
+		discover_host.clear();
+		discover_vendor.clear();
+		auxstring.clear();
 	}
 
 	kis_protocol_info_type proto;
@@ -415,6 +576,11 @@ class kis_layer1_packinfo : public packet_component {
 public:
 	kis_layer1_packinfo() {
 		self_destruct = 1;  // Safe to delete us
+
+		kis_layer1_packinfo::reset();
+	}
+
+	virtual void reset() {
         signal_type = kis_l1_signal_type_none;
 		signal_dbm = noise_dbm = 0;
 		signal_rssi = noise_rssi = 0;
@@ -424,6 +590,7 @@ public:
 		freq_khz = 0;
 		accuracy = 0;
 		channel = "0";
+		content_checkum = 0;
 	}
 
 	// How "accurate" are we?  Higher == better.  Nothing uses this yet
@@ -32,6 +32,9 @@
 #include "configfile.h"
 #include "packetchain.h"
 #include "alertracker.h"
+#include "kis_perfcounter.h"
+#include "kis_threads.h"
+#include "entrytracker.h"
 
 class SortLinkPriority {
 public:
@@ -48,7 +51,8 @@ Packetchain::Packetchain() {
 	exit(-1);
 }
 
-Packetchain::Packetchain(GlobalRegistry *in_globalreg) {
+Packetchain::Packetchain(GlobalRegistry *in_globalreg) :
+    Kis_Net_Httpd_CPPStream_Handler(in_globalreg) {
     globalreg = in_globalreg;
     next_componentid = 1;
 	next_handlerid = 1;
@@ -56,18 +60,70 @@ Packetchain::Packetchain(GlobalRegistry *in_globalreg) {
     last_packet_queue_user_warning = 0;
     last_packet_drop_user_warning = 0;
 
-    packet_queue_warning = 
+    // The alert tracker doesn't exist yet; resolve the ref now and fetch
+    // by index when we need it
+    alertracker_ref = globalreg->RegisterGlobal("ALERTTRACKER");
+
+    kis_mutex_set_name(&packetchain_mutex, "packetchain");
+
+    packet_queue_warning =
         globalreg->kismet_config->FetchOptUInt("packet_log_warning", 0);
     packet_queue_drop =
         globalreg->kismet_config->FetchOptUInt("packet_backlog_limit", 8192);
 
+    packet_chain_threads =
+        globalreg->kismet_config->FetchOptUInt("packet_chain_threads", 1);
+
+    profile_handlers =
+        globalreg->kismet_config->FetchOptBoolean("packet_chain_profiling", 0);
+
+    timing_vec_id =
+        globalreg->entrytracker->RegisterField("kismet.packetchain.timing_list",
+                TrackerVector, "list of per-handler timing records");
+
+    std::shared_ptr<tracked_handler_timing>
+        timing_builder(new tracked_handler_timing(globalreg, 0));
+
+    timing_entry_id =
+        globalreg->entrytracker->RegisterField("kismet.packetchain.handler_timing",
+                timing_builder, "packet chain handler timing");
+
+    latency_vec_id =
+        globalreg->entrytracker->RegisterField("kismet.packetchain.latency_list",
+                TrackerVector, "list of per-source latency records");
+
+    std::shared_ptr<tracked_packet_latency>
+        latency_builder(new tracked_packet_latency(globalreg, 0));
+
+    latency_entry_id =
+        globalreg->entrytracker->RegisterField("kismet.packetchain.packet_latency",
+                latency_builder, "end-to-end packet latency");
+
+    // 0 means 'however many CPUs we have'; never less than one worker
+    if (packet_chain_threads == 0)
+        packet_chain_threads = std::thread::hardware_concurrency();
+    if (packet_chain_threads == 0)
+        packet_chain_threads = 1;
+
+    if (packet_chain_threads > 1)
+        _MSG("Packet chain spawning " + UIntToString(packet_chain_threads) +
+                " processing threads", MSGFLAG_INFO);
+
     packetchain_shutdown = false;
+    packet_queue_count = 0;
+    dropped_packets = 0;
+
+    active_sources = 0;
+    for (unsigned int s = 0; s < PACKETCHAIN_SOURCE_SLOTS; s++)
+        source_backlog[s] = 0;
 
-    // Lock the packet conditional
-    packet_condition.lock();
+    // We need the component ids used to derive ordering domains before any
+    // packets show up; registration is shared with the eventual real users
+    pack_comp_linkframe = RegisterPacketComponent("LINKFRAME");
+    pack_comp_common = RegisterPacketComponent("COMMON");
 
-    // Create a pthread thread because we have to manipulate the stack size;
-    // The decoder thread handles almost everything about a packet and some
+    // Create pthread threads because we have to manipulate the stack size;
+    // The decoder threads handle almost everything about a packet and some
     // libcs seem to limit us in bad ways
     pthread_attr_t attr;
     pthread_attr_init(&attr);
@@ -75,17 +131,103 @@ Packetchain::Packetchain(GlobalRegistry *in_globalreg) {
      * Disable - doesn't fix musl bug, might break other platforms
     pthread_attr_setstacksize(&attr, (1024 * 1024 * 8));
     */
-    pthread_create(&packet_thread, &attr, Packetchain::packet_queue_processor, (void *) this);
+
+    // Size the ingest rings off the backlog limit so a full ring carries the
+    // drop semantics; a limit of 0 historically meant 'unbounded', which a
+    // lock-free ring can't honor, so pick a deep default instead
+    size_t ring_sz = packet_queue_drop;
+    if (ring_sz == 0)
+        ring_sz = 65536;
+
+    // Keep at most a full backlog's worth of stripped packets around for
+    // recycling; past that we fall back to the allocator
+    packet_pool_max = ring_sz;
+
+    for (unsigned int t = 0; t < packet_chain_threads; t++) {
+        packet_work_unit *unit = new packet_work_unit(ring_sz);
+        unit->packetchain = this;
+        unit->unit_number = t;
+
+        // Lock the packet conditional
+        unit->packet_condition.lock();
+
+        work_units.push_back(unit);
+
+        pthread_create(&(unit->packet_thread), &attr,
+                Packetchain::packet_queue_processor, (void *) unit);
+    }
+
+    // Spawn the asynchronous logging stage with its own queue so sqlite and
+    // pcap writes never stall dissection
+    logging_unit = new packet_work_unit(ring_sz);
+    logging_unit->packetchain = this;
+    logging_unit->unit_number = 0;
+    logging_unit->packet_condition.lock();
+
+    pthread_create(&(logging_unit->packet_thread), &attr,
+            Packetchain::logging_queue_processor, (void *) logging_unit);
+
+    // Publish health counters if the perf registry is up; the counters
+    // themselves are our own atomics, the registry only samples them
+    std::shared_ptr<PerfCounterRegistry> perfcounters =
+        Globalreg::FetchGlobalAs<PerfCounterRegistry>(globalreg, "PERFCOUNTERS");
+
+    if (perfcounters != NULL) {
+        Packetchain *chain = this;
+
+        perfcounters->RegisterCounter("kismet.packetchain.queue_depth",
+                "packets waiting for dissection or logging",
+                PerfCounterRegistry::PERF_GAUGE,
+                [chain]() -> uint64_t {
+                    return chain->FetchPendingPackets();
+                });
+
+        perfcounters->RegisterCounter("kismet.packetchain.dropped_packets",
+                "packets dropped due to chain backlog",
+                PerfCounterRegistry::PERF_COUNTER,
+                [chain]() -> uint64_t {
+                    return chain->dropped_packets;
+                });
+
+        perfcounters->RegisterCounter("kismet.memory.packet_pool",
+                "stripped packets cached for recycling",
+                PerfCounterRegistry::PERF_GAUGE,
+                [chain]() -> uint64_t {
+                    return chain->FetchPacketPoolSize();
+                });
+    }
 }
 
 Packetchain::~Packetchain() {
     {
-        // Tell the packet thread we're dying and unlock it
-        local_locker qlock(&packetqueue_mutex);
+        std::shared_ptr<PerfCounterRegistry> perfcounters =
+            Globalreg::FetchGlobalAs<PerfCounterRegistry>(globalreg, "PERFCOUNTERS");
+
+        if (perfcounters != NULL) {
+            perfcounters->RemoveCounter("kismet.packetchain.queue_depth");
+            perfcounters->RemoveCounter("kismet.packetchain.dropped_packets");
+            perfcounters->RemoveCounter("kismet.memory.packet_pool");
+        }
+
+        // Tell the packet threads we're dying and unlock them
         packetchain_shutdown = true;
-        packet_condition.unlock();
 
-        pthread_join(packet_thread, NULL);
+        for (auto u : work_units) {
+            u->packet_condition.unlock();
+
+            pthread_join(u->packet_thread, NULL);
+
+            delete u;
+        }
+
+        work_units.clear();
+
+        // The logging thread dies after the dissection workers so anything
+        // they queued gets seen before the flag check stops it
+        logging_unit->packet_condition.unlock();
+        pthread_join(logging_unit->packet_thread, NULL);
+        delete logging_unit;
+        logging_unit = NULL;
     }
 
     {
@@ -133,6 +275,15 @@ Packetchain::~Packetchain() {
         }
     }
 
+    {
+        local_locker poollock(&packet_pool_mutex);
+
+        for (auto p : packet_pool)
+            delete p;
+
+        packet_pool.clear();
+    }
+
 }
 
 int Packetchain::RegisterPacketComponent(std::string in_component) {
@@ -185,8 +336,26 @@ std::string Packetchain::FetchPacketComponentName(int in_id) {
 }
 
 kis_packet *Packetchain::GeneratePacket() {
+    kis_packet *newpack = NULL;
+
+    // Draw from the recycling pool before we go to the allocator
+    {
+        local_locker poollock(&packet_pool_mutex);
+
+        if (packet_pool.size() > 0) {
+            newpack = packet_pool.back();
+            packet_pool.pop_back();
+        }
+    }
+
+    if (newpack == NULL)
+        newpack = new kis_packet(globalreg);
+
+    // Stamp the genesis time; a monotonic read is a vdso call and cheap
+    // enough to take on every packet
+    clock_gettime(CLOCK_MONOTONIC, &newpack->gen_monotime);
+
     local_locker lock(&packetchain_mutex);
-    kis_packet *newpack = new kis_packet(globalreg);
     pc_link *pcl;
 
     // Run the frame through the genesis chain incase anything
@@ -214,140 +383,418 @@ kis_packet *Packetchain::GeneratePacket() {
     return newpack;
 }
 
-void *Packetchain::packet_queue_processor(void *in_packetchain) {
-    Packetchain *packetchain = (Packetchain *) in_packetchain;
+void Packetchain::CompileChain() {
+    // Concatenate the staged chains, in stage order, into one contiguous
+    // call list and swap it in for the consumption threads; anyone mid-walk
+    // keeps their reference to the old list
+    std::shared_ptr<std::vector<pc_link *> > compiled(new std::vector<pc_link *>());
+
+    compiled->reserve(postcap_chain.size() + llcdissect_chain.size() +
+            decrypt_chain.size() + datadissect_chain.size() +
+            classifier_chain.size() + tracker_chain.size());
+
+    for (auto pcl : postcap_chain)
+        compiled->push_back(pcl);
+    for (auto pcl : llcdissect_chain)
+        compiled->push_back(pcl);
+    for (auto pcl : decrypt_chain)
+        compiled->push_back(pcl);
+    for (auto pcl : datadissect_chain)
+        compiled->push_back(pcl);
+    for (auto pcl : classifier_chain)
+        compiled->push_back(pcl);
+    for (auto pcl : tracker_chain)
+        compiled->push_back(pcl);
+
+    std::atomic_store(&flat_chain,
+            std::shared_ptr<const std::vector<pc_link *> >(compiled));
+
+    // The logging stage is compiled apart since it runs on its own thread
+    std::shared_ptr<std::vector<pc_link *> > logging(new std::vector<pc_link *>());
+
+    for (auto pcl : logging_chain)
+        logging->push_back(pcl);
+
+    std::atomic_store(&flat_logging_chain,
+            std::shared_ptr<const std::vector<pc_link *> >(logging));
+}
+
+void Packetchain::RunTimedHandler(pc_link *pcl, kis_packet *in_pack) {
+    struct timespec t0, t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    if (pcl->callback != NULL)
+        pcl->callback(globalreg, pcl->auxdata, in_pack);
+    else if (pcl->l_callback != NULL)
+        pcl->l_callback(in_pack);
+    else
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    uint64_t us = (t1.tv_sec - t0.tv_sec) * 1000000LL +
+        (t1.tv_nsec - t0.tv_nsec) / 1000LL;
+
+    pcl->num_packets++;
+    pcl->total_time_us += us;
+
+    uint64_t prev_max = pcl->max_time_us;
+    while (us > prev_max &&
+            !pcl->max_time_us.compare_exchange_weak(prev_max, us))
+        ;
+}
+
+void Packetchain::RunChainHandlers(const std::vector<pc_link *>& in_chain,
+        kis_packet *in_pack) {
+    if (!profile_handlers) {
+        for (auto pcl : in_chain) {
+            // Handlers flagged for the timing guard (plugins) are timed
+            // even with global profiling off; for everything else this is
+            // a predictable not-taken branch
+            if (pcl->profile_always) {
+                RunTimedHandler(pcl, in_pack);
+                continue;
+            }
+
+            if (pcl->callback != NULL)
+                pcl->callback(globalreg, pcl->auxdata, in_pack);
+            else if (pcl->l_callback != NULL)
+                pcl->l_callback(in_pack);
+        }
+
+        return;
+    }
+
+    for (auto pcl : in_chain) {
+        RunTimedHandler(pcl, in_pack);
+    }
+}
+
+void Packetchain::RunPacketChains(kis_packet *in_pack) {
+    // Retire this packet from its source's backlog accounting
+    unsigned int slot = FetchSourceSlot(in_pack);
+    if (source_backlog[slot].fetch_sub(1) == 1)
+        active_sources--;
+
+    std::shared_ptr<const std::vector<pc_link *> > chain =
+        std::atomic_load(&flat_chain);
+
+    if (chain != NULL)
+        RunChainHandlers(*chain, in_pack);
+
+    // Hand the finished packet to the logging thread; if the logging queue
+    // is saturated, apply backpressure by logging inline rather than
+    // silently losing log records
+    if (logging_unit != NULL && logging_unit->packet_queue.enqueue(in_pack)) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (logging_unit->consumer_sleeping.load())
+            logging_unit->packet_condition.unlock();
+
+        return;
+    }
+
+    RunLoggingChain(in_pack);
+}
+
+void Packetchain::RunLoggingChain(kis_packet *in_pack) {
+    std::shared_ptr<const std::vector<pc_link *> > chain =
+        std::atomic_load(&flat_logging_chain);
+
+    if (chain != NULL)
+        RunChainHandlers(*chain, in_pack);
+
+    // The packet has now cleared the whole capture-to-log pipeline;
+    // measure it against its genesis stamp.  Recording here rather than
+    // in DestroyPacket keeps dropped packets out of the histograms
+    RecordPacketLatency(in_pack);
+
+    DestroyPacket(in_pack);
+}
+
+void Packetchain::RecordPacketLatency(kis_packet *in_pack) {
+    // Packets built outside GeneratePacket carry no stamp; skip them
+    if (in_pack->gen_monotime.tv_sec == 0 && in_pack->gen_monotime.tv_nsec == 0)
+        return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    int64_t usec =
+        (int64_t) (now.tv_sec - in_pack->gen_monotime.tv_sec) * 1000000LL +
+        (now.tv_nsec - in_pack->gen_monotime.tv_nsec) / 1000LL;
+
+    if (usec < 0)
+        usec = 0;
+
+    // Attribute to the capture source of the link frame; stampless
+    // injectors without one share record 0, like the backlog accounting
+    unsigned int sid = 0;
+
+    kis_datachunk *linkchunk =
+        (kis_datachunk *) in_pack->fetch(pack_comp_linkframe);
+
+    if (linkchunk != NULL)
+        sid = linkchunk->source_id;
+
+    local_locker lock(&latency_mutex);
+
+    packet_latency_rec& rec = latency_records[sid];
+
+    rec.num_packets++;
+    rec.total_usec += usec;
+
+    if ((uint64_t) usec > rec.max_usec)
+        rec.max_usec = usec;
+
+    rec.buckets[LatencyBucket(usec)]++;
+}
+
+unsigned int Packetchain::LatencyBucket(uint64_t usec) {
+    // The first power-of-two group is exact
+    if (usec < PACKETCHAIN_LAT_SUBBUCKETS)
+        return (unsigned int) usec;
+
+    unsigned int msb = 63 - __builtin_clzll(usec);
+    unsigned int bucket =
+        (msb - PACKETCHAIN_LAT_SUBBITS + 1) * PACKETCHAIN_LAT_SUBBUCKETS +
+        ((usec >> (msb - PACKETCHAIN_LAT_SUBBITS)) & (PACKETCHAIN_LAT_SUBBUCKETS - 1));
+
+    if (bucket >= PACKETCHAIN_LAT_BUCKETS)
+        bucket = PACKETCHAIN_LAT_BUCKETS - 1;
+
+    return bucket;
+}
+
+uint64_t Packetchain::LatencyBucketFloor(unsigned int bucket) {
+    if (bucket < PACKETCHAIN_LAT_SUBBUCKETS)
+        return bucket;
+
+    unsigned int group = bucket / PACKETCHAIN_LAT_SUBBUCKETS;
+    unsigned int sub = bucket % PACKETCHAIN_LAT_SUBBUCKETS;
+
+    return (uint64_t) (PACKETCHAIN_LAT_SUBBUCKETS + sub) << (group - 1);
+}
+
+void *Packetchain::logging_queue_processor(void *in_workunit) {
+    packet_work_unit *unit = (packet_work_unit *) in_workunit;
+    Packetchain *packetchain = unit->packetchain;
     kis_packet *packet = NULL;
-    local_demand_locker queue_lock(&(packetchain->packetqueue_mutex));
-    local_demand_locker chain_lock(&(packetchain->packetchain_mutex));
+
+    Kis_Thread_Setup(packetchain->globalreg, "chainlog", "logging");
 
     while (1) {
-        queue_lock.lock();
+        // Drain everything queued before honoring a shutdown so nothing the
+        // dissection workers handed us goes unlogged
+        if (unit->packet_queue.dequeue(packet)) {
+            packetchain->RunLoggingChain(packet);
+            continue;
+        }
 
-        // Are we shutting down?
         if (packetchain->packetchain_shutdown)
             return NULL;
-      
-        if (packetchain->packet_queue.size() != 0) {
-            // Get the next packet
-            packet = packetchain->packet_queue.front();
-            packetchain->packet_queue.pop();
 
-            // Unlock the queue while we process that packet
-            queue_lock.unlock();
+        unit->packet_condition.lock();
+        unit->consumer_sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
 
-            // Lock the  packet chain itself because we need to have consistent
-            // packet chain vectors
-            
-            for (auto pcl : packetchain->postcap_chain) {
-                if (pcl->callback != NULL)
-                    pcl->callback(packetchain->globalreg, pcl->auxdata, packet);
-                else if (pcl->l_callback != NULL)
-                    pcl->l_callback(packet);
-            }
+        if (unit->packet_queue.approx_size() != 0 ||
+                packetchain->packetchain_shutdown) {
+            unit->consumer_sleeping.store(false);
+            unit->packet_condition.unlock();
+            continue;
+        }
 
-            for (auto pcl : packetchain->llcdissect_chain) {
-                if (pcl->callback != NULL)
-                    pcl->callback(packetchain->globalreg, pcl->auxdata, packet);
-                else if (pcl->l_callback != NULL)
-                    pcl->l_callback(packet);
-            }
+        unit->packet_condition.block_until();
+        unit->consumer_sleeping.store(false);
+    }
+}
 
-            for (auto pcl : packetchain->decrypt_chain) {
-                if (pcl->callback != NULL)
-                    pcl->callback(packetchain->globalreg, pcl->auxdata, packet);
-                else if (pcl->l_callback != NULL)
-                    pcl->l_callback(packet);
-            }
+void *Packetchain::packet_queue_processor(void *in_workunit) {
+    packet_work_unit *unit = (packet_work_unit *) in_workunit;
+    Packetchain *packetchain = unit->packetchain;
+    kis_packet *batch[PACKET_DEQUEUE_BATCH];
+    size_t batch_sz;
 
-            for (auto pcl : packetchain->datadissect_chain) {
-                if (pcl->callback != NULL)
-                    pcl->callback(packetchain->globalreg, pcl->auxdata, packet);
-                else if (pcl->l_callback != NULL)
-                    pcl->l_callback(packet);
-            }
+    Kis_Thread_Setup(packetchain->globalreg,
+            "chainwork/" + UIntToString(unit->unit_number), "packetchain");
 
-            for (auto pcl : packetchain->classifier_chain) {
-                if (pcl->callback != NULL)
-                    pcl->callback(packetchain->globalreg, pcl->auxdata, packet);
-                else if (pcl->l_callback != NULL)
-                    pcl->l_callback(packet);
-            }
+    while (1) {
+        // Are we shutting down?
+        if (packetchain->packetchain_shutdown)
+            return NULL;
 
-            for (auto pcl : packetchain->tracker_chain) {
-                if (pcl->callback != NULL)
-                    pcl->callback(packetchain->globalreg, pcl->auxdata, packet);
-                else if (pcl->l_callback != NULL)
-                    pcl->l_callback(packet);
-            }
+        // Drain up to a batch from the ring in one pass so the shared
+        // accounting and the wakeup checks are amortized over the whole
+        // batch when we're running a backlog
+        batch_sz = 0;
+        while (batch_sz < PACKET_DEQUEUE_BATCH &&
+                unit->packet_queue.dequeue(batch[batch_sz]))
+            batch_sz++;
 
-            for (auto pcl : packetchain->logging_chain) {
-                if (pcl->callback != NULL)
-                    pcl->callback(packetchain->globalreg, pcl->auxdata, packet);
-                else if (pcl->l_callback != NULL)
-                    pcl->l_callback(packet);
-            }
+        if (batch_sz > 0) {
+            packetchain->packet_queue_count -= batch_sz;
 
-            packetchain->DestroyPacket(packet);
+            for (size_t b = 0; b < batch_sz; b++)
+                packetchain->RunPacketChains(batch[b]);
 
             // re-loop in case we have more packets
             continue;
-        } else {
-            // We have no packets, lock our conditional until something queues 
-            // a new packet and fall out of the selector
-            packetchain->packet_condition.lock();
         }
 
-        // No packets; fall through to blocking until we have them
-        queue_lock.unlock();
-
+        // We have no packets; advertise that we're going to sleep, then
+        // recheck the ring.  A producer which enqueued before seeing the
+        // flag is caught by the recheck; one which saw the flag will poke
+        // the conditional.
+        unit->packet_condition.lock();
+        unit->consumer_sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (unit->packet_queue.approx_size() != 0 ||
+                packetchain->packetchain_shutdown) {
+            unit->consumer_sleeping.store(false);
+            unit->packet_condition.unlock();
+            continue;
+        }
 
         // Block until something pokes the conditional locker
-        packetchain->packet_condition.block_until();
+        unit->packet_condition.block_until();
+        unit->consumer_sleeping.store(false);
     }
 }
 
+unsigned int Packetchain::FetchPacketWorker(kis_packet *in_pack) {
+    if (packet_chain_threads <= 1)
+        return 0;
+
+    // Prefer the source MAC as the ordering domain when whoever built the
+    // packet filled in common info before injecting it; packets for one
+    // device then always land on the same worker.  The phy is folded into
+    // the key so disjoint phys diverge onto separate lanes even when their
+    // addresses collide.
+    kis_common_info *common =
+        (kis_common_info *) in_pack->fetch(pack_comp_common);
+
+    if (common != NULL && common->source != mac_addr(0))
+        return (common->source.longmac + (uint64_t) common->phyid * 31) %
+            packet_chain_threads;
+
+    // Otherwise fall back to the capture source as the domain; a device
+    // heard on a single radio still stays in order.  The link type is
+    // folded in so that dissection of disjoint link types - 802.11 frames
+    // vs SDR JSON reports - lands on separate lanes instead of serializing
+    // behind each other when the source ids happen to collide.
+    kis_datachunk *linkchunk =
+        (kis_datachunk *) in_pack->fetch(pack_comp_linkframe);
+
+    if (linkchunk != NULL)
+        return ((unsigned int) linkchunk->dlt * 31 + linkchunk->source_id) %
+            packet_chain_threads;
+
+    return 0;
+}
+
+unsigned int Packetchain::FetchSourceSlot(kis_packet *in_pack) {
+    kis_datachunk *linkchunk =
+        (kis_datachunk *) in_pack->fetch(pack_comp_linkframe);
+
+    if (linkchunk == NULL)
+        return 0;
+
+    return linkchunk->source_id % PACKETCHAIN_SOURCE_SLOTS;
+}
+
 int Packetchain::ProcessPacket(kis_packet *in_pack) {
-    local_locker qlock(&packetqueue_mutex);
+    packet_work_unit *unit = work_units[FetchPacketWorker(in_pack)];
+    unsigned int slot = FetchSourceSlot(in_pack);
+
+    // Once the backlog passes half the hard limit, start dropping
+    // proportionally: any source holding more than an even share of the
+    // congested backlog loses its packet, so a flooding source sheds load
+    // before the quiet ones lose anything
+    if (packet_queue_drop != 0 && packet_queue_count > packet_queue_drop / 2) {
+        unsigned int act = active_sources;
+        if (act == 0)
+            act = 1;
+
+        unsigned int fair_share = (packet_queue_drop / 2) / act;
+        if (fair_share == 0)
+            fair_share = 1;
+
+        if (source_backlog[slot] > fair_share) {
+            time_t offt = Timetracker::GetCachedTime() - last_packet_drop_user_warning;
+
+            if (offt > 30) {
+                last_packet_drop_user_warning = Timetracker::GetCachedTime();
+
+                std::shared_ptr<Alertracker> alertracker =
+                    Globalreg::FetchMandatoryGlobalAs<Alertracker>(globalreg, alertracker_ref);
+                alertracker->RaiseOneShot("PACKETLOST",
+                        "Kismet is dropping packets from the busiest sources; the "
+                        "packet queue has a backlog of " + IntToString(packet_queue_count) +
+                        " packets and sources over their fair share are being "
+                        "thinned first.  Your system may not be fast enough to "
+                        "process the number of packets being seen.  You can change "
+                        "this behavior in 'kismet_memory.conf'.", -1);
+            }
+
+            dropped_packets++;
+            DestroyPacket(in_pack);
+
+            return 1;
+        }
+    }
 
-    if (packet_queue.size() > packet_queue_warning &&
+    if (packet_queue_count > packet_queue_warning &&
             packet_queue_warning != 0) {
-        time_t offt = time(0) - last_packet_queue_user_warning;
+        time_t offt = Timetracker::GetCachedTime() - last_packet_queue_user_warning;
 
         if (offt > 30) {
-            last_packet_queue_user_warning = time(0);
+            last_packet_queue_user_warning = Timetracker::GetCachedTime();
 
             std::shared_ptr<Alertracker> alertracker =
-                Globalreg::FetchMandatoryGlobalAs<Alertracker>(globalreg, "ALERTTRACKER");
-            alertracker->RaiseOneShot("PACKETQUEUE", 
-                    "The packet queue has a backlog of " + IntToString(packet_queue.size()) + 
+                Globalreg::FetchMandatoryGlobalAs<Alertracker>(globalreg, alertracker_ref);
+            alertracker->RaiseOneShot("PACKETQUEUE",
+                    "The packet queue has a backlog of " + IntToString(packet_queue_count) +
                     " packets; if you have multiple data sources it's possible that your "
                     "system is not fast enough.  Kismet will continue to process "
                     "packets, this may be a momentary spike in packet load.", -1);
         }
     }
 
-    if (packet_queue_drop != 0 && packet_queue.size() > packet_queue_drop) {
-        time_t offt = time(0) - last_packet_drop_user_warning;
+    // A full ring is the drop condition; capture threads never wait on it
+    if (!unit->packet_queue.enqueue(in_pack)) {
+        time_t offt = Timetracker::GetCachedTime() - last_packet_drop_user_warning;
 
         if (offt > 30) {
-            last_packet_drop_user_warning = time(0);
+            last_packet_drop_user_warning = Timetracker::GetCachedTime();
 
             std::shared_ptr<Alertracker> alertracker =
-                Globalreg::FetchMandatoryGlobalAs<Alertracker>(globalreg, "ALERTTRACKER");
-            alertracker->RaiseOneShot("PACKETLOST", 
+                Globalreg::FetchMandatoryGlobalAs<Alertracker>(globalreg, alertracker_ref);
+            alertracker->RaiseOneShot("PACKETLOST",
                     "Kismet has started to drop packets; the packet queue has a backlog "
-                    "of " + IntToString(packet_queue.size()) + " packets.  Your system "
+                    "of " + IntToString(packet_queue_count) + " packets.  Your system "
                     "may not be fast enough to process the number of packets being seen. "
                     "You change this behavior in 'kismet_memory.conf'.", -1);
         }
 
-        // Don't queue packets
+        // Don't queue the packet; reap it now so it isn't leaked
+        dropped_packets++;
+        DestroyPacket(in_pack);
+
         return 1;
     }
 
-    packet_queue.push(in_pack);
+    packet_queue_count++;
+
+    if (source_backlog[slot]++ == 0)
+        active_sources++;
 
-    packet_condition.unlock();
+    // Wake the consumer only if it's advertised that it's asleep; otherwise
+    // producers never touch the conditional
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (unit->consumer_sleeping.load())
+        unit->packet_condition.unlock();
 
     return 1;
 }
@@ -361,19 +808,34 @@ void Packetchain::DestroyPacket(kis_packet *in_pack) {
     // about error conditions
     for (unsigned int x = 0; x < destruction_chain.size(); x++) {
         pcl = destruction_chain[x];
-   
+
         (*(pcl->callback))(globalreg, pcl->auxdata, in_pack);
     }
 
+    // Strip the packet and recycle it through the pool instead of freeing
+    // it, unless the pool is already holding a full backlog's worth
+    {
+        local_locker poollock(&packet_pool_mutex);
+
+        if (packet_pool.size() < packet_pool_max) {
+            in_pack->reset();
+            packet_pool.push_back(in_pack);
+            return;
+        }
+    }
+
 	delete in_pack;
 }
 
 int Packetchain::RegisterIntHandler(pc_callback in_cb, void *in_aux,
-        std::function<int (kis_packet *)> in_l_cb, 
-        int in_chain, int in_prio) {
+        std::function<int (kis_packet *)> in_l_cb,
+        int in_chain, int in_prio,
+        std::string in_plugin, bool in_profile_always) {
+
+    local_locker lock(&packetchain_mutex);
 
     pc_link *link = NULL;
-    
+
     // Generate packet, we'll nuke it if it's invalid later
     link = new pc_link;
     link->priority = in_prio;
@@ -381,6 +843,8 @@ int Packetchain::RegisterIntHandler(pc_callback in_cb, void *in_aux,
     link->l_callback = in_l_cb;
     link->auxdata = in_aux;
 	link->id = next_handlerid++;
+    link->plugin = in_plugin;
+    link->profile_always = in_profile_always;
             
     switch (in_chain) {
         case CHAINPOS_GENESIS:
@@ -439,22 +903,49 @@ int Packetchain::RegisterIntHandler(pc_callback in_cb, void *in_aux,
 
         default:
             delete link;
-            _MSG("Packetchain::RegisterHandler requested unknown chain", 
+            _MSG("Packetchain::RegisterHandler requested unknown chain",
 				 MSGFLAG_ERROR);
             return -1;
     }
 
+    CompileChain();
+
     return link->id;
 }
 
-int Packetchain::RegisterHandler(pc_callback in_cb, void *in_aux, 
+int Packetchain::RegisterHandler(pc_callback in_cb, void *in_aux,
         int in_chain, int in_prio) {
-    return RegisterIntHandler(in_cb, in_aux, NULL, in_chain, in_prio);
+    return RegisterIntHandler(in_cb, in_aux, NULL, in_chain, in_prio, "", false);
 }
 
 int Packetchain::RegisterHandler(std::function<int (kis_packet *)> in_cb, int in_chain,
         int in_prio) {
-    return RegisterIntHandler(NULL, NULL, in_cb, in_chain, in_prio);
+    return RegisterIntHandler(NULL, NULL, in_cb, in_chain, in_prio, "", false);
+}
+
+int Packetchain::RegisterPluginHandler(std::string in_plugin, unsigned int in_api_version,
+        pc_callback in_cb, void *in_aux, int in_chain, int in_prio) {
+
+    // The entire capability handshake happens here, once; after this the
+    // handler lives in the flattened chain as a raw function pointer with
+    // the same dispatch cost as any built-in
+    if (in_api_version != KIS_PACKETCHAIN_PLUGIN_API_VERSION) {
+        _MSG("Plugin '" + in_plugin + "' was built against packet chain API "
+                "version " + UIntToString(in_api_version) + " but this Kismet "
+                "provides version " +
+                UIntToString(KIS_PACKETCHAIN_PLUGIN_API_VERSION) + "; refusing "
+                "to install its chain handler", MSGFLAG_ERROR);
+        return -1;
+    }
+
+    if (in_cb == NULL) {
+        _MSG("Plugin '" + in_plugin + "' tried to register a NULL chain "
+                "handler", MSGFLAG_ERROR);
+        return -1;
+    }
+
+    return RegisterIntHandler(in_cb, in_aux, NULL, in_chain, in_prio,
+            in_plugin, true);
 }
 
 int Packetchain::RemoveHandler(int in_id, int in_chain) {
@@ -541,6 +1032,8 @@ int Packetchain::RemoveHandler(int in_id, int in_chain) {
             return -1;
     }
 
+    CompileChain();
+
     return 1;
 }
 
@@ -628,6 +1121,178 @@ int Packetchain::RemoveHandler(pc_callback in_cb, int in_chain) {
             return -1;
     }
 
+    CompileChain();
+
     return 1;
 }
 
+
+bool Packetchain::Httpd_VerifyPath(const char *path, const char *method) {
+    if (strcmp(method, "GET") != 0)
+        return false;
+
+    if (!Httpd_CanSerialize(path))
+        return false;
+
+    if (Httpd_StripSuffix(path) == "/packetchain/handler_timing")
+        return true;
+
+    if (Httpd_StripSuffix(path) == "/packetchain/packet_latency")
+        return true;
+
+    return false;
+}
+
+void Packetchain::Httpd_CreateStreamResponse(
+        Kis_Net_Httpd *httpd __attribute__((unused)),
+        Kis_Net_Httpd_Connection *connection __attribute__((unused)),
+        const char *path, const char *method,
+        const char *upload_data __attribute__((unused)),
+        size_t *upload_data_size __attribute__((unused)),
+        std::stringstream &stream) {
+
+    if (strcmp(method, "GET") != 0)
+        return;
+
+    if (!Httpd_CanSerialize(path))
+        return;
+
+    std::string stripped = Httpd_StripSuffix(path);
+
+    if (stripped == "/packetchain/packet_latency") {
+        SharedTrackerElement latency_vec(new TrackerElement(TrackerVector, latency_vec_id));
+        TrackerElementVector lvec(latency_vec);
+
+        local_locker lock(&latency_mutex);
+
+        for (auto r : latency_records) {
+            std::shared_ptr<tracked_packet_latency> t =
+                std::static_pointer_cast<tracked_packet_latency>(globalreg->entrytracker->GetTrackedInstance(latency_entry_id));
+
+            t->set_source_id(r.first);
+            t->set_num_packets(r.second.num_packets);
+            t->set_total_usec(r.second.total_usec);
+            t->set_max_usec(r.second.max_usec);
+
+            // Only occupied buckets are emitted, keyed by their floor, so
+            // the record stays small no matter the histogram geometry
+            for (unsigned int b = 0; b < PACKETCHAIN_LAT_BUCKETS; b++) {
+                if (r.second.buckets[b] != 0)
+                    t->add_bucket(LatencyBucketFloor(b), r.second.buckets[b]);
+            }
+
+            lvec.push_back(t);
+        }
+
+        Httpd_Serialize(path, stream, latency_vec);
+
+        return;
+    }
+
+    if (stripped != "/packetchain/handler_timing")
+        return;
+
+    SharedTrackerElement timing_vec(new TrackerElement(TrackerVector, timing_vec_id));
+    TrackerElementVector tvec(timing_vec);
+
+    // Snapshot the handler lists so nothing shifts under us; the counters
+    // themselves are atomics and safe to read while the chain runs
+    local_locker lock(&packetchain_mutex);
+
+    std::vector<std::pair<int, std::vector<pc_link *> *> > all_chains = {
+        { CHAINPOS_GENESIS, &genesis_chain },
+        { CHAINPOS_POSTCAP, &postcap_chain },
+        { CHAINPOS_LLCDISSECT, &llcdissect_chain },
+        { CHAINPOS_DECRYPT, &decrypt_chain },
+        { CHAINPOS_DATADISSECT, &datadissect_chain },
+        { CHAINPOS_CLASSIFIER, &classifier_chain },
+        { CHAINPOS_TRACKER, &tracker_chain },
+        { CHAINPOS_LOGGING, &logging_chain },
+        { CHAINPOS_DESTROY, &destruction_chain }
+    };
+
+    for (auto c : all_chains) {
+        for (auto pcl : *(c.second)) {
+            std::shared_ptr<tracked_handler_timing> t =
+                std::static_pointer_cast<tracked_handler_timing>(globalreg->entrytracker->GetTrackedInstance(timing_entry_id));
+
+            uint64_t packets = pcl->num_packets;
+            uint64_t total = pcl->total_time_us;
+
+            t->set_chain(c.first);
+            t->set_handler_id(pcl->id);
+            t->set_plugin(pcl->plugin);
+            t->set_priority(pcl->priority);
+            t->set_num_packets(packets);
+            t->set_total_usec(total);
+            t->set_max_usec(pcl->max_time_us);
+
+            if (packets != 0)
+                t->set_avg_usec(total / packets);
+
+            tvec.push_back(t);
+        }
+    }
+
+    Httpd_Serialize(path, stream, timing_vec);
+}
+
+size_t Packetchain::FetchPacketPoolSize() {
+    local_locker lock(&packet_pool_mutex);
+
+    return packet_pool.size();
+}
+
+size_t Packetchain::FetchPendingPackets() {
+    size_t pending = packet_queue_count;
+
+    if (logging_unit != NULL)
+        pending += logging_unit->packet_queue.approx_size();
+
+    return pending;
+}
+
+void Packetchain::ReportHandlerTimings(FILE *in_out) {
+    local_locker lock(&packetchain_mutex);
+
+    if (!profile_handlers) {
+        fprintf(in_out, "Packet chain profiling disabled; set "
+                "packet_chain_profiling=true to collect per-handler timing.\n"
+                "Plugin handlers are always timed and reported below.\n");
+    }
+
+    std::vector<std::pair<const char *, std::vector<pc_link *> *> > all_chains = {
+        { "GENESIS", &genesis_chain },
+        { "POSTCAP", &postcap_chain },
+        { "LLCDISSECT", &llcdissect_chain },
+        { "DECRYPT", &decrypt_chain },
+        { "DATADISSECT", &datadissect_chain },
+        { "CLASSIFIER", &classifier_chain },
+        { "TRACKER", &tracker_chain },
+        { "LOGGING", &logging_chain },
+        { "DESTROY", &destruction_chain }
+    };
+
+    for (auto c : all_chains) {
+        for (auto pcl : *(c.second)) {
+            // With global profiling off only plugin handlers accumulate
+            // timing, skip the all-zero built-in rows
+            if (!profile_handlers && !pcl->profile_always)
+                continue;
+
+            uint64_t packets = pcl->num_packets;
+            uint64_t total = pcl->total_time_us;
+            uint64_t max = pcl->max_time_us;
+
+            fprintf(in_out, "%-12s handler %3d priority %6d %-16s "
+                    "%12llu packets  %12llu usec total  "
+                    "avg %8.2f usec  max %8llu usec\n",
+                    c.first, pcl->id, pcl->priority,
+                    pcl->plugin.length() == 0 ? "builtin" : pcl->plugin.c_str(),
+                    (unsigned long long) packets,
+                    (unsigned long long) total,
+                    packets == 0 ? 0.0 : (double) total / (double) packets,
+                    (unsigned long long) max);
+        }
+    }
+}
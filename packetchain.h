@@ -29,6 +29,7 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
@@ -38,10 +39,12 @@
 
 #include "globalregistry.h"
 #include "kis_mutex.h"
+#include "kis_net_microhttpd.h"
 #include "packet.h"
+#include "trackedelement.h"
 
 
-/* Packets are added to the packet queue from any thread (including the main 
+/* Packets are added to the packet queue from any thread (including the main
  * thread).
  *
  * They are then processed by the packet consumption thread(s) via the registered
@@ -50,6 +53,14 @@
  * Once being inserted into the packet chain, the packet pointer may no longer be
  * considered valid by the generating thread.
  *
+ * By default a single consumption thread processes all packets, which
+ * guarantees total ordering.  When 'packet_chain_threads' is set to more than
+ * one thread, packets are spread across a pool of consumption threads; each
+ * packet is assigned to an ordering domain (the source MAC when a common info
+ * record is present at injection time, otherwise the capture source) and all
+ * packets in one domain are always handled, in order, by the same thread, so
+ * per-device ordering holds through the classifier and tracker stages.
+ *
  * Packet chain progression
  * GENESIS
  *   --> genesis_chain
@@ -74,6 +85,11 @@
  *   --> destroy_chain
  */
 
+// Chain handler ABI version for plugins; checked once at registration by
+// RegisterPluginHandler so a plugin built against an incompatible chain
+// layout is rejected at load time instead of being revalidated per call
+#define KIS_PACKETCHAIN_PLUGIN_API_VERSION  1
+
 #define CHAINPOS_GENESIS        1
 #define CHAINPOS_POSTCAP        2
 #define CHAINPOS_LLCDISSECT     3
@@ -84,13 +100,288 @@
 #define CHAINPOS_LOGGING        8
 #define CHAINPOS_DESTROY        9
 
+// How many packets a consumption thread pulls from its ring per pass; a
+// batch amortizes the queue accounting and wakeup checks across multiple
+// packets when a backlog has formed
+#define PACKET_DEQUEUE_BATCH	32
+
+// Per-source backlog accounting slots used for fair dropping; sources are
+// hashed into these, so it only needs to be comfortably larger than any
+// sane number of simultaneous capture sources
+#define PACKETCHAIN_SOURCE_SLOTS	1024
+
+// Log-linear latency histogram geometry, in the usual HDR style:  each
+// power-of-two range of the microsecond domain is split into 8 linear
+// sub-buckets, so relative error is bounded at ~12% across the whole
+// range while the bucket index is computed with a clz and a shift.  176
+// buckets spans sub-usec through ~16 seconds; the last bucket absorbs
+// anything slower.
+#define PACKETCHAIN_LAT_SUBBITS		3
+#define PACKETCHAIN_LAT_SUBBUCKETS	(1 << PACKETCHAIN_LAT_SUBBITS)
+#define PACKETCHAIN_LAT_BUCKETS		176
+
 #define CHAINCALL_PARMS GlobalRegistry *globalreg __attribute__ ((unused)), \
     void *auxdata __attribute__ ((unused)), \
     kis_packet *in_pack
 
 class kis_packet;
 
-class Packetchain : public LifetimeGlobal {
+// Bounded lock-free multi-producer single-consumer ring (Vyukov-style
+// sequenced ring buffer) used to hand packets from the capture threads to a
+// chain worker; capture threads never block each other or on the consumer,
+// they only fail the enqueue when the ring is full, which maps onto the
+// existing backlog-drop semantics.
+template<class t>
+class mpsc_bounded_queue {
+public:
+    // Size is rounded up to the next power of two
+    mpsc_bounded_queue(size_t in_sz) {
+        size_t p2 = 2;
+        while (p2 < in_sz)
+            p2 <<= 1;
+
+        buffer_mask = p2 - 1;
+        buffer = new cell_t[p2];
+
+        for (size_t i = 0; i != p2; i++)
+            buffer[i].sequence.store(i, std::memory_order_relaxed);
+
+        enqueue_pos.store(0, std::memory_order_relaxed);
+        dequeue_pos.store(0, std::memory_order_relaxed);
+    }
+
+    ~mpsc_bounded_queue() {
+        delete[] buffer;
+    }
+
+    // Called from any producer thread; false if the ring is full
+    bool enqueue(const t& data) {
+        cell_t *cell;
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+
+        for (;;) {
+            cell = &buffer[pos & buffer_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t) seq - (intptr_t) pos;
+
+            if (dif == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                            std::memory_order_relaxed))
+                    break;
+            } else if (dif < 0) {
+                // Full
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = data;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Called only from the single consumer thread; false if empty
+    bool dequeue(t& data) {
+        cell_t *cell = &buffer[dequeue_pos.load(std::memory_order_relaxed) & buffer_mask];
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+
+        if ((intptr_t) seq - (intptr_t) (pos + 1) < 0)
+            return false;
+
+        dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+
+        data = cell->data;
+        cell->sequence.store(pos + buffer_mask + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    size_t approx_size() const {
+        return enqueue_pos.load(std::memory_order_relaxed) -
+            dequeue_pos.load(std::memory_order_relaxed);
+    }
+
+protected:
+    struct cell_t {
+        std::atomic<size_t> sequence;
+        t data;
+    };
+
+    cell_t *buffer;
+    size_t buffer_mask;
+
+    std::atomic<size_t> enqueue_pos;
+    std::atomic<size_t> dequeue_pos;
+};
+
+// Per-handler latency record exposed over the REST interface when chain
+// profiling is enabled
+class tracked_handler_timing : public tracker_component {
+public:
+    tracked_handler_timing(GlobalRegistry *in_globalreg, int in_id) :
+        tracker_component(in_globalreg, in_id) {
+        register_fields();
+        reserve_fields(NULL);
+    }
+
+    tracked_handler_timing(GlobalRegistry *in_globalreg, int in_id,
+            SharedTrackerElement e) :
+        tracker_component(in_globalreg, in_id) {
+        register_fields();
+        reserve_fields(e);
+    }
+
+    virtual SharedTrackerElement clone_type() {
+        return SharedTrackerElement(new tracked_handler_timing(globalreg, get_id()));
+    }
+
+    __Proxy(chain, int32_t, int32_t, int32_t, chain);
+    __Proxy(handler_id, int32_t, int32_t, int32_t, handler_id);
+    __Proxy(plugin, std::string, std::string, std::string, plugin);
+    __Proxy(priority, int32_t, int32_t, int32_t, priority);
+    __Proxy(num_packets, uint64_t, uint64_t, uint64_t, num_packets);
+    __Proxy(total_usec, uint64_t, uint64_t, uint64_t, total_usec);
+    __Proxy(max_usec, uint64_t, uint64_t, uint64_t, max_usec);
+    __Proxy(avg_usec, uint64_t, uint64_t, uint64_t, avg_usec);
+
+protected:
+    virtual void register_fields() {
+        tracker_component::register_fields();
+
+        chain_id =
+            RegisterField("kismet.packetchain.handler.chain", TrackerInt32,
+                    "chain position (per packetchain.h)", &chain);
+        handler_id_id =
+            RegisterField("kismet.packetchain.handler.id", TrackerInt32,
+                    "handler id", &handler_id);
+        plugin_id =
+            RegisterField("kismet.packetchain.handler.plugin", TrackerString,
+                    "owning plugin, empty for built-in handlers", &plugin);
+        priority_id =
+            RegisterField("kismet.packetchain.handler.priority", TrackerInt32,
+                    "handler priority", &priority);
+        num_packets_id =
+            RegisterField("kismet.packetchain.handler.num_packets", TrackerUInt64,
+                    "number of packets seen by handler", &num_packets);
+        total_usec_id =
+            RegisterField("kismet.packetchain.handler.total_usec", TrackerUInt64,
+                    "total time spent in handler (usec)", &total_usec);
+        max_usec_id =
+            RegisterField("kismet.packetchain.handler.max_usec", TrackerUInt64,
+                    "longest single packet in handler (usec)", &max_usec);
+        avg_usec_id =
+            RegisterField("kismet.packetchain.handler.avg_usec", TrackerUInt64,
+                    "average time per packet in handler (usec)", &avg_usec);
+    }
+
+    SharedTrackerElement chain;
+    int chain_id;
+
+    SharedTrackerElement handler_id;
+    int handler_id_id;
+
+    SharedTrackerElement plugin;
+    int plugin_id;
+
+    SharedTrackerElement priority;
+    int priority_id;
+
+    SharedTrackerElement num_packets;
+    int num_packets_id;
+
+    SharedTrackerElement total_usec;
+    int total_usec_id;
+
+    SharedTrackerElement max_usec;
+    int max_usec_id;
+
+    SharedTrackerElement avg_usec;
+    int avg_usec_id;
+};
+
+// Per-source end-to-end latency record exposed over the REST interface;
+// the histogram is keyed by the microsecond floor of each occupied
+// bucket so a consumer can derive percentiles without knowing the
+// bucket geometry
+class tracked_packet_latency : public tracker_component {
+public:
+    tracked_packet_latency(GlobalRegistry *in_globalreg, int in_id) :
+        tracker_component(in_globalreg, in_id) {
+        register_fields();
+        reserve_fields(NULL);
+    }
+
+    tracked_packet_latency(GlobalRegistry *in_globalreg, int in_id,
+            SharedTrackerElement e) :
+        tracker_component(in_globalreg, in_id) {
+        register_fields();
+        reserve_fields(e);
+    }
+
+    virtual SharedTrackerElement clone_type() {
+        return SharedTrackerElement(new tracked_packet_latency(globalreg, get_id()));
+    }
+
+    __Proxy(source_id, uint32_t, uint32_t, uint32_t, source_id);
+    __Proxy(num_packets, uint64_t, uint64_t, uint64_t, num_packets);
+    __Proxy(total_usec, uint64_t, uint64_t, uint64_t, total_usec);
+    __Proxy(max_usec, uint64_t, uint64_t, uint64_t, max_usec);
+
+    void add_bucket(uint64_t floor_usec, uint64_t count) {
+        TrackerElementIntMap hmap(histogram);
+
+        SharedTrackerElement c(new TrackerElement(TrackerUInt64, histogram_count_id));
+        c->set(count);
+
+        hmap.insert(TrackerElementIntMap::pair(floor_usec, c));
+    }
+
+protected:
+    virtual void register_fields() {
+        tracker_component::register_fields();
+
+        source_id_id =
+            RegisterField("kismet.packetchain.latency.source_id", TrackerUInt32,
+                    "capture source id of the link frame", &source_id);
+        num_packets_id =
+            RegisterField("kismet.packetchain.latency.num_packets", TrackerUInt64,
+                    "packets which completed the capture-to-log pipeline", &num_packets);
+        total_usec_id =
+            RegisterField("kismet.packetchain.latency.total_usec", TrackerUInt64,
+                    "total pipeline latency (usec)", &total_usec);
+        max_usec_id =
+            RegisterField("kismet.packetchain.latency.max_usec", TrackerUInt64,
+                    "slowest single packet (usec)", &max_usec);
+        histogram_id =
+            RegisterField("kismet.packetchain.latency.histogram", TrackerIntMap,
+                    "packet counts keyed by latency bucket floor (usec)", &histogram);
+        histogram_count_id =
+            RegisterField("kismet.packetchain.latency.histogram.count", TrackerUInt64,
+                    "packets in latency bucket");
+    }
+
+    SharedTrackerElement source_id;
+    int source_id_id;
+
+    SharedTrackerElement num_packets;
+    int num_packets_id;
+
+    SharedTrackerElement total_usec;
+    int total_usec_id;
+
+    SharedTrackerElement max_usec;
+    int max_usec_id;
+
+    SharedTrackerElement histogram;
+    int histogram_id;
+
+    int histogram_count_id;
+};
+
+class Packetchain : public LifetimeGlobal, public Kis_Net_Httpd_CPPStream_Handler {
 public:
     static std::shared_ptr<Packetchain> create_packetchain(GlobalRegistry *in_globalreg) {
         std::shared_ptr<Packetchain> mon(new Packetchain(in_globalreg));
@@ -119,31 +410,146 @@ public:
     // Destroy a packet at the end of its life
     void DestroyPacket(kis_packet *in_pack);
  
-    // Callback and information 
+    // Callback and information
     typedef int (*pc_callback)(CHAINCALL_PARMS);
-    typedef struct {
+    typedef struct _pc_link {
+        _pc_link() :
+            priority {0},
+            callback {NULL},
+            auxdata {NULL},
+            id {0},
+            profile_always {false},
+            num_packets {0},
+            total_time_us {0},
+            max_time_us {0} { }
+
         int priority;
 		Packetchain::pc_callback callback;
         std::function<int (kis_packet *)> l_callback;
         void *auxdata;
 		int id;
+
+        // Owning plugin, empty for built-in handlers
+        std::string plugin;
+
+        // Time this handler even when global chain profiling is off; set
+        // for plugin handlers so a misbehaving plugin is identifiable from
+        // the latency accounting
+        bool profile_always;
+
+        // Latency accounting, touched by any consumption thread when chain
+        // profiling is enabled
+        std::atomic<uint64_t> num_packets;
+        std::atomic<uint64_t> total_time_us;
+        std::atomic<uint64_t> max_time_us;
     } pc_link;
 
-    // Register a callback, aux data, a chain to put it in, and the priority 
+    // Total packets still queued for dissection or logging; lets an
+    // offline driver (the replay benchmark) detect when the chain has
+    // fully drained.  Approximate, like the counters it reads
+    size_t FetchPendingPackets();
+
+    // Dump the per-handler latency accounting as plain text; only
+    // meaningful when packet_chain_profiling is enabled
+    void ReportHandlerTimings(FILE *in_out);
+
+    // Stripped packets currently cached for recycling; published as a
+    // memory accounting gauge
+    size_t FetchPacketPoolSize();
+
+    // Log-linear bucket index for a latency in usec, and the inverse for
+    // reporting; generic over the PACKETCHAIN_LAT_* geometry, so other
+    // subsystems doing latency accounting share the same bucket floors
+    static unsigned int LatencyBucket(uint64_t usec);
+    static uint64_t LatencyBucketFloor(unsigned int bucket);
+
+    // Register a callback, aux data, a chain to put it in, and the priority
     int RegisterHandler(pc_callback in_cb, void *in_aux, int in_chain, int in_prio);
     int RegisterHandler(std::function<int (kis_packet *)> in_cb, int in_chain, int in_prio);
+
+    // Plugin chain registration.  The plugin passes the chain API version
+    // it was built against; a mismatch is rejected here, once, and a
+    // handler that passes the handshake is installed into the flattened
+    // chain as a raw function pointer with the same dispatch cost as a
+    // built-in dissector.  The handler is tagged with the plugin name and
+    // always timed, so /packetchain/handler_timing.json attributes its
+    // latency even when packet_chain_profiling is off.
+    // Returns the handler id, or negative on a failed handshake.
+    int RegisterPluginHandler(std::string in_plugin, unsigned int in_api_version,
+            pc_callback in_cb, void *in_aux, int in_chain, int in_prio);
     int RemoveHandler(pc_callback in_cb, int in_chain);
 	int RemoveHandler(int in_id, int in_chain);
 
+    // HTTP interface; per-handler timing records when profiling is on,
+    // and per-source end-to-end latency histograms
+    virtual bool Httpd_VerifyPath(const char *path, const char *method);
+
+    virtual void Httpd_CreateStreamResponse(Kis_Net_Httpd *httpd,
+            Kis_Net_Httpd_Connection *connection,
+            const char *url, const char *method, const char *upload_data,
+            size_t *upload_data_size, std::stringstream &stream);
+
 protected:
     GlobalRegistry *globalreg;
 
-    static void *packet_queue_processor(void *in_packetchain);
+    // Per-worker packet queue; in pooled mode each consumption thread owns
+    // one of these so workers never contend on each others' queues.  The
+    // ring itself is lock-free; the conditional is only touched by
+    // producers on the rare empty-to-nonempty transition when the consumer
+    // has advertised it is asleep.
+    struct packet_work_unit {
+        packet_work_unit(size_t in_ring_sz) :
+            packet_queue {in_ring_sz},
+            consumer_sleeping {false} { }
+
+        Packetchain *packetchain;
+
+        // Worker index, used for thread naming
+        unsigned int unit_number;
+
+        conditional_locker<int> packet_condition;
+        mpsc_bounded_queue<kis_packet *> packet_queue;
+        std::atomic<bool> consumer_sleeping;
+
+        pthread_t packet_thread;
+    };
+
+    static void *packet_queue_processor(void *in_workunit);
+
+    // Dedicated logging thread; drains packets which have finished
+    // dissection and tracking, runs the logging handlers, and destroys
+    // them, so slow log writes never stall the dissection workers
+    static void *logging_queue_processor(void *in_workunit);
 
-    // Common function for both insertion methods
-    int RegisterIntHandler(pc_callback in_cb, void *in_aux, 
-            std::function<int (kis_packet *)> in_l_cb, 
-            int in_chain, int in_prio);
+    // Run one packet through the postcap-through-tracker chains, then hand
+    // it to the logging thread (or log it inline if the logging queue is
+    // saturated)
+    void RunPacketChains(kis_packet *in_pack);
+
+    // Logging stage + destruction for one packet
+    void RunLoggingChain(kis_packet *in_pack);
+
+    // Run a packet through the handlers of one chain, with optional
+    // latency accounting
+    void RunChainHandlers(const std::vector<pc_link *>& in_chain, kis_packet *in_pack);
+
+    // Dispatch one handler under the monotonic clock and fold the result
+    // into its accounting
+    void RunTimedHandler(pc_link *pcl, kis_packet *in_pack);
+
+    // Are we timing every handler call?
+    bool profile_handlers;
+
+    int timing_vec_id, timing_entry_id;
+
+    // Map a packet to the worker which owns its ordering domain
+    unsigned int FetchPacketWorker(kis_packet *in_pack);
+
+    // Common function for all insertion methods
+    int RegisterIntHandler(pc_callback in_cb, void *in_aux,
+            std::function<int (kis_packet *)> in_l_cb,
+            int in_chain, int in_prio,
+            std::string in_plugin, bool in_profile_always);
 
     int next_componentid, next_handlerid;
 
@@ -164,21 +570,90 @@ protected:
 	std::vector<Packetchain::pc_link *> tracker_chain;
     std::vector<Packetchain::pc_link *> logging_chain;
 
+    // The core chains compiled into a single flat call array in stage
+    // order; rebuilt on every registration change and swapped atomically,
+    // so the consumption threads walk one contiguous list per packet and
+    // never see a half-edited chain.  The logging stage is compiled
+    // separately since it runs asynchronously on its own thread.
+    std::shared_ptr<const std::vector<Packetchain::pc_link *> > flat_chain;
+    std::shared_ptr<const std::vector<Packetchain::pc_link *> > flat_logging_chain;
+
+    // Rebuild the flat chain; caller must hold packetchain_mutex
+    void CompileChain();
+
     // Whole packet-chain mutex
     kis_recursive_timed_mutex packetchain_mutex;
 
     // Packet queue management; we have to use raw threads to be able to set
     // the stack size on them, which may be needed for MUSL Libc
-    pthread_t packet_thread;
+    unsigned int packet_chain_threads;
+    std::vector<packet_work_unit *> work_units;
+
+    // Queue and thread for the asynchronous logging stage
+    packet_work_unit *logging_unit;
+
+    // Total backlog across all worker queues
+    std::atomic<unsigned int> packet_queue_count;
+
+    // Total packets dropped to backlog since startup; published as a
+    // health counter
+    std::atomic<uint64_t> dropped_packets;
+
+    // In-flight packets per source slot, and how many slots are currently
+    // non-idle; drives proportional dropping once the chain is congested,
+    // so one flooding radio can't starve the quiet ones out of the backlog
+    std::atomic<unsigned int> source_backlog[PACKETCHAIN_SOURCE_SLOTS];
+    std::atomic<unsigned int> active_sources;
+
+    // Map a packet to its source accounting slot
+    unsigned int FetchSourceSlot(kis_packet *in_pack);
+
+    // End-to-end latency accounting; packets are stamped with a monotonic
+    // time at genesis and measured when the logging stage finishes with
+    // them, so the histograms cover the full capture-to-log pipeline.
+    // Plain counters under their own mutex - recording happens on the
+    // single logging thread so there is effectively no contention, and
+    // the REST reader takes the same lock
+    struct packet_latency_rec {
+        packet_latency_rec() :
+            num_packets {0},
+            total_usec {0},
+            max_usec {0} {
+            for (unsigned int b = 0; b < PACKETCHAIN_LAT_BUCKETS; b++)
+                buckets[b] = 0;
+        }
+
+        uint64_t num_packets;
+        uint64_t total_usec;
+        uint64_t max_usec;
+        uint64_t buckets[PACKETCHAIN_LAT_BUCKETS];
+    };
+
+    kis_recursive_timed_mutex latency_mutex;
+    std::map<unsigned int, packet_latency_rec> latency_records;
+
+    int latency_vec_id, latency_entry_id;
+
+    // Measure a packet leaving the logging stage against its genesis stamp
+    void RecordPacketLatency(kis_packet *in_pack);
 
-    kis_recursive_timed_mutex packetqueue_mutex;
-    conditional_locker<int> packet_condition;
-    std::queue<kis_packet *> packet_queue;
     bool packetchain_shutdown;
 
+    // Recycled packet objects; DestroyPacket strips and caches packets here
+    // instead of freeing them, and GeneratePacket draws from the cache
+    kis_recursive_timed_mutex packet_pool_mutex;
+    std::vector<kis_packet *> packet_pool;
+    size_t packet_pool_max;
+
+    int pack_comp_linkframe, pack_comp_common;
+
     // Warning and discard levels for packet queue being full
     unsigned int packet_queue_warning, packet_queue_drop;
     time_t last_packet_queue_user_warning, last_packet_drop_user_warning;
+
+    // Alertracker ref resolved once at construction so the congestion
+    // paths fetch it by index instead of a string lookup
+    int alertracker_ref;
 };
 
 #endif
@@ -42,6 +42,7 @@ Pcap_Stream_Ringbuf::Pcap_Stream_Ringbuf(GlobalRegistry *in_globalreg,
 
     pack_comp_linkframe = packetchain->RegisterPacketComponent("LINKFRAME");
     pack_comp_datasrc = packetchain->RegisterPacketComponent("KISDATASRC");
+    pack_comp_pcapng_frame = packetchain->RegisterPacketComponent("PCAPNGFRAME");
 
     // Write the initial headers
     if (pcapng_make_shb("", "", "Kismet") < 0)
@@ -67,9 +68,6 @@ int Pcap_Stream_Ringbuf::pcapng_make_shb(std::string in_hw, std::string in_os, s
     size_t opt_offt = 0;
 
     size_t buf_sz;
-    size_t write_sz;
-
-    uint32_t *end_sz = (uint32_t *) &buf_sz;
 
     buf_sz = sizeof(pcapng_shb);
     // Allocate an end-of-options entry
@@ -85,15 +83,17 @@ int Pcap_Stream_Ringbuf::pcapng_make_shb(std::string in_hw, std::string in_os, s
     if (in_app.length() > 0) 
         buf_sz += sizeof(pcapng_option) + PAD_TO_32BIT(in_app.length());
 
-    if (handler->GetWriteBufferAvailable() < (ssize_t) buf_sz + 4) {
+    if (!handler->EnsureWriteBufferSpace(buf_sz + 4)) {
         handler->ProtocolError();
         return -1;
     }
 
-    buf = new uint8_t[buf_sz];
+    // Reserve the entire block, including the trailing size, and assemble
+    // it in place
+    ssize_t r = handler->ReserveWriteBufferData((void **) &buf, buf_sz + 4);
 
-    if (buf == NULL) {
-        delete[] buf;
+    if (r != (ssize_t) buf_sz + 4) {
+        handler->CommitWriteBufferData(NULL, 0);
         handler->ProtocolError();
         return -1;
     }
@@ -145,30 +145,16 @@ int Pcap_Stream_Ringbuf::pcapng_make_shb(std::string in_hw, std::string in_os, s
     opt->option_code = PCAPNG_OPT_ENDOFOPT;
     opt->option_length = 0;
 
-    write_sz = handler->PutWriteBufferData(buf, buf_sz, true);
-
-    if (write_sz != buf_sz) {
-        handler->ProtocolError();
-        delete[] buf;
-        return -1;
-    }
-
-    log_size += write_sz;
-
     // Put the trailing size
-    *end_sz += 4;
-    
-    write_sz = handler->PutWriteBufferData(end_sz, 4, true);
+    uint32_t end_sz = buf_sz + 4;
+    memcpy(buf + buf_sz, &end_sz, 4);
 
-    if (write_sz != 4) {
+    if (!handler->CommitWriteBufferData(buf, buf_sz + 4)) {
         handler->ProtocolError();
-        delete[] buf;
         return -1;
     }
 
-    log_size += write_sz;
-
-    delete[] buf;
+    log_size += buf_sz + 4;
 
     return 1;
 }
@@ -207,10 +193,7 @@ int Pcap_Stream_Ringbuf::pcapng_make_idb(unsigned int in_sourcenumber, std::stri
     size_t opt_offt = 0;
 
     size_t buf_sz;
-    size_t write_sz;
 
-    uint32_t *end_sz = (uint32_t *) &buf_sz;
-    
     buf_sz = sizeof(pcapng_idb);
 
     // Allocate an end-of-options entry
@@ -224,14 +207,17 @@ int Pcap_Stream_Ringbuf::pcapng_make_idb(unsigned int in_sourcenumber, std::stri
         buf_sz += sizeof(pcapng_option_t) + PAD_TO_32BIT(in_desc.length());
     }
 
-    if (handler->GetWriteBufferAvailable() < (ssize_t) buf_sz + 4) {
+    if (!handler->EnsureWriteBufferSpace(buf_sz + 4)) {
         handler->ProtocolError();
         return -1;
     }
 
-    retbuf = new uint8_t[buf_sz];
+    // Reserve the entire block, including the trailing size, and assemble
+    // it in place
+    ssize_t r = handler->ReserveWriteBufferData((void **) &retbuf, buf_sz + 4);
 
-    if (retbuf == NULL) {
+    if (r != (ssize_t) buf_sz + 4) {
+        handler->CommitWriteBufferData(NULL, 0);
         handler->ProtocolError();
         return -1;
     }
@@ -266,35 +252,21 @@ int Pcap_Stream_Ringbuf::pcapng_make_idb(unsigned int in_sourcenumber, std::stri
     opt->option_code = PCAPNG_OPT_ENDOFOPT;
     opt->option_length = 0;
 
-    write_sz = handler->PutWriteBufferData(retbuf, buf_sz, true);
-
-    if (write_sz != buf_sz) {
-        handler->ProtocolError();
-        delete[] retbuf;
-        return -1;
-    }
-
-    log_size += write_sz;
-
     // Put the trailing size
-    *end_sz += 4;
-    
-    write_sz = handler->PutWriteBufferData(end_sz, 4, true);
+    uint32_t end_sz = buf_sz + 4;
+    memcpy(retbuf + buf_sz, &end_sz, 4);
 
-    if (write_sz != 4) {
+    if (!handler->CommitWriteBufferData(retbuf, buf_sz + 4)) {
         handler->ProtocolError();
-        delete[] retbuf;
         return -1;
     }
 
-    log_size += write_sz;
-
-    delete[] retbuf;
+    log_size += buf_sz + 4;
 
     return logid;
 }
 
-int Pcap_Stream_Ringbuf::pcapng_write_packet(unsigned int in_sourcenumber, 
+int Pcap_Stream_Ringbuf::pcapng_write_packet(unsigned int in_sourcenumber,
         struct timeval *in_tv, std::vector<data_block> in_blocks) {
     uint8_t *retbuf;
 
@@ -305,38 +277,31 @@ int Pcap_Stream_Ringbuf::pcapng_write_packet(unsigned int in_sourcenumber,
 
     pcapng_option *opt;
 
-    // Buffer contains just the header
-    size_t buf_sz = sizeof(pcapng_epb);
-
-    // Data contains header + data + options
-    size_t data_sz = buf_sz;
-
-    // End reference size
-    uint32_t *end_sz = (uint32_t *) &data_sz;
-
-    size_t write_sz;
-
     size_t aggregate_block_sz = 0;
 
     for (auto db : in_blocks) {
         aggregate_block_sz += db.len;
     }
 
-    // Pad to 32
-    data_sz += PAD_TO_32BIT(aggregate_block_sz);
-
-    // Allocate an end-of-options entry
-    data_sz += sizeof(pcapng_option);
+    // Total length of the assembled block - header, 32bit-padded data,
+    // end-of-options, and the trailing block size
+    size_t block_sz = sizeof(pcapng_epb) + PAD_TO_32BIT(aggregate_block_sz) +
+        sizeof(pcapng_option) + 4;
 
-    // Drop packet if we can't put it in the buffer
-    if (handler->GetWriteBufferAvailable() < (ssize_t) buf_sz + 4) {
+    // Let a growable ring expand for a lagging client before concluding
+    // the packet has to drop
+    if (!handler->EnsureWriteBufferSpace(block_sz)) {
         fprintf(stderr, "WARNING - pcapng ringbuf stream dropping packets\n");
         return 0;
     }
 
-    ssize_t r = handler->ReserveWriteBufferData((void **) &retbuf, buf_sz);
+    // Reserve the entire block as a single record and assemble it in place;
+    // the reservation is zero-copy whenever the ring doesn't wrap, and one
+    // commit replaces the string of small header/data/pad/option writes and
+    // the per-packet option scratch allocation
+    ssize_t r = handler->ReserveWriteBufferData((void **) &retbuf, block_sz);
 
-    if (r != (ssize_t) buf_sz) {
+    if (r != (ssize_t) block_sz) {
         handler->CommitWriteBufferData(NULL, 0);
         handler->ProtocolError();
         return -1;
@@ -345,7 +310,7 @@ int Pcap_Stream_Ringbuf::pcapng_write_packet(unsigned int in_sourcenumber,
     epb = (pcapng_epb *) retbuf;
 
     epb->block_type = PCAPNG_EPB_BLOCK_TYPE;
-    epb->block_length = data_sz + 4;
+    epb->block_length = block_sz;
     epb->interface_id = ng_interface_id;
 
     // Convert timestamp to 10e6 usec precision
@@ -360,90 +325,103 @@ int Pcap_Stream_Ringbuf::pcapng_write_packet(unsigned int in_sourcenumber,
     epb->captured_length = aggregate_block_sz;
     epb->original_length = aggregate_block_sz;
 
-    // Write the header to the ringbuf
-    write_sz = handler->CommitWriteBufferData(retbuf, buf_sz);
+    // Copy the incoming blocks sequentially
+    size_t block_offt = sizeof(pcapng_epb);
 
-    if (!write_sz) {
-        handler->ProtocolError();
-        return -1;
+    for (auto db : in_blocks) {
+        memcpy(retbuf + block_offt, db.data, db.len);
+        block_offt += db.len;
     }
 
-    log_size += write_sz;
+    // Zero the pad to 32bit
+    while (block_offt < sizeof(pcapng_epb) + PAD_TO_32BIT(aggregate_block_sz))
+        retbuf[block_offt++] = 0;
 
-    // Write all the incoming blocks sequentially
-    for (auto db : in_blocks) {
-        // Write the data to the ringbuf
-        write_sz = handler->PutWriteBufferData(db.data, db.len, true);
+    // Put the end-of-options
+    opt = (pcapng_option_t *) &retbuf[block_offt];
+    opt->option_code = PCAPNG_OPT_ENDOFOPT;
+    opt->option_length = 0;
+    block_offt += sizeof(pcapng_option);
 
-        if (write_sz != db.len) {
-            handler->ProtocolError();
-            return -1;
-        }
+    // Put the trailing size
+    uint32_t end_sz = block_sz;
+    memcpy(retbuf + block_offt, &end_sz, 4);
 
-        log_size += write_sz;
+    if (!handler->CommitWriteBufferData(retbuf, block_sz)) {
+        handler->ProtocolError();
+        return -1;
     }
 
-    // Pad data to 32bit
-    uint32_t pad = 0;
-    size_t pad_sz = 0;
-
-    pad_sz = PAD_TO_32BIT(aggregate_block_sz) - aggregate_block_sz;
+    log_size += block_sz;
 
-    if (pad_sz > 0) {
-        write_sz = handler->PutWriteBufferData(&pad, pad_sz, true);
+    return 1;
+}
 
-        if (write_sz != pad_sz) {
-            handler->ProtocolError();
-            return -1;
-        }
+// Build - or re-use - the framed EPB for this packet and chunk.  Every open
+// stream sees every chain packet, so when several clients stream from the
+// same server the framing cost is paid once per packet per distinct chunk;
+// subsequent streams find the finished block cached on the packet.  The
+// interface-id field is left zero since IDB numbering is stream-local.
+const std::string *Pcap_Stream_Ringbuf::fetch_framed_block(kis_packet *in_packet,
+        kis_datachunk *in_data) {
+    packet_component_pcapng_frame *framecache =
+        (packet_component_pcapng_frame *) in_packet->fetch(pack_comp_pcapng_frame);
+
+    if (framecache == NULL) {
+        framecache = new packet_component_pcapng_frame();
+        in_packet->insert(pack_comp_pcapng_frame, framecache);
+    }
 
-        log_size += write_sz;
+    // Streams with different data selectors frame different chunks; match
+    // on the chunk itself.  There are rarely more than one or two.
+    for (auto f = framecache->frames.begin(); f != framecache->frames.end(); ++f) {
+        if (f->first == in_data)
+            return &(f->second);
     }
 
-    // Allocate the options
-    retbuf = new uint8_t[sizeof(pcapng_option_t)];
+    // Total length of the assembled block - header, 32bit-padded data,
+    // end-of-options, and the trailing block size
+    size_t block_sz = sizeof(pcapng_epb) + PAD_TO_32BIT(in_data->length) +
+        sizeof(pcapng_option) + 4;
 
-    if (retbuf == NULL) {
-        handler->ProtocolError();
-        return -1;
-    }
+    // resize() zero-fills, which covers the 32bit pad and the
+    // end-of-options record for us
+    std::string block;
+    block.resize(block_sz, 0);
 
-    // Put the end-of-options
-    opt = (pcapng_option_t *) retbuf;
-    opt->option_code = PCAPNG_OPT_ENDOFOPT;
-    opt->option_length = 0;
+    pcapng_epb *epb = (pcapng_epb *) &block[0];
 
-    write_sz = handler->PutWriteBufferData(retbuf, sizeof(pcapng_option_t), true);
+    epb->block_type = PCAPNG_EPB_BLOCK_TYPE;
+    epb->block_length = block_sz;
+    epb->interface_id = 0;
 
-    if (write_sz != sizeof(pcapng_option_t)) {
-        handler->ProtocolError();
-        delete[] retbuf;
-        return -1;
-    }
+    // Convert timestamp to 10e6 usec precision
+    uint64_t conv_ts;
+    conv_ts = (uint64_t) in_packet->ts.tv_sec * 1000000L;
+    conv_ts += in_packet->ts.tv_usec;
 
-    log_size += write_sz;
+    // Split high and low ts
+    epb->timestamp_high = (conv_ts >> 32);
+    epb->timestamp_low = conv_ts;
 
-    delete[] retbuf;
+    epb->captured_length = in_data->length;
+    epb->original_length = in_data->length;
 
-    // Put the trailing size
-    *end_sz += 4;
-    
-    write_sz = handler->PutWriteBufferData(end_sz, 4, true);
+    memcpy(&block[sizeof(pcapng_epb)], in_data->data, in_data->length);
 
-    if (write_sz != 4) {
-        handler->ProtocolError();
-        return -1;
-    }
+    // Put the trailing size
+    uint32_t end_sz = block_sz;
+    memcpy(&block[block_sz - 4], &end_sz, 4);
 
-    log_size += write_sz;
+    framecache->frames.push_back(std::make_pair(in_data, std::move(block)));
 
-    return 1;
+    return &(framecache->frames.back().second);
 }
 
 int Pcap_Stream_Ringbuf::pcapng_write_packet(kis_packet *in_packet, kis_datachunk *in_data) {
     SharedDatasource kis_datasource;
 
-    packetchain_comp_datasource *datasrcinfo = 
+    packetchain_comp_datasource *datasrcinfo =
         (packetchain_comp_datasource *) in_packet->fetch(pack_comp_datasrc);
 
     // We can't log packets w/ no info b/c we don't know what source in the
@@ -451,7 +429,7 @@ int Pcap_Stream_Ringbuf::pcapng_write_packet(kis_packet *in_packet, kis_datachun
     if (datasrcinfo == NULL)
         return 0;
 
-    auto ds_id_rec = 
+    auto ds_id_rec =
         datasource_id_map.find(datasrcinfo->ref_source->get_source_number());
 
     // Interface ID for multiple interfaces per file
@@ -465,10 +443,39 @@ int Pcap_Stream_Ringbuf::pcapng_write_packet(kis_packet *in_packet, kis_datachun
         ng_interface_id = ds_id_rec->second;
     }
 
-    std::vector<data_block> blocks;
-    blocks.push_back(data_block(in_data->data, in_data->length));
+    const std::string *block = fetch_framed_block(in_packet, in_data);
 
-    return pcapng_write_packet(ng_interface_id, &(in_packet->ts), blocks);
+    // Let a growable ring expand for a lagging client before concluding
+    // the packet has to drop
+    if (!handler->EnsureWriteBufferSpace(block->length())) {
+        fprintf(stderr, "WARNING - pcapng ringbuf stream dropping packets\n");
+        return 0;
+    }
+
+    uint8_t *retbuf;
+
+    ssize_t r = handler->ReserveWriteBufferData((void **) &retbuf, block->length());
+
+    if (r != (ssize_t) block->length()) {
+        handler->CommitWriteBufferData(NULL, 0);
+        handler->ProtocolError();
+        return -1;
+    }
+
+    // One copy of the shared frame into our ring, then patch in the
+    // stream-local interface id
+    memcpy(retbuf, block->data(), block->length());
+
+    ((pcapng_epb *) retbuf)->interface_id = ng_interface_id;
+
+    if (!handler->CommitWriteBufferData(retbuf, block->length())) {
+        handler->ProtocolError();
+        return -1;
+    }
+
+    log_size += block->length();
+
+    return 1;
 }
 
 // Handle a packet from the chain; given the accept_cb and selector_cb we
@@ -481,12 +488,16 @@ int Pcap_Stream_Ringbuf::pcapng_write_packet(kis_packet *in_packet, kis_datachun
 void Pcap_Stream_Ringbuf::handle_chain_packet(kis_packet *in_packet) {
     kis_datachunk *target_datachunk;
 
-    // If we have an accept filter and it rejects, we're done
-    if (accept_cb != NULL && accept_cb(in_packet) == false)
+    // If we're paused, ignore packets; this is a single atomic read and
+    // every open stream sees every chain packet, so check it before we
+    // spend anything on the accept filter
+    if (get_stream_paused())
         return;
 
-    // If we're paused, ignore packets
-    if (get_stream_paused())
+    // If we have an accept filter and it rejects, we're done; the filter
+    // runs before any pcapng framing is considered, so a rejected packet
+    // costs a stream nothing but the callback itself
+    if (accept_cb != NULL && accept_cb(in_packet) == false)
         return;
 
     // If we have a selector filter, use it to get the data chunk, otherwise
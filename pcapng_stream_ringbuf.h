@@ -115,6 +115,26 @@ struct pcapng_epb {
 typedef struct pcapng_epb pcapng_epb_t;
 #define PCAPNG_EPB_BLOCK_TYPE       6
 
+/* Per-packet cache of framed EPB blocks, shared across every open pcapng
+ * stream.  When several streams are attached to the same server, each
+ * packet only gets framed once per distinct data chunk - the first stream
+ * to want it builds the complete block, and the rest copy the finished
+ * frame into their own ring and patch the stream-local interface id.
+ *
+ * Chain handlers for a single packet always run sequentially within one
+ * ordering domain, so the cache needs no locking; it is reclaimed with
+ * the packet. */
+class packet_component_pcapng_frame : public packet_component {
+public:
+    packet_component_pcapng_frame() {
+        self_destruct = 1;
+    }
+
+    // Completed EPB block per distinct data chunk; the interface-id field
+    // is left zero because IDB numbering is per-stream
+    std::vector<std::pair<kis_datachunk *, std::string> > frames;
+};
+
 /* Instantiate a stream that attaches to the packetchain, outputs packets 
  * of type dlt, and optionally, apply an accept filter function;
  *
@@ -159,6 +179,11 @@ protected:
     // Write a complete block using native headers
     virtual int pcapng_write_packet(kis_packet *in_packet, kis_datachunk *in_data);
 
+    // Fetch the shared framed EPB for a packet+chunk, building and caching
+    // it on the packet if no other stream has framed it yet
+    virtual const std::string *fetch_framed_block(kis_packet *in_packet,
+            kis_datachunk *in_data);
+
     // Low-level packet logging; accepts a vector of blocks to minimize the copying
     // needed to append custom headers
     virtual int pcapng_write_packet(unsigned int in_sourcenumber, struct timeval *in_tv,
@@ -178,7 +203,7 @@ protected:
     std::shared_ptr<BufferHandlerGeneric> handler;
 
     int packethandler_id;
-    int pack_comp_linkframe, pack_comp_datasrc;
+    int pack_comp_linkframe, pack_comp_datasrc, pack_comp_pcapng_frame;
 
     std::function<bool (kis_packet *)> accept_cb;
     std::function<kis_datachunk * (kis_packet *)> selector_cb;
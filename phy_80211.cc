@@ -263,7 +263,7 @@ Kis_80211_Phy::Kis_80211_Phy(GlobalRegistry *in_globalreg,
         Globalreg::FetchGlobalAs<Timetracker>(globalreg, "TIMETRACKER");
 
 	// Initialize the crc tables
-	crc32_init_table_80211(globalreg->crc32_table);
+	crc32_init_table_80211x4(globalreg->crc32_table);
 
     SetPhyName("IEEE802.11");
 
@@ -565,6 +565,43 @@ Kis_80211_Phy::Kis_80211_Phy(GlobalRegistry *in_globalreg,
         process_ctl_phy = false;
     }
 
+    // Compact probe-only station mode
+    if (globalreg->kismet_config->FetchOptBoolean("dot11_compact_probe_stations", 0)) {
+        _MSG("PHY802.11 will record probe-only stations in a compact table and "
+                "only promote them to full tracked devices when they show other "
+                "activity; this greatly reduces memory use in dense environments "
+                "but probe-only stations will not appear in the device list.",
+                MSGFLAG_INFO);
+        process_probe_compact = true;
+    } else {
+        process_probe_compact = false;
+    }
+
+    max_probe_stations =
+        globalreg->kismet_config->FetchOptInt("dot11_max_probe_stations", 65536);
+
+    probe_station_entry_id =
+        entrytracker->RegisterField("dot11.probe_station", TrackerMap,
+                "compact probe-only station");
+    probe_station_mac_id =
+        entrytracker->RegisterField("dot11.probe_station.macaddr", TrackerMac,
+                "station MAC address");
+    probe_station_first_id =
+        entrytracker->RegisterField("dot11.probe_station.first_time", TrackerUInt64,
+                "first time seen");
+    probe_station_last_id =
+        entrytracker->RegisterField("dot11.probe_station.last_time", TrackerUInt64,
+                "last time seen");
+    probe_station_packets_id =
+        entrytracker->RegisterField("dot11.probe_station.packets", TrackerUInt64,
+                "probe requests seen");
+    probe_station_signal_id =
+        entrytracker->RegisterField("dot11.probe_station.max_signal", TrackerInt32,
+                "strongest observed signal, dbm");
+    probe_station_ssid_count_id =
+        entrytracker->RegisterField("dot11.probe_station.probed_ssid_count", TrackerUInt64,
+                "distinct probed SSIDs");
+
 	dissect_strings = 0;
 	dissect_all_strings = 0;
 
@@ -635,15 +672,6 @@ Kis_80211_Phy::Kis_80211_Phy(GlobalRegistry *in_globalreg,
         Globalreg::FetchGlobalAs<Kis_Httpd_Registry>(globalreg, "WEBREGISTRY");
     httpregistry->register_js_module("kismet_ui_dot11", "/js/kismet.ui.dot11.js");
 
-    // Set up the de-duplication list
-    recent_packet_checksums_sz = 
-        globalreg->kismet_config->FetchOptUInt("packet_dedup_size", 2048);
-    recent_packet_checksums = new uint32_t[recent_packet_checksums_sz];
-    for (unsigned int x = 0; x < recent_packet_checksums_sz; x++) {
-        recent_packet_checksums[x] = 0;
-    }
-    recent_packet_checksum_pos = 0;
-
     // Parse the ssid regex options
     auto apspoof_lines = globalreg->kismet_config->FetchOptVec("apspoof");
 
@@ -722,8 +750,6 @@ Kis_80211_Phy::~Kis_80211_Phy() {
             CHAINPOS_CLASSIFIER);
 
     timetracker->RemoveTimer(device_idle_timer);
-
-    delete[] recent_packet_checksums;
 }
 
 int Kis_80211_Phy::LoadWepkeys() {
@@ -779,6 +805,84 @@ int Kis_80211_Phy::LoadWepkeys() {
 
 // Common classifier responsible for generating the common devices & mapping wifi packets
 // to those devices
+bool Kis_80211_Phy::CompactProbeStation(dot11_packinfo *dot11info, kis_packet *in_pack,
+        kis_layer1_packinfo *pack_l1info) {
+
+    // Already promoted to a full device?  Keep feeding it normally
+    TrackedDeviceKey key(globalreg->server_uuid_hash, FetchPhynameHash(),
+            dot11info->source_mac);
+
+    if (devicetracker->FetchDevice(key) != NULL)
+        return false;
+
+    local_locker lock(&probe_station_mutex);
+
+    auto pi = probe_station_map.find(dot11info->source_mac);
+
+    if (pi == probe_station_map.end()) {
+        // Bound the compact table itself; shed stations idle for more than
+        // five minutes first, and if it's still full, drop the newcomer -
+        // a packed record is cheap but not free
+        if ((int) probe_station_map.size() >= max_probe_stations) {
+            for (auto i = probe_station_map.begin(); i != probe_station_map.end(); ) {
+                if (in_pack->ts.tv_sec - i->second.last_time > 300)
+                    i = probe_station_map.erase(i);
+                else
+                    ++i;
+            }
+
+            if ((int) probe_station_map.size() >= max_probe_stations)
+                return true;
+        }
+
+        compact_probe_station rec;
+        rec.first_time = in_pack->ts.tv_sec;
+        rec.last_time = 0;
+        rec.packets = 0;
+        rec.max_signal = 0;
+
+        pi = probe_station_map.insert(std::make_pair(dot11info->source_mac, rec)).first;
+    }
+
+    if (pi->second.last_time < in_pack->ts.tv_sec)
+        pi->second.last_time = in_pack->ts.tv_sec;
+
+    pi->second.packets++;
+
+    if (pack_l1info != NULL && pack_l1info->signal_dbm != 0 &&
+            (pi->second.max_signal == 0 ||
+             pack_l1info->signal_dbm > pi->second.max_signal))
+        pi->second.max_signal = pack_l1info->signal_dbm;
+
+    // Cap the per-station SSID hash set; a fuzzer cycling SSIDs shouldn't
+    // be able to grow a probation record without bound
+    if (dot11info->ssid_csum != 0 && pi->second.probed_ssid_csums.size() < 64)
+        pi->second.probed_ssid_csums.insert(dot11info->ssid_csum);
+
+    return true;
+}
+
+void Kis_80211_Phy::FoldCompactProbeStation(std::shared_ptr<kis_tracked_device_base> basedev) {
+    if (!process_probe_compact)
+        return;
+
+    local_locker lock(&probe_station_mutex);
+
+    auto pi = probe_station_map.find(basedev->get_macaddr());
+
+    if (pi == probe_station_map.end())
+        return;
+
+    // Carry the probe-era first-seen time into the promoted device; the
+    // probed SSID content itself was never retained, only hashes, so the
+    // full probed-ssid record starts fresh
+    if (pi->second.first_time != 0 &&
+            pi->second.first_time < basedev->get_first_time())
+        basedev->set_first_time(pi->second.first_time);
+
+    probe_station_map.erase(pi);
+}
+
 int Kis_80211_Phy::CommonClassifierDot11(CHAINCALL_PARMS) {
     packetnum++;
 
@@ -882,14 +986,23 @@ int Kis_80211_Phy::CommonClassifierDot11(CHAINCALL_PARMS) {
         }
 
         if (dot11info->source_mac != dot11info->bssid_mac &&
-                dot11info->source_mac != globalreg->empty_mac && 
+                dot11info->source_mac != globalreg->empty_mac &&
                 !(dot11info->source_mac.bitwise_and(globalreg->multicast_mac)) ) {
-            source_dev =
-                d11phy->devicetracker->UpdateCommonDevice(commoninfo, 
-                        dot11info->source_mac, d11phy, in_pack, 
-                        (UCD_UPDATE_SIGNAL | UCD_UPDATE_FREQUENCIES |
-                         UCD_UPDATE_PACKETS | UCD_UPDATE_LOCATION |
-                         UCD_UPDATE_SEENBY | UCD_UPDATE_ENCRYPTION));
+            // In compact mode, blind probe requests from stations we don't
+            // already track live in the packed probe table instead of
+            // synthesizing a full device record
+            if (d11phy->process_probe_compact &&
+                    dot11info->subtype == packet_sub_probe_req &&
+                    d11phy->CompactProbeStation(dot11info, in_pack, pack_l1info)) {
+                // Absorbed; no device work for this frame
+            } else {
+                source_dev =
+                    d11phy->devicetracker->UpdateCommonDevice(commoninfo,
+                            dot11info->source_mac, d11phy, in_pack,
+                            (UCD_UPDATE_SIGNAL | UCD_UPDATE_FREQUENCIES |
+                             UCD_UPDATE_PACKETS | UCD_UPDATE_LOCATION |
+                             UCD_UPDATE_SEENBY | UCD_UPDATE_ENCRYPTION));
+            }
         }
 
         if (dot11info->dest_mac != dot11info->source_mac &&
@@ -948,6 +1061,8 @@ int Kis_80211_Phy::CommonClassifierDot11(CHAINCALL_PARMS) {
         }
 
         if (source_dev != NULL) {
+            d11phy->FoldCompactProbeStation(source_dev);
+
             local_locker sourcelocker(&(source_dev->device_mutex));
 
             source_dot11 =
@@ -984,6 +1099,8 @@ int Kis_80211_Phy::CommonClassifierDot11(CHAINCALL_PARMS) {
         }
 
         if (dest_dev != NULL) {
+            d11phy->FoldCompactProbeStation(dest_dev);
+
             local_locker destlocker(&(dest_dev->device_mutex));
 
             dest_dot11 =
@@ -991,13 +1108,13 @@ int Kis_80211_Phy::CommonClassifierDot11(CHAINCALL_PARMS) {
             std::stringstream newdevstr;
 
             if (dest_dot11 == NULL) {
-                newdevstr << "Detected new 802.11 Wi-Fi device " << 
+                newdevstr << "Detected new 802.11 Wi-Fi device " <<
                     dest_dev->get_macaddr().Mac2String() << " packet " << packetnum;
                 _MSG(newdevstr.str(), MSGFLAG_INFO);
 
                 dest_dot11.reset(new dot11_tracked_device(globalreg, d11phy->dot11_device_entry_id));
                 dot11_tracked_device::attach_base_parent(dest_dot11, dest_dev);
-                
+
                 dot11info->new_device = true;
             }
 
@@ -1168,6 +1285,8 @@ int Kis_80211_Phy::CommonClassifierDot11(CHAINCALL_PARMS) {
         // If we have a source device, we know it's not originating from the same radio as the AP,
         // since source != bssid
         if (source_dev != NULL) {
+            d11phy->FoldCompactProbeStation(source_dev);
+
             local_locker sourcelocker(&(source_dev->device_mutex));
 
             source_dot11 =
@@ -1797,7 +1916,26 @@ void Kis_80211_Phy::HandleProbedSSID(std::shared_ptr<kis_tracked_device_base> ba
     std::shared_ptr<dot11_probed_ssid> probessid = NULL;
     TrackerElement::int_map_iterator ssid_itr;
 
-    // Always re-parse the IEs on a probe
+    // If we've processed an identical probe, don't waste time parsing again,
+    // just tweak the few fields we need to update
+    if (dot11dev->get_last_probe_ie_csum() == dot11info->ietag_csum) {
+        probessid = dot11dev->get_last_probe_ssid();
+
+        if (probessid != NULL) {
+            if (probessid->get_last_time() < in_pack->ts.tv_sec)
+                probessid->set_last_time(in_pack->ts.tv_sec);
+
+            if (pack_gpsinfo != NULL && pack_gpsinfo->fix > 1) {
+                probessid->get_location()->add_loc(pack_gpsinfo->lat, pack_gpsinfo->lon,
+                        pack_gpsinfo->alt, pack_gpsinfo->fix);
+            }
+        }
+
+        return;
+    }
+
+    dot11dev->set_last_probe_ie_csum(dot11info->ietag_csum);
+
     if (PacketDot11IEdissector(in_pack, dot11info) < 0) {
         return;
     }
@@ -1805,9 +1943,42 @@ void Kis_80211_Phy::HandleProbedSSID(std::shared_ptr<kis_tracked_device_base> ba
     if (dot11info->subtype == packet_sub_probe_req ||
             dot11info->subtype == packet_sub_reassociation_req) {
 
+        // Remember every probed hash, even ones we evict the full record for
+        dot11dev->get_probed_ssid_hash_set()->insert(dot11info->ssid_csum,
+                in_pack->ts.tv_sec);
+
         ssid_itr = probemap.find(dot11info->ssid_csum);
 
         if (ssid_itr == probemap.end() || ssid_itr->second == NULL) {
+            // Cap the number of fully materialized probe records; evict the
+            // least recently seen record to make room for the new one
+            if (probemap.size() >= dot11_tracked_device::max_probed_ssids) {
+                TrackerElement::int_map_iterator oldest_itr = probemap.end();
+                time_t oldest_time = 0;
+
+                for (ssid_itr = probemap.begin(); ssid_itr != probemap.end();
+                        ++ssid_itr) {
+                    std::shared_ptr<dot11_probed_ssid> ps =
+                        std::static_pointer_cast<dot11_probed_ssid>(ssid_itr->second);
+
+                    if (oldest_itr == probemap.end() ||
+                            ps->get_last_time() < oldest_time) {
+                        oldest_itr = ssid_itr;
+                        oldest_time = ps->get_last_time();
+                    }
+                }
+
+                if (oldest_itr != probemap.end()) {
+                    if (dot11dev->get_last_probe_ssid() ==
+                            std::static_pointer_cast<dot11_probed_ssid>(oldest_itr->second)) {
+                        dot11dev->set_last_probe_ssid(NULL);
+                        dot11dev->set_last_probe_ie_csum(0);
+                    }
+
+                    probemap.erase(oldest_itr);
+                }
+            }
+
             probessid = dot11dev->new_probed_ssid();
             TrackerElement::int_map_pair p(dot11info->ssid_csum, probessid);
             probemap.insert(p);
@@ -1836,6 +2007,7 @@ void Kis_80211_Phy::HandleProbedSSID(std::shared_ptr<kis_tracked_device_base> ba
 
         dot11dev->set_last_probed_ssid(probessid->get_ssid());
         dot11dev->set_last_probed_ssid_csum(dot11info->ssid_csum);
+        dot11dev->set_last_probe_ssid(probessid);
     }
 
 }
@@ -1853,21 +2025,22 @@ void Kis_80211_Phy::ProcessClient(std::shared_ptr<kis_tracked_device_base> bssid
     local_locker bssidlock(&(bssiddev->device_mutex));
     local_locker clientlock(&(clientdev->device_mutex));
 
-    // Create and map the client behavior record for this BSSID
-    TrackerElementMacMap client_map(clientdot11->get_client_map());
-    std::shared_ptr<dot11_client> client_record;
-
-    auto cmi = client_map.find(bssiddev->get_macaddr());
+    // Find or create the client behavior record for this BSSID; the
+    // cached probe spares the ordered map walk on every data frame
+    std::shared_ptr<dot11_client> client_record =
+        clientdot11->find_client(bssiddev->get_macaddr());
     bool new_client_record = false;
 
-    if (cmi == client_map.end()) {
+    if (client_record == NULL) {
         client_record = clientdot11->new_client();
+
+        TrackerElementMacMap client_map(clientdot11->get_client_map());
         TrackerElement::mac_map_pair cp(bssiddev->get_macaddr(), client_record);
         client_map.insert(cp);
+
+        clientdot11->cache_client(bssiddev->get_macaddr(), client_record);
+
         new_client_record = true;
-    } else {
-        client_record = 
-            std::static_pointer_cast<dot11_client>(cmi->second);
     }
 
     if (new_client_record) {
@@ -1960,8 +2133,7 @@ void Kis_80211_Phy::ProcessClient(std::shared_ptr<kis_tracked_device_base> bssid
     client_record->set_bssid_key(bssiddev->get_key());
 
     // Update the backwards map to the client
-    if (bssiddot11->get_associated_client_map()->mac_find(clientdev->get_macaddr()) ==
-            bssiddot11->get_associated_client_map()->mac_end()) {
+    if (bssiddot11->note_associated_client(clientdev->get_macaddr())) {
         bssiddot11->get_associated_client_map()->add_macmap(clientdev->get_macaddr(),
                 clientdev->get_tracker_key());
     }
@@ -2239,6 +2411,10 @@ std::string Kis_80211_Phy::CryptToString(uint64_t cryptset) {
 
 bool Kis_80211_Phy::Httpd_VerifyPath(const char *path, const char *method) {
     if (strcmp(method, "GET") == 0) {
+        if (Httpd_CanSerialize(path) &&
+                Httpd_StripSuffix(path) == "/phy/phy80211/probe_stations")
+            return true;
+
         std::vector<std::string> tokenurl = StrTokenize(path, "/");
 
         // we care about
@@ -2389,6 +2565,52 @@ void Kis_80211_Phy::Httpd_CreateStreamResponse(Kis_Net_Httpd *httpd,
         return;
     }
 
+    // Explicit view into the compact probe-only station table; stations
+    // here haven't earned a full device record yet
+    if (Httpd_CanSerialize(url) &&
+            Httpd_StripSuffix(url) == "/phy/phy80211/probe_stations") {
+        SharedTrackerElement pvec(new TrackerElement(TrackerVector, 0));
+        TrackerElementVector pv(pvec);
+
+        {
+            local_locker lock(&probe_station_mutex);
+
+            for (auto i = probe_station_map.begin(); i != probe_station_map.end(); ++i) {
+                SharedTrackerElement pe(new TrackerElement(TrackerMap, probe_station_entry_id));
+
+                SharedTrackerElement pmac(new TrackerElement(TrackerMac, probe_station_mac_id));
+                pmac->set(i->first);
+                pe->add_map(pmac);
+
+                SharedTrackerElement pfirst(new TrackerElement(TrackerUInt64, probe_station_first_id));
+                pfirst->set((uint64_t) i->second.first_time);
+                pe->add_map(pfirst);
+
+                SharedTrackerElement plast(new TrackerElement(TrackerUInt64, probe_station_last_id));
+                plast->set((uint64_t) i->second.last_time);
+                pe->add_map(plast);
+
+                SharedTrackerElement ppackets(new TrackerElement(TrackerUInt64, probe_station_packets_id));
+                ppackets->set((uint64_t) i->second.packets);
+                pe->add_map(ppackets);
+
+                SharedTrackerElement psignal(new TrackerElement(TrackerInt32, probe_station_signal_id));
+                psignal->set((int32_t) i->second.max_signal);
+                pe->add_map(psignal);
+
+                SharedTrackerElement pssids(new TrackerElement(TrackerUInt64, probe_station_ssid_count_id));
+                pssids->set((uint64_t) i->second.probed_ssid_csums.size());
+                pe->add_map(pssids);
+
+                pv.push_back(pe);
+            }
+        }
+
+        entrytracker->Serialize(httpd->GetSuffix(url), stream, pvec, NULL);
+
+        return;
+    }
+
     std::vector<std::string> tokenurl = StrTokenize(url, "/");
 
     // /phy/phy80211/by-key/[key]/pcap/[mac]-handshake.pcap
@@ -2517,6 +2739,11 @@ public:
 
             if (globalreg->timestamp.tv_sec - pssid->get_last_time() > timeout &&
                     device->get_packets() < packets) {
+                if (dot11dev->get_last_probe_ssid() == pssid) {
+                    dot11dev->set_last_probe_ssid(NULL);
+                    dot11dev->set_last_probe_ie_csum(0);
+                }
+
                 probe_map.erase(int_itr);
                 int_itr = probe_map.begin();
                 devicetracker->UpdateFullRefresh();
@@ -2526,6 +2753,7 @@ public:
         TrackerElementMacMap client_map(dot11dev->get_client_map());
         std::shared_ptr<dot11_client> client = NULL;
         TrackerElementMacMap::iterator mac_itr;
+        bool pruned_client = false;
 
         for (mac_itr = client_map.begin(); mac_itr != client_map.end(); ++mac_itr) {
             // Always leave one
@@ -2538,10 +2766,15 @@ public:
                     device->get_packets() < packets) {
                 client_map.erase(mac_itr);
                 mac_itr = client_map.begin();
+                pruned_client = true;
                 devicetracker->UpdateFullRefresh();
             }
         }
 
+        // The association caches point into the maps we just pruned
+        if (pruned_client)
+            dot11dev->flush_assoc_caches();
+
         return false;
     }
 
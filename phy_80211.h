@@ -27,6 +27,9 @@
 #include <time.h>
 #include <list>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <algorithm>
 #include <string>
@@ -523,12 +526,13 @@ class dot11_probed_ssid : public tracker_component {
         virtual void reserve_fields(SharedTrackerElement e) {
             tracker_component::reserve_fields(e);
 
-            if (e != NULL) {
-                location.reset(new kis_tracked_location(globalreg, location_id, 
+            if (e != NULL && e->get_map_value(location_id) != NULL) {
+                location.reset(new kis_tracked_location(globalreg, location_id,
                             e->get_map_value(location_id)));
             }
 
-            add_map(location_id, location);
+            if (location != NULL)
+                add_map(location_id, location);
         }
 
         SharedTrackerElement ssid;
@@ -716,8 +720,9 @@ class dot11_advertised_ssid : public tracker_component {
             tracker_component::reserve_fields(e);
 
             if (e != NULL) {
-                location.reset(new kis_tracked_location(globalreg, location_id, 
-                            e->get_map_value(location_id)));
+                if (e->get_map_value(location_id) != NULL)
+                    location.reset(new kis_tracked_location(globalreg, location_id,
+                                e->get_map_value(location_id)));
 
                 // If we're inheriting, it's our responsibility to kick submaps and vectors with
                 // complex types as well; since they're not themselves complex objects
@@ -730,7 +735,8 @@ class dot11_advertised_ssid : public tracker_component {
                 }
             }
 
-            add_map(location_id, location);
+            if (location != NULL)
+                add_map(location_id, location);
         }
 
         SharedTrackerElement ssid;
@@ -891,14 +897,18 @@ class dot11_client : public tracker_component {
             tracker_component::reserve_fields(e);
 
             if (e != NULL) {
-                ipdata.reset(new kis_tracked_ip_data(globalreg, ipdata_id, 
-                            e->get_map_value(ipdata_id)));
-                location.reset(new kis_tracked_location(globalreg, location_id, 
-                            e->get_map_value(location_id)));
+                if (e->get_map_value(ipdata_id) != NULL)
+                    ipdata.reset(new kis_tracked_ip_data(globalreg, ipdata_id,
+                                e->get_map_value(ipdata_id)));
+                if (e->get_map_value(location_id) != NULL)
+                    location.reset(new kis_tracked_location(globalreg, location_id,
+                                e->get_map_value(location_id)));
             }
 
-            add_map(ipdata_id, ipdata);
-            add_map(location_id, location);
+            if (ipdata != NULL)
+                add_map(ipdata_id, ipdata);
+            if (location != NULL)
+                add_map(location_id, location);
         }
 
 
@@ -948,14 +958,101 @@ class dot11_client : public tracker_component {
 // We haven't seen this device directly but we've seen something talking to it
 #define DOT11_DEVICE_TYPE_INFERRED_WIRED    (1 << 7)
 
+// Capped open-addressed set of probed SSID hashes
+//
+// Randomizing clients probing hundreds of SSIDs would otherwise grow the
+// probed-SSID map without bound; full records are only materialized for
+// the most recent probes, and the rest of the history is remembered here
+// as bare hashes.  The table is fixed size; a colliding insert evicts the
+// least recently seen hash inside its probe window, so both memory and
+// per-probe cost stay constant.
+class dot11_ssid_hash_set {
+    public:
+        dot11_ssid_hash_set() {
+            memset(slot_hash, 0, sizeof(slot_hash));
+            memset(slot_time, 0, sizeof(slot_time));
+            distinct = 0;
+        }
+
+        // Record a SSID hash; returns true if it was not already in the set
+        bool insert(uint32_t hash, time_t when) {
+            // Zero marks an empty slot
+            if (hash == 0)
+                hash = 1;
+
+            unsigned int base = hash % set_slots;
+            unsigned int lru = base;
+
+            for (unsigned int p = 0; p < set_probe_window; p++) {
+                unsigned int s = (base + p) % set_slots;
+
+                if (slot_hash[s] == hash) {
+                    slot_time[s] = when;
+                    return false;
+                }
+
+                if (slot_hash[s] == 0) {
+                    slot_hash[s] = hash;
+                    slot_time[s] = when;
+                    distinct++;
+                    return true;
+                }
+
+                if (slot_time[s] < slot_time[lru])
+                    lru = s;
+            }
+
+            // Probe window full; evict the least recently seen hash.  A
+            // re-probe of an evicted hash counts as distinct again, so the
+            // distinct count is an approximation once eviction kicks in.
+            slot_hash[lru] = hash;
+            slot_time[lru] = when;
+            distinct++;
+            return true;
+        }
+
+        bool contains(uint32_t hash) const {
+            if (hash == 0)
+                hash = 1;
+
+            unsigned int base = hash % set_slots;
+
+            for (unsigned int p = 0; p < set_probe_window; p++) {
+                unsigned int s = (base + p) % set_slots;
+
+                if (slot_hash[s] == hash)
+                    return true;
+
+                if (slot_hash[s] == 0)
+                    return false;
+            }
+
+            return false;
+        }
+
+        // Number of distinct hashes ever inserted
+        uint64_t size() const {
+            return distinct;
+        }
+
+    protected:
+        static const unsigned int set_slots = 128;
+        static const unsigned int set_probe_window = 8;
+
+        uint32_t slot_hash[set_slots];
+        time_t slot_time[set_slots];
+        uint64_t distinct;
+};
+
 // Dot11 device
 //
 // Device-level data, additional data stored in the client and ssid arrays
 class dot11_tracked_device : public tracker_component {
     public:
         dot11_tracked_device(GlobalRegistry *in_globalreg, int in_id) :
-            tracker_component(in_globalreg, in_id) { 
+            tracker_component(in_globalreg, in_id) {
                 last_adv_ie_csum = 0;
+                last_probe_ie_csum = 0;
                 register_fields();
                 reserve_fields(NULL);
             }
@@ -968,6 +1065,7 @@ class dot11_tracked_device : public tracker_component {
                 SharedTrackerElement e) :
             tracker_component(in_globalreg, in_id) {
                 last_adv_ie_csum = 0;
+                last_probe_ie_csum = 0;
                 register_fields();
                 reserve_fields(e);
             }
@@ -986,6 +1084,59 @@ class dot11_tracked_device : public tracker_component {
         }
         __Proxy(num_client_aps, uint64_t, uint64_t, uint64_t, num_client_aps);
 
+        // Fast-path probe of the per-bssid client record, via a non-tracked
+        // hash cache keyed on the packed mac; the tracked macmap stays
+        // authoritative (and is what serializes), the cache spares the
+        // ordered map walk on every data frame.  Guarded by the owning
+        // device's mutex, like the maps themselves.
+        std::shared_ptr<dot11_client> find_client(mac_addr in_bssid) {
+            auto ci = client_map_cache.find(in_bssid.longmac);
+
+            if (ci != client_map_cache.end())
+                return ci->second;
+
+            TrackerElementMacMap cmap(client_map);
+
+            auto cmi = cmap.find(in_bssid);
+
+            if (cmi == cmap.end())
+                return NULL;
+
+            std::shared_ptr<dot11_client> cr =
+                std::static_pointer_cast<dot11_client>(cmi->second);
+
+            client_map_cache[in_bssid.longmac] = cr;
+
+            return cr;
+        }
+
+        void cache_client(mac_addr in_bssid, std::shared_ptr<dot11_client> in_client) {
+            client_map_cache[in_bssid.longmac] = in_client;
+        }
+
+        // Check-and-remember an associated client; returns true if the
+        // client wasn't already in the associated map and should be added
+        bool note_associated_client(mac_addr in_mac) {
+            if (associated_client_cache.find(in_mac.longmac) !=
+                    associated_client_cache.end())
+                return false;
+
+            bool present =
+                get_associated_client_map()->mac_find(in_mac) !=
+                get_associated_client_map()->mac_end();
+
+            associated_client_cache.insert(in_mac.longmac);
+
+            return !present;
+        }
+
+        // Drop the association caches; called when the tracked maps are
+        // pruned out from under them
+        void flush_assoc_caches() {
+            client_map_cache.clear();
+            associated_client_cache.clear();
+        }
+
 
         __ProxyTrackable(advertised_ssid_map, TrackerElement, advertised_ssid_map);
         std::shared_ptr<dot11_advertised_ssid> new_advertised_ssid() {
@@ -1060,6 +1211,23 @@ class dot11_tracked_device : public tracker_component {
             last_adv_ssid = adv_ssid;
         }
 
+        uint32_t get_last_probe_ie_csum() { return last_probe_ie_csum; }
+        void set_last_probe_ie_csum(uint32_t csum) { last_probe_ie_csum = csum; }
+        std::shared_ptr<dot11_probed_ssid> get_last_probe_ssid() {
+            return last_probe_ssid;
+        }
+        void set_last_probe_ssid(std::shared_ptr<dot11_probed_ssid> probe_ssid) {
+            last_probe_ssid = probe_ssid;
+        }
+
+        // Maximum number of fully materialized probe records per device;
+        // older records are evicted and tracked as hashes only
+        static const unsigned int max_probed_ssids = 64;
+
+        dot11_ssid_hash_set *get_probed_ssid_hash_set() {
+            return &probed_ssid_hash_set;
+        }
+
         virtual void pre_serialize() {
             TrackerElementMacMap c_e_map(client_map);
             TrackerElementIntMap a_s_map(advertised_ssid_map);
@@ -1068,7 +1236,10 @@ class dot11_tracked_device : public tracker_component {
 
             set_num_client_aps(c_e_map.size());
             set_num_advertised_ssids(a_s_map.size());
-            set_num_probed_ssids(p_s_map.size());
+            // The materialized map is capped; the hash set remembers the
+            // distinct probes which have been evicted from it
+            set_num_probed_ssids(std::max((uint64_t) p_s_map.size(),
+                        probed_ssid_hash_set.size()));
             set_num_associated_clients(a_c_map.size());
         }
 
@@ -1251,6 +1422,11 @@ class dot11_tracked_device : public tracker_component {
         int client_map_entry_id;
         SharedTrackerElement num_client_aps;
 
+        // Non-tracked hash caches over the association maps, keyed on the
+        // packed mac; see find_client / note_associated_client
+        std::unordered_map<uint64_t, std::shared_ptr<dot11_client> > client_map_cache;
+        std::unordered_set<uint64_t> associated_client_cache;
+
         // Records of this device advertising SSIDs
         SharedTrackerElement advertised_ssid_map;
         int advertised_ssid_map_entry_id;
@@ -1294,6 +1470,9 @@ class dot11_tracked_device : public tracker_component {
         // Un-exposed internal tracking options
         uint32_t last_adv_ie_csum;
         std::shared_ptr<dot11_advertised_ssid> last_adv_ssid;
+        uint32_t last_probe_ie_csum;
+        std::shared_ptr<dot11_probed_ssid> last_probe_ssid;
+        dot11_ssid_hash_set probed_ssid_hash_set;
 };
 
 class dot11_ssid_alert {
@@ -1316,7 +1495,80 @@ class dot11_ssid_alert {
         macmap<int> allow_mac_map;
 };
 
-class Kis_80211_Phy : public Kis_Phy_Handler, 
+class dot11_ie_48_rsn;
+class dot11_ie_221_wfa_wpa;
+class dot11_ie_221_ms_wps;
+
+// Small LRU memoization cache for parsed IE object graphs, keyed by the IE
+// contents.  Repeat frames from the same AP carry byte-identical WPS / WPA /
+// RSN IEs, so a cache hit resolves to the previously parsed shared object
+// instead of re-running the kaitai parse.  The full key bytes are kept and
+// compared on lookup so a checksum collision can't cross-wire two networks.
+// Cached objects are shared between packets and must never be mutated by
+// consumers.
+template<class P>
+class dot11_parsed_ie_cache {
+public:
+    dot11_parsed_ie_cache(size_t in_max_ents = 64) : max_ents(in_max_ents) { }
+
+    std::shared_ptr<P> fetch(kaitai::kbytes in_key) {
+        local_locker lock(&cache_mutex);
+
+        uint32_t csum = Adler32Checksum(in_key.data(), in_key.length());
+
+        auto i = cache_map.find(csum);
+
+        if (i == cache_map.end())
+            return NULL;
+
+        if (i->second.key.length() != in_key.length() ||
+                memcmp(i->second.key.data(), in_key.data(), in_key.length()) != 0)
+            return NULL;
+
+        recency.splice(recency.begin(), recency, i->second.recency_itr);
+
+        return i->second.parsed;
+    }
+
+    void insert(kaitai::kbytes in_key, std::shared_ptr<P> in_parsed) {
+        local_locker lock(&cache_mutex);
+
+        uint32_t csum = Adler32Checksum(in_key.data(), in_key.length());
+
+        // Keep the existing entry on a duplicate (or colliding) insert
+        if (cache_map.find(csum) != cache_map.end())
+            return;
+
+        if (cache_map.size() >= max_ents) {
+            cache_map.erase(recency.back());
+            recency.pop_back();
+        }
+
+        recency.push_front(csum);
+
+        cache_entry e;
+        e.key = in_key.to_string();
+        e.parsed = in_parsed;
+        e.recency_itr = recency.begin();
+
+        cache_map[csum] = e;
+    }
+
+protected:
+    struct cache_entry {
+        std::string key;
+        std::shared_ptr<P> parsed;
+        std::list<uint32_t>::iterator recency_itr;
+    };
+
+    kis_recursive_timed_mutex cache_mutex;
+
+    size_t max_ents;
+    std::map<uint32_t, cache_entry> cache_map;
+    std::list<uint32_t> recency;
+};
+
+class Kis_80211_Phy : public Kis_Phy_Handler,
     public Kis_Net_Httpd_CPPStream_Handler, public TimetrackerEvent {
 
 public:
@@ -1404,10 +1656,10 @@ protected:
     std::shared_ptr<Packetchain> packetchain;
     std::shared_ptr<Timetracker> timetracker;
 
-    // Checksum of recent packets for duplication filtering
-    uint32_t *recent_packet_checksums;
-    size_t recent_packet_checksums_sz;
-    unsigned int recent_packet_checksum_pos;
+    // Memoization caches for the expensive vendor/crypt IE parses
+    dot11_parsed_ie_cache<dot11_ie_48_rsn> rsn_ie_cache;
+    dot11_parsed_ie_cache<dot11_ie_221_wfa_wpa> wpa_ie_cache;
+    dot11_parsed_ie_cache<dot11_ie_221_ms_wps> wps_ie_cache;
 
     // Handle advertised SSIDs
     void HandleSSID(std::shared_ptr<kis_tracked_device_base> basedev, 
@@ -1516,7 +1768,7 @@ protected:
     time_t conf_save;
 
     // probe assoc to owning network
-    std::map<mac_addr, kis_tracked_device_base *> probe_assoc_map;
+    std::unordered_map<mac_addr, kis_tracked_device_base *> probe_assoc_map;
 
     // Do we time out components of devices?
     int device_idle_expiration;
@@ -1528,6 +1780,43 @@ protected:
 
     // Do we process control and phy frames?
     bool process_ctl_phy;
+
+    // Compact probe-only station tracking.  In dense public spaces the
+    // overwhelming majority of stations are only ever seen as blind probe
+    // requests; when dot11_compact_probe_stations is enabled they're held
+    // in this packed table instead of being promoted to a full tracked
+    // device, and only become a real device when they show any other
+    // activity (association, data frames, or an AP answering them), at
+    // which point the packed history is folded into the new device.
+    struct compact_probe_station {
+        time_t first_time;
+        time_t last_time;
+        uint32_t packets;
+        int max_signal;
+        std::set<uint32_t> probed_ssid_csums;
+    };
+
+    // Absorb a blind probe request into the compact table; returns false
+    // if the station is already a full tracked device and the packet
+    // should be processed normally
+    bool CompactProbeStation(dot11_packinfo *dot11info, kis_packet *in_pack,
+            kis_layer1_packinfo *pack_l1info);
+
+    // Fold any packed history into a freshly promoted device and retire
+    // the compact record
+    void FoldCompactProbeStation(std::shared_ptr<kis_tracked_device_base> basedev);
+
+    bool process_probe_compact;
+    int max_probe_stations;
+
+    kis_recursive_timed_mutex probe_station_mutex;
+    std::map<mac_addr, compact_probe_station> probe_station_map;
+
+    // Entrytracker ids for the probe_stations endpoint
+    int probe_station_entry_id, probe_station_mac_id,
+        probe_station_first_id, probe_station_last_id,
+        probe_station_packets_id, probe_station_signal_id,
+        probe_station_ssid_count_id;
     };
 
 #endif
@@ -29,6 +29,7 @@
 #include <iomanip>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 
 #include "endian_magic.h"
 #include "phy_80211.h"
@@ -274,6 +275,11 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
         return 0;
     }
 
+    // Don't dissect anything the prefilter already rejected
+    if (in_pack->filtered) {
+        return 0;
+    }
+
     debugpcknum++;
     // printf("debug - packet %d\n", debugpcknum);
 
@@ -295,24 +301,6 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
     if (chunk->dlt != KDLT_IEEE802_11)
         return 0;
 
-    // Compare the checksum and see if we've recently seen this exact packet
-    uint32_t chunk_csum = Adler32Checksum((const char *) chunk->data, chunk->length);
-
-    for (unsigned int c = 0; c < recent_packet_checksums_sz; c++) {
-        if (recent_packet_checksums[c] == 0)
-            break;
-
-        if (recent_packet_checksums[c] == chunk_csum) {
-            in_pack->filtered = 1;
-            in_pack->duplicate = 1;
-            return 0;
-        }
-    }
-
-    if (recent_packet_checksums_sz > 0)
-        recent_packet_checksums[(recent_packet_checksum_pos++ % recent_packet_checksums_sz)] = 
-            chunk_csum;
-
     // Flat-out dump if it's not big enough to be 80211, don't even bother making a
     // packinfo record for it because we're completely broken
     if (chunk->length < 10) {
@@ -343,8 +331,6 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
         common->basic_crypt_set |= KIS_DEVICE_BASICCRYPT_ENCRYPTED;
     }
 
-    uint16_t duration = 0;
-
     // 18 bytes of normal address ranges
     uint8_t *addr0 = NULL;
     uint8_t *addr1 = NULL;
@@ -357,9 +343,8 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
     packinfo->subtype = packet_sub_unknown;
     packinfo->distrib = distrib_unknown;
 
-    // Endian swap the duration  ** Optimize this in the future **
-    memcpy(&duration, &(chunk->data[2]), 2);
-    duration = kis_ntoh16(duration);
+    // Endian swap the duration
+    packinfo->duration = kis_extractBE16(&(chunk->data[2]));
 
     // 2 bytes of sequence and fragment counts
     wireless_fragseq *sequence;
@@ -391,7 +376,8 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
         packinfo->type = packet_phy;
         common->type = packet_basic_phy;
 
-        if (fc->subtype == 5) { 
+        switch (fc->subtype) {
+        case 5: {
             packinfo->subtype = packet_sub_vht_ndp;
 
             if (addr0 == NULL || addr1 == NULL) {
@@ -405,7 +391,9 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
             packinfo->bssid_mac = mac_addr(0);
             packinfo->other_mac = mac_addr(0);
 
-        } else if (fc->subtype == 8) {
+            break;
+        }
+        case 8: {
             packinfo->subtype = packet_sub_block_ack_req;
 
             if (addr0 == NULL || addr1 == NULL) {
@@ -419,7 +407,9 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
             packinfo->bssid_mac = mac_addr(0);
             packinfo->other_mac = mac_addr(0);
 
-        } else if (fc->subtype == 9) {
+            break;
+        }
+        case 9: {
             packinfo->subtype = packet_sub_block_ack;
 
             if (addr0 == NULL || addr1 == NULL) {
@@ -430,7 +420,9 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
 
             packinfo->source_mac = mac_addr(addr0, PHY80211_MAC_LEN);
             packinfo->dest_mac = mac_addr(addr1, PHY80211_MAC_LEN);
-        } else if (fc->subtype == 10) {
+            break;
+        }
+        case 10: {
             packinfo->subtype = packet_sub_pspoll;
 
             if (addr0 == NULL) {
@@ -444,7 +436,9 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
             packinfo->dest_mac = mac_addr(0);
             packinfo->other_mac = mac_addr(0);
 
-        } else if (fc->subtype == 11) {
+            break;
+        }
+        case 11: {
             packinfo->subtype = packet_sub_rts;
 
             if (addr0 == NULL || addr1 == NULL) {
@@ -458,7 +452,9 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
             packinfo->bssid_mac = mac_addr(0);
             packinfo->other_mac = mac_addr(0);
 
-        } else if (fc->subtype == 12) {
+            break;
+        }
+        case 12: {
             packinfo->subtype = packet_sub_cts;
 
             if (addr0 == NULL) {
@@ -472,7 +468,9 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
             packinfo->bssid_mac = mac_addr(0);
             packinfo->other_mac = mac_addr(0);
 
-        } else if (fc->subtype == 13) {
+            break;
+        }
+        case 13: {
             packinfo->subtype = packet_sub_ack;
 
             if (addr0 == NULL) {
@@ -486,7 +484,9 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
             packinfo->bssid_mac = mac_addr(0);
             packinfo->other_mac = mac_addr(0);
 
-        } else if (fc->subtype == 14) {
+            break;
+        }
+        case 14: {
             packinfo->subtype = packet_sub_cf_end;
 
             packinfo->bssid_mac = mac_addr(0);
@@ -494,7 +494,9 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
             packinfo->dest_mac = mac_addr(0);
             packinfo->other_mac = mac_addr(0);
 
-        } else if (fc->subtype == 15) {
+            break;
+        }
+        case 15: {
             packinfo->subtype = packet_sub_cf_end_ack;
 
             packinfo->bssid_mac = mac_addr(0);
@@ -502,7 +504,9 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
             packinfo->dest_mac = mac_addr(0);
             packinfo->other_mac = mac_addr(0);
 
-        } else {
+            break;
+        }
+        default: {
             fprintf(stderr, "debug - unknown type - %u %u\n", fc->type, fc->subtype);
             packinfo->subtype = packet_sub_unknown;
 
@@ -510,6 +514,8 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
             packinfo->source_mac = mac_addr(0);
             packinfo->dest_mac = mac_addr(0);
             packinfo->other_mac = mac_addr(0);
+            break;
+        }
         }
 
         // Fill in the common addressing before we bail on a phy
@@ -568,35 +574,44 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
 
         fixed_parameters *fixparm = NULL;
 
-        if (fc->subtype == 0) {
+        switch (fc->subtype) {
+        case 0: {
             packinfo->subtype = packet_sub_association_req;
 
             packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
             packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
             packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
 
-        } else if (fc->subtype == 1) {
+            break;
+        }
+        case 1: {
             packinfo->subtype = packet_sub_association_resp;
 
             packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
             packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
             packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
 
-        } else if (fc->subtype == 2) {
+            break;
+        }
+        case 2: {
             packinfo->subtype = packet_sub_reassociation_req;
 
             packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
             packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
             packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
 
-        } else if (fc->subtype == 3) {
+            break;
+        }
+        case 3: {
             packinfo->subtype = packet_sub_reassociation_resp;
 
             packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
             packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
             packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
 
-        } else if (fc->subtype == 4) {
+            break;
+        }
+        case 4: {
             packinfo->subtype = packet_sub_probe_req;
 
             packinfo->distrib = distrib_to;
@@ -605,13 +620,17 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
             packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
             packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
             
-        } else if (fc->subtype == 5) {
+            break;
+        }
+        case 5: {
             packinfo->subtype = packet_sub_probe_resp;
 
             packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
             packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
             packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
-        } else if (fc->subtype == 8) {
+            break;
+        }
+        case 8: {
             packinfo->subtype = packet_sub_beacon;
 
             packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
@@ -624,7 +643,9 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
                 packinfo->corrupt = 1;
             }
             
-        } else if (fc->subtype == 9) {
+            break;
+        }
+        case 9: {
             // I'm not positive this is the right handling of atim packets.  
             // Do something smarter in the future
             packinfo->subtype = packet_sub_atim;
@@ -635,50 +656,59 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
 
             packinfo->distrib = distrib_unknown;
 
-        } else if (fc->subtype == 10) {
+            break;
+        }
+        case 10: {
             packinfo->subtype = packet_sub_disassociation;
 
             packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
             packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
             packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
 
-            uint16_t rcode;
-            memcpy(&rcode, (const char *) &(chunk->data[24]), 2);
+            uint16_t rcode = kis_unaligned_load16(&(chunk->data[24]));
 
             packinfo->mgt_reason_code = rcode;
 
-        } else if (fc->subtype == 11) {
+            break;
+        }
+        case 11: {
             packinfo->subtype = packet_sub_authentication;
 
             packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
             packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
             packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
 
-            uint16_t rcode;
-            memcpy(&rcode, (const char *) &(chunk->data[24]), 2);
+            uint16_t rcode = kis_unaligned_load16(&(chunk->data[24]));
 
             packinfo->mgt_reason_code = rcode;
 
-        } else if (fc->subtype == 12) {
+            break;
+        }
+        case 12: {
             packinfo->subtype = packet_sub_deauthentication;
 
             packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
             packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
             packinfo->bssid_mac = mac_addr(addr2, PHY80211_MAC_LEN);
 
-            uint16_t rcode;
-            memcpy(&rcode, (const char *) &(chunk->data[24]), 2);
+            uint16_t rcode = kis_unaligned_load16(&(chunk->data[24]));
 
             packinfo->mgt_reason_code = rcode;
-        } else if (fc->subtype == 13) {
+            break;
+        }
+        case 13: {
             packinfo->subtype = packet_sub_action;
 
             packinfo->dest_mac = mac_addr(addr0, PHY80211_MAC_LEN);
             packinfo->source_mac = mac_addr(addr1, PHY80211_MAC_LEN);
             packinfo->bssid_mac = mac_addr(addr3, PHY80211_MAC_LEN);
-        } else {
+            break;
+        }
+        default: {
             fprintf(stderr, "debug - unknown type - %u %u\n", fc->type, fc->subtype);
             packinfo->subtype = packet_sub_unknown;
+            break;
+        }
         }
 
         if (fc->subtype == packet_sub_probe_req || 
@@ -695,14 +725,14 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
             packinfo->header_offset = 24;
             fixparm = NULL;
 
-            membuf pack_membuf((char *) &(chunk->data[packinfo->header_offset]), 
-                    (char *) &(chunk->data[chunk->length]));
-            std::istream pack_stream(&pack_membuf);
-
             std::shared_ptr<dot11_action> action(new dot11_action());
 
             try {
-                std::shared_ptr<kaitai::kstream> ks(new kaitai::kstream(&pack_stream));
+                // Borrow the packet contents rather than copying them into a
+                // stream
+                std::shared_ptr<kaitai::kstream> ks(new kaitai::kstream(
+                            (const char *) &(chunk->data[packinfo->header_offset]),
+                            chunk->length - packinfo->header_offset));
                 action->parse(ks);
             } catch (const std::exception& e) {
                 fprintf(stderr, "debug - unable to parse action frame - %s\n", e.what());
@@ -718,21 +748,18 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
                 // Scan the action IE tags
                 std::shared_ptr<dot11_ie> rmm_tags(new dot11_ie());
 
-                try {
-                    rmm_tags->parse(action_rmm->tags_data_stream());
-                } catch (const std::exception& e) {
-                    // fprintf(stderr, "debug - invalid ie rmm tags: %s\n", e.what());
+                if (rmm_tags->parse(action_rmm->tags_data_stream()) < 0) {
+                    // fprintf(stderr, "debug - invalid ie rmm tags\n");
                     packinfo->corrupt = 1;
                     in_pack->insert(_PCM(PACK_COMP_80211), packinfo);
                     return 0;
                 }
 
-                for (auto t : *(rmm_tags->tags())) {
-                    if (t->tag_num() == 52) {
-                        try {
-                            dot11_ie_52_rmm ie_rmm;
-                            ie_rmm.parse(t->tag_data_stream());
+                for (auto& t : *(rmm_tags->tags())) {
+                    if (t.tag_num() == 52) {
+                        dot11_ie_52_rmm ie_rmm;
 
+                        if (ie_rmm.parse(t.tag_data_stream()) == 0) {
                             if (ie_rmm.channel_number() > 0xE0) {
                                 std::stringstream ss;
 
@@ -743,14 +770,13 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
                                     "exploit attempt against Broadcom chipsets used in mobile " <<
                                     "devices.";
 
-                                alertracker->RaiseAlert(alert_11kneighborchan_ref, in_pack, 
-                                        packinfo->bssid_mac, packinfo->source_mac, 
-                                        packinfo->dest_mac, packinfo->other_mac, 
+                                alertracker->RaiseAlert(alert_11kneighborchan_ref, in_pack,
+                                        packinfo->bssid_mac, packinfo->source_mac,
+                                        packinfo->dest_mac, packinfo->other_mac,
                                         packinfo->channel, ss.str());
                             }
-
-                        } catch (const std::exception& e) {
-                            fprintf(stderr, "debug - unable to parse rmm neighbor - %s\n", e.what());
+                        } else {
+                            fprintf(stderr, "debug - unable to parse rmm neighbor\n");
                         }
                     }
                 }
@@ -788,13 +814,7 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
             }
 
             // Pull the fixparm timestamp
-            uint64_t temp_ts;
-            memcpy(&temp_ts, fixparm->timestamp, 8);
-#ifdef WORDS_BIGENDIAN
-            packinfo->timestamp = kis_swap64(temp_ts);
-#else
-            packinfo->timestamp = temp_ts;
-#endif
+            packinfo->timestamp = kis_extractLE64(fixparm->timestamp);
         }
 
         // Look for MSF opcode beacons before tag decode
@@ -854,61 +874,92 @@ int Kis_80211_Phy::PacketDot11dissector(kis_packet *in_pack) {
 
         // Collect the subtypes - we probably want to do something better with thse
         // in the future
-        if (fc->subtype == 0) {
+        switch (fc->subtype) {
+        case 0: {
             packinfo->subtype = packet_sub_data;
 
-        } else if (fc->subtype == 1) {
+            break;
+        }
+        case 1: {
             packinfo->subtype = packet_sub_data_cf_ack;
 
-        } else if (fc->subtype == 2) {
+            break;
+        }
+        case 2: {
             packinfo->subtype = packet_sub_data_cf_poll;
 
-        } else if (fc->subtype == 3) {
+            break;
+        }
+        case 3: {
             packinfo->subtype = packet_sub_data_cf_ack_poll;
 
-        } else if (fc->subtype == 4) {
+            break;
+        }
+        case 4: {
             packinfo->subtype = packet_sub_data_null;
 
-        } else if (fc->subtype == 5) {
+            break;
+        }
+        case 5: {
             packinfo->subtype = packet_sub_cf_ack;
 
-        } else if (fc->subtype == 6) {
+            break;
+        }
+        case 6: {
             packinfo->subtype = packet_sub_cf_ack_poll;
-        } else if (fc->subtype == 8) {
+            break;
+        }
+        case 8: {
             // Ugly hack, do this better
             packinfo->subtype = packet_sub_data_qos_data;
             // printf("debug - qos data, offset +2, %u to %u\n", packinfo->header_offset, packinfo->header_offset + 2);
             packinfo->header_offset += 2;
-        } else if (fc->subtype == 9) {
+            break;
+        }
+        case 9: {
             // Ugly hack, do this better
             packinfo->subtype = packet_sub_data_qos_data_cf_ack;
             packinfo->header_offset += 2;
-        } else if (fc->subtype == 10) {
+            break;
+        }
+        case 10: {
             // Ugly hack, do this better
             packinfo->subtype = packet_sub_data_qos_data_cf_poll;
             packinfo->header_offset += 2;
-        } else if (fc->subtype == 11) {
+            break;
+        }
+        case 11: {
             // Ugly hack, do this better
             packinfo->subtype = packet_sub_data_qos_data_cf_ack_poll;
             packinfo->header_offset += 2;
-        } else if (fc->subtype == 12) {
+            break;
+        }
+        case 12: {
             // Ugly hack, do this better
             packinfo->subtype = packet_sub_data_qos_null;
             packinfo->header_offset += 2;
-        } else if (fc->subtype == 14) {
+            break;
+        }
+        case 14: {
             // Ugly hack, do this better
             packinfo->subtype = packet_sub_data_qos_cf_poll_nod;
             packinfo->header_offset += 2;
-        } else if (fc->subtype == 15) {
+            break;
+        }
+        case 15: {
             // Ugly hack, do this better
             packinfo->subtype = packet_sub_data_qos_cf_ack_poll;
             packinfo->header_offset += 2;
-        } else {
+            break;
+        }
+        default: {
             fprintf(stderr, "debug - unknown type/subtype %u %u\n", packinfo->type, packinfo->subtype);
             packinfo->corrupt = 1;
             packinfo->subtype = packet_sub_unknown;
             in_pack->insert(pack_comp_80211, packinfo);
             return 0;
+            break;
+        }
         }
 
         // Extract ID's
@@ -1220,16 +1271,17 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
     if (chunk->dlt != KDLT_IEEE802_11)
         return 0;
 
-    membuf tags_membuf((char *) &(chunk->data[packinfo->header_offset]), 
-            (char *) &(chunk->data[chunk->length]));
-    std::istream istream_ietags(&tags_membuf);
-
     std::shared_ptr<dot11_ie> ietags(new dot11_ie());
 
-    try {
-        std::shared_ptr<kaitai::kstream> stream_ietags(new kaitai::kstream(&istream_ietags));
-        ietags->parse(stream_ietags);
-    } catch (const std::exception& e) {
+    // Borrow the packet contents rather than copying them into a stream;
+    // the IE tags in turn borrow their contents from the packet.  The tag
+    // splitter bounds-checks rather than throwing, so a truncated frame
+    // costs a comparison, not an unwind
+    std::shared_ptr<kaitai::kstream> stream_ietags(new kaitai::kstream(
+                (const char *) &(chunk->data[packinfo->header_offset]),
+                chunk->length - packinfo->header_offset));
+
+    if (ietags->parse(stream_ietags) < 0) {
         fprintf(stderr, "debug - IE tags corrupt\n");
         packinfo->corrupt = 1;
         return -1;
@@ -1245,18 +1297,20 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
     bool seen_mcsrates = false;
     unsigned int wmmtspec_responses = 0;
 
-    for (auto ie_tag : *(ietags->tags())) {
+    for (auto& ie_tag : *(ietags->tags())) {
         // IE 0 SSID
-        if (ie_tag->tag_num() == 0) {
+        if (ie_tag.tag_num() == 0) {
             if (seen_ssid) {
                 fprintf(stderr, "debug - multiple SSID ie tags?\n");
             }
 
             seen_ssid = true;
 
-            packinfo->ssid_len = ie_tag->tag_data().length();
+            kaitai::kbytes ssid_view = ie_tag.tag_data_view();
+
+            packinfo->ssid_len = ssid_view.length();
             packinfo->ssid_csum =
-                Adler32Checksum(ie_tag->tag_data().data(), ie_tag->tag_data().length());
+                Adler32Checksum(ssid_view.data(), ssid_view.length());
 
             if (packinfo->ssid_len == 0) {
                 packinfo->ssid_blank = true;
@@ -1264,10 +1318,19 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
             }
 
             if (packinfo->ssid_len <= DOT11_PROTO_SSID_LEN) {
-                if (ie_tag->tag_data().find_first_not_of('\0') == std::string::npos) {
+                bool ssid_blank = true;
+                for (char s : ssid_view) {
+                    if (s != '\0') {
+                        ssid_blank = false;
+                        break;
+                    }
+                }
+
+                if (ssid_blank) {
                     packinfo->ssid_blank = true;
                 } else {
-                    packinfo->ssid = MungeToPrintable(ie_tag->tag_data().data());
+                    packinfo->ssid =
+                        MungeToPrintable(ssid_view.data(), ssid_view.length(), 1);
                 }
             } else { 
                 _ALERT(alert_longssid_ref, in_pack, packinfo,
@@ -1284,8 +1347,8 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
 
         // IE 1 Basic Rates
         // IE 50 Extended Rates
-        if (ie_tag->tag_num() == 1 || ie_tag->tag_num() == 50) {
-            if (ie_tag->tag_num() == 1) {
+        if (ie_tag.tag_num() == 1 || ie_tag.tag_num() == 50) {
+            if (ie_tag.tag_num() == 1) {
                 if (seen_basicrates) {
                     fprintf(stderr, "debug - seen multiple basicrates?\n");
                 }
@@ -1293,7 +1356,7 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
                 seen_basicrates = true;
             }
 
-            if (ie_tag->tag_num() == 50) {
+            if (ie_tag.tag_num() == 50) {
                 if (seen_extendedrates) {
                     fprintf(stderr, "debug - seen multiple extendedrates?\n");
                 }
@@ -1301,7 +1364,11 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
                 seen_extendedrates = true;
             }
 
-            if (ie_tag->tag_data().find("\x75\xEB\x49") != std::string::npos) {
+            static const char msf_rate[] = "\x75\xEB\x49";
+            kaitai::kbytes rate_view = ie_tag.tag_data_view();
+
+            if (std::search(rate_view.begin(), rate_view.end(),
+                        msf_rate, msf_rate + 3) != rate_view.end()) {
                 _ALERT(alert_msfdlinkrate_ref, in_pack, packinfo,
                         "MSF-style poisoned rate field in beacon for network " +
                         packinfo->bssid_mac.Mac2String() + ", exploit attempt "
@@ -1312,7 +1379,7 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
             }
 
             std::vector<std::string> basicrates;
-            for (uint8_t r : ie_tag->tag_data()) {
+            for (uint8_t r : rate_view) {
                 std::string rate;
 
                 switch (r) {
@@ -1458,25 +1525,25 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
         }
 
         // IE 3 channel
-        if (ie_tag->tag_num() == 3) {
-            if (ie_tag->tag_data().length() != 1) {
+        if (ie_tag.tag_num() == 3) {
+            if (ie_tag.tag_data_view().length() != 1) {
                 fprintf(stderr, "debug - corrupt channel tag\n");
                 packinfo->corrupt = 1;
                 return -1;
             }
-                
-            packinfo->channel = UIntToString((uint8_t) (ie_tag->tag_data()[0]));
+
+            packinfo->channel = UIntToString((uint8_t) (ie_tag.tag_data_view()[0]));
             continue;
         }
 
         // IE 7 802.11d
-        if (ie_tag->tag_num() == 7) {
-            try {
-                dot11_ie_7_country dot11d;
-                // Allow fragmented 11d, take what we can parse
-                dot11d.set_allow_fragments(true);
-                dot11d.parse(ie_tag->tag_data_stream());
+        if (ie_tag.tag_num() == 7) {
+            dot11_ie_7_country dot11d;
+            // Allow fragmented 11d, take what we can parse
+            dot11d.set_allow_fragments(true);
 
+            // Corrupt dot11d isn't a fatal condition
+            if (dot11d.parse(ie_tag.tag_data_stream()) == 0) {
                 packinfo->dot11d_country = MungeToPrintable(dot11d.country_code());
 
                 for (auto c : *(dot11d.country_list())) {
@@ -1488,31 +1555,27 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
 
                     packinfo->dot11d_vec.push_back(ri);
                 }
-
-            } catch (const std::exception& e) {
-                // Corrupt dot11 isn't a fatal condition
-                // fprintf(stderr, "debug - corrupt dot11d: %s\n", e.what());
             }
 
             continue;
         }
 
         // IE 11 QBSS
-        if (ie_tag->tag_num() == 11) {
-            try {
-                std::shared_ptr<dot11_ie_11_qbss> qbss(new dot11_ie_11_qbss());
-                qbss->parse(ie_tag->tag_data_stream());
-                packinfo->qbss = qbss;
-            } catch (const std::exception& e) {
+        if (ie_tag.tag_num() == 11) {
+            std::shared_ptr<dot11_ie_11_qbss> qbss(new dot11_ie_11_qbss());
+
+            if (qbss->parse(ie_tag.tag_data_stream()) < 0) {
                 fprintf(stderr, "debug - corrupt QBSS\n");
                 packinfo->corrupt = 1;
                 return -1;
             }
 
+            packinfo->qbss = qbss;
+
             continue;
         }
 
-        if (ie_tag->tag_num() == 45) {
+        if (ie_tag.tag_num() == 45) {
             if (seen_mcsrates) {
                 fprintf(stderr, "debug - duplicate ie45 mcs rates\n");
             } 
@@ -1521,10 +1584,9 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
 
             std::vector<std::string> mcsrates;
 
-            try {
-                std::shared_ptr<dot11_ie_45_ht_cap> ht(new dot11_ie_45_ht_cap());
-                ht->parse(ie_tag->tag_data_stream());
+            std::shared_ptr<dot11_ie_45_ht_cap> ht(new dot11_ie_45_ht_cap());
 
+            if (ht->parse(ie_tag.tag_data_stream()) == 0) {
                 std::stringstream mcsstream;
 
                 // See if we support 40mhz channels and aren't 40mhz intolerant
@@ -1579,8 +1641,7 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
 
                     mcs_offt += 8;
                 }
-
-            } catch (const std::exception& e) {
+            } else {
                 fprintf(stderr, "debug -corrupt HT\n");
                 packinfo->corrupt = 1;
                 return -1;
@@ -1591,13 +1652,24 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
         }
 
         // IE 48, RSN
-        if (ie_tag->tag_num() == 48) {
+        if (ie_tag.tag_num() == 48) {
             bool rsn_invalid = false;
 
-            try {
-                std::shared_ptr<dot11_ie_48_rsn> rsn(new dot11_ie_48_rsn());
-                rsn->parse(ie_tag->tag_data_stream());
+            std::shared_ptr<dot11_ie_48_rsn> rsn =
+                rsn_ie_cache.fetch(ie_tag.tag_data_view());
+
+            int rsn_res = 0;
+
+            if (rsn == NULL) {
+                rsn.reset(new dot11_ie_48_rsn());
+                rsn_res = rsn->parse(ie_tag.tag_data_stream());
+
+                // Only cache RSN records which parsed cleanly
+                if (rsn_res == 0)
+                    rsn_ie_cache.insert(ie_tag.tag_data_view(), rsn);
+            }
 
+            if (rsn_res == 0) {
                 // TODO - don't aggregate these in the future
 
                 // Merge the group cipher
@@ -1619,8 +1691,7 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
                 packinfo->cryptset |= crypt_version_wpa2;
 
                 common->basic_crypt_set |= KIS_DEVICE_BASICCRYPT_ENCRYPTED;
-
-            } catch (const std::exception& e) {
+            } else {
                 rsn_invalid = true;
                 packinfo->corrupt = 1;
             }
@@ -1630,12 +1701,14 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
             // https://pleasestopnamingvulnerabilities.com/
             // CVE-2017-9714
             if (rsn_invalid) {
-                try {
-                    std::shared_ptr<dot11_ie_48_rsn_partial> rsn(new dot11_ie_48_rsn_partial());
-                    ie_tag->tag_data_stream()->seek(0);
-                    rsn->parse(ie_tag->tag_data_stream());
-
-                    if (rsn->pairwise_count() > 1024) {
+                std::shared_ptr<dot11_ie_48_rsn_partial> partial_rsn(new dot11_ie_48_rsn_partial());
+                ie_tag.tag_data_stream()->seek(0);
+
+                // A failed partial parse tells us nothing new; we already
+                // know the record is bad, we're just looking for the
+                // specific malformed pairwise count
+                if (partial_rsn->parse(ie_tag.tag_data_stream()) == 0) {
+                    if (partial_rsn->pairwise_count() > 1024) {
                         alertracker->RaiseAlert(alert_atheros_rsnloop_ref, 
                                 in_pack,
                                 packinfo->bssid_mac, packinfo->source_mac, 
@@ -1647,64 +1720,60 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
                                 "CVE-2017-9714 and "
                                 "https://pleasestopnamingvulnerabilities.com/");
                     }
-
-                } catch (const std::exception& e) {
-                    // Do nothing with the secondary error; we already know
-                    // something is wrong we're just trying to extract the
-                    // better errors
                 }
             }
         }
 
         // IE 54 Mobility
-        if (ie_tag->tag_num() == 54) {
-            try {
-                std::shared_ptr<dot11_ie_54_mobility> mobility(new dot11_ie_54_mobility());
-                mobility->parse(ie_tag->tag_data_stream());
-                packinfo->dot11r_mobility = mobility;
-            } catch (const std::exception& e) {
+        if (ie_tag.tag_num() == 54) {
+            std::shared_ptr<dot11_ie_54_mobility> mobility(new dot11_ie_54_mobility());
+
+            if (mobility->parse(ie_tag.tag_data_stream()) < 0) {
                 packinfo->corrupt = 1;
                 return -1;
             }
+
+            packinfo->dot11r_mobility = mobility;
             continue;
         }
 
         // IE 61 HT
-        if (ie_tag->tag_num() == 61) {
-            try {
-                std::shared_ptr<dot11_ie_61_ht_op> ht(new dot11_ie_61_ht_op());
-                ht->parse(ie_tag->tag_data_stream());
-                packinfo->dot11ht = ht;
-            } catch (const std::exception& e) {
+        if (ie_tag.tag_num() == 61) {
+            std::shared_ptr<dot11_ie_61_ht_op> ht(new dot11_ie_61_ht_op());
+
+            if (ht->parse(ie_tag.tag_data_stream()) < 0) {
                 fprintf(stderr, "debug - unparseable HT\n");
                 // Don't consider unparseable HT a corrupt packet (for now)
                 continue;
             }
 
+            packinfo->dot11ht = ht;
+
             continue;
         }
 
         // IE 133 CISCO CCX
-        if (ie_tag->tag_num() == 133) {
-            try {
-                std::shared_ptr<dot11_ie_133_cisco_ccx> ccx1(new dot11_ie_133_cisco_ccx());
-                ccx1->parse(ie_tag->tag_data_stream());
-                packinfo->beacon_info = MungeToPrintable(ccx1->ap_name());
-            } catch (const std::exception& e) {
-                fprintf(stderr, "debug - ccx error %s\n", e.what());
+        if (ie_tag.tag_num() == 133) {
+            std::shared_ptr<dot11_ie_133_cisco_ccx> ccx1(new dot11_ie_133_cisco_ccx());
+
+            if (ccx1->parse(ie_tag.tag_data_stream()) < 0) {
+                fprintf(stderr, "debug - ccx error\n");
                 continue;
             }
 
+            packinfo->beacon_info = MungeToPrintable(ccx1->ap_name());
+
             continue;
         }
 
         // IE 191 VHT Capabilities TODO compbine with VHT OP to derive actual usable
         // rate
-        if (ie_tag->tag_num() == 191) {
-            try {
-                std::shared_ptr<dot11_ie_191_vht_cap> vht(new dot11_ie_191_vht_cap());
-                vht->parse(ie_tag->tag_data_stream());
+        if (ie_tag.tag_num() == 191) {
+            std::shared_ptr<dot11_ie_191_vht_cap> vht(new dot11_ie_191_vht_cap());
 
+            // Don't consider this a corrupt packet just because we didn't
+            // parse it
+            if (vht->parse(ie_tag.tag_data_stream()) == 0) {
                 bool gi80 = vht->vht_cap_80mhz_shortgi();
                 bool gi160 = vht->vht_cap_160mhz_shortgi();
                 bool supp160 = vht->vht_cap_160mhz();
@@ -1768,40 +1837,36 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
 
                 if (packinfo->maxrate < speed)
                     packinfo->maxrate = speed;
-
-
-            } catch (const std::exception& e) {
-                fprintf(stderr, "debug - vht 191 error %s\n", e.what());
-                // Don't consider this a corrupt packet just because we didn't parse it
+            } else {
+                fprintf(stderr, "debug - vht 191 error\n");
             }
         }
 
 
         // IE 192 VHT Operation
-        if (ie_tag->tag_num() == 192) {
-            try {
-                std::shared_ptr<dot11_ie_192_vht_op> vht(new dot11_ie_192_vht_op());
-                vht->parse(ie_tag->tag_data_stream());
-                packinfo->dot11vht = vht;
+        if (ie_tag.tag_num() == 192) {
+            std::shared_ptr<dot11_ie_192_vht_op> vht(new dot11_ie_192_vht_op());
 
-            } catch (const std::exception& e) {
-                fprintf(stderr, "debug - vht 192 error %s\n", e.what());
+            if (vht->parse(ie_tag.tag_data_stream()) < 0) {
+                fprintf(stderr, "debug - vht 192 error\n");
                 // Don't consider this a corrupt packet just because we didn't parse it
+                continue;
             }
 
+            packinfo->dot11vht = vht;
+
             continue;
         }
 
-        if (ie_tag->tag_num() == 221) {
-            try {
-                std::shared_ptr<dot11_ie_221_vendor> vendor(new dot11_ie_221_vendor());
-                vendor->parse(ie_tag->tag_data_stream());
+        if (ie_tag.tag_num() == 221) {
+            std::shared_ptr<dot11_ie_221_vendor> vendor(new dot11_ie_221_vendor());
 
+            if (vendor->parse(ie_tag.tag_data_stream()) == 0) {
                 // Match mis-sized WMM
                 if (packinfo->subtype == packet_sub_beacon &&
                         vendor->vendor_oui_int() == 0x0050f2 &&
                         vendor->vendor_oui_type() == 2 &&
-                        ie_tag->tag_data().length() > 24) {
+                        ie_tag.tag_data_view().length() > 24) {
 
                     std::string al = "IEEE80211 Access Point BSSID " + 
                         packinfo->bssid_mac.Mac2String() + " sent association "
@@ -1822,7 +1887,12 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
                         vendor->vendor_oui_int() == 0x0050f2 &&
                         vendor->vendor_oui_type() == 2) {
                     dot11_ie_221_ms_wmm wmm;
-                    wmm.parse(vendor->vendor_tag_stream());
+
+                    if (wmm.parse(vendor->vendor_tag_stream()) < 0) {
+                        fprintf(stderr, "debug - 221 ie tag corrupt\n");
+                        packinfo->corrupt = 1;
+                        return -1;
+                    }
 
                     if (wmm.wme_subtype() == 0x02) {
                         wmmtspec_responses++;
@@ -1847,7 +1917,12 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
                 // Look for DJI DroneID OUIs
                 if (vendor->vendor_oui_int() == dot11_ie_221_dji_droneid::vendor_oui()) {
                     std::shared_ptr<dot11_ie_221_dji_droneid> droneid(new dot11_ie_221_dji_droneid());
-                    droneid->parse(vendor->vendor_tag_stream());
+
+                    if (droneid->parse(vendor->vendor_tag_stream()) < 0) {
+                        fprintf(stderr, "debug - 221 ie tag corrupt\n");
+                        packinfo->corrupt = 1;
+                        return -1;
+                    }
 
                     packinfo->droneid = droneid;
                 }
@@ -1855,8 +1930,20 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
                 // Look for MS/WFA WPA
                 if (vendor->vendor_oui_int() == dot11_ie_221_wfa_wpa::ms_wps_oui() && 
                         vendor->vendor_oui_type() == dot11_ie_221_wfa_wpa::wfa_wpa_subtype()) {
-                    std::shared_ptr<dot11_ie_221_wfa_wpa> wpa(new dot11_ie_221_wfa_wpa());
-                    wpa->parse(vendor->vendor_tag_stream());
+                    std::shared_ptr<dot11_ie_221_wfa_wpa> wpa =
+                        wpa_ie_cache.fetch(vendor->vendor_tag_view());
+
+                    if (wpa == NULL) {
+                        wpa.reset(new dot11_ie_221_wfa_wpa());
+
+                        if (wpa->parse(vendor->vendor_tag_stream()) < 0) {
+                            fprintf(stderr, "debug - 221 ie tag corrupt\n");
+                            packinfo->corrupt = 1;
+                            return -1;
+                        }
+
+                        wpa_ie_cache.insert(vendor->vendor_tag_view(), wpa);
+                    }
 
                     // Merge the group cipher
                     packinfo->cryptset |= 
@@ -1885,8 +1972,20 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
                 // Look for WPS MS
                 if (vendor->vendor_oui_int() == dot11_ie_221_ms_wps::ms_wps_oui() && 
                         vendor->vendor_oui_type() == dot11_ie_221_ms_wps::ms_wps_subtype()) {
-                    std::unique_ptr<dot11_ie_221_ms_wps> wps(new dot11_ie_221_ms_wps());
-                    wps->parse(vendor->vendor_tag_stream());
+                    std::shared_ptr<dot11_ie_221_ms_wps> wps =
+                        wps_ie_cache.fetch(vendor->vendor_tag_view());
+
+                    if (wps == NULL) {
+                        wps.reset(new dot11_ie_221_ms_wps());
+
+                        if (wps->parse(vendor->vendor_tag_stream()) < 0) {
+                            fprintf(stderr, "debug - 221 ie tag corrupt\n");
+                            packinfo->corrupt = 1;
+                            return -1;
+                        }
+
+                        wps_ie_cache.insert(vendor->vendor_tag_view(), wps);
+                    }
 
                     for (auto wpselem : *(wps->wps_elements())) {
                         auto state = wpselem->sub_element_state();
@@ -1932,8 +2031,8 @@ int Kis_80211_Phy::PacketDot11IEdissector(kis_packet *in_pack, dot11_packinfo *p
                         }
                     }
                 }
-            } catch (const std::exception &e) {
-                fprintf(stderr, "debug - 221 ie tag corrupt %s\n", e.what());
+            } else {
+                fprintf(stderr, "debug - 221 ie tag corrupt\n");
                 packinfo->corrupt = 1;
                 return -1;
             }
@@ -2289,15 +2388,11 @@ int Kis_80211_Phy::PacketDot11WPSM3(kis_packet *in_pack) {
 
     pos += sizeof(eapol_llc);
 
-    // Make an in-memory zero-copy stream instance to the packet contents after
-    // the SNAP/LLC header
-    membuf eapol_membuf((char *) &(chunk->data[pos]), 
-            (char *) &(chunk->data[chunk->length]));
-    std::istream eapol_stream(&eapol_membuf);
-
     try {
-        // Make a kaitai parser and parse with our wpaeap handler
-        std::shared_ptr<kaitai::kstream> ks(new kaitai::kstream(&eapol_stream));
+        // Make a kaitai parser borrowing the packet contents after the
+        // SNAP/LLC header and parse with our wpaeap handler
+        std::shared_ptr<kaitai::kstream> ks(new kaitai::kstream(
+                    (const char *) &(chunk->data[pos]), chunk->length - pos));
         dot11_wpa_eap eap;
         eap.parse(ks);
 
@@ -2407,15 +2502,11 @@ std::shared_ptr<dot11_tracked_eapol>
 
     pos += sizeof(eapol_llc);
 
-    // Make an in-memory zero-copy stream instance to the packet contents after
-    // the SNAP/LLC header
-    membuf eapol_membuf((char *) &(chunk->data[pos]), 
-            (char *) &(chunk->data[chunk->length]));
-    std::istream eapol_stream(&eapol_membuf);
-
     try {
-        // Make a kaitai parser and parse with our wpaeap handler
-        std::shared_ptr<kaitai::kstream> ks(new kaitai::kstream(&eapol_stream));
+        // Make a kaitai parser borrowing the packet contents after the
+        // SNAP/LLC header and parse with our wpaeap handler
+        std::shared_ptr<kaitai::kstream> ks(new kaitai::kstream(
+                    (const char *) &(chunk->data[pos]), chunk->length - pos));
         dot11_wpa_eap eap;
         eap.parse(ks);
 
@@ -139,22 +139,17 @@ int Phy_80211_Httpd_Pcap::Httpd_CreateStreamResponse(Kis_Net_Httpd *httpd,
     Kis_Net_Httpd_Buffer_Stream_Aux *saux = 
         (Kis_Net_Httpd_Buffer_Stream_Aux *) connection->custom_extension;
       
-    // Filter based on the device key
+    // Filter on the BSSID.  The dissector has already cached its output on
+    // the packet by the time the logging chain runs, so the cheapest check
+    // available is an indexed component fetch and a mac compare - no need
+    // to re-derive the BSSID from the raw header offsets
     Pcap_Stream_Ringbuf *psrb = new Pcap_Stream_Ringbuf(http_globalreg,
-            saux->get_rbhandler(), 
+            saux->get_rbhandler(),
             [dmac, pack_comp_dot11](kis_packet *packet) -> bool {
                 dot11_packinfo *dot11info =
                     (dot11_packinfo *) packet->fetch(pack_comp_dot11);
 
-                if (dot11info == NULL) {
-                    return false;
-                }
-
-                if (dot11info->bssid_mac == dmac) {
-                    return true;
-                }
-
-                return false;
+                return dot11info != NULL && dot11info->bssid_mac == dmac;
             }, NULL);
 
     saux->set_aux(psrb, 
@@ -138,6 +138,21 @@ int Kis_Bluetooth_Phy::PacketTrackerBluetooth(CHAINCALL_PARMS) {
         basedev->add_map(btdev);
     }
 
+    // Checksum the content fields of the record; scan reports for a device
+    // sitting nearby differ only in signal, so skip re-applying the fields
+    // when nothing else has changed
+    std::stringstream csstream;
+    csstream << btpi->name << " " << btpi->type << " " << btpi->txpower;
+    for (auto u : btpi->service_uuid_vec)
+        csstream << " " << u.UUID2String();
+
+    uint32_t record_csum = Adler32Checksum(csstream.str());
+
+    if (btdev->get_last_record_csum() == record_csum)
+        return 0;
+
+    btdev->set_last_record_csum(record_csum);
+
     basedev->bitset_basic_type_set(KIS_DEVICE_BASICTYPE_PEER);
 
     if (btpi->type == 0)
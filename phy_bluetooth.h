@@ -62,14 +62,16 @@ class bluetooth_tracked_device : public tracker_component {
 public:
     bluetooth_tracked_device(GlobalRegistry *in_globalreg, int in_id) :
         tracker_component(in_globalreg, in_id) {
+        last_record_csum = 0;
         register_fields();
         reserve_fields(NULL);
     }
 
-    bluetooth_tracked_device(GlobalRegistry *in_globalreg, int in_id, 
-            SharedTrackerElement e) : 
+    bluetooth_tracked_device(GlobalRegistry *in_globalreg, int in_id,
+            SharedTrackerElement e) :
         tracker_component(in_globalreg, in_id) {
 
+        last_record_csum = 0;
         register_fields();
         reserve_fields(e);
     }
@@ -81,6 +83,9 @@ public:
     __ProxyTrackable(service_uuid_vec, TrackerElement, service_uuid_vec);
     __Proxy(txpower, int16_t, int16_t, int16_t, txpower);
 
+    uint32_t get_last_record_csum() { return last_record_csum; }
+    void set_last_record_csum(uint32_t csum) { last_record_csum = csum; }
+
 protected:
     virtual void register_fields() {
         RegisterField("bluetooth.device.service_uuid_vec", TrackerVector,
@@ -96,6 +101,10 @@ protected:
 
     SharedTrackerElement service_uuid_vec;
     SharedTrackerElement txpower;
+
+    // Un-exposed checksum of the last scan record content, used to skip
+    // re-applying reports which only changed in signal
+    uint32_t last_record_csum;
 };
 
 class Kis_Bluetooth_Phy : public Kis_Phy_Handler {
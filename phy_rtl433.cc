@@ -21,7 +21,7 @@
 
 #include "phy_rtl433.h"
 #include "devicetracker.h"
-#include "kismet_json.h"
+#include "flat_json.h"
 #include "endian_magic.h"
 #include "macaddr.h"
 #include "kis_httpd_registry.h"
@@ -78,7 +78,7 @@ double Kis_RTL433_Phy::f_to_c(double f) {
     return (f - 32) / (double) 1.8f;
 }
 
-mac_addr Kis_RTL433_Phy::json_to_mac(Json::Value json) {
+mac_addr Kis_RTL433_Phy::json_to_mac(const FlatJsonReport& json) {
     // Derive a mac addr from the model and device id data
     //
     // We turn the model string into 4 bytes using the adler32 checksum,
@@ -90,32 +90,19 @@ mac_addr Kis_RTL433_Phy::json_to_mac(Json::Value json) {
     uint16_t *model = (uint16_t *) bytes;
     uint32_t *checksum = (uint32_t *) (bytes + 2);
 
-    std::string smodel = "unk";
-
-    if (json.isMember("model")) {
-        Json::Value m = json["model"];
-        if (m.isString()) {
-            smodel = m.asString();
-        }
-    }
+    std::string smodel = json.getString("model", "unk");
 
     *checksum = Adler32Checksum(smodel.c_str(), smodel.length());
 
     bool set_model = false;
-    if (json.isMember("id")) {
-        Json::Value i = json["id"];
-        if (i.isNumeric()) {
-            *model = kis_hton16((uint16_t) i.asUInt());
-            set_model = true;
-        }
+    if (json.isNumber("id")) {
+        *model = kis_hton16((uint16_t) json.getNumber("id", 0));
+        set_model = true;
     }
 
-    if (!set_model && json.isMember("device")) {
-        Json::Value d = json["device"];
-        if (d.isNumeric()) {
-            *model = kis_hton16((uint16_t) d.asUInt());
-            set_model = true;
-        }
+    if (!set_model && json.isNumber("device")) {
+        *model = kis_hton16((uint16_t) json.getNumber("device", 0));
+        set_model = true;
     }
 
     if (!set_model) {
@@ -128,7 +115,7 @@ mac_addr Kis_RTL433_Phy::json_to_mac(Json::Value json) {
     return mac_addr(bytes, 6);
 }
 
-bool Kis_RTL433_Phy::json_to_rtl(Json::Value json) {
+bool Kis_RTL433_Phy::json_to_rtl(const FlatJsonReport& json) {
     std::string err;
     std::string v;
 
@@ -139,6 +126,12 @@ bool Kis_RTL433_Phy::json_to_rtl(Json::Value json) {
         return false;
     }
 
+    // Every decoded report synthesizes a device; hold new emitters in the
+    // probation table until they've been sighted enough to earn a full
+    // device record
+    if (!AdmitReportSource(rtlmac, globalreg->timestamp.tv_sec))
+        return true;
+
     // To interact with devicetracker we (currently) need to turn this into
     // something that looks vaguely like a packet
     kis_packet *pack = new kis_packet(globalreg);
@@ -153,13 +146,10 @@ bool Kis_RTL433_Phy::json_to_rtl(Json::Value json) {
     common->datasize = 0;
 
     // If this json record has a channel
-    if (json.isMember("channel")) {
-        Json::Value c = json["channel"];
-        if (c.isNumeric()) {
-            common->channel = IntToString(c.asInt());
-        } else if (c.isString()) {
-            common->channel = MungeToPrintable(c.asString());
-        }
+    if (json.isNumber("channel")) {
+        common->channel = IntToString((int) json.getNumber("channel", 0));
+    } else if (json.isString("channel")) {
+        common->channel = MungeToPrintable(json.getString("channel", ""));
     }
 
     common->freq_khz = 433920;
@@ -176,11 +166,7 @@ bool Kis_RTL433_Phy::json_to_rtl(Json::Value json) {
     // Get rid of our pseudopacket
     delete(pack);
 
-    std::string dn = "Sensor";
-
-    if (json.isMember("model")) {
-        dn = MungeToPrintable(json["model"].asString());
-    }
+    std::string dn = MungeToPrintable(json.getString("model", "Sensor"));
 
     basedev->set_manuf("RTL433");
 
@@ -208,28 +194,24 @@ bool Kis_RTL433_Phy::json_to_rtl(Json::Value json) {
         commondev->set_model(dn);
 
         bool set_id = false;
-        if (json.isMember("id")) {
-            Json::Value id_j = json["id"];
-            if (id_j.isNumeric()) {
-                std::stringstream ss;
-                ss << id_j.asUInt64();
-                commondev->set_rtlid(ss.str());
-                set_id = true;
-            } else if (id_j.isString()) {
-                commondev->set_rtlid(id_j.asString());
-                set_id = true;
-            }
+        if (json.isNumber("id")) {
+            std::stringstream ss;
+            ss << (uint64_t) json.getNumber("id", 0);
+            commondev->set_rtlid(ss.str());
+            set_id = true;
+        } else if (json.isString("id")) {
+            commondev->set_rtlid(json.getString("id", ""));
+            set_id = true;
         }
 
-        if (!set_id && json.isMember("device")) {
-            Json::Value device_j = json["device"];
-            if (device_j.isNumeric()) {
+        if (!set_id) {
+            if (json.isNumber("device")) {
                 std::stringstream ss;
-                ss << device_j.asUInt64();
+                ss << (uint64_t) json.getNumber("device", 0);
                 commondev->set_rtlid(ss.str());
                 set_id = true;
-            } else if (device_j.isString()) {
-                commondev->set_rtlid(device_j.asString());
+            } else if (json.isString("device")) {
+                commondev->set_rtlid(json.getString("device", ""));
                 set_id = true;
             }
         }
@@ -241,28 +223,16 @@ bool Kis_RTL433_Phy::json_to_rtl(Json::Value json) {
         commondev->set_rtlchannel("0");
     }
 
-    if (json.isMember("channel")) {
-        auto channel_j = json["channel"];
-
-        if (channel_j.isNumeric())
-            commondev->set_rtlchannel(IntToString(channel_j.asInt()));
-        else if (channel_j.isString())
-            commondev->set_rtlchannel(MungeToPrintable(channel_j.asString()));
-    }
-
-    if (json.isMember("battery")) {
-        auto battery_j = json["battery"];
+    if (json.isNumber("channel"))
+        commondev->set_rtlchannel(IntToString((int) json.getNumber("channel", 0)));
+    else if (json.isString("channel"))
+        commondev->set_rtlchannel(MungeToPrintable(json.getString("channel", "")));
 
-        if (battery_j.isString())
-            commondev->set_battery(MungeToPrintable(battery_j.asString()));
-    }
+    if (json.isString("battery"))
+        commondev->set_battery(MungeToPrintable(json.getString("battery", "")));
 
-    auto humidity_j = json["humidity"];
-    auto moisture_j = json["moisture"];
-    auto temp_f_j = json["temperature_F"];
-    auto temp_c_j = json["temperature_C"];
-
-    if (!humidity_j.isNull() || !moisture_j.isNull() || !temp_f_j.isNull() || !temp_c_j.isNull()) {
+    if (json.hasField("humidity") || json.hasField("moisture") ||
+            json.hasField("temperature_F") || json.hasField("temperature_C")) {
         std::shared_ptr<rtl433_tracked_thermometer> thermdev = 
             std::static_pointer_cast<rtl433_tracked_thermometer>(rtlholder->get_map_value(rtl433_thermometer_id));
 
@@ -272,35 +242,27 @@ bool Kis_RTL433_Phy::json_to_rtl(Json::Value json) {
             rtlholder->add_map(thermdev);
         }
 
-        if (humidity_j.isNumeric()) {
-            thermdev->set_humidity(humidity_j.asInt());
+        if (json.isNumber("humidity")) {
+            thermdev->set_humidity((int) json.getNumber("humidity", 0));
         }
 
-        if (moisture_j.isNumeric()) {
-            thermdev->set_humidity(moisture_j.asInt());
+        if (json.isNumber("moisture")) {
+            thermdev->set_humidity((int) json.getNumber("moisture", 0));
         }
 
-        if (temp_f_j.isNumeric()) {
-            thermdev->set_temperature(f_to_c(temp_f_j.asInt()));
+        if (json.isNumber("temperature_F")) {
+            thermdev->set_temperature(f_to_c((int) json.getNumber("temperature_F", 0)));
         }
 
-        if (temp_c_j.isNumeric()) {
-            thermdev->set_temperature(temp_c_j.asInt());
+        if (json.isNumber("temperature_C")) {
+            thermdev->set_temperature((int) json.getNumber("temperature_C", 0));
         }
     }
 
-    auto direction_j = json["direction_deg"];
-    auto windstrength_j = json["windstrength"];
-    auto winddirection_j = json["winddirection"];
-    auto windspeed_j = json["speed"];
-    auto gust_j = json["gust"];
-    auto rain_j = json["rain"];
-    auto uv_index_j = json["uv_index"];
-    auto lux_j = json["lux"];
-
-    if (!direction_j.isNull() || !windstrength_j.isNull() || !winddirection_j.isNull() ||
-            !windspeed_j.isNull() || !gust_j.isNull() || !rain_j.isNull() || !uv_index_j.isNull() ||
-            !lux_j.isNull()) {
+    if (json.hasField("direction_deg") || json.hasField("windstrength") ||
+            json.hasField("winddirection") || json.hasField("speed") ||
+            json.hasField("gust") || json.hasField("rain") ||
+            json.hasField("uv_index") || json.hasField("lux")) {
 
         std::shared_ptr<rtl433_tracked_weatherstation> weatherdev = 
             std::static_pointer_cast<rtl433_tracked_weatherstation>(rtlholder->get_map_value(rtl433_weatherstation_id));
@@ -311,45 +273,52 @@ bool Kis_RTL433_Phy::json_to_rtl(Json::Value json) {
             rtlholder->add_map(weatherdev);
         }
 
-        if (direction_j.isNumeric()) {
-            weatherdev->set_wind_dir(direction_j.asInt());
-            weatherdev->get_wind_dir_rrd()->add_sample(direction_j.asInt(), time(0));
+        if (json.isNumber("direction_deg")) {
+            int dir = (int) json.getNumber("direction_deg", 0);
+            weatherdev->set_wind_dir(dir);
+            weatherdev->get_wind_dir_rrd()->add_sample(dir, time(0));
         }
 
-        if (winddirection_j.isNumeric()) {
-            weatherdev->set_wind_dir(winddirection_j.asInt());
-            weatherdev->get_wind_dir_rrd()->add_sample(winddirection_j.asInt(), time(0));
+        if (json.isNumber("winddirection")) {
+            int dir = (int) json.getNumber("winddirection", 0);
+            weatherdev->set_wind_dir(dir);
+            weatherdev->get_wind_dir_rrd()->add_sample(dir, time(0));
         }
 
-        if (windspeed_j.isNumeric()) {
-            weatherdev->set_wind_speed((int32_t) windspeed_j.asInt());
-            weatherdev->get_wind_speed_rrd()->add_sample((int64_t) windspeed_j.asInt(), time(0));
+        if (json.isNumber("speed")) {
+            int speed = (int) json.getNumber("speed", 0);
+            weatherdev->set_wind_speed((int32_t) speed);
+            weatherdev->get_wind_speed_rrd()->add_sample((int64_t) speed, time(0));
         }
 
-        if (windstrength_j.isNumeric()) {
-            weatherdev->set_wind_speed((int32_t) windstrength_j.asInt());
-            weatherdev->get_wind_speed_rrd()->add_sample((int64_t) windstrength_j.asInt(),
-                    time(0));
+        if (json.isNumber("windstrength")) {
+            int speed = (int) json.getNumber("windstrength", 0);
+            weatherdev->set_wind_speed((int32_t) speed);
+            weatherdev->get_wind_speed_rrd()->add_sample((int64_t) speed, time(0));
         }
 
-        if (gust_j.isNumeric()) {
-            weatherdev->set_wind_gust((int32_t) gust_j.asInt());
-            weatherdev->get_wind_gust_rrd()->add_sample((int64_t) gust_j.asInt(), time(0));
+        if (json.isNumber("gust")) {
+            int gust = (int) json.getNumber("gust", 0);
+            weatherdev->set_wind_gust((int32_t) gust);
+            weatherdev->get_wind_gust_rrd()->add_sample((int64_t) gust, time(0));
         }
 
-        if (rain_j.isNumeric()) {
-            weatherdev->set_rain((int32_t) rain_j.asInt());
-            weatherdev->get_rain_rrd()->add_sample((int64_t) rain_j.asInt(), time(0));
+        if (json.isNumber("rain")) {
+            int rain = (int) json.getNumber("rain", 0);
+            weatherdev->set_rain((int32_t) rain);
+            weatherdev->get_rain_rrd()->add_sample((int64_t) rain, time(0));
         }
 
-        if (uv_index_j.isNumeric()) {
-            weatherdev->set_uv_index((int32_t) uv_index_j.asInt());
-            weatherdev->get_uv_index_rrd()->add_sample((int64_t) uv_index_j.asInt(), time(0));
+        if (json.isNumber("uv_index")) {
+            int uv = (int) json.getNumber("uv_index", 0);
+            weatherdev->set_uv_index((int32_t) uv);
+            weatherdev->get_uv_index_rrd()->add_sample((int64_t) uv, time(0));
         }
 
-        if (lux_j.isNumeric()) {
-            weatherdev->set_lux((int32_t) lux_j.asInt());
-            weatherdev->get_lux_rrd()->add_sample((int64_t) lux_j.asInt(), time(0));
+        if (json.isNumber("lux")) {
+            int lux = (int) json.getNumber("lux", 0);
+            weatherdev->set_lux((int32_t) lux);
+            weatherdev->get_lux_rrd()->add_sample((int64_t) lux, time(0));
         }
 
     }
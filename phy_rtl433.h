@@ -26,18 +26,18 @@
 #include "trackedelement.h"
 #include "devicetracker_component.h"
 #include "phyhandler.h"
-#include "kismet_json.h"
+#include "flat_json.h"
 
 class packet_info_rtl433 : public packet_component {
 public:
-    packet_info_rtl433(Json::Value in_json) {
+    packet_info_rtl433(const FlatJsonReport& in_json) {
         json = in_json;
         self_destruct = 1;
     }
 
     virtual ~packet_info_rtl433() { }
 
-    Json::Value json;
+    FlatJsonReport json;
 };
 
 /* Similar to the extreme aggregator, a temperature aggregator which ignores empty
@@ -70,18 +70,14 @@ public:
         return b;
     }
 
-    // Simple average
-    static int64_t combine_vector(SharedTrackerElement e) {
-        TrackerElementVector v(e);
-
+    // Simple average of the slots which aren't empty
+    static int64_t combine_vector(const int64_t *vals, size_t in_sz) {
         int64_t avg = 0;
         int64_t avg_c = 0;
 
-        for (TrackerElementVector::iterator i = v.begin(); i != v.end(); ++i)  {
-            int64_t v = GetTrackerValue<int64_t>(*i);
-
-            if (v != default_val()) {
-                avg += GetTrackerValue<int64_t>(*i);
+        for (size_t x = 0; x < in_sz; x++) {
+            if (vals[x] != default_val()) {
+                avg += vals[x];
                 avg_c++;
             }
         }
@@ -482,11 +478,11 @@ protected:
     int pack_comp_common, pack_comp_rtl433;
 
     // Convert a JSON record to a RTL-based device key
-    mac_addr json_to_mac(Json::Value in_json);
+    mac_addr json_to_mac(const FlatJsonReport& in_json);
 
     // convert to a device record & push into device tracker, return false
     // if we can't do anything with it
-    bool json_to_rtl(Json::Value in_json);
+    bool json_to_rtl(const FlatJsonReport& in_json);
 
     double f_to_c(double f);
 
@@ -263,28 +263,23 @@ int Kis_UAV_Phy::CommonClassifier(CHAINCALL_PARMS) {
                 (dot11info->subtype == packet_sub_beacon ||
                  dot11info->subtype == packet_sub_probe_resp)) {
 
-            TrackerElementVector matchv(uavphy->manuf_match_vec);
-            for (auto mi : matchv) {
-                std::shared_ptr<uav_manuf_match> m = 
-                    std::static_pointer_cast<uav_manuf_match>(mi);
-
-                if (m->match_record(dot11info->bssid_mac, dot11info->ssid)) {
-                    std::shared_ptr<uav_tracked_device> uavdev = 
-                        std::static_pointer_cast<uav_tracked_device>(basedev->get_map_value(uavphy->uav_device_id));
-
-                    if (uavdev == NULL) {
-                        uavdev.reset(new uav_tracked_device(globalreg, uavphy->uav_device_id));
-                        basedev->add_map(uavdev);
-                        uavdev->set_uav_manufacturer(m->get_uav_manuf_name());
-                        uavdev->set_uav_model(m->get_uav_manuf_model());
-                    }
-
-                    uavdev->set_tracker_matched_type(m);
+            std::shared_ptr<uav_manuf_match> m =
+                uavphy->find_manuf_match(dot11info->bssid_mac, dot11info->ssid);
+
+            if (m != NULL) {
+                std::shared_ptr<uav_tracked_device> uavdev =
+                    std::static_pointer_cast<uav_tracked_device>(basedev->get_map_value(uavphy->uav_device_id));
+
+                if (uavdev == NULL) {
+                    uavdev.reset(new uav_tracked_device(globalreg, uavphy->uav_device_id));
+                    basedev->add_map(uavdev);
+                    uavdev->set_uav_manufacturer(m->get_uav_manuf_name());
+                    uavdev->set_uav_model(m->get_uav_manuf_model());
+                }
 
-                    uavdev->set_uav_match_type("UAV Fingerprint");
+                uavdev->set_tracker_matched_type(m);
 
-                    break;
-                }
+                uavdev->set_uav_match_type("UAV Fingerprint");
             }
         }
     }
@@ -406,6 +401,61 @@ bool Kis_UAV_Phy::parse_manuf_definition(std::string in_def) {
 
     matches.push_back(manufmatch);
 
+    rebuild_manuf_index();
+
     return true;
 }
 
+void Kis_UAV_Phy::rebuild_manuf_index() {
+    local_locker lock(&uav_mutex);
+
+    mac_match_index.clear();
+    mac_match_masks.clear();
+    ssid_match_vec.clear();
+
+    TrackerElementVector matches(manuf_match_vec);
+
+    for (auto i : matches) {
+        std::shared_ptr<uav_manuf_match> mi =
+            std::static_pointer_cast<uav_manuf_match>(i);
+
+        mac_addr m = mi->get_uav_manuf_mac();
+
+        if (m.longmac == 0) {
+            ssid_match_vec.push_back(mi);
+            continue;
+        }
+
+        // Bucket on the masked mac; track each distinct mask so a lookup
+        // probes once per mask, not once per matcher
+        mac_match_index.emplace(m.longmac & m.longmask, mi);
+
+        if (std::find(mac_match_masks.begin(), mac_match_masks.end(),
+                    m.longmask) == mac_match_masks.end())
+            mac_match_masks.push_back(m.longmask);
+    }
+}
+
+std::shared_ptr<uav_manuf_match> Kis_UAV_Phy::find_manuf_match(mac_addr in_mac,
+        std::string in_ssid) {
+    local_locker lock(&uav_mutex);
+
+    for (auto mask : mac_match_masks) {
+        auto range = mac_match_index.equal_range(in_mac.longmac & mask);
+
+        for (auto i = range.first; i != range.second; ++i) {
+            // match_record re-applies the full masked compare and the
+            // partial/regex semantics
+            if (i->second->match_record(in_mac, in_ssid))
+                return i->second;
+        }
+    }
+
+    for (auto mi : ssid_match_vec) {
+        if (mi->match_record(in_mac, in_ssid))
+            return mi;
+    }
+
+    return NULL;
+}
+
@@ -20,6 +20,8 @@
 #ifndef __PHY_UAV_DRONE_H__
 #define __PHY_UAV_DRONE_H__
 
+#include <unordered_map>
+
 #include "trackedelement.h"
 #include "tracked_location.h"
 #include "phyhandler.h"
@@ -341,8 +343,9 @@ protected:
         tracker_component::reserve_fields(e);
 
         if (e != NULL) {
-            last_telem_loc.reset(new uav_tracked_telemetry(globalreg, last_telem_loc_id,
-                        e->get_map_value(last_telem_loc_id)));
+            if (e->get_map_value(last_telem_loc_id) != NULL)
+                last_telem_loc.reset(new uav_tracked_telemetry(globalreg, last_telem_loc_id,
+                            e->get_map_value(last_telem_loc_id)));
 
             TrackerElementVector v(uav_telem_history);
             for (auto l = v.begin(); l != v.end(); ++l) {
@@ -350,15 +353,18 @@ protected:
                 *l = std::static_pointer_cast<TrackerElement>(telem);
             }
 
-            home_location.reset(new kis_tracked_location_triplet(globalreg, home_location_id,
-                        e->get_map_value(home_location_id)));
+            if (e->get_map_value(home_location_id) != NULL)
+                home_location.reset(new kis_tracked_location_triplet(globalreg, home_location_id,
+                            e->get_map_value(home_location_id)));
 
-            matched_type.reset(new uav_manuf_match(globalreg, matched_type_id,
-                        e->get_map_value(matched_type_id)));
+            if (e->get_map_value(matched_type_id) != NULL)
+                matched_type.reset(new uav_manuf_match(globalreg, matched_type_id,
+                            e->get_map_value(matched_type_id)));
         }
 
         add_map(home_location);
-        add_map(last_telem_loc_id, last_telem_loc);
+        if (last_telem_loc != NULL)
+            add_map(last_telem_loc_id, last_telem_loc);
         add_map(matched_type);
     }
 
@@ -413,9 +419,19 @@ public:
 
     virtual int Httpd_PostComplete(Kis_Net_Httpd_Connection *concls);
 
+    // Probe the compiled match index; returns the first matching manuf
+    // record or NULL.  Mac-keyed matchers resolve via one hash probe per
+    // distinct mask; regex-only matchers are tried afterwards.
+    std::shared_ptr<uav_manuf_match> find_manuf_match(mac_addr in_mac,
+            std::string in_ssid);
+
 protected:
     bool parse_manuf_definition(std::string def);
 
+    // Recompile the match index from manuf_match_vec; called whenever a
+    // definition is added
+    void rebuild_manuf_index();
+
     kis_recursive_timed_mutex uav_mutex;
 
     std::shared_ptr<Packetchain> packetchain;
@@ -427,6 +443,14 @@ protected:
     int uav_device_id;
 
     SharedTrackerElement manuf_match_vec;
+
+    // Compiled match index over manuf_match_vec; matchers with a mac are
+    // bucketed on the masked mac so lookup cost doesn't grow with the
+    // signature set, matchers with only an ssid regex stay in a short
+    // linear list
+    std::unordered_multimap<uint64_t, std::shared_ptr<uav_manuf_match> > mac_match_index;
+    std::vector<uint64_t> mac_match_masks;
+    std::vector<std::shared_ptr<uav_manuf_match> > ssid_match_vec;
 };
 
 #endif
@@ -135,6 +135,12 @@ bool Kis_Zwave_Phy::json_to_record(Json::Value json) {
     if (dmac.error)
         return false;
 
+    // Every decoded report synthesizes a device; hold new nodes in the
+    // probation table until they've been sighted enough to earn a full
+    // device record.  Still a valid report, so it isn't an http error.
+    if (!AdmitReportSource(smac, globalreg->timestamp.tv_sec))
+        return true;
+
     kis_packet *pack = new kis_packet(globalreg);
     pack->ts.tv_sec = globalreg->timestamp.tv_sec;
     pack->ts.tv_usec = globalreg->timestamp.tv_usec;
@@ -23,7 +23,12 @@
 
 #include <stdio.h>
 
+#include <map>
+
 #include "globalregistry.h"
+#include "configfile.h"
+#include "kis_mutex.h"
+#include "macaddr.h"
 #include "trackedelement.h"
 
 class Devicetracker;
@@ -38,6 +43,9 @@ public:
 		devicetracker = NULL;
 		phyid = -1;
 		phyname = "NONE";
+        report_admit_sightings = -1;
+        report_admit_window = 0;
+        report_admit_probation_len = 0;
 	}
 
     virtual Kis_Phy_Handler *CreatePhyHandler(GlobalRegistry *in_globalreg,
@@ -48,6 +56,9 @@ public:
 		globalreg = in_globalreg;
 		phyid = in_phyid;
 		devicetracker = in_tracker;
+        report_admit_sightings = -1;
+        report_admit_window = 0;
+        report_admit_probation_len = 0;
 	}
 
 	virtual ~Kis_Phy_Handler() { }
@@ -69,6 +80,83 @@ protected:
         phyname_hash = TrackedDeviceKey::gen_pkey(phyname);
     }
 
+    // Admission control for phys which synthesize devices from decoded
+    // sensor reports (rtl_433, Z-Wave) rather than captured frames; a
+    // neighborhood of chatty junk emitters can otherwise bloat the tracker
+    // with full device records.  When tracker_report_admit_sightings is
+    // set, a report source has to be sighted that many times within
+    // tracker_report_admit_window seconds before it's promoted to a full
+    // tracked device; until then it costs one slot in this compact
+    // probation table.  Returns true when the report should build or
+    // update a tracked device.
+    bool AdmitReportSource(mac_addr in_mac, time_t in_ts) {
+        if (report_admit_sightings < 0) {
+            report_admit_sightings =
+                globalreg->kismet_config->FetchOptInt("tracker_report_admit_sightings", 0);
+            report_admit_window =
+                globalreg->kismet_config->FetchOptInt("tracker_report_admit_window", 60);
+            report_admit_probation_len =
+                globalreg->kismet_config->FetchOptInt("tracker_report_admit_probation_len", 4096);
+        }
+
+        if (report_admit_sightings <= 1)
+            return true;
+
+        local_locker lock(&probation_mutex);
+
+        auto pi = probation_table.find(in_mac);
+
+        if (pi == probation_table.end()) {
+            // Bound the probation table itself; shed expired candidates
+            // first, and if it's still full, the new source is the one
+            // that waits
+            if ((int) probation_table.size() >= report_admit_probation_len) {
+                for (auto i = probation_table.begin(); i != probation_table.end(); ) {
+                    if (in_ts - i->second.first_ts > report_admit_window)
+                        i = probation_table.erase(i);
+                    else
+                        ++i;
+                }
+
+                if ((int) probation_table.size() >= report_admit_probation_len)
+                    return false;
+            }
+
+            probation_rec rec;
+            rec.first_ts = in_ts;
+            rec.sightings = 1;
+            probation_table[in_mac] = rec;
+
+            return false;
+        }
+
+        // Restart the window when the previous sightings went stale
+        if (in_ts - pi->second.first_ts > report_admit_window) {
+            pi->second.first_ts = in_ts;
+            pi->second.sightings = 1;
+            return false;
+        }
+
+        if (++(pi->second.sightings) >= (unsigned int) report_admit_sightings) {
+            probation_table.erase(pi);
+            return true;
+        }
+
+        return false;
+    }
+
+    struct probation_rec {
+        time_t first_ts;
+        unsigned int sightings;
+    };
+
+    kis_recursive_timed_mutex probation_mutex;
+    std::map<mac_addr, probation_rec> probation_table;
+
+    int report_admit_sightings;
+    int report_admit_window;
+    int report_admit_probation_len;
+
 	GlobalRegistry *globalreg;
 	Devicetracker *devicetracker;
 
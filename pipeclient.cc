@@ -24,6 +24,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <sys/uio.h>
 
 #include "util.h"
 #include "pipeclient.h"
@@ -111,22 +112,45 @@ int PipeClient::Poll(fd_set& in_rset, fd_set& in_wset) {
     std::stringstream msg;
 
     uint8_t *buf;
-    size_t len;
+    uint8_t *seg_b;
+    size_t len, len_a, len_b;
     ssize_t ret, iret;
 
+    struct iovec iov[2];
+    int iovcnt;
+
     // fprintf(stderr, "debug - pipeclient - poll rfd %d wfd %d\n", read_fd, write_fd);
 
     if (read_fd > -1 && FD_ISSET(read_fd, &in_rset)) {
-        // Allocate the biggest buffer we can fit in the ring, read as much
-        // as we can at once.
-       
+        // Reserve the entire free space of the ring, both sides of the
+        // wrap, and fill it with one readv
+
         while (handler->GetReadBufferAvailable()) {
-            len = handler->ZeroCopyReserveReadBufferData((void **) &buf,
-                    handler->GetReadBufferAvailable());
+            len = handler->ZeroCopyReserveReadBufferVector((void **) &buf, &len_a,
+                    (void **) &seg_b, &len_b, handler->GetReadBufferAvailable());
+
+            iovcnt = 0;
+
+            if (len_a > 0) {
+                iov[iovcnt].iov_base = buf;
+                iov[iovcnt].iov_len = len_a;
+                iovcnt++;
+            }
+
+            if (len_b > 0) {
+                iov[iovcnt].iov_base = seg_b;
+                iov[iovcnt].iov_len = len_b;
+                iovcnt++;
+            }
+
+            if (len == 0 || iovcnt == 0) {
+                handler->CommitReadBufferData(buf, 0);
+                break;
+            }
 
             // fprintf(stderr, "debug - read buffer available reserved %lu\n", len);
 
-            if ((ret = read(read_fd, buf, len)) <= 0) {
+            if ((ret = readv(read_fd, iov, iovcnt)) <= 0) {
                 if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
 
                     if (ret == 0) {
@@ -164,14 +188,30 @@ int PipeClient::Poll(fd_set& in_rset, fd_set& in_wset) {
         }
     }
 
-    if (write_fd > -1 && FD_ISSET(write_fd, &in_wset) && 
+    if (write_fd > -1 && FD_ISSET(write_fd, &in_wset) &&
             (len = handler->GetWriteBufferUsed()) > 0) {
-        // Peek the data into our buffer
-        ret = handler->ZeroCopyPeekWriteBufferData((void **) &buf, len);
+        // Peek both sides of the ring wrap and hand them to the kernel in
+        // a single writev
+        ret = handler->ZeroCopyPeekWriteBufferVector((void **) &buf, &len_a,
+                (void **) &seg_b, &len_b, len);
+
+        iovcnt = 0;
+
+        if (len_a > 0) {
+            iov[iovcnt].iov_base = buf;
+            iov[iovcnt].iov_len = len_a;
+            iovcnt++;
+        }
+
+        if (len_b > 0) {
+            iov[iovcnt].iov_base = seg_b;
+            iov[iovcnt].iov_len = len_b;
+            iovcnt++;
+        }
 
         // fprintf(stderr, "debug - pipe client write - used %u peeked %u\n", len, ret);
 
-        if ((iret = write(write_fd, buf, ret)) < 0) {
+        if ((iret = writev(write_fd, iov, iovcnt)) < 0) {
             if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
                 msg << "Pipe client error writing - " << kis_strerror_r(errno);
 
@@ -182,6 +222,9 @@ int PipeClient::Poll(fd_set& in_rset, fd_set& in_wset) {
                 handler->BufferError(msg.str());
                 return 0;
             }
+
+            // Release the peek so the next poll can try again
+            handler->PeekFreeWriteBufferData(buf);
         } else {
             // Consume whatever we managed to write
             handler->PeekFreeWriteBufferData(buf);
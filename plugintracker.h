@@ -75,6 +75,14 @@
 //
 // Plugins should return negative on failure, non-negative on success.
 //
+// Plugins which process packets should install their chain handlers via
+// Packetchain::RegisterPluginHandler, passing the
+// KIS_PACKETCHAIN_PLUGIN_API_VERSION they were built against; the version
+// handshake happens once at registration, the handler is dispatched as a
+// raw function pointer like any built-in, and its per-handler latency is
+// always accounted so a slow plugin is identifiable from
+// /packetchain/handler_timing.json.
+//
 //
 // Kismet plugins are first-order citizens in the ecosystem - a plugin
 // is passed the global registry and is able to look up and interact
@@ -16,16 +16,27 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
 #include "pollabletracker.h"
 
 PollableTracker::PollableTracker(GlobalRegistry *in_globalreg) {
     globalreg = in_globalreg;
 
+#ifdef SYS_LINUX
+    epoll_fd = -1;
+#endif
 }
 
 PollableTracker::~PollableTracker() {
     local_eol_locker lock(&pollable_mutex);
 
+#ifdef SYS_LINUX
+    if (epoll_fd >= 0)
+        close(epoll_fd);
+#endif
 }
 
 void PollableTracker::RegisterPollable(std::shared_ptr<Pollable> in_pollable) {
@@ -93,3 +104,138 @@ int PollableTracker::ProcessPollableSelect(fd_set rset, fd_set wset) {
     return num;
 }
 
+#ifdef SYS_LINUX
+
+void PollableTracker::SyncEpollInterest() {
+    fd_set rset, wset;
+    std::map<int, epoll_interest> desired;
+
+    for (auto i = pollable_vec.begin(); i != pollable_vec.end(); ++i) {
+        FD_ZERO(&rset);
+        FD_ZERO(&wset);
+
+        int max_fd = (*i)->MergeSet(0, &rset, &wset);
+
+        for (int fd = 0; fd <= max_fd; fd++) {
+            uint32_t events = 0;
+
+            if (FD_ISSET(fd, &rset))
+                events |= EPOLLIN;
+            if (FD_ISSET(fd, &wset))
+                events |= EPOLLOUT;
+
+            if (events == 0)
+                continue;
+
+            epoll_interest interest;
+            interest.pollable = *i;
+            interest.events = events;
+
+            desired[fd] = interest;
+        }
+    }
+
+    struct epoll_event ev;
+
+    // Drop descriptors nobody wants anymore; a pollable may have closed
+    // its descriptor already, in which case the kernel has dropped it
+    // for us and the ctl failing is fine
+    for (auto e = epoll_interest_map.begin(); e != epoll_interest_map.end(); ++e) {
+        if (desired.find(e->first) == desired.end())
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, e->first, NULL);
+    }
+
+    for (auto d = desired.begin(); d != desired.end(); ++d) {
+        memset(&ev, 0, sizeof(ev));
+        ev.events = d->second.events;
+        ev.data.fd = d->first;
+
+        auto e = epoll_interest_map.find(d->first);
+
+        if (e == epoll_interest_map.end()) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, d->first, &ev);
+        } else if (e->second.events != d->second.events) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, d->first, &ev);
+        }
+    }
+
+    epoll_interest_map = desired;
+}
+
+int PollableTracker::ProcessPollableEpoll(int timeout_ms) {
+    struct epoll_event ready[128];
+    int nev;
+
+    {
+        local_locker lock(&pollable_mutex);
+
+        Maintenance();
+
+        if (epoll_fd < 0) {
+            epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+            if (epoll_fd < 0)
+                return -1;
+        }
+
+        SyncEpollInterest();
+    }
+
+    // Sleep unlocked so pollables can be added or removed while we wait
+    nev = epoll_wait(epoll_fd, ready, 128, timeout_ms);
+
+    if (nev < 0) {
+        if (errno == EINTR || errno == EAGAIN)
+            return 0;
+
+        return -1;
+    }
+
+    local_locker lock(&pollable_mutex);
+
+    fd_set rset, wset;
+    FD_ZERO(&rset);
+    FD_ZERO(&wset);
+
+    // Rebuild fd_sets from the ready list and dispatch only to the
+    // pollables which own a ready descriptor; errors and hangups get
+    // reported as readable so the pollable sees the failing read
+    std::vector<std::shared_ptr<Pollable> > dispatch_vec;
+
+    for (int e = 0; e < nev; e++) {
+        int fd = ready[e].data.fd;
+
+        if (ready[e].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+            FD_SET(fd, &rset);
+        if (ready[e].events & EPOLLOUT)
+            FD_SET(fd, &wset);
+
+        auto i = epoll_interest_map.find(fd);
+
+        if (i == epoll_interest_map.end())
+            continue;
+
+        bool seen = false;
+        for (auto d = dispatch_vec.begin(); d != dispatch_vec.end(); ++d) {
+            if (*d == i->second.pollable) {
+                seen = true;
+                break;
+            }
+        }
+
+        if (!seen)
+            dispatch_vec.push_back(i->second.pollable);
+    }
+
+    int num = 0;
+
+    for (auto d = dispatch_vec.begin(); d != dispatch_vec.end(); ++d) {
+        if ((*d)->Poll(rset, wset) >= 0)
+            num++;
+    }
+
+    return num;
+}
+
+#endif
+
@@ -21,8 +21,13 @@
 
 #include "config.h"
 
+#include <map>
 #include <vector>
 
+#ifdef SYS_LINUX
+#include <sys/epoll.h>
+#endif
+
 #include "kis_mutex.h"
 #include "pollable.h"
 #include "globalregistry.h"
@@ -75,6 +80,19 @@ public:
     // -1   Error
     int ProcessPollableSelect(fd_set rset, fd_set wset);
 
+#ifdef SYS_LINUX
+    // Perform a complete event loop pass over an epoll descriptor:
+    // sync the kernel interest list to the pollables, sleep in
+    // epoll_wait for up to timeout_ms, and dispatch Poll() only to the
+    // pollables which own ready descriptors, so a wakeup costs the size
+    // of the ready set instead of the size of the registration list.
+    //
+    // returns:
+    // 0+   Number of pollable items processed
+    // -1   Error
+    int ProcessPollableEpoll(int timeout_ms);
+#endif
+
 protected:
     GlobalRegistry *globalreg;
 
@@ -85,6 +103,25 @@ protected:
     std::vector<std::shared_ptr<Pollable> > remove_vec;
 
     void Maintenance();
+
+#ifdef SYS_LINUX
+    int epoll_fd;
+
+    struct epoll_interest {
+        std::shared_ptr<Pollable> pollable;
+        uint32_t events;
+    };
+
+    // Descriptors currently registered with the kernel and the pollable
+    // which owns each one
+    std::map<int, epoll_interest> epoll_interest_map;
+
+    // Re-derive the descriptor interest of every pollable via MergeSet
+    // and sync the kernel registration to match; pollables change their
+    // write interest as their buffers drain so this runs every pass, but
+    // it only makes syscalls for interests which actually changed.
+    void SyncEpollInterest();
+#endif
 };
 
 #endif
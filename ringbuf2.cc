@@ -23,15 +23,29 @@
 #include "util.h"
 #include "ringbuf2.h"
 
+std::atomic<uint64_t> RingbufV2::overflow_count(0);
+std::atomic<uint64_t> RingbufV2::total_buffer_bytes(0);
+
 RingbufV2::RingbufV2(size_t in_sz) {
-    buffer = new unsigned char[in_sz];
+    // Round up to the next power of two so positions can be wrapped with a
+    // mask instead of a modulo
+    size_t rounded = 1;
+
+    while (rounded < in_sz)
+        rounded = rounded << 1;
 
-    memset(buffer, 0xAA, in_sz);
+    buffer = new unsigned char[rounded];
 
-    buffer_sz = in_sz;
+    memset(buffer, 0xAA, rounded);
+
+    buffer_sz = rounded;
+    buffer_mask = rounded - 1;
+    buffer_max_sz = 0;
     start_pos = 0;
     length = 0;
 
+    total_buffer_bytes += rounded;
+
 #ifdef PROFILE_RINGBUFV2 
     zero_copy_w_bytes = 0;
     zero_copy_r_bytes = 0;
@@ -41,13 +55,69 @@ RingbufV2::RingbufV2(size_t in_sz) {
 #endif
 }
 
+RingbufV2::RingbufV2(size_t in_sz, size_t in_max_sz) : RingbufV2(in_sz) {
+    size_t rounded = 1;
+
+    while (rounded < in_max_sz)
+        rounded = rounded << 1;
+
+    if (rounded < buffer_sz)
+        rounded = buffer_sz;
+
+    buffer_max_sz = rounded;
+}
+
+bool RingbufV2::grow_locked(size_t in_needed) {
+    if (buffer_max_sz == 0 || buffer_sz >= buffer_max_sz)
+        return false;
+
+    // An outstanding zero-copy region points into the old allocation;
+    // growth has to wait for it to resolve
+    if (peek_reserved || write_reserved)
+        return false;
+
+    size_t new_sz = buffer_sz;
+
+    while (new_sz - length < in_needed && new_sz < buffer_max_sz)
+        new_sz = new_sz << 1;
+
+    if (new_sz - length < in_needed)
+        return false;
+
+    // Linearize the buffered data into the new allocation
+    unsigned char *new_buffer = new unsigned char[new_sz];
+
+    if (length > 0) {
+        if (start_pos + length <= buffer_sz) {
+            memcpy(new_buffer, buffer + start_pos, length);
+        } else {
+            size_t chunk_a = buffer_sz - start_pos;
+            memcpy(new_buffer, buffer + start_pos, chunk_a);
+            memcpy(new_buffer + chunk_a, buffer, length - chunk_a);
+        }
+    }
+
+    delete[] buffer;
+
+    total_buffer_bytes += new_sz - buffer_sz;
+
+    buffer = new_buffer;
+    buffer_sz = new_sz;
+    buffer_mask = new_sz - 1;
+    start_pos = 0;
+
+    return true;
+}
+
 RingbufV2::~RingbufV2() {
     local_eol_locker lock(&write_mutex);
 
 #ifdef PROFILE_RINGBUFV2
     profile();
 #endif
-    
+
+    total_buffer_bytes -= buffer_sz;
+
     delete[] buffer;
 }
 
@@ -110,6 +180,15 @@ ssize_t RingbufV2::available() {
     return buffer_sz - length;
 }
 
+bool RingbufV2::ensure(size_t in_sz) {
+    local_locker lock(&write_mutex);
+
+    if (buffer_sz - length >= in_sz)
+        return true;
+
+    return grow_locked(in_sz);
+}
+
 ssize_t RingbufV2::peek(unsigned char **ptr, size_t in_sz) {
     local_eol_locker peeklock(&write_mutex);
 
@@ -198,6 +277,50 @@ ssize_t RingbufV2::zero_copy_peek(unsigned char **ptr, size_t in_sz) {
     return opsize;
 }
 
+ssize_t RingbufV2::zero_copy_peek_vector(unsigned char **seg_a, size_t *len_a,
+        unsigned char **seg_b, size_t *len_b, size_t in_sz) {
+    local_eol_locker peeklock(&write_mutex);
+
+    if (peek_reserved) {
+        throw std::runtime_error("ringbuf v2 peek already locked");
+    }
+
+    // Always reserve first since we might blindly peek_free later
+    peek_reserved = true;
+    free_peek = false;
+
+    *seg_a = NULL;
+    *seg_b = NULL;
+    *len_a = 0;
+    *len_b = 0;
+
+    // No matter what is requested we can't read more than we have
+    size_t opsize = std::min(in_sz, used());
+
+    if (opsize == 0)
+        return 0;
+
+#ifdef PROFILE_RINGBUFV2
+    zero_copy_r_bytes += opsize;
+    last_profile_bytes += opsize;
+    if (last_profile_bytes > (1024*1024))
+        profile();
+#endif
+
+    *seg_a = buffer + start_pos;
+
+    if (start_pos + opsize <= buffer_sz) {
+        *len_a = opsize;
+    } else {
+        // Wrapped; the second segment is the head of the buffer
+        *len_a = buffer_sz - start_pos;
+        *seg_b = buffer;
+        *len_b = opsize - *len_a;
+    }
+
+    return opsize;
+}
+
 void RingbufV2::peek_free(unsigned char *in_data) {
     local_unlocker unpeeklock(&write_mutex);
 
@@ -232,25 +355,11 @@ size_t RingbufV2::consume(size_t in_sz) {
         throw std::runtime_error("ringbuf v2 consuming more than we have?");
     }
 
-    // Can we read contiguously?
-    if (start_pos + opsize < buffer_sz) {
-        start_pos += opsize;
-        length -= opsize;
+    // Masked advance handles the wrap in one op
+    start_pos = (start_pos + opsize) & buffer_mask;
+    length -= opsize;
 
-        return opsize;
-    } else {
-        // Split into chunks
-        size_t chunk_a = buffer_sz - start_pos;
-        size_t chunk_b = opsize - chunk_a;
-
-        // Loop the ring buffer and mark read
-        start_pos = chunk_b;
-        length -= opsize;
-
-        return opsize;
-    }
-
-    return 0;
+    return opsize;
 }
 
 ssize_t RingbufV2::write(unsigned char *data, size_t in_sz) {
@@ -263,8 +372,8 @@ ssize_t RingbufV2::write(unsigned char *data, size_t in_sz) {
     if (in_sz == 0)
         return 0;
 
-    if (available() < (ssize_t) in_sz) {
-        fprintf(stderr, "debug - ringbuf2 - insufficient space in buffer for %lu available %lu length %lu\n", in_sz, available(), length);
+    if (available() < (ssize_t) in_sz && !grow_locked(in_sz)) {
+        overflow_count++;
         return 0;
     }
 
@@ -281,7 +390,7 @@ ssize_t RingbufV2::write(unsigned char *data, size_t in_sz) {
     size_t copy_start;
 
     // Figure out if we can write a contiguous block
-    copy_start = (start_pos + length) % buffer_sz;
+    copy_start = (start_pos + length) & buffer_mask;
 
     if (copy_start + in_sz < buffer_sz) {
         // fprintf(stderr, "debug - ringbuf2 write len %lu copy_start %lu start pos %lu length %lu buffer %lu\n", in_sz, copy_start, start_pos, length, buffer_sz);
@@ -324,29 +433,37 @@ ssize_t RingbufV2::reserve(unsigned char **data, size_t in_sz) {
 
     size_t copy_start;
 
-    if (available() < (ssize_t) in_sz) {
-        // fprintf(stderr, "debug - ringbuf2 - insufficient space in buffer for %lu\n", in_sz);
+    if (available() < (ssize_t) in_sz && !grow_locked(in_sz)) {
+        overflow_count++;
         return 0;
     }
 
-    // Figure out if we can write a contiguous block
-    copy_start = (start_pos + length) % buffer_sz;
+    // Figure out where the write region starts
+    copy_start = (start_pos + length) & buffer_mask;
 
     write_reserved = true;
+    free_commit = false;
 
-    if (copy_start + in_sz < buffer_sz) {
-        free_commit = false;
+    // Contiguous tail space fits the reservation directly
+    if (copy_start + in_sz <= buffer_sz) {
         *data = buffer + copy_start;
 
         return in_sz;
-    } else {
-        free_commit = true;
-        *data = new unsigned char[in_sz];
+    }
 
-        // fprintf(stderr, "debug - ringbuf2 - copy reserve at %lu len  %lu\n", copy_start, in_sz);
+    // The tail is too short but we know the total free space fits; buffered
+    // data which already wraps leaves its free space contiguous in the middle
+    // and is caught above, so the data must be a single unwrapped run which we
+    // can shuffle to the front of the buffer, making the free region
+    // contiguous.  This costs a move of the pending data but only at the wrap
+    // point, and keeps the reservation zero-copy.
+    if (length > 0)
+        memmove(buffer, buffer + start_pos, length);
 
-        return in_sz;
-    }
+    start_pos = 0;
+    *data = buffer + length;
+
+    return in_sz;
 }
 
 ssize_t RingbufV2::zero_copy_reserve(unsigned char **data, size_t in_sz) {
@@ -364,7 +481,7 @@ ssize_t RingbufV2::zero_copy_reserve(unsigned char **data, size_t in_sz) {
     }
 
     size_t copy_start;
-    copy_start = (start_pos + length) % buffer_sz;
+    copy_start = (start_pos + length) & buffer_mask;
 
     // Always return at the start of the buffer
     *data = buffer + copy_start;
@@ -380,6 +497,43 @@ ssize_t RingbufV2::zero_copy_reserve(unsigned char **data, size_t in_sz) {
 
 }
 
+ssize_t RingbufV2::zero_copy_reserve_vector(unsigned char **seg_a, size_t *len_a,
+        unsigned char **seg_b, size_t *len_b, size_t in_sz) {
+    local_eol_locker writelock(&write_mutex);
+
+    if (write_reserved) {
+        throw std::runtime_error("ringbuf v2 write already locked");
+    }
+
+    write_reserved = true;
+    free_commit = false;
+
+    *seg_a = NULL;
+    *seg_b = NULL;
+    *len_a = 0;
+    *len_b = 0;
+
+    size_t opsize = std::min((size_t) available(), in_sz);
+
+    if (opsize == 0)
+        return 0;
+
+    size_t copy_start = (start_pos + length) & buffer_mask;
+
+    *seg_a = buffer + copy_start;
+
+    if (copy_start + opsize <= buffer_sz) {
+        *len_a = opsize;
+    } else {
+        // Wrapped; the second segment is the head of the buffer
+        *len_a = buffer_sz - copy_start;
+        *seg_b = buffer;
+        *len_b = opsize - *len_a;
+    }
+
+    return opsize;
+}
+
 bool RingbufV2::commit(unsigned char *data, size_t in_sz) {
     local_unlocker unwritelock(&write_mutex);
 
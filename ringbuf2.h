@@ -22,18 +22,34 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <atomic>
 #include <mutex>
 #include "buffer_handler.h"
 
 // #define PROFILE_RINGBUFV2   1
 
-// A better ringbuffer implementation that will replace the old ringbuffer in 
+// A better ringbuffer implementation that will replace the old ringbuffer in
 // Kismet as the rewrite continues
 //
+// Buffers are rounded up to power-of-two sizes so all position math is done
+// with a mask instead of a modulo.
+//
+// reserve() always returns a contiguous region of the full requested size;
+// when the write region would wrap, the pending data is shuffled to the
+// front of the buffer instead of bouncing the reservation through an
+// interstitial copy, so reserved writes are always zero-copy.
+//
 // Automatically thread locks locally to prevent multiple operations overlapping
 class RingbufV2 : public CommonBuffer {
 public:
     RingbufV2(size_t in_sz);
+
+    // Growable buffer; starts at in_sz and doubles on write pressure up
+    // to in_max_sz, so a consumer which keeps up only ever costs the
+    // initial allocation and a lagging one costs memory proportional to
+    // its actual backlog
+    RingbufV2(size_t in_sz, size_t in_max_sz);
+
     virtual ~RingbufV2();
 
     // Reset a buffer
@@ -43,6 +59,8 @@ public:
     virtual ssize_t available();
     virtual size_t used();
 
+    virtual bool ensure(size_t in_sz);
+
     // Write data into a buffer
     // Return amount of data actually written
     virtual ssize_t write(unsigned char *in_data, size_t in_sz);
@@ -50,22 +68,51 @@ public:
     // Peek at data
     virtual ssize_t peek(unsigned char **in_data, size_t in_sz);
     virtual ssize_t zero_copy_peek(unsigned char **in_data, size_t in_sz);
+    virtual ssize_t zero_copy_peek_vector(unsigned char **seg_a, size_t *len_a,
+            unsigned char **seg_b, size_t *len_b, size_t in_sz);
     virtual void peek_free(unsigned char *in_data);
 
     virtual size_t consume(size_t in_sz);
 
     virtual ssize_t reserve(unsigned char **data, size_t in_sz);
     virtual ssize_t zero_copy_reserve(unsigned char **data, size_t in_sz);
+    virtual ssize_t zero_copy_reserve_vector(unsigned char **seg_a, size_t *len_a,
+            unsigned char **seg_b, size_t *len_b, size_t in_sz);
     virtual bool commit(unsigned char *data, size_t in_sz);
 
+    // Process-wide count of writes and reserves rejected for lack of
+    // buffer space, across all ring buffers; published as an engine
+    // health counter
+    static uint64_t FetchOverflowCount() {
+        return overflow_count;
+    }
+
+    // Process-wide bytes currently allocated to live ring buffers;
+    // published as a memory accounting gauge
+    static uint64_t FetchTotalBytes() {
+        return total_buffer_bytes;
+    }
+
 #ifdef PROFILE_RINGBUFV2
     virtual void profile();
 #endif
 
 protected:
+    static std::atomic<uint64_t> overflow_count;
+    static std::atomic<uint64_t> total_buffer_bytes;
+
+    // Grow the buffer so in_needed bytes fit, up to the maximum; caller
+    // must hold write_mutex.  Returns false if growth can't happen (fixed
+    // buffer, at max, or a zero-copy region is outstanding)
+    bool grow_locked(size_t in_needed);
+
     unsigned char *buffer;
-    // Total size
+    // Total size; always a power of two
     size_t buffer_sz;
+    // Growth limit, rounded to a power of two; 0 for a fixed buffer
+    size_t buffer_max_sz;
+    // Wrap mask, buffer_sz - 1
+    size_t buffer_mask;
     // Where reads start
     size_t start_pos;
     // Length of data currently in buffer
@@ -206,3 +206,65 @@ size_t kis_simple_ringbuf_peek(kis_simple_ringbuf_t *ringbuf, void *ptr,
     return 0;
 }
 
+
+/* Reserves a block of write space in the ring, exposing the ring memory
+ * directly.  Only contiguous memory is handed out; if the block would wrap
+ * the ring, nothing is reserved.
+ *
+ * Returns amount reserved (length, or 0)
+ */
+size_t kis_simple_ringbuf_reserve(kis_simple_ringbuf_t *ringbuf,
+        void **data, size_t length) {
+    size_t copy_start;
+
+    if (kis_simple_ringbuf_available(ringbuf) < length)
+        return 0;
+
+    copy_start =
+        (ringbuf->start_pos + ringbuf->length) % ringbuf->buffer_sz;
+
+    /* We can only expose linear memory; the caller falls back to a copying
+     * write when the block would wrap */
+    if (copy_start + length > ringbuf->buffer_sz)
+        return 0;
+
+    *data = ringbuf->buffer + copy_start;
+
+    return length;
+}
+
+/* Commits previously reserved space, marking it as written.
+ *
+ * Returns amount committed
+ */
+size_t kis_simple_ringbuf_commit(kis_simple_ringbuf_t *ringbuf, size_t length) {
+    ringbuf->length += length;
+
+    return length;
+}
+
+/* Peeks at data in place, exposing the ring memory directly.  Does NOT
+ * advance the ringbuf or consume data.
+ *
+ * At most the contiguous run up to the wrap point is exposed.
+ *
+ * Returns amount of data available at *ptr
+ */
+size_t kis_simple_ringbuf_peek_zc(kis_simple_ringbuf_t *ringbuf,
+        void **ptr, size_t size) {
+    size_t opsize = kis_simple_ringbuf_used(ringbuf);
+
+    if (opsize == 0)
+        return 0;
+
+    if (opsize > size)
+        opsize = size;
+
+    /* Clamp to the contiguous run before the wrap point */
+    if (ringbuf->start_pos + opsize > ringbuf->buffer_sz)
+        opsize = ringbuf->buffer_sz - ringbuf->start_pos;
+
+    *ptr = ringbuf->buffer + ringbuf->start_pos;
+
+    return opsize;
+}
@@ -79,12 +79,46 @@ size_t kis_simple_ringbuf_read(kis_simple_ringbuf_t *ringbuf, void *ptr, size_t
 /* Peeks at data by copying into provided buffer.  Does NOT advance ringbuf
  * or consume data.
  *
- * If requested amount of data is not available, peeks amount available and 
+ * If requested amount of data is not available, peeks amount available and
  * returns;
  *
  * Returns amount copied
  */
 size_t kis_simple_ringbuf_peek(kis_simple_ringbuf_t *ringbuf, void *ptr, size_t size);
 
+/* Reserves a block of write space in the ring, exposing the ring memory
+ * directly so callers can serialize into it without staging in an
+ * intermediate buffer.  Reserved space does not count as written until it
+ * is committed.
+ *
+ * Only contiguous memory is ever handed out; if the requested length would
+ * wrap the ring (or exceeds the available space), nothing is reserved and
+ * the caller should fall back to a copying write.
+ *
+ * Returns amount reserved (length, or 0)
+ */
+size_t kis_simple_ringbuf_reserve(kis_simple_ringbuf_t *ringbuf,
+        void **data, size_t length);
+
+/* Commits previously reserved space, marking length bytes (which may be
+ * less than the reserved amount) as written.
+ *
+ * Returns amount committed
+ */
+size_t kis_simple_ringbuf_commit(kis_simple_ringbuf_t *ringbuf, size_t length);
+
+/* Peeks at data in place, exposing the ring memory directly instead of
+ * copying it out.  Does NOT advance the ringbuf or consume data; consume
+ * with kis_simple_ringbuf_read(ringbuf, NULL, sz) when done with the
+ * memory.
+ *
+ * At most the contiguous run up to the wrap point is exposed; callers
+ * needing more than is returned should fall back to a copying peek.
+ *
+ * Returns amount of data available at *ptr
+ */
+size_t kis_simple_ringbuf_peek_zc(kis_simple_ringbuf_t *ringbuf,
+        void **ptr, size_t size);
+
 #endif
 
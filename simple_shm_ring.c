@@ -0,0 +1,232 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* A single-producer single-consumer shared-memory ring buffer in pure C;
+ * see simple_shm_ring.h for the layout and ownership rules */
+
+#include <stdint.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "simple_shm_ring.h"
+
+kis_shm_ring_t *kis_shm_ring_create(const char *path, size_t size) {
+    kis_shm_ring_t *ring;
+    size_t rounded = 1;
+
+    /* Round up to the next power of two so positions can be masked */
+    while (rounded < size)
+        rounded = rounded << 1;
+
+    ring = (kis_shm_ring_t *) malloc(sizeof(kis_shm_ring_t));
+
+    if (ring == NULL)
+        return NULL;
+
+    ring->path = strdup(path);
+    ring->map_sz = sizeof(kis_shm_ring_header_t) + rounded;
+
+    /* Make the backing file exclusively so we never adopt a stale ring */
+    ring->fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+    if (ring->fd < 0) {
+        free(ring->path);
+        free(ring);
+        return NULL;
+    }
+
+    if (ftruncate(ring->fd, ring->map_sz) < 0) {
+        close(ring->fd);
+        unlink(path);
+        free(ring->path);
+        free(ring);
+        return NULL;
+    }
+
+    ring->header = (kis_shm_ring_header_t *) mmap(NULL, ring->map_sz,
+            PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+
+    if (ring->header == MAP_FAILED) {
+        close(ring->fd);
+        unlink(path);
+        free(ring->path);
+        free(ring);
+        return NULL;
+    }
+
+    ring->data = (uint8_t *) ring->header + sizeof(kis_shm_ring_header_t);
+
+    ring->header->ring_sz = rounded;
+    ring->header->write_pos = 0;
+    ring->header->read_pos = 0;
+
+    /* Publish the magic last so an attacher never sees a half-made header */
+    __sync_synchronize();
+    ring->header->magic = KIS_SHM_RING_MAGIC;
+
+    return ring;
+}
+
+kis_shm_ring_t *kis_shm_ring_attach(const char *path) {
+    kis_shm_ring_t *ring;
+    struct stat st;
+
+    ring = (kis_shm_ring_t *) malloc(sizeof(kis_shm_ring_t));
+
+    if (ring == NULL)
+        return NULL;
+
+    ring->path = strdup(path);
+
+    ring->fd = open(path, O_RDWR);
+
+    if (ring->fd < 0) {
+        free(ring->path);
+        free(ring);
+        return NULL;
+    }
+
+    if (fstat(ring->fd, &st) < 0 ||
+            (size_t) st.st_size <= sizeof(kis_shm_ring_header_t)) {
+        close(ring->fd);
+        free(ring->path);
+        free(ring);
+        return NULL;
+    }
+
+    ring->map_sz = st.st_size;
+
+    ring->header = (kis_shm_ring_header_t *) mmap(NULL, ring->map_sz,
+            PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+
+    if (ring->header == MAP_FAILED) {
+        close(ring->fd);
+        free(ring->path);
+        free(ring);
+        return NULL;
+    }
+
+    ring->data = (uint8_t *) ring->header + sizeof(kis_shm_ring_header_t);
+
+    /* Validate the header - right magic, power-of-two size which matches
+     * the file we mapped */
+    if (ring->header->magic != KIS_SHM_RING_MAGIC ||
+            ring->header->ring_sz == 0 ||
+            (ring->header->ring_sz & (ring->header->ring_sz - 1)) != 0 ||
+            ring->map_sz != sizeof(kis_shm_ring_header_t) + ring->header->ring_sz) {
+        munmap((void *) ring->header, ring->map_sz);
+        close(ring->fd);
+        free(ring->path);
+        free(ring);
+        return NULL;
+    }
+
+    return ring;
+}
+
+void kis_shm_ring_unlink(kis_shm_ring_t *ring) {
+    if (ring->path != NULL) {
+        unlink(ring->path);
+        free(ring->path);
+        ring->path = NULL;
+    }
+}
+
+void kis_shm_ring_free(kis_shm_ring_t *ring) {
+    if (ring == NULL)
+        return;
+
+    munmap((void *) ring->header, ring->map_sz);
+    close(ring->fd);
+
+    if (ring->path != NULL)
+        free(ring->path);
+
+    free(ring);
+}
+
+size_t kis_shm_ring_available(kis_shm_ring_t *ring) {
+    return ring->header->ring_sz -
+        (ring->header->write_pos - ring->header->read_pos);
+}
+
+size_t kis_shm_ring_used(kis_shm_ring_t *ring) {
+    return ring->header->write_pos - ring->header->read_pos;
+}
+
+size_t kis_shm_ring_write(kis_shm_ring_t *ring, void *data, size_t length) {
+    size_t offt;
+    size_t chunk;
+
+    if (kis_shm_ring_available(ring) < length)
+        return 0;
+
+    offt = ring->header->write_pos & (ring->header->ring_sz - 1);
+
+    chunk = ring->header->ring_sz - offt;
+    if (chunk > length)
+        chunk = length;
+
+    memcpy(ring->data + offt, data, chunk);
+
+    if (chunk < length)
+        memcpy(ring->data, (uint8_t *) data + chunk, length - chunk);
+
+    /* Make sure the data lands before the consumer can see the new position */
+    __sync_synchronize();
+    ring->header->write_pos += length;
+
+    return length;
+}
+
+size_t kis_shm_ring_read(kis_shm_ring_t *ring, void *ptr, size_t size) {
+    size_t used = kis_shm_ring_used(ring);
+    size_t offt;
+    size_t chunk;
+
+    if (used < size)
+        size = used;
+
+    if (size == 0)
+        return 0;
+
+    if (ptr != NULL) {
+        offt = ring->header->read_pos & (ring->header->ring_sz - 1);
+
+        chunk = ring->header->ring_sz - offt;
+        if (chunk > size)
+            chunk = size;
+
+        memcpy(ptr, ring->data + offt, chunk);
+
+        if (chunk < size)
+            memcpy((uint8_t *) ptr + chunk, ring->data, size - chunk);
+    }
+
+    /* Make sure we're done with the data before the producer can reuse it */
+    __sync_synchronize();
+    ring->header->read_pos += size;
+
+    return size;
+}
+
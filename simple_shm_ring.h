@@ -0,0 +1,126 @@
+/*
+    This file is part of Kismet
+
+    Kismet is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Kismet is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Kismet; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* A single-producer single-consumer ring buffer living in a file-backed
+ * shared memory mapping, used as an optional bulk-data channel between
+ * capture binaries and the Kismet server so that packet frames don't have
+ * to be copied through a pipe.
+ *
+ * The creating side (the capture binary) makes the backing file - typically
+ * on a tmpfs such as /dev/shm - and offers the path to the other side over
+ * the normal external interface protocol; the attaching side maps the same
+ * file.  Positions are absolute byte counters so the usual empty/full ring
+ * ambiguity doesn't exist; the producer only ever advances write_pos and
+ * the consumer only ever advances read_pos, so no cross-process lock is
+ * needed, only a memory barrier before publishing each position.
+ *
+ * Implemented in pure C so it can be shared between capture_framework and
+ * the C++ server. */
+
+#ifndef __SIMPLE_SHM_RING_H__
+#define __SIMPLE_SHM_RING_H__
+
+#include <stdint.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KIS_SHM_RING_MAGIC      0x4b524e47
+
+/* Header at the front of the shared mapping; the write and read positions
+ * are kept on their own cache lines so the two processes don't false-share */
+struct kis_shm_ring_header {
+    uint32_t magic;
+    uint32_t ring_sz; /* Data size, always a power of two */
+
+    volatile uint64_t write_pos; /* Absolute bytes written; producer-owned */
+    uint8_t pad0[48];
+
+    volatile uint64_t read_pos; /* Absolute bytes consumed; consumer-owned */
+    uint8_t pad1[56];
+};
+typedef struct kis_shm_ring_header kis_shm_ring_header_t;
+
+/* Local handle to a mapped ring */
+struct kis_shm_ring {
+    int fd;
+    char *path;
+    size_t map_sz;
+    kis_shm_ring_header_t *header;
+    uint8_t *data;
+};
+typedef struct kis_shm_ring kis_shm_ring_t;
+
+/* Create the backing file and map a ring of at least size data bytes
+ * (rounded up to a power of two); path should be on a tmpfs or ramdisk,
+ * and is created exclusively with owner-only permissions.
+ *
+ * Returns NULL if creation or mapping failed
+ */
+kis_shm_ring_t *kis_shm_ring_create(const char *path, size_t size);
+
+/* Map a ring created by another process
+ *
+ * Returns NULL if the file could not be mapped or does not contain a
+ * valid ring
+ */
+kis_shm_ring_t *kis_shm_ring_attach(const char *path);
+
+/* Remove the backing file (the mapping stays alive until both sides have
+ * freed it); safe to call from either side once both have mapped it
+ */
+void kis_shm_ring_unlink(kis_shm_ring_t *ring);
+
+/* Unmap and destroy a local handle
+ */
+void kis_shm_ring_free(kis_shm_ring_t *ring);
+
+/* Get available space (producer side)
+ */
+size_t kis_shm_ring_available(kis_shm_ring_t *ring);
+
+/* Get used space (consumer side)
+ */
+size_t kis_shm_ring_used(kis_shm_ring_t *ring);
+
+/* Append data; all-or-nothing, like the simple ringbuf
+ *
+ * Returns amount written
+ */
+size_t kis_shm_ring_write(kis_shm_ring_t *ring, void *data, size_t length);
+
+/* Copies data into provided buffer and advances the ring; passing a NULL
+ * buffer discards the data.
+ *
+ * If the requested amount is not available, reads the amount available
+ * and returns.
+ *
+ * Returns amount copied
+ */
+size_t kis_shm_ring_read(kis_shm_ring_t *ring, void *ptr, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -21,6 +21,7 @@
 
 #include "config.h"
 
+#include <atomic>
 #include <memory>
 
 #include "globalregistry.h"
@@ -44,8 +45,8 @@ public:
 
     virtual void stop_stream(std::string in_reason __attribute__((unused))) { };
 
-    uint64_t get_log_size() { return log_size; }
-    uint64_t get_log_packets() { return log_packets; }
+    uint64_t get_log_size() { return log_size.load(std::memory_order_relaxed); }
+    uint64_t get_log_packets() { return log_packets.load(std::memory_order_relaxed); }
 
     void set_max_size(uint64_t in_sz) { max_size = in_sz; }
     uint64_t get_max_size() { return max_size; }
@@ -56,12 +57,12 @@ public:
     double get_stream_id() { return stream_id; }
     void set_stream_id(double id) { stream_id = id; }
 
-    virtual bool check_over_size() { 
-        return (max_size != 0 && log_size > max_size); 
+    virtual bool check_over_size() {
+        return (max_size != 0 && log_size.load(std::memory_order_relaxed) > max_size);
     }
 
-    virtual bool check_over_packets() { 
-        return (max_packets != 0 && log_packets > max_packets); 
+    virtual bool check_over_packets() {
+        return (max_packets != 0 && log_packets.load(std::memory_order_relaxed) > max_packets);
     }
 
     virtual bool get_stream_paused() { return stream_paused; }
@@ -70,13 +71,18 @@ public:
 
 protected:
     double stream_id;
-    uint64_t log_size;
-    uint64_t log_packets;
+
+    // Accounting is bumped from the streaming path for every block and only
+    // sampled by the REST side; atomics on their own cache lines keep the
+    // stats of concurrent high-rate streams from serializing against each
+    // other or tearing when read
+    alignas(64) std::atomic<uint64_t> log_size;
+    alignas(64) std::atomic<uint64_t> log_packets;
 
     uint64_t max_size;
     uint64_t max_packets;
 
-    bool stream_paused;
+    std::atomic<bool> stream_paused;
 };
 
 class streaming_info_record : public tracker_component {
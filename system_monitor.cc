@@ -29,6 +29,9 @@
 #include "util.h"
 #include "battery.h"
 #include "entrytracker.h"
+#include "kis_mempool.h"
+#include "kis_perfcounter.h"
+#include "kis_threads.h"
 #include "system_monitor.h"
 #include "json_adapter.h"
 
@@ -49,6 +52,12 @@ Systemmonitor::Systemmonitor(GlobalRegistry *in_globalreg) :
     mem_per_page = sysconf(_SC_PAGESIZE);
 #endif
 
+    // Prime the battery cache so serializations before the first tick
+    // have sane values; after this the tick owns the refresh
+    memset(&cached_battery, 0, sizeof(kis_battery_info));
+    Fetch_Battery_Info(&cached_battery);
+    battery_sample_time = time(0);
+
     struct timeval trigger_tm;
     trigger_tm.tv_sec = globalreg->timestamp.tv_sec + 1;
     trigger_tm.tv_usec = 0;
@@ -121,6 +130,19 @@ void Systemmonitor::register_fields() {
     RegisterField("kismet.system.memory.rss", TrackerUInt64,
             "memory RSS in kbytes", &memory);
 
+    RegisterField("kismet.system.memory.pool.reserved", TrackerUInt64,
+            "preallocated memory pool reservation, bytes", &pool_reserved);
+    RegisterField("kismet.system.memory.pool.committed", TrackerUInt64,
+            "preallocated memory pool bytes carved into blocks", &pool_committed);
+    RegisterField("kismet.system.memory.pool.outstanding", TrackerUInt64,
+            "preallocated memory pool bytes currently in use", &pool_outstanding);
+    RegisterField("kismet.system.memory.pool.fallbacks", TrackerUInt64,
+            "allocations which fell back to the heap after pool exhaustion",
+            &pool_fallbacks);
+    RegisterField("kismet.system.memory.pool.hugepages", TrackerUInt8,
+            "preallocated memory pool is backed by explicit hugepages",
+            &pool_hugepages);
+
     RegisterField("kismet.system.devices.count", TrackerUInt64,
             "number of devices in devicetracker", &devices);
 
@@ -144,8 +166,71 @@ void Systemmonitor::register_fields() {
                 "memory used RRD"); 
 
     devices_rrd_id =
-        RegisterComplexField("kismet.system.devices.rrd", rrd_builder, 
+        RegisterComplexField("kismet.system.devices.rrd", rrd_builder,
                 "device count RRD");
+
+    RegisterField("kismet.system.counters", TrackerVector,
+            "engine health counters", &counter_vec);
+
+    counter_entry_id =
+        RegisterField("kismet.system.counter.entry", TrackerMap,
+                "engine health counter");
+    counter_name_id =
+        RegisterField("kismet.system.counter.name", TrackerString,
+                "counter name");
+    counter_desc_id =
+        RegisterField("kismet.system.counter.description", TrackerString,
+                "counter description");
+    counter_type_id =
+        RegisterField("kismet.system.counter.type", TrackerString,
+                "'counter' (monotonic total) or 'gauge' (instantaneous)");
+    counter_value_id =
+        RegisterField("kismet.system.counter.value", TrackerUInt64,
+                "most recent sampled value");
+    counter_rrd_id =
+        RegisterComplexField("kismet.system.counter.rrd", rrd_builder,
+                "sampled value RRD");
+
+    thread_entry_id =
+        RegisterField("kismet.system.thread.entry", TrackerMap,
+                "engine thread");
+    thread_name_id =
+        RegisterField("kismet.system.thread.name", TrackerString,
+                "thread name");
+    thread_class_id =
+        RegisterField("kismet.system.thread.class", TrackerString,
+                "affinity class");
+    thread_cpus_id =
+        RegisterField("kismet.system.thread.cpus", TrackerString,
+                "applied cpu list, empty if unpinned");
+    thread_tid_id =
+        RegisterField("kismet.system.thread.tid", TrackerUInt64,
+                "kernel thread id");
+
+    mutex_entry_id =
+        RegisterField("kismet.system.mutex.entry", TrackerMap,
+                "instrumented mutex");
+    mutex_name_id =
+        RegisterField("kismet.system.mutex.name", TrackerString,
+                "mutex label, if one was assigned");
+    mutex_address_id =
+        RegisterField("kismet.system.mutex.address", TrackerString,
+                "mutex address, to tell unlabeled mutexes apart");
+    mutex_acquisitions_id =
+        RegisterField("kismet.system.mutex.acquisitions", TrackerUInt64,
+                "total lock acquisitions");
+    mutex_contentions_id =
+        RegisterField("kismet.system.mutex.contentions", TrackerUInt64,
+                "acquisitions which had to wait");
+    mutex_wait_id =
+        RegisterField("kismet.system.mutex.wait_usec", TrackerUInt64,
+                "total microseconds spent waiting");
+    mutex_hold_id =
+        RegisterField("kismet.system.mutex.hold_usec", TrackerUInt64,
+                "total microseconds held");
+    mutex_max_hold_id =
+        RegisterField("kismet.system.mutex.max_hold_usec", TrackerUInt64,
+                "longest single hold in microseconds");
 }
 
 void Systemmonitor::reserve_fields(SharedTrackerElement e) {
@@ -211,6 +296,41 @@ int Systemmonitor::timetracker_event(int eventid) {
 
 #endif
 
+    // Preallocated memory pool occupancy; cheap counter reads, and all
+    // zero when the pool isn't enabled
+    if (kis_mem_pool::active()) {
+        set_pool_reserved(kis_mem_pool::reserved_bytes());
+        set_pool_committed(kis_mem_pool::committed_bytes());
+        set_pool_outstanding(kis_mem_pool::outstanding_bytes());
+        set_pool_fallbacks(kis_mem_pool::heap_fallbacks());
+        set_pool_hugepages(kis_mem_pool::hugepages_active());
+    }
+
+    // Refresh the battery cache when it ages out; this tick is the only
+    // place that walks the power_supply sysfs tree, so status pollers
+    // never generate filesystem traffic no matter how fast they poll
+    if (globalreg->timestamp.tv_sec - battery_sample_time >= battery_cache_ttl) {
+        Fetch_Battery_Info(&cached_battery);
+        battery_sample_time = globalreg->timestamp.tv_sec;
+    }
+
+    sample_perf_counters();
+
+    // Re-render the serialized status snapshot while we already hold the
+    // monitor lock; Pack runs the pre_serialize chain so battery state and
+    // timestamps are current as of this tick.  Status pollers stream the
+    // snapshot without contending for monitor_mutex at all.
+    std::shared_ptr<Systemmonitor> mon =
+        Globalreg::FetchGlobalAs<Systemmonitor>(globalreg, "SYSTEM_MONITOR");
+
+    if (mon != NULL) {
+        std::stringstream ss;
+        JsonAdapter::Pack(globalreg, ss, mon, NULL);
+
+        std::atomic_store(&status_json,
+                std::shared_ptr<const std::string>(new std::string(ss.str())));
+    }
+
     // Reschedule
     struct timeval trigger_tm;
     trigger_tm.tv_sec = globalreg->timestamp.tv_sec + 1;
@@ -222,21 +342,70 @@ int Systemmonitor::timetracker_event(int eventid) {
     return 1;
 }
 
-void Systemmonitor::pre_serialize() {
-    kis_battery_info batinfo;
-    Fetch_Battery_Info(&batinfo);
+void Systemmonitor::sample_perf_counters() {
+    std::shared_ptr<PerfCounterRegistry> perfcounters =
+        Globalreg::FetchGlobalAs<PerfCounterRegistry>(globalreg, "PERFCOUNTERS");
+
+    if (perfcounters == NULL)
+        return;
+
+    TrackerElementVector cvec(counter_vec);
+
+    for (auto rec : perfcounters->FetchCounters()) {
+        auto si = counter_state.find(rec.name);
+
+        if (si == counter_state.end()) {
+            // First time we've seen this counter; build its tracked entry
+            sampled_counter state;
+
+            state.entry.reset(new TrackerElement(TrackerMap, counter_entry_id));
+
+            SharedTrackerElement name(new TrackerElement(TrackerString, counter_name_id));
+            name->set(rec.name);
+            state.entry->add_map(name);
 
-    set_battery_perc(batinfo.percentage);
-    if (batinfo.ac && batinfo.charging) {
+            SharedTrackerElement desc(new TrackerElement(TrackerString, counter_desc_id));
+            desc->set(rec.description);
+            state.entry->add_map(desc);
+
+            SharedTrackerElement type(new TrackerElement(TrackerString, counter_type_id));
+            type->set(std::string(rec.type == PerfCounterRegistry::PERF_GAUGE ?
+                        "gauge" : "counter"));
+            state.entry->add_map(type);
+
+            state.value.reset(new TrackerElement(TrackerUInt64, counter_value_id));
+            state.entry->add_map(state.value);
+
+            state.rrd.reset(new kis_tracked_rrd<kis_tracked_rrd_extreme_aggregator>(globalreg,
+                        counter_rrd_id));
+            state.entry->add_map(state.rrd);
+
+            cvec.push_back(state.entry);
+
+            si = counter_state.insert(std::make_pair(rec.name, state)).first;
+        }
+
+        uint64_t v = rec.fetch();
+
+        si->second.value->set(v);
+        si->second.rrd->add_sample(v, globalreg->timestamp.tv_sec);
+    }
+}
+
+void Systemmonitor::pre_serialize() {
+    // Serve the battery state the tick last sampled; re-reading sysfs here
+    // would put filesystem I/O back into every REST status fetch
+    set_battery_perc(cached_battery.percentage);
+    if (cached_battery.ac && cached_battery.charging) {
         set_battery_charging("charging");
-    } else if (batinfo.ac && !batinfo.charging) {
+    } else if (cached_battery.ac && !cached_battery.charging) {
         set_battery_charging("charged");
-    } else if (!batinfo.ac) {
+    } else if (!cached_battery.ac) {
         set_battery_charging("discharging");
     }
 
-    set_battery_ac(batinfo.ac);
-    set_battery_remaining(batinfo.remaining_sec);
+    set_battery_ac(cached_battery.ac);
+    set_battery_remaining(cached_battery.remaining_sec);
 
     struct timeval now;
     gettimeofday(&now, NULL);
@@ -257,9 +426,18 @@ bool Systemmonitor::Httpd_VerifyPath(const char *path, const char *method) {
     if (stripped == "/system/status")
         return true;
 
+    if (stripped == "/system/memory")
+        return true;
+
     if (stripped == "/system/timestamp")
         return true;
 
+    if (stripped == "/system/threads")
+        return true;
+
+    if (stripped == "/system/mutex_profile")
+        return true;
+
     return false;
 }
 
@@ -271,8 +449,6 @@ void Systemmonitor::Httpd_CreateStreamResponse(
         size_t *upload_data_size __attribute__((unused)), 
         std::stringstream &stream) {
 
-    local_locker lock(&monitor_mutex);
-
     if (strcmp(method, "GET") != 0) {
         return;
     }
@@ -286,24 +462,147 @@ void Systemmonitor::Httpd_CreateStreamResponse(
         Globalreg::FetchGlobalAs<EntryTracker>(globalreg, "ENTRY_TRACKER");
 
     if (stripped == "/system/status") {
+        // Stream the snapshot rendered by the monitor tick; it's at most a
+        // second stale, which is as fresh as the sampled data underneath it
+        // anyway, and costs us no locks
+        if (httpd->GetSuffix(path) == "json") {
+            std::shared_ptr<const std::string> snap = std::atomic_load(&status_json);
+
+            if (snap != NULL) {
+                stream << *snap;
+                return;
+            }
+        }
+
+        // Other serializers (and the window before the first tick) fall
+        // back to serializing the live record under the lock
+        local_locker lock(&monitor_mutex);
+
         entrytracker->Serialize(httpd->GetSuffix(path), stream,
                 Globalreg::FetchGlobalAs<Systemmonitor>(globalreg, "SYSTEM_MONITOR"), NULL);
 
+        return;
+    } else if (stripped == "/system/memory") {
+        local_locker lock(&monitor_mutex);
+
+        // Memory breakdown: process RSS plus the per-subsystem memory
+        // gauges published through the perf counter registry
+        SharedTrackerElement mse(new TrackerElement(TrackerMap, 0));
+
+        mse->add_map(memory);
+        mse->add_map(devices);
+
+        SharedTrackerElement mvec(new TrackerElement(TrackerVector,
+                    counter_vec->get_id()));
+        TrackerElementVector mv(mvec);
+
+        for (auto i : counter_state) {
+            if (i.first.compare(0, 14, "kismet.memory.") == 0)
+                mv.push_back(i.second.entry);
+        }
+
+        mse->add_map(mvec);
+
+        entrytracker->Serialize(httpd->GetSuffix(path), stream, mse, NULL);
+
         return;
     } else if (stripped == "/system/timestamp") {
+        // Built from standalone elements so reporting the time doesn't have
+        // to touch the monitor lock
         SharedTrackerElement tse(new TrackerElement(TrackerMap, 0));
 
-        tse->add_map(timestamp_sec);
-        tse->add_map(timestamp_usec);
-
         struct timeval now;
         gettimeofday(&now, NULL);
 
-        set_timestamp_sec(now.tv_sec);
-        set_timestamp_usec(now.tv_usec);
+        SharedTrackerElement sec(new TrackerElement(TrackerUInt64,
+                    timestamp_sec->get_id()));
+        sec->set((uint64_t) now.tv_sec);
+        tse->add_map(sec);
+
+        SharedTrackerElement usec(new TrackerElement(TrackerUInt64,
+                    timestamp_usec->get_id()));
+        usec->set((uint64_t) now.tv_usec);
+        tse->add_map(usec);
 
         entrytracker->Serialize(httpd->GetSuffix(path), stream, tse, NULL);
 
+        return;
+    } else if (stripped == "/system/threads") {
+        // Engine threads which have announced themselves, with their
+        // affinity class and any pinned cpu list
+        SharedTrackerElement tvec(new TrackerElement(TrackerVector, 0));
+        TrackerElementVector tv(tvec);
+
+        for (auto t : Kis_Thread_Inventory()) {
+            SharedTrackerElement te(new TrackerElement(TrackerMap, thread_entry_id));
+
+            SharedTrackerElement name(new TrackerElement(TrackerString, thread_name_id));
+            name->set(t.name);
+            te->add_map(name);
+
+            SharedTrackerElement tclass(new TrackerElement(TrackerString, thread_class_id));
+            tclass->set(t.thread_class);
+            te->add_map(tclass);
+
+            SharedTrackerElement cpus(new TrackerElement(TrackerString, thread_cpus_id));
+            cpus->set(t.cpu_list);
+            te->add_map(cpus);
+
+            SharedTrackerElement tid(new TrackerElement(TrackerUInt64, thread_tid_id));
+            tid->set((uint64_t) t.tid);
+            te->add_map(tid);
+
+            tv.push_back(te);
+        }
+
+        entrytracker->Serialize(httpd->GetSuffix(path), stream, tvec, NULL);
+
+        return;
+    } else if (stripped == "/system/mutex_profile") {
+        // Lock contention counters; empty unless built with
+        // --enable-mutexprofile
+        SharedTrackerElement mvec(new TrackerElement(TrackerVector, 0));
+        TrackerElementVector mv(mvec);
+
+        char addr[32];
+
+        for (auto m : kis_mutex_profile_snapshot()) {
+            SharedTrackerElement me(new TrackerElement(TrackerMap, mutex_entry_id));
+
+            SharedTrackerElement name(new TrackerElement(TrackerString, mutex_name_id));
+            name->set(m.name);
+            me->add_map(name);
+
+            snprintf(addr, sizeof(addr), "%p", m.address);
+            SharedTrackerElement address(new TrackerElement(TrackerString, mutex_address_id));
+            address->set(std::string(addr));
+            me->add_map(address);
+
+            SharedTrackerElement acq(new TrackerElement(TrackerUInt64, mutex_acquisitions_id));
+            acq->set(m.acquisitions);
+            me->add_map(acq);
+
+            SharedTrackerElement cont(new TrackerElement(TrackerUInt64, mutex_contentions_id));
+            cont->set(m.contentions);
+            me->add_map(cont);
+
+            SharedTrackerElement wait(new TrackerElement(TrackerUInt64, mutex_wait_id));
+            wait->set(m.wait_usec);
+            me->add_map(wait);
+
+            SharedTrackerElement hold(new TrackerElement(TrackerUInt64, mutex_hold_id));
+            hold->set(m.hold_usec);
+            me->add_map(hold);
+
+            SharedTrackerElement maxhold(new TrackerElement(TrackerUInt64, mutex_max_hold_id));
+            maxhold->set(m.max_hold_usec);
+            me->add_map(maxhold);
+
+            mv.push_back(me);
+        }
+
+        entrytracker->Serialize(httpd->GetSuffix(path), stream, mvec, NULL);
+
         return;
     } else {
         return;
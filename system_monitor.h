@@ -23,6 +23,7 @@
 
 #include <string>
 
+#include "battery.h"
 #include "kis_mutex.h"
 #include "trackedelement.h"
 #include "timetracker.h"
@@ -30,6 +31,8 @@
 #include "devicetracker.h"
 #include "kis_net_microhttpd.h"
 
+class PerfCounterRegistry;
+
 class Systemmonitor : public tracker_component, public Kis_Net_Httpd_CPPStream_Handler,
     public LifetimeGlobal, public TimetrackerEvent {
 public:
@@ -66,6 +69,12 @@ public:
     __Proxy(memory, uint64_t, uint64_t, uint64_t, memory);
     __Proxy(devices, uint64_t, uint64_t, uint64_t, devices);
 
+    __Proxy(pool_reserved, uint64_t, uint64_t, uint64_t, pool_reserved);
+    __Proxy(pool_committed, uint64_t, uint64_t, uint64_t, pool_committed);
+    __Proxy(pool_outstanding, uint64_t, uint64_t, uint64_t, pool_outstanding);
+    __Proxy(pool_fallbacks, uint64_t, uint64_t, uint64_t, pool_fallbacks);
+    __Proxy(pool_hugepages, uint8_t, bool, bool, pool_hugepages);
+
     __Proxy(username, std::string, std::string, std::string, username);
 
     __Proxy(server_uuid, uuid, uuid, uuid, server_uuid);
@@ -94,6 +103,15 @@ protected:
     SharedTrackerElement timestamp_usec;
     SharedTrackerElement timestamp_start_sec;
     SharedTrackerElement memory;
+
+    // Preallocated memory pool occupancy, sampled each monitor tick when
+    // the pool is active
+    SharedTrackerElement pool_reserved;
+    SharedTrackerElement pool_committed;
+    SharedTrackerElement pool_outstanding;
+    SharedTrackerElement pool_fallbacks;
+    SharedTrackerElement pool_hugepages;
+
     SharedTrackerElement username;
     SharedTrackerElement server_uuid;
     SharedTrackerElement server_name;
@@ -109,6 +127,47 @@ protected:
     int devices_rrd_id;
     std::shared_ptr<kis_tracked_rrd<kis_tracked_rrd_extreme_aggregator> > devices_rrd;
 
+    // Engine health counters published by other subsystems through the
+    // perf counter registry; sampled once a second into per-counter RRDs
+    // and serialized as part of the system status record
+    SharedTrackerElement counter_vec;
+    int counter_entry_id, counter_name_id, counter_desc_id;
+    int counter_type_id, counter_value_id, counter_rrd_id;
+
+    // Thread inventory serialization ids
+    int thread_entry_id, thread_name_id, thread_class_id;
+    int thread_cpus_id, thread_tid_id;
+
+    // Mutex profile fields; populated only on instrumented builds
+    int mutex_entry_id, mutex_name_id, mutex_address_id;
+    int mutex_acquisitions_id, mutex_contentions_id;
+    int mutex_wait_id, mutex_hold_id, mutex_max_hold_id;
+
+    struct sampled_counter {
+        SharedTrackerElement entry;
+        SharedTrackerElement value;
+        std::shared_ptr<kis_tracked_rrd<kis_tracked_rrd_extreme_aggregator> > rrd;
+    };
+
+    std::map<std::string, sampled_counter> counter_state;
+
+    void sample_perf_counters();
+
+    // Serialized JSON form of the full status record, regenerated at the
+    // end of every monitor tick and swapped with
+    // std::atomic_load/atomic_store.  The common status poll streams this
+    // snapshot without ever taking monitor_mutex, so hammering
+    // /system/status during an overload can't pile up behind the sampling
+    // timer; non-json serializers fall back to the locked path.
+    std::shared_ptr<const std::string> status_json;
+
+    // Battery state sampled by the monitor tick on a short TTL; battery
+    // levels move slowly, so serializers read this cached copy instead of
+    // walking sysfs, keeping every status render purely in-memory
+    static const time_t battery_cache_ttl = 5;
+    kis_battery_info cached_battery;
+    time_t battery_sample_time;
+
     long mem_per_page;
 };
 
@@ -17,6 +17,10 @@
 */
 
 #include "config.h"
+
+#include <netinet/tcp.h>
+#include <sys/uio.h>
+
 #include "tcpserver2.h"
 #include "ringbuf2.h"
 
@@ -166,8 +170,13 @@ int TcpServerV2::Poll(fd_set& in_rset, fd_set& in_wset) {
     int ret, iret;
     size_t len;
     unsigned char *buf;
+    unsigned char *seg_b;
+    size_t len_a, len_b;
     ssize_t r_sz;
 
+    struct iovec iov[2];
+    int iovcnt;
+
     if (!valid)
         return -1;
 
@@ -209,16 +218,36 @@ int TcpServerV2::Poll(fd_set& in_rset, fd_set& in_wset) {
         if (FD_ISSET(i->first, &in_rset)) {
 
             while (i->second->GetReadBufferAvailable() > 0) {
-                // Read only as much as we can get w/ a direct reference
-                r_sz = i->second->ZeroCopyReserveReadBufferData((void **) &buf, 
-                        i->second->GetReadBufferAvailable());
+                // Reserve the entire free space of the ring, both sides of
+                // the wrap, and fill it with one readv; the socket is
+                // nonblocking so this never waits
+                r_sz = i->second->ZeroCopyReserveReadBufferVector((void **) &buf, &len_a,
+                        (void **) &seg_b, &len_b, i->second->GetReadBufferAvailable());
 
                 if (r_sz < 0) {
                     break;
                 }
 
+                iovcnt = 0;
 
-                ret = recv(i->first, buf, r_sz, MSG_DONTWAIT);
+                if (len_a > 0) {
+                    iov[iovcnt].iov_base = buf;
+                    iov[iovcnt].iov_len = len_a;
+                    iovcnt++;
+                }
+
+                if (len_b > 0) {
+                    iov[iovcnt].iov_base = seg_b;
+                    iov[iovcnt].iov_len = len_b;
+                    iovcnt++;
+                }
+
+                if (iovcnt == 0) {
+                    i->second->CommitReadBufferData(buf, 0);
+                    break;
+                }
+
+                ret = readv(i->first, iov, iovcnt);
 
                 if (ret < 0) {
                     if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
@@ -268,11 +297,28 @@ int TcpServerV2::Poll(fd_set& in_rset, fd_set& in_wset) {
         }
 
         if (FD_ISSET(i->first, &in_wset)) {
-            len = i->second->ZeroCopyPeekWriteBufferData((void **) &buf, 
-                    i->second->GetWriteBufferUsed());
+            // Peek both sides of the ring wrap and hand them to the kernel
+            // in a single writev; the socket is nonblocking so this never
+            // waits
+            len = i->second->ZeroCopyPeekWriteBufferVector((void **) &buf, &len_a,
+                    (void **) &seg_b, &len_b, i->second->GetWriteBufferUsed());
 
             if (len > 0) {
-                ret = send(i->first, buf, len, MSG_DONTWAIT);
+                iovcnt = 0;
+
+                if (len_a > 0) {
+                    iov[iovcnt].iov_base = buf;
+                    iov[iovcnt].iov_len = len_a;
+                    iovcnt++;
+                }
+
+                if (len_b > 0) {
+                    iov[iovcnt].iov_base = seg_b;
+                    iov[iovcnt].iov_len = len_b;
+                    iovcnt++;
+                }
+
+                ret = writev(i->first, iov, iovcnt);
 
                 if (ret < 0) {
                     if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
@@ -300,6 +346,9 @@ int TcpServerV2::Poll(fd_set& in_rset, fd_set& in_wset) {
                     i->second->PeekFreeWriteBufferData(buf);
                     i->second->ConsumeWriteBufferData(ret);
                 }
+            } else {
+                // Nothing pending after all; release the peek
+                i->second->PeekFreeWriteBufferData(buf);
             }
         }
     }
@@ -387,6 +436,11 @@ int TcpServerV2::AcceptConnection() {
     // Nonblocking, don't clone
     fcntl(new_fd, F_SETFL, fcntl(new_fd, F_GETFL, 0) | O_NONBLOCK);
 
+    // Disable nagle; we write whole frames via writev and buffering them
+    // in the kernel just adds latency to remote capture
+    int nodelay = 1;
+    setsockopt(new_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
     // Return the new fd; it is validated elsewhere and the buffer and handler
     // is made for it elsewhere
     return new_fd;
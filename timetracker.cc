@@ -22,6 +22,8 @@
 
 #include "timetracker.h"
 
+std::atomic<time_t> Timetracker::cached_time_sec(0);
+
 Timetracker::Timetracker(GlobalRegistry *in_globalreg) {
     globalreg = in_globalreg;
 
@@ -29,6 +31,15 @@ Timetracker::Timetracker(GlobalRegistry *in_globalreg) {
 
 	globalreg->start_time = time(0);
 	gettimeofday(&(globalreg->timestamp), NULL);
+
+    cached_time_sec.store(globalreg->timestamp.tv_sec, std::memory_order_relaxed);
+
+    // Align the wheel position to the current time
+    uint64_t now_usec = (uint64_t) globalreg->timestamp.tv_sec * 1000000ULL +
+        globalreg->timestamp.tv_usec;
+    wheel_pos_usec = now_usec - (now_usec % timer_wheel_res_usec);
+    wheel_cur_slot = (unsigned int) (wheel_pos_usec / timer_wheel_res_usec) % timer_wheel_slots;
+    wheel_count = 0;
 }
 
 Timetracker::~Timetracker() {
@@ -44,8 +55,6 @@ Timetracker::~Timetracker() {
 }
 
 int Timetracker::Tick() {
-    std::vector<timer_event *> action_timers;
-
     local_demand_locker lock(&time_mutex);
 
     lock.lock();
@@ -55,23 +64,101 @@ int Timetracker::Tick() {
     gettimeofday(&cur_tm, NULL);
 	globalreg->timestamp.tv_sec = cur_tm.tv_sec;
 	globalreg->timestamp.tv_usec = cur_tm.tv_usec;
+
+    // Refresh the published coarse clock for the hot paths
+    cached_time_sec.store(cur_tm.tv_sec, std::memory_order_relaxed);
+
     timer_event *evt;
     int timerid;
 
-    std::vector<int> removed_timers;
+    // Advance the high-resolution wheel first so hop-cadence timers never
+    // queue behind heap callbacks.  Every crossed slot is drained into a
+    // single batched expiry list before any callback runs
+    if (wheel_count > 0) {
+        uint64_t now_usec = (uint64_t) cur_tm.tv_sec * 1000000ULL + cur_tm.tv_usec;
+
+        // Batch by id, not pointer; an event in the drain batch is no
+        // longer in its wheel slot, so RemoveTimer can delete it while an
+        // earlier callback runs with the lock released.  Each id is
+        // re-resolved through timer_map under the lock before the event
+        // is touched
+        std::vector<int> due;
+
+        while (wheel_pos_usec + timer_wheel_res_usec <= now_usec) {
+            wheel_pos_usec += timer_wheel_res_usec;
+            wheel_cur_slot = (wheel_cur_slot + 1) % timer_wheel_slots;
+
+            std::vector<timer_event *>& slot = wheel_slots[wheel_cur_slot];
+
+            while (slot.size() > 0) {
+                due.push_back(slot.back()->timer_id);
+                slot.pop_back();
+                wheel_count--;
+            }
+        }
+
+        for (unsigned int x = 0; x < due.size(); x++) {
+            auto dmi = timer_map.find(due[x]);
+
+            // Removed while an earlier due callback ran
+            if (dmi == timer_map.end())
+                continue;
+
+            evt = dmi->second;
+            timerid = evt->timer_id;
+
+            lock.unlock();
+
+            int ret = 0;
+            if (evt->callback != NULL) {
+                ret = (*evt->callback)(evt, evt->callback_parm, globalreg);
+            } else if (evt->event != NULL) {
+                ret = evt->event->timetracker_event(evt->timer_id);
+            } else if (evt->event_func != NULL) {
+                ret = evt->event_func(evt->timer_id);
+            }
+
+            lock.lock();
+
+            // Removed (or removed itself) while the callback ran
+            if (timer_map.find(timerid) == timer_map.end())
+                continue;
 
-    for (unsigned int x = 0; x < sorted_timers.size(); x++) {
-        evt = sorted_timers[x];
+            if (ret > 0 && evt->recurring) {
+                // Anchor to the previous deadline to keep the cadence
+                // stable; if we fell behind (or the new deadline lands
+                // inside the already-drained current slot, which wouldn't
+                // be visited again for a full lap), skip the missed beats
+                // instead of firing them back to back
+                evt->wheel_deadline_usec += evt->wheel_period_usec;
+
+                if (evt->wheel_deadline_usec < wheel_pos_usec + timer_wheel_res_usec)
+                    evt->wheel_deadline_usec = now_usec + evt->wheel_period_usec;
+
+                WheelInsert_nb(evt);
+            } else {
+                timer_map.erase(timerid);
+                delete evt;
+            }
+        }
+    }
+
+    // Pop events off the heap until the soonest pending one isn't due;
+    // events which aren't due never get looked at
+    while (sorted_timers.size() > 0) {
+        evt = sorted_timers.front();
         timerid = evt->timer_id;
 
         if ((cur_tm.tv_sec < evt->trigger_tm.tv_sec) ||
-            ((cur_tm.tv_sec == evt->trigger_tm.tv_sec) && 
+            ((cur_tm.tv_sec == evt->trigger_tm.tv_sec) &&
 			 (cur_tm.tv_usec < evt->trigger_tm.tv_usec))) {
-
-            lock.unlock();
             break;
 		}
 
+        std::pop_heap(sorted_timers.begin(), sorted_timers.end(),
+                HeapTimerEventsTrigger());
+        sorted_timers.pop_back();
+
         lock.unlock();
 
         // Call the function with the given parameters
@@ -84,12 +171,19 @@ int Timetracker::Tick() {
             ret = evt->event_func(evt->timer_id);
         }
 
+        lock.lock();
+
+        // If the event removed itself (or was removed) while the callback
+        // ran the record is already gone; don't touch it again
+        if (timer_map.find(timerid) == timer_map.end())
+            continue;
+
         if (ret > 0 && evt->timeslices != -1 && evt->recurring) {
             evt->schedule_tm.tv_sec = cur_tm.tv_sec;
             evt->schedule_tm.tv_usec = cur_tm.tv_usec;
-            evt->trigger_tm.tv_sec = evt->schedule_tm.tv_sec + 
+            evt->trigger_tm.tv_sec = evt->schedule_tm.tv_sec +
                 (evt->timeslices / SERVER_TIMESLICES_SEC);
-            evt->trigger_tm.tv_usec = evt->schedule_tm.tv_usec + 
+            evt->trigger_tm.tv_usec = evt->schedule_tm.tv_usec +
 				((evt->timeslices % SERVER_TIMESLICES_SEC) *
                  (1000000L / SERVER_TIMESLICES_SEC));
 
@@ -98,22 +192,105 @@ int Timetracker::Tick() {
                 evt->trigger_tm.tv_usec %= 1000000L;
             }
 
+            sorted_timers.push_back(evt);
+            std::push_heap(sorted_timers.begin(), sorted_timers.end(),
+                    HeapTimerEventsTrigger());
         } else {
-            removed_timers.push_back(timerid);
+            // Already popped off the heap; drop the map record and free it
+            timer_map.erase(timerid);
+            delete evt;
         }
+    }
+
+    lock.unlock();
+
+    return 1;
+}
 
-        for (auto x : removed_timers) {
-            RemoveTimer_nb(x);
+void Timetracker::WheelInsert_nb(timer_event *evt) {
+    unsigned int slot = (unsigned int)
+        (evt->wheel_deadline_usec / timer_wheel_res_usec) % timer_wheel_slots;
+
+    wheel_slots[slot].push_back(evt);
+    wheel_count++;
+
+    // Keep the heap-style trigger time in sync for anything inspecting
+    // the record
+    evt->trigger_tm.tv_sec = evt->wheel_deadline_usec / 1000000ULL;
+    evt->trigger_tm.tv_usec = evt->wheel_deadline_usec % 1000000ULL;
+}
+
+bool Timetracker::WheelSchedule_nb(timer_event *evt) {
+    evt->on_wheel = 0;
+    evt->wheel_period_usec = 0;
+    evt->wheel_deadline_usec = 0;
+
+    // Only sub-second recurring slice timers go on the wheel; everything
+    // else belongs on the heap
+    if (evt->timeslices <= 0 || evt->timeslices >= SERVER_TIMESLICES_SEC ||
+            !evt->recurring)
+        return false;
+
+    evt->on_wheel = 1;
+    evt->wheel_period_usec = (uint64_t) evt->timeslices *
+        (1000000ULL / SERVER_TIMESLICES_SEC);
+    evt->wheel_deadline_usec = (uint64_t) evt->schedule_tm.tv_sec * 1000000ULL +
+        evt->schedule_tm.tv_usec + evt->wheel_period_usec;
+
+    WheelInsert_nb(evt);
+
+    return true;
+}
+
+int64_t Timetracker::UsecToNextEvent(int64_t in_max_usec) {
+    local_locker lock(&time_mutex);
+
+    if (sorted_timers.size() == 0 && wheel_count == 0)
+        return in_max_usec;
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    int64_t delta = in_max_usec;
+
+    if (sorted_timers.size() > 0) {
+        timer_event *evt = sorted_timers.front();
+
+        int64_t heap_delta =
+            ((int64_t) evt->trigger_tm.tv_sec - (int64_t) now.tv_sec) * 1000000L +
+            ((int64_t) evt->trigger_tm.tv_usec - (int64_t) now.tv_usec);
+
+        if (heap_delta < delta)
+            delta = heap_delta;
+    }
+
+    if (wheel_count > 0) {
+        // Small population; find the soonest wheel deadline directly
+        uint64_t now_usec = (uint64_t) now.tv_sec * 1000000ULL + now.tv_usec;
+        uint64_t soonest = 0;
+        bool found = false;
+
+        for (unsigned int s = 0; s < timer_wheel_slots; s++) {
+            for (unsigned int x = 0; x < wheel_slots[s].size(); x++) {
+                if (!found || wheel_slots[s][x]->wheel_deadline_usec < soonest) {
+                    soonest = wheel_slots[s][x]->wheel_deadline_usec;
+                    found = true;
+                }
+            }
         }
 
-        // Re-sort the list
-        lock.lock();
-        stable_sort(sorted_timers.begin(), sorted_timers.end(), 
-                SortTimerEventsTrigger());
-        lock.unlock();
+        if (found) {
+            int64_t wheel_delta = (int64_t) soonest - (int64_t) now_usec;
+
+            if (wheel_delta < delta)
+                delta = wheel_delta;
+        }
     }
 
-    return 1;
+    if (delta < 0)
+        return 0;
+
+    return delta;
 }
 
 int Timetracker::RegisterTimer(int in_timeslices, struct timeval *in_trigger,
@@ -150,10 +327,12 @@ int Timetracker::RegisterTimer_nb(int in_timeslices, struct timeval *in_trigger,
     evt->event = NULL;
 
     timer_map[evt->timer_id] = evt;
-    sorted_timers.push_back(evt);
 
-    // Resort the list
-    stable_sort(sorted_timers.begin(), sorted_timers.end(), SortTimerEventsTrigger());
+    if (!WheelSchedule_nb(evt)) {
+        sorted_timers.push_back(evt);
+        std::push_heap(sorted_timers.begin(), sorted_timers.end(),
+                HeapTimerEventsTrigger());
+    }
 
     return evt->timer_id;
 }
@@ -196,10 +375,12 @@ int Timetracker::RegisterTimer_nb(int in_timeslices, struct timeval *in_trigger,
     evt->event = in_event;
 
     timer_map[evt->timer_id] = evt;
-    sorted_timers.push_back(evt);
 
-    // Resort the list
-    stable_sort(sorted_timers.begin(), sorted_timers.end(), SortTimerEventsTrigger());
+    if (!WheelSchedule_nb(evt)) {
+        sorted_timers.push_back(evt);
+        std::push_heap(sorted_timers.begin(), sorted_timers.end(),
+                HeapTimerEventsTrigger());
+    }
 
     return evt->timer_id;
 }
@@ -243,10 +424,12 @@ int Timetracker::RegisterTimer_nb(int in_timeslices, struct timeval *in_trigger,
     evt->event_func = in_event;
 
     timer_map[evt->timer_id] = evt;
-    sorted_timers.push_back(evt);
 
-    // Resort the list
-    stable_sort(sorted_timers.begin(), sorted_timers.end(), SortTimerEventsTrigger());
+    if (!WheelSchedule_nb(evt)) {
+        sorted_timers.push_back(evt);
+        std::push_heap(sorted_timers.begin(), sorted_timers.end(),
+                HeapTimerEventsTrigger());
+    }
 
     return evt->timer_id;
 }
@@ -262,9 +445,29 @@ int Timetracker::RemoveTimer_nb(int in_timerid) {
     itr = timer_map.find(in_timerid);
 
     if (itr != timer_map.end()) {
+        bool heap_dirty = false;
+
+        if (itr->second->on_wheel) {
+            for (unsigned int s = 0; s < timer_wheel_slots; s++) {
+                for (unsigned int x = 0; x < wheel_slots[s].size(); x++) {
+                    if (wheel_slots[s][x]->timer_id == in_timerid) {
+                        wheel_slots[s].erase(wheel_slots[s].begin() + x);
+                        wheel_count--;
+                        break;
+                    }
+                }
+            }
+
+            delete itr->second;
+            timer_map.erase(itr);
+
+            return 1;
+        }
+
         for (unsigned int x = 0; x < sorted_timers.size(); x++) {
             if (sorted_timers[x]->timer_id == in_timerid) {
                 sorted_timers.erase(sorted_timers.begin() + x);
+                heap_dirty = true;
                 break;
             }
         }
@@ -272,8 +475,10 @@ int Timetracker::RemoveTimer_nb(int in_timerid) {
         delete itr->second;
         timer_map.erase(itr);
 
-        // Resort the list
-        stable_sort(sorted_timers.begin(), sorted_timers.end(), SortTimerEventsTrigger());
+        // Pulling an arbitrary record breaks the heap shape; rebuild it
+        if (heap_dirty)
+            std::make_heap(sorted_timers.begin(), sorted_timers.end(),
+                    HeapTimerEventsTrigger());
 
         return 1;
     }
@@ -29,6 +29,7 @@
 #include <algorithm>
 #include <string>
 
+#include <atomic>
 #include <functional>
 
 #include "globalregistry.h"
@@ -57,6 +58,14 @@ public:
         // Event is rescheduled again once it expires, if it's a timesliced event
         int recurring;
 
+        // Sub-second recurring events live on the high-resolution wheel
+        // instead of the heap; deadlines are tracked in absolute usec and
+        // rescheduling anchors to the previous deadline, not the time the
+        // tick happened to run, so cadence doesn't drift under load
+        int on_wheel;
+        uint64_t wheel_period_usec;
+        uint64_t wheel_deadline_usec;
+
         // Event, if we were passed a class
         TimetrackerEvent *event;
 
@@ -71,10 +80,10 @@ public:
     // Sort alerts by alert trigger time
     class SortTimerEventsTrigger {
     public:
-        inline bool operator() (const Timetracker::timer_event *x, 
+        inline bool operator() (const Timetracker::timer_event *x,
 								const Timetracker::timer_event *y) const {
             if ((x->trigger_tm.tv_sec < y->trigger_tm.tv_sec) ||
-                ((x->trigger_tm.tv_sec == y->trigger_tm.tv_sec) && 
+                ((x->trigger_tm.tv_sec == y->trigger_tm.tv_sec) &&
 				 (x->trigger_tm.tv_usec < y->trigger_tm.tv_usec)))
                 return 1;
 
@@ -82,6 +91,17 @@ public:
         }
     };
 
+    // Heap ordering for the timer vector; the std:: heap primitives build
+    // a max-heap from a 'less' comparison, so invert the trigger sort to
+    // keep the soonest event at the front
+    class HeapTimerEventsTrigger {
+    public:
+        inline bool operator() (const Timetracker::timer_event *x,
+                                const Timetracker::timer_event *y) const {
+            return SortTimerEventsTrigger()(y, x);
+        }
+    };
+
     static std::shared_ptr<Timetracker> create_timetracker(GlobalRegistry *in_globalreg) {
         std::shared_ptr<Timetracker> mon(new Timetracker(in_globalreg));
         in_globalreg->timetracker = mon.get();
@@ -98,6 +118,14 @@ public:
     // Tick and handle timers
     int Tick();
 
+    // Coarse cached time, refreshed at the start of every tick; the packet
+    // chain, RRD updates, and device commit paths read this instead of
+    // making their own clock call per packet.  Resolution is one server
+    // timeslice, which is plenty for second-granularity accounting.
+    static time_t GetCachedTime() {
+        return cached_time_sec.load(std::memory_order_relaxed);
+    }
+
     // Register an optionally recurring timer.  Slices are 1/100th of a second,
     // the smallest linux can slice without getting into weird calls.
     int RegisterTimer(int in_timeslices, struct timeval *in_trigger,
@@ -114,6 +142,11 @@ public:
     // Remove a timer that's going to execute
     int RemoveTimer(int timer_id);
 
+    // Microseconds until the soonest pending timer fires, clamped to
+    // [0, in_max_usec]; lets the main loop sleep until the next deadline
+    // instead of waking on a fixed cadence
+    int64_t UsecToNextEvent(int64_t in_max_usec);
+
 protected:
     GlobalRegistry *globalreg;
 
@@ -132,7 +165,35 @@ protected:
 
     int next_timer_id;
     std::map<int, timer_event *> timer_map;
+
+    // Min-heap of pending events ordered by trigger time; each tick pops
+    // only the due events instead of rescanning a sorted list
     std::vector<timer_event *> sorted_timers;
+
+    // High-resolution wheel, the fine level above the heap: sub-second
+    // recurring timers (channel hop cadences) are slotted by deadline at
+    // 10ms resolution, every crossed slot is drained into one batched
+    // expiry pass per tick, and rescheduling adds the period to the old
+    // deadline so a late tick doesn't permanently shift the cadence.
+    // One lap of the wheel (1.28s) covers every sub-second period.
+    static const unsigned int timer_wheel_slots = 128;
+    static const uint64_t timer_wheel_res_usec = 10000;
+
+    std::vector<timer_event *> wheel_slots[timer_wheel_slots];
+    unsigned int wheel_cur_slot;
+    uint64_t wheel_pos_usec;
+    unsigned int wheel_count;
+
+    // Route a slice timer onto the wheel if it's sub-second and recurring;
+    // false if it belongs on the heap.  Caller must hold time_mutex
+    bool WheelSchedule_nb(timer_event *evt);
+
+    // Slot an event by its absolute deadline; caller must hold time_mutex
+    void WheelInsert_nb(timer_event *evt);
+
+    // Published coarse clock; static so hot paths don't need to chase the
+    // globalreg to read it
+    static std::atomic<time_t> cached_time_sec;
 };
 
 class TimetrackerEvent {
@@ -342,116 +342,144 @@ void kis_location_history::reserve_fields(SharedTrackerElement e) {
 
     samples_100_cascade = 0;
     samples_10k_cascade = 0;
+
+    // If we were built over a stored record, import the history into the
+    // packed rings
+    if (e != NULL) {
+        import_sample_vec(samples_100_vec, samples_100_pod);
+        import_sample_vec(samples_10k_vec, samples_10k_pod);
+        import_sample_vec(samples_1m_vec, samples_1m_pod);
+    }
 }
 
-void kis_location_history::add_sample(std::shared_ptr<kis_historic_location> in_sample) {
-    set_int_last_sample_ts(in_sample->get_time_sec());
+void kis_location_history::pre_serialize() {
+    tracker_component::pre_serialize();
 
-    samples_100_vec.push_back(in_sample);
+    materialize_sample_vec(samples_100_pod, samples_100_vec);
+    materialize_sample_vec(samples_10k_pod, samples_10k_vec);
+    materialize_sample_vec(samples_1m_pod, samples_1m_vec);
+}
 
-    if (samples_100_vec.size() > 100) 
-        samples_100_vec.erase(samples_100_vec.begin());
+void kis_location_history::materialize_sample_vec(
+        const std::vector<kis_historic_location_packed>& in_samples,
+        TrackerElementVector& out_vec) {
+    out_vec.clear();
 
-    samples_100_cascade++;
+    for (auto p : in_samples) {
+        std::shared_ptr<kis_historic_location> loc(new kis_historic_location(globalreg, 0));
 
-    // We've gotten 100 samples, cascade up to our next bucket
-    if (samples_100_cascade >= 100) {
-        double lat, lon, alt, heading, speed, signal, timesec, frequency;
-        double num_signal, num_alt;
+        loc->set_lat(p.unpack_lat());
+        loc->set_lon(p.unpack_lon());
+        loc->set_alt(p.alt);
+        loc->set_speed(p.speed);
+        loc->set_heading(p.heading);
+        loc->set_frequency(p.frequency);
+        loc->set_signal(p.signal);
+        loc->set_time_sec(p.time_sec);
 
-        lat = lon = alt = heading = speed = signal = timesec = frequency = 0;
-        num_signal = num_alt = 0;
+        out_vec.push_back(loc);
+    }
+}
 
-        for (auto g : samples_100_vec) {
-            std::shared_ptr<kis_historic_location> gl =
-                std::static_pointer_cast<kis_historic_location>(g);
+void kis_location_history::import_sample_vec(TrackerElementVector& in_vec,
+        std::vector<kis_historic_location_packed>& out_samples) {
+    for (auto g : in_vec) {
+        std::shared_ptr<kis_historic_location> gl(new kis_historic_location(globalreg, 0, g));
 
-            lat += gl->get_lat();
-            lon += gl->get_lon();
-            if (gl->get_alt()) {
-                alt += gl->get_alt();
-                num_alt++;
-            }
+        kis_historic_location_packed p;
+        p.pack(gl->get_lat(), gl->get_lon(), gl->get_alt(), gl->get_speed(),
+                gl->get_heading(), gl->get_frequency(), gl->get_signal(),
+                gl->get_time_sec());
 
-            heading += gl->get_heading();
-            speed += gl->get_speed();
+        out_samples.push_back(p);
+    }
+}
+
+kis_historic_location_packed kis_location_history::aggregate_samples(
+        const std::vector<kis_historic_location_packed>& in_samples) {
+    double lat, lon, alt, heading, speed, signal, timesec, frequency;
+    double num_signal, num_alt;
+
+    lat = lon = alt = heading = speed = signal = timesec = frequency = 0;
+    num_signal = num_alt = 0;
 
-            if (gl->get_signal() != 0) {
-                signal += gl->get_signal();
-                num_signal++;
-            }
+    for (auto p : in_samples) {
+        lat += p.unpack_lat();
+        lon += p.unpack_lon();
 
-            timesec += gl->get_time_sec();
-            frequency += gl->get_frequency();
+        if (p.alt != 0) {
+            alt += p.alt;
+            num_alt++;
         }
 
-        std::shared_ptr<kis_historic_location> aggloc(new kis_historic_location(globalreg, 0));
+        heading += p.heading;
+        speed += p.speed;
+
+        if (p.signal != 0) {
+            signal += p.signal;
+            num_signal++;
+        }
+
+        timesec += p.time_sec;
+        frequency += p.frequency;
+    }
 
-        aggloc->set_lat(lat / samples_100_vec.size());
-        aggloc->set_lon(lon / samples_100_vec.size());
-        if (!std::isnan(alt / num_alt))
-            aggloc->set_alt(alt / num_alt);
-        aggloc->set_heading(heading / samples_100_vec.size());
-        aggloc->set_speed(speed / samples_100_vec.size());
-        aggloc->set_signal(signal / num_signal);
-        aggloc->set_time_sec(timesec / samples_100_vec.size());
-        aggloc->set_frequency(frequency / samples_100_vec.size());
+    kis_historic_location_packed agg;
 
+    double agg_alt = 0;
+    if (num_alt != 0)
+        agg_alt = alt / num_alt;
+
+    double agg_signal = 0;
+    if (num_signal != 0)
+        agg_signal = signal / num_signal;
+
+    agg.pack(lat / in_samples.size(), lon / in_samples.size(), agg_alt,
+            speed / in_samples.size(), heading / in_samples.size(),
+            frequency / in_samples.size(), agg_signal,
+            timesec / in_samples.size());
+
+    return agg;
+}
+
+void kis_location_history::add_sample(const kis_historic_location_packed& in_sample) {
+    set_int_last_sample_ts((time_t) in_sample.time_sec);
+
+    // Decimate stationary fixes; a sample within epsilon of the last kept
+    // point adds no track detail
+    if (samples_100_pod.size() > 0) {
+        const kis_historic_location_packed& last = samples_100_pod.back();
+
+        if (abs(in_sample.lat - last.lat) < decimation_epsilon &&
+                abs(in_sample.lon - last.lon) < decimation_epsilon &&
+                fabs(in_sample.alt - last.alt) < 5)
+            return;
+    }
+
+    samples_100_pod.push_back(in_sample);
+
+    if (samples_100_pod.size() > 100)
+        samples_100_pod.erase(samples_100_pod.begin());
+
+    samples_100_cascade++;
+
+    // We've gotten 100 samples, cascade up to our next bucket
+    if (samples_100_cascade >= 100) {
         samples_100_cascade = 0;
 
-        samples_10k_vec.push_back(aggloc);
-        if (samples_10k_vec.size() > 100)
-            samples_10k_vec.erase(samples_10k_vec.begin());
+        samples_10k_pod.push_back(aggregate_samples(samples_100_pod));
+        if (samples_10k_pod.size() > 100)
+            samples_10k_pod.erase(samples_10k_pod.begin());
 
         samples_10k_cascade++;
 
+        // If we've gotten 100 samples in the 10k bucket, cascade up again
         if (samples_10k_cascade >= 100) {
-            // If we've gotten 100 samples in the 10k bucket, cascade up again
-            lat = lon = alt = heading = speed = signal = timesec = frequency = 0;
-            num_alt = num_signal = 0;
-
-            for (auto g : samples_10k_vec) {
-                std::shared_ptr<kis_historic_location> gl =
-                    std::static_pointer_cast<kis_historic_location>(g);
-
-                lat += gl->get_lat();
-                lon += gl->get_lon();
-                
-                if (gl->get_alt()) {
-                    alt += gl->get_alt();
-                    num_alt++;
-                }
-
-                heading += gl->get_heading();
-                speed += gl->get_speed();
-
-                if (gl->get_signal()) {
-                    signal += gl->get_signal();
-                    num_signal++;
-                }
-
-                timesec += gl->get_time_sec();
-                frequency += gl->get_frequency();
-            }
-
-            std::shared_ptr<kis_historic_location> 
-                aggloc10(new kis_historic_location(globalreg, 0));
-
-            aggloc10->set_lat(lat / samples_10k_vec.size());
-            aggloc10->set_lon(lon / samples_10k_vec.size());
-            if (!std::isnan(alt / num_alt))
-                    aggloc10->set_alt(alt / num_alt);
-            aggloc10->set_heading(heading / samples_10k_vec.size());
-            aggloc10->set_speed(speed / samples_10k_vec.size());
-            aggloc10->set_signal(signal / num_signal);
-            aggloc10->set_time_sec(timesec / samples_10k_vec.size());
-            aggloc10->set_frequency(timesec / samples_10k_vec.size());
-
             samples_10k_cascade = 0;
 
-            samples_1m_vec.push_back(aggloc10);
-            if (samples_1m_vec.size() > 100)
-                samples_1m_vec.erase(samples_1m_vec.begin());
+            samples_1m_pod.push_back(aggregate_samples(samples_10k_pod));
+            if (samples_1m_pod.size() > 100)
+                samples_1m_pod.erase(samples_1m_pod.begin());
         }
     }
 }
@@ -144,17 +144,55 @@ protected:
     SharedTrackerElement signal, frequency;
 };
 
+// Packed historic location fix.  The history rings keep these instead of
+// full tracked element trees - a fix packs into a few dozen bytes and is
+// only expanded into tracked form when the cloud is serialized.
+struct kis_historic_location_packed {
+    // Fixed-point lat/lon multiplier; ~0.1 meter of resolution
+    const static int precision = 1000000;
+
+    int32_t lat;
+    int32_t lon;
+    float alt;
+    float speed;
+    float heading;
+    float frequency;
+    int32_t signal;
+    uint32_t time_sec;
+
+    void pack(double in_lat, double in_lon, double in_alt, double in_speed,
+            double in_heading, double in_frequency, int32_t in_signal,
+            time_t in_time_sec) {
+        lat = (int32_t) (in_lat * precision);
+        lon = (int32_t) (in_lon * precision);
+        alt = in_alt;
+        speed = in_speed;
+        heading = in_heading;
+        frequency = in_frequency;
+        signal = in_signal;
+        time_sec = in_time_sec;
+    }
+
+    double unpack_lat() const { return (double) lat / precision; }
+    double unpack_lon() const { return (double) lon / precision; }
+};
+
 // rrd-ish historic location cloud of cascading precision
 // Collects a historical record about a device and then averages them to the next level
-// of precision
-class kis_location_history : public tracker_component { 
+// of precision.  Fixes are kept as packed records and only materialized into
+// tracked elements at serialization time; fixes within epsilon of the last
+// kept point are decimated away since they add no track detail.
+class kis_location_history : public tracker_component {
 public:
+    // Decimation epsilon, in fixed-point lat/lon units (~2 meters)
+    const static int decimation_epsilon = 20;
+
     kis_location_history(GlobalRegistry *in_globalreg, int in_id);
     kis_location_history(GlobalRegistry *in_globalreg, int in_id, SharedTrackerElement e);
 
     virtual SharedTrackerElement clone_type();
 
-    void add_sample(std::shared_ptr<kis_historic_location> in_sample);
+    void add_sample(const kis_historic_location_packed& in_sample);
 
     __ProxyPrivSplit(last_sample_ts, uint64_t, time_t, time_t, last_sample_ts);
 
@@ -162,6 +200,20 @@ protected:
     virtual void register_fields();
     virtual void reserve_fields(SharedTrackerElement e);
 
+    // Expand the packed rings into the tracked vectors for serialization
+    virtual void pre_serialize();
+
+    // Average a packed ring into a single packed record
+    kis_historic_location_packed aggregate_samples(
+            const std::vector<kis_historic_location_packed>& in_samples);
+
+    void materialize_sample_vec(
+            const std::vector<kis_historic_location_packed>& in_samples,
+            TrackerElementVector& out_vec);
+
+    void import_sample_vec(TrackerElementVector& in_vec,
+            std::vector<kis_historic_location_packed>& out_samples);
+
     SharedTrackerElement samples_100;
     SharedTrackerElement samples_10k;
     SharedTrackerElement samples_1m;
@@ -175,6 +227,11 @@ protected:
     TrackerElementVector samples_10k_vec;
     TrackerElementVector samples_1m_vec;
 
+    // Packed history rings; oldest record first
+    std::vector<kis_historic_location_packed> samples_100_pod;
+    std::vector<kis_historic_location_packed> samples_10k_pod;
+    std::vector<kis_historic_location_packed> samples_1m_pod;
+
 };
 
 #endif
@@ -53,16 +53,14 @@ public:
         return a + b;
     }
 
-    // Combine a vector for a higher-level record (seconds to minutes, minutes to 
-    // hours, and so on).
-    static int64_t combine_vector(std::shared_ptr<TrackerElement> e) {
-        TrackerElementVector v(e);
-
+    // Combine a bucket of samples for a higher-level record (seconds to
+    // minutes, minutes to hours, and so on).
+    static int64_t combine_vector(const int64_t *vals, size_t in_sz) {
         int64_t avg = 0;
-        for (TrackerElementVector::iterator i = v.begin(); i != v.end(); ++i) 
-            avg += GetTrackerValue<int64_t>(*i);
+        for (size_t x = 0; x < in_sz; x++)
+            avg += vals[x];
 
-        return avg / v.size();
+        return avg / (int64_t) in_sz;
     }
 
     // Default 'empty' value
@@ -110,9 +108,28 @@ public:
         update_first = in_upd;
     }
 
-    __Proxy(last_time, uint64_t, time_t, time_t, last_time);
+    // Samples live in the POD rings until serialization; the tracked
+    // last_time field is only touched when the record is exported
+    time_t get_last_time() {
+        return sample_last_time;
+    }
+
+    void set_last_time(time_t in_time) {
+        sample_last_time = in_time;
+    }
 
-    // Add a sample.  Use combinator function 'c' to derive the new sample value
+    // Aggregate the stored per-second samples for the past minute into a
+    // single value; this gives consumers a cheap recent-activity metric
+    // without serializing the whole RRD.  Callers should sanity-check
+    // get_last_time() themselves if they care about staleness.
+    int64_t combine_minute() {
+        Aggregator agg;
+        return agg.combine_vector(minute_samples, 60);
+    }
+
+    // Add a sample.  Use combinator function 'c' to derive the new sample
+    // value.  Samples land in the contiguous rings; no tracked elements
+    // are touched on the per-packet path.
     void add_sample(int64_t in_s, time_t in_time) {
         Aggregator agg;
 
@@ -120,7 +137,7 @@ public:
         int min_bucket = (in_time / 60) % 60;
         int hour_bucket = (in_time / 3600) % 24;
 
-        time_t ltime = get_last_time();
+        time_t ltime = sample_last_time;
 
         // The second slot for the last time
         int last_sec_bucket = ltime % 60;
@@ -133,87 +150,59 @@ public:
             // printf("debug - rrd - timewarp to the past?  discard\n");
             return;
         }
-        
-        std::shared_ptr<TrackerElement> e;
 
         // If we haven't seen data in a day, we reset everything because
         // none of it is valid.  This is the simplest case.
         if (in_time - ltime > (60 * 60 * 24)) {
             // Directly fill in this second, clear rest of the minute
-            TrackerElementVector mv(minute_vec);
-            for (TrackerElementVector::iterator i = mv.begin(); i != mv.end(); ++i) {
-                if (i - mv.begin() == sec_bucket)
-                    (*i)->set(in_s);
-                else
-                    (*i)->set((int64_t) agg.default_val());
-            }
+            for (int x = 0; x < 60; x++)
+                minute_samples[x] = agg.default_val();
+            minute_samples[sec_bucket] = in_s;
 
             // Reset the last hour, setting it to a single sample
             // Get the combined value for the minute
-            int64_t min_val = agg.combine_vector(minute_vec);
-            TrackerElementVector hv = TrackerElementVector(hour_vec);
-            for (TrackerElementVector::iterator i = hv.begin(); i != hv.end(); ++i) {
-                if (i - hv.begin() == min_bucket)
-                    (*i)->set(min_val);
-                else
-                    (*i)->set((int64_t) agg.default_val());
-            }
+            int64_t min_val = agg.combine_vector(minute_samples, 60);
+            for (int x = 0; x < 60; x++)
+                hour_samples[x] = agg.default_val();
+            hour_samples[min_bucket] = min_val;
 
             // Reset the last day, setting it to a single sample
-            int64_t hr_val = agg.combine_vector(hour_vec);
-            TrackerElementVector dv = TrackerElementVector(day_vec);
-            for (TrackerElementVector::iterator i = dv.begin(); i != dv.end(); ++i) {
-                if (i - dv.begin() == hour_bucket)
-                    (*i)->set(hr_val);
-                else
-                    (*i)->set((int64_t) agg.default_val());
-            }
+            int64_t hr_val = agg.combine_vector(hour_samples, 60);
+            for (int x = 0; x < 24; x++)
+                day_samples[x] = agg.default_val();
+            day_samples[hour_bucket] = hr_val;
 
-            set_last_time(in_time);
+            sample_last_time = in_time;
 
             return;
         } else if (in_time - ltime > (60*60)) {
-            // printf("debug - rrd - been an hour since last value\n");
             // If we haven't seen data in an hour but we're still w/in the day:
             //   - Average the seconds we know about & set the minute record
             //   - Clear seconds data & set our current value
             //   - Average the minutes we know about & set the hour record
-            //
-           
+
             int64_t sec_avg = 0, min_avg = 0;
 
-            // We only have this entry in the minute, so set it and get the 
+            // We only have this entry in the minute, so set it and get the
             // combined value
-            
-            TrackerElementVector mv(minute_vec);
-            for (TrackerElementVector::iterator i = mv.begin(); i != mv.end(); ++i) {
-                if (i - mv.begin() == sec_bucket)
-                    (*i)->set(in_s);
-                else
-                    (*i)->set((int64_t) agg.default_val());
-            }
-            sec_avg = agg.combine_vector(minute_vec);
+            for (int x = 0; x < 60; x++)
+                minute_samples[x] = agg.default_val();
+            minute_samples[sec_bucket] = in_s;
+            sec_avg = agg.combine_vector(minute_samples, 60);
 
             // We haven't seen anything in this hour, so clear it, set the minute
             // and get the aggregate
-            TrackerElementVector hv = TrackerElementVector(hour_vec);
-            for (TrackerElementVector::iterator i = hv.begin(); i != hv.end(); ++i) {
-                if (i - hv.begin() == min_bucket)
-                    (*i)->set(sec_avg);
-                else
-                    (*i)->set((int64_t) agg.default_val());
-            }
-            min_avg = agg.combine_vector(hour_vec);
+            for (int x = 0; x < 60; x++)
+                hour_samples[x] = agg.default_val();
+            hour_samples[min_bucket] = sec_avg;
+            min_avg = agg.combine_vector(hour_samples, 60);
 
             // Fill the hours between the last time we saw data and now with
             // zeroes; fastforward time
-            for (int h = 0; h < hours_different(last_hour_bucket + 1, hour_bucket); h++) {
-                e = hour_vec->get_vector_value((last_hour_bucket + 1 + h) % 24);
-                e->set((int64_t) agg.default_val());
-            }
+            for (int h = 0; h < hours_different(last_hour_bucket + 1, hour_bucket); h++)
+                day_samples[(last_hour_bucket + 1 + h) % 24] = agg.default_val();
 
-            e = day_vec->get_vector_value(hour_bucket);
-            e->set(min_avg);
+            day_samples[hour_bucket] = min_avg;
 
         } else if (in_time - ltime > 60) {
             // - Calculate the average seconds
@@ -221,85 +210,81 @@ public:
             // - Set the new second value
             // - Update minutes
             // - Update hours
-            // printf("debug - rrd - been over a minute since last value\n");
 
             int64_t sec_avg = 0, min_avg = 0;
 
-            TrackerElementVector mv(minute_vec);
-            for (TrackerElementVector::iterator i = mv.begin(); i != mv.end(); ++i) {
-                if (i - mv.begin() == sec_bucket)
-                    (*i)->set(in_s);
-                else
-                    (*i)->set((int64_t) agg.default_val());
-            }
-            sec_avg = agg.combine_vector(minute_vec);
+            for (int x = 0; x < 60; x++)
+                minute_samples[x] = agg.default_val();
+            minute_samples[sec_bucket] = in_s;
+            sec_avg = agg.combine_vector(minute_samples, 60);
 
             // Zero between last and current
-            for (int m = 0; 
-                    m < minutes_different(last_min_bucket + 1, min_bucket); m++) {
-                e = hour_vec->get_vector_value((last_min_bucket + 1 + m) % 60);
-                e->set((int64_t) agg.default_val());
-            }
+            for (int m = 0;
+                    m < minutes_different(last_min_bucket + 1, min_bucket); m++)
+                hour_samples[(last_min_bucket + 1 + m) % 60] = agg.default_val();
 
             // Set the updated value
-            e = hour_vec->get_vector_value(min_bucket);
-            e->set((int64_t) sec_avg);
+            hour_samples[min_bucket] = sec_avg;
 
-            min_avg = agg.combine_vector(hour_vec);
+            min_avg = agg.combine_vector(hour_samples, 60);
 
             // Reset the hour
-            e = day_vec->get_vector_value(hour_bucket);
-            e->set(min_avg);
+            day_samples[hour_bucket] = min_avg;
 
         } else {
-            // printf("debug - rrd - w/in the last minute %d seconds\n", in_time - last_time);
             // If in_time == last_time then we're updating an existing record,
             // use the aggregator class to combine it
-            
+
             // Otherwise, fast-forward seconds with zero data, then propagate the
             // changes up
             if (in_time == ltime) {
-                e = minute_vec->get_vector_value(sec_bucket);
-                e->set(agg.combine_element(GetTrackerValue<int64_t>(e), in_s));
+                minute_samples[sec_bucket] =
+                    agg.combine_element(minute_samples[sec_bucket], in_s);
             } else {
-                for (int s = 0; 
-                        s < minutes_different(last_sec_bucket + 1, sec_bucket); s++) {
-                    e = minute_vec->get_vector_value((last_sec_bucket + 1 + s) % 60);
-                    e->set((int64_t) agg.default_val());
-                }
-
-                e = minute_vec->get_vector_value(sec_bucket);
-                e->set((int64_t) in_s);
+                for (int s = 0;
+                        s < minutes_different(last_sec_bucket + 1, sec_bucket); s++)
+                    minute_samples[(last_sec_bucket + 1 + s) % 60] = agg.default_val();
+
+                minute_samples[sec_bucket] = in_s;
             }
 
             // Update all the averages
             int64_t sec_avg = 0, min_avg = 0;
 
-            sec_avg = agg.combine_vector(minute_vec);
+            sec_avg = agg.combine_vector(minute_samples, 60);
 
             // Set the minute
-            e = hour_vec->get_vector_value(min_bucket);
-            e->set(sec_avg);
+            hour_samples[min_bucket] = sec_avg;
 
-            min_avg = agg.combine_vector(hour_vec);
+            min_avg = agg.combine_vector(hour_samples, 60);
 
             // Set the hour
-            e = day_vec->get_vector_value(hour_bucket);
-            e->set(min_avg);
+            day_samples[hour_bucket] = min_avg;
         }
 
-        set_last_time(in_time);
+        sample_last_time = in_time;
     }
 
     virtual void pre_serialize() {
         tracker_component::pre_serialize();
         Aggregator agg;
 
-        // printf("debug - rrd - preserialize\n");
         // Update the averages
         if (update_first) {
             add_sample(agg.default_val(), globalreg->timestamp.tv_sec);
         }
+
+        // Materialize the rings into the tracked vectors for export
+        (*last_time).set((uint64_t) sample_last_time);
+
+        for (int x = 0; x < 60; x++)
+            minute_vec->get_vector_value(x)->set(minute_samples[x]);
+
+        for (int x = 0; x < 60; x++)
+            hour_vec->get_vector_value(x)->set(hour_samples[x]);
+
+        for (int x = 0; x < 24; x++)
+            day_vec->get_vector_value(x)->set(day_samples[x]);
     }
 
 protected:
@@ -391,6 +376,22 @@ protected:
             }
         }
 
+        // Import any stored sample history (restored devices) into the
+        // rings; fresh records import the zeroed slots built above
+        for (x = 0; x < 60; x++)
+            minute_samples[x] =
+                GetTrackerValue<int64_t>(minute_vec->get_vector_value(x));
+
+        for (x = 0; x < 60; x++)
+            hour_samples[x] =
+                GetTrackerValue<int64_t>(hour_vec->get_vector_value(x));
+
+        for (x = 0; x < 24; x++)
+            day_samples[x] =
+                GetTrackerValue<int64_t>(day_vec->get_vector_value(x));
+
+        sample_last_time = (time_t) GetTrackerValue<uint64_t>(last_time);
+
         Aggregator agg;
         (*blank_val).set(agg.default_val());
         (*aggregator_name).set(agg.name());
@@ -404,6 +405,15 @@ protected:
     SharedTrackerElement blank_val;
     SharedTrackerElement aggregator_name;
 
+    // Contiguous sample rings; one flat allocation per record instead of
+    // a tracked element per bucket.  The tracked vectors above hold the
+    // registered field definitions and are filled from the rings at
+    // serialization time.
+    int64_t minute_samples[60];
+    int64_t hour_samples[60];
+    int64_t day_samples[24];
+    time_t sample_last_time;
+
     int second_entry_id;
     int minute_entry_id;
     int hour_entry_id;
@@ -449,14 +459,20 @@ public:
         update_first = in_upd;
     }
 
-    __Proxy(last_time, uint64_t, time_t, time_t, last_time);
+    time_t get_last_time() {
+        return sample_last_time;
+    }
+
+    void set_last_time(time_t in_time) {
+        sample_last_time = in_time;
+    }
 
     void add_sample(int64_t in_s, time_t in_time) {
         Aggregator agg;
 
         int sec_bucket = in_time % 60;
 
-        time_t ltime = get_last_time();
+        time_t ltime = sample_last_time;
 
         // The second slot for the last time
         int last_sec_bucket = ltime % 60;
@@ -464,37 +480,30 @@ public:
         if (in_time < ltime) {
             return;
         }
-        
-        SharedTrackerElement e;
 
         // If we haven't seen data in a minute, wipe
         if (in_time - ltime > 60) {
-            for (int x = 0; x < 60; x++) {
-                e = minute_vec->get_vector_value(x);
-                e->set((int64_t) agg.default_val());
-            }
+            for (int x = 0; x < 60; x++)
+                minute_samples[x] = agg.default_val();
         } else {
             // If in_time == last_time then we're updating an existing record, so
             // add that in.
             // Otherwise, fast-forward seconds with zero data, average the seconds,
             // and propagate the averages up
             if (in_time == ltime) {
-                e = minute_vec->get_vector_value(sec_bucket);
-                e->set(agg.combine_element(GetTrackerValue<int64_t>(e), in_s));
+                minute_samples[sec_bucket] =
+                    agg.combine_element(minute_samples[sec_bucket], in_s);
             } else {
-                for (int s = 0; 
-                        s < minutes_different(last_sec_bucket + 1, sec_bucket); s++) {
-                    e = minute_vec->get_vector_value((last_sec_bucket + 1 + s) % 60);
-                    e->set((int64_t) agg.default_val());
-                }
-
-                e = minute_vec->get_vector_value(sec_bucket);
-                e->set((int64_t) in_s);
+                for (int s = 0;
+                        s < minutes_different(last_sec_bucket + 1, sec_bucket); s++)
+                    minute_samples[(last_sec_bucket + 1 + s) % 60] = agg.default_val();
+
+                minute_samples[sec_bucket] = in_s;
             }
         }
 
 
-        set_last_time(in_time);
+        sample_last_time = in_time;
     }
 
     virtual void pre_serialize() {
@@ -504,6 +513,12 @@ public:
         if (update_first) {
             add_sample(agg.default_val(), globalreg->timestamp.tv_sec);
         }
+
+        // Materialize the ring into the tracked vector for export
+        (*last_time).set((uint64_t) sample_last_time);
+
+        for (int x = 0; x < 60; x++)
+            minute_vec->get_vector_value(x)->set(minute_samples[x]);
     }
 
 protected:
@@ -551,6 +566,11 @@ protected:
             }
         }
 
+        // Import any stored sample history into the ring
+        for (x = 0; x < 60; x++)
+            minute_samples[x] =
+                GetTrackerValue<int64_t>(minute_vec->get_vector_value(x));
+
         Aggregator agg;
         (*blank_val).set(agg.default_val());
         (*aggregator_name).set(agg.name());
@@ -561,6 +581,11 @@ protected:
     SharedTrackerElement blank_val;
     SharedTrackerElement aggregator_name;
 
+    // Contiguous sample ring; filled into the tracked vector at
+    // serialization time
+    int64_t minute_samples[60];
+    time_t sample_last_time;
+
     int second_entry_id;
 
     bool update_first;
@@ -578,18 +603,14 @@ public:
     }
 
     // Select the strongest signal of the bucket
-    static int64_t combine_vector(SharedTrackerElement e) {
-        TrackerElementVector v(e);
-
+    static int64_t combine_vector(const int64_t *vals, size_t in_sz) {
         int64_t avg = 0, avgc = 0;
 
-        for (TrackerElementVector::iterator i = v.begin(); i != v.end(); ++i) {
-            int64_t v = GetTrackerValue<int64_t>(*i);
-
-            if (v == 0)
+        for (size_t x = 0; x < in_sz; x++) {
+            if (vals[x] == 0)
                 continue;
 
-            avg += v;
+            avg += vals[x];
             avgc++;
         }
 
@@ -597,18 +618,6 @@ public:
             return default_val();
 
         return avg / avgc;
-
-#if 0
-        int64_t max = 0;
-        for (TrackerElementVector::iterator i = v.begin(); i != v.end(); ++i) {
-            int64_t v = GetTrackerValue<int64_t>(*i);
-
-            if (max == 0 || max < v)
-                max = v;
-        }
-
-        return max;
-#endif
     }
 
     // Default 'empty' value, no legit signal would be 0
@@ -650,14 +659,12 @@ public:
     }
 
     // Simple average
-    static int64_t combine_vector(SharedTrackerElement e) {
-        TrackerElementVector v(e);
-
+    static int64_t combine_vector(const int64_t *vals, size_t in_sz) {
         int64_t avg = 0;
-        for (TrackerElementVector::iterator i = v.begin(); i != v.end(); ++i) 
-            avg += GetTrackerValue<int64_t>(*i);
+        for (size_t x = 0; x < in_sz; x++)
+            avg += vals[x];
 
-        return avg / v.size();
+        return avg / (int64_t) in_sz;
     }
 
     // Default 'empty' value, no legit signal would be 0
@@ -34,52 +34,96 @@
 TrackedDeviceKey::TrackedDeviceKey() {
     spkey = 0;
     dkey = 0;
+    hkey = mix_hash(spkey, dkey);
     error = true;
 }
 
 TrackedDeviceKey::TrackedDeviceKey(const TrackedDeviceKey& k) {
     spkey = k.spkey;
     dkey = k.dkey;
+    hkey = k.hkey;
     error = k.error;
 }
 
 TrackedDeviceKey::TrackedDeviceKey(uint64_t in_spkey, uint64_t in_dkey) {
     spkey = in_spkey;
     dkey = in_dkey;
+    hkey = mix_hash(spkey, dkey);
     error = false;
 }
 
 TrackedDeviceKey::TrackedDeviceKey(uint32_t in_skey, uint32_t in_pkey, uint64_t in_dkey) {
     spkey = (((uint64_t) in_skey) << 32) | in_pkey;
     dkey = in_dkey;
+    hkey = mix_hash(spkey, dkey);
     error = false;
 }
 
 TrackedDeviceKey::TrackedDeviceKey(uint32_t in_skey, uint32_t in_pkey, mac_addr in_device) {
     spkey = (((uint64_t) in_skey) << 32) | in_pkey;
     dkey = in_device.longmac;
+    hkey = mix_hash(spkey, dkey);
     error = false;
 }
 
 TrackedDeviceKey::TrackedDeviceKey(uint64_t in_spkey, mac_addr in_device) {
     spkey = in_spkey;
     dkey = in_device.longmac;
+    hkey = mix_hash(spkey, dkey);
     error = false;
 }
 
+// Parse a run of hex digits; advances the position and fails on anything
+// which isn't a digit.  Keys are parsed on every by-key REST hit, where
+// sscanf is measurably slower than walking the string.
+static bool parse_hex64(const std::string& s, size_t& pos, uint64_t *ret) {
+    uint64_t v = 0;
+    size_t digits = 0;
+
+    while (pos < s.length() && digits < 16) {
+        char c = s[pos];
+        uint64_t n;
+
+        if (c >= '0' && c <= '9')
+            n = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            n = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            n = c - 'A' + 10;
+        else
+            break;
+
+        v = (v << 4) | n;
+        pos++;
+        digits++;
+    }
+
+    if (digits == 0)
+        return false;
+
+    *ret = v;
+    return true;
+}
+
 TrackedDeviceKey::TrackedDeviceKey(std::string in_keystr) {
-    unsigned long long int k1, k2;
+    uint64_t k1, k2;
+    size_t pos = 0;
 
-    if (sscanf(in_keystr.c_str(), "%llx_%llx", &k1, &k2) != 2) {
+    if (!parse_hex64(in_keystr, pos, &k1) ||
+            pos >= in_keystr.length() || in_keystr[pos] != '_' ||
+            (++pos, !parse_hex64(in_keystr, pos, &k2)) ||
+            pos != in_keystr.length()) {
         error = true;
         spkey = 0;
         dkey = 0;
+        hkey = mix_hash(spkey, dkey);
         return;
     }
 
     // Convert from big endian exported format
     spkey = (uint64_t) kis_ntoh64(k1);
     dkey = (uint64_t) kis_ntoh64(k2);
+    hkey = mix_hash(spkey, dkey);
     error = false;
 }
 
@@ -121,9 +165,47 @@ std::ostream& operator<<(std::ostream& os, const TrackedDeviceKey& k) {
     return os;
 }
 
+std::mutex StringInternPool::pool_mutex;
+std::map<std::string, size_t> StringInternPool::pool;
+
+const std::string *StringInternPool::acquire(const std::string& s) {
+    std::lock_guard<std::mutex> lk(pool_mutex);
+
+    auto r = pool.emplace(s, (size_t) 0);
+    r.first->second++;
+
+    return &(r.first->first);
+}
+
+const std::string *StringInternPool::acquire(std::string&& s) {
+    std::lock_guard<std::mutex> lk(pool_mutex);
+
+    auto r = pool.emplace(std::move(s), (size_t) 0);
+    r.first->second++;
+
+    return &(r.first->first);
+}
+
+void StringInternPool::release(const std::string *s) {
+    if (s == NULL)
+        return;
+
+    std::lock_guard<std::mutex> lk(pool_mutex);
+
+    auto i = pool.find(*s);
+
+    if (i != pool.end() && --(i->second) == 0)
+        pool.erase(i);
+}
+
+std::atomic<uint64_t> TrackerElement::element_count(0);
+
 void TrackerElement::Initialize() {
+    element_count++;
+
     this->type = TrackerUnassigned;
     reference_count = 0;
+    element_generation = 1;
 
     set_id(-1);
 
@@ -170,6 +252,8 @@ TrackerElement::TrackerElement(TrackerType type, int id) {
 }
 
 TrackerElement::~TrackerElement() {
+    element_count--;
+
     // If we contain references to other things, unlink them.  This may cause them to
     // auto-delete themselves.
     if (type == TrackerVector) {
@@ -185,7 +269,7 @@ TrackerElement::~TrackerElement() {
     } else if (type == TrackerDoubleMap) {
         delete dataunion.subdoublemap_value;
     } else if (type == TrackerString) {
-        delete(dataunion.string_value);
+        StringInternPool::release(dataunion.string_value);
     } else if (type == TrackerMac) {
         delete(dataunion.mac_value);
     } else if (type == TrackerUuid) {
@@ -230,7 +314,7 @@ void TrackerElement::set_type(TrackerType in_type) {
         delete(dataunion.key_value);
         dataunion.key_value = NULL;
     } else if (type == TrackerString && dataunion.string_value != NULL) {
-        delete(dataunion.string_value);
+        StringInternPool::release(dataunion.string_value);
         dataunion.string_value = NULL;
     } else if (type == TrackerByteArray && dataunion.bytearray_value != NULL) {
         delete(dataunion.bytearray_value);
@@ -259,7 +343,7 @@ void TrackerElement::set_type(TrackerType in_type) {
     } else if (type == TrackerKey) {
         dataunion.key_value = new TrackedDeviceKey();
     } else if (type == TrackerString) {
-        dataunion.string_value = new std::string();
+        dataunion.string_value = StringInternPool::acquire(std::string());
     } else if (type == TrackerByteArray) {
         dataunion.bytearray_value = new std::shared_ptr<uint8_t>();
         bytearray_value_len = 0;
@@ -267,6 +351,8 @@ void TrackerElement::set_type(TrackerType in_type) {
 }
 
 TrackerElement& TrackerElement::operator++(int) {
+    bump_generation();
+
     switch (type) {
         case TrackerInt8:
             dataunion.int8_value++;
@@ -306,6 +392,8 @@ TrackerElement& TrackerElement::operator++(int) {
 }
 
 TrackerElement& TrackerElement::operator--(int) {
+    bump_generation();
+
     switch (type) {
         case TrackerInt8:
             dataunion.int8_value--;
@@ -345,6 +433,8 @@ TrackerElement& TrackerElement::operator--(int) {
 }
 
 TrackerElement& TrackerElement::operator+=(const float& v) {
+    bump_generation();
+
     switch (type) {
         case TrackerFloat:
             dataunion.float_value+= v;
@@ -360,6 +450,8 @@ TrackerElement& TrackerElement::operator+=(const float& v) {
 }
 
 TrackerElement& TrackerElement::operator+=(const double& v) {
+    bump_generation();
+
     switch (type) {
         case TrackerFloat:
             dataunion.float_value+= v;
@@ -375,6 +467,8 @@ TrackerElement& TrackerElement::operator+=(const double& v) {
 }
 
 TrackerElement& TrackerElement::operator+=(const int& v) {
+    bump_generation();
+
     switch (type) {
         case TrackerInt8:
             dataunion.int8_value += v;
@@ -414,6 +508,8 @@ TrackerElement& TrackerElement::operator+=(const int& v) {
 }
 
 TrackerElement& TrackerElement::operator+=(const unsigned int& v) {
+    bump_generation();
+
     switch (type) {
         case TrackerInt8:
             dataunion.int8_value += v;
@@ -453,18 +549,24 @@ TrackerElement& TrackerElement::operator+=(const unsigned int& v) {
 }
 
 TrackerElement& TrackerElement::operator+=(const int64_t& i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt64);
     dataunion.int64_value += i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator+=(const uint64_t& i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt64);
     dataunion.uint64_value += i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator-=(const int& v) {
+    bump_generation();
+
     switch (type) {
         case TrackerInt8:
             dataunion.int8_value -= v;
@@ -504,6 +606,8 @@ TrackerElement& TrackerElement::operator-=(const int& v) {
 }
 
 TrackerElement& TrackerElement::operator-=(const unsigned int& v) {
+    bump_generation();
+
     switch (type) {
         case TrackerInt8:
             dataunion.int8_value -= v;
@@ -543,6 +647,8 @@ TrackerElement& TrackerElement::operator-=(const unsigned int& v) {
 }
 
 TrackerElement& TrackerElement::operator-=(const float& v) {
+    bump_generation();
+
     switch (type) {
         case TrackerFloat:
             dataunion.float_value-= v;
@@ -558,6 +664,8 @@ TrackerElement& TrackerElement::operator-=(const float& v) {
 }
 
 TrackerElement& TrackerElement::operator-=(const double& v) {
+    bump_generation();
+
     switch (type) {
         case TrackerFloat:
             dataunion.float_value-= v;
@@ -573,12 +681,16 @@ TrackerElement& TrackerElement::operator-=(const double& v) {
 }
 
 TrackerElement& TrackerElement::operator-=(const int64_t& i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt64);
     dataunion.int64_value -= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator-=(const uint64_t& i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt64);
     dataunion.uint64_value -= i;
     return *this;
@@ -586,144 +698,192 @@ TrackerElement& TrackerElement::operator-=(const uint64_t& i) {
 
 
 TrackerElement& TrackerElement::operator|=(int8_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt8);
     dataunion.int8_value |= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator|=(uint8_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt8);
     dataunion.uint8_value |= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator|=(int16_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt16);
     dataunion.int16_value |= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator|=(uint16_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt16);
     dataunion.uint16_value |= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator|=(int32_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt32);
     dataunion.int32_value |= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator|=(uint32_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt32);
     dataunion.uint32_value |= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator|=(int64_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt64);
     dataunion.int64_value |= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator|=(uint64_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt64);
     dataunion.uint64_value |= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator&=(int8_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt8);
     dataunion.int8_value &= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator&=(uint8_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt8);
     dataunion.uint8_value &= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator&=(int16_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt16);
     dataunion.int16_value &= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator&=(uint16_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt16);
     dataunion.uint16_value &= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator&=(int32_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt32);
     dataunion.int32_value &= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator&=(uint32_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt32);
     dataunion.uint32_value &= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator&=(int64_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt64);
     dataunion.int64_value &= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator&=(uint64_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt64);
     dataunion.uint64_value &= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator^=(int8_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt8);
     dataunion.int8_value ^= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator^=(uint8_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt8);
     dataunion.uint8_value ^= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator^=(int16_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt16);
     dataunion.int16_value ^= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator^=(uint16_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt16);
     dataunion.uint16_value ^= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator^=(int32_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt32);
     dataunion.int32_value ^= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator^=(uint32_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt32);
     dataunion.uint32_value ^= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator^=(int64_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerInt64);
     dataunion.int64_value ^= i;
     return *this;
 }
 
 TrackerElement& TrackerElement::operator^=(uint64_t i) {
+    bump_generation();
+
     except_type_mismatch(TrackerUInt64);
     dataunion.uint64_value ^= i;
     return *this;
@@ -808,12 +968,16 @@ TrackerElement::mac_map_iterator TrackerElement::mac_find(mac_addr k) {
 }
 
 void TrackerElement::add_macmap(mac_addr i, SharedTrackerElement s) {
+    bump_generation();
+
     except_type_mismatch(TrackerMacMap);
 
     (*dataunion.submacmap_value)[i] = s;
 }
 
 void TrackerElement::del_macmap(mac_addr f) {
+    bump_generation();
+
     except_type_mismatch(TrackerMacMap);
 
     mac_map_iterator mi = dataunion.submacmap_value->find(f);
@@ -823,12 +987,16 @@ void TrackerElement::del_macmap(mac_addr f) {
 }
 
 void TrackerElement::del_macmap(mac_map_iterator i) {
+    bump_generation();
+
     except_type_mismatch(TrackerMacMap);
 
     dataunion.submacmap_value->erase(i);
 }
 
 void TrackerElement::clear_macmap() {
+    bump_generation();
+
     except_type_mismatch(TrackerMacMap);
 
     dataunion.submacmap_value->clear();
@@ -841,6 +1009,8 @@ size_t TrackerElement::size_macmap() {
 }
 
 void TrackerElement::insert_macmap(mac_map_pair p) {
+    bump_generation();
+
     except_type_mismatch(TrackerMacMap);
 
     dataunion.submacmap_value->insert(p);
@@ -877,12 +1047,16 @@ TrackerElement::string_map_iterator TrackerElement::string_find(std::string k) {
 }
 
 void TrackerElement::add_stringmap(std::string i, SharedTrackerElement s) {
+    bump_generation();
+
     except_type_mismatch(TrackerStringMap);
 
     (*dataunion.substringmap_value)[i] = s;
 }
 
 void TrackerElement::del_stringmap(std::string f) {
+    bump_generation();
+
     except_type_mismatch(TrackerStringMap);
 
     string_map_iterator mi = dataunion.substringmap_value->find(f);
@@ -892,12 +1066,16 @@ void TrackerElement::del_stringmap(std::string f) {
 }
 
 void TrackerElement::del_stringmap(string_map_iterator i) {
+    bump_generation();
+
     except_type_mismatch(TrackerStringMap);
 
     dataunion.substringmap_value->erase(i);
 }
 
 void TrackerElement::clear_stringmap() {
+    bump_generation();
+
     except_type_mismatch(TrackerStringMap);
 
     dataunion.substringmap_value->clear();
@@ -910,6 +1088,8 @@ size_t TrackerElement::size_stringmap() {
 }
 
 void TrackerElement::insert_stringmap(string_map_pair p) {
+    bump_generation();
+
     except_type_mismatch(TrackerStringMap);
 
     dataunion.substringmap_value->insert(p);
@@ -946,12 +1126,16 @@ TrackerElement::double_map_iterator TrackerElement::double_find(double k) {
 }
 
 void TrackerElement::add_doublemap(double i, SharedTrackerElement s) {
+    bump_generation();
+
     except_type_mismatch(TrackerDoubleMap);
 
     (*dataunion.subdoublemap_value)[i] = s;
 }
 
 void TrackerElement::del_doublemap(double f) {
+    bump_generation();
+
     except_type_mismatch(TrackerDoubleMap);
 
     double_map_iterator mi = dataunion.subdoublemap_value->find(f);
@@ -961,12 +1145,16 @@ void TrackerElement::del_doublemap(double f) {
 }
 
 void TrackerElement::del_doublemap(double_map_iterator i) {
+    bump_generation();
+
     except_type_mismatch(TrackerDoubleMap);
 
     dataunion.subdoublemap_value->erase(i);
 }
 
 void TrackerElement::clear_doublemap() {
+    bump_generation();
+
     except_type_mismatch(TrackerDoubleMap);
 
     for (double_map_iterator i = dataunion.subdoublemap_value->begin();
@@ -977,6 +1165,8 @@ void TrackerElement::clear_doublemap() {
 }
 
 void TrackerElement::insert_doublemap(double_map_pair p) {
+    bump_generation();
+
     except_type_mismatch(TrackerDoubleMap);
 
     dataunion.subdoublemap_value->insert(p);
@@ -1140,6 +1330,8 @@ TrackerType TrackerElement::typestring_to_type(std::string s) {
 }
 
 void TrackerElement::coercive_set(std::string in_str) {
+    bump_generation();
+
     mac_addr m;
     uuid u;
     TrackedDeviceKey k;
@@ -1177,6 +1369,8 @@ void TrackerElement::coercive_set(std::string in_str) {
 }
 
 void TrackerElement::coercive_set(double in_num) {
+    bump_generation();
+
     switch (type) {
         case TrackerInt8:
             if (in_num < -128 || in_num > 127)
@@ -1229,6 +1423,8 @@ void TrackerElement::coercive_set(double in_num) {
 }
 
 void TrackerElement::coercive_set(SharedTrackerElement in_elem) {
+    bump_generation();
+
     // Extract the base type then do a coercive set
     std::string basic_string;
     double basic_num;
@@ -1294,6 +1490,8 @@ void TrackerElement::coercive_set(SharedTrackerElement in_elem) {
 }
 
 void TrackerElement::add_map(int f, SharedTrackerElement s) {
+    bump_generation();
+
     except_type_mismatch(TrackerMap);
     
     auto o = dataunion.submap_value->find(f);
@@ -1304,6 +1502,8 @@ void TrackerElement::add_map(int f, SharedTrackerElement s) {
 }
 
 void TrackerElement::add_map(SharedTrackerElement s) {
+    bump_generation();
+
     except_type_mismatch(TrackerMap);
 
     if (s == NULL)
@@ -1317,6 +1517,8 @@ void TrackerElement::add_map(SharedTrackerElement s) {
 }
 
 void TrackerElement::del_map(int f) {
+    bump_generation();
+
     except_type_mismatch(TrackerMap);
 
     map_iterator i = dataunion.submap_value->find(f);
@@ -1326,6 +1528,8 @@ void TrackerElement::del_map(int f) {
 }
 
 void TrackerElement::del_map(SharedTrackerElement e) {
+    bump_generation();
+
     except_type_mismatch(TrackerMap);
 
     if (e == NULL)
@@ -1335,17 +1539,23 @@ void TrackerElement::del_map(SharedTrackerElement e) {
 }
 
 void TrackerElement::del_map(map_iterator i) {
+    bump_generation();
+
     except_type_mismatch(TrackerMap);
     dataunion.submap_value->erase(i);
 }
 
 void TrackerElement::insert_map(tracked_pair p) {
+    bump_generation();
+
     except_type_mismatch(TrackerMap);
 
     dataunion.submap_value->insert(p);
 }
 
 void TrackerElement::clear_map() {
+    bump_generation();
+
     except_type_mismatch(TrackerMap);
     
     dataunion.submap_value->clear();
@@ -1388,6 +1598,8 @@ TrackerElement::int_map_iterator TrackerElement::int_find(int k) {
 }
 
 void TrackerElement::clear_intmap() {
+    bump_generation();
+
     except_type_mismatch(TrackerIntMap);
 
     dataunion.subintmap_value->clear();
@@ -1400,18 +1612,24 @@ size_t TrackerElement::size_intmap() {
 }
 
 void TrackerElement::insert_intmap(int_map_pair p) {
+    bump_generation();
+
     except_type_mismatch(TrackerIntMap);
 
     dataunion.subintmap_value->insert(p);
 }
 
 void TrackerElement::add_intmap(int i, SharedTrackerElement s) {
+    bump_generation();
+
     except_type_mismatch(TrackerIntMap);
 
     (*dataunion.subintmap_value)[i] = s;
 }
 
 void TrackerElement::del_intmap(int i) {
+    bump_generation();
+
     except_type_mismatch(TrackerIntMap);
 
     int_map_iterator itr = dataunion.subintmap_value->find(i);
@@ -1421,18 +1639,24 @@ void TrackerElement::del_intmap(int i) {
 }
 
 void TrackerElement::del_intmap(int_map_iterator i) {
+    bump_generation();
+
     except_type_mismatch(TrackerIntMap);
 
     dataunion.subintmap_value->erase(i);
 }
 
 void TrackerElement::add_vector(SharedTrackerElement s) {
+    bump_generation();
+
     except_type_mismatch(TrackerVector);
 
     dataunion.subvector_value->push_back(s);
 }
 
 void TrackerElement::del_vector(unsigned int p) {
+    bump_generation();
+
     except_type_mismatch(TrackerVector);
 
     if (p >= dataunion.subvector_value->size()) {
@@ -1447,12 +1671,16 @@ void TrackerElement::del_vector(unsigned int p) {
 }
 
 void TrackerElement::del_vector(vector_iterator i) {
+    bump_generation();
+
     except_type_mismatch(TrackerVector);
 
     dataunion.subvector_value->erase(i);
 }
 
 void TrackerElement::clear_vector() {
+    bump_generation();
+
     except_type_mismatch(TrackerVector);
 
     dataunion.subvector_value->clear();
@@ -1465,6 +1693,8 @@ size_t TrackerElement::size_vector() {
 }
 
 void TrackerElement::set_bytearray(uint8_t *d, size_t len) {
+    bump_generation();
+
     except_type_mismatch(TrackerByteArray);
 
     dataunion.bytearray_value->reset(new uint8_t[len], std::default_delete<uint8_t[]>());
@@ -1473,6 +1703,8 @@ void TrackerElement::set_bytearray(uint8_t *d, size_t len) {
 }
 
 void TrackerElement::set_bytearray(std::shared_ptr<uint8_t> d, size_t len) {
+    bump_generation();
+
     except_type_mismatch(TrackerByteArray);
 
     *(dataunion.bytearray_value) = d;
@@ -1480,6 +1712,8 @@ void TrackerElement::set_bytearray(std::shared_ptr<uint8_t> d, size_t len) {
 }
 
 void TrackerElement::set_bytearray(std::string s) {
+    bump_generation();
+
     set_bytearray((uint8_t *) s.data(), s.length());
 }
 
@@ -1503,6 +1737,176 @@ std::string TrackerElement::get_bytearray_str() {
     return std::string((const char *) ba, bytearray_value_len);
 }
 
+SharedTrackerElement TrackerElement::deep_clone_element() {
+    SharedTrackerElement dup =
+        std::allocate_shared<TrackerElement>(tracker_element_pool_allocator<TrackerElement>(),
+                type, tracked_id);
+
+    if (local_name.length() != 0)
+        dup->set_local_name(local_name);
+
+    switch (type) {
+        case TrackerString:
+            dup->set(get_string());
+            break;
+        case TrackerInt8:
+            dup->set(get_int8());
+            break;
+        case TrackerUInt8:
+            dup->set(get_uint8());
+            break;
+        case TrackerInt16:
+            dup->set(get_int16());
+            break;
+        case TrackerUInt16:
+            dup->set(get_uint16());
+            break;
+        case TrackerInt32:
+            dup->set(get_int32());
+            break;
+        case TrackerUInt32:
+            dup->set(get_uint32());
+            break;
+        case TrackerInt64:
+            dup->set(get_int64());
+            break;
+        case TrackerUInt64:
+            dup->set(get_uint64());
+            break;
+        case TrackerFloat:
+            dup->set(get_float());
+            break;
+        case TrackerDouble:
+            dup->set(get_double());
+            break;
+        case TrackerMac:
+            dup->set(get_mac());
+            break;
+        case TrackerUuid:
+            dup->set(get_uuid());
+            break;
+        case TrackerKey:
+            dup->set(get_key());
+            break;
+        case TrackerByteArray:
+            dup->set_bytearray(get_bytearray(), get_bytearray_size());
+            break;
+        case TrackerVector:
+            for (auto i = dataunion.subvector_value->begin();
+                    i != dataunion.subvector_value->end(); ++i) {
+                if (*i != NULL)
+                    dup->add_vector((*i)->deep_clone_element());
+            }
+            break;
+        case TrackerMap:
+            for (auto i = dataunion.submap_value->begin();
+                    i != dataunion.submap_value->end(); ++i) {
+                if (i->second != NULL)
+                    dup->add_map(i->first, i->second->deep_clone_element());
+            }
+            break;
+        case TrackerIntMap:
+            for (auto i = dataunion.subintmap_value->begin();
+                    i != dataunion.subintmap_value->end(); ++i) {
+                if (i->second != NULL)
+                    dup->add_intmap(i->first, i->second->deep_clone_element());
+            }
+            break;
+        case TrackerMacMap:
+            for (auto i = dataunion.submacmap_value->begin();
+                    i != dataunion.submacmap_value->end(); ++i) {
+                if (i->second != NULL)
+                    dup->add_macmap(i->first, i->second->deep_clone_element());
+            }
+            break;
+        case TrackerStringMap:
+            for (auto i = dataunion.substringmap_value->begin();
+                    i != dataunion.substringmap_value->end(); ++i) {
+                if (i->second != NULL)
+                    dup->add_stringmap(i->first, i->second->deep_clone_element());
+            }
+            break;
+        case TrackerDoubleMap:
+            for (auto i = dataunion.subdoublemap_value->begin();
+                    i != dataunion.subdoublemap_value->end(); ++i) {
+                if (i->second != NULL)
+                    dup->add_doublemap(i->first, i->second->deep_clone_element());
+            }
+            break;
+        case TrackerKeyMap:
+            for (auto i = dataunion.subkeymap_value->begin();
+                    i != dataunion.subkeymap_value->end(); ++i) {
+                if (i->second != NULL)
+                    dup->get_keymap()->emplace(i->first, i->second->deep_clone_element());
+            }
+            break;
+        default:
+            break;
+    }
+
+    return dup;
+}
+
+uint64_t TrackerElement::tree_generation() {
+    uint64_t h = element_generation;
+
+    switch (type) {
+        case TrackerVector:
+            for (auto i = dataunion.subvector_value->begin();
+                    i != dataunion.subvector_value->end(); ++i) {
+                if (*i != NULL)
+                    h = (h * 31) + (*i)->tree_generation();
+            }
+            break;
+        case TrackerMap:
+            for (auto i = dataunion.submap_value->begin();
+                    i != dataunion.submap_value->end(); ++i) {
+                if (i->second != NULL)
+                    h = (h * 31) + i->second->tree_generation();
+            }
+            break;
+        case TrackerIntMap:
+            for (auto i = dataunion.subintmap_value->begin();
+                    i != dataunion.subintmap_value->end(); ++i) {
+                if (i->second != NULL)
+                    h = (h * 31) + i->second->tree_generation();
+            }
+            break;
+        case TrackerMacMap:
+            for (auto i = dataunion.submacmap_value->begin();
+                    i != dataunion.submacmap_value->end(); ++i) {
+                if (i->second != NULL)
+                    h = (h * 31) + i->second->tree_generation();
+            }
+            break;
+        case TrackerStringMap:
+            for (auto i = dataunion.substringmap_value->begin();
+                    i != dataunion.substringmap_value->end(); ++i) {
+                if (i->second != NULL)
+                    h = (h * 31) + i->second->tree_generation();
+            }
+            break;
+        case TrackerDoubleMap:
+            for (auto i = dataunion.subdoublemap_value->begin();
+                    i != dataunion.subdoublemap_value->end(); ++i) {
+                if (i->second != NULL)
+                    h = (h * 31) + i->second->tree_generation();
+            }
+            break;
+        case TrackerKeyMap:
+            for (auto i = dataunion.subkeymap_value->begin();
+                    i != dataunion.subkeymap_value->end(); ++i) {
+                if (i->second != NULL)
+                    h = (h * 31) + i->second->tree_generation();
+            }
+            break;
+        default:
+            break;
+    }
+
+    return h;
+}
+
 size_t TrackerElement::size() {
     switch (type) {
         case TrackerVector:
@@ -1522,71 +1926,15 @@ size_t TrackerElement::size() {
     }
 }
 
-template<> std::string GetTrackerValue(SharedTrackerElement e) {
-    return e->get_string();
-}
-
-template<> int8_t GetTrackerValue(SharedTrackerElement e) {
-    return e->get_int8();
-}
-
-template<> uint8_t GetTrackerValue(SharedTrackerElement e) {
-    return e->get_uint8();
-}
-
-template<> int16_t GetTrackerValue(SharedTrackerElement e) {
-    return e->get_int16();
-}
-
-template<> uint16_t GetTrackerValue(SharedTrackerElement e) {
-    return e->get_uint16();
-}
-
-template<> int32_t GetTrackerValue(SharedTrackerElement e) {
-    return e->get_int32();
-}
-
-template<> uint32_t GetTrackerValue(SharedTrackerElement e) {
-    return e->get_uint32();
-}
-
-template<> int64_t GetTrackerValue(SharedTrackerElement e) {
-    return e->get_int64();
-}
-
-template<> uint64_t GetTrackerValue(SharedTrackerElement e) {
-    return e->get_uint64();
-}
-
-template<> float GetTrackerValue(SharedTrackerElement e) {
-    return e->get_float();
-}
-
-template<> double GetTrackerValue(SharedTrackerElement e) {
-    return e->get_double();
-}
-
-template<> mac_addr GetTrackerValue(SharedTrackerElement e) {
-    return e->get_mac();
-}
-
-template<> TrackerElement::tracked_map *GetTrackerValue(SharedTrackerElement e) {
+template<> TrackerElement::tracked_map *GetTrackerValue(const SharedTrackerElement& e) {
     return e->get_map();
 }
 
 template<> TrackerElement::tracked_vector 
-    *GetTrackerValue(SharedTrackerElement e) {
+    *GetTrackerValue(const SharedTrackerElement& e) {
     return e->get_vector();
 }
 
-template<> uuid GetTrackerValue(SharedTrackerElement e) {
-    return e->get_uuid();
-}
-
-template<> TrackedDeviceKey GetTrackerValue(SharedTrackerElement e) {
-    return e->get_key();
-}
-
 bool operator==(TrackerElement &te1, int8_t i) {
     return te1.get_int8() == i;
 }
@@ -1905,6 +2253,42 @@ void tracker_component::reserve_fields(SharedTrackerElement e) {
     }
 }
 
+void tracker_component::clone_from_prototype(tracker_component *proto) {
+    // Copy the registered field list, rebasing each assignment pointer from
+    // the prototype instance to this one; both objects are the same
+    // most-derived type, so member offsets are identical
+    for (unsigned int i = 0; i < proto->registered_fields.size(); i++) {
+        registered_field *prf = proto->registered_fields[i];
+
+        SharedTrackerElement *assign = NULL;
+
+        if (prf->assign != NULL) {
+            assign = reinterpret_cast<SharedTrackerElement *>(
+                    reinterpret_cast<char *>(this) +
+                    (reinterpret_cast<char *>(prf->assign) -
+                     reinterpret_cast<char *>(proto)));
+        }
+
+        registered_fields.push_back(new registered_field(prf->id, assign));
+    }
+
+    // Deep-copy the prototype's field tree; plain elements are copied
+    // directly from the pool, complex components rebuild through their own
+    // constructors
+    for (auto i = proto->begin(); i != proto->end(); ++i) {
+        if (i->second != NULL)
+            add_map(i->first, i->second->deep_clone_element());
+    }
+
+    // Point our field members at our copies
+    for (unsigned int i = 0; i < registered_fields.size(); i++) {
+        registered_field *rf = registered_fields[i];
+
+        if (rf->assign != NULL)
+            *(rf->assign) = get_map_value(rf->id);
+    }
+}
+
 SharedTrackerElement 
     tracker_component::import_or_new(SharedTrackerElement e, int i) {
 
@@ -2025,6 +2409,7 @@ TrackerElementSummary::TrackerElementSummary(SharedElementSummary in_c) {
     parent_element = in_c->parent_element;
     resolved_path = in_c->resolved_path;
     rename = in_c->rename;
+    absent_name = in_c->absent_name;
 }
 
 TrackerElementSummary::TrackerElementSummary(std::string in_path, std::string in_rename,
@@ -2050,6 +2435,7 @@ TrackerElementSummary::TrackerElementSummary(std::vector<std::string> in_path,
 TrackerElementSummary::TrackerElementSummary(std::vector<int> in_path, std::string in_rename) {
     resolved_path = in_path;
     rename = in_rename;
+    absent_name = in_rename;
 }
 
 TrackerElementSummary::TrackerElementSummary(std::vector<int> in_path) {
@@ -2082,6 +2468,14 @@ void TrackerElementSummary::parse_path(std::vector<std::string> in_path, std::st
     } else {
         rename = in_rename;
     }
+
+    // Pre-resolve the display name used for records which lack the field;
+    // the per-record summary loop then never has to consult the entry
+    // tracker for the common case of a field absent on most devices
+    if (rename.length() != 0)
+        absent_name = rename;
+    else if (resolved_path.size() != 0)
+        absent_name = entrytracker->GetFieldName(resolved_path[resolved_path.size() - 1]);
 }
 
 SharedTrackerElement GetTrackerElementPath(std::string in_path, 
@@ -2089,7 +2483,7 @@ SharedTrackerElement GetTrackerElementPath(std::string in_path,
     return GetTrackerElementPath(StrTokenize(in_path, "/"), elem, entrytracker);
 }
 
-SharedTrackerElement GetTrackerElementPath(std::vector<std::string> in_path, 
+SharedTrackerElement GetTrackerElementPath(const std::vector<std::string> &in_path,
         SharedTrackerElement elem, std::shared_ptr<EntryTracker> entrytracker) {
 
     if (in_path.size() < 1)
@@ -2122,7 +2516,7 @@ SharedTrackerElement GetTrackerElementPath(std::vector<std::string> in_path,
     return next_elem;
 }
 
-SharedTrackerElement GetTrackerElementPath(std::vector<int> in_path, 
+SharedTrackerElement GetTrackerElementPath(const std::vector<int> &in_path,
         SharedTrackerElement elem) {
 
     if (in_path.size() < 1)
@@ -2159,7 +2553,7 @@ std::vector<SharedTrackerElement> GetTrackerElementMultiPath(std::string in_path
     return GetTrackerElementMultiPath(StrTokenize(in_path, "/"), elem, entrytracker);
 }
 
-std::vector<SharedTrackerElement> GetTrackerElementMultiPath(std::vector<std::string> in_path, 
+std::vector<SharedTrackerElement> GetTrackerElementMultiPath(const std::vector<std::string> &in_path,
         SharedTrackerElement elem, std::shared_ptr<EntryTracker> entrytracker) {
 
     std::vector<SharedTrackerElement> ret;
@@ -2278,7 +2672,7 @@ std::vector<SharedTrackerElement> GetTrackerElementMultiPath(std::vector<std::st
     return ret;
 }
 
-std::vector<SharedTrackerElement> GetTrackerElementMultiPath(std::vector<int> in_path, 
+std::vector<SharedTrackerElement> GetTrackerElementMultiPath(const std::vector<int> &in_path,
         SharedTrackerElement elem) {
 
     std::vector<SharedTrackerElement> ret;
@@ -2393,8 +2787,8 @@ std::vector<SharedTrackerElement> GetTrackerElementMultiPath(std::vector<int> in
 }
 
 void SummarizeTrackerElement(std::shared_ptr<EntryTracker> entrytracker,
-        SharedTrackerElement in, std::vector<SharedElementSummary> in_summarization, 
-        SharedTrackerElement &ret_elem, 
+        SharedTrackerElement in, const std::vector<SharedElementSummary> &in_summarization,
+        SharedTrackerElement &ret_elem,
         TrackerElementSerializer::rename_map &rename_map) {
 
     // Poke the pre-serialization function to update anything that needs updating before
@@ -2402,7 +2796,8 @@ void SummarizeTrackerElement(std::shared_ptr<EntryTracker> entrytracker,
     in->pre_serialize();
 
     unsigned int fn = 0;
-    ret_elem.reset(new TrackerElement(TrackerMap));
+    ret_elem = std::allocate_shared<TrackerElement>(tracker_element_pool_allocator<TrackerElement>(),
+            TrackerMap);
 
     if (in_summarization.size() == 0)
         ret_elem = in;
@@ -2413,18 +2808,26 @@ void SummarizeTrackerElement(std::shared_ptr<EntryTracker> entrytracker,
         if ((*si)->resolved_path.size() == 0)
             continue;
 
-        SharedTrackerElement f =
-            GetTrackerElementPath((*si)->resolved_path, in);
+        // Most summaries are top-level fields of the record; pluck them
+        // directly out of the sorted field map instead of going through the
+        // generic path walker
+        SharedTrackerElement f;
 
-        if (f == NULL) {
-            f = entrytracker->RegisterAndGetField("unknown" + IntToString(fn),
-                    TrackerInt8, "unallocated field");
+        if ((*si)->resolved_path.size() == 1)
+            f = in->get_map_value((*si)->resolved_path[0]);
+        else
+            f = GetTrackerElementPath((*si)->resolved_path, in);
 
-            f = SharedTrackerElement(new TrackerElement(TrackerUInt8));
+        if (f == NULL) {
+            // Preserve the response shape with a zero-valued placeholder;
+            // the display name was resolved when the summary was compiled so
+            // we don't go back to the entry tracker for every record which
+            // lacks the field
+            f = std::make_shared<TrackerElement>(TrackerUInt8);
             f->set((uint8_t) 0);
-        
-            if ((*si)->rename.length() != 0) {
-                f->set_local_name((*si)->rename);
+
+            if ((*si)->absent_name.length() != 0) {
+                f->set_local_name((*si)->absent_name);
             } else {
                 // Get the last name of the field in the path, if we can...
                 int lastid = (*si)->resolved_path[(*si)->resolved_path.size() - 1];
@@ -2434,7 +2837,7 @@ void SummarizeTrackerElement(std::shared_ptr<EntryTracker> entrytracker,
                 else
                     f->set_local_name(entrytracker->GetFieldName(lastid));
             }
-        } 
+        }
 
        
         // If we're renaming it or we're a path, we put the record in.  We need
@@ -2442,7 +2845,7 @@ void SummarizeTrackerElement(std::shared_ptr<EntryTracker> entrytracker,
         // object so that when we serialize we can descend the path calling
         // the proper pre-serialization methods
         if ((*si)->rename.length() != 0 || (*si)->resolved_path.size() > 1) {
-            SharedElementSummary sum(new TrackerElementSummary(*si));
+            SharedElementSummary sum = std::make_shared<TrackerElementSummary>(*si);
             sum->parent_element = in;
             rename_map[f] = sum;
         }
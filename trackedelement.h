@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#include <atomic>
 #include <string>
 #include <stdexcept>
 
@@ -31,7 +32,9 @@
 #include <map>
 
 #include <memory>
+#include <mutex>
 
+#include "kis_mempool.h"
 #include "kis_mutex.h"
 #include "macaddr.h"
 #include "uuid.h"
@@ -46,7 +49,11 @@
 // functions, and if this presents a problem, turning off type checking can cull 
 // a large percentage of the function calls
 
+// Configure with --disable-typesafety to drop the checks from release
+// builds, turning the typed accessors into direct union loads and stores
+#ifndef DISABLE_TE_TYPE_SAFETY
 #define TE_TYPE_SAFETY  1
+#endif
 
 #ifndef TE_TYPE_SAFETY
 // If there's no type safety, define an empty except_type_mismatch
@@ -100,8 +107,30 @@ public:
 
     bool get_error() { return error; }
 
+    // Raw key components, used for hashing keys into buckets
+    uint64_t get_spkey() const { return spkey; }
+    uint64_t get_dkey() const { return dkey; }
+
+    // Cached mixed hash, computed once at construction; keys sit in hashed
+    // indexes and unordered containers so lookups shouldn't re-mix
+    uint64_t get_hkey() const { return hkey; }
+
+    // Finalizer-style mix; dkey is the raw packed longmac, whose low bits
+    // cluster badly (OUI runs), so scramble it and fold in the server/phy
+    // component
+    static uint64_t mix_hash(uint64_t in_spkey, uint64_t in_dkey) {
+        uint64_t h = in_dkey ^ (in_spkey * (uint64_t) 0x9E3779B97F4A7C15ULL);
+
+        h ^= h >> 33;
+        h *= (uint64_t) 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+
+        return h;
+    }
+
 protected:
     uint64_t spkey, dkey;
+    uint64_t hkey;
     bool error;
 };
 
@@ -109,6 +138,266 @@ bool operator <(const TrackedDeviceKey& x, const TrackedDeviceKey& y);
 bool operator ==(const TrackedDeviceKey& x, const TrackedDeviceKey& y);
 std::ostream& operator<<(std::ostream& os, const TrackedDeviceKey& k);
 
+namespace std {
+    template<> struct hash<TrackedDeviceKey> {
+        std::size_t operator()(const TrackedDeviceKey& k) const {
+            return (std::size_t) k.get_hkey();
+        }
+    };
+}
+
+// Recycling allocator for tracker elements, used via std::allocate_shared.
+//
+// Building a tracked device allocates its whole field tree element by
+// element, and expiring a timed-out device frees it the same way; over
+// multi-week uptimes that churn fragments the heap.  Elements can outlive
+// their device (serializers and summarization hold shared references into
+// the tree), so a hard per-device arena release is not safe; instead,
+// freed element blocks are kept on a bounded free list and handed back out,
+// so steady-state device creation is a pointer pop from warmed slabs and
+// expiry returns blocks without touching the global allocator.
+//
+// Blocks are pooled per rebound node type, so every block on a list is the
+// same size.
+template<typename T>
+class tracker_element_pool_allocator {
+public:
+    typedef T value_type;
+
+    tracker_element_pool_allocator() { }
+
+    template<typename U>
+    tracker_element_pool_allocator(const tracker_element_pool_allocator<U>&) { }
+
+    T *allocate(size_t n) {
+        if (n == 1) {
+            std::lock_guard<std::mutex> lk(pool_mutex());
+
+            std::vector<void *>& fl = free_list();
+
+            if (!fl.empty()) {
+                void *p = fl.back();
+                fl.pop_back();
+                return static_cast<T *>(p);
+            }
+        }
+
+        // Dry free list; carve from the preallocated region when it's
+        // active so device trees land inside the hugepage reservation
+        void *m = kis_mem_pool::take(n * sizeof(T));
+        if (m != NULL)
+            return static_cast<T *>(m);
+
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t n) {
+        if (n == 1) {
+            std::lock_guard<std::mutex> lk(pool_mutex());
+
+            std::vector<void *>& fl = free_list();
+
+            if (fl.size() < max_pool_blocks) {
+                fl.push_back(p);
+                return;
+            }
+        }
+
+        if (kis_mem_pool::give(p))
+            return;
+
+        ::operator delete(p);
+    }
+
+    template<typename U>
+    bool operator==(const tracker_element_pool_allocator<U>&) const {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const tracker_element_pool_allocator<U>&) const {
+        return false;
+    }
+
+protected:
+    // Bound the free list so a transient spike of devices doesn't pin
+    // memory forever; overflow falls through to the normal heap
+    static const size_t max_pool_blocks = 65536;
+
+    static std::mutex& pool_mutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    static std::vector<void *>& free_list() {
+        static std::vector<void *> v;
+        return v;
+    }
+};
+
+// Interning pool for tracker element string values.
+//
+// The same strings are stored over and over across the device tree - every
+// device made by the same vendor carries an identical manuf string, and
+// SSIDs, phy names, and channel strings repeat across thousands of devices.
+// Interning collapses the duplicates to a single refcounted copy; elements
+// hold a pointer into the pool and re-acquire on assignment, so with 200k
+// devices the per-device cost of a repeated string is one pointer.
+class StringInternPool {
+public:
+    // Fetch the pooled copy of a string, adding it if needed; takes a
+    // reference on the pooled copy
+    static const std::string *acquire(const std::string& s);
+
+    // As above, but steal the caller's buffer when the string is new to
+    // the pool
+    static const std::string *acquire(std::string&& s);
+
+    // Release a reference on a pooled string; the backing copy is freed
+    // when the last reference goes away
+    static void release(const std::string *s);
+
+protected:
+    static std::mutex pool_mutex;
+    static std::map<std::string, size_t> pool;
+};
+
+// Flat sorted-vector map used to back the tracker map types.  Tracked devices
+// are trees of many small maps which are populated once (during
+// reserve_fields or dissection) and then walked constantly during lookup and
+// serialization; storing the key/element pairs contiguously and sorted turns
+// lookup into a binary search over hot cache lines and iteration into a
+// linear scan, instead of chasing a red-black tree node per field.
+//
+// Implements the subset of the std::map interface the tracker code uses;
+// keys are unique, and inserting or erasing invalidates iterators, as with
+// any vector.
+template<typename K>
+class TrackerFlatMap {
+public:
+    typedef std::pair<K, SharedTrackerElement> pair_type;
+    typedef typename std::vector<pair_type>::iterator iterator;
+    typedef typename std::vector<pair_type>::const_iterator const_iterator;
+
+    iterator begin() {
+        return backing.begin();
+    }
+
+    const_iterator begin() const {
+        return backing.begin();
+    }
+
+    iterator end() {
+        return backing.end();
+    }
+
+    const_iterator end() const {
+        return backing.end();
+    }
+
+    iterator find(const K& k) {
+        iterator i = lower_bound(k);
+
+        if (i != backing.end() && i->first == k)
+            return i;
+
+        return backing.end();
+    }
+
+    const_iterator find(const K& k) const {
+        const_iterator i = lower_bound(k);
+
+        if (i != backing.end() && i->first == k)
+            return i;
+
+        return backing.end();
+    }
+
+    // Insert-or-fetch, as std::map::insert; the existing element is kept if
+    // the key is already present
+    std::pair<iterator, bool> insert(const pair_type& p) {
+        iterator i = lower_bound(p.first);
+
+        if (i != backing.end() && i->first == p.first)
+            return std::make_pair(i, false);
+
+        return std::make_pair(backing.insert(i, p), true);
+    }
+
+    std::pair<iterator, bool> emplace(const K& k, const SharedTrackerElement& e) {
+        return insert(pair_type(k, e));
+    }
+
+    // Insert-or-replace, as std::map::operator[]
+    SharedTrackerElement& operator[](const K& k) {
+        iterator i = lower_bound(k);
+
+        if (i != backing.end() && i->first == k)
+            return i->second;
+
+        return backing.insert(i, pair_type(k, NULL))->second;
+    }
+
+    iterator erase(iterator i) {
+        return backing.erase(i);
+    }
+
+    size_t erase(const K& k) {
+        iterator i = find(k);
+
+        if (i == backing.end())
+            return 0;
+
+        backing.erase(i);
+        return 1;
+    }
+
+    void clear() {
+        backing.clear();
+    }
+
+    size_t size() const {
+        return backing.size();
+    }
+
+    bool empty() const {
+        return backing.empty();
+    }
+
+protected:
+    iterator lower_bound(const K& k) {
+        size_t lo = 0, hi = backing.size();
+
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+
+            if (backing[mid].first < k)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        return backing.begin() + lo;
+    }
+
+    const_iterator lower_bound(const K& k) const {
+        size_t lo = 0, hi = backing.size();
+
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+
+            if (backing[mid].first < k)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        return backing.begin() + lo;
+    }
+
+    std::vector<pair_type> backing;
+};
+
 // Types of fields we can track and automatically resolve
 // Statically assigned type numbers which MUST NOT CHANGE as things go forwards for 
 // binary/fast serialization, new types must be added to the end of the list
@@ -175,10 +464,20 @@ public:
 
     void Initialize();
 
-    // Factory-style for easily making more of the same if we're subclassed
+    // Process-wide count of live elements; the device tree is overwhelmingly
+    // made of these, so the count is the best proxy for its memory footprint.
+    // Published as a memory accounting gauge
+    static uint64_t FetchElementCount() {
+        return element_count;
+    }
+
+    // Factory-style for easily making more of the same if we're subclassed;
+    // make_shared folds the refcount control block into the element
+    // allocation, which matters when every scalar field of every device is
+    // one of these
     virtual std::shared_ptr<TrackerElement> clone_type() {
-        std::shared_ptr<TrackerElement> dup1(new TrackerElement(get_type(), get_id()));
-        return dup1;
+        return std::allocate_shared<TrackerElement>(tracker_element_pool_allocator<TrackerElement>(),
+                get_type(), get_id());
     }
 
     virtual std::shared_ptr<TrackerElement> clone_type(int in_id) {
@@ -188,6 +487,28 @@ public:
         return dup1;
     }
 
+    // Generation count, bumped by every mutation; lets cached
+    // serializations of an element be validated without re-rendering it
+    uint64_t get_generation() {
+        return element_generation;
+    }
+
+    void bump_generation() {
+        element_generation++;
+    }
+
+    // Combined generation of this element and everything under it; a cheap
+    // pointer walk over the tree, orders of magnitude lighter than
+    // re-serializing it, used to decide if a cached render is still valid
+    uint64_t tree_generation();
+
+    // Deep copy of this element and everything under it, preserving type,
+    // id, and stored values, without touching the entrytracker; used by the
+    // prototype-clone fast path for building new component trees.  Complex
+    // component subclasses override this to rebuild via their own
+    // constructors so their internal field pointers stay valid.
+    virtual SharedTrackerElement deep_clone_element();
+
     // Called prior to serialization output
     virtual void pre_serialize() { }
 
@@ -218,38 +539,42 @@ public:
     typedef std::vector<SharedTrackerElement>::iterator vector_iterator;
     typedef std::vector<SharedTrackerElement>::const_iterator vector_const_iterator;
 
-    typedef std::multimap<int, SharedTrackerElement> tracked_map;
-    typedef std::multimap<int, SharedTrackerElement>::iterator map_iterator;
-    typedef std::multimap<int, SharedTrackerElement>::const_iterator map_const_iterator;
-    typedef std::pair<int, SharedTrackerElement> tracked_pair;
+    typedef TrackerFlatMap<int> tracked_map;
+    typedef TrackerFlatMap<int>::iterator map_iterator;
+    typedef TrackerFlatMap<int>::const_iterator map_const_iterator;
+    typedef TrackerFlatMap<int>::pair_type tracked_pair;
 
-    typedef std::map<int, SharedTrackerElement> tracked_int_map;
-    typedef std::map<int, SharedTrackerElement>::iterator int_map_iterator;
-    typedef std::map<int, SharedTrackerElement>::const_iterator int_map_const_iterator;
-    typedef std::pair<int, SharedTrackerElement> int_map_pair;
+    typedef TrackerFlatMap<int> tracked_int_map;
+    typedef TrackerFlatMap<int>::iterator int_map_iterator;
+    typedef TrackerFlatMap<int>::const_iterator int_map_const_iterator;
+    typedef TrackerFlatMap<int>::pair_type int_map_pair;
 
-    typedef std::map<mac_addr, SharedTrackerElement> tracked_mac_map;
-    typedef std::map<mac_addr, SharedTrackerElement>::iterator mac_map_iterator;
-    typedef std::map<mac_addr, SharedTrackerElement>::const_iterator mac_map_const_iterator;
-    typedef std::pair<mac_addr, SharedTrackerElement> mac_map_pair;
+    typedef TrackerFlatMap<mac_addr> tracked_mac_map;
+    typedef TrackerFlatMap<mac_addr>::iterator mac_map_iterator;
+    typedef TrackerFlatMap<mac_addr>::const_iterator mac_map_const_iterator;
+    typedef TrackerFlatMap<mac_addr>::pair_type mac_map_pair;
 
-    typedef std::map<std::string, SharedTrackerElement> tracked_string_map;
-    typedef std::map<std::string, SharedTrackerElement>::iterator string_map_iterator;
-    typedef std::map<std::string, SharedTrackerElement>::const_iterator string_map_const_iterator;
-    typedef std::pair<std::string, SharedTrackerElement> string_map_pair;
+    typedef TrackerFlatMap<std::string> tracked_string_map;
+    typedef TrackerFlatMap<std::string>::iterator string_map_iterator;
+    typedef TrackerFlatMap<std::string>::const_iterator string_map_const_iterator;
+    typedef TrackerFlatMap<std::string>::pair_type string_map_pair;
 
-    typedef std::map<double, SharedTrackerElement> tracked_double_map;
-    typedef std::map<double, SharedTrackerElement>::iterator double_map_iterator;
-    typedef std::map<double, SharedTrackerElement>::const_iterator double_map_const_iterator;
-    typedef std::pair<double, SharedTrackerElement> double_map_pair;
+    typedef TrackerFlatMap<double> tracked_double_map;
+    typedef TrackerFlatMap<double>::iterator double_map_iterator;
+    typedef TrackerFlatMap<double>::const_iterator double_map_const_iterator;
+    typedef TrackerFlatMap<double>::pair_type double_map_pair;
 
-    typedef std::map<TrackedDeviceKey, SharedTrackerElement> tracked_key_map;
-    typedef std::map<TrackedDeviceKey, SharedTrackerElement>::iterator key_map_iterator;
-    typedef std::map<TrackedDeviceKey, SharedTrackerElement>::const_iterator key_map_const_iterator;
-    typedef std::pair<TrackedDeviceKey, SharedTrackerElement> key_map_pair;
+    typedef TrackerFlatMap<TrackedDeviceKey> tracked_key_map;
+    typedef TrackerFlatMap<TrackedDeviceKey>::iterator key_map_iterator;
+    typedef TrackerFlatMap<TrackedDeviceKey>::const_iterator key_map_const_iterator;
+    typedef TrackerFlatMap<TrackedDeviceKey>::pair_type key_map_pair;
 
     // Getter per type, use templated GetTrackerValue() for easy fetch
-    std::string get_string() {
+    //
+    // String values are interned; the reference is stable until this
+    // element is assigned a different string, so callers which hold the
+    // value across a mutation must copy it
+    const std::string& get_string() {
         except_type_mismatch(TrackerString);
         return *(dataunion.string_value);
     }
@@ -372,77 +697,182 @@ public:
         return *(dataunion.uuid_value);
     }
 
+    // Unchecked peers of the typed getters; these skip the runtime type
+    // verification and read the union directly.  They are for internal hot
+    // paths (serialization, per-packet staging) where the type has already
+    // been established by switching on get_type() or by the registration
+    // schema; plugin-facing code should stay on the checked forms, which
+    // catch mis-typed fields instead of reading garbage union members
+    const std::string& get_string_raw() const { return *(dataunion.string_value); }
+    uint8_t get_uint8_raw() const { return dataunion.uint8_value; }
+    int8_t get_int8_raw() const { return dataunion.int8_value; }
+    uint16_t get_uint16_raw() const { return dataunion.uint16_value; }
+    int16_t get_int16_raw() const { return dataunion.int16_value; }
+    uint32_t get_uint32_raw() const { return dataunion.uint32_value; }
+    int32_t get_int32_raw() const { return dataunion.int32_value; }
+    uint64_t get_uint64_raw() const { return dataunion.uint64_value; }
+    int64_t get_int64_raw() const { return dataunion.int64_value; }
+    float get_float_raw() const { return dataunion.float_value; }
+    double get_double_raw() const { return dataunion.double_value; }
+    const mac_addr& get_mac_raw() const { return *(dataunion.mac_value); }
+    const TrackedDeviceKey& get_key_raw() const { return *(dataunion.key_value); }
+    const uuid& get_uuid_raw() const { return *(dataunion.uuid_value); }
+
     // Overloaded set
-    void set(std::string v) {
+    void set(const std::string& v) {
         except_type_mismatch(TrackerString);
-        *(dataunion.string_value) = v;
+
+        if (*(dataunion.string_value) == v)
+            return;
+
+        StringInternPool::release(dataunion.string_value);
+        dataunion.string_value = StringInternPool::acquire(v);
+        bump_generation();
+    }
+
+    // Move overload; hands the caller's buffer through to the intern pool
+    // when the value is new, so dissector-built strings land without a copy
+    void set(std::string&& v) {
+        except_type_mismatch(TrackerString);
+
+        if (*(dataunion.string_value) == v)
+            return;
+
+        StringInternPool::release(dataunion.string_value);
+        dataunion.string_value = StringInternPool::acquire(std::move(v));
+        bump_generation();
     }
 
     void set(uint8_t v) {
         except_type_mismatch(TrackerUInt8);
+
+        if (dataunion.uint8_value == v)
+            return;
+
         dataunion.uint8_value = v;
+        bump_generation();
     }
 
     void set(int8_t v) {
         except_type_mismatch(TrackerInt8);
+
+        if (dataunion.int8_value == v)
+            return;
+
         dataunion.int8_value = v;
+        bump_generation();
     }
 
     void set(uint16_t v) {
         except_type_mismatch(TrackerUInt16);
+
+        if (dataunion.uint16_value == v)
+            return;
+
         dataunion.uint16_value = v;
+        bump_generation();
     }
 
     void set(int16_t v) {
         except_type_mismatch(TrackerInt16);
+
+        if (dataunion.int16_value == v)
+            return;
+
         dataunion.int16_value = v;
+        bump_generation();
     }
 
     void set(uint32_t v) {
         except_type_mismatch(TrackerUInt32);
+
+        if (dataunion.uint32_value == v)
+            return;
+
         dataunion.uint32_value = v;
+        bump_generation();
     }
 
     void set(int32_t v) {
         except_type_mismatch(TrackerInt32);
+
+        if (dataunion.int32_value == v)
+            return;
+
         dataunion.int32_value = v;
+        bump_generation();
     }
 
     void set(uint64_t v) {
         except_type_mismatch(TrackerUInt64);
+
+        if (dataunion.uint64_value == v)
+            return;
+
         dataunion.uint64_value = v;
+        bump_generation();
     }
 
     void set(int64_t v) {
         except_type_mismatch(TrackerInt64);
+
+        if (dataunion.int64_value == v)
+            return;
+
         dataunion.int64_value = v;
+        bump_generation();
     }
 
     void set(float v) {
         except_type_mismatch(TrackerFloat);
+
+        if (dataunion.float_value == v)
+            return;
+
         dataunion.float_value = v;
+        bump_generation();
     }
 
     void set(double v) {
         except_type_mismatch(TrackerDouble);
+
+        if (dataunion.double_value == v)
+            return;
+
         dataunion.double_value = v;
+        bump_generation();
     }
 
     void set(mac_addr v) {
         except_type_mismatch(TrackerMac);
+
+        if (*(dataunion.mac_value) == v)
+            return;
+
         // mac has overrided =
         *(dataunion.mac_value) = v;
+        bump_generation();
     }
 
     void set(uuid v) {
         except_type_mismatch(TrackerUuid);
+
+        if (*(dataunion.uuid_value) == v)
+            return;
+
         // uuid has overrided =
         *(dataunion.uuid_value) = v;
+        bump_generation();
     }
 
     void set(TrackedDeviceKey k) {
         except_type_mismatch(TrackerKey);
+
+        if (*(dataunion.key_value) == k)
+            return;
+
         *(dataunion.key_value) = k;
+        bump_generation();
     }
 
     // Coercive set - attempt to fit incoming data into the type (for basic types)
@@ -656,9 +1086,15 @@ protected:
     }
 #endif
 
+    // Live element accounting for the memory breakdown
+    static std::atomic<uint64_t> element_count;
+
     // Garbage collection?  Say it ain't so...
     int reference_count;
 
+    // Mutation generation used to validate cached serializations
+    uint64_t element_generation;
+
     TrackerType type;
     int tracked_id;
 
@@ -670,7 +1106,8 @@ protected:
     // We could make these all one type, but then we'd have odd interactions
     // with incrementing and I'm not positive that's safe in all cases
     union du {
-        std::string *string_value;
+        // Interned; owned by the StringInternPool, never written through
+        const std::string *string_value;
 
         uint8_t uint8_value;
         int8_t int8_value;
@@ -1069,28 +1506,73 @@ public:
 };
 
 // Templated access functions
+//
+// The scalar specializations are inline so that a proxied field access
+// compiles down to the type check (if enabled) and a union load, instead
+// of a call into another translation unit
+
+template<typename T> T GetTrackerValue(const SharedTrackerElement&);
+
+template<> inline std::string GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_string();
+}
+
+template<> inline int8_t GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_int8();
+}
+
+template<> inline uint8_t GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_uint8();
+}
+
+template<> inline int16_t GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_int16();
+}
+
+template<> inline uint16_t GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_uint16();
+}
+
+template<> inline int32_t GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_int32();
+}
+
+template<> inline uint32_t GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_uint32();
+}
+
+template<> inline int64_t GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_int64();
+}
+
+template<> inline uint64_t GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_uint64();
+}
+
+template<> inline float GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_float();
+}
+
+template<> inline double GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_double();
+}
+
+template<> inline mac_addr GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_mac();
+}
 
-template<typename T> T GetTrackerValue(SharedTrackerElement);
-
-template<> std::string GetTrackerValue(SharedTrackerElement e);
-template<> int8_t GetTrackerValue(SharedTrackerElement e);
-template<> uint8_t GetTrackerValue(SharedTrackerElement e);
-template<> int16_t GetTrackerValue(SharedTrackerElement e);
-template<> uint16_t GetTrackerValue(SharedTrackerElement e);
-template<> int32_t GetTrackerValue(SharedTrackerElement e);
-template<> uint32_t GetTrackerValue(SharedTrackerElement e);
-template<> int64_t GetTrackerValue(SharedTrackerElement e);
-template<> uint64_t GetTrackerValue(SharedTrackerElement e);
-template<> float GetTrackerValue(SharedTrackerElement e);
-template<> double GetTrackerValue(SharedTrackerElement e);
-template<> mac_addr GetTrackerValue(SharedTrackerElement e);
-template<> uuid GetTrackerValue(SharedTrackerElement e);
-template<> TrackedDeviceKey GetTrackerValue(SharedTrackerElement e);
+template<> inline uuid GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_uuid();
+}
+
+template<> inline TrackedDeviceKey GetTrackerValue(const SharedTrackerElement& e) {
+    return e->get_key();
+}
 
 template<> std::map<int, SharedTrackerElement > 
-    GetTrackerValue(SharedTrackerElement e);
+    GetTrackerValue(const SharedTrackerElement& e);
 template<> std::vector<SharedTrackerElement > 
-    GetTrackerValue(SharedTrackerElement e);
+    GetTrackerValue(const SharedTrackerElement& e);
 
 // Complex trackable unit based on trackertype dataunion.
 //
@@ -1123,7 +1605,38 @@ class tracker_component : public TrackerElement {
         return (rtype) GetTrackerValue<ptype>(cvar); \
     } \
     virtual void set_##name(itype in) { \
-        cvar->set((ptype) in); \
+        cvar->set((ptype) std::move(in)); \
+    }
+
+// Static-dispatch variant of __Proxy; identical semantics but the
+// accessors are non-virtual, so with the inline GetTrackerValue
+// specializations a call on a concrete component compiles to a type
+// check and a union load.  Use for leaf components whose accessors are
+// never overridden; packet-rate fields are the intended customers.
+#define __ProxyStatic(name, ptype, itype, rtype, cvar) \
+    SharedTrackerElement get_tracker_##name() { \
+        return (std::shared_ptr<TrackerElement>) cvar; \
+    } \
+    rtype get_##name() const { \
+        return (rtype) GetTrackerValue<ptype>(cvar); \
+    } \
+    void set_##name(itype in) { \
+        cvar->set((ptype) std::move(in)); \
+    }
+
+// Static-dispatch increment and decrement, companion to __ProxyStatic
+#define __ProxyStaticIncDec(name, ptype, rtype, cvar) \
+    void inc_##name() { \
+        (*cvar)++; \
+    } \
+    void inc_##name(rtype i) { \
+        (*cvar) += (ptype) i; \
+    } \
+    void dec_##name() { \
+        (*cvar)--; \
+    } \
+    void dec_##name(rtype i) { \
+        (*cvar) -= (ptype) i; \
     }
 
 // Ugly trackercomponent macro for proxying trackerelement values
@@ -1302,6 +1815,12 @@ public:
     // their own complex types.
     virtual SharedTrackerElement clone_type();
 
+    // Components carry typed pointers into their own maps, so a deep clone
+    // has to go through the subclass constructor to rebuild them
+    virtual SharedTrackerElement deep_clone_element() {
+        return clone_type();
+    }
+
     // Return the name via the entrytracker
     virtual std::string get_name();
 
@@ -1312,6 +1831,15 @@ public:
     SharedTrackerElement get_child_path(std::vector<std::string> in_path);
 
 protected:
+    // Build this component's field tree by deep-copying a fully
+    // constructed prototype of the same most-derived type, skipping the
+    // register_fields/reserve_fields entrytracker machinery entirely.
+    // Registered-field assignment pointers are rebased from the prototype
+    // instance to this one, which is valid because both objects share the
+    // same layout.  The caller's constructor must not have called
+    // register_fields or reserve_fields.
+    void clone_from_prototype(tracker_component *proto);
+
     // Reserve a field via the entrytracker, using standard entrytracker build methods.
     // This field will be automatically assigned or created during the reservefields 
     // stage.
@@ -1325,9 +1853,9 @@ protected:
     int RegisterField(std::string in_name, TrackerType in_type, std::string in_desc);
 
     // Reserve a field via the entrytracker, using standard entrytracker build methods.
-    // This field will be automatically assigned or created during the reservefields 
+    // This field will be automatically assigned or created during the reservefields
     // stage.
-    // You will nearly always want to use registercomplex below since fields with 
+    // You will nearly always want to use registercomplex below since fields with
     // specific builders typically want to inherit from a subtype
     int RegisterField(std::string in_name, SharedTrackerElement in_builder, 
             std::string in_desc, SharedTrackerElement *in_dest);
@@ -1399,6 +1927,11 @@ public:
     std::vector<int> resolved_path;
     std::string rename;
 
+    // Display name for records which lack the field, resolved once when the
+    // path is compiled; the per-record summary loop uses it instead of
+    // consulting the entry tracker for every device missing the field
+    std::string absent_name;
+
 protected:
     void parse_path(std::vector<std::string> in_path, std::string in_rename, 
             std::shared_ptr<EntryTracker> entrytracker);
@@ -1434,10 +1967,10 @@ protected:
 SharedTrackerElement GetTrackerElementPath(std::string in_path, 
         SharedTrackerElement elem, std::shared_ptr<EntryTracker> entrytracker);
 // Split std::string path
-SharedTrackerElement GetTrackerElementPath(std::vector<std::string> in_path, 
+SharedTrackerElement GetTrackerElementPath(const std::vector<std::string> &in_path,
         SharedTrackerElement elem, std::shared_ptr<EntryTracker> entrytracker);
 // Resolved field ID path
-SharedTrackerElement GetTrackerElementPath(std::vector<int> in_path, 
+SharedTrackerElement GetTrackerElementPath(const std::vector<int> &in_path,
         SharedTrackerElement elem);
 
 // Get a list of elements from a complex path which may include vectors
@@ -1450,20 +1983,25 @@ std::vector<SharedTrackerElement> GetTrackerElementMultiPath(std::string in_path
         SharedTrackerElement elem,
         std::shared_ptr<EntryTracker> entrytracker);
 // Split std::string path
-std::vector<SharedTrackerElement> GetTrackerElementMultiPath(std::vector<std::string> in_path, 
+std::vector<SharedTrackerElement> GetTrackerElementMultiPath(const std::vector<std::string> &in_path,
         SharedTrackerElement elem,
         std::shared_ptr<EntryTracker> entrytracker);
 // Resolved field ID path
-std::vector<SharedTrackerElement> GetTrackerElementMultiPath(std::vector<int> in_path, 
+std::vector<SharedTrackerElement> GetTrackerElementMultiPath(const std::vector<int> &in_path,
         SharedTrackerElement elem);
 
 // Summarize a complex record using a collection of summary elements.  The summarized
 // element is returned in ret_elem, and the rename mapping for serialization is
 // completed in rename.
+//
+// The summarization list is compiled (paths resolved to field IDs) once per
+// request; this function is then applied per record in a tight loop over the
+// device list, so it takes everything by reference and avoids per-record
+// allocation in the projection itself.
 void SummarizeTrackerElement(std::shared_ptr<EntryTracker> entrytracker,
-        SharedTrackerElement in, 
-        std::vector<SharedElementSummary> in_summarization, 
-        SharedTrackerElement &ret_elem, 
+        SharedTrackerElement in,
+        const std::vector<SharedElementSummary> &in_summarization,
+        SharedTrackerElement &ret_elem,
         TrackerElementSerializer::rename_map &rename_map);
 
 
@@ -31,6 +31,14 @@
 # include <libutil.h>
 #endif /* HAVE_LIBUTIL_H */
 
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+# include <arm_acle.h>
+# include <sys/auxv.h>
+# ifndef HWCAP_CRC32
+#  define HWCAP_CRC32	(1 << 7)
+# endif
+#endif
+
 #if PF_ARGV_TYPE == PF_ARGV_PSTAT
 #error "pstat?"
 #endif
@@ -67,15 +75,62 @@
 
 // Munge text down to printable characters only.  Simpler, cleaner munger than
 // before (and more blatant when munging)
+// Classification and case tables; built once at load so the per-byte work
+// in the string hot paths is a single table lookup instead of branches or
+// a locale call
+namespace {
+struct ascii_tables_t {
+    unsigned char printable[256];
+    unsigned char lower[256];
+    unsigned char upper[256];
+
+    ascii_tables_t() {
+        for (unsigned int i = 0; i < 256; i++) {
+            printable[i] = (i >= 32 && i <= 126);
+            lower[i] = i;
+            upper[i] = i;
+        }
+
+        for (unsigned int i = 'A'; i <= 'Z'; i++)
+            lower[i] = i + 32;
+        for (unsigned int i = 'a'; i <= 'z'; i++)
+            upper[i] = i - 32;
+    }
+};
+
+const ascii_tables_t ascii_tables;
+}
+
 std::string MungeToPrintable(const char *in_data, unsigned int max, int nullterm) {
     std::string ret;
 	unsigned int i;
 
-	for (i = 0; i < max; i++) {
-		if ((unsigned char) in_data[i] == 0 && nullterm == 1)
-			return ret;
+    // Size the output in one pass so the build loop never reallocates;
+    // this runs per SSID during beacon storms
+    unsigned int stop = max;
+    size_t olen = 0;
+
+    for (i = 0; i < max; i++) {
+        unsigned char c = (unsigned char) in_data[i];
+
+        if (c == 0 && nullterm == 1) {
+            stop = i;
+            break;
+        }
+
+        olen += ascii_tables.printable[c] ? 1 : 4;
+    }
 
-		if ((unsigned char) in_data[i] >= 32 && (unsigned char) in_data[i] <= 126) {
+    // Clean strings copy straight out
+    if (olen == stop)
+        return std::string(in_data, stop);
+
+    ret.reserve(olen);
+
+	for (i = 0; i < stop; i++) {
+        unsigned char c = (unsigned char) in_data[i];
+
+		if (ascii_tables.printable[c]) {
 			ret += in_data[i];
 		} else {
 			ret += '\\';
@@ -95,7 +150,7 @@ std::string MungeToPrintable(std::string in_str) {
 std::string StrLower(std::string in_str) {
     std::string thestr = in_str;
     for (unsigned int i = 0; i < thestr.length(); i++)
-        thestr[i] = tolower(thestr[i]);
+        thestr[i] = ascii_tables.lower[(unsigned char) thestr[i]];
 
     return thestr;
 }
@@ -104,7 +159,7 @@ std::string StrUpper(std::string in_str) {
     std::string thestr = in_str;
 
     for (unsigned int i = 0; i < thestr.length(); i++)
-        thestr[i] = toupper(thestr[i]);
+        thestr[i] = ascii_tables.upper[(unsigned char) thestr[i]];
 
     return thestr;
 }
@@ -326,7 +381,15 @@ std::vector<std::string> StrTokenize(std::string in_str, std::string in_split, i
 
     if (in_str.length() == 0)
         return ret;
-    
+
+    // Count delimiters up front so the output vector allocates once
+    size_t ndelim = 0;
+    for (size_t scan = end; scan != std::string::npos;
+            scan = in_str.find(in_split, scan + 1))
+        ndelim++;
+
+    ret.reserve(ndelim + 1);
+
     while (end != std::string::npos) {
         std::string sub = in_str.substr(begin, end-begin);
         begin = end+1;
@@ -842,6 +905,90 @@ unsigned int crc32_le_80211(unsigned int *crc32_table, const unsigned char *buf,
 	return crc;
 }
 
+void crc32_init_table_80211x4(unsigned int crc32_table[4][256]) {
+	int i, t;
+	unsigned int crc;
+
+	crc32_init_table_80211(crc32_table[0]);
+
+	for (i = 0; i < 256; ++i) {
+		crc = crc32_table[0][i];
+
+		for (t = 1; t < 4; ++t) {
+			crc = (crc >> 8) ^ crc32_table[0][crc & 0xFF];
+			crc32_table[t][i] = crc;
+		}
+	}
+}
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+// The ARMv8 CRC32 extension implements the 802.3 polynomial directly; the
+// extension is optional so probe the hwcaps once before using it
+static int crc32_80211_hw_capable() {
+	static int capable = -1;
+
+	if (capable < 0)
+		capable = (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+
+	return capable;
+}
+
+static unsigned int crc32_le_80211_hw(const unsigned char *buf, int len) {
+	unsigned int crc = 0xFFFFFFFF;
+	uint64_t d;
+	uint32_t w;
+
+	while (len >= 8) {
+		memcpy(&d, buf, 8);
+		crc = __crc32d(crc, d);
+		buf += 8;
+		len -= 8;
+	}
+
+	if (len >= 4) {
+		memcpy(&w, buf, 4);
+		crc = __crc32w(crc, w);
+		buf += 4;
+		len -= 4;
+	}
+
+	while (len-- > 0)
+		crc = __crc32b(crc, *buf++);
+
+	return crc ^ 0xFFFFFFFF;
+}
+#endif
+
+unsigned int crc32_le_80211x4(unsigned int crc32_table[4][256],
+		const unsigned char *buf, int len) {
+	unsigned int crc = 0xFFFFFFFF;
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+	if (crc32_80211_hw_capable())
+		return crc32_le_80211_hw(buf, len);
+#endif
+
+	while (len >= 4) {
+		crc ^= (unsigned int) buf[0] |
+			((unsigned int) buf[1] << 8) |
+			((unsigned int) buf[2] << 16) |
+			((unsigned int) buf[3] << 24);
+		crc = crc32_table[3][crc & 0xFF] ^
+			crc32_table[2][(crc >> 8) & 0xFF] ^
+			crc32_table[1][(crc >> 16) & 0xFF] ^
+			crc32_table[0][(crc >> 24) & 0xFF];
+		buf += 4;
+		len -= 4;
+	}
+
+	while (len-- > 0)
+		crc = (crc >> 8) ^ crc32_table[0][(crc ^ *buf++) & 0xFF];
+
+	crc ^= 0xFFFFFFFF;
+
+	return crc;
+}
+
 void SubtractTimeval(struct timeval *in_tv1, struct timeval *in_tv2,
 					 struct timeval *out_tv) {
 	if (in_tv1->tv_sec < in_tv2->tv_sec ||
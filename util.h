@@ -48,6 +48,7 @@
 #include <functional>
 #include <thread>
 #include <mutex>
+#include <chrono>
 #include <condition_variable>
 
 #include <sys/time.h>
@@ -201,9 +202,19 @@ uint32_t Adler32IncrementalChecksum(const char *buf1, size_t len,
 unsigned int update_crc32_80211(unsigned int crc, const unsigned char *data,
 								int len, unsigned int poly);
 void crc32_init_table_80211(unsigned int *crc32_table);
-unsigned int crc32_le_80211(unsigned int *crc32_table, const unsigned char *buf, 
+unsigned int crc32_le_80211(unsigned int *crc32_table, const unsigned char *buf,
 							int len);
 
+// Sliced-table variant of the 802.11 FCS checksum; processes the frame a
+// word at a time instead of a byte at a time, and on processors with a
+// CRC32 instruction for the 802.3 polynomial (the ARMv8 CRC extension)
+// uses the hardware instruction when runtime detection finds it.  The x86
+// SSE4.2 crc32 instruction implements the Castagnoli polynomial, not
+// 802.3, so x86 stays on the sliced tables.
+void crc32_init_table_80211x4(unsigned int crc32_table[4][256]);
+unsigned int crc32_le_80211x4(unsigned int crc32_table[4][256],
+		const unsigned char *buf, int len);
+
 
 // Simple lexer for "advanced" filter stuff and other tools
 #define _kis_lex_none			0
@@ -287,6 +298,15 @@ public:
         return data;
     }
 
+    // Block until another thread unlocks us or the timeout expires; returns
+    // true if we were unlocked, false if the timeout expired first
+    bool block_for_ms(unsigned int in_ms) {
+        std::unique_lock<std::mutex> lk(m);
+
+        return cv.wait_for(lk, std::chrono::milliseconds(in_ms),
+                [this](){ return !locked; });
+    }
+
     // Unlock the conditional, unblocking whatever thread was blocked
     // waiting for us, and passing whatever data we'd like to pass
     void unlock(t in_data) {
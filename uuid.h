@@ -43,6 +43,9 @@
 /* Assume that the gettimeofday() has microsecond granularity */
 #define MAX_ADJUSTMENT 10
 
+/* Formatted UUID length including the terminating NUL */
+#define UUID_STR_LEN    37
+
 class uuid {
     public:
         uuid() {
@@ -63,24 +66,43 @@ class uuid {
             clock_seq = (uint16_t *) &(uuid_block[8]);
             node = &(uuid_block[10]);
 
-            unsigned int ln[6];
-            unsigned int ltl, ltm, lth, lcs;
-            if (sscanf(in.c_str(), "%08x-%04x-%04x-%04x-%02x%02x%02x%02x%02x%02x",
-                        &ltl, &ltm, &lth, &lcs,
-                        &ln[0], &ln[1], &ln[2], &ln[3], &ln[4], &ln[5]) != 10) {
-                error = 1;
+            error = 1;
+
+            // Parse the 8-4-4-4-12 layout directly; no sscanf, no
+            // allocation
+            if (in.length() < 36)
                 return;
-            }
 
-            error = 0;
+            const char *s = in.c_str();
+
+            if (s[8] != '-' || s[13] != '-' || s[18] != '-' || s[23] != '-')
+                return;
+
+            uint64_t v;
+
+            if (parse_hex(s, 8, &v) < 0)
+                return;
+            *time_low = (uint32_t) v;
+
+            if (parse_hex(s + 9, 4, &v) < 0)
+                return;
+            *time_mid = (uint16_t) v;
+
+            if (parse_hex(s + 14, 4, &v) < 0)
+                return;
+            *time_hi = (uint16_t) v;
+
+            if (parse_hex(s + 19, 4, &v) < 0)
+                return;
+            *clock_seq = (uint16_t) v;
 
-            *time_low = ltl;
-            *time_mid = ltm;
-            *time_hi = lth;
-            *clock_seq = lcs;
             for (unsigned int x = 0; x < 6; x++) {
-                node[x] = ln[x];
+                if (parse_hex(s + 24 + (x * 2), 2, &v) < 0)
+                    return;
+                node[x] = (uint8_t) v;
             }
+
+            error = 0;
         }
 
         uuid(uint8_t *in_node) {
@@ -121,14 +143,46 @@ class uuid {
             error = 0;
         }
 
+        // Format into a caller buffer of at least UUID_STR_LEN bytes via a
+        // nibble table; no allocation, no stdio.  Serialization paths which
+        // format a UUID per record should use this with a stack buffer
+        void UUID2StringBuf(char *in_buf) const {
+            static const char nibble[17] = "0123456789abcdef";
+            unsigned int pos = 0;
+            int s;
+
+            uint32_t tl = *time_low;
+            for (s = 28; s >= 0; s -= 4)
+                in_buf[pos++] = nibble[(tl >> s) & 0xF];
+            in_buf[pos++] = '-';
+
+            uint16_t tm = *time_mid;
+            for (s = 12; s >= 0; s -= 4)
+                in_buf[pos++] = nibble[(tm >> s) & 0xF];
+            in_buf[pos++] = '-';
+
+            uint16_t th = *time_hi;
+            for (s = 12; s >= 0; s -= 4)
+                in_buf[pos++] = nibble[(th >> s) & 0xF];
+            in_buf[pos++] = '-';
+
+            uint16_t cs = *clock_seq;
+            for (s = 12; s >= 0; s -= 4)
+                in_buf[pos++] = nibble[(cs >> s) & 0xF];
+            in_buf[pos++] = '-';
+
+            for (unsigned int b = 0; b < 6; b++) {
+                in_buf[pos++] = nibble[node[b] >> 4];
+                in_buf[pos++] = nibble[node[b] & 0xF];
+            }
+
+            in_buf[pos] = '\0';
+        }
+
         std::string UUID2String() const {
-            char ids[38];
-            snprintf(ids, 38, "%08x-%04hx-%04hx-%04hx-%02hx%02hx%02hx%02hx%02hx%02hx",
-                    (unsigned int) *time_low, *time_mid, *time_hi, *clock_seq,
-                    (unsigned short) node[0], (unsigned short) node[1],
-                    (unsigned short) node[2], (unsigned short) node[3],
-                    (unsigned short) node[4], (unsigned short) node[5]);
-            return std::string(ids);
+            char ids[UUID_STR_LEN];
+            UUID2StringBuf(ids);
+            return std::string(ids, UUID_STR_LEN - 1);
         }
 
         inline bool operator== (const uuid& op) const {
@@ -173,6 +227,33 @@ class uuid {
         int error;
 
     protected:
+        static int hex_nibble(char c) {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        }
+
+        // Parse in_len hex digits; negative on any non-hex character
+        static int parse_hex(const char *in_str, unsigned int in_len, uint64_t *ret_v) {
+            uint64_t v = 0;
+
+            for (unsigned int x = 0; x < in_len; x++) {
+                int n = hex_nibble(in_str[x]);
+
+                if (n < 0)
+                    return -1;
+
+                v = (v << 4) | n;
+            }
+
+            *ret_v = v;
+            return 0;
+        }
+
         void get_random_bytes(void *buf, int nbytes) {
             int i, r;
             unsigned char *cp = (unsigned char *) buf;
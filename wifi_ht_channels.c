@@ -25,7 +25,7 @@
 
 #include "wifi_ht_channels.h"
 
-wifi_channel wifi_ht_channels[MAX_WIFI_HT_CHANNEL + 1] = {
+const wifi_channel wifi_ht_channels[MAX_WIFI_HT_CHANNEL + 1] = {
     [1] = { 
         .chan = 1, 
         .freq = 2412, 
@@ -26,6 +26,8 @@
 #ifndef __WIFI_HT_CHANNELS_H__
 #define __WIFI_HT_CHANNELS_H__
 
+#include <stddef.h>
+
 #define WIFI_WIDTH_MASK     (0x0000FFFF)
 #define WIFI_WIDTH_5MHZ     (1 << 1)
 #define WIFI_WIDTH_10MHZ    (1 << 2)
@@ -55,7 +57,79 @@ typedef struct {
 
 #define MAX_WIFI_HT_CHANNEL     196
 
-extern wifi_channel wifi_ht_channels[MAX_WIFI_HT_CHANNEL + 1];
+extern const wifi_channel wifi_ht_channels[MAX_WIFI_HT_CHANNEL + 1];
+
+/* 802.11 channel to frequency; if it looks like a frequency already, return
+ * it as a pure frequency; derived from iwconfig */
+static inline unsigned int wifi_chan_to_freq(unsigned int in_chan) {
+    if (in_chan > 250)
+        return in_chan;
+
+    if (in_chan == 14)
+        return 2484;
+    else if (in_chan < 14)
+        return 2407 + in_chan * 5;
+    else if (in_chan >= 182 && in_chan <= 196)
+        return 4000 + in_chan * 5;
+    else
+        return 5000 + in_chan * 5;
+
+    return in_chan;
+}
+
+/* Frequency in MHz to 802.11 channel; if it looks like a channel already,
+ * return it as a channel; revamped from iw */
+static inline unsigned int wifi_freq_to_chan(unsigned int in_freq) {
+    if (in_freq < 250)
+        return in_freq;
+
+    if (in_freq == 2484)
+        return 14;
+
+    if (in_freq < 2484)
+        return (in_freq - 2407) / 5;
+
+    /* 4.9GHz public safety band sits below the 5GHz formula */
+    if (in_freq >= 4910 && in_freq <= 4980)
+        return (in_freq - 4000) / 5;
+
+    return in_freq / 5 - 1000;
+}
+
+/* Direct lookup of a channel record by channel number; the table is indexed
+ * by channel so this is an array load, not a scan of the channel list.
+ * Returns NULL for channels we have no record of. */
+static inline const wifi_channel *wifi_get_ht_channel(unsigned int in_chan) {
+    if (in_chan == 0 || in_chan > MAX_WIFI_HT_CHANNEL)
+        return NULL;
+
+    if (wifi_ht_channels[in_chan].chan == 0)
+        return NULL;
+
+    return &(wifi_ht_channels[in_chan]);
+}
+
+/* Direct lookup of a channel record by control frequency in MHz; buckets the
+ * frequency to its channel number and validates it against the table. */
+static inline const wifi_channel *wifi_get_ht_channel_freq(unsigned int in_freq) {
+    const wifi_channel *c = wifi_get_ht_channel(wifi_freq_to_chan(in_freq));
+
+    if (c == NULL || c->freq != (double) in_freq)
+        return NULL;
+
+    return c;
+}
+
+/* Look up a channel record from user input which may be either a channel
+ * number or a control frequency in MHz. */
+static inline const wifi_channel *wifi_get_ht_channel_any(unsigned int chan_or_freq) {
+    const wifi_channel *c = wifi_get_ht_channel(chan_or_freq);
+
+    if (c == NULL)
+        c = wifi_get_ht_channel_freq(chan_or_freq);
+
+    return c;
+}
 
 #endif
 